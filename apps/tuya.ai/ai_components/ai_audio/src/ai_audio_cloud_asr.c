@@ -25,6 +25,11 @@
 #define AI_AUDIO_UPLOAD_BUFF_TIME_MS (100)
 #define AI_AUDIO_WAIT_ASR_TM_MS      (10 * 1000)
 
+// bytes of upload buffer the cloud asr may hold, 0: not limited
+#ifndef AI_AUDIO_CLOUD_ASR_MEM_BUDGET
+#define AI_AUDIO_CLOUD_ASR_MEM_BUDGET 0
+#endif
+
 #define AI_CLOUD_ASR_EVENT(event)                                                                                      \
     do {                                                                                                               \
         PR_DEBUG("ai cloud asr event: %d", event);                                                                     \
@@ -83,6 +88,8 @@ typedef struct {
 ***********************variable define**********************
 ***********************************************************/
 static AI_AUDIO_CLOUD_ASR_T sg_ai_cloud_asr = {0};
+static TAL_MEM_BUDGET_DEFINE(sg_ai_cloud_asr_budget, "ai_audio_asr", AI_AUDIO_CLOUD_ASR_MEM_BUDGET,
+                              TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
 
 /***********************************************************
 ***********************function define**********************
@@ -250,7 +257,8 @@ OPERATE_RET ai_audio_cloud_asr_init(void)
 
     // upload buffer init
     sg_ai_cloud_asr.upload_buffer_len = AI_AUDIO_VOICE_FRAME_LEN_GET(AI_AUDIO_UPLOAD_BUFF_TIME_MS);
-    sg_ai_cloud_asr.upload_buffer = (uint8_t *)tkl_system_psram_malloc(sg_ai_cloud_asr.upload_buffer_len);
+    sg_ai_cloud_asr.upload_buffer =
+        (uint8_t *)tal_mem_budget_malloc(&sg_ai_cloud_asr_budget, sg_ai_cloud_asr.upload_buffer_len);
     TUYA_CHECK_NULL_GOTO(sg_ai_cloud_asr.upload_buffer, __ERR);
 
     TUYA_CALL_ERR_GOTO(tal_queue_create_init(&sg_ai_cloud_asr.queue, sizeof(AI_CLOUD_ASR_MSG_T), 16), __ERR);
@@ -281,7 +289,7 @@ __ERR:
     }
 
     if (sg_ai_cloud_asr.upload_buffer) {
-        tkl_system_psram_free(sg_ai_cloud_asr.upload_buffer);
+        tal_mem_budget_free(sg_ai_cloud_asr.upload_buffer);
         sg_ai_cloud_asr.upload_buffer = NULL;
     }
 
@@ -32,6 +32,11 @@
 
 #define ASR_PROCE_UNIT_NUM    30
 #define ASR_WAKEUP_TIMEOUT_MS (30000)
+
+// bytes of wakeup word recognition buffers the input may hold, 0: not limited
+#ifndef AI_AUDIO_WAKEUP_MEM_BUDGET
+#define AI_AUDIO_WAKEUP_MEM_BUDGET 0
+#endif
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -88,6 +93,8 @@ const static TKL_ASR_WAKEUP_WORD_E cWAKEUP_KEYWORD_LIST[] = {
 static AI_AUDIO_INOUT_INFORM_CB sg_audio_input_inform_cb = NULL;
 static THREAD_HANDLE sg_ai_audio_input_thrd_hdl = NULL;
 static AI_AUDIO_INPUT_INFO_T sg_audio_input;
+static TAL_MEM_BUDGET_DEFINE(sg_wakeup_budget, "ai_audio_wakeup", AI_AUDIO_WAKEUP_MEM_BUDGET, TAL_MEM_PLACE_PSRAM,
+                              TAL_MEM_BUDGET_STRICT);
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
@@ -191,7 +198,7 @@ static TKL_ASR_WAKEUP_WORD_E __asr_recognize_wakeup_keyword(void)
         return TKL_ASR_WAKEUP_WORD_UNKNOWN;
     }
 
-    uint8_t *p_buf = tkl_system_psram_malloc(uint_size);
+    uint8_t *p_buf = tal_mem_budget_malloc(&sg_wakeup_budget, uint_size);
     if (NULL == p_buf) {
         PR_ERR("malloc fail");
         return TKL_ASR_WAKEUP_WORD_UNKNOWN;
@@ -209,7 +216,7 @@ static TKL_ASR_WAKEUP_WORD_E __asr_recognize_wakeup_keyword(void)
         }
     }
 
-    tkl_system_psram_free(p_buf);
+    tal_mem_budget_free(p_buf);
 
     return wakeup_word;
 }
@@ -37,6 +37,11 @@
 #define MP3_PCM_SIZE_MAX           (MAX_NSAMP * MAX_NCHAN * MAX_NGRAN * 2)
 #define PLAYING_NO_DATA_TIMEOUT_MS (5 * 1000)
 
+// bytes of mp3 decoder state and buffers the player may hold, 0: not limited
+#ifndef AI_AUDIO_PLAYER_MEM_BUDGET
+#define AI_AUDIO_PLAYER_MEM_BUDGET 0
+#endif
+
 #define AI_AUDIO_PLAYER_STAT_CHANGE(last_stat, new_stat)                                                               \
     do {                                                                                                               \
         if (last_stat != new_stat) {                                                                                   \
@@ -81,6 +86,8 @@ typedef struct {
 ***********************variable define**********************
 ***********************************************************/
 static APP_PLAYER_T sg_player;
+static TAL_MEM_BUDGET_DEFINE(sg_player_budget, "ai_audio_player", AI_AUDIO_PLAYER_MEM_BUDGET, TAL_MEM_PLACE_PSRAM,
+                              TAL_MEM_BUDGET_STRICT);
 
 /***********************************************************
 ***********************function define**********************
@@ -90,7 +97,7 @@ static OPERATE_RET __ai_audio_player_mp3_start(void)
     OPERATE_RET rt = OPRT_OK;
 
     if (NULL == sg_player.mp3_dec) {
-        sg_player.mp3_dec = (mp3dec_t *)tkl_system_psram_malloc(sizeof(mp3dec_t));
+        sg_player.mp3_dec = (mp3dec_t *)tal_mem_budget_malloc(&sg_player_budget, sizeof(mp3dec_t));
         if (NULL == sg_player.mp3_dec) {
             PR_ERR("malloc mp3dec_t failed");
             return OPRT_MALLOC_FAILED;
@@ -167,22 +174,22 @@ static OPERATE_RET __ai_audio_player_mp3_init(void)
 
     PR_DEBUG("app player mp3 init...");
 
-    sg_player.mp3_raw = (uint8_t *)tkl_system_psram_malloc(MAINBUF_SIZE);
+    sg_player.mp3_raw = (uint8_t *)tal_mem_budget_malloc(&sg_player_budget, MAINBUF_SIZE);
     TUYA_CHECK_NULL_GOTO(sg_player.mp3_raw, __ERR);
 
-    sg_player.mp3_pcm = (uint8_t *)tkl_system_psram_malloc(MP3_PCM_SIZE_MAX);
+    sg_player.mp3_pcm = (uint8_t *)tal_mem_budget_malloc(&sg_player_budget, MP3_PCM_SIZE_MAX);
     TUYA_CHECK_NULL_GOTO(sg_player.mp3_pcm, __ERR);
 
     return rt;
 
 __ERR:
     if (sg_player.mp3_pcm) {
-        tkl_system_psram_free(sg_player.mp3_pcm);
+        tal_mem_budget_free(sg_player.mp3_pcm);
         sg_player.mp3_pcm = NULL;
     }
 
     if (sg_player.mp3_raw) {
-        tkl_system_psram_free(sg_player.mp3_raw);
+        tal_mem_budget_free(sg_player.mp3_raw);
         sg_player.mp3_raw = NULL;
     }
 
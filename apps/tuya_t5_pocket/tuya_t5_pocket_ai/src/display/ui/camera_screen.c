@@ -501,38 +501,26 @@ static void keyboard_event_cb(lv_event_t *e)
                 // Get the YUV422 buffer with latest frame data
                 uint8_t *yuv422_source = (current_buffer_index == 0) ? sg_yuv422_buffer_1 : sg_yuv422_buffer_2;
 
-                // Allocate printer bitmap buffer before calling callback
-                int bitmap_size = (PRINT_WIDTH + 7) / 8 * PRINT_HEIGHT;
-                uint8_t *printer_bitmap = (uint8_t *)tal_psram_malloc(bitmap_size);
-                if (!printer_bitmap) {
-                    printf("Failed to allocate printer bitmap buffer (%d bytes)\n", bitmap_size);
-                    rt = camera_start();
-                    if (rt != OPRT_OK) {
-                        printf("Failed to restart camera: %d\n", rt);
-                    }
-                } else {
-                    YUV422_TO_BINARY_PARAMS_T print_params = {
-                        .yuv422_data = yuv422_source, // Direct pointer, no copy
-                        .src_width = CAMERA_WIDTH,
-                        .src_height = CAMERA_HEIGHT,
-                        .binary_data = printer_bitmap, // Pre-allocated buffer
-                        .dst_width = PRINT_WIDTH,
-                        .dst_height = PRINT_HEIGHT,
-                        .config = &sg_binary_config, // Use global config directly
-                        .invert_colors = 0           // Will be overridden by printer
-                    };
-
-                    // Update status
-                    char buf[32];
-                    snprintf(buf, sizeof(buf), "Status:\n%s", "Printing");
-                    lv_label_set_text(status_label, buf);
-
-                    sg_print_callback(&print_params); // Call print callback
-                    tal_psram_free(printer_bitmap);
-
-                    update_info_display(); // Refresh status display
-                    printf("bitmap_size %d bytes free succeed\n", bitmap_size);
-                }
+                // The bitmap is streamed to the printer band by band, no buffer is allocated here
+                YUV422_TO_BINARY_PARAMS_T print_params = {
+                    .yuv422_data = yuv422_source, // Direct pointer, no copy
+                    .src_width = CAMERA_WIDTH,
+                    .src_height = CAMERA_HEIGHT,
+                    .binary_data = NULL,
+                    .dst_width = PRINT_WIDTH,
+                    .dst_height = PRINT_HEIGHT,
+                    .config = &sg_binary_config, // Use global config directly
+                    .invert_colors = 0           // Will be overridden by printer
+                };
+
+                // Update status
+                char buf[32];
+                snprintf(buf, sizeof(buf), "Status:\n%s", "Printing");
+                lv_label_set_text(status_label, buf);
+
+                sg_print_callback(&print_params); // Call print callback
+
+                update_info_display(); // Refresh status display
             } else {
                 printf("ENTER key pressed but callback not ready\n");
             }
@@ -37,7 +37,7 @@ typedef void (*camera_screen_lifecycle_cb_t)(BOOL_T is_init);
 /**
  * @brief Camera photo print callback type
  * Called when ENTER key is pressed to print current photo from raw YUV422 data
- * @param params Conversion parameters for printing
+ * @param params Conversion parameters for printing (binary_data is NULL, use yuv422_to_printer_stream())
  * @note The yuv422_data buffer will be freed after callback returns
  */
 typedef void (*camera_photo_print_cb_t)(const YUV422_TO_BINARY_PARAMS_T *params);
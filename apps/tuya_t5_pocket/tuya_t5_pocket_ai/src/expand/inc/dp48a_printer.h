@@ -153,6 +153,8 @@ void dp48a_print_qr_ex(const uint8_t *data, uint16_t len);
 // ==================== Image printing ====================
 void dp48a_print_bitmap(uint16_t width, uint16_t height, const uint8_t *data);
 void dp48a_print_bitmap_raster(uint16_t width, uint16_t height, const uint8_t *data);
+void dp48a_print_bitmap_begin(uint16_t width, uint16_t height);
+void dp48a_print_bitmap_write(const uint8_t *data, size_t len);
 
 // ==================== Printer settings ====================
 void dp48a_set_density(dp48a_density_t density);
@@ -24,6 +24,12 @@ extern "C" {
 
 #include <stdint.h>
 
+/**
+ * @brief Output rows produced per band by the conversion kernel
+ * @note Bands handed to YUV422_TO_BINARY_BAND_CB hold at most this many rows
+ */
+#define YUV422_TO_BINARY_BAND_ROWS 16
+
 /**
  * @brief Binary conversion method enum (for printer)
  */
@@ -62,6 +68,18 @@ typedef struct {
     int invert_colors;             // 1: bit=1->white (LVGL), 0: bit=1->black (printer)
 } YUV422_TO_BINARY_PARAMS_T;
 
+/**
+ * @brief Band output callback for streaming conversion
+ * @param band Packed rows of this band (MSB first, stride bytes per row)
+ * @param row Index of the first output row in this band
+ * @param rows Number of rows in this band (1..YUV422_TO_BINARY_BAND_ROWS)
+ * @param stride Bytes per output row, (dst_width + 7) / 8
+ * @param user_data User data passed to the streaming call
+ * @return 0 to continue, non-zero to abort the conversion
+ * @note The band buffer is only valid during the callback
+ */
+typedef int (*YUV422_TO_BINARY_BAND_CB)(const uint8_t *band, int row, int rows, int stride, void *user_data);
+
 /**
  * @brief Convert YUV422 to binary format with selected algorithm (universal interface)
  * @param params Conversion parameters structure
@@ -71,6 +89,17 @@ typedef struct {
  */
 int yuv422_to_binary(const YUV422_TO_BINARY_PARAMS_T *params);
 
+/**
+ * @brief Convert YUV422 to binary format band by band (streaming interface)
+ * @param params Conversion parameters structure (binary_data is not used and may be NULL)
+ * @param band_cb Callback receiving each finished band, top to bottom
+ * @param user_data User data passed to band_cb
+ * @return 0 on success, -1 on error or when band_cb aborts
+ * @note Only one band of output is held in memory at a time
+ */
+int yuv422_to_binary_stream(const YUV422_TO_BINARY_PARAMS_T *params, YUV422_TO_BINARY_BAND_CB band_cb,
+                            void *user_data);
+
 /**
  * @brief Convert YUV422 to printer binary format (convenience wrapper)
  * @param params Conversion parameters (invert_colors will be set to 0 for printer)
@@ -79,6 +108,17 @@ int yuv422_to_binary(const YUV422_TO_BINARY_PARAMS_T *params);
  */
 int yuv422_to_printer_binary(const YUV422_TO_BINARY_PARAMS_T *params);
 
+/**
+ * @brief Convert YUV422 to printer binary format band by band (convenience wrapper)
+ * @param params Conversion parameters (invert_colors will be set to 0 for printer)
+ * @param band_cb Callback receiving each finished band, top to bottom
+ * @param user_data User data passed to band_cb
+ * @return 0 on success, -1 on error or when band_cb aborts
+ * @note Output: bit=1->black, bit=0->white (for thermal printer)
+ */
+int yuv422_to_printer_stream(const YUV422_TO_BINARY_PARAMS_T *params, YUV422_TO_BINARY_BAND_CB band_cb,
+                             void *user_data);
+
 /**
  * @brief Convert YUV422 to LVGL I1 format binary (convenience wrapper)
  * @param params Conversion parameters (invert_colors will be set to 1 for LVGL)
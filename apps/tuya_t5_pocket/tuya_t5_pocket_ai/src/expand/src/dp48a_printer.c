@@ -445,6 +445,21 @@ void dp48a_print_qr_ex(const uint8_t *data, uint16_t len)
  * @param data Image data (1 bit per pixel, row-major)
  */
 void dp48a_print_bitmap(uint16_t width, uint16_t height, const uint8_t *data)
+{
+    uint16_t width_bytes = (width + 7) / 8;
+
+    dp48a_print_bitmap_begin(width, height);
+    dp48a_print_bitmap_write(data, width_bytes * height);
+}
+
+/**
+ * @brief Start a bitmap image whose rows are sent separately
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @note Must be followed by exactly ((width + 7) / 8) * height bytes of
+ *       dp48a_print_bitmap_write() data, e.g. one call per converted band
+ */
+void dp48a_print_bitmap_begin(uint16_t width, uint16_t height)
 {
     uint16_t width_bytes = (width + 7) / 8;
     uint8_t xL = width_bytes & 0xFF;
@@ -454,7 +469,16 @@ void dp48a_print_bitmap(uint16_t width, uint16_t height, const uint8_t *data)
 
     uint8_t cmd[] = {0x1D, 0x76, 0x30, 0x00, xL, xH, yL, yH};
     dp48a_send_command(cmd, sizeof(cmd));
-    dp48a_send_command(data, width_bytes * height);
+}
+
+/**
+ * @brief Send bitmap rows for an image started with dp48a_print_bitmap_begin()
+ * @param data Image rows (1 bit per pixel, MSB first)
+ * @param len Length of data in bytes
+ */
+void dp48a_print_bitmap_write(const uint8_t *data, size_t len)
+{
+    dp48a_send_command(data, len);
 }
 
 /**
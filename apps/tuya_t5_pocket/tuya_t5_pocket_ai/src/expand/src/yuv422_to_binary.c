@@ -12,6 +12,16 @@
  * All algorithms rotate 90° counter-clockwise and crop to desired size.
  * Output format: MSB first bitmap, color mapping controlled by invert_colors parameter
  *
+ * Every method runs through one fused kernel. The source is walked row-major
+ * in bands of YUV422_TO_BINARY_BAND_ROWS output rows: each source row
+ * contributes one short contiguous run of luma samples to a small band tile,
+ * which performs the rotation as a transpose in internal RAM. Threshold and
+ * Bayer methods are expressed as a per-position threshold map and compared
+ * 4 pixels at a time; error diffusion uses reciprocal-multiply-and-shift
+ * weights instead of integer divides. Finished bands are either written into
+ * the caller's bitmap or handed to a band callback, so a consumer such as the
+ * printer never needs the whole bitmap in memory.
+ *
  * @copyright Copyright (c) 2025 Tuya Inc. All Rights Reserved.
  */
 
@@ -20,12 +30,57 @@
 #include "tal_api.h"
 #include <string.h>
 
+#if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32
+#include <arm_acle.h>
+#endif
+
 /***********************************************************
 ************************macro define************************
 ***********************************************************/
 // Crop offset is dynamically calculated based on source width and destination height
 // For camera: src=384, dst_height=168 -> offset=(384-168)/2=108
 
+#define YUV2BIN_BAND_ROWS    YUV422_TO_BINARY_BAND_ROWS
+#define YUV2BIN_DIFFUSE_PAD  2 // Error row padding on each side, covers the widest kernel (dx = -2..2)
+#define YUV2BIN_DIFFUSE_ROWS 3 // Maximum number of error rows a kernel touches
+#define YUV2BIN_MAP_ROWS     4 // Maximum ordered map period (4x4 Bayer)
+#define YUV2BIN_LUMA_THRESH  128
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    int8_t dx;      // Column offset from the current pixel
+    uint8_t row;    // 0: current row, 1: next row, 2: row after next
+    uint8_t weight; // Numerator of the kernel weight
+} YUV2BIN_DIFFUSE_TAP_T;
+
+typedef struct {
+    const YUV2BIN_DIFFUSE_TAP_T *taps;
+    uint8_t tap_count;
+    uint8_t rows;   // Error rows in use (including the current one)
+    uint16_t recip; // Fixed-point reciprocal of the divisor: recip / (1 << shift) ~= 1 / divisor
+    uint8_t shift;
+} YUV2BIN_DIFFUSE_KERNEL_T;
+
+typedef struct {
+    const YUV422_TO_BINARY_PARAMS_T *params;
+    int stride;        // Packed bytes per output row
+    int crop_offset;   // First source column mapped to output row 0
+    int valid_width;   // Output columns backed by a source row
+    int luma_stride;   // Band tile row length, multiple of 8
+    uint8_t polarity;  // XOR mask turning "white" bits into the requested color mapping
+    uint8_t *luma;     // Band tile, YUV2BIN_BAND_ROWS x luma_stride
+    uint8_t *band;     // Packed band for the band callback, NULL when writing in place
+    uint8_t *map;      // Ordered threshold map, map_period x luma_stride
+    int map_period;    // Row period of the ordered map
+    uint8_t map_strict; // 1: white when luma > map, 0: white when luma >= map
+    const YUV2BIN_DIFFUSE_KERNEL_T *diffuse;
+    int16_t *err_rows[YUV2BIN_DIFFUSE_ROWS];
+    int err_len; // Error row length including padding
+    void *block; // Single allocation backing all of the buffers above
+} YUV2BIN_CTX_T;
+
 /***********************************************************
 ***********************Bayer Matrices***********************
 ***********************************************************/
@@ -34,158 +89,62 @@ static const uint8_t bayer_3x3[3][3] = {{0, 7, 3}, {6, 4, 2}, {1, 5, 8}};
 static const uint8_t bayer_4x4[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
 
 /***********************************************************
-*********************Forward Declarations*******************
+*******************Error Diffusion Kernels******************
 ***********************************************************/
-static uint8_t calculate_adaptive_threshold(const uint8_t *yuv422_data, int src_width, int src_height);
-static uint8_t calculate_otsu_threshold(const uint8_t *yuv422_data, int src_width, int src_height);
-static int yuv422_to_binary_crop_threshold(const uint8_t *yuv422_data, int src_width, int src_height,
-                                           uint8_t *binary_data, int dst_width, int dst_height, uint8_t threshold,
-                                           int invert);
-static int yuv422_to_bayer4_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                   int dst_width, int dst_height, int invert);
-static int yuv422_to_bayer8_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                   int dst_width, int dst_height, int invert);
-static int yuv422_to_bayer16_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                    int dst_width, int dst_height, int invert);
-static int yuv422_to_floyd_steinberg(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                     int dst_width, int dst_height, int invert);
-static int yuv422_to_stucki(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                            int dst_width, int dst_height, int invert);
-static int yuv422_to_jarvis(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                            int dst_width, int dst_height, int invert);
+// Floyd-Steinberg (divisor: 16)
+static const YUV2BIN_DIFFUSE_TAP_T sg_floyd_taps[] = {
+    {1, 0, 7}, {-1, 1, 3}, {0, 1, 5}, {1, 1, 1},
+};
+
+// Stucki (divisor: 42)
+static const YUV2BIN_DIFFUSE_TAP_T sg_stucki_taps[] = {
+    {1, 0, 8},  {2, 0, 4},  {-2, 1, 2}, {-1, 1, 4}, {0, 1, 8}, {1, 1, 4},
+    {2, 1, 2},  {-2, 2, 1}, {-1, 2, 2}, {0, 2, 4},  {1, 2, 2}, {2, 2, 1},
+};
+
+// Jarvis-Judice-Ninke (divisor: 48)
+static const YUV2BIN_DIFFUSE_TAP_T sg_jarvis_taps[] = {
+    {1, 0, 7},  {2, 0, 5},  {-2, 1, 3}, {-1, 1, 5}, {0, 1, 7}, {1, 1, 5},
+    {2, 1, 3},  {-2, 2, 1}, {-1, 2, 3}, {0, 2, 5},  {1, 2, 3}, {2, 2, 1},
+};
+
+static const YUV2BIN_DIFFUSE_KERNEL_T sg_floyd_kernel = {
+    sg_floyd_taps, sizeof(sg_floyd_taps) / sizeof(sg_floyd_taps[0]), 2, 1, 4};
+static const YUV2BIN_DIFFUSE_KERNEL_T sg_stucki_kernel = {
+    sg_stucki_taps, sizeof(sg_stucki_taps) / sizeof(sg_stucki_taps[0]), 3, 195, 13}; // 8192 / 42
+static const YUV2BIN_DIFFUSE_KERNEL_T sg_jarvis_kernel = {
+    sg_jarvis_taps, sizeof(sg_jarvis_taps) / sizeof(sg_jarvis_taps[0]), 3, 683, 15}; // 32768 / 48
 
 /***********************************************************
-***********************Main Entry Point*********************
+*********************Threshold Calculation******************
 ***********************************************************/
 /**
- * @brief Convert YUV422 to binary format with selected algorithm (universal interface)
+ * @brief Build the luma histogram of the whole frame in one pass
  */
-int yuv422_to_binary(const YUV422_TO_BINARY_PARAMS_T *params)
+static void __luma_histogram(const uint8_t *yuv422_data, int src_width, int src_height, uint32_t histogram[256])
 {
-    if (!params || !params->yuv422_data || !params->binary_data || !params->config) {
-        return -1;
-    }
-
-    // Clear output buffer
-    int bitmap_size = (params->dst_width + 7) / 8 * params->dst_height;
-    memset(params->binary_data, 0, bitmap_size);
-
-    switch (params->config->method) {
-    case BINARY_METHOD_FIXED:
-        return yuv422_to_binary_crop_threshold(params->yuv422_data, params->src_width, params->src_height,
-                                               params->binary_data, params->dst_width, params->dst_height,
-                                               params->config->fixed_threshold, params->invert_colors);
-
-    case BINARY_METHOD_ADAPTIVE: {
-        uint8_t threshold = calculate_adaptive_threshold(params->yuv422_data, params->src_width, params->src_height);
-        return yuv422_to_binary_crop_threshold(params->yuv422_data, params->src_width, params->src_height,
-                                               params->binary_data, params->dst_width, params->dst_height, threshold,
-                                               params->invert_colors);
-    }
-
-    case BINARY_METHOD_OTSU: {
-        uint8_t threshold = calculate_otsu_threshold(params->yuv422_data, params->src_width, params->src_height);
-        return yuv422_to_binary_crop_threshold(params->yuv422_data, params->src_width, params->src_height,
-                                               params->binary_data, params->dst_width, params->dst_height, threshold,
-                                               params->invert_colors);
-    }
-
-    case BINARY_METHOD_BAYER4_DITHER:
-        return yuv422_to_bayer4_dither(params->yuv422_data, params->src_width, params->src_height, params->binary_data,
-                                       params->dst_width, params->dst_height, params->invert_colors);
-
-    case BINARY_METHOD_BAYER8_DITHER:
-        return yuv422_to_bayer8_dither(params->yuv422_data, params->src_width, params->src_height, params->binary_data,
-                                       params->dst_width, params->dst_height, params->invert_colors);
-
-    case BINARY_METHOD_BAYER16_DITHER:
-        return yuv422_to_bayer16_dither(params->yuv422_data, params->src_width, params->src_height, params->binary_data,
-                                        params->dst_width, params->dst_height, params->invert_colors);
-
-    case BINARY_METHOD_FLOYD_STEINBERG:
-        return yuv422_to_floyd_steinberg(params->yuv422_data, params->src_width, params->src_height,
-                                         params->binary_data, params->dst_width, params->dst_height,
-                                         params->invert_colors);
-
-    case BINARY_METHOD_STUCKI:
-        return yuv422_to_stucki(params->yuv422_data, params->src_width, params->src_height, params->binary_data,
-                                params->dst_width, params->dst_height, params->invert_colors);
-
-    case BINARY_METHOD_JARVIS:
-        return yuv422_to_jarvis(params->yuv422_data, params->src_width, params->src_height, params->binary_data,
-                                params->dst_width, params->dst_height, params->invert_colors);
+    const uint8_t *luma = yuv422_data + 1; // Y component
+    int total_pixels = src_width * src_height;
 
-    default:
-        return -1;
+    memset(histogram, 0, 256 * sizeof(uint32_t));
+    for (int i = 0; i < total_pixels; i++) {
+        histogram[luma[i * 2]]++;
     }
 }
 
-/**
- * @brief Convert YUV422 to printer binary format (convenience wrapper)
- */
-int yuv422_to_printer_binary(const YUV422_TO_BINARY_PARAMS_T *params)
-{
-    if (!params) {
-        return -1;
-    }
-
-    // Create a copy with invert_colors forced to 0 for printer
-    YUV422_TO_BINARY_PARAMS_T printer_params = *params;
-    printer_params.invert_colors = 0; // Printer: bit=1->black
-
-    return yuv422_to_binary(&printer_params);
-}
-
-/**
- * @brief Convert YUV422 to LVGL I1 format binary (convenience wrapper)
- */
-int yuv422_to_lvgl_binary(const YUV422_TO_BINARY_PARAMS_T *params)
-{
-    if (!params) {
-        return -1;
-    }
-
-    // Create a copy with invert_colors forced to 1 for LVGL
-    YUV422_TO_BINARY_PARAMS_T lvgl_params = *params;
-    lvgl_params.invert_colors = 1; // LVGL: bit=1->white
-
-    return yuv422_to_binary(&lvgl_params);
-}
-
-/***********************************************************
-*********************Threshold Calculation******************
-***********************************************************/
-static uint8_t calculate_adaptive_threshold(const uint8_t *yuv422_data, int src_width, int src_height)
+static uint8_t calculate_adaptive_threshold(const uint32_t histogram[256], uint32_t total_pixels)
 {
     uint32_t luminance_sum = 0;
-    int total_pixels = src_width * src_height;
 
-    for (int y = 0; y < src_height; y++) {
-        int row_offset = y * src_width * 2;
-        for (int x = 0; x < src_width; x++) {
-            int yuv_index = row_offset + x * 2 + 1; // Y component
-            luminance_sum += yuv422_data[yuv_index];
-        }
+    for (int i = 0; i < 256; i++) {
+        luminance_sum += i * histogram[i];
     }
 
     return (uint8_t)(luminance_sum / total_pixels);
 }
 
-static uint8_t calculate_otsu_threshold(const uint8_t *yuv422_data, int src_width, int src_height)
+static uint8_t calculate_otsu_threshold(const uint32_t histogram[256], uint32_t total_pixels)
 {
-    int histogram[256] = {0};
-    int total_pixels = src_width * src_height;
-
-    // Build histogram
-    for (int y = 0; y < src_height; y++) {
-        int row_offset = y * src_width * 2;
-        for (int x = 0; x < src_width; x++) {
-            int yuv_index = row_offset + x * 2 + 1;
-            uint8_t luminance = yuv422_data[yuv_index];
-            histogram[luminance]++;
-        }
-    }
-
     // Calculate optimal threshold
     float sum = 0;
     for (int i = 0; i < 256; i++) {
@@ -193,7 +152,7 @@ static uint8_t calculate_otsu_threshold(const uint8_t *yuv422_data, int src_widt
     }
 
     float sum_background = 0;
-    int weight_background = 0;
+    uint32_t weight_background = 0;
     float max_variance = 0;
     uint8_t optimal_threshold = 0;
 
@@ -202,7 +161,7 @@ static uint8_t calculate_otsu_threshold(const uint8_t *yuv422_data, int src_widt
         if (weight_background == 0)
             continue;
 
-        int weight_foreground = total_pixels - weight_background;
+        uint32_t weight_foreground = total_pixels - weight_background;
         if (weight_foreground == 0)
             break;
 
@@ -224,391 +183,422 @@ static uint8_t calculate_otsu_threshold(const uint8_t *yuv422_data, int src_widt
 }
 
 /***********************************************************
-****************Simple Threshold Conversion*****************
+*******************Ordered (Map) Threshold******************
 ***********************************************************/
-static int yuv422_to_binary_crop_threshold(const uint8_t *yuv422_data, int src_width, int src_height,
-                                           uint8_t *binary_data, int dst_width, int dst_height, uint8_t threshold,
-                                           int invert)
+static inline uint32_t __load_u8x4(const uint8_t *p)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
+    // Lane 0 holds the leftmost pixel regardless of endianness
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
+/**
+ * @brief Per-lane unsigned a >= b, result in the top bit of each byte lane
+ */
+static inline uint32_t __ge_u8x4(uint32_t a, uint32_t b)
+{
+#if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32
+    // USUB8 sets GE[n] when lane n does not borrow, i.e. a >= b
+    (void)__usub8(a, b);
+    return __sel(0x80808080u, 0);
+#else
+    uint32_t diff = (a | 0x80808080u) - (b & 0x7F7F7F7Fu);
+    return ((a & ~b) | (~(a ^ b) & diff)) & 0x80808080u;
+#endif
+}
 
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            // Rotate 90° CCW: (dst_x, dst_y) -> (src_y=height-1-dst_x, src_x=dst_y+offset)
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
+/**
+ * @brief Compare 4 pixels against the map and return them as an MSB-first nibble (1 = white)
+ */
+static inline uint8_t __map_nibble(const uint8_t *luma, const uint8_t *map, uint8_t strict)
+{
+    uint32_t l = __load_u8x4(luma);
+    uint32_t m = __load_u8x4(map);
+    uint32_t ge = strict ? (__ge_u8x4(m, l) ^ 0x80808080u) : __ge_u8x4(l, m);
 
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+    // Gather lane bits 0/8/16/24 into bits 31/30/29/28
+    return (uint8_t)((((ge >> 7) * 0x80402010u) >> 28) & 0x0F);
+}
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            uint8_t luminance = yuv422_data[yuv_index];
+static void __map_row(const YUV2BIN_CTX_T *ctx, const uint8_t *luma, const uint8_t *map, uint8_t *out)
+{
+    for (int i = 0; i < ctx->stride; i++, luma += 8, map += 8) {
+        out[i] = (uint8_t)((__map_nibble(luma, map, ctx->map_strict) << 4) |
+                           __map_nibble(luma + 4, map + 4, ctx->map_strict)) ^
+                 ctx->polarity;
+    }
+}
+
+/**
+ * @brief Fill the ordered map from a Bayer matrix
+ * @note A pixel is white when luminance >= max(bayer * scale, floor_level)
+ */
+static void __map_build_bayer(YUV2BIN_CTX_T *ctx, const uint8_t *matrix, int n, int scale, int floor_level)
+{
+    int max_level = 0;
 
-            // Apply threshold with color inversion control
-            // invert=0 (printer): luminance < threshold -> bit=1 (black)
-            // invert=1 (LVGL):    luminance >= threshold -> bit=1 (white)
-            int should_set_bit = invert ? (luminance >= threshold) : (luminance < threshold);
+    for (int i = 0; i < n * n; i++) {
+        int level = matrix[i] * scale;
+        if (level > max_level) {
+            max_level = level;
+        }
+    }
 
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
+    // 256 is "never white" and does not fit a byte, switch to luma > (level - 1)
+    ctx->map_strict = (max_level > 255) ? 1 : 0;
+    ctx->map_period = n;
+
+    for (int y = 0; y < n; y++) {
+        uint8_t *row = ctx->map + y * ctx->luma_stride;
+        for (int x = 0; x < ctx->luma_stride; x++) {
+            int level = matrix[y * n + x % n] * scale;
+            if (level < floor_level) {
+                level = floor_level;
             }
+            row[x] = (uint8_t)(ctx->map_strict ? level - 1 : level);
         }
     }
+}
 
-    return 0;
+static void __map_build_flat(YUV2BIN_CTX_T *ctx, uint8_t threshold)
+{
+    ctx->map_strict = 0;
+    ctx->map_period = 1;
+    memset(ctx->map, threshold, ctx->luma_stride);
 }
 
 /***********************************************************
-********************Bayer Dithering Methods*****************
+**************Error Diffusion Methods***********************
 ***********************************************************/
-static int yuv422_to_bayer4_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                   int dst_width, int dst_height, int invert)
+static void __diffuse_row(YUV2BIN_CTX_T *ctx, const uint8_t *luma, uint8_t *out)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
-
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
-
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
-
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
-
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            uint8_t luminance = yuv422_data[yuv_index];
-
-            // 4-level Bayer dithering (2x2 matrix, threshold 0-3)
-            uint8_t bayer_value = bayer_2x2[dst_y % 2][dst_x % 2];
-            uint8_t gray_level = luminance / 85; // Map 0-255 to 0-3
+    const YUV2BIN_DIFFUSE_KERNEL_T *kernel = ctx->diffuse;
+    int16_t *curr_row = ctx->err_rows[0];
+    int32_t round = 1 << (kernel->shift - 1);
+    uint8_t bits = 0;
+    int dst_x;
+
+    for (dst_x = 0; dst_x < ctx->valid_width; dst_x++) {
+        int16_t luminance = (int16_t)luma[dst_x] + curr_row[dst_x];
+
+        if (luminance < 0)
+            luminance = 0;
+        if (luminance > 255)
+            luminance = 255;
+
+        uint8_t white = (luminance >= YUV2BIN_LUMA_THRESH) ? 1 : 0;
+        int32_t error = (int32_t)(luminance - (white ? 255 : 0)) * kernel->recip;
+
+        bits = (uint8_t)((bits << 1) | white);
+        if ((dst_x & 0x07) == 0x07) {
+            out[dst_x >> 3] = bits ^ ctx->polarity;
+        }
 
-            int should_set_bit =
-                invert ? (gray_level >= bayer_value && luminance >= 32) : (gray_level < bayer_value || luminance < 32);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
-            }
+        // Padding absorbs taps that fall outside the row, no bounds checks needed
+        for (int i = 0; i < kernel->tap_count; i++) {
+            const YUV2BIN_DIFFUSE_TAP_T *tap = &kernel->taps[i];
+            ctx->err_rows[tap->row][dst_x + tap->dx] += (int16_t)((error * tap->weight + round) >> kernel->shift);
         }
     }
 
-    return 0;
+    if (dst_x & 0x07) {
+        out[dst_x >> 3] = (uint8_t)(bits << (8 - (dst_x & 0x07))) ^ ctx->polarity;
+    }
 }
 
-static int yuv422_to_bayer8_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                   int dst_width, int dst_height, int invert)
+static void __diffuse_rows_advance(YUV2BIN_CTX_T *ctx)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
-
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
-
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
-
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+    int rows = ctx->diffuse->rows;
+    int16_t *temp = ctx->err_rows[0];
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            uint8_t luminance = yuv422_data[yuv_index];
-
-            // 8-level Bayer dithering (3x3 matrix, threshold 0-8)
-            uint8_t bayer_value = bayer_3x3[dst_y % 3][dst_x % 3];
-            uint8_t gray_level = luminance / 32; // Map 0-255 to 0-7
-
-            int should_set_bit =
-                invert ? (gray_level >= bayer_value && luminance >= 16) : (gray_level < bayer_value || luminance < 16);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
-            }
-        }
+    for (int i = 0; i < rows - 1; i++) {
+        ctx->err_rows[i] = ctx->err_rows[i + 1];
     }
-
-    return 0;
+    ctx->err_rows[rows - 1] = temp;
+    memset(temp - YUV2BIN_DIFFUSE_PAD, 0, ctx->err_len * sizeof(int16_t));
 }
 
-static int yuv422_to_bayer16_dither(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                    int dst_width, int dst_height, int invert)
+/***********************************************************
+************************Fused Kernel************************
+***********************************************************/
+/**
+ * @brief Clear bits of an output row that have no source pixel behind them
+ */
+static void __row_tail_clear(uint8_t *row, int valid_width, int stride)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
+    int full = valid_width >> 3;
+    int rem = valid_width & 0x07;
 
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
+    if (rem && full < stride) {
+        row[full] &= (uint8_t)(0xFF00 >> rem);
+        full++;
+    }
+    if (full < stride) {
+        memset(row + full, 0, stride - full);
+    }
+}
 
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
+/**
+ * @brief Gather the luma of one band into the tile, reading the source row-major
+ * @note Output row (band_y + r) is source column (band_y + r + crop_offset), and
+ *       output column dst_x is source row (src_height - 1 - dst_x).
+ */
+static void __luma_band_load(YUV2BIN_CTX_T *ctx, int band_y, int rows)
+{
+    const YUV422_TO_BINARY_PARAMS_T *params = ctx->params;
+    int r0 = 0, r1 = rows;
 
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+    // Restrict the band to source columns that exist
+    if (band_y + ctx->crop_offset < 0) {
+        r0 = -(band_y + ctx->crop_offset);
+    }
+    if (band_y + r1 + ctx->crop_offset > params->src_width) {
+        r1 = params->src_width - band_y - ctx->crop_offset;
+    }
+    if (r0 >= r1 || ctx->valid_width <= 0) {
+        return;
+    }
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            uint8_t luminance = yuv422_data[yuv_index];
+    int src_x = band_y + r0 + ctx->crop_offset;
+    int src_row_len = params->src_width * 2;
 
-            // 16-level Bayer dithering (4x4 matrix, threshold 0-15)
-            uint8_t bayer_value = bayer_4x4[dst_y % 4][dst_x % 4];
-            uint8_t gray_level = luminance / 17; // Map 0-255 to 0-15
+    for (int src_y = params->src_height - ctx->valid_width; src_y < params->src_height; src_y++) {
+        const uint8_t *src = params->yuv422_data + src_y * src_row_len + src_x * 2 + 1;
+        uint8_t *dst = ctx->luma + r0 * ctx->luma_stride + (params->src_height - 1 - src_y);
 
-            int should_set_bit = invert ? (gray_level >= bayer_value) : (gray_level < bayer_value);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
-            }
+        for (int r = r0; r < r1; r++, src += 2, dst += ctx->luma_stride) {
+            *dst = *src;
         }
     }
-
-    return 0;
 }
 
-/***********************************************************
-**************Error Diffusion Methods***********************
-***********************************************************/
-static int yuv422_to_floyd_steinberg(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                                     int dst_width, int dst_height, int invert)
+static int __ctx_init(YUV2BIN_CTX_T *ctx, const YUV422_TO_BINARY_PARAMS_T *params, int with_band)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
+    const BINARY_CONFIG_T *config = params->config;
 
-    // Allocate error buffers with padding
-    int16_t *error_buffer = (int16_t *)tal_psram_malloc((dst_width + 2) * 2 * sizeof(int16_t));
-    if (!error_buffer) {
+    memset(ctx, 0, sizeof(YUV2BIN_CTX_T));
+    ctx->params = params;
+    ctx->stride = (params->dst_width + 7) / 8;
+    ctx->crop_offset = (params->src_width - params->dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
+    ctx->valid_width = (params->dst_width < params->src_height) ? params->dst_width : params->src_height;
+    ctx->luma_stride = ctx->stride * 8;
+    ctx->polarity = params->invert_colors ? 0x00 : 0xFF; // invert=1 (LVGL): bit=1->white, 0 (printer): bit=1->black
+
+    switch (config->method) {
+    case BINARY_METHOD_FLOYD_STEINBERG:
+        ctx->diffuse = &sg_floyd_kernel;
+        break;
+    case BINARY_METHOD_STUCKI:
+        ctx->diffuse = &sg_stucki_kernel;
+        break;
+    case BINARY_METHOD_JARVIS:
+        ctx->diffuse = &sg_jarvis_kernel;
+        break;
+    case BINARY_METHOD_FIXED:
+    case BINARY_METHOD_ADAPTIVE:
+    case BINARY_METHOD_OTSU:
+    case BINARY_METHOD_BAYER4_DITHER:
+    case BINARY_METHOD_BAYER8_DITHER:
+    case BINARY_METHOD_BAYER16_DITHER:
+        break;
+    default:
         return -1;
     }
 
-    int16_t *curr_row = error_buffer + 1;
-    int16_t *next_row = error_buffer + dst_width + 3;
-    memset(error_buffer, 0, (dst_width + 2) * 2 * sizeof(int16_t));
+    // One internal-RAM block: band tile, ordered map or error rows, packed band
+    int luma_size = YUV2BIN_BAND_ROWS * ctx->luma_stride;
+    int map_size = ctx->diffuse ? 0 : YUV2BIN_MAP_ROWS * ctx->luma_stride;
+    int err_size = 0;
+    int band_size = with_band ? YUV2BIN_BAND_ROWS * ctx->stride : 0;
 
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
+    if (ctx->diffuse) {
+        ctx->err_len = ctx->luma_stride + 2 * YUV2BIN_DIFFUSE_PAD;
+        err_size = ctx->diffuse->rows * ctx->err_len * sizeof(int16_t);
+    }
 
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
+    uint8_t *block = (uint8_t *)tal_malloc(err_size + luma_size + map_size + band_size);
+    if (!block) {
+        return -1;
+    }
+    memset(block, 0, err_size + luma_size + map_size);
+    ctx->block = block;
 
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+    // Error rows first to keep them int16_t aligned
+    for (int i = 0; ctx->diffuse && i < ctx->diffuse->rows; i++) {
+        ctx->err_rows[i] = (int16_t *)block + i * ctx->err_len + YUV2BIN_DIFFUSE_PAD;
+    }
+    ctx->luma = block + err_size;
+    ctx->map = map_size ? ctx->luma + luma_size : NULL;
+    ctx->band = band_size ? ctx->luma + luma_size + map_size : NULL;
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            int16_t luminance = (int16_t)yuv422_data[yuv_index] + curr_row[dst_x];
+    switch (config->method) {
+    case BINARY_METHOD_FIXED:
+        __map_build_flat(ctx, config->fixed_threshold);
+        break;
 
-            if (luminance < 0)
-                luminance = 0;
-            if (luminance > 255)
-                luminance = 255;
+    case BINARY_METHOD_ADAPTIVE:
+    case BINARY_METHOD_OTSU: {
+        uint32_t histogram[256];
+        uint32_t total_pixels = (uint32_t)(params->src_width * params->src_height);
+
+        __luma_histogram(params->yuv422_data, params->src_width, params->src_height, histogram);
+        __map_build_flat(ctx, (config->method == BINARY_METHOD_OTSU)
+                                  ? calculate_otsu_threshold(histogram, total_pixels)
+                                  : calculate_adaptive_threshold(histogram, total_pixels));
+        break;
+    }
 
-            uint8_t new_pixel = (luminance >= 128) ? 255 : 0;
-            int16_t error = luminance - new_pixel;
+    case BINARY_METHOD_BAYER4_DITHER:
+        // 4-level: luminance / 85 >= bayer, black below 32
+        __map_build_bayer(ctx, &bayer_2x2[0][0], 2, 85, 32);
+        break;
 
-            // Printer: bit=1->black
-            int should_set_bit = invert ? (new_pixel == 255) : (new_pixel == 0);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
-            }
+    case BINARY_METHOD_BAYER8_DITHER:
+        // 8-level: luminance / 32 >= bayer, black below 16
+        __map_build_bayer(ctx, &bayer_3x3[0][0], 3, 32, 16);
+        break;
 
-            // Floyd-Steinberg error diffusion
-            if (dst_x < dst_width - 1)
-                curr_row[dst_x + 1] += (error * 7) / 16;
-            if (dst_x > 0)
-                next_row[dst_x - 1] += (error * 3) / 16;
-            next_row[dst_x] += (error * 5) / 16;
-            if (dst_x < dst_width - 1)
-                next_row[dst_x + 1] += error / 16;
-        }
+    case BINARY_METHOD_BAYER16_DITHER:
+        // 16-level: luminance / 17 >= bayer
+        __map_build_bayer(ctx, &bayer_4x4[0][0], 4, 17, 0);
+        break;
 
-        // Swap rows
-        int16_t *temp = curr_row;
-        curr_row = next_row;
-        next_row = temp;
-        memset(next_row - 1, 0, (dst_width + 2) * sizeof(int16_t));
+    default:
+        break;
     }
 
-    tal_psram_free(error_buffer);
     return 0;
 }
 
-static int yuv422_to_stucki(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                            int dst_width, int dst_height, int invert)
+static void __ctx_deinit(YUV2BIN_CTX_T *ctx)
+{
+    tal_free(ctx->block);
+    ctx->block = NULL;
+}
+
+static int __yuv422_to_binary_run(const YUV422_TO_BINARY_PARAMS_T *params, YUV422_TO_BINARY_BAND_CB band_cb,
+                                  void *user_data)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
+    YUV2BIN_CTX_T ctx;
+    int ret = 0;
 
-    // Allocate 3 error rows with padding
-    int16_t *error_buffer = (int16_t *)tal_psram_malloc((dst_width + 4) * 3 * sizeof(int16_t));
-    if (!error_buffer) {
+    if (__ctx_init(&ctx, params, band_cb != NULL) != 0) {
         return -1;
     }
 
-    int16_t *curr_row = error_buffer + 2;
-    int16_t *next_row1 = error_buffer + dst_width + 6;
-    int16_t *next_row2 = error_buffer + 2 * (dst_width + 4) + 2;
-    memset(error_buffer, 0, (dst_width + 4) * 3 * sizeof(int16_t));
-
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
-
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
-
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+    for (int band_y = 0; band_y < params->dst_height; band_y += YUV2BIN_BAND_ROWS) {
+        int rows = params->dst_height - band_y;
+        if (rows > YUV2BIN_BAND_ROWS) {
+            rows = YUV2BIN_BAND_ROWS;
+        }
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            int16_t luminance = (int16_t)yuv422_data[yuv_index] + curr_row[dst_x];
+        uint8_t *out = band_cb ? ctx.band : params->binary_data + band_y * ctx.stride;
 
-            if (luminance < 0)
-                luminance = 0;
-            if (luminance > 255)
-                luminance = 255;
+        __luma_band_load(&ctx, band_y, rows);
 
-            uint8_t new_pixel = (luminance >= 128) ? 255 : 0;
-            int16_t error = luminance - new_pixel;
+        for (int r = 0; r < rows; r++) {
+            int dst_y = band_y + r;
+            int src_x = dst_y + ctx.crop_offset;
+            uint8_t *row_out = out + r * ctx.stride;
 
-            int should_set_bit = invert ? (new_pixel == 255) : (new_pixel == 0);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
+            if (src_x < 0 || src_x >= params->src_width) {
+                memset(row_out, 0, ctx.stride);
+            } else if (ctx.diffuse) {
+                __diffuse_row(&ctx, ctx.luma + r * ctx.luma_stride, row_out);
+            } else {
+                __map_row(&ctx, ctx.luma + r * ctx.luma_stride,
+                          ctx.map + (dst_y % ctx.map_period) * ctx.luma_stride, row_out);
             }
+            __row_tail_clear(row_out, ctx.valid_width, ctx.stride);
 
-            // Stucki error diffusion (divisor: 42)
-            if (dst_x < dst_width - 1)
-                curr_row[dst_x + 1] += (error * 8) / 42;
-            if (dst_x < dst_width - 2)
-                curr_row[dst_x + 2] += (error * 4) / 42;
-            if (dst_x > 1)
-                next_row1[dst_x - 2] += (error * 2) / 42;
-            if (dst_x > 0)
-                next_row1[dst_x - 1] += (error * 4) / 42;
-            next_row1[dst_x] += (error * 8) / 42;
-            if (dst_x < dst_width - 1)
-                next_row1[dst_x + 1] += (error * 4) / 42;
-            if (dst_x < dst_width - 2)
-                next_row1[dst_x + 2] += (error * 2) / 42;
-            if (dst_x > 1)
-                next_row2[dst_x - 2] += error / 42;
-            if (dst_x > 0)
-                next_row2[dst_x - 1] += (error * 2) / 42;
-            next_row2[dst_x] += (error * 4) / 42;
-            if (dst_x < dst_width - 1)
-                next_row2[dst_x + 1] += (error * 2) / 42;
-            if (dst_x < dst_width - 2)
-                next_row2[dst_x + 2] += error / 42;
+            if (ctx.diffuse) {
+                __diffuse_rows_advance(&ctx);
+            }
         }
 
-        // Rotate rows
-        int16_t *temp = curr_row;
-        curr_row = next_row1;
-        next_row1 = next_row2;
-        next_row2 = temp;
-        memset(next_row2 - 2, 0, (dst_width + 4) * sizeof(int16_t));
+        if (band_cb && band_cb(out, band_y, rows, ctx.stride, user_data) != 0) {
+            ret = -1;
+            break;
+        }
     }
 
-    tal_psram_free(error_buffer);
-    return 0;
+    __ctx_deinit(&ctx);
+    return ret;
 }
 
-static int yuv422_to_jarvis(const uint8_t *yuv422_data, int src_width, int src_height, uint8_t *binary_data,
-                            int dst_width, int dst_height, int invert)
+/***********************************************************
+***********************Main Entry Point*********************
+***********************************************************/
+/**
+ * @brief Convert YUV422 to binary format with selected algorithm (universal interface)
+ */
+int yuv422_to_binary(const YUV422_TO_BINARY_PARAMS_T *params)
 {
-    int binary_stride = (dst_width + 7) / 8;
-    int crop_offset = (src_width - dst_height) / 2; // Dynamic: (src_width - dst_height) / 2
-
-    // Allocate 3 error rows with padding
-    int16_t *error_buffer = (int16_t *)tal_psram_malloc((dst_width + 4) * 3 * sizeof(int16_t));
-    if (!error_buffer) {
+    if (!params || !params->yuv422_data || !params->binary_data || !params->config || params->src_width <= 0 ||
+        params->src_height <= 0 || params->dst_width <= 0 || params->dst_height <= 0) {
         return -1;
     }
 
-    int16_t *curr_row = error_buffer + 2;
-    int16_t *next_row1 = error_buffer + dst_width + 6;
-    int16_t *next_row2 = error_buffer + 2 * (dst_width + 4) + 2;
-    memset(error_buffer, 0, (dst_width + 4) * 3 * sizeof(int16_t));
+    return __yuv422_to_binary_run(params, NULL, NULL);
+}
 
-    for (int dst_y = 0; dst_y < dst_height; dst_y++) {
-        int row_offset = dst_y * binary_stride;
+/**
+ * @brief Convert YUV422 to binary format band by band (streaming interface)
+ */
+int yuv422_to_binary_stream(const YUV422_TO_BINARY_PARAMS_T *params, YUV422_TO_BINARY_BAND_CB band_cb,
+                            void *user_data)
+{
+    if (!params || !params->yuv422_data || !params->config || !band_cb || params->src_width <= 0 ||
+        params->src_height <= 0 || params->dst_width <= 0 || params->dst_height <= 0) {
+        return -1;
+    }
 
-        for (int dst_x = 0; dst_x < dst_width; dst_x++) {
-            int src_x = dst_y + crop_offset;
-            int src_y = src_height - 1 - dst_x;
+    return __yuv422_to_binary_run(params, band_cb, user_data);
+}
 
-            if (src_x < 0 || src_x >= src_width || src_y < 0 || src_y >= src_height) {
-                continue;
-            }
+/**
+ * @brief Convert YUV422 to printer binary format (convenience wrapper)
+ */
+int yuv422_to_printer_binary(const YUV422_TO_BINARY_PARAMS_T *params)
+{
+    if (!params) {
+        return -1;
+    }
 
-            int yuv_index = src_y * src_width * 2 + src_x * 2 + 1;
-            int16_t luminance = (int16_t)yuv422_data[yuv_index] + curr_row[dst_x];
+    // Create a copy with invert_colors forced to 0 for printer
+    YUV422_TO_BINARY_PARAMS_T printer_params = *params;
+    printer_params.invert_colors = 0; // Printer: bit=1->black
 
-            if (luminance < 0)
-                luminance = 0;
-            if (luminance > 255)
-                luminance = 255;
+    return yuv422_to_binary(&printer_params);
+}
 
-            uint8_t new_pixel = (luminance >= 128) ? 255 : 0;
-            int16_t error = luminance - new_pixel;
+/**
+ * @brief Convert YUV422 to printer binary format band by band (convenience wrapper)
+ */
+int yuv422_to_printer_stream(const YUV422_TO_BINARY_PARAMS_T *params, YUV422_TO_BINARY_BAND_CB band_cb,
+                             void *user_data)
+{
+    if (!params) {
+        return -1;
+    }
 
-            int should_set_bit = invert ? (new_pixel == 255) : (new_pixel == 0);
-            if (should_set_bit) {
-                int byte_index = row_offset + (dst_x >> 3);
-                int bit_position = 7 - (dst_x & 0x07);
-                binary_data[byte_index] |= (1 << bit_position);
-            }
+    YUV422_TO_BINARY_PARAMS_T printer_params = *params;
+    printer_params.invert_colors = 0; // Printer: bit=1->black
 
-            // Jarvis-Judice-Ninke error diffusion (divisor: 48)
-            if (dst_x < dst_width - 1)
-                curr_row[dst_x + 1] += (error * 7) / 48;
-            if (dst_x < dst_width - 2)
-                curr_row[dst_x + 2] += (error * 5) / 48;
-            if (dst_x > 1)
-                next_row1[dst_x - 2] += (error * 3) / 48;
-            if (dst_x > 0)
-                next_row1[dst_x - 1] += (error * 5) / 48;
-            next_row1[dst_x] += (error * 7) / 48;
-            if (dst_x < dst_width - 1)
-                next_row1[dst_x + 1] += (error * 5) / 48;
-            if (dst_x < dst_width - 2)
-                next_row1[dst_x + 2] += (error * 3) / 48;
-            if (dst_x > 1)
-                next_row2[dst_x - 2] += error / 48;
-            if (dst_x > 0)
-                next_row2[dst_x - 1] += (error * 3) / 48;
-            next_row2[dst_x] += (error * 5) / 48;
-            if (dst_x < dst_width - 1)
-                next_row2[dst_x + 1] += (error * 3) / 48;
-            if (dst_x < dst_width - 2)
-                next_row2[dst_x + 2] += error / 48;
-        }
+    return yuv422_to_binary_stream(&printer_params, band_cb, user_data);
+}
 
-        // Rotate rows
-        int16_t *temp = curr_row;
-        curr_row = next_row1;
-        next_row1 = next_row2;
-        next_row2 = temp;
-        memset(next_row2 - 2, 0, (dst_width + 4) * sizeof(int16_t));
+/**
+ * @brief Convert YUV422 to LVGL I1 format binary (convenience wrapper)
+ */
+int yuv422_to_lvgl_binary(const YUV422_TO_BINARY_PARAMS_T *params)
+{
+    if (!params) {
+        return -1;
     }
 
-    tal_psram_free(error_buffer);
-    return 0;
+    // Create a copy with invert_colors forced to 1 for LVGL
+    YUV422_TO_BINARY_PARAMS_T lvgl_params = *params;
+    lvgl_params.invert_colors = 1; // LVGL: bit=1->white
+
+    return yuv422_to_binary(&lvgl_params);
 }
@@ -166,29 +166,43 @@ static void __camera_screen_lifecycle_handler(BOOL_T is_init)
     }
 }
 
+/**
+ * @brief Band callback streaming converted photo rows to the printer
+ * @param band Packed rows of this band
+ * @param row Index of the first row in this band
+ * @param rows Number of rows in this band
+ * @param stride Bytes per row
+ * @param user_data Pointer to the number of bytes sent so far
+ * @return 0 to continue conversion
+ */
+static int __camera_photo_band_handler(const uint8_t *band, int row, int rows, int stride, void *user_data)
+{
+    uint32_t *sent = (uint32_t *)user_data;
+
+    (void)row;
+    dp48a_print_bitmap_write(band, rows * stride);
+    *sent += rows * stride;
+
+    return 0;
+}
+
 /**
  * @brief Camera photo print handler
  * Called when ENTER key is pressed with raw YUV422 data
- * @param params Conversion parameters with YUV422 data and pre-allocated buffer
- * @note Buffer is allocated before callback and freed after callback returns
+ * @param params Conversion parameters with YUV422 data (binary_data is not used)
+ * @note The photo is converted band by band straight into the printer, no bitmap buffer is needed
  */
 static void __camera_photo_print_handler(const YUV422_TO_BINARY_PARAMS_T *params)
 {
-    if (!params || !params->yuv422_data || !params->binary_data || !params->config || params->src_width <= 0 ||
-        params->src_height <= 0 || params->dst_width <= 0 || params->dst_height <= 0) {
-        PR_ERR("Invalid parameters or missing pre-allocated buffer");
+    if (!params || !params->yuv422_data || !params->config || params->src_width <= 0 || params->src_height <= 0 ||
+        params->dst_width <= 0 || params->dst_height <= 0) {
+        PR_ERR("Invalid parameters");
         return;
     }
 
     PR_NOTICE("Starting camera photo print from YUV422: %dx%d -> %dx%d, method=%d", params->src_width,
               params->src_height, params->dst_width, params->dst_height, params->config->method);
 
-    int convert_result = yuv422_to_printer_binary(params);
-    if (convert_result != 0) {
-        PR_ERR("Failed to convert YUV422 to binary: %d", convert_result);
-        return;
-    }
-
     // Save current UART mode
     UART_MODE_E saved_mode;
     tal_mutex_lock(sg_mode_mutex);
@@ -210,7 +224,21 @@ static void __camera_photo_print_handler(const YUV422_TO_BINARY_PARAMS_T *params
     dp48a_set_align(DP48A_ALIGN_CENTER);
     dp48a_print_line("--- Camera Photo ---");
     dp48a_feed_lines(1);
-    dp48a_print_bitmap(params->dst_width, params->dst_height, params->binary_data);
+
+    uint32_t bitmap_size = (params->dst_width + 7) / 8 * params->dst_height;
+    uint32_t sent = 0;
+    dp48a_print_bitmap_begin(params->dst_width, params->dst_height);
+    int convert_result = yuv422_to_printer_stream(params, __camera_photo_band_handler, &sent);
+    if (convert_result != 0) {
+        PR_ERR("Failed to convert YUV422 to binary: %d", convert_result);
+        // The printer still expects the full image, finish it with blank rows
+        uint8_t blank[32] = {0};
+        while (sent < bitmap_size) {
+            uint32_t len = (bitmap_size - sent) < sizeof(blank) ? (bitmap_size - sent) : sizeof(blank);
+            dp48a_print_bitmap_write(blank, len);
+            sent += len;
+        }
+    }
 
     // Wait for print to complete
     PR_DEBUG("Waiting for print to complete...");
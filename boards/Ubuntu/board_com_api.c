@@ -96,6 +96,15 @@ static OPERATE_RET __board_register_audio(void)
             alsa_cfg.period_frames = 256;   // Default period size
         #endif
 
+        // Transfer mode and latency target, the defaults keep readi/writei
+        #if defined(CONFIG_ALSA_MMAP_ENABLE)
+            alsa_cfg.mmap_enable = CONFIG_ALSA_MMAP_ENABLE;
+        #endif
+
+        #if defined(CONFIG_ALSA_LATENCY_MS)
+            alsa_cfg.latency_ms = CONFIG_ALSA_LATENCY_MS;
+        #endif
+
         // AEC configuration (for future use)
         #if defined(ENABLE_AUDIO_AEC) && (ENABLE_AUDIO_AEC == 1)
             alsa_cfg.aec_enable = 1;
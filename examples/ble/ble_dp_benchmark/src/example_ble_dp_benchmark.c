@@ -0,0 +1,393 @@
+/**
+ * @file example_ble_dp_benchmark.c
+ * @brief Measures the BLE DP report encoder against the former KLV list.
+ *
+ * The former encoder copied every DP into a klv_node_s list, three
+ * allocations per DP, then walked the list into a frame allocated for the
+ * report. tuya_ble_dp_obj_report now encodes the DPs in one pass into a
+ * stack buffer and allocates only when a frame is larger than that buffer.
+ * This example runs both on the same DP sets, without a BLE connection: the
+ * former one from a copy of its code kept here, the new one through
+ * tuya_ble_dp_obj_encode() with the same stack-then-heap fallback as the
+ * report path.
+ *
+ * For each DP set it prints reports per second and heap allocations per
+ * report. The allocation count needs ENABLE_TAL_MEMORY_PROFILE or
+ * ENABLE_TAL_MEMORY_POOL, otherwise it is shown as -1. That both produce the
+ * same TLVs is checked by the unit tests in src/tuya_cloud_service/ut.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "ble_dp.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TIME_MS     1000 // run each case for about this long
+#define BENCH_CHECK_CNT   16   // reports between two clock reads
+#define BENCH_STACK_LEN   128  // stack buffer of the report path
+#define BENCH_TIME_STAMP  1700000000
+#define BENCH_LONG_STRING "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+
+#define LEGACY_DT_BOOL   1
+#define LEGACY_DT_VALUE  2
+#define LEGACY_DT_STRING 3
+#define LEGACY_DT_ENUM   4
+#define LEGACY_DT_BITMAP 5
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef OPERATE_RET (*BENCH_CASE_CB)(const dp_obj_t *dps, uint16_t cnt);
+
+typedef struct legacy_klv_node {
+    struct legacy_klv_node *next;
+    uint8_t id;
+    uint8_t type;
+    uint16_t len;
+    uint8_t *data;
+} LEGACY_KLV_NODE_T;
+
+typedef struct {
+    const char *name;
+    const dp_obj_t *dps;
+    uint16_t cnt;
+} BENCH_SET_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const dp_obj_t sg_switch_dps[] = {
+    {.id = 1, .type = PROP_BOOL, .value.dp_bool = true},
+};
+
+static const dp_obj_t sg_sensor_dps[] = {
+    {.id = 1, .type = PROP_BOOL, .value.dp_bool = true},  {.id = 2, .type = PROP_VALUE, .value.dp_value = 235},
+    {.id = 3, .type = PROP_VALUE, .value.dp_value = -12}, {.id = 4, .type = PROP_ENUM, .value.dp_enum = 2},
+    {.id = 5, .type = PROP_ENUM, .value.dp_enum = 300},   {.id = 6, .type = PROP_BITMAP, .value.dp_bitmap = 0x05},
+    {.id = 7, .type = PROP_VALUE, .value.dp_value = 80},  {.id = 8, .type = PROP_BOOL, .value.dp_bool = false},
+};
+
+static const dp_obj_t sg_config_dps[] = {
+    {.id = 101, .type = PROP_STR, .value.dp_str = BENCH_LONG_STRING},
+    {.id = 102, .type = PROP_VALUE, .value.dp_value = 3600},
+    {.id = 103, .type = PROP_STR, .value.dp_str = BENCH_LONG_STRING},
+    {.id = 104, .type = PROP_ENUM, .value.dp_enum = 1},
+    {.id = 105, .type = PROP_STR, .value.dp_str = "Living room"},
+};
+
+static const BENCH_SET_T sg_sets[] = {
+    {"1 bool", sg_switch_dps, CNTSOF(sg_switch_dps)},
+    {"8 scalars", sg_sensor_dps, CNTSOF(sg_sensor_dps)},
+    {"5 with strings", sg_config_dps, CNTSOF(sg_config_dps)},
+};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void __legacy_klv_free(LEGACY_KLV_NODE_T *list)
+{
+    LEGACY_KLV_NODE_T *next = NULL;
+
+    while (list) {
+        next = list->next;
+        tal_free(list->data);
+        tal_free(list);
+        list = next;
+    }
+}
+
+/**
+ * @brief The former make_klv_list: a temporary copy of the value, the node and
+ * the node data, the node pushed in front of the list
+ */
+static LEGACY_KLV_NODE_T *__legacy_klv_make(LEGACY_KLV_NODE_T *list, uint8_t id, uint8_t type, const void *data,
+                                            uint16_t len)
+{
+    LEGACY_KLV_NODE_T *node = NULL;
+    uint8_t *copy = NULL;
+    uint32_t value = 0;
+
+    copy = tal_malloc(len);
+    if (NULL == copy) {
+        goto __ERR;
+    }
+    memcpy(copy, data, len);
+    if (LEGACY_DT_STRING != type) {
+        memcpy(&value, copy, len);
+    }
+    if (LEGACY_DT_BOOL == type) {
+        len = 1;
+    } else if (LEGACY_DT_ENUM == type) {
+        len = (value <= 0xff) ? 1 : ((value <= 0xffff) ? 2 : 4);
+    }
+
+    node = tal_malloc(sizeof(LEGACY_KLV_NODE_T));
+    if (NULL == node) {
+        goto __ERR;
+    }
+    memset(node, 0, sizeof(LEGACY_KLV_NODE_T));
+    node->data = tal_malloc(len);
+    if (NULL == node->data) {
+        tal_free(node);
+        goto __ERR;
+    }
+    node->id = id;
+    node->type = type;
+    node->len = len;
+    if (LEGACY_DT_STRING == type) {
+        memcpy(node->data, copy, len);
+    } else {
+        for (uint16_t i = 0; i < len; i++) {
+            node->data[i] = (uint8_t)(value >> ((len - 1 - i) * 8));
+        }
+    }
+    node->next = list;
+    tal_free(copy);
+    return node;
+
+__ERR:
+    __legacy_klv_free(list);
+    tal_free(copy);
+    return NULL;
+}
+
+/**
+ * @brief The former klvlist_2_data: sizes the list, allocates the frame and
+ * fills it
+ */
+static OPERATE_RET __legacy_klv_to_frame(LEGACY_KLV_NODE_T *list, uint32_t time_stamp, uint8_t **frame,
+                                         uint32_t *len)
+{
+    LEGACY_KLV_NODE_T *node = NULL;
+    uint32_t frame_len = 7 + 5, offset = 0;
+    uint8_t *buf = NULL;
+
+    for (node = list; node; node = node->next) {
+        frame_len += 4 + node->len;
+    }
+    buf = tal_malloc(frame_len);
+    if (NULL == buf) {
+        return OPRT_MALLOC_FAILED;
+    }
+
+    buf[offset++] = 0;
+    memset(&buf[offset], 0, 4); // sn
+    offset += 4;
+    buf[offset++] = 0;
+    buf[offset++] = 0;
+    buf[offset++] = 1;
+    memcpy(&buf[offset], &time_stamp, 4);
+    offset += 4;
+    for (node = list; node; node = node->next) {
+        buf[offset++] = node->id;
+        buf[offset++] = node->type;
+        buf[offset++] = node->len >> 8;
+        buf[offset++] = node->len & 0xff;
+        memcpy(&buf[offset], node->data, node->len);
+        offset += node->len;
+    }
+    *frame = buf;
+    *len = offset;
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __legacy_report(const dp_obj_t *dps, uint16_t cnt)
+{
+    LEGACY_KLV_NODE_T *list = NULL;
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t *frame = NULL;
+    uint32_t len = 0;
+
+    for (uint16_t i = 0; i < cnt; i++) {
+        const dp_obj_t *dp = &dps[i];
+        uint32_t value = 0;
+
+        switch (dp->type) {
+        case PROP_BOOL:
+            value = dp->value.dp_bool;
+            list = __legacy_klv_make(list, dp->id, LEGACY_DT_BOOL, &value, 4);
+            break;
+        case PROP_VALUE:
+            list = __legacy_klv_make(list, dp->id, LEGACY_DT_VALUE, &dp->value.dp_value, 4);
+            break;
+        case PROP_STR:
+            list = __legacy_klv_make(list, dp->id, LEGACY_DT_STRING, dp->value.dp_str, strlen(dp->value.dp_str));
+            break;
+        case PROP_ENUM:
+            list = __legacy_klv_make(list, dp->id, LEGACY_DT_ENUM, &dp->value.dp_enum, 4);
+            break;
+        case PROP_BITMAP:
+            list = __legacy_klv_make(list, dp->id, LEGACY_DT_BITMAP, &dp->value.dp_bitmap, 4);
+            break;
+        default:
+            break;
+        }
+        if (NULL == list) {
+            return OPRT_MALLOC_FAILED;
+        }
+    }
+
+    rt = __legacy_klv_to_frame(list, BENCH_TIME_STAMP, &frame, &len);
+    __legacy_klv_free(list);
+    tal_free(frame);
+
+    return rt;
+}
+
+/**
+ * @brief Encodes a report the way tuya_ble_dp_obj_report does before handing
+ * the frame to tuya_ble_send
+ */
+static OPERATE_RET __tlv_report(const dp_obj_t *dps, uint16_t cnt)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t stack_buf[BENCH_STACK_LEN];
+    uint8_t *heap_buf = NULL;
+    uint32_t len = 0;
+
+    rt = tuya_ble_dp_obj_encode(dps, cnt, NULL, 0, BENCH_TIME_STAMP, stack_buf, sizeof(stack_buf), &len);
+    if (OPRT_BUFFER_NOT_ENOUGH == rt) {
+        heap_buf = tal_malloc(len);
+        if (NULL == heap_buf) {
+            return OPRT_MALLOC_FAILED;
+        }
+        rt = tuya_ble_dp_obj_encode(dps, cnt, NULL, 0, BENCH_TIME_STAMP, heap_buf, len, &len);
+        tal_free(heap_buf);
+    }
+
+    return rt;
+}
+
+/**
+ * @brief Runs one case for BENCH_TIME_MS and prints reports/s and heap
+ * allocations per report
+ *
+ * @param[in] name case name
+ * @param[in] cb case body
+ * @param[in] set DP set
+ *
+ * @return none
+ */
+static void __bench_run(const char *name, BENCH_CASE_CB cb, const BENCH_SET_T *set)
+{
+    TAL_MEMORY_STATS_T stats = {0};
+    uint32_t start_ms = 0, elapsed_ms = 0;
+    uint32_t reports = 0, alloc_cnt = 0, i;
+    int allocs = -1;
+
+    if (OPRT_OK == tal_memory_get_stats(&stats)) {
+        alloc_cnt = stats.alloc_cnt;
+        if (OPRT_OK != cb(set->dps, set->cnt) || OPRT_OK != tal_memory_get_stats(&stats)) {
+            PR_ERR("%s %s failed", name, set->name);
+            return;
+        }
+        allocs = stats.alloc_cnt - alloc_cnt;
+    }
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    do {
+        for (i = 0; i < BENCH_CHECK_CNT; i++) {
+            if (OPRT_OK != cb(set->dps, set->cnt)) {
+                PR_ERR("%s %s failed", name, set->name);
+                return;
+            }
+        }
+        reports += BENCH_CHECK_CNT;
+        elapsed_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("%-8s %-16s %9d reports/s %4d allocs/report", name, set->name,
+              (uint32_t)((uint64_t)reports * 1000 / elapsed_ms), allocs);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t i;
+    uint32_t len = 0;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    PR_NOTICE("------ ble dp benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_sets); i++) {
+        tuya_ble_dp_obj_encode(sg_sets[i].dps, sg_sets[i].cnt, NULL, 0, BENCH_TIME_STAMP, NULL, 0, &len);
+        PR_NOTICE("%s: %d byte frame", sg_sets[i].name, len);
+        __bench_run("klv", __legacy_report, &sg_sets[i]);
+        __bench_run("tlv", __tlv_report, &sg_sets[i]);
+    }
+
+    PR_NOTICE("------ ble dp benchmark end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,238 @@
+/**
+ * @file example_lvgl_mem_benchmark.c
+ * @brief Measures LVGL allocation time and heap fragmentation under widget churn.
+ *
+ * The example runs LVGL headless: a display with a RAM draw buffer and a flush
+ * callback that drops the pixels, so it needs no screen and runs on Ubuntu as
+ * well as on a board. Each round builds a chat-like widget tree of a varying
+ * size, renders it and deletes the oldest of the BENCH_LIVE_TREES trees kept
+ * alive, so blocks of mixed sizes and lifetimes interleave the way they do in
+ * a real UI.
+ *
+ * Every BENCH_REPORT rounds it prints the average create and delete time and
+ * what lv_mem_monitor() reports. Build it once with LVGL_MEM_POOL_SIZE unset
+ * (lv_malloc() on the system heap, the monitor then shows nothing) and once
+ * with it set to compare; the system free heap is printed in both cases.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+#include "lvgl.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_HOR_RES    320
+#define BENCH_VER_RES    240
+#define BENCH_BUF_LINES  40
+#define BENCH_ROUNDS     400
+#define BENCH_REPORT     100
+#define BENCH_LIVE_TREES 4
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+static uint16_t sg_draw_buf[BENCH_HOR_RES * BENCH_BUF_LINES];
+static lv_obj_t *sg_trees[BENCH_LIVE_TREES];
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+static uint32_t __bench_tick_get(void)
+{
+    return (uint32_t)tal_system_get_millisecond();
+}
+
+static void __bench_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    lv_display_flush_ready(disp);
+}
+
+/**
+ * @brief Builds a scrolling list of message bubbles with a header
+ *
+ * @param[in] rows number of messages
+ *
+ * @return the root object
+ */
+static lv_obj_t *__bench_tree_create(uint32_t rows)
+{
+    lv_obj_t *root = lv_obj_create(lv_screen_active());
+    lv_obj_t *row = NULL, *obj = NULL;
+    uint32_t i;
+
+    lv_obj_set_size(root, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_flex_flow(root, LV_FLEX_FLOW_COLUMN);
+
+    obj = lv_label_create(root);
+    lv_label_set_text_fmt(obj, "conversation with %d messages", (int)rows);
+
+    for (i = 0; i < rows; i++) {
+        row = lv_obj_create(root);
+        lv_obj_set_size(row, LV_PCT(90), LV_SIZE_CONTENT);
+        lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+
+        obj = lv_label_create(row);
+        // message lengths vary so the text buffers differ in size
+        lv_label_set_text_fmt(obj, "message %d %.*s", (int)i, (int)(i * 7 % 48),
+                              "lorem ipsum dolor sit amet consectetur adipiscing");
+
+        if (0 == i % 3) {
+            obj = lv_button_create(row);
+            obj = lv_label_create(obj);
+            lv_label_set_text(obj, LV_SYMBOL_OK);
+        }
+        if (0 == i % 5) {
+            obj = lv_bar_create(row);
+            lv_bar_set_value(obj, i % 100, LV_ANIM_OFF);
+        }
+    }
+
+    return root;
+}
+
+static void __bench_report(uint32_t round, uint32_t create_ms, uint32_t delete_ms)
+{
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+
+    PR_NOTICE("round %4d: create %5d us, delete %5d us", round, create_ms * 1000 / BENCH_REPORT,
+              delete_ms * 1000 / BENCH_REPORT);
+    PR_NOTICE("  lv pool: used %3d%% of %7d B, max used %7d B, frag %3d%%, biggest free %7d B, used blocks %d",
+              mon.used_pct, (int)mon.total_size, (int)mon.max_used, mon.frag_pct, (int)mon.free_biggest_size,
+              (int)mon.used_cnt);
+    PR_NOTICE("  system free heap %d B", tal_system_get_free_heap_size());
+}
+
+static void __bench_run(void)
+{
+    lv_display_t *disp = NULL;
+    uint32_t create_ms = 0, delete_ms = 0, start_ms = 0;
+    uint32_t round, slot;
+
+    lv_init();
+    lv_tick_set_cb(__bench_tick_get);
+
+    disp = lv_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+    lv_display_set_flush_cb(disp, __bench_flush);
+    lv_display_set_buffers(disp, sg_draw_buf, NULL, sizeof(sg_draw_buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+    __bench_report(0, 0, 0);
+
+    for (round = 1; round <= BENCH_ROUNDS; round++) {
+        slot = round % BENCH_LIVE_TREES;
+
+        if (sg_trees[slot]) {
+            start_ms = (uint32_t)tal_system_get_millisecond();
+            lv_obj_delete(sg_trees[slot]);
+            delete_ms += (uint32_t)tal_system_get_millisecond() - start_ms;
+        }
+
+        start_ms = (uint32_t)tal_system_get_millisecond();
+        sg_trees[slot] = __bench_tree_create(8 + round * 13 % 33);
+        create_ms += (uint32_t)tal_system_get_millisecond() - start_ms;
+
+        lv_refr_now(disp);
+
+        if (0 == round % BENCH_REPORT) {
+            __bench_report(round, create_ms, delete_ms);
+            create_ms = 0;
+            delete_ms = 0;
+        }
+    }
+
+    if (LV_RESULT_OK != lv_mem_test()) {
+        PR_ERR("lv_mem_test failed");
+    }
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+    PR_NOTICE("------ lvgl mem benchmark start ------");
+
+    __bench_run();
+
+    PR_NOTICE("------ lvgl mem benchmark end ------");
+#else
+    PR_ERR("LVGL is not enabled. Please enable CONFIG_ENABLE_LIBLVGL in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 8;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
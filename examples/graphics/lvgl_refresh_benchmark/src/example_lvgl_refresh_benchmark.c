@@ -0,0 +1,298 @@
+/**
+ * @file example_lvgl_refresh_benchmark.c
+ * @brief Measures how the LVGL task of lv_vendor renders, flushes and wakes up.
+ *
+ * The example runs headless: it registers a RAM display with tdl_display whose
+ * flush only waits BENCH_FLUSH_MS, the time a QSPI panel takes to receive a
+ * 320x240 RGB565 frame, and hands it to lv_vendor like a board display. The
+ * LVGL task, its wakeups and its statistics are then the ones of a device.
+ *
+ * Three phases print lv_vendor_get_stats() every second for BENCH_PHASE_S
+ * seconds, after one second left out as the statistics cover the last
+ * complete second:
+ * - idle: a static screen, what matters is how often the task wakes up;
+ * - animation: a spinner, fps and the render and flush time per frame;
+ * - remote update: the application thread changes a label every
+ *   BENCH_UPDATE_MS under lv_vendor_disp_lock(), the phase also reports the
+ *   time from lv_vendor_disp_unlock() until the change is on the panel.
+ *
+ * Build it with CONFIG_LVGL_TASK_SLEEP_TIME_CUSTOMIZE set to compare with a
+ * task that sleeps a fixed slice between passes; lv_vendor_disp_unlock()
+ * still wakes it up then.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+#include "lvgl.h"
+#include "lv_vendor.h"
+#include "tdl_display_manage.h"
+#include "tdl_display_driver.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_DISP_NAME  "bench_ram"
+#define BENCH_HOR_RES    320
+#define BENCH_VER_RES    240
+#define BENCH_FLUSH_MS   8  // 320x240 RGB565 over a 40 MHz QSPI link
+#define BENCH_PHASE_S    3
+#define BENCH_UPDATE_MS  37 // period of the label changes of the remote update phase
+#define BENCH_LVGL_PRI   5
+#define BENCH_LVGL_STACK (1024 * 8)
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+static uint8_t sg_ram_disp; // the driver has no state, the handle only has to be set
+static lv_obj_t *sg_label;
+
+// written under lv_vendor_disp_lock() and read in the flush, which the LVGL task makes under the same lock
+static uint32_t sg_update_ms; // time of the oldest change not on the panel yet, 0 if none
+static uint32_t sg_latency_sum;
+static uint32_t sg_latency_max;
+static uint32_t sg_latency_cnt;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+static OPERATE_RET __ram_disp_open(TDD_DISP_DEV_HANDLE_T device)
+{
+    (void)device;
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __ram_disp_flush(TDD_DISP_DEV_HANDLE_T device, TDL_DISP_FRAME_BUFF_T *frame_buff)
+{
+    uint32_t now_ms = 0, latency_ms = 0;
+
+    (void)device;
+
+    // like a DMA transfer, the panel takes the frame without the CPU
+    tal_system_sleep(BENCH_FLUSH_MS);
+
+    now_ms = (uint32_t)tal_system_get_millisecond();
+    if (sg_update_ms) {
+        latency_ms = now_ms - sg_update_ms;
+        sg_latency_sum += latency_ms;
+        sg_latency_cnt++;
+        if (latency_ms > sg_latency_max) {
+            sg_latency_max = latency_ms;
+        }
+        sg_update_ms = 0;
+    }
+
+    if (frame_buff && frame_buff->free_cb) {
+        frame_buff->free_cb(frame_buff);
+    }
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __ram_disp_close(TDD_DISP_DEV_HANDLE_T device)
+{
+    (void)device;
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __ram_disp_register(void)
+{
+    TDD_DISP_DEV_INFO_T info;
+    TDD_DISP_INTFS_T intfs = {
+        .open = __ram_disp_open,
+        .flush = __ram_disp_flush,
+        .close = __ram_disp_close,
+    };
+
+    memset(&info, 0, sizeof(TDD_DISP_DEV_INFO_T));
+    info.type = TUYA_DISPLAY_RGB;
+    info.width = BENCH_HOR_RES;
+    info.height = BENCH_VER_RES;
+    info.fmt = TUYA_PIXEL_FMT_RGB565;
+    info.rotation = TUYA_DISPLAY_ROTATION_0;
+    info.bl.type = TUYA_DISP_BL_TP_NONE;
+    info.power.pin = TUYA_GPIO_NUM_MAX;
+
+    return tdl_disp_device_register(BENCH_DISP_NAME, &sg_ram_disp, &intfs, &info);
+}
+
+static void __bench_report(const char *phase, uint32_t second)
+{
+    lv_vendor_stats_t stats;
+
+    lv_vendor_get_stats(&stats);
+
+    PR_NOTICE("%-13s %d s: fps %3d, render avg %3d max %3d ms, flush avg %3d max %3d ms, wakeups %4d", phase,
+              second, stats.fps, stats.render_avg_ms, stats.render_max_ms, stats.flush_avg_ms, stats.flush_max_ms,
+              stats.wakeups);
+}
+
+/**
+ * @brief Runs one phase for 1 + BENCH_PHASE_S seconds and reports every second but the first
+ *
+ * @param[in] phase phase name
+ * @param[in] remote_update change the label every BENCH_UPDATE_MS
+ *
+ * @return none
+ */
+static void __bench_phase(const char *phase, bool remote_update)
+{
+    uint32_t start_ms = (uint32_t)tal_system_get_millisecond();
+    uint32_t now_ms = 0, second = 0, count = 0;
+
+    while (second <= BENCH_PHASE_S) {
+        tal_system_sleep(BENCH_UPDATE_MS);
+
+        if (remote_update) {
+            lv_vendor_disp_lock();
+            lv_label_set_text_fmt(sg_label, "remote update %d", (int)++count);
+            if (0 == sg_update_ms) {
+                sg_update_ms = (uint32_t)tal_system_get_millisecond();
+            }
+            lv_vendor_disp_unlock();
+        }
+
+        now_ms = (uint32_t)tal_system_get_millisecond();
+        if (now_ms - start_ms >= (second + 1) * 1000) {
+            if (second) {
+                __bench_report(phase, second);
+            }
+            second++;
+        }
+    }
+}
+
+static void __bench_run(void)
+{
+    lv_obj_t *spinner = NULL;
+
+    if (OPRT_OK != __ram_disp_register()) {
+        PR_ERR("display register failed");
+        return;
+    }
+
+    lv_vendor_init(BENCH_DISP_NAME);
+
+    sg_label = lv_label_create(lv_screen_active());
+    lv_label_set_text(sg_label, "idle");
+    lv_obj_align(sg_label, LV_ALIGN_TOP_MID, 0, 16);
+
+    lv_vendor_start(BENCH_LVGL_PRI, BENCH_LVGL_STACK);
+
+    __bench_phase("idle", false);
+
+    lv_vendor_disp_lock();
+    lv_label_set_text(sg_label, "animation");
+    spinner = lv_spinner_create(lv_screen_active());
+    lv_obj_set_size(spinner, 120, 120);
+    lv_obj_center(spinner);
+    lv_vendor_disp_unlock();
+
+    __bench_phase("animation", false);
+
+    lv_vendor_disp_lock();
+    lv_obj_delete(spinner);
+    lv_vendor_disp_unlock();
+
+    __bench_phase("remote update", true);
+
+    lv_vendor_disp_lock();
+    PR_NOTICE("remote update to panel: avg %d ms, max %d ms over %d updates",
+              sg_latency_cnt ? sg_latency_sum / sg_latency_cnt : 0, sg_latency_max, sg_latency_cnt);
+    lv_vendor_disp_unlock();
+
+    lv_vendor_stop();
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_LIBLVGL) && (ENABLE_LIBLVGL == 1)
+    PR_NOTICE("------ lvgl refresh benchmark start ------");
+
+    __bench_run();
+
+    PR_NOTICE("------ lvgl refresh benchmark end ------");
+#else
+    PR_ERR("LVGL is not enabled. Please enable CONFIG_ENABLE_LIBLVGL in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file example_alsa_latency_benchmark.c
+ * @brief Compares the readi/writei and mmap transfer modes of tdd_audio_alsa.
+ *
+ * The example registers the same stream twice, once per transfer mode, on the
+ * ALSA loopback card (modprobe snd-aloop): what is played on hw:Loopback,0,0
+ * is captured back on hw:Loopback,1,0, so no sound hardware is needed.
+ *
+ * For each mode it plays BENCH_RUN_MS of silence with a full-scale click every
+ * BENCH_CLICK_MS and reports:
+ * - the round trip from the play call that queued a click to the mic_cb call
+ *   that returned it, average and worst case;
+ * - the CPU time the process spent per second of audio (getrusage);
+ * - the xruns, granted period and buffer sizes from tdd_audio_alsa_get_stats().
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_AUDIO_ALSA) && (ENABLE_AUDIO_ALSA == 1)
+#include <sys/resource.h>
+
+#include "tdl_audio_manage.h"
+#include "tdd_audio_alsa.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_PLAY_DEVICE    "hw:Loopback,0,0"
+#define BENCH_CAPTURE_DEVICE "hw:Loopback,1,0"
+#define BENCH_SAMPLE_RATE    16000
+#define BENCH_LATENCY_MS     20
+#define BENCH_CHUNK_MS       10
+#define BENCH_CHUNK_SAMPLES  (BENCH_SAMPLE_RATE * BENCH_CHUNK_MS / 1000)
+#define BENCH_RUN_MS         10000
+#define BENCH_CLICK_MS       500
+#define BENCH_CLICK_LEVEL    16000 // captured samples above this are the click
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    volatile SYS_TIME_T click_ms; // 0 when no click is in flight
+    uint32_t clicks;
+    uint32_t sum_ms;
+    uint32_t max_ms;
+} BENCH_RESULT_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_AUDIO_ALSA) && (ENABLE_AUDIO_ALSA == 1)
+static BENCH_RESULT_T sg_result;
+static int16_t sg_silence[BENCH_CHUNK_SAMPLES];
+static int16_t sg_click[BENCH_CHUNK_SAMPLES];
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_AUDIO_ALSA) && (ENABLE_AUDIO_ALSA == 1)
+static void __bench_mic_cb(TDL_AUDIO_FRAME_FORMAT_E type, TDL_AUDIO_STATUS_E status, uint8_t *data, uint32_t len)
+{
+    int16_t *pcm = (int16_t *)data;
+    uint32_t i, rtt_ms;
+
+    if (0 == sg_result.click_ms) {
+        return;
+    }
+
+    for (i = 0; i < len / sizeof(int16_t); i++) {
+        if (pcm[i] > BENCH_CLICK_LEVEL) {
+            rtt_ms = (uint32_t)(tal_system_get_millisecond() - sg_result.click_ms);
+            sg_result.click_ms = 0;
+            sg_result.clicks++;
+            sg_result.sum_ms += rtt_ms;
+            if (rtt_ms > sg_result.max_ms) {
+                sg_result.max_ms = rtt_ms;
+            }
+            return;
+        }
+    }
+}
+
+static uint64_t __bench_cpu_us(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+static OPERATE_RET __bench_register(char *name, uint8_t mmap_enable)
+{
+    TDD_AUDIO_ALSA_CFG_T cfg = {0};
+
+    strncpy(cfg.capture_device, BENCH_CAPTURE_DEVICE, sizeof(cfg.capture_device) - 1);
+    strncpy(cfg.playback_device, BENCH_PLAY_DEVICE, sizeof(cfg.playback_device) - 1);
+    cfg.sample_rate = TDD_ALSA_SAMPLE_16000;
+    cfg.spk_sample_rate = TDD_ALSA_SAMPLE_16000;
+    cfg.data_bits = TDD_ALSA_DATABITS_16;
+    cfg.channels = TDD_ALSA_CHANNEL_MONO;
+    cfg.latency_ms = BENCH_LATENCY_MS;
+    cfg.mmap_enable = mmap_enable;
+
+    return tdd_audio_alsa_register(name, cfg);
+}
+
+static void __bench_run(char *name)
+{
+    OPERATE_RET rt = OPRT_OK;
+    TDL_AUDIO_HANDLE_T audio = NULL;
+    TDD_AUDIO_ALSA_STATS_T stats;
+    SYS_TIME_T start_ms, next_click_ms, now_ms;
+    uint64_t cpu_us;
+
+    memset(&sg_result, 0, sizeof(sg_result));
+
+    TUYA_CALL_ERR_LOG(tdl_audio_find(name, &audio));
+    if (OPRT_OK != rt) {
+        return;
+    }
+    TUYA_CALL_ERR_LOG(tdl_audio_open(audio, __bench_mic_cb));
+    if (OPRT_OK != rt) {
+        PR_ERR("open %s failed, is snd-aloop loaded?", name);
+        return;
+    }
+
+    cpu_us = __bench_cpu_us();
+    start_ms = tal_system_get_millisecond();
+    next_click_ms = start_ms + BENCH_CLICK_MS;
+
+    // play blocks on the device, so the loop runs at the sample rate
+    do {
+        now_ms = tal_system_get_millisecond();
+        if (now_ms >= next_click_ms && 0 == sg_result.click_ms) {
+            sg_result.click_ms = now_ms;
+            tdl_audio_play(audio, (uint8_t *)sg_click, sizeof(sg_click));
+            next_click_ms = now_ms + BENCH_CLICK_MS;
+        } else {
+            tdl_audio_play(audio, (uint8_t *)sg_silence, sizeof(sg_silence));
+        }
+    } while (now_ms - start_ms < BENCH_RUN_MS);
+
+    cpu_us = __bench_cpu_us() - cpu_us;
+    tdd_audio_alsa_get_stats(name, &stats);
+    tdl_audio_close(audio);
+
+    PR_NOTICE("%-10s round trip avg %3d ms, max %3d ms over %d clicks", name,
+              sg_result.clicks ? sg_result.sum_ms / sg_result.clicks : 0, sg_result.max_ms, sg_result.clicks);
+    PR_NOTICE("%-10s cpu %d us per second of audio", name, (uint32_t)(cpu_us * 1000 / BENCH_RUN_MS));
+    PR_NOTICE("%-10s capture period %d, buffer %d frames, xruns %d", name, stats.capture_period_frames,
+              stats.capture_buffer_frames, stats.capture_xruns);
+    PR_NOTICE("%-10s playback period %d, buffer %d frames, xruns %d", name, stats.playback_period_frames,
+              stats.playback_buffer_frames, stats.playback_xruns);
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_AUDIO_ALSA) && (ENABLE_AUDIO_ALSA == 1)
+    uint32_t i;
+
+    for (i = 0; i < BENCH_CHUNK_SAMPLES; i++) {
+        sg_click[i] = (i < 8) ? 32767 : 0;
+    }
+
+    if (OPRT_OK != __bench_register("alsa_rw", 0) || OPRT_OK != __bench_register("alsa_mmap", 1)) {
+        PR_ERR("register ALSA drivers failed");
+        return;
+    }
+
+    PR_NOTICE("------ alsa latency benchmark start ------");
+
+    __bench_run("alsa_rw");
+    __bench_run("alsa_mmap");
+
+    PR_NOTICE("------ alsa latency benchmark end ------");
+#else
+    PR_ERR("ALSA is not enabled. Please enable CONFIG_ENABLE_AUDIO_ALSA in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,578 @@
+/**
+ * @file example_p2p_cmd_benchmark.c
+ * @brief Measures how fast the P2P command channel answers bursts of commands.
+ *
+ * The app and the device are joined by a local loopback which behaves as the
+ * KCP stream of a session: every write of the app is one message, a read
+ * returns the next message, or its start when the buffer is shorter. The app
+ * sends bursts of playback control commands (pause and resume), the device
+ * reads and answers them, the app reads the responses back and checks that
+ * every command got its answer, in order.
+ *
+ * Two device readers are compared for bursts of 1, 4, 16 and 64 commands:
+ * - "per command": the header then the payload are read, the buffer is
+ *   cleared after each command and every response is allocated and sent on
+ *   its own, as the session did before the command channel;
+ * - "channel": tuya_ipc_p2p_cmd_chan.h reads what has come, handles every
+ *   complete command through a handler table and sends the responses of the
+ *   burst together.
+ *
+ * For each it reports the round trip of a burst, the time per command and
+ * the reads and sends the device made. A last case cuts the command stream
+ * at random places, commands of odd lengths included, and checks that both
+ * readers give the app the same responses.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+#include <string.h>
+
+#include "tuya_ipc_p2p_cmd_chan.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TIME_MS   1000 // run each case for about this long
+#define BENCH_BURST_MAX 64
+#define BENCH_FUZZ_NUM  2000 // bursts of the random cut case
+#define BENCH_TEXT_MAX  200  // payload of a text command at most
+
+#define BENCH_PIPE_SIZE (64 * 1024)
+#define BENCH_PIPE_MSG  4096
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+// one direction of the loopback
+typedef struct {
+    MUTEX_HANDLE mutex;
+    CHAR_T data[BENCH_PIPE_SIZE];
+    UINT_T msg_len[BENCH_PIPE_MSG];
+    UINT_T msg_head;
+    UINT_T msg_tail;
+    UINT_T rpos; // Read position in data, the messages follow each other from 0
+    UINT_T wpos;
+} BENCH_PIPE_T;
+
+// the device reader before the command channel
+typedef struct {
+    INT_T read_size;
+    CHAR_T read_buff[P2P_CMD_CHAN_RECV_SIZE];
+    INT_T cur_read;
+    INT_T flag;
+} BENCH_OLD_READER_T;
+
+typedef struct {
+    UINT_T reads;
+    UINT_T sends;
+} BENCH_COUNT_T;
+#endif
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static BENCH_PIPE_T sg_to_dev;
+static BENCH_PIPE_T sg_to_app;
+static BENCH_OLD_READER_T sg_old;
+static P2P_CMD_CHAN_T sg_chan;
+static BENCH_COUNT_T sg_count;
+static UINT_T sg_paused;
+static UINT_T sg_seed = 1;
+static CHAR_T sg_app_buff[BENCH_PIPE_SIZE];
+static CHAR_T sg_resp_expect[BENCH_PIPE_SIZE];
+static INT_T sg_resp_expect_len;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static UINT_T __rand(VOID)
+{
+    sg_seed = sg_seed * 1103515245 + 12345;
+    return sg_seed >> 16;
+}
+
+static VOID __pipe_reset(BENCH_PIPE_T *pipe)
+{
+    pipe->msg_head = 0;
+    pipe->msg_tail = 0;
+    pipe->rpos = 0;
+    pipe->wpos = 0;
+}
+
+static INT_T __pipe_write(BENCH_PIPE_T *pipe, CONST CHAR_T *buff, INT_T len)
+{
+    tal_mutex_lock(pipe->mutex);
+    if (pipe->wpos + len > BENCH_PIPE_SIZE || pipe->msg_tail - pipe->msg_head >= BENCH_PIPE_MSG) {
+        tal_mutex_unlock(pipe->mutex);
+        return -1;
+    }
+    memcpy(pipe->data + pipe->wpos, buff, len);
+    pipe->wpos += len;
+    pipe->msg_len[pipe->msg_tail++ % BENCH_PIPE_MSG] = len;
+    tal_mutex_unlock(pipe->mutex);
+    return len;
+}
+
+// the next message, or its start when buff is shorter, as ikcp_recv2
+static INT_T __pipe_read(BENCH_PIPE_T *pipe, CHAR_T *buff, INT_T len)
+{
+    UINT_T *p_msg_len = NULL;
+
+    tal_mutex_lock(pipe->mutex);
+    if (pipe->msg_head == pipe->msg_tail) {
+        // empty, start over at the front of the buffer
+        pipe->rpos = 0;
+        pipe->wpos = 0;
+        tal_mutex_unlock(pipe->mutex);
+        return 0;
+    }
+    p_msg_len = &pipe->msg_len[pipe->msg_head % BENCH_PIPE_MSG];
+    if ((UINT_T)len >= *p_msg_len) {
+        len = *p_msg_len;
+        pipe->msg_head++;
+    } else {
+        *p_msg_len -= len;
+    }
+    memcpy(buff, pipe->data + pipe->rpos, len);
+    pipe->rpos += len;
+    tal_mutex_unlock(pipe->mutex);
+    return len;
+}
+
+static INT_T __dev_recv(VOID *priv, CHAR_T *buff, INT_T *p_len, INT_T timeout_ms)
+{
+    *p_len = __pipe_read(&sg_to_dev, buff, *p_len);
+    if (*p_len > 0) {
+        sg_count.reads++;
+    }
+    return OPRT_OK;
+}
+
+static INT_T __dev_send(VOID *priv, CHAR_T *buff, INT_T len)
+{
+    sg_count.sends++;
+    return __pipe_write(&sg_to_app, buff, len);
+}
+
+/* the device side, the same handlers for both readers */
+static VOID __cmd_playback(VOID *priv, P2P_CMD_PARSE_T *p_cmd, CHAR_T *payload)
+{
+    C2C_TRANS_CTRL_VIDEO_REQ_T *parm = (C2C_TRANS_CTRL_VIDEO_REQ_T *)payload;
+    C2C_CMD_IO_CTRL_COM_RESP_T resp;
+
+    sg_paused = (TY_CMD_IO_CTRL_VIDEO_PAUSE == parm->operation);
+    memset(&resp, 0, sizeof(resp));
+    resp.channel = parm->channel;
+    resp.result = TY_C2C_CMD_IO_CTRL_COMMAND_SUCCESS;
+    p2p_cmd_chan_resp(&sg_chan, p_cmd, &resp, sizeof(resp));
+}
+
+static VOID __cmd_text(VOID *priv, P2P_CMD_PARSE_T *p_cmd, CHAR_T *payload)
+{
+    // echoed back
+    p2p_cmd_chan_resp(&sg_chan, p_cmd, payload, p_cmd->str_header.length);
+}
+
+static VOID __cmd_unknown(VOID *priv, P2P_CMD_PARSE_T *p_cmd, CHAR_T *payload)
+{
+    C2C_CMD_IO_CTRL_COM_RESP_T resp;
+
+    memset(&resp, 0, sizeof(resp));
+    resp.result = TY_C2C_CMD_IO_CTRL_COMMAND_INVALID;
+    p2p_cmd_chan_resp(&sg_chan, p_cmd, &resp, sizeof(resp));
+}
+
+static CONST P2P_CMD_HANDLER_T sg_handler[] = {
+    {TY_C2C_CMD_IO_CTRL_PLAYBACK, sizeof(C2C_TRANS_CTRL_VIDEO_REQ_T), __cmd_playback},
+    {TY_C2C_CMD_QUERY_TEXT, 0, __cmd_text},
+};
+
+static CONST P2P_CMD_CHAN_CFG_T sg_chan_cfg = {
+    .handler = sg_handler,
+    .handler_num = sizeof(sg_handler) / sizeof(sg_handler[0]),
+    .unknown = __cmd_unknown,
+    .recv = __dev_recv,
+    .send = __dev_send,
+};
+
+/* the reader before the command channel: header, payload, a response per send */
+static VOID __old_resp(P2P_CMD_PARSE_T *p_cmd, VOID *payload, INT_T len)
+{
+    INT_T pack_len = P2P_CMD_HEAD_LEN + len;
+    CHAR_T *buff = (CHAR_T *)tal_malloc(pack_len);
+
+    if (NULL == buff) {
+        return;
+    }
+    memcpy(buff, p_cmd, P2P_CMD_HEAD_LEN);
+    ((P2P_CMD_PARSE_T *)buff)->str_header.type = 1;
+    ((P2P_CMD_PARSE_T *)buff)->str_header.length = len;
+    memcpy(buff + P2P_CMD_HEAD_LEN, payload, len);
+    __dev_send(NULL, buff, pack_len);
+    tal_free(buff);
+}
+
+static VOID __old_parse(P2P_CMD_PARSE_T *p_cmd)
+{
+    CHAR_T *payload = (CHAR_T *)(p_cmd + 1);
+    C2C_CMD_IO_CTRL_COM_RESP_T resp;
+
+    if (0 != p_cmd->str_header.type) {
+        return;
+    }
+    memset(&resp, 0, sizeof(resp));
+    switch (p_cmd->str_header.high_cmd) {
+    case TY_C2C_CMD_IO_CTRL_PLAYBACK: {
+        C2C_TRANS_CTRL_VIDEO_REQ_T *parm = (C2C_TRANS_CTRL_VIDEO_REQ_T *)payload;
+        sg_paused = (TY_CMD_IO_CTRL_VIDEO_PAUSE == parm->operation);
+        resp.channel = parm->channel;
+        resp.result = TY_C2C_CMD_IO_CTRL_COMMAND_SUCCESS;
+        __old_resp(p_cmd, &resp, sizeof(resp));
+        break;
+    }
+    case TY_C2C_CMD_QUERY_TEXT:
+        __old_resp(p_cmd, payload, p_cmd->str_header.length);
+        break;
+    default:
+        resp.result = TY_C2C_CMD_IO_CTRL_COMMAND_INVALID;
+        __old_resp(p_cmd, &resp, sizeof(resp));
+        break;
+    }
+}
+
+static VOID __old_reset(VOID)
+{
+    memset(&sg_old, 0, sizeof(sg_old));
+    sg_old.read_size = P2P_CMD_HEAD_LEN;
+}
+
+// one read, as __p2p_read_cmd did
+static INT_T __old_read(VOID)
+{
+    P2P_CMD_PARSE_T *p_head = (P2P_CMD_PARSE_T *)sg_old.read_buff;
+    INT_T want = sg_old.read_size;
+
+    __dev_recv(NULL, sg_old.read_buff + sg_old.cur_read, &sg_old.read_size, 0);
+    if (0 == sg_old.read_size) {
+        sg_old.read_size = want;
+        return 0;
+    }
+    sg_old.cur_read += sg_old.read_size;
+    if (0 == sg_old.flag) {
+        if (sg_old.cur_read < (INT_T)P2P_CMD_HEAD_LEN) {
+            sg_old.read_size = P2P_CMD_HEAD_LEN - sg_old.cur_read;
+            return 1;
+        }
+        sg_old.flag = 1;
+    }
+    if (sg_old.cur_read < (INT_T)(P2P_CMD_HEAD_LEN + p_head->str_header.length)) {
+        sg_old.read_size = P2P_CMD_HEAD_LEN + p_head->str_header.length - sg_old.cur_read;
+        return 1;
+    }
+    __old_parse(p_head);
+    memset(sg_old.read_buff, 0x00, sizeof(sg_old.read_buff));
+    sg_old.read_size = P2P_CMD_HEAD_LEN;
+    sg_old.cur_read = 0;
+    sg_old.flag = 0;
+    return 1;
+}
+
+/* the app side */
+static INT_T __app_cmd(CHAR_T *buff, INT_T req_id, USHORT_T high_cmd, CONST VOID *payload, INT_T len)
+{
+    P2P_CMD_PARSE_T head;
+
+    memset(&head, 0, sizeof(head));
+    head.mark = P2P_CMD_MARK;
+    head.reqId = req_id;
+    head.str_header.high_cmd = high_cmd;
+    head.str_header.length = len;
+    memcpy(buff, &head, P2P_CMD_HEAD_LEN);
+    memcpy(buff + P2P_CMD_HEAD_LEN, payload, len);
+    return P2P_CMD_HEAD_LEN + len;
+}
+
+static INT_T __app_playback_burst(UINT_T burst, INT_T req_id)
+{
+    C2C_TRANS_CTRL_VIDEO_REQ_T req;
+    CHAR_T cmd[64];
+    INT_T len;
+    UINT_T i;
+
+    for (i = 0; i < burst; i++) {
+        req.channel = 0;
+        req.operation = (i & 1) ? TY_CMD_IO_CTRL_VIDEO_RESUME : TY_CMD_IO_CTRL_VIDEO_PAUSE;
+        len = __app_cmd(cmd, req_id + i, TY_C2C_CMD_IO_CTRL_PLAYBACK, &req, sizeof(req));
+        __pipe_write(&sg_to_dev, cmd, len);
+    }
+    return req_id + burst;
+}
+
+/**
+ * @brief read the responses the app has
+ *
+ * @return responses in order from req_id, -1 when one is out of order or not a success
+ */
+static INT_T __app_playback_resp(INT_T req_id)
+{
+    C2C_CMD_IO_CTRL_COM_RESP_T *p_resp = NULL;
+    P2P_CMD_PARSE_T *p_head = NULL;
+    INT_T len = 0, off = 0, num = 0, ret;
+
+    while ((ret = __pipe_read(&sg_to_app, sg_app_buff + len, sizeof(sg_app_buff) - len)) > 0) {
+        len += ret;
+    }
+    while (off + (INT_T)P2P_CMD_HEAD_LEN <= len) {
+        p_head = (P2P_CMD_PARSE_T *)(sg_app_buff + off);
+        p_resp = (C2C_CMD_IO_CTRL_COM_RESP_T *)(p_head + 1);
+        if (p_head->reqId != req_id + num || 1 != p_head->str_header.type ||
+            TY_C2C_CMD_IO_CTRL_COMMAND_SUCCESS != p_resp->result) {
+            return -1;
+        }
+        off += P2P_CMD_HEAD_LEN + p_head->str_header.length;
+        num++;
+    }
+    return num;
+}
+
+static VOID __dev_serve(BOOL_T old)
+{
+    if (old) {
+        while (__old_read()) {
+        }
+    } else {
+        // a read stops after P2P_CMD_CHAN_READ_MAX messages, as the session thread the next one goes on
+        while (p2p_cmd_chan_read(&sg_chan, 0) > 0) {
+        }
+    }
+}
+
+static VOID __bench_burst(UINT_T burst)
+{
+    SYS_TIME_T start_ms, elapsed_ms;
+    BENCH_COUNT_T count[2];
+    UINT_T rtt_ns[2], cmd_ns[2], bursts, errors = 0;
+    INT_T req_id, num;
+    UINT_T old;
+
+    for (old = 0; old < 2; old++) {
+        __pipe_reset(&sg_to_dev);
+        __pipe_reset(&sg_to_app);
+        __old_reset();
+        p2p_cmd_chan_reset(&sg_chan);
+        memset(&sg_count, 0, sizeof(sg_count));
+        req_id = 0;
+        bursts = 0;
+        start_ms = tal_system_get_millisecond();
+        do {
+            __app_playback_burst(burst, req_id);
+            __dev_serve(old);
+            num = __app_playback_resp(req_id);
+            if (num != (INT_T)burst) {
+                errors++;
+            }
+            req_id += burst;
+            bursts++;
+            elapsed_ms = tal_system_get_millisecond() - start_ms;
+        } while (elapsed_ms < BENCH_TIME_MS);
+        rtt_ns[old] = (UINT_T)(elapsed_ms * 1000000 / bursts);
+        cmd_ns[old] = rtt_ns[old] / burst;
+        count[old].reads = sg_count.reads / bursts;
+        count[old].sends = sg_count.sends / bursts;
+    }
+
+    PR_NOTICE("  burst of %2d: per command %6d ns round trip (%4d ns/cmd, %3d reads, %3d sends) | "
+              "channel %6d ns round trip (%4d ns/cmd, %3d reads, %3d sends)",
+              burst, rtt_ns[1], cmd_ns[1], count[1].reads, count[1].sends, rtt_ns[0], cmd_ns[0], count[0].reads,
+              count[0].sends);
+    if (errors) {
+        PR_ERR("  %d bursts not answered in order", errors);
+    }
+}
+
+static INT_T __fuzz_resp(CHAR_T *resp, INT_T resp_size)
+{
+    INT_T len = 0, ret;
+
+    while ((ret = __pipe_read(&sg_to_app, resp + len, resp_size - len)) > 0) {
+        len += ret;
+    }
+    return len;
+}
+
+/**
+ * @brief the channel reads a stream of commands cut at random places, the per command reader the same commands
+ *        sent one by one, as the app sends them, their responses have to be the same
+ */
+static VOID __bench_fuzz(VOID)
+{
+    static CHAR_T stream[BENCH_PIPE_SIZE / 2];
+    static CHAR_T resp[BENCH_PIPE_SIZE];
+    C2C_TRANS_CTRL_VIDEO_REQ_T req;
+    CHAR_T text[BENCH_TEXT_MAX];
+    INT_T cmd_len[32];
+    UINT_T i, j, burst, errors = 0, cmds = 0;
+    INT_T len, off, cut, resp_len, text_len;
+
+    for (i = 0; i < BENCH_FUZZ_NUM; i++) {
+        len = 0;
+        burst = 1 + __rand() % 32;
+        for (j = 0; j < burst; j++) {
+            switch (__rand() % 4) {
+            case 0:
+                text_len = __rand() % BENCH_TEXT_MAX;
+                memset(text, 'a' + j % 26, text_len);
+                cmd_len[j] = __app_cmd(stream + len, j, TY_C2C_CMD_QUERY_TEXT, text, text_len);
+                break;
+            case 1:
+                cmd_len[j] = __app_cmd(stream + len, j, TY_C2C_CMD_PROTOCOL_VERSION, &req, 0);
+                break;
+            default:
+                req.channel = j;
+                req.operation = __rand() % 3;
+                cmd_len[j] = __app_cmd(stream + len, j, TY_C2C_CMD_IO_CTRL_PLAYBACK, &req, sizeof(req));
+                break;
+            }
+            len += cmd_len[j];
+        }
+        cmds += burst;
+
+        __pipe_reset(&sg_to_dev);
+        __pipe_reset(&sg_to_app);
+        __old_reset();
+        for (j = 0, off = 0; j < burst; off += cmd_len[j], j++) {
+            __pipe_write(&sg_to_dev, stream + off, cmd_len[j]);
+        }
+        __dev_serve(TRUE);
+        sg_resp_expect_len = __fuzz_resp(sg_resp_expect, sizeof(sg_resp_expect));
+
+        __pipe_reset(&sg_to_dev);
+        __pipe_reset(&sg_to_app);
+        p2p_cmd_chan_reset(&sg_chan);
+        for (off = 0; off < len; off += cut) {
+            cut = 1 + __rand() % 300;
+            if (cut > len - off) {
+                cut = len - off;
+            }
+            __pipe_write(&sg_to_dev, stream + off, cut);
+            if (0 == __rand() % 3) {
+                __dev_serve(FALSE);
+            }
+        }
+        __dev_serve(FALSE);
+        resp_len = __fuzz_resp(resp, sizeof(resp));
+
+        if (resp_len != sg_resp_expect_len || 0 != memcmp(resp, sg_resp_expect, resp_len)) {
+            errors++;
+        }
+    }
+
+    PR_NOTICE("  %d bursts of %d commands cut at random: %d with responses differing from the per command reader",
+              BENCH_FUZZ_NUM, cmds, errors);
+    if (errors) {
+        PR_ERR("command channel check failed");
+    }
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return void
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+    UINT_T burst;
+
+    PR_NOTICE("------ p2p command channel benchmark start ------");
+
+    tal_mutex_create_init(&sg_to_dev.mutex);
+    tal_mutex_create_init(&sg_to_app.mutex);
+    p2p_cmd_chan_init(&sg_chan, &sg_chan_cfg, NULL);
+
+    for (burst = 1; burst <= BENCH_BURST_MAX; burst *= 4) {
+        __bench_burst(burst);
+    }
+    __bench_fuzz();
+
+    tal_mutex_release(sg_to_dev.mutex);
+    tal_mutex_release(sg_to_app.mutex);
+
+    PR_NOTICE("------ p2p command channel benchmark end ------");
+#else
+    PR_ERR("tuya p2p is not enabled. Please enable CONFIG_ENABLE_TUYA_P2P in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
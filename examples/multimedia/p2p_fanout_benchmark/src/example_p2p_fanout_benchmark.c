@@ -0,0 +1,560 @@
+/**
+ * @file example_p2p_fanout_benchmark.c
+ * @brief Measures how the P2P live stream scales with the number of viewers.
+ *
+ * N viewers are simulated on a local loopback: the "send" of a packet copies
+ * it, private header included, into the receive buffer of the viewer, which
+ * checks that the RTP sequence numbers of each stream follow each other. The
+ * stream is synthesized: H.264 GOPs of BENCH_GOP frames, an IDR of
+ * BENCH_IDR_SIZE bytes then predicted frames of about BENCH_P_SIZE bytes, each
+ * video frame followed by a 20 ms G.711 frame.
+ *
+ * Two ways of serving the viewers are compared for N = 1, 2, 4, 8:
+ * - "per viewer": every viewer has its own packers and RTP buffers and packs
+ *   every frame itself, as each session did before the frame ring;
+ * - "shared ring": every frame is packed once into the frame ring of
+ *   tuya_ipc_p2p_frame_ring.h, each viewer walks the packets with its reader,
+ *   writes its own sequence number and private header and sends them.
+ *
+ * For each it reports the time spent per frame (all viewers served), the
+ * share of one core at 30 fps and the heap taken. Two more cases check the
+ * ring: a viewer draining slower than the stream is overwritten and starts
+ * over at a key frame, and a viewer joining in the middle of a GOP receives
+ * the stream from its key frame.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+#include <string.h>
+
+#include "rtp-payload.h"
+#include "tuya_ipc_p2p_frame_ring.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_GOP        30
+#define BENCH_FRAMES     (BENCH_GOP * 4)
+#define BENCH_IDR_SIZE   (60 * 1024)
+#define BENCH_P_SIZE     (8 * 1024)
+#define BENCH_AUDIO_SIZE 320 // 20 ms of 8 kHz G.711
+#define BENCH_ROUNDS     5    // times the stream is served to the slow viewer
+#define BENCH_TIME_MS    1000 // run each fan-out case for about this long
+#define BENCH_VIEWER_MAX 8
+#define BENCH_FPS        30
+
+#define BENCH_HEAD_LEN   36 // largest private header, as P2P_EXT_HEAD_MAX_LEN
+#define BENCH_PACK_LEN   (1100 + 128)
+#define BENCH_RING_SIZE  (512 * 1024)
+#define BENCH_RING_NUM   128
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    uint8_t key;
+} BENCH_FRAME_T;
+
+typedef struct {
+    /* the per viewer scheme */
+    void *packer[2];
+    uint8_t *rtp_buff[2];
+    /* the shared ring scheme */
+    P2P_RING_READER_T reader;
+    uint16_t seq[2];
+    /* loopback receiver */
+    uint8_t recv[BENCH_PACK_LEN];
+    uint16_t recv_seq[2];
+    uint8_t recv_started[2];
+    uint32_t packets;
+    uint32_t seq_errors;
+    uint32_t first_key;     // the first video frame received was a key frame
+    uint32_t video_recv;    // video frames received
+    uint32_t dropped_seen;  // reader.dropped when the viewer last started over
+    uint32_t resync_errors; // started over at a frame other than a key frame
+} BENCH_VIEWER_T;
+
+typedef struct {
+    BENCH_VIEWER_T *viewer;
+    uint32_t media;
+} BENCH_PACK_ARG_T;
+#endif
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static BENCH_FRAME_T sg_video[BENCH_FRAMES];
+static BENCH_FRAME_T sg_audio;
+static BENCH_VIEWER_T sg_viewer[BENCH_VIEWER_MAX];
+static BENCH_PACK_ARG_T sg_pack_arg[BENCH_VIEWER_MAX][2];
+static uint32_t sg_seed = 1;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static uint32_t __rand(void)
+{
+    sg_seed = sg_seed * 1103515245 + 12345;
+    return sg_seed >> 16;
+}
+
+static uint32_t __nal_add(uint8_t *p, uint8_t type, uint32_t size)
+{
+    uint32_t i;
+
+    p[0] = 0x00;
+    p[1] = 0x00;
+    p[2] = 0x00;
+    p[3] = 0x01;
+    p[4] = 0x60 | type;
+    for (i = 5; i < size + 4; i++) {
+        // never zero, so the payload holds no start code
+        p[i] = (uint8_t)__rand() | 0x01;
+    }
+    return size + 4;
+}
+
+static int __stream_synthesize(void)
+{
+    uint32_t i, size;
+
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        sg_video[i].key = (0 == i % BENCH_GOP);
+        size = sg_video[i].key ? BENCH_IDR_SIZE + 64 : BENCH_P_SIZE * 2;
+        sg_video[i].data = tal_malloc(size);
+        if (NULL == sg_video[i].data) {
+            return -1;
+        }
+        if (sg_video[i].key) {
+            sg_video[i].len = __nal_add(sg_video[i].data, 7, 20); // SPS
+            sg_video[i].len += __nal_add(sg_video[i].data + sg_video[i].len, 8, 4);
+            sg_video[i].len += __nal_add(sg_video[i].data + sg_video[i].len, 5, BENCH_IDR_SIZE);
+        } else {
+            sg_video[i].len = __nal_add(sg_video[i].data, 1, BENCH_P_SIZE / 2 + __rand() % BENCH_P_SIZE);
+        }
+    }
+
+    sg_audio.key = 1;
+    sg_audio.len = BENCH_AUDIO_SIZE;
+    sg_audio.data = tal_malloc(BENCH_AUDIO_SIZE);
+    if (NULL == sg_audio.data) {
+        return -1;
+    }
+    for (i = 0; i < BENCH_AUDIO_SIZE; i++) {
+        sg_audio.data[i] = (uint8_t)__rand();
+    }
+    return 0;
+}
+
+static void __stream_free(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        tal_free(sg_video[i].data);
+        sg_video[i].data = NULL;
+    }
+    tal_free(sg_audio.data);
+    sg_audio.data = NULL;
+}
+
+/**
+ * @brief the loopback send: the viewer receives the packet behind its private header
+ */
+static void __viewer_recv(BENCH_VIEWER_T *viewer, uint32_t media, const uint8_t *buf, int len)
+{
+    uint32_t idx = (P2P_RING_MEDIA_VIDEO == media) ? 0 : 1;
+    const uint8_t *rtp = NULL;
+    uint16_t seq;
+
+    memcpy(viewer->recv, buf, len);
+    rtp = viewer->recv + BENCH_HEAD_LEN;
+    seq = (uint16_t)(rtp[2] << 8 | rtp[3]);
+    if (viewer->recv_started[idx] && seq != (uint16_t)(viewer->recv_seq[idx] + 1)) {
+        viewer->seq_errors++;
+    }
+    viewer->recv_seq[idx] = seq;
+    viewer->recv_started[idx] = 1;
+    viewer->packets++;
+}
+
+static void __viewer_reset(uint32_t num)
+{
+    memset(sg_viewer, 0, sizeof(BENCH_VIEWER_T) * num);
+}
+
+static void __viewer_report(const char *name, uint32_t num)
+{
+    uint32_t i, errors = 0;
+
+    for (i = 0; i < num; i++) {
+        errors += sg_viewer[i].seq_errors;
+    }
+    if (errors) {
+        PR_ERR("  %s: %d RTP sequence gaps seen by the viewers", name, errors);
+    }
+}
+
+/* the per viewer scheme: each viewer packs into its own RTP buffer */
+static void *__viewer_alloc(void *param, int bytes)
+{
+    BENCH_PACK_ARG_T *arg = (BENCH_PACK_ARG_T *)param;
+
+    if (bytes > BENCH_PACK_LEN - BENCH_HEAD_LEN) {
+        return NULL;
+    }
+    return arg->viewer->rtp_buff[arg->media - 1] + BENCH_HEAD_LEN;
+}
+
+static void __viewer_free(void *param, void *packet)
+{
+    return;
+}
+
+static int __viewer_packet(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
+{
+    BENCH_PACK_ARG_T *arg = (BENCH_PACK_ARG_T *)param;
+    uint8_t *head = (uint8_t *)packet - BENCH_HEAD_LEN;
+
+    memset(head, 0, BENCH_HEAD_LEN);
+    *(int *)&head[BENCH_HEAD_LEN - 4] = bytes;
+    __viewer_recv(arg->viewer, arg->media, head, bytes + BENCH_HEAD_LEN);
+    return 0;
+}
+
+static int __per_viewer_open(uint32_t num)
+{
+    struct rtp_payload_t handler = {__viewer_alloc, __viewer_free, __viewer_packet};
+    BENCH_VIEWER_T *viewer = NULL;
+    uint32_t i, m;
+
+    for (i = 0; i < num; i++) {
+        viewer = &sg_viewer[i];
+        for (m = 0; m < 2; m++) {
+            sg_pack_arg[i][m].viewer = viewer;
+            sg_pack_arg[i][m].media = m + 1;
+            viewer->rtp_buff[m] = tal_malloc(BENCH_PACK_LEN);
+            if (NULL == viewer->rtp_buff[m]) {
+                return -1;
+            }
+        }
+        viewer->packer[0] = rtp_payload_encode_create(96, "H264", 0, 10, &handler, &sg_pack_arg[i][0]);
+        viewer->packer[1] = rtp_payload_encode_create(8, "PCMA", 0, 11, &handler, &sg_pack_arg[i][1]);
+        if (NULL == viewer->packer[0] || NULL == viewer->packer[1]) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void __per_viewer_close(uint32_t num)
+{
+    uint32_t i, m;
+
+    for (i = 0; i < num; i++) {
+        for (m = 0; m < 2; m++) {
+            if (sg_viewer[i].packer[m]) {
+                rtp_payload_encode_destroy(sg_viewer[i].packer[m]);
+            }
+            tal_free(sg_viewer[i].rtp_buff[m]);
+        }
+    }
+}
+
+static void __per_viewer_serve(uint32_t num, uint32_t frame)
+{
+    uint32_t i, ts = frame * 3000;
+
+    for (i = 0; i < num; i++) {
+        rtp_payload_encode_input(sg_viewer[i].packer[0], sg_video[frame].data, sg_video[frame].len, ts);
+        rtp_payload_encode_input(sg_viewer[i].packer[1], sg_audio.data, sg_audio.len, frame * 160);
+    }
+}
+
+/* the shared ring scheme */
+static OPERATE_RET __ring_put(P2P_RING_HANDLE_T ring, uint32_t frame)
+{
+    MEDIA_FRAME media;
+    OPERATE_RET rt = OPRT_OK;
+
+    memset(&media, 0, sizeof(media));
+    media.type = sg_video[frame].key ? eVideoIFrame : eVideoPBFrame;
+    media.data = sg_video[frame].data;
+    media.size = sg_video[frame].len;
+    rt = p2p_ring_put(ring, P2P_RING_MEDIA_VIDEO, 96, "H264", &media, frame * 3000);
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+
+    media.type = eAudioFrame;
+    media.data = sg_audio.data;
+    media.size = sg_audio.len;
+    return p2p_ring_put(ring, P2P_RING_MEDIA_AUDIO, 8, "PCMA", &media, frame * 160);
+}
+
+/**
+ * @brief send a viewer at most max_frames of its pending frames, as __p2p_send_readers does
+ */
+static void __ring_drain(P2P_RING_HANDLE_T ring, BENCH_VIEWER_T *viewer, uint32_t max_frames)
+{
+    P2P_RING_FRAME_T *p_frame = NULL;
+    uint32_t idx, offset;
+    uint8_t *packet = NULL;
+    int len;
+
+    while (max_frames-- && NULL != (p_frame = p2p_ring_peek(ring, &viewer->reader))) {
+        idx = (P2P_RING_MEDIA_VIDEO == p_frame->media) ? 0 : 1;
+        if (viewer->reader.dropped != viewer->dropped_seen) {
+            // overwritten, the viewer starts over
+            viewer->dropped_seen = viewer->reader.dropped;
+            if (0 != idx || FALSE == p_frame->key_frame) {
+                viewer->resync_errors++;
+            }
+        }
+        if (0 == idx) {
+            if (0 == viewer->video_recv) {
+                viewer->first_key = p_frame->key_frame;
+            }
+            viewer->video_recv++;
+        }
+        offset = 0;
+        while (NULL != (packet = (uint8_t *)p2p_ring_packet(ring, p_frame, &offset, &len))) {
+            packet[2] = (uint8_t)(viewer->seq[idx] >> 8);
+            packet[3] = (uint8_t)(viewer->seq[idx] & 0xFF);
+            viewer->seq[idx]++;
+            memset(packet - BENCH_HEAD_LEN, 0, BENCH_HEAD_LEN);
+            *(int *)&packet[-4] = len;
+            __viewer_recv(viewer, p_frame->media, packet - BENCH_HEAD_LEN, len + BENCH_HEAD_LEN);
+        }
+        p2p_ring_pass(ring, &viewer->reader);
+    }
+}
+
+static void __bench_fanout(uint32_t num)
+{
+    P2P_RING_HANDLE_T ring = NULL;
+    SYS_TIME_T start_ms, elapsed_ms;
+    uint32_t i, v, frames, per_viewer_ns, ring_ns;
+    int heap_before, per_viewer_heap, ring_heap;
+
+    /* per viewer */
+    __viewer_reset(num);
+    heap_before = tal_system_get_free_heap_size();
+    if (0 != __per_viewer_open(num)) {
+        PR_ERR("no memory for %d viewers", num);
+        __per_viewer_close(num);
+        return;
+    }
+    per_viewer_heap = heap_before - tal_system_get_free_heap_size();
+    frames = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        for (i = 0; i < BENCH_FRAMES; i++, frames++) {
+            __per_viewer_serve(num, i);
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    per_viewer_ns = (uint32_t)(elapsed_ms * 1000000 / frames);
+    __per_viewer_close(num);
+    __viewer_report("per viewer", num);
+
+    /* shared ring */
+    __viewer_reset(num);
+    heap_before = tal_system_get_free_heap_size();
+    if (OPRT_OK != p2p_ring_create(BENCH_RING_SIZE, BENCH_RING_NUM, BENCH_HEAD_LEN, num, &ring)) {
+        PR_ERR("no memory for the ring");
+        return;
+    }
+    ring_heap = heap_before - tal_system_get_free_heap_size();
+    for (i = 0; i < num; i++) {
+        p2p_ring_reader_set(ring, &sg_viewer[i].reader, P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO);
+    }
+    frames = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        for (i = 0; i < BENCH_FRAMES; i++, frames++) {
+            __ring_put(ring, i);
+            for (v = 0; v < num; v++) {
+                __ring_drain(ring, &sg_viewer[v], BENCH_RING_NUM);
+            }
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    ring_ns = (uint32_t)(elapsed_ms * 1000000 / frames);
+    p2p_ring_destroy(ring);
+    __viewer_report("shared ring", num);
+
+    // a core at BENCH_FPS: ns per frame * BENCH_FPS / 1e9, shown in 1/100 %
+    PR_NOTICE("  %d viewers: per viewer %6d ns/frame (%d.%02d%% of a core), heap %7d | "
+              "shared ring %6d ns/frame (%d.%02d%% of a core), heap %7d",
+              num, per_viewer_ns, per_viewer_ns * BENCH_FPS / 10000000, per_viewer_ns * BENCH_FPS / 100000 % 100,
+              per_viewer_heap, ring_ns, ring_ns * BENCH_FPS / 10000000, ring_ns * BENCH_FPS / 100000 % 100,
+              ring_heap);
+}
+
+/**
+ * @brief one viewer keeps up, one sends a frame every other frame and falls behind
+ */
+static void __bench_slow_viewer(void)
+{
+    P2P_RING_HANDLE_T ring = NULL;
+    P2P_RING_STAT_T stat;
+    uint32_t i;
+
+    __viewer_reset(2);
+    if (OPRT_OK != p2p_ring_create(BENCH_RING_SIZE / 2, BENCH_RING_NUM, BENCH_HEAD_LEN, 2, &ring)) {
+        return;
+    }
+    p2p_ring_reader_set(ring, &sg_viewer[0].reader, P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO);
+    p2p_ring_reader_set(ring, &sg_viewer[1].reader, P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO);
+    for (i = 0; i < BENCH_FRAMES * BENCH_ROUNDS; i++) {
+        __ring_put(ring, i % BENCH_FRAMES);
+        __ring_drain(ring, &sg_viewer[0], BENCH_RING_NUM);
+        __ring_drain(ring, &sg_viewer[1], i % 2);
+    }
+    p2p_ring_get_stat(ring, &stat);
+    p2p_ring_destroy(ring);
+
+    PR_NOTICE("  slow viewer: %d frames sent, %d dropped, %d restarts not at a key frame; fast viewer: %d sent, "
+              "%d dropped; %d frames overwritten unsent, %d RTP sequence gaps",
+              sg_viewer[1].reader.sent, sg_viewer[1].reader.dropped, sg_viewer[1].resync_errors,
+              sg_viewer[0].reader.sent, sg_viewer[0].reader.dropped, stat.overwritten,
+              sg_viewer[0].seq_errors + sg_viewer[1].seq_errors);
+}
+
+/**
+ * @brief a viewer joins in the middle of a GOP, it gets the stream from the key frame of the GOP
+ */
+static void __bench_late_joiner(void)
+{
+    P2P_RING_HANDLE_T ring = NULL;
+    uint32_t i, join = BENCH_GOP + BENCH_GOP / 2;
+
+    __viewer_reset(2);
+    if (OPRT_OK != p2p_ring_create(BENCH_RING_SIZE, BENCH_RING_NUM, BENCH_HEAD_LEN, 2, &ring)) {
+        return;
+    }
+    p2p_ring_reader_set(ring, &sg_viewer[0].reader, P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO);
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        if (i == join) {
+            p2p_ring_reader_set(ring, &sg_viewer[1].reader, P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO);
+        }
+        __ring_put(ring, i);
+        __ring_drain(ring, &sg_viewer[0], BENCH_RING_NUM);
+        __ring_drain(ring, &sg_viewer[1], BENCH_RING_NUM);
+    }
+    p2p_ring_destroy(ring);
+
+    PR_NOTICE("  late joiner at frame %d: first video frame %s, %d video frames received of %d since the key frame",
+              join, sg_viewer[1].first_key ? "is a key frame" : "is NOT a key frame", sg_viewer[1].video_recv,
+              BENCH_FRAMES - join / BENCH_GOP * BENCH_GOP);
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+    uint32_t num;
+
+    PR_NOTICE("------ p2p fan-out benchmark start ------");
+
+    if (0 != __stream_synthesize()) {
+        PR_ERR("no memory for the stream");
+        __stream_free();
+        return;
+    }
+    PR_NOTICE("H.264 GOP %d, IDR %d bytes, P about %d bytes, %d bytes of G.711 per frame", BENCH_GOP,
+              BENCH_IDR_SIZE, BENCH_P_SIZE, BENCH_AUDIO_SIZE);
+
+    for (num = 1; num <= BENCH_VIEWER_MAX; num *= 2) {
+        __bench_fanout(num);
+    }
+    __bench_slow_viewer();
+    __bench_late_joiner();
+
+    __stream_free();
+
+    PR_NOTICE("------ p2p fan-out benchmark end ------");
+#else
+    PR_ERR("tuya p2p is not enabled. Please enable CONFIG_ENABLE_TUYA_P2P in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,453 @@
+/**
+ * @file example_p2p_sdp_benchmark.c
+ * @brief Measures the cost of the SDP work done for every P2P viewer.
+ *
+ * Each viewer that connects sends an offer which the device decodes,
+ * negotiates against its own codecs and answers. The benchmark times these
+ * steps on a few offers (a browser offer, an app offer, a minimal one and
+ * two with odd m lines: a space before the line end and no payload types):
+ * - decode: tuya_p2p_rtc_sdp_decode() of the offer text;
+ * - negotiate: with the negotiation cache emptied before every call (a new
+ *   kind of viewer) and with the result already cached (a viewer like the
+ *   ones before);
+ * - encode: with the codec parts of the answer rebuilt on every call and
+ *   reused from the previous call;
+ * - viewer: the whole of it on fresh sessions, as done for each viewer.
+ *
+ * A second part mutates the offers at random and checks that a negotiation
+ * served from the cache gives the same codecs as a negotiation from scratch,
+ * that the reused codec parts give the same answer text as rebuilt ones,
+ * that an answer never maps a payload type to an empty codec name and that
+ * the encoder never writes past the size it is given.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+#include <string.h>
+
+#include "tuya_sdp.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TIME_MS   500 // run each case for about this long
+#define BENCH_SDP_SIZE  (4 * 1024)
+#define BENCH_FUZZ_NUM  2000
+#define BENCH_FUZZ_EDIT 4 // edits made to an offer at most
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+typedef struct {
+    const char *name;
+    const char *text;
+} BENCH_OFFER_T;
+#endif
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static const BENCH_OFFER_T sg_offer[] = {
+    {"browser",
+     "v=0\r\no=- 4611731400430051336 2 IN IP4 127.0.0.1\r\ns=-\r\nt=0 0\r\na=group:BUNDLE 0 1 2\r\n"
+     "a=msid-semantic: WMS stream1\r\n"
+     "m=audio 9 UDP/TLS/RTP/SAVPF 111 0 8\r\nc=IN IP4 0.0.0.0\r\na=rtcp:9 IN IP4 0.0.0.0\r\n"
+     "a=ice-ufrag:abcd\r\na=ice-pwd:efghijklmnopqrstuvwxyz12\r\na=fingerprint:sha-256 AA:BB:CC:DD\r\n"
+     "a=setup:actpass\r\na=mid:0\r\na=sendrecv\r\na=msid:stream1 track-a\r\na=rtcp-mux\r\n"
+     "a=rtpmap:111 opus/48000/2\r\na=rtpmap:0 PCMU/8000\r\na=rtpmap:8 PCMA/8000\r\na=ssrc:1111 cname:peer\r\n"
+     "m=video 9 UDP/TLS/RTP/SAVPF 96 97 98 99\r\nc=IN IP4 0.0.0.0\r\na=mid:1\r\na=recvonly\r\n"
+     "a=msid:stream1 track-v\r\na=rtpmap:96 H264/90000\r\na=rtcp-fb:96 nack\r\n"
+     "a=fmtp:96 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n"
+     "a=rtpmap:97 rtx/90000\r\na=fmtp:97 apt=96\r\na=rtpmap:98 H265/90000\r\na=rtpmap:99 rtx/90000\r\n"
+     "a=fmtp:99 apt=98\r\na=ssrc-group:FID 2222 3333\r\na=ssrc:2222 cname:peer\r\na=ssrc:3333 cname:peer\r\n"
+     "m=application 9 tuya 6001\r\nc=IN IP4 0.0.0.0\r\na=aes-key:00112233445566778899aabbccddeeff\r\n"
+     "a=mid:2\r\na=rtpmap:6001 AES/KCP 3\r\n"
+     "a=candidate:1 1 udp 2122260223 192.168.1.2 50000 typ host\r\n"
+     "a=candidate:2 1 udp 1686052607 1.2.3.4 50001 typ srflx\r\n"},
+    {"app",
+     "v=0\no=- 1 1 IN IP4 127.0.0.1\ns=-\nt=0 0\na=group:BUNDLE audio video\na=msid-semantic: WMS s\n"
+     "m=audio 9 UDP/TLS/RTP/SAVPF 0\na=mid:audio\na=rtpmap:0 PCMU/8000/1\na=ssrc:5 cname:x\n"
+     "m=video 9 UDP/TLS/RTP/SAVPF 102 103\na=mid:video\na=rtpmap:102 H264/90000\na=rtpmap:103 rtx/90000\n"
+     "a=fmtp:103 apt=102\na=ssrc:6 cname:x\na=ssrc:7 cname:x\n"
+     "a=ice-ufrag:u\na=ice-pwd:p\na=fingerprint:sha-256 00\n"},
+    {"minimal", "v=0\r\ns=-\r\na=group:BUNDLE 0\r\nm=video 9 UDP/TLS/RTP/SAVPF 96\r\na=mid:0\r\n"
+                "a=rtpmap:96 H264/90000\r\n"},
+    {"trailing", "v=0\r\ns=-\r\na=group:BUNDLE 0\r\nm=video 9 UDP/TLS/RTP/SAVPF 96 \r\na=mid:0\r\n"
+                 "a=rtpmap:96 H264/90000\r\n"},
+    {"no-pt", "v=0\r\ns=-\r\na=group:BUNDLE 0\r\nm=video 9 UDP/TLS/RTP/SAVPF\r\na=mid:0\r\n"},
+};
+
+static const char *sg_edit_word[] = {" ",   "/",     ":",    "\r\n",  "\n",       "a=",   "m=",
+                                     "rtx", "apt=",  "0",    "96",    "a=ssrc:",  "FID",  "a=rtpmap:",
+                                     "\t",  "SAVPF", "tuya", "H264",  "a=fmtp:",  "-1",   "cname:"};
+
+static rtc_sdp_t sg_local;
+static rtc_sdp_t sg_remote;
+static rtc_sdp_t sg_check;
+static char sg_text[BENCH_SDP_SIZE];
+static char sg_answer[BENCH_SDP_SIZE];
+static char sg_expect[BENCH_SDP_SIZE];
+static uint32_t sg_seed = 1;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static uint32_t __rand(void)
+{
+    sg_seed = sg_seed * 1103515245 + 12345;
+    return sg_seed >> 8;
+}
+
+/* the device side, as the media service sets it up for a session */
+static void __local_open(rtc_sdp_t *sdp)
+{
+    tuya_p2p_rtc_sdp_init(sdp, "session", "device", "sha-256 11:22:33:44", "ufrag", "password", DTLS_ROLE_CLIENT);
+    tuya_p2p_rtc_sdp_add_audio_codec(sdp, NULL, 0, 1234, 0, 0);
+    tuya_p2p_rtc_sdp_add_video_codec(sdp, "H264", 96, 5678, 90000, "42e01f");
+    tuya_p2p_rtc_sdp_add_video_rtx_codec(sdp, 96, 97, 9999, 90000);
+    tuya_p2p_rtc_sdp_add_tuya_codec(sdp, "AES/KCP", 6001, 3);
+}
+
+static void __remote_open(rtc_sdp_t *sdp, const char *text)
+{
+    tuya_p2p_rtc_sdp_init(sdp, "", "", "", NULL, NULL, DTLS_ROLE_SERVER);
+    // decode cuts the text in place
+    strncpy(sg_text, text, sizeof(sg_text) - 1);
+    sg_text[sizeof(sg_text) - 1] = 0;
+    tuya_p2p_rtc_sdp_decode(sdp, sg_text);
+}
+
+/* an a=rtpmap line of the answer with no codec name, as "a=rtpmap:0 /0" */
+static int __answer_empty_codec(const char *text)
+{
+    const char *p = text;
+
+    while (NULL != (p = strstr(p, "a=rtpmap:"))) {
+        p += strlen("a=rtpmap:");
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (p[0] == ' ' && p[1] == '/') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* the answer without its o= line, which holds the time */
+static const char *__answer_body(const char *text)
+{
+    const char *p = strstr(text, "\ns=");
+
+    return p ? p : text;
+}
+
+/**
+ * @brief time the steps of one offer, in ns per call
+ */
+static void __bench_offer(const BENCH_OFFER_T *offer)
+{
+    SYS_TIME_T start_ms, elapsed_ms;
+    uint32_t n, decode_ns, cold_ns, warm_ns, rebuild_ns, reuse_ns, viewer_cold_ns, viewer_warm_ns;
+    int len;
+
+    /* decode */
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        __remote_open(&sg_remote, offer->text);
+        tuya_p2p_rtc_sdp_deinit(&sg_remote);
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    decode_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    /* negotiate, the offer adds its media to the local sdp once, answering does not add more */
+    __local_open(&sg_local);
+    __remote_open(&sg_remote, offer->text);
+    tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "offer");
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        tuya_p2p_rtc_sdp_nego_cache_clear();
+        tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "answer");
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    cold_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "answer");
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    warm_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    /* encode */
+    len = 0;
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        sg_local.tmpl.gen = 0;
+        len = tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, sizeof(sg_answer));
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    rebuild_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, sizeof(sg_answer));
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    reuse_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+    if (len > 0 && __answer_empty_codec(sg_answer)) {
+        PR_ERR("  %s: the answer maps a payload type to no codec", offer->name);
+    }
+    tuya_p2p_rtc_sdp_deinit(&sg_local);
+    tuya_p2p_rtc_sdp_deinit(&sg_remote);
+
+    /* a viewer: fresh sessions, decode, negotiate, encode */
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        tuya_p2p_rtc_sdp_nego_cache_clear();
+        __local_open(&sg_local);
+        __remote_open(&sg_remote, offer->text);
+        tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "offer");
+        tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, sizeof(sg_answer));
+        tuya_p2p_rtc_sdp_deinit(&sg_local);
+        tuya_p2p_rtc_sdp_deinit(&sg_remote);
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    viewer_cold_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    n = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        __local_open(&sg_local);
+        __remote_open(&sg_remote, offer->text);
+        tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "offer");
+        tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, sizeof(sg_answer));
+        tuya_p2p_rtc_sdp_deinit(&sg_local);
+        tuya_p2p_rtc_sdp_deinit(&sg_remote);
+        n++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    viewer_warm_ns = (uint32_t)(elapsed_ms * 1000000 / n);
+
+    PR_NOTICE("  %-8s (%4d bytes, answer %4d): decode %6d ns | negotiate %6d ns, cached %6d ns | "
+              "encode %6d ns, parts reused %6d ns | viewer %6d ns, cached %6d ns",
+              offer->name, (int)strlen(offer->text), len, decode_ns, cold_ns, warm_ns, rebuild_ns, reuse_ns,
+              viewer_cold_ns, viewer_warm_ns);
+}
+
+static void __offer_mutate(char *text, int size)
+{
+    int len = strlen(text);
+    uint32_t i, edits = 1 + __rand() % BENCH_FUZZ_EDIT;
+
+    for (i = 0; i < edits; i++) {
+        int pos = len ? __rand() % (len + 1) : 0;
+        int op = __rand() % 4;
+
+        if (op == 0 && pos < len) {
+            int cnt = 1 + __rand() % 8;
+            if (pos + cnt > len) {
+                cnt = len - pos;
+            }
+            memmove(text + pos, text + pos + cnt, len - pos - cnt + 1);
+            len -= cnt;
+        } else if (op == 1) {
+            const char *word = sg_edit_word[__rand() % (sizeof(sg_edit_word) / sizeof(sg_edit_word[0]))];
+            int wl = strlen(word);
+            if (len + wl >= size) {
+                continue;
+            }
+            memmove(text + pos + wl, text + pos, len - pos + 1);
+            memcpy(text + pos, word, wl);
+            len += wl;
+        } else if (op == 2 && pos < len) {
+            text[pos] = "0123456789 /:=amrtx\r\n"[__rand() % 21];
+        } else {
+            text[pos] = 0;
+            len = pos;
+        }
+    }
+}
+
+static int __nego_same(rtc_sdp_t *a, rtc_sdp_t *b)
+{
+    return 0 == memcmp(&a->audio.negotiated_codec.name, &b->audio.negotiated_codec.name,
+                       sizeof(rtc_audio_codec_t) - sizeof(QUEUE)) &&
+           0 == memcmp(&a->video.negotiated_codec.name, &b->video.negotiated_codec.name,
+                       sizeof(rtc_video_codec_t) - sizeof(QUEUE)) &&
+           0 == memcmp(&a->video.rtx_codec.name, &b->video.rtx_codec.name, sizeof(rtc_video_codec_t) - sizeof(QUEUE)) &&
+           a->video.rtx_mode == b->video.rtx_mode &&
+           0 == memcmp(&a->tuya.negotiated_codec.name, &b->tuya.negotiated_codec.name,
+                       sizeof(rtc_tuya_codec_t) - sizeof(QUEUE));
+}
+
+/**
+ * @brief negotiate mutated offers from scratch and from the cache, encode the answers into buffers of random sizes
+ */
+static void __bench_fuzz(void)
+{
+    static char offer[BENCH_SDP_SIZE];
+    uint32_t i, nego_errors = 0, text_errors = 0, codec_errors = 0, size_errors = 0, hit, miss, hit_end, miss_end;
+    int len, size, ret;
+
+    tuya_p2p_rtc_sdp_nego_cache_stat(&hit, &miss);
+    for (i = 0; i < BENCH_FUZZ_NUM; i++) {
+        strcpy(offer, sg_offer[__rand() % (sizeof(sg_offer) / sizeof(sg_offer[0]))].text);
+        __offer_mutate(offer, sizeof(offer) / 2);
+
+        /* from scratch */
+        tuya_p2p_rtc_sdp_nego_cache_clear();
+        __local_open(&sg_check);
+        __remote_open(&sg_remote, offer);
+        tuya_p2p_rtc_sdp_negotiate(&sg_check, &sg_remote, "offer");
+        tuya_p2p_rtc_sdp_deinit(&sg_remote);
+
+        /* from the cache filled just before */
+        __local_open(&sg_local);
+        __remote_open(&sg_remote, offer);
+        tuya_p2p_rtc_sdp_negotiate(&sg_local, &sg_remote, "offer");
+        tuya_p2p_rtc_sdp_deinit(&sg_remote);
+        if (!__nego_same(&sg_local, &sg_check)) {
+            nego_errors++;
+        }
+
+        /* answer with the parts reused and rebuilt */
+        len = tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, sizeof(sg_answer));
+        sg_local.tmpl.gen = 0;
+        ret = tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_expect, sizeof(sg_expect));
+        if (len != ret || (len > 0 && 0 != strcmp(__answer_body(sg_answer), __answer_body(sg_expect)))) {
+            text_errors++;
+        }
+        if (len > 0 && __answer_empty_codec(sg_answer)) {
+            codec_errors++;
+        }
+
+        /* too small buffers, the byte after the size is never written */
+        if (len > 0) {
+            size = __rand() % (len + 2);
+            memset(sg_answer, 'Z', sizeof(sg_answer));
+            ret = tuya_p2p_rtc_sdp_encode(&sg_local, "answer", sg_answer, size);
+            if ((ret >= 0 && (ret >= size || sg_answer[ret] != '\0')) || sg_answer[size] != 'Z') {
+                size_errors++;
+            }
+        }
+        tuya_p2p_rtc_sdp_deinit(&sg_local);
+        tuya_p2p_rtc_sdp_deinit(&sg_check);
+    }
+
+    tuya_p2p_rtc_sdp_nego_cache_stat(&hit_end, &miss_end);
+    PR_NOTICE("  %d mutated offers: %d negotiation mismatches, %d answer mismatches, %d empty codecs, "
+              "%d size errors (cache %d hits, %d misses)",
+              BENCH_FUZZ_NUM, nego_errors, text_errors, codec_errors, size_errors, hit_end - hit, miss_end - miss);
+    if (nego_errors || text_errors || codec_errors || size_errors) {
+        PR_ERR("sdp check failed");
+    }
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return void
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+    uint32_t i;
+
+    PR_NOTICE("------ p2p sdp benchmark start ------");
+
+    for (i = 0; i < sizeof(sg_offer) / sizeof(sg_offer[0]); i++) {
+        __bench_offer(&sg_offer[i]);
+    }
+    __bench_fuzz();
+
+    PR_NOTICE("------ p2p sdp benchmark end ------");
+#else
+    PR_ERR("tuya p2p is not enabled. Please enable CONFIG_ENABLE_TUYA_P2P in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
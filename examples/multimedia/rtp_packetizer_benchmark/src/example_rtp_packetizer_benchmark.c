@@ -0,0 +1,464 @@
+/**
+ * @file example_rtp_packetizer_benchmark.c
+ * @brief Measures how the P2P video path packs frames into RTP packets.
+ *
+ * The example packs H.264 and H.265 elementary streams with lib_rtp the way
+ * tuya_ipc_p2p.c sends them, once per packing scheme:
+ * - "per frame": a packer created and destroyed for every frame, every packet
+ *   malloc'ed, then copied behind the private header into the send buffer;
+ * - "persistent": one packer per stream kept across frames, every packet
+ *   built in the send buffer right behind the room of the private header.
+ *
+ * The streams are read from BENCH_H264_FILE and BENCH_H265_FILE (Annex B, one
+ * slice per picture) when they exist, otherwise synthesized: a GOP of
+ * BENCH_GOP frames, an IDR of BENCH_IDR_SIZE bytes with its parameter sets
+ * followed by predicted frames of about BENCH_P_SIZE bytes.
+ *
+ * For each stream and scheme it reports frames per second, packets and heap
+ * allocations per frame (rtp_payload_encode_create counted as its two), and
+ * checks that rtp_payload_encode_packets() predicts every packet. It then
+ * compares the send buffer the former estimate reserved per frame, 1600 bytes
+ * per RTP_MTU_LEN of frame, with what the packets actually take.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+#include <stdio.h>
+
+#include "rtp-payload.h"
+#include "tuya_media_service_rtc.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_H264_FILE   "/tmp/bench.h264"
+#define BENCH_H265_FILE   "/tmp/bench.h265"
+#define BENCH_STREAM_MAX  (8 * 1024 * 1024)
+#define BENCH_FRAME_MAX   1024
+#define BENCH_GOP         30
+#define BENCH_FRAMES      90
+#define BENCH_IDR_SIZE    (60 * 1024)
+#define BENCH_P_SIZE      (8 * 1024)
+#define BENCH_TIME_MS     1000 // run each case for about this long
+
+#define BENCH_RTP_MTU_LEN 1100 // as tuya_ipc_p2p.c
+#define BENCH_HEAD_LEN    36   // largest private header, fixed header and extension
+#define BENCH_PACK_LEN    (1100 + 128)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    char     *name;
+    int       payload;
+    uint8_t   is_h265;
+    char     *file;
+    uint8_t  *data;
+    uint32_t  len;
+    uint32_t  frame_num;
+    uint32_t  frame_off[BENCH_FRAME_MAX + 1];
+} BENCH_STREAM_T;
+
+typedef struct {
+    uint8_t  *buff; // send buffer of the stream
+    uint32_t  allocs;
+    uint32_t  packets;
+    uint32_t  sum;
+} BENCH_SINK_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static BENCH_STREAM_T sg_stream[] = {
+    {"h264", 96, 0, BENCH_H264_FILE},
+    {"h265", 96, 1, BENCH_H265_FILE}, // lib_rtp finds H.265 by name for dynamic payload types only
+};
+
+static uint8_t sg_head[BENCH_HEAD_LEN];
+static uint32_t sg_seed = 1;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+static void __nal_add(BENCH_STREAM_T *stream, uint8_t type, uint32_t size)
+{
+    uint8_t *p = stream->data + stream->len;
+    uint32_t i;
+
+    p[0] = 0x00;
+    p[1] = 0x00;
+    p[2] = 0x00;
+    p[3] = 0x01;
+    if (stream->is_h265) {
+        p[4] = type << 1;
+        p[5] = 0x01;
+        i = 6;
+    } else {
+        p[4] = 0x60 | type;
+        i = 5;
+    }
+    for (; i < size + 4; i++) {
+        // never zero, so the payload holds no start code
+        sg_seed = sg_seed * 1103515245 + 12345;
+        p[i] = (uint8_t)(sg_seed >> 16) | 0x01;
+    }
+    stream->len += size + 4;
+}
+
+static void __stream_synthesize(BENCH_STREAM_T *stream)
+{
+    uint32_t i;
+
+    stream->len = 0;
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        stream->frame_off[i] = stream->len;
+        if (0 == i % BENCH_GOP) {
+            if (stream->is_h265) {
+                __nal_add(stream, 32, 24); // VPS
+                __nal_add(stream, 33, 42); // SPS
+                __nal_add(stream, 34, 8);  // PPS
+                __nal_add(stream, 19, BENCH_IDR_SIZE);
+            } else {
+                __nal_add(stream, 7, 20); // SPS
+                __nal_add(stream, 8, 4);  // PPS
+                __nal_add(stream, 5, BENCH_IDR_SIZE);
+            }
+        } else {
+            sg_seed = sg_seed * 1103515245 + 12345;
+            __nal_add(stream, 1, BENCH_P_SIZE / 2 + (sg_seed >> 16) % BENCH_P_SIZE);
+        }
+    }
+    stream->frame_num = BENCH_FRAMES;
+    stream->frame_off[i] = stream->len;
+}
+
+/**
+ * @brief split an Annex B stream into pictures, a picture starts with the parameter sets before its slice
+ */
+static void __stream_split(BENCH_STREAM_T *stream)
+{
+    uint32_t i, start = 0, num = 0;
+    uint8_t type, has_vcl = 0;
+
+    for (i = 0; i + 4 < stream->len && num < BENCH_FRAME_MAX; i++) {
+        if (stream->data[i] || stream->data[i + 1] || 0x01 != stream->data[i + 2]) {
+            continue;
+        }
+        type = stream->is_h265 ? (stream->data[i + 3] >> 1) & 0x3F : stream->data[i + 3] & 0x1F;
+        if (has_vcl) {
+            // the next access unit starts at its first NAL unit, the zero of a 4 byte start code included
+            stream->frame_off[num++] = start;
+            start = (i && 0 == stream->data[i - 1]) ? i - 1 : i;
+            has_vcl = 0;
+        }
+        if ((stream->is_h265 && type < 32) || (!stream->is_h265 && type >= 1 && type <= 5)) {
+            has_vcl = 1;
+        }
+        i += 2;
+    }
+    if (has_vcl && num < BENCH_FRAME_MAX) {
+        stream->frame_off[num++] = start;
+    }
+    stream->frame_num = num;
+    stream->frame_off[num] = stream->len;
+}
+
+static void __stream_load(BENCH_STREAM_T *stream)
+{
+    FILE *fp = fopen(stream->file, "rb");
+
+    stream->data = tal_malloc(BENCH_STREAM_MAX);
+    if (NULL == stream->data) {
+        return;
+    }
+
+    if (fp) {
+        stream->len = fread(stream->data, 1, BENCH_STREAM_MAX, fp);
+        fclose(fp);
+        __stream_split(stream);
+        PR_NOTICE("%s: %d frames read from %s", stream->name, stream->frame_num, stream->file);
+    }
+    if (NULL == fp || 0 == stream->frame_num) {
+        __stream_synthesize(stream);
+        PR_NOTICE("%s: %d frames synthesized, GOP %d", stream->name, stream->frame_num, BENCH_GOP);
+    }
+}
+
+/* the former scheme: a heap packet, copied behind the private header */
+static void *__heap_alloc(void *param, int bytes)
+{
+    BENCH_SINK_T *sink = (BENCH_SINK_T *)param;
+    uint8_t *packet = malloc(bytes);
+
+    if (packet) {
+        memset(packet, 0, bytes);
+        sink->allocs++;
+    }
+    return packet;
+}
+
+static void __heap_free(void *param, void *packet)
+{
+    free(packet);
+}
+
+static int __copy_packet(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
+{
+    BENCH_SINK_T *sink = (BENCH_SINK_T *)param;
+
+    memcpy(sink->buff, sg_head, BENCH_HEAD_LEN);
+    *(int *)&sink->buff[BENCH_HEAD_LEN - 4] = bytes;
+    memcpy(sink->buff + BENCH_HEAD_LEN, packet, bytes);
+
+    // stands for the send, which reads the whole packet once
+    sink->sum += sink->buff[BENCH_HEAD_LEN + bytes - 1];
+    sink->packets++;
+    return 0;
+}
+
+/* the persistent scheme: the packet is built in the send buffer */
+static void *__arena_alloc(void *param, int bytes)
+{
+    BENCH_SINK_T *sink = (BENCH_SINK_T *)param;
+
+    if (bytes > BENCH_PACK_LEN - BENCH_HEAD_LEN) {
+        return NULL;
+    }
+    return sink->buff + BENCH_HEAD_LEN;
+}
+
+static void __arena_free(void *param, void *packet)
+{
+    return;
+}
+
+static int __arena_packet(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
+{
+    BENCH_SINK_T *sink = (BENCH_SINK_T *)param;
+    uint8_t *head = (uint8_t *)packet - BENCH_HEAD_LEN;
+
+    memcpy(head, sg_head, BENCH_HEAD_LEN);
+    *(int *)&head[BENCH_HEAD_LEN - 4] = bytes;
+
+    sink->sum += head[BENCH_HEAD_LEN + bytes - 1];
+    sink->packets++;
+    return 0;
+}
+
+static void __bench_per_frame(BENCH_STREAM_T *stream, BENCH_SINK_T *sink)
+{
+    struct rtp_payload_t handler = {__heap_alloc, __heap_free, __copy_packet};
+    SYS_TIME_T start_ms, elapsed_ms;
+    uint32_t i, frames = 0, timestamp = 0;
+    uint16_t seq = 0;
+    void *packer = NULL;
+
+    start_ms = tal_system_get_millisecond();
+    do {
+        for (i = 0; i < stream->frame_num; i++, frames++) {
+            packer = rtp_payload_encode_create(stream->payload, stream->name, seq, 10, &handler, sink);
+            if (NULL == packer) {
+                PR_ERR("create %s packer failed", stream->name);
+                return;
+            }
+            sink->allocs += 2;
+            rtp_payload_encode_input(packer, stream->data + stream->frame_off[i],
+                                     stream->frame_off[i + 1] - stream->frame_off[i], timestamp);
+            rtp_payload_encode_getinfo(packer, &seq, &timestamp);
+            rtp_payload_encode_destroy(packer);
+            timestamp += 3000;
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("  per frame:  %6d frames/s, %4d packets and %4d allocations per frame",
+              (uint32_t)(frames * 1000 / elapsed_ms), sink->packets / frames, sink->allocs / frames);
+}
+
+static void __bench_persistent(BENCH_STREAM_T *stream, BENCH_SINK_T *sink)
+{
+    struct rtp_payload_t handler = {__arena_alloc, __arena_free, __arena_packet};
+    SYS_TIME_T start_ms, elapsed_ms;
+    uint32_t i, len, frames = 0, missed = 0;
+    uint32_t before;
+    int predicted;
+    void *packer = NULL;
+
+    packer = rtp_payload_encode_create(stream->payload, stream->name, 0, 10, &handler, sink);
+    if (NULL == packer) {
+        PR_ERR("create %s packer failed", stream->name);
+        return;
+    }
+    sink->allocs += 2;
+
+    start_ms = tal_system_get_millisecond();
+    do {
+        for (i = 0; i < stream->frame_num; i++, frames++) {
+            len = stream->frame_off[i + 1] - stream->frame_off[i];
+            // sized first, as the send buffer check does
+            predicted = rtp_payload_encode_packets(packer, stream->data + stream->frame_off[i], len);
+            before = sink->packets;
+            if (0 != rtp_payload_encode_input(packer, stream->data + stream->frame_off[i], len, frames * 3000)) {
+                missed++;
+            }
+            if (predicted != (int)(sink->packets - before)) {
+                missed++;
+            }
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    rtp_payload_encode_destroy(packer);
+
+    PR_NOTICE("  persistent: %6d frames/s, %4d packets and %4d allocations per frame, %d frames mispredicted",
+              (uint32_t)(frames * 1000 / elapsed_ms), sink->packets / frames, sink->allocs / frames, missed);
+}
+
+static void __bench_window(BENCH_STREAM_T *stream)
+{
+    struct rtp_payload_t handler = {__arena_alloc, __arena_free, __arena_packet};
+    uint32_t i, len, len_max = 0, estimate = 0, exact = 0, max_estimate = 0, max_exact = 0;
+    uint32_t seg_cnt = (BENCH_HEAD_LEN + rtp_packet_getsize() + TUYA_P2P_SEGMENT_DATA_LEN - 1) /
+                       TUYA_P2P_SEGMENT_DATA_LEN;
+    BENCH_SINK_T sink;
+    void *packer = NULL;
+    int packets;
+
+    memset(&sink, 0, sizeof(sink));
+    packer = rtp_payload_encode_create(stream->payload, stream->name, 0, 10, &handler, &sink);
+    if (NULL == packer) {
+        return;
+    }
+
+    for (i = 0; i < stream->frame_num; i++) {
+        len = stream->frame_off[i + 1] - stream->frame_off[i];
+        packets = rtp_payload_encode_packets(packer, stream->data + stream->frame_off[i], len);
+        estimate += (len / BENCH_RTP_MTU_LEN + 1) * TUYA_P2P_SEGMENT_SIZE;
+        exact += packets * seg_cnt * TUYA_P2P_SEGMENT_SIZE;
+        if (len > len_max) {
+            len_max = len;
+            max_estimate = (len / BENCH_RTP_MTU_LEN + 1) * TUYA_P2P_SEGMENT_SIZE;
+            max_exact = packets * seg_cnt * TUYA_P2P_SEGMENT_SIZE;
+        }
+    }
+    rtp_payload_encode_destroy(packer);
+
+    PR_NOTICE("  send buffer per frame: former estimate %d bytes, exact %d bytes; largest frame %d / %d bytes",
+              estimate / stream->frame_num, exact / stream->frame_num, max_estimate, max_exact);
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_TUYA_P2P) && (ENABLE_TUYA_P2P == 1)
+    BENCH_SINK_T sink;
+    uint32_t i;
+
+    PR_NOTICE("------ rtp packetizer benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_stream); i++) {
+        __stream_load(&sg_stream[i]);
+        if (NULL == sg_stream[i].data) {
+            PR_ERR("no memory for the %s stream", sg_stream[i].name);
+            continue;
+        }
+
+        memset(&sink, 0, sizeof(sink));
+        sink.buff = tal_malloc(BENCH_PACK_LEN);
+        if (NULL == sink.buff) {
+            continue;
+        }
+
+        PR_NOTICE("%s, %d bytes per frame:", sg_stream[i].name, sg_stream[i].len / sg_stream[i].frame_num);
+        __bench_per_frame(&sg_stream[i], &sink);
+        memset(sink.buff, 0, BENCH_PACK_LEN);
+        sink.allocs = sink.packets = 0;
+        __bench_persistent(&sg_stream[i], &sink);
+        __bench_window(&sg_stream[i]);
+
+        tal_free(sink.buff);
+        tal_free(sg_stream[i].data);
+        sg_stream[i].data = NULL;
+    }
+
+    PR_NOTICE("------ rtp packetizer benchmark end ------");
+#else
+    PR_ERR("tuya p2p is not enabled. Please enable CONFIG_ENABLE_TUYA_P2P in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file example_frame_fanout_benchmark.c
+ * @brief Measures the frame fan-out of tdl_camera with several subscribers.
+ *
+ * The example needs no camera: it registers two synthetic sources of YUV422
+ * frames, one at VGA and one at 720p. Each runs twice, at BENCH_CAMERA_FPS as
+ * a sensor would and then unpaced, producing frames as fast as buffers come
+ * back. Three subscribers share every frame the way a product does:
+ * - "display", latest only, reads one line;
+ * - "encoder", a queue of BENCH_ENC_DEPTH, reads the whole frame;
+ * - "stream", latest only, keeps a reference to the frame until the next one
+ *   arrives, as a sender waiting for the network would.
+ *
+ * After BENCH_RUN_MS it prints the frames produced and, per subscriber, the
+ * frames delivered and dropped and their age. At the sensor rate nothing
+ * should be dropped; unpaced, the encoder rate is the throughput of the
+ * slowest consumer. It then times the two frame copies per frame that three
+ * consumers needed before frames were shared.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_CAMERA_SYNTHETIC) && (ENABLE_CAMERA_SYNTHETIC == 1)
+#include "tdl_camera_manage.h"
+#include "tdd_camera_synthetic.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_RUN_MS     3000
+#define BENCH_CAMERA_FPS 30
+#define BENCH_FRAME_CNT  6
+#define BENCH_ENC_DEPTH  2
+#define BENCH_COPY_ROUNDS 50
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    char    *name;
+    uint16_t width;
+    uint16_t height;
+} BENCH_RES_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_CAMERA_SYNTHETIC) && (ENABLE_CAMERA_SYNTHETIC == 1)
+static const BENCH_RES_T sg_res[] = {
+    {"synth_vga", 640, 480},
+    {"synth_720p", 1280, 720},
+};
+
+static volatile uint32_t sg_sink = 0;
+static TDL_CAMERA_FRAME_T *sg_stream_frame = NULL;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_CAMERA_SYNTHETIC) && (ENABLE_CAMERA_SYNTHETIC == 1)
+static void __display_cb(TDL_CAMERA_HANDLE_T hdl, TDL_CAMERA_FRAME_T *frame, void *arg)
+{
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < frame->width * 2; i++) {
+        sum += frame->data[i];
+    }
+    sg_sink += sum;
+}
+
+static void __encoder_cb(TDL_CAMERA_HANDLE_T hdl, TDL_CAMERA_FRAME_T *frame, void *arg)
+{
+    uint32_t *word = (uint32_t *)frame->data;
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < frame->data_len / 4; i++) {
+        sum ^= word[i];
+    }
+    sg_sink += sum;
+}
+
+static void __stream_cb(TDL_CAMERA_HANDLE_T hdl, TDL_CAMERA_FRAME_T *frame, void *arg)
+{
+    // keep the frame past the callback, give back the previous one
+    tdl_camera_frame_ref(frame);
+    if (sg_stream_frame) {
+        tdl_camera_frame_unref(sg_stream_frame);
+    }
+    sg_stream_frame = frame;
+}
+
+static void __bench_report(char *name, TDL_CAMERA_SUB_HANDLE_T sub)
+{
+    TDL_CAMERA_SUB_STATS_T stats;
+
+    tdl_camera_sub_get_stats(sub, &stats);
+    PR_NOTICE("  %-8s %4d fps delivered, %5d dropped, age avg %3d ms max %3d ms", name,
+              stats.delivered * 1000 / BENCH_RUN_MS, stats.dropped, stats.age_avg_ms, stats.age_max_ms);
+}
+
+static void __bench_copy(const BENCH_RES_T *res)
+{
+    uint32_t len = res->width * res->height * 2;
+    uint8_t *src = tal_malloc(len);
+    uint8_t *dst = tal_malloc(len * 2);
+    SYS_TIME_T start_ms;
+    uint32_t i;
+
+    if (src && dst) {
+        memset(src, 0x5A, len);
+        start_ms = tal_system_get_millisecond();
+        for (i = 0; i < BENCH_COPY_ROUNDS; i++) {
+            memcpy(dst, src, len);
+            memcpy(dst + len, src, len);
+        }
+        PR_NOTICE("  copying each frame for two more consumers: %d us per frame",
+                  (uint32_t)((tal_system_get_millisecond() - start_ms) * 1000 / BENCH_COPY_ROUNDS));
+    }
+
+    tal_free(src);
+    tal_free(dst);
+}
+
+static void __bench_run(const BENCH_RES_T *res, uint16_t fps)
+{
+    OPERATE_RET rt = OPRT_OK;
+    TDL_CAMERA_HANDLE_T camera = NULL;
+    TDL_CAMERA_CFG_T cfg;
+    TDL_CAMERA_SUB_CFG_T sub_cfg;
+    TDL_CAMERA_SUB_HANDLE_T display = NULL, encoder = NULL, stream = NULL;
+    TDL_CAMERA_DEV_STATS_T start, end;
+
+    camera = tdl_camera_find_dev(res->name);
+    if (NULL == camera) {
+        PR_ERR("camera dev %s not found", res->name);
+        return;
+    }
+
+    memset(&sub_cfg, 0, sizeof(TDL_CAMERA_SUB_CFG_T));
+    sub_cfg.fmt = TDL_CAMERA_FMT_YUV422;
+
+    sub_cfg.policy = TDL_CAMERA_SUB_LATEST;
+    sub_cfg.cb     = __display_cb;
+    TUYA_CALL_ERR_GOTO(tdl_camera_subscribe(camera, &sub_cfg, &display), __EXIT);
+
+    sub_cfg.policy      = TDL_CAMERA_SUB_QUEUE;
+    sub_cfg.queue_depth = BENCH_ENC_DEPTH;
+    sub_cfg.cb          = __encoder_cb;
+    TUYA_CALL_ERR_GOTO(tdl_camera_subscribe(camera, &sub_cfg, &encoder), __EXIT);
+
+    sub_cfg.policy = TDL_CAMERA_SUB_LATEST;
+    sub_cfg.cb     = __stream_cb;
+    TUYA_CALL_ERR_GOTO(tdl_camera_subscribe(camera, &sub_cfg, &stream), __EXIT);
+
+    memset(&cfg, 0, sizeof(TDL_CAMERA_CFG_T));
+    cfg.fps           = fps; // 0: as fast as the subscribers give the buffers back
+    cfg.width         = res->width;
+    cfg.height        = res->height;
+    cfg.out_fmt       = TDL_CAMERA_FMT_YUV422;
+    cfg.raw_frame_cnt = BENCH_FRAME_CNT;
+    tdl_camera_dev_get_stats(camera, &start);
+    TUYA_CALL_ERR_GOTO(tdl_camera_dev_open(camera, &cfg), __EXIT);
+
+    tal_system_sleep(BENCH_RUN_MS);
+
+    tdl_camera_dev_close(camera);
+    tdl_camera_dev_get_stats(camera, &end);
+
+    PR_NOTICE("%s %dx%d %s: %d fps produced, %d frames without buffer", res->name, res->width, res->height,
+              fps ? "paced" : "unpaced", (end.raw_posted - start.raw_posted) * 1000 / BENCH_RUN_MS,
+              end.no_buffer - start.no_buffer);
+    __bench_report("display", display);
+    __bench_report("encoder", encoder);
+    __bench_report("stream", stream);
+
+__EXIT:
+    if (display) {
+        tdl_camera_unsubscribe(display);
+    }
+    if (encoder) {
+        tdl_camera_unsubscribe(encoder);
+    }
+    if (stream) {
+        tdl_camera_unsubscribe(stream);
+    }
+    // let the stream callback finish before giving back the frame it kept
+    tal_system_sleep(100);
+    if (sg_stream_frame) {
+        tdl_camera_frame_unref(sg_stream_frame);
+        sg_stream_frame = NULL;
+    }
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_CAMERA_SYNTHETIC) && (ENABLE_CAMERA_SYNTHETIC == 1)
+    TDD_SYNTHETIC_CFG_T synth_cfg;
+    uint32_t i;
+
+    // one source per resolution, the frame buffers of a device keep the size of its first open
+    for (i = 0; i < CNTSOF(sg_res); i++) {
+        synth_cfg.max_fps    = BENCH_CAMERA_FPS;
+        synth_cfg.max_width  = sg_res[i].width;
+        synth_cfg.max_height = sg_res[i].height;
+        if (OPRT_OK != tdl_camera_synthetic_device_register(sg_res[i].name, &synth_cfg)) {
+            PR_ERR("register %s failed", sg_res[i].name);
+            return;
+        }
+    }
+
+    PR_NOTICE("------ frame fan-out benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_res); i++) {
+        __bench_run(&sg_res[i], BENCH_CAMERA_FPS);
+        __bench_run(&sg_res[i], 0);
+        __bench_copy(&sg_res[i]);
+    }
+
+    PR_NOTICE("------ frame fan-out benchmark end ------");
+#else
+    PR_ERR("synthetic camera is not enabled. Please enable CONFIG_ENABLE_CAMERA_SYNTHETIC in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
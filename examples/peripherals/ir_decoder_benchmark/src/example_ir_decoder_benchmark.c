@@ -0,0 +1,612 @@
+/**
+ * @file example_ir_decoder_benchmark.c
+ * @brief Checks and measures the streaming IR decoder of tdl_ir_device.
+ *
+ * The example needs no IR hardware. It builds pulse traces of NEC (with two
+ * repeat frames), RC5, RC5X, RC6, Sony SIRC 12/15/20 and a 48 bit air
+ * conditioner code that only the learned mode can decode, distorted the way a
+ * demodulating receiver does: marks BENCH_MARK_SKEW_US longer, spaces as much
+ * shorter, every duration off by up to BENCH_JITTER_PCT percent.
+ *
+ * It then
+ * - replays every trace through a decoder of its own protocol, and all but
+ *   SIRC 15/20 through one IR_PROT_AUTO decoder, checking every code and
+ *   repeat, and prints when the first code came out against the length of
+ *   the frame;
+ * - reports the CPU time of tdl_ir_decoder_feed() per edge, and of the former
+ *   NEC parser per frame;
+ * - registers a replay driver as "ir_replay", opens it as an NEC device with
+ *   a callback and plays the NEC trace at its real pace, reporting the time
+ *   from the edge that completes each code to the callback, and to the end
+ *   of reception callback, where the former receiver reported the code.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+#if defined(ENABLE_IR) && (ENABLE_IR == 1)
+#include "tdl_ir_dev_manage.h"
+#include "tdl_ir_decoder.h"
+#include "tdl_nec_protocol.h"
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TRACE_MAX     512
+#define BENCH_CODE_MAX      8
+#define BENCH_MARK_SKEW_US  60
+#define BENCH_JITTER_PCT    8
+#define BENCH_TIME_MS       1000 // run each CPU case for about this long
+#define BENCH_IDLE_US       1000000
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    char     *name;
+    IR_PROT_E prot;
+    uint8_t   sirc_bits;
+    uint8_t   toggle;
+    uint16_t  addr;
+    uint16_t  cmd;
+    uint8_t   frames; // the first frame and its repeats
+} BENCH_CASE_T;
+
+typedef struct {
+    uint32_t dur[BENCH_TRACE_MAX];
+    uint16_t len;
+    uint16_t frame_len; // edges up to the last mark of the first frame
+} BENCH_TRACE_T;
+
+typedef struct {
+    IR_DRV_RECV_CB recv_cb;
+    void          *args;
+} BENCH_REPLAY_DRV_T;
+
+typedef struct {
+    volatile SYS_TIME_T edge_ms[BENCH_CODE_MAX]; // when the edge completing each code was played
+    volatile SYS_TIME_T last_edge_ms;
+    uint32_t            code_cnt;
+    uint32_t            code_ms_max;
+    uint32_t            finish_ms;
+    uint8_t             finished;
+} BENCH_LIVE_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if defined(ENABLE_IR) && (ENABLE_IR == 1)
+static const BENCH_CASE_T sg_case[] = {
+    {"nec", IR_PROT_NEC, 0, 0, 0x807F, 0x1DE2, 3},
+    {"rc5", IR_PROT_RC5, 0, 1, 0x05, 0x35, 2},
+    {"rc5x", IR_PROT_RC5, 0, 0, 0x1A, 0x4C, 1},
+    {"rc6", IR_PROT_RC6, 0, 1, 0x04, 0x0C, 2},
+    {"sirc12", IR_PROT_SIRC, 12, 0, 0x01, 0x15, 3},
+    {"sirc15", IR_PROT_SIRC, 15, 0, 0x97, 0x2A, 3},
+    {"sirc20", IR_PROT_SIRC, 20, 0, 0x1C3A, 0x39, 3},
+    {"learned", IR_PROT_LEARN, 0, 0, 0, 0, 1},
+};
+
+static const uint8_t sg_ac_code[6] = {0x02, 0x20, 0xE0, 0x04, 0x00, 0x48};
+
+static BENCH_TRACE_T sg_trace[CNTSOF(sg_case)];
+static BENCH_TRACE_T sg_learned;
+static BENCH_TRACE_T sg_replay;
+static uint32_t sg_seed = 1;
+
+static BENCH_REPLAY_DRV_T sg_replay_drv;
+static BENCH_LIVE_T sg_live;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if defined(ENABLE_IR) && (ENABLE_IR == 1)
+static void __trace_add(BENCH_TRACE_T *trace, uint8_t is_mark, uint32_t us)
+{
+    /* the trace starts with a mark, a level that goes on lengthens the last duration */
+    if (is_mark == !(trace->len & 1)) {
+        if (trace->len < BENCH_TRACE_MAX) {
+            trace->dur[trace->len++] = us;
+        }
+    } else if (trace->len) {
+        trace->dur[trace->len - 1] += us;
+    }
+}
+
+static uint32_t __trace_us(BENCH_TRACE_T *trace, uint16_t len)
+{
+    uint32_t i, us = 0;
+
+    for (i = 0; i < len; i++) {
+        us += trace->dur[i];
+    }
+    return us;
+}
+
+static void __encode_pulse_distance(BENCH_TRACE_T *trace, const uint8_t *byte, uint8_t bytes, uint32_t unit)
+{
+    uint32_t i, bit;
+
+    for (i = 0; i < bytes * 8; i++) {
+        bit = (byte[i / 8] >> (i % 8)) & 0x01;
+        __trace_add(trace, 1, unit);
+        __trace_add(trace, 0, bit ? unit * 3 : unit);
+    }
+    __trace_add(trace, 1, unit);
+}
+
+static void __encode(const BENCH_CASE_T *c, BENCH_TRACE_T *trace)
+{
+    uint8_t byte[4] = {c->addr >> 8, c->addr & 0xFF, c->cmd >> 8, c->cmd & 0xFF};
+    uint32_t frame, start_us, data, i;
+    int32_t bit;
+
+    memset(trace, 0, sizeof(BENCH_TRACE_T));
+
+    for (frame = 0; frame < c->frames; frame++) {
+        start_us = __trace_us(trace, trace->len);
+
+        switch (c->prot) {
+        case IR_PROT_NEC:
+            __trace_add(trace, 1, 9000);
+            if (0 == frame) {
+                __trace_add(trace, 0, 4500);
+                for (i = 0; i < 32; i++) {
+                    __trace_add(trace, 1, 560);
+                    __trace_add(trace, 0, ((byte[i / 8] >> (i % 8)) & 0x01) ? 1690 : 560);
+                }
+            } else {
+                __trace_add(trace, 0, 2250);
+            }
+            __trace_add(trace, 1, 560);
+            break;
+
+        case IR_PROT_RC5:
+            data = (1 << 13) | (!(c->cmd & 0x40) << 12) | (c->toggle << 11) | ((c->addr & 0x1F) << 6) | (c->cmd & 0x3F);
+            for (bit = 13; bit >= 0; bit--) {
+                __trace_add(trace, !((data >> bit) & 0x01), 889);
+                __trace_add(trace, (data >> bit) & 0x01, 889);
+            }
+            break;
+
+        case IR_PROT_RC6:
+            __trace_add(trace, 1, 2666);
+            __trace_add(trace, 0, 889);
+            /* start bit 1, mode 0, the toggle in the double width trailer bit */
+            data = (1 << 20) | (c->toggle << 16) | ((c->addr & 0xFF) << 8) | (c->cmd & 0xFF);
+            for (bit = 20; bit >= 0; bit--) {
+                __trace_add(trace, (data >> bit) & 0x01, (16 == bit) ? 889 : 444);
+                __trace_add(trace, !((data >> bit) & 0x01), (16 == bit) ? 889 : 444);
+            }
+            break;
+
+        case IR_PROT_SIRC:
+            data = (c->cmd & 0x7F) | (c->addr << 7);
+            __trace_add(trace, 1, 2400);
+            __trace_add(trace, 0, 600);
+            for (i = 0; i < c->sirc_bits; i++) {
+                __trace_add(trace, 1, ((data >> i) & 0x01) ? 1200 : 600);
+                __trace_add(trace, 0, 600);
+            }
+            break;
+
+        default:
+            /* an air conditioner frame, pulse distance on a 432 us unit */
+            __trace_add(trace, 1, 3456);
+            __trace_add(trace, 0, 1728);
+            __encode_pulse_distance(trace, sg_ac_code, sizeof(sg_ac_code), 432);
+            break;
+        }
+
+        if (0 == frame) {
+            trace->frame_len = trace->len - !(trace->len & 1);
+        }
+        if (frame + 1 < c->frames) {
+            /* the next frame starts one period later */
+            __trace_add(trace, 0,
+                        ((IR_PROT_SIRC == c->prot) ? 45000 : 110000) - (__trace_us(trace, trace->len) - start_us));
+        }
+    }
+}
+
+static uint32_t __bench_distort(uint32_t us, uint8_t is_mark)
+{
+    int32_t jitter;
+
+    sg_seed = sg_seed * 1103515245 + 12345;
+    jitter = (int32_t)(us * BENCH_JITTER_PCT / 100) * ((int32_t)((sg_seed >> 16) % 201) - 100) / 100;
+
+    return (is_mark ? us + BENCH_MARK_SKEW_US : us - BENCH_MARK_SKEW_US) + jitter;
+}
+
+static void __bench_distort_trace(BENCH_TRACE_T *src, BENCH_TRACE_T *dst)
+{
+    uint32_t i;
+
+    dst->len = src->len;
+    dst->frame_len = src->frame_len;
+    for (i = 0; i < src->len; i++) {
+        dst->dur[i] = __bench_distort(src->dur[i], !(i & 1));
+    }
+}
+
+/**
+ * @brief feed a trace, return the codes, the time and the index of the edges that completed them
+ */
+static uint32_t __bench_replay(IR_DECODER_HANDLE_T dec, BENCH_TRACE_T *trace, IR_DATA_CODE_T *code, uint32_t *code_us,
+                               uint32_t *code_idx)
+{
+    uint32_t i, us = 0, cnt = 0;
+
+    tdl_ir_decoder_reset(dec);
+    for (i = 0; i < trace->len; i++) {
+        us += trace->dur[i];
+        if (tdl_ir_decoder_feed(dec, trace->dur[i], &code[cnt]) && cnt < BENCH_CODE_MAX - 1) {
+            if (code_us) {
+                code_us[cnt] = us;
+            }
+            if (code_idx) {
+                code_idx[cnt] = i;
+            }
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+static uint32_t __bench_check(const BENCH_CASE_T *c, IR_DATA_CODE_T *code, uint32_t cnt)
+{
+    uint32_t i, failed = 0;
+
+    if (cnt != c->frames) {
+        PR_ERR("%s: %d codes, expected %d", c->name, cnt, c->frames);
+        failed++;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        if (code[i].prot != c->prot || code[i].repeat_cnt != i || code[i].addr != c->addr || code[i].cmd != c->cmd ||
+            code[i].toggle != c->toggle) {
+            PR_ERR("%s: code %d prot %d addr %04x cmd %04x toggle %d repeat %d", c->name, i, code[i].prot,
+                   code[i].addr, code[i].cmd, code[i].toggle, code[i].repeat_cnt);
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+static uint32_t __bench_decode(void)
+{
+    IR_DECODER_CFG_T cfg;
+    IR_DECODER_HANDLE_T dec = NULL, auto_dec = NULL;
+    IR_DATA_TIMECODE_T learned = {sg_learned.len, sg_learned.dur};
+    IR_DATA_CODE_T code[BENCH_CODE_MAX];
+    uint32_t code_us[BENCH_CODE_MAX];
+    uint32_t i, cnt, frame_us, failed = 0;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.prot_mask = IR_DECODE_PROT_ALL;
+    if (OPRT_OK != tdl_ir_decoder_create(&cfg, &auto_dec)) {
+        return 1;
+    }
+    tdl_ir_decoder_learn_add(auto_dec, &learned);
+
+    for (i = 0; i < CNTSOF(sg_case); i++) {
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.prot_mask = IR_PROT_BIT(sg_case[i].prot);
+        cfg.sirc_bits = sg_case[i].sirc_bits;
+        if (OPRT_OK != tdl_ir_decoder_create(&cfg, &dec)) {
+            failed++;
+            continue;
+        }
+        if (IR_PROT_LEARN == sg_case[i].prot) {
+            tdl_ir_decoder_learn_add(dec, &learned);
+        }
+
+        __bench_distort_trace(&sg_trace[i], &sg_replay);
+        cnt = __bench_replay(dec, &sg_replay, code, code_us, NULL);
+        failed += __bench_check(&sg_case[i], code, cnt);
+        frame_us = __trace_us(&sg_replay, sg_replay.frame_len);
+        PR_NOTICE("%-8s frame ends at %3d.%d ms, code at %3d.%d ms", sg_case[i].name, frame_us / 1000,
+                  frame_us / 100 % 10, cnt ? code_us[0] / 1000 : 0, cnt ? code_us[0] / 100 % 10 : 0);
+
+        /* the auto decoder only takes the default SIRC length */
+        if (IR_PROT_SIRC != sg_case[i].prot || 12 == sg_case[i].sirc_bits) {
+            __bench_distort_trace(&sg_trace[i], &sg_replay);
+            cnt = __bench_replay(auto_dec, &sg_replay, code, NULL, NULL);
+            failed += __bench_check(&sg_case[i], code, cnt);
+        }
+
+        tdl_ir_decoder_release(dec);
+        dec = NULL;
+    }
+
+    tdl_ir_decoder_release(auto_dec);
+
+    return failed;
+}
+
+static void __bench_cpu(void)
+{
+    IR_DECODER_CFG_T cfg;
+    IR_DECODER_HANDLE_T dec = NULL;
+    IR_DATA_TIMECODE_T learned = {sg_learned.len, sg_learned.dur};
+    IR_DATA_CODE_T code[BENCH_CODE_MAX];
+    IR_NEC_CFG_T nec_cfg = {0, 31, 46, 46, 40, 24};
+    IR_DATA_NEC_T nec_data;
+    void *nec_err_val = NULL;
+    SYS_TIME_T start_ms, elapsed_ms;
+    uint32_t i, rounds = 0, edges = 0;
+    uint16_t head = 0;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.prot_mask = IR_DECODE_PROT_ALL;
+    if (OPRT_OK != tdl_ir_decoder_create(&cfg, &dec)) {
+        return;
+    }
+    tdl_ir_decoder_learn_add(dec, &learned);
+
+    start_ms = tal_system_get_millisecond();
+    do {
+        for (i = 0; i < CNTSOF(sg_case); i++) {
+            __bench_replay(dec, &sg_trace[i], code, NULL, NULL);
+            edges += sg_trace[i].len;
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    PR_NOTICE("auto decoder: %d ns per edge", (uint32_t)(elapsed_ms * 1000000 / edges));
+    tdl_ir_decoder_release(dec);
+    dec = NULL;
+
+    /* the same NEC capture through an NEC decoder and the former parser */
+    __bench_distort_trace(&sg_trace[0], &sg_replay);
+    sg_replay.len = sg_replay.frame_len + 1;
+
+    cfg.prot_mask = IR_PROT_BIT(IR_PROT_NEC);
+    if (OPRT_OK != tdl_ir_decoder_create(&cfg, &dec)) {
+        return;
+    }
+    start_ms = tal_system_get_millisecond();
+    do {
+        __bench_replay(dec, &sg_replay, code, NULL, NULL);
+        rounds++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    PR_NOTICE("NEC decoder: %d ns per frame, spread over its edges", (uint32_t)(elapsed_ms * 1000000 / rounds));
+    tdl_ir_decoder_release(dec);
+
+    /* the former path: find the leader, then parse the whole capture */
+    if (OPRT_OK != tdl_ir_nec_err_val_init(&nec_err_val, &nec_cfg)) {
+        return;
+    }
+    rounds = 0;
+    start_ms = tal_system_get_millisecond();
+    do {
+        tdl_nec_get_frame_head(sg_replay.dur, sg_replay.len, nec_err_val, &head);
+        tdl_ir_nec_parser_single(&sg_replay.dur[head], sg_replay.len - head, nec_err_val, 0, &nec_data);
+        rounds++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+    PR_NOTICE("former NEC parser: %d ns per frame, in the receive task, decoded %04x %04x", (uint32_t)(elapsed_ms * 1000000 / rounds),
+              nec_data.addr, nec_data.cmd);
+    tdl_ir_nec_err_val_init_release(nec_err_val);
+}
+
+static int __replay_open(IR_DRV_HANDLE_T drv_hdl, unsigned char mode, IR_TDL_TRANS_CB ir_tdl_cb, void *args)
+{
+    sg_replay_drv.recv_cb = ir_tdl_cb.recv_cb;
+    sg_replay_drv.args = args;
+    return OPRT_OK;
+}
+
+static int __replay_close(IR_DRV_HANDLE_T drv_hdl, unsigned char mode)
+{
+    sg_replay_drv.recv_cb = NULL;
+    return OPRT_OK;
+}
+
+static int __replay_output(IR_DRV_HANDLE_T drv_hdl, unsigned int freq, unsigned char is_active, unsigned int time_us)
+{
+    return OPRT_NOT_SUPPORTED;
+}
+
+static int __replay_status_notif(IR_DRV_HANDLE_T drv_hdl, IR_DRIVER_STATE_E state, void *args)
+{
+    return OPRT_OK;
+}
+
+static TDD_IR_INTFS_T sg_replay_intfs = {
+    .open = __replay_open,
+    .close = __replay_close,
+    .output = __replay_output,
+    .status_notif = __replay_status_notif,
+};
+
+static void __live_recv_cb(uint8_t is_frame_finish, IR_DATA_U *recv_data)
+{
+    uint32_t ms;
+
+    if (is_frame_finish) {
+        sg_live.finish_ms = (uint32_t)(tal_system_get_millisecond() - sg_live.last_edge_ms);
+        sg_live.finished = 1;
+        return;
+    }
+
+    if (sg_live.code_cnt < BENCH_CODE_MAX) {
+        ms = (uint32_t)(tal_system_get_millisecond() - sg_live.edge_ms[sg_live.code_cnt]);
+        if (ms > sg_live.code_ms_max) {
+            sg_live.code_ms_max = ms;
+        }
+    }
+    PR_DEBUG("nec %04x %04x repeat %d", recv_data->nec_data.addr, recv_data->nec_data.cmd,
+             recv_data->nec_data.repeat_cnt);
+    sg_live.code_cnt++;
+}
+
+static void __bench_live(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    IR_HANDLE_T ir = NULL;
+    IR_DEV_CFG_T cfg;
+    IR_DECODER_CFG_T dec_cfg;
+    IR_DECODER_HANDLE_T dec = NULL;
+    IR_DATA_CODE_T code[BENCH_CODE_MAX];
+    uint32_t code_idx[BENCH_CODE_MAX];
+    uint32_t i, k = 0, cnt = 0;
+    uint64_t due_us = 0;
+    SYS_TIME_T start_ms;
+
+    /* the edges that complete a code, found offline */
+    __bench_distort_trace(&sg_trace[0], &sg_replay);
+    memset(&dec_cfg, 0, sizeof(dec_cfg));
+    dec_cfg.prot_mask = IR_PROT_BIT(IR_PROT_NEC);
+    dec_cfg.tolerance = 46;
+    TUYA_CALL_ERR_LOG(tdl_ir_decoder_create(&dec_cfg, &dec));
+    if (OPRT_OK != rt) {
+        return;
+    }
+    cnt = __bench_replay(dec, &sg_replay, code, NULL, code_idx);
+    tdl_ir_decoder_release(dec);
+
+    TUYA_CALL_ERR_GOTO(tdl_ir_dev_register("ir_replay", NULL, &sg_replay_intfs), __EXIT);
+    TUYA_CALL_ERR_GOTO(tdl_ir_dev_find("ir_replay", &ir), __EXIT);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ir_mode = IR_MODE_RECV_ONLY;
+    cfg.recv_queue_num = 3;
+    cfg.recv_buf_size = 1024;
+    cfg.recv_timeout = 300;
+    cfg.prot_opt = IR_PROT_NEC;
+    cfg.prot_cfg.nec_cfg = (IR_NEC_CFG_T){0, 31, 46, 46, 40, 24};
+    TUYA_CALL_ERR_GOTO(tdl_ir_dev_open(ir, &cfg), __EXIT);
+    TUYA_CALL_ERR_GOTO(tdl_ir_config(ir, IR_CMD_RECV_CB_REGISTER, __live_recv_cb), __EXIT);
+
+    memset(&sg_live, 0, sizeof(sg_live));
+
+    /* play the edges at their pace, the first one ends the idle level */
+    sg_replay_drv.recv_cb(NULL, BENCH_IDLE_US, sg_replay_drv.args);
+    start_ms = tal_system_get_millisecond();
+    for (i = 0; i < sg_replay.len; i++) {
+        due_us += sg_replay.dur[i];
+        while (tal_system_get_millisecond() - start_ms < due_us / 1000) {
+            tal_system_sleep(1);
+        }
+        sg_live.last_edge_ms = tal_system_get_millisecond();
+        if (k < cnt && code_idx[k] == i) {
+            sg_live.edge_ms[k++] = sg_live.last_edge_ms;
+        }
+        sg_replay_drv.recv_cb(NULL, sg_replay.dur[i], sg_replay_drv.args);
+    }
+
+    for (i = 0; i < 10 && !sg_live.finished; i++) {
+        tal_system_sleep(100);
+    }
+
+    PR_NOTICE("live NEC device: %d of %d codes, each within %d ms of its last edge", sg_live.code_cnt, cnt,
+              sg_live.code_ms_max);
+    PR_NOTICE("live NEC device: end of reception %d ms after the last edge", sg_live.finished ? sg_live.finish_ms : 0);
+
+__EXIT:
+    if (ir) {
+        tdl_ir_dev_close(ir);
+    }
+}
+#endif
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+#if defined(ENABLE_IR) && (ENABLE_IR == 1)
+    uint32_t i, failed;
+
+    for (i = 0; i < CNTSOF(sg_case); i++) {
+        __encode(&sg_case[i], &sg_trace[i]);
+    }
+    /* the learned code is the clean frame */
+    __encode(&sg_case[CNTSOF(sg_case) - 1], &sg_learned);
+
+    PR_NOTICE("------ ir decoder benchmark start ------");
+
+    failed = __bench_decode();
+    PR_NOTICE("decode check: %s (%d failures)", failed ? "FAILED" : "passed", failed);
+
+    __bench_cpu();
+    __bench_live();
+
+    PR_NOTICE("------ ir decoder benchmark end ------");
+#else
+    PR_ERR("IR is not enabled. Please enable CONFIG_ENABLE_IR in app_default.config");
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,264 @@
+/**
+ * @file example_atop_codec_benchmark.c
+ * @brief Measures latency and peak heap of the ATOP request/response codec.
+ *
+ * The example plays both sides of an ATOP exchange without a network: a local
+ * stand-in for the cloud encrypts a JSON reply of the requested size with the
+ * device key and wraps it as {"result":"<base64>","t":...} the way the ATOP
+ * gateway does. Each round then signs and encrypts a request with
+ * atop_base_request_encode() and decrypts and parses the reply with
+ * atop_base_response_decode(), as atop_base_request() does around the HTTP
+ * exchange.
+ *
+ * For every reply size it prints the average encode and decode time and the
+ * peak heap used on top of the receive buffer. The peak needs
+ * ENABLE_TAL_MEMORY_PROFILE or ENABLE_TAL_MEMORY_POOL, otherwise it is shown
+ * as 0.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "atop_base.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/base64.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_KEY    "0123456789abcdef0123456789abcdef"
+#define BENCH_ROUNDS 100
+#define BENCH_NONCE  "0123456789ab" // 12 bytes, fixed for the stand-in
+
+#define BENCH_REPLY_HEAD "{\"success\":true,\"result\":{\"schema\":\""
+#define BENCH_REPLY_TAIL "\"},\"t\":1700000000}"
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const uint32_t sg_reply_len[] = {256, 1024, 4096, 16384};
+
+static char sg_request_data[] = "{\"token\":\"AYxxxxxx\",\"softVer\":\"1.0.0\",\"protocolVer\":\"2.2\","
+                                "\"baselineVer\":\"40.00\",\"cadVer\":\"1.0.3\",\"cdVer\":\"1.0.0\",\"t\":1700000000}";
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+/**
+ * @brief Builds the encrypted reply the ATOP gateway would send
+ *
+ * @param[in] len plaintext length
+ * @param[out] reply NUL terminated HTTP body, release with tal_free
+ * @param[out] reply_len body length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+static OPERATE_RET __standin_reply_make(uint32_t len, char **reply, size_t *reply_len)
+{
+    OPERATE_RET rt = OPRT_OK;
+    mbedtls_gcm_context gcm;
+    uint8_t *plain = NULL, *sealed = NULL;
+    size_t sealed_len = 12 + len + 16, b64_len = 0, offset = 0;
+
+    if (len < strlen(BENCH_REPLY_HEAD) + strlen(BENCH_REPLY_TAIL)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    plain = tal_malloc(len);
+    sealed = tal_malloc(sealed_len);
+    *reply = tal_malloc(sealed_len * 4 / 3 + 64);
+    if (NULL == plain || NULL == sealed || NULL == *reply) {
+        rt = OPRT_MALLOC_FAILED;
+        goto __EXIT;
+    }
+
+    // {"success":true,"result":{"schema":"xxxx..."},"t":1700000000}
+    memset(plain, 'x', len);
+    memcpy(plain, BENCH_REPLY_HEAD, strlen(BENCH_REPLY_HEAD));
+    memcpy(plain + len - strlen(BENCH_REPLY_TAIL), BENCH_REPLY_TAIL, strlen(BENCH_REPLY_TAIL));
+
+    memcpy(sealed, BENCH_NONCE, 12);
+    mbedtls_gcm_init(&gcm);
+    mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, (const unsigned char *)BENCH_KEY, 128);
+    rt = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, sealed, 12, NULL, 0, plain, sealed + 12, 16,
+                                   sealed + 12 + len);
+    mbedtls_gcm_free(&gcm);
+    if (OPRT_OK != rt) {
+        goto __EXIT;
+    }
+
+    offset = sprintf(*reply, "{\"result\":\"");
+    mbedtls_base64_encode((uint8_t *)*reply + offset, sealed_len * 4 / 3 + 8, &b64_len, sealed, sealed_len);
+    offset += b64_len;
+    offset += sprintf(*reply + offset, "\",\"t\":1700000000,\"sign\":\"00\"}");
+    *reply_len = offset;
+
+__EXIT:
+    tal_free(plain);
+    tal_free(sealed);
+    if (OPRT_OK != rt) {
+        tal_free(*reply);
+        *reply = NULL;
+    }
+
+    return rt;
+}
+
+/**
+ * @brief Runs BENCH_ROUNDS exchanges with one reply size and prints the results
+ *
+ * @param[in] len reply plaintext length
+ *
+ * @return none
+ */
+static void __bench_run(uint32_t len)
+{
+    atop_base_request_t request = {
+        .path = "/d.json",
+        .key = BENCH_KEY,
+        .api = "thing.device.opensdk.active",
+        .version = "1.0",
+        .uuid = "uuidxxxxxxxxxxxxxxxx",
+        .timestamp = 1700000000,
+        .data = sg_request_data,
+        .datalen = sizeof(sg_request_data) - 1,
+    };
+    size_t buffer_len = ATOP_BASE_BUFFER_SIZE(request.datalen);
+    TAL_MEMORY_STATS_T stats = {0};
+    uint32_t encode_ms = 0, decode_ms = 0, start_ms = 0, live = 0, peak = 0;
+    char *reply = NULL, *path = NULL;
+    uint8_t *buffer = NULL, *rx = NULL, *body = NULL;
+    size_t reply_len = 0, body_len = 0;
+    uint32_t i, failed = 0;
+
+    if (OPRT_OK != __standin_reply_make(len, &reply, &reply_len)) {
+        PR_ERR("stand-in reply %d failed", len);
+        return;
+    }
+    buffer = tal_malloc(buffer_len);
+    rx = tal_malloc(reply_len + 1);
+    if (NULL == buffer || NULL == rx) {
+        goto __EXIT;
+    }
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        atop_base_response_t response = {0};
+
+        start_ms = (uint32_t)tal_system_get_millisecond();
+        if (OPRT_OK != atop_base_request_encode(&request, buffer, buffer_len, &path, &body, &body_len)) {
+            failed++;
+        }
+        encode_ms += (uint32_t)tal_system_get_millisecond() - start_ms;
+
+        // the HTTP client hands over the body in its receive buffer
+        memcpy(rx, reply, reply_len + 1);
+        tal_memory_peak_reset();
+        tal_memory_get_stats(&stats);
+        live = stats.live_bytes;
+
+        start_ms = (uint32_t)tal_system_get_millisecond();
+        if (OPRT_OK != atop_base_response_decode(BENCH_KEY, rx, reply_len, &response) || !response.success) {
+            failed++;
+        }
+        decode_ms += (uint32_t)tal_system_get_millisecond() - start_ms;
+
+        tal_memory_get_stats(&stats);
+        if (stats.peak_bytes - live > peak) {
+            peak = stats.peak_bytes - live;
+        }
+        atop_base_response_free(&response);
+    }
+
+    PR_NOTICE("reply %6d B (body %6d B): encode %4d us, decode %5d us, decode peak heap %6d B, failed %d", len,
+              (int)reply_len, encode_ms * 1000 / BENCH_ROUNDS, decode_ms * 1000 / BENCH_ROUNDS, peak, failed);
+
+__EXIT:
+    tal_free(rx);
+    tal_free(buffer);
+    tal_free(reply);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t i;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    PR_NOTICE("------ atop codec benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_reply_len); i++) {
+        __bench_run(sg_reply_len[i]);
+    }
+
+    PR_NOTICE("------ atop codec benchmark end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,319 @@
+/**
+ * @file example_dp_schema_benchmark.c
+ * @brief Measures DP schema lookups and bulk report validation.
+ *
+ * The example plays a gateway: it creates BENCH_DEV_NUM sub-device schemas
+ * of BENCH_DP_NUM DPs each, as many as DP_SCHEMA_NUM_MAX of the build
+ * registers, then reports every DP of every sub-device in turn. Each report
+ * resolves the device with dp_schema_find() and validates its DPs with
+ * dp_rept_valid_check(), as tuya_iot_dp_obj_report does before encoding.
+ *
+ * It prints:
+ * - dp_schema_find() against a strcmp scan of the devices, the former lookup;
+ * - dp_node_find() against a scan of schema->node[], the former lookup;
+ * - reports and DPs validated per second.
+ *
+ * That the lookups find what the scans find and that validation accepts and
+ * rejects the right DPs is checked by the unit tests in
+ * src/tuya_cloud_service/ut.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "dp_schema.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TIME_MS   1000 // run each case for about this long
+#define BENCH_DEV_NUM   32
+#define BENCH_DP_NUM    64
+#define BENCH_JSON_LEN  (BENCH_DP_NUM * 128)
+#define BENCH_DEVID_FMT "6c8f1a2b3c4d5e%04dsub"
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef uint32_t (*BENCH_CASE_CB)(uint32_t round);
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static char sg_devid[BENCH_DEV_NUM][DEV_ID_LEN + 1];
+static dp_schema_t *sg_schema[BENCH_DEV_NUM];
+static uint32_t sg_dev_num;
+
+static dp_obj_t sg_dps[BENCH_DP_NUM];
+static dp_rept_valid_t *sg_dpvalid;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+/**
+ * @brief DP id of the i-th DP, spread over 1..255 like real products
+ */
+static uint8_t __dp_id(uint32_t i)
+{
+    return (uint8_t)(1 + (i * 97) % 255);
+}
+
+static char *__schema_json_make(void)
+{
+    static const char *props[] = {
+        "{\"type\":\"bool\"}",
+        "{\"type\":\"value\",\"min\":0,\"max\":1000,\"step\":1,\"scale\":0}",
+        "{\"type\":\"enum\",\"range\":[\"low\",\"middle\",\"high\"]}",
+        "{\"type\":\"string\",\"maxlen\":255}",
+        "{\"type\":\"bitmap\",\"label\":[\"a\",\"b\",\"c\"],\"maxlen\":8}",
+    };
+    char *json = tal_malloc(BENCH_JSON_LEN);
+    int offset = 0;
+
+    if (NULL == json) {
+        return NULL;
+    }
+    offset += snprintf(json + offset, BENCH_JSON_LEN - offset, "[");
+    for (uint32_t i = 0; i < BENCH_DP_NUM; i++) {
+        offset += snprintf(json + offset, BENCH_JSON_LEN - offset,
+                           "%s{\"id\":%d,\"mode\":\"rw\",\"type\":\"obj\",\"property\":%s}", i ? "," : "",
+                           __dp_id(i), props[i % CNTSOF(props)]);
+    }
+    snprintf(json + offset, BENCH_JSON_LEN - offset, "]");
+
+    return json;
+}
+
+static void __report_make(void)
+{
+    for (uint32_t i = 0; i < BENCH_DP_NUM; i++) {
+        dp_obj_t *dp = &sg_dps[i];
+
+        dp->id = __dp_id(i);
+        switch (i % 5) {
+        case 0:
+            dp->type = PROP_BOOL;
+            dp->value.dp_bool = true;
+            break;
+        case 1:
+            dp->type = PROP_VALUE;
+            dp->value.dp_value = i * 10;
+            break;
+        case 2:
+            dp->type = PROP_ENUM;
+            dp->value.dp_enum = i % 3;
+            break;
+        case 3:
+            dp->type = PROP_STR;
+            dp->value.dp_str = "bench";
+            break;
+        default:
+            dp->type = PROP_BITMAP;
+            dp->value.dp_bitmap = 0x05;
+            break;
+        }
+    }
+}
+
+static uint32_t __schema_find_hash(uint32_t round)
+{
+    return NULL != dp_schema_find(sg_devid[round % sg_dev_num]);
+}
+
+static uint32_t __schema_find_scan(uint32_t round)
+{
+    const char *devid = sg_devid[round % sg_dev_num];
+
+    for (uint32_t i = 0; i < sg_dev_num; i++) {
+        if (0 == strcmp(devid, sg_schema[i]->devid)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t __node_find_index(uint32_t round)
+{
+    dp_schema_t *schema = sg_schema[round % sg_dev_num];
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < BENCH_DP_NUM; i++) {
+        found += NULL != dp_node_find(schema, sg_dps[i].id);
+    }
+    return found;
+}
+
+static uint32_t __node_find_scan(uint32_t round)
+{
+    dp_schema_t *schema = sg_schema[round % sg_dev_num];
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < BENCH_DP_NUM; i++) {
+        for (uint32_t j = 0; j < schema->num; j++) {
+            if (schema->node[j].desc.id == sg_dps[i].id) {
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+static uint32_t __report_validate(uint32_t round)
+{
+    dp_rept_in_t dpin = {
+        .rept_type = T_OBJ_REPT, .flags = DP_REPT_NO_FILTER_FLAG, .dpscnt = BENCH_DP_NUM, .dps = sg_dps};
+    dp_schema_t *schema = dp_schema_find(sg_devid[round % sg_dev_num]);
+
+    memset(sg_dpvalid, 0, sizeof(dp_rept_valid_t));
+    if (NULL == schema || OPRT_OK != dp_rept_valid_check(schema, &dpin, sg_dpvalid)) {
+        return 0;
+    }
+    return sg_dpvalid->num;
+}
+
+/**
+ * @brief Runs one case for BENCH_TIME_MS and prints calls/s and items/s
+ *
+ * @param[in] name case name
+ * @param[in] cb case body, returns the items it found or validated
+ * @param[in] expect items one call must return
+ *
+ * @return none
+ */
+static void __bench_run(const char *name, BENCH_CASE_CB cb, uint32_t expect)
+{
+    uint32_t start_ms = 0, elapsed_ms = 0;
+    uint32_t calls = 0;
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    do {
+        if (cb(calls) != expect) {
+            PR_ERR("%s: call %d did not return %d", name, calls, expect);
+            return;
+        }
+        calls++;
+        if (0 == calls % 64) {
+            elapsed_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+        }
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("%-24s %9d calls/s %10d items/s", name, (uint32_t)((uint64_t)calls * 1000 / elapsed_ms),
+              (uint32_t)((uint64_t)calls * expect * 1000 / elapsed_ms));
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    char *json = NULL;
+    uint32_t i;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    json = __schema_json_make();
+    sg_dpvalid = tal_malloc(sizeof(dp_rept_valid_t) + BENCH_DP_NUM);
+    if (NULL == json || NULL == sg_dpvalid) {
+        PR_ERR("malloc failed");
+        goto __EXIT;
+    }
+
+    //! the schemas beyond DP_SCHEMA_NUM_MAX would not be registered
+    for (i = 0; i < BENCH_DEV_NUM && i < DP_SCHEMA_NUM_MAX; i++) {
+        snprintf(sg_devid[i], sizeof(sg_devid[0]), BENCH_DEVID_FMT, i);
+        if (OPRT_OK != dp_schema_create(sg_devid[i], json, &sg_schema[i])) {
+            PR_ERR("schema %d create failed", i);
+            goto __EXIT;
+        }
+        sg_dev_num++;
+    }
+    __report_make();
+
+    PR_NOTICE("------ dp schema benchmark start ------");
+    PR_NOTICE("%d sub-devices of %d DPs registered", sg_dev_num, BENCH_DP_NUM);
+
+    if (sg_dev_num) {
+        __bench_run("devid find, hash index", __schema_find_hash, 1);
+        __bench_run("devid find, scan", __schema_find_scan, 1);
+        __bench_run("dp find, id index", __node_find_index, BENCH_DP_NUM);
+        __bench_run("dp find, scan", __node_find_scan, BENCH_DP_NUM);
+        __bench_run("report validate", __report_validate, BENCH_DP_NUM);
+    }
+
+    PR_NOTICE("------ dp schema benchmark end ------");
+
+__EXIT:
+    for (i = 0; i < sg_dev_num; i++) {
+        dp_schema_delete(sg_devid[i]);
+    }
+    tal_free(sg_dpvalid);
+    tal_free(json);
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,251 @@
+/**
+ * @file example_iotdns_cache_benchmark.c
+ * @brief Compares reconnect latency with a cold and a warm IoT DNS cache.
+ *
+ * A reconnect here is what the SDK does before it can open its cloud links:
+ * resolve the cloud endpoint for a region and environment, then fetch the CA
+ * certificate of the ATOP host. Every round runs that sequence BENCH_ROUNDS
+ * times and prints the average and worst latency:
+ * - cold: the cache and its KV copies are dropped before every reconnect, so
+ *   each one waits for the IoT DNS round trips.
+ * - warm kv: only the RAM copies are dropped, as after a reboot, so entries
+ *   are read back from KV.
+ * - warm ram: the cache is kept, as for a reconnect after a Wi-Fi flap.
+ *
+ * The requests go to the register center configured in the SDK. The warm
+ * rounds make no request at all while the entries are fresh, so they do not
+ * depend on the server; the cold round shows the network cost they save.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "netmgr.h"
+#include "iotdns.h"
+#include "tuya_endpoint.h"
+#include "tuya_register_center.h"
+#include "tuya_tls.h"
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+#include "netconn_wifi.h"
+#endif
+#if defined(ENABLE_WIRED) && (ENABLE_WIRED == 1)
+#include "netconn_wired.h"
+#endif
+
+/***********************************************************
+*********************** macro define ***********************
+***********************************************************/
+#define BENCH_REGION "AY"
+#define BENCH_ENV    "pro"
+#define BENCH_ROUNDS 5
+
+#ifdef ENABLE_WIFI
+#define DEFAULT_WIFI_SSID "your-ssid-****"
+#define DEFAULT_WIFI_PSWD "your-pswd-****"
+#endif
+
+/***********************************************************
+********************** typedef define **********************
+***********************************************************/
+typedef enum {
+    BENCH_COLD,
+    BENCH_WARM_KV,
+    BENCH_WARM_RAM,
+} BENCH_MODE_E;
+
+/***********************************************************
+********************** function define *********************
+***********************************************************/
+extern int iotdns_cloud_endpoint_get(const char *region, const char *env, tuya_endpoint_t *endpoint);
+
+/**
+ * @brief Resolves the endpoint and the ATOP certificate like a reconnect does
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+static OPERATE_RET __bench_reconnect(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    tuya_endpoint_t endpoint;
+    uint8_t *cacert = NULL;
+    uint16_t cacert_len = 0;
+
+    memset(&endpoint, 0, sizeof(tuya_endpoint_t));
+    TUYA_CALL_ERR_RETURN(iotdns_cloud_endpoint_get(BENCH_REGION, BENCH_ENV, &endpoint));
+    tal_free(endpoint.cert);
+
+    rt = tuya_iotdns_query_host_certs(endpoint.atop.host, endpoint.atop.port, &cacert, &cacert_len);
+    tal_free(cacert);
+
+    return rt;
+}
+
+/**
+ * @brief Runs one round of reconnects and prints the latency
+ *
+ * @param[in] name round name
+ * @param[in] mode what is dropped from the cache before every reconnect
+ *
+ * @return none
+ */
+static void __bench_round(const char *name, BENCH_MODE_E mode)
+{
+    uint32_t start_ms, elapsed_ms, total_ms = 0, max_ms = 0;
+    uint32_t i, failed = 0;
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if (BENCH_COLD == mode) {
+            tuya_iotdns_cache_clear(TRUE);
+        } else if (BENCH_WARM_KV == mode) {
+            tuya_iotdns_cache_clear(FALSE);
+        }
+
+        start_ms = (uint32_t)tal_system_get_millisecond();
+        if (OPRT_OK != __bench_reconnect()) {
+            failed++;
+        }
+        elapsed_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+
+        total_ms += elapsed_ms;
+        if (elapsed_ms > max_ms) {
+            max_ms = elapsed_ms;
+        }
+    }
+
+    PR_NOTICE("%-8s avg %d ms max %d ms, failed %d/%d", name, total_ms / BENCH_ROUNDS, max_ms, failed, BENCH_ROUNDS);
+}
+
+/**
+ * @brief  __link_status_cb
+ *
+ * @param[in] data link status
+ * @return OPRT_OK
+ */
+static OPERATE_RET __link_status_cb(void *data)
+{
+    static netmgr_status_e status = NETMGR_LINK_DOWN;
+
+    if (status == (netmgr_status_e)data) {
+        return OPRT_OK;
+    }
+    status = (netmgr_status_e)data;
+    if (NETMGR_LINK_UP != status) {
+        return OPRT_OK;
+    }
+
+    PR_NOTICE("------ iotdns cache benchmark start ------");
+
+    __bench_round("cold", BENCH_COLD);
+    // Fill the cache once, the warm rounds start from here
+    __bench_reconnect();
+    __bench_round("warm kv", BENCH_WARM_KV);
+    __bench_round("warm ram", BENCH_WARM_RAM);
+
+    PR_NOTICE("------ iotdns cache benchmark end ------");
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return void
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    tal_kv_init(&(tal_kv_cfg_t){
+        .seed = "vmlkasdh93dlvlcy",
+        .key = "dflfuap134ddlduq",
+    });
+    tal_sw_timer_init();
+    tal_workq_init();
+    tuya_tls_init();
+    tuya_register_center_init();
+    tuya_iotdns_cache_init();
+    tal_event_subscribe(EVENT_LINK_STATUS_CHG, "iotdns_bench", __link_status_cb, SUBSCRIBE_TYPE_NORMAL);
+
+#if defined(ENABLE_LIBLWIP) && (ENABLE_LIBLWIP == 1)
+    TUYA_LwIP_Init();
+#endif
+
+    // network init
+    netmgr_type_e type = 0;
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+    type |= NETCONN_WIFI;
+#endif
+#if defined(ENABLE_WIRED) && (ENABLE_WIRED == 1)
+    type |= NETCONN_WIRED;
+#endif
+    netmgr_init(type);
+
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+    // connect wifi
+    netconn_wifi_info_t wifi_info = {0};
+    strcpy(wifi_info.ssid, DEFAULT_WIFI_SSID);
+    strcpy(wifi_info.pswd, DEFAULT_WIFI_PSWD);
+    netmgr_conn_set(NETCONN_WIFI, NETCONN_CMD_SSID_PSWD, &wifi_info);
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
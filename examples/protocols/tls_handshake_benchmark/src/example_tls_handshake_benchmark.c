@@ -0,0 +1,243 @@
+/**
+ * @file example_tls_handshake_benchmark.c
+ * @brief Compares full and resumed TLS handshakes of tuya_tls.
+ *
+ * The example connects to a TLS server repeatedly and reads the handshake
+ * counters of tuya_tls. The first round clears the session cache before every
+ * connection, so each one runs a full handshake; the second round keeps the
+ * cache, so every connection after the first resumes the cached session.
+ *
+ * On the Ubuntu platform start a local server first, for example the mbedtls
+ * test server:
+ *     ./programs/ssl/ssl_server2 server_port=4433 force_version=tls12
+ * or openssl:
+ *     openssl s_server -accept 4433 -cert cert.pem -key key.pem -tls1_2 -www
+ *
+ * The server certificate is not verified unless BENCH_CA_CERT is set to its
+ * CA in PEM format.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "netmgr.h"
+#include "tuya_tls.h"
+#include "tuya_transporter.h"
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+#include "netconn_wifi.h"
+#endif
+#if defined(ENABLE_WIRED) && (ENABLE_WIRED == 1)
+#include "netconn_wired.h"
+#endif
+
+/***********************************************************
+*********************** macro define ***********************
+***********************************************************/
+#define BENCH_HOST       "127.0.0.1"
+#define BENCH_PORT       4433
+#define BENCH_CA_CERT    NULL // PEM CA of the server, NULL skips verification
+#define BENCH_ROUNDS     10
+#define BENCH_TIMEOUT_MS 5000
+
+#ifdef ENABLE_WIFI
+#define DEFAULT_WIFI_SSID "your-ssid-****"
+#define DEFAULT_WIFI_PSWD "your-pswd-****"
+#endif
+
+/***********************************************************
+********************** variable define *********************
+***********************************************************/
+static const char *sg_ca_cert = BENCH_CA_CERT;
+
+/***********************************************************
+********************** function define *********************
+***********************************************************/
+
+/**
+ * @brief Opens and closes one TLS connection to the benchmark server
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+static OPERATE_RET __bench_connect(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    tuya_tls_config_t config = {
+        .mode = TUYA_TLS_SERVER_CERT_MODE,
+        .verify = (sg_ca_cert != NULL),
+        .ca_cert = (char *)sg_ca_cert,
+        .ca_cert_size = sg_ca_cert ? strlen(sg_ca_cert) + 1 : 0,
+    };
+
+    tuya_transporter_t transporter = tuya_transporter_create(TRANSPORT_TYPE_TLS, NULL);
+    if (NULL == transporter) {
+        return OPRT_MALLOC_FAILED;
+    }
+
+    tuya_transporter_ctrl(transporter, TUYA_TRANSPORTER_SET_TLS_CONFIG, &config);
+    rt = tuya_transporter_connect(transporter, BENCH_HOST, BENCH_PORT, BENCH_TIMEOUT_MS);
+    tuya_transporter_close(transporter);
+    tuya_transporter_destroy(transporter);
+
+    return rt;
+}
+
+/**
+ * @brief Runs one round of connections and prints the handshake counters
+ *
+ * @param[in] name round name
+ * @param[in] resume keep the session cache between connections
+ *
+ * @return none
+ */
+static void __bench_round(const char *name, BOOL_T resume)
+{
+    tuya_tls_stat_t stat = {0};
+    uint32_t i;
+
+    tuya_tls_cache_clear();
+    tuya_tls_stat_reset();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        if (!resume) {
+            tuya_tls_cache_clear();
+        }
+        if (OPRT_OK != __bench_connect()) {
+            PR_ERR("%s connect %d to %s:%d failed", name, i, BENCH_HOST, BENCH_PORT);
+        }
+    }
+    tuya_tls_stat_get(&stat);
+
+    PR_NOTICE("%-8s full %d avg %d ms max %d ms, resumed %d avg %d ms max %d ms, failed %d, ca hit/miss %d/%d", name,
+              stat.full_cnt, stat.full_cnt ? stat.full_ms / stat.full_cnt : 0, stat.full_max_ms, stat.resume_cnt,
+              stat.resume_cnt ? stat.resume_ms / stat.resume_cnt : 0, stat.resume_max_ms, stat.fail_cnt, stat.ca_hit,
+              stat.ca_miss);
+}
+
+/**
+ * @brief  __link_status_cb
+ *
+ * @param[in] data link status
+ * @return OPRT_OK
+ */
+static OPERATE_RET __link_status_cb(void *data)
+{
+    static netmgr_status_e status = NETMGR_LINK_DOWN;
+
+    if (status == (netmgr_status_e)data) {
+        return OPRT_OK;
+    }
+    status = (netmgr_status_e)data;
+    if (NETMGR_LINK_UP != status) {
+        return OPRT_OK;
+    }
+
+    PR_NOTICE("------ tls handshake benchmark start ------");
+
+    __bench_round("full", FALSE);
+    __bench_round("resumed", TRUE);
+
+    PR_NOTICE("------ tls handshake benchmark end ------");
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief user_main
+ *
+ * @return void
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    tal_kv_init(&(tal_kv_cfg_t){
+        .seed = "vmlkasdh93dlvlcy",
+        .key = "dflfuap134ddlduq",
+    });
+    tal_sw_timer_init();
+    tal_workq_init();
+    tuya_tls_init();
+    tal_event_subscribe(EVENT_LINK_STATUS_CHG, "tls_bench", __link_status_cb, SUBSCRIBE_TYPE_NORMAL);
+
+#if defined(ENABLE_LIBLWIP) && (ENABLE_LIBLWIP == 1)
+    TUYA_LwIP_Init();
+#endif
+
+    // network init
+    netmgr_type_e type = 0;
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+    type |= NETCONN_WIFI;
+#endif
+#if defined(ENABLE_WIRED) && (ENABLE_WIRED == 1)
+    type |= NETCONN_WIRED;
+#endif
+    netmgr_init(type);
+
+#if defined(ENABLE_WIFI) && (ENABLE_WIFI == 1)
+    // connect wifi
+    netconn_wifi_info_t wifi_info = {0};
+    strcpy(wifi_info.ssid, DEFAULT_WIFI_SSID);
+    strcpy(wifi_info.pswd, DEFAULT_WIFI_PSWD);
+    netmgr_conn_set(NETCONN_WIFI, NETCONN_CMD_SSID_PSWD, &wifi_info);
+#endif
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
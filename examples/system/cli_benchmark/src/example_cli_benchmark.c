@@ -0,0 +1,325 @@
+/**
+ * @file example_cli_benchmark.c
+ * @brief Feeds thousands of scripted commands to the CLI through a pseudo
+ * UART, interactive and in batch mode.
+ *
+ * The CLI is started with tal_cli_init_with_io on an in-memory stream: reads
+ * take the bytes of the script handed over by the example, writes are
+ * counted. BENCH_CMD_NUM commands are registered in tables of
+ * BENCH_TABLE_CMD_NUM, so some end up in the static tables of the CLI and the
+ * rest in its dynamic list. Every command checks the arguments it gets
+ * against the ones the script gave it.
+ *
+ * The same script, with extra spaces and empty lines, is run once as typed
+ * on a terminal and once in batch mode, and the example prints the commands
+ * per second and the bytes and writes sent back for each. It then compares
+ * the lookup of a name in the command index with a scan of the tables.
+ * Completion, batch parsing and the kept execution times are checked by
+ * src/tal_cli/ut/test_tal_cli.cpp.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tal_cli.h"
+#include "tkl_output.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_CMD_NUM       200
+#define BENCH_TABLE_CMD_NUM 20
+#define BENCH_LINES         20000
+#define BENCH_SCRIPT_SIZE   (BENCH_LINES * 32)
+#define BENCH_LOOKUPS       200000
+#define BENCH_DONE_TIMEOUT  10000
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    const char *data;
+    uint32_t len;
+    uint32_t pos;
+    SEM_HANDLE ready;
+    uint32_t out_bytes;
+    uint32_t out_writes;
+} BENCH_UART_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static BENCH_UART_T sg_uart;
+static SEM_HANDLE sg_done;
+
+static char sg_name[BENCH_CMD_NUM][12];
+static cli_cmd_t sg_cmd[BENCH_CMD_NUM];
+static uint32_t sg_calls[BENCH_CMD_NUM];
+static uint32_t sg_bad_argv;
+
+static char sg_script[BENCH_SCRIPT_SIZE];
+static uint32_t sg_script_len;
+static uint32_t sg_script_calls[BENCH_CMD_NUM];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static int __uart_read(uint8_t *data, uint32_t len)
+{
+    uint32_t n;
+
+    while (sg_uart.pos == sg_uart.len) {
+        tal_semaphore_wait(sg_uart.ready, SEM_WAIT_FOREVER);
+    }
+
+    n = sg_uart.len - sg_uart.pos;
+    n = n > len ? len : n;
+    memcpy(data, sg_uart.data + sg_uart.pos, n);
+    sg_uart.pos += n;
+
+    return n;
+}
+
+static int __uart_write(const uint8_t *data, uint32_t len)
+{
+    sg_uart.out_bytes += len;
+    sg_uart.out_writes++;
+
+    return len;
+}
+
+static const cli_io_t sg_io = {
+    .read = __uart_read,
+    .write = __uart_write,
+};
+
+/**
+ * @brief hand a script to the CLI and wait for its last line, "bench_done"
+ */
+static OPERATE_RET __uart_run(const char *script, uint32_t len)
+{
+    sg_uart.data = script;
+    sg_uart.pos = 0;
+    sg_uart.len = len;
+    tal_semaphore_post(sg_uart.ready);
+
+    return tal_semaphore_wait(sg_done, BENCH_DONE_TIMEOUT);
+}
+
+/**
+ * @brief the commands are called "cmd_<i> <i> <i * 7>"
+ */
+static void __bench_cmd(int argc, char *argv[])
+{
+    int i;
+
+    if (3 != argc || 0 != strncmp(argv[0], "cmd_", 4)) {
+        sg_bad_argv++;
+        return;
+    }
+    i = atoi(argv[0] + 4);
+    if (i < 0 || i >= BENCH_CMD_NUM || atoi(argv[1]) != i || atoi(argv[2]) != i * 7) {
+        sg_bad_argv++;
+        return;
+    }
+    sg_calls[i]++;
+}
+
+static void __bench_done(int argc, char *argv[])
+{
+    tal_semaphore_post(sg_done);
+}
+
+static const cli_cmd_t sg_done_cmd[] = {
+    {
+        .name = "bench_done",
+        .help = "end of a benchmark script",
+        .func = __bench_done,
+    },
+};
+
+static void __bench_register(void)
+{
+    int i;
+
+    for (i = 0; i < BENCH_CMD_NUM; i++) {
+        snprintf(sg_name[i], sizeof(sg_name[i]), "cmd_%03d", i);
+        sg_cmd[i].name = sg_name[i];
+        sg_cmd[i].help = "benchmark command";
+        sg_cmd[i].func = __bench_cmd;
+    }
+    for (i = 0; i < BENCH_CMD_NUM; i += BENCH_TABLE_CMD_NUM) {
+        tal_cli_cmd_register(&sg_cmd[i], BENCH_TABLE_CMD_NUM);
+    }
+    tal_cli_cmd_register(sg_done_cmd, CNTSOF(sg_done_cmd));
+}
+
+static void __script_build(void)
+{
+    static const char *space[] = {" ", "  ", " \t "};
+    uint32_t seed = 1;
+    int i, cmd;
+
+    sg_script_len = 0;
+    for (i = 0; i < BENCH_LINES; i++) {
+        seed = seed * 1103515245 + 12345;
+        cmd = (seed >> 16) % BENCH_CMD_NUM;
+        sg_script_calls[cmd]++;
+        sg_script_len += sprintf(sg_script + sg_script_len, "%scmd_%03d%s%d %d\r\n", (i % 5) ? "" : " ", cmd,
+                                 space[i % 3], cmd, cmd * 7);
+        if (0 == i % 50) {
+            sg_script[sg_script_len++] = '\n';
+        }
+    }
+    sg_script_len += sprintf(sg_script + sg_script_len, "bench_done\r");
+}
+
+static void __script_run(const char *mode)
+{
+    SYS_TIME_T start_ms, ms;
+    uint32_t missing = 0;
+    int i;
+
+    memset(sg_calls, 0, sizeof(sg_calls));
+    sg_bad_argv = 0;
+    sg_uart.out_bytes = 0;
+    sg_uart.out_writes = 0;
+
+    start_ms = tal_system_get_millisecond();
+    if (OPRT_OK != __uart_run(sg_script, sg_script_len)) {
+        PR_ERR("%s: script did not finish", mode);
+        return;
+    }
+    ms = tal_system_get_millisecond() - start_ms;
+
+    for (i = 0; i < BENCH_CMD_NUM; i++) {
+        missing += sg_calls[i] != sg_script_calls[i];
+    }
+    PR_NOTICE("%-11s: %d commands in %d ms, %d cmd/s, %d bytes in %d writes sent back, %d bad argv, %d miscounted",
+              mode, BENCH_LINES, (int)ms, ms ? (int)(BENCH_LINES * 1000ULL / ms) : 0, sg_uart.out_bytes,
+              sg_uart.out_writes, sg_bad_argv, missing);
+}
+
+static void __bench_lookup(void)
+{
+    cli_cmd_stat_t stat;
+    SYS_TIME_T start_ms, scan_ms, hash_ms;
+    uint32_t seed = 7, found = 0;
+    int i, j;
+
+    start_ms = tal_system_get_millisecond();
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        for (j = 0; j < BENCH_CMD_NUM; j++) {
+            if (0 == strcmp(sg_cmd[j].name, sg_name[(seed >> 16) % BENCH_CMD_NUM])) {
+                found++;
+                break;
+            }
+        }
+    }
+    scan_ms = tal_system_get_millisecond() - start_ms;
+
+    start_ms = tal_system_get_millisecond();
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        found += OPRT_OK == tal_cli_cmd_stat_get(sg_name[(seed >> 16) % BENCH_CMD_NUM], &stat);
+    }
+    hash_ms = tal_system_get_millisecond() - start_ms;
+
+    PR_NOTICE("lookup of %d names among %d: scan %d ns, index %d ns (%d found)", BENCH_LOOKUPS, BENCH_CMD_NUM,
+              (int)(scan_ms * 1000000ULL / BENCH_LOOKUPS), (int)(hash_ms * 1000000ULL / BENCH_LOOKUPS), found);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return void
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+
+    PR_NOTICE("------ cli benchmark start ------");
+
+    tal_semaphore_create_init(&sg_uart.ready, 0, 1);
+    tal_semaphore_create_init(&sg_done, 0, 1);
+    __bench_register();
+    if (OPRT_OK != tal_cli_init_with_io(&sg_io)) {
+        PR_ERR("cli init failed");
+        return;
+    }
+    __script_build();
+
+    __script_run("interactive");
+    tal_cli_batch_mode(1);
+    __script_run("batch");
+    tal_cli_batch_mode(0);
+
+    __bench_lookup();
+
+    PR_NOTICE("------ cli benchmark end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
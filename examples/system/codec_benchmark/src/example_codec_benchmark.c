@@ -0,0 +1,223 @@
+/**
+ * @file example_codec_benchmark.c
+ * @brief Measures the base64 and hex codec of text_codec.c.
+ *
+ * The example reports the throughput of the codec, of mbedtls base64 and of
+ * the former byte-wise hex loops of mix_method.c on BENCH_BUF_LEN byte
+ * buffers. The results of the codec are checked by the unit tests of
+ * src/common/ut.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "mix_method.h"
+#include "text_codec.h"
+#include "mbedtls/base64.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_BUF_LEN (64 * 1024)
+#define BENCH_TIME_MS 500 // run each case for about this long
+
+#define BENCH_TEXT_LEN (TUYA_BASE64_ENCODE_LEN(BENCH_BUF_LEN) + 1)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef void (*BENCH_CASE_CB)(const uint8_t *bin, char *text, uint8_t *out);
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static uint8_t *sg_bin;
+static char *sg_text;
+static uint8_t *sg_out;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void __hex_encode_bytewise(const uint8_t *bin, char *text, uint8_t *out)
+{
+    uint8_t ddh, ddl;
+    int i;
+
+    //! the former hex2str loop
+    for (i = 0; i < BENCH_BUF_LEN; i++) {
+        ddh = 48 + bin[i] / 16;
+        ddl = 48 + bin[i] % 16;
+        if (ddh > 57) {
+            ddh = ddh + 7;
+        }
+        if (ddl > 57) {
+            ddl = ddl + 7;
+        }
+        text[i * 2] = ddh;
+        text[i * 2 + 1] = ddl;
+    }
+    text[BENCH_BUF_LEN * 2] = '\0';
+}
+
+static void __hex_decode_bytewise(const uint8_t *bin, char *text, uint8_t *out)
+{
+    int i;
+
+    //! the former ascs2hex loop
+    for (i = 0; i < BENCH_BUF_LEN * 2; i += 2) {
+        out[i / 2] = (asc2hex(text[i]) << 4) + asc2hex(text[i + 1]);
+    }
+}
+
+static void __hex_encode_codec(const uint8_t *bin, char *text, uint8_t *out)
+{
+    tuya_hex_encode_buf(bin, BENCH_BUF_LEN, text, TRUE);
+}
+
+static void __hex_decode_codec(const uint8_t *bin, char *text, uint8_t *out)
+{
+    tuya_hex_decode_buf(text, BENCH_BUF_LEN * 2, out);
+}
+
+static void __b64_encode_mbedtls(const uint8_t *bin, char *text, uint8_t *out)
+{
+    size_t olen;
+
+    mbedtls_base64_encode((uint8_t *)text, BENCH_TEXT_LEN, &olen, bin, BENCH_BUF_LEN);
+}
+
+static void __b64_decode_mbedtls(const uint8_t *bin, char *text, uint8_t *out)
+{
+    size_t olen;
+
+    mbedtls_base64_decode(out, BENCH_BUF_LEN, &olen, (const uint8_t *)text, TUYA_BASE64_ENCODE_LEN(BENCH_BUF_LEN));
+}
+
+static void __b64_encode_codec(const uint8_t *bin, char *text, uint8_t *out)
+{
+    tuya_base64_encode_buf(bin, BENCH_BUF_LEN, text);
+}
+
+static void __b64_decode_codec(const uint8_t *bin, char *text, uint8_t *out)
+{
+    tuya_base64_decode_buf(text, TUYA_BASE64_ENCODE_LEN(BENCH_BUF_LEN), out);
+}
+
+static void __bench_speed(const char *name, BENCH_CASE_CB cb)
+{
+    SYS_TIME_T start_ms = tal_system_get_millisecond(), elapsed_ms = 0;
+    uint32_t rounds = 0;
+
+    do {
+        cb(sg_bin, sg_text, sg_out);
+        rounds++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("%-24s %8d KB/s", name, (uint32_t)((uint64_t)rounds * BENCH_BUF_LEN / elapsed_ms * 1000 / 1024));
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t i;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    sg_bin = tal_malloc(BENCH_BUF_LEN);
+    sg_text = tal_malloc(2 * BENCH_BUF_LEN + 1);
+    sg_out = tal_malloc(BENCH_BUF_LEN);
+    if (NULL == sg_bin || NULL == sg_text || NULL == sg_out) {
+        PR_ERR("malloc failed");
+        goto __exit;
+    }
+    for (i = 0; i < BENCH_BUF_LEN; i++) {
+        sg_bin[i] = (uint8_t)((i * 2654435761u) >> 13);
+    }
+
+    PR_NOTICE("------ codec benchmark start ------");
+
+    tuya_base64_encode_buf(sg_bin, BENCH_BUF_LEN, sg_text);
+    __bench_speed("base64 encode mbedtls", __b64_encode_mbedtls);
+    __bench_speed("base64 encode codec", __b64_encode_codec);
+    __bench_speed("base64 decode mbedtls", __b64_decode_mbedtls);
+    __bench_speed("base64 decode codec", __b64_decode_codec);
+    tuya_hex_encode_buf(sg_bin, BENCH_BUF_LEN, sg_text, TRUE);
+    __bench_speed("hex encode byte-wise", __hex_encode_bytewise);
+    __bench_speed("hex encode codec", __hex_encode_codec);
+    __bench_speed("hex decode byte-wise", __hex_decode_bytewise);
+    __bench_speed("hex decode codec", __hex_decode_codec);
+
+    PR_NOTICE("------ codec benchmark end ------");
+
+__exit:
+    tal_free(sg_bin);
+    tal_free(sg_text);
+    tal_free(sg_out);
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
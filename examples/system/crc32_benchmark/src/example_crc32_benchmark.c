@@ -0,0 +1,159 @@
+/**
+ * @file example_crc32_benchmark.c
+ * @brief Measures the CRC-32 engine of crc32i.c.
+ *
+ * The example reports the throughput of hash_crc32i_total() and of the former
+ * byte-at-a-time table loop on BENCH_BUF_LEN byte buffers, so the gain of
+ * slice-by-8 (or of the ARMv8 CRC instructions, when the build targets them)
+ * on OTA images and file transfers can be read directly. The results of the
+ * engine are checked by the unit tests of src/common/ut.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "crc32i.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_BUF_LEN   (64 * 1024)
+#define BENCH_TIME_MS   1000 // run each case for about this long
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static uint32_t sg_byte_table[256];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static uint32_t __crc32_bytewise(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc = sg_byte_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+static void __bench_speed(const char *name, uint32_t (*crc)(const uint8_t *, uint32_t), const uint8_t *buf)
+{
+    SYS_TIME_T start_ms = tal_system_get_millisecond(), elapsed_ms = 0;
+    uint32_t rounds = 0;
+    volatile uint32_t sink = 0;
+
+    do {
+        sink ^= crc(buf, BENCH_BUF_LEN);
+        rounds++;
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("%-12s %6d KB/s", name, (uint32_t)((uint64_t)rounds * BENCH_BUF_LEN / elapsed_ms * 1000 / 1024));
+}
+
+static uint32_t __crc32_engine(const uint8_t *data, uint32_t len)
+{
+    return hash_crc32i_total(data, len);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint8_t *buf = NULL;
+    uint32_t i, bit, crc;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    buf = tal_malloc(BENCH_BUF_LEN);
+    if (NULL == buf) {
+        PR_ERR("malloc %d failed", BENCH_BUF_LEN);
+        return;
+    }
+    for (i = 0; i < BENCH_BUF_LEN; i++) {
+        buf[i] = (uint8_t)((i * 2654435761u) >> 13);
+    }
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        sg_byte_table[i] = crc;
+    }
+
+    PR_NOTICE("------ crc32 benchmark start ------");
+
+    __bench_speed("byte-wise", __crc32_bytewise, buf);
+    __bench_speed("crc32i", __crc32_engine, buf);
+
+    PR_NOTICE("------ crc32 benchmark end ------");
+
+    tal_free(buf);
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
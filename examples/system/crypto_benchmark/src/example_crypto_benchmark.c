@@ -0,0 +1,230 @@
+/**
+ * @file example_crypto_benchmark.c
+ * @brief Measures the throughput of the tal_security AES and HMAC APIs.
+ *
+ * This example compares the one-shot helpers, which create a context and run the
+ * key schedule on every call, with the keyed contexts that keep the expanded key
+ * for a whole session. For each message size it reports calls per second and
+ * throughput in KB/s, so the per-call overhead on short LAN/MQTT frames and the
+ * raw cipher speed on large buffers can both be read from the same table.
+ *
+ * Cases measured:
+ * - AES-128-CBC: tal_aes128_cbc_encode_raw() vs tal_aes_key_crypt_cbc().
+ * - AES-128-CBC + PKCS7: tal_aes128_cbc_encode() (allocates the output) vs
+ *   tal_aes_key_pkcs7_encode() into a caller buffer.
+ * - HMAC-SHA256: tal_sha256_mac() vs tal_sha256_mac_reset() on a started context.
+ *
+ * That both sides of each case produce the same output is checked by the unit
+ * tests in src/tal_security/ut.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_TIME_MS   1000 // run each case for about this long
+#define BENCH_CHECK_CNT 16   // iterations between two clock reads
+#define BENCH_MAX_LEN   4096
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef OPERATE_RET (*BENCH_CASE_CB)(uint32_t len);
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const uint32_t sg_bench_len[] = {16, 64, 256, 1024, BENCH_MAX_LEN};
+
+static uint8_t sg_key[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                             0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static uint8_t sg_iv[16];
+static uint8_t sg_input[BENCH_MAX_LEN];
+static uint8_t sg_output[BENCH_MAX_LEN + 16];
+
+static tal_aes_key_context_t sg_aes_key;
+static tal_hash_mac_context_t sg_hmac;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static OPERATE_RET __aes_cbc_raw(uint32_t len)
+{
+    return tal_aes128_cbc_encode_raw(sg_input, len, sg_key, sg_iv, sg_output);
+}
+
+static OPERATE_RET __aes_cbc_keyed(uint32_t len)
+{
+    return tal_aes_key_crypt_cbc(&sg_aes_key, SYMMETRY_ENCRYPT, len, sg_iv, sg_input, sg_output);
+}
+
+static OPERATE_RET __aes_cbc_pkcs7_alloc(uint32_t len)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t *ec_data = NULL;
+    uint32_t ec_len = 0;
+
+    rt = tal_aes128_cbc_encode(sg_input, len, sg_key, sg_iv, &ec_data, &ec_len);
+    if (OPRT_OK == rt) {
+        tal_aes_free_data(ec_data);
+    }
+
+    return rt;
+}
+
+static OPERATE_RET __aes_cbc_pkcs7_keyed(uint32_t len)
+{
+    uint32_t ec_len = 0;
+
+    return tal_aes_key_pkcs7_encode(&sg_aes_key, sg_iv, sg_input, len, sg_output, sizeof(sg_output), &ec_len);
+}
+
+static OPERATE_RET __hmac_oneshot(uint32_t len)
+{
+    return tal_sha256_mac(sg_key, sizeof(sg_key), sg_input, len, sg_output);
+}
+
+static OPERATE_RET __hmac_keyed(uint32_t len)
+{
+    OPERATE_RET rt = OPRT_OK;
+
+    TUYA_CALL_ERR_RETURN(tal_sha256_mac_reset(&sg_hmac));
+    TUYA_CALL_ERR_RETURN(tal_sha256_mac_update(&sg_hmac, sg_input, len));
+
+    return tal_sha256_mac_finish(&sg_hmac, sg_output);
+}
+
+/**
+ * @brief Runs one case for BENCH_TIME_MS and prints calls/s and KB/s
+ *
+ * @param[in] name case name
+ * @param[in] cb case body
+ * @param[in] len message length
+ *
+ * @return none
+ */
+static void __bench_run(const char *name, BENCH_CASE_CB cb, uint32_t len)
+{
+    uint32_t start_ms = 0, elapsed_ms = 0;
+    uint32_t calls = 0, i;
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    do {
+        for (i = 0; i < BENCH_CHECK_CNT; i++) {
+            if (OPRT_OK != cb(len)) {
+                PR_ERR("%s len %d failed", name, len);
+                return;
+            }
+        }
+        calls += BENCH_CHECK_CNT;
+        elapsed_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+    } while (elapsed_ms < BENCH_TIME_MS);
+
+    PR_NOTICE("%-22s %5d B %9d calls/s %9d KB/s", name, len, (uint32_t)((uint64_t)calls * 1000 / elapsed_ms),
+              (uint32_t)((uint64_t)calls * len * 1000 / 1024 / elapsed_ms));
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    OPERATE_RET rt = OPRT_OK;
+    uint32_t i;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    for (i = 0; i < sizeof(sg_input); i++) {
+        sg_input[i] = (uint8_t)i;
+    }
+
+    /* session contexts, keyed once */
+    TUYA_CALL_ERR_GOTO(tal_aes_key_init(&sg_aes_key), __EXIT);
+    TUYA_CALL_ERR_GOTO(tal_aes_key_setkey(&sg_aes_key, sg_key, 128), __EXIT);
+    TUYA_CALL_ERR_GOTO(tal_sha256_mac_create_init(&sg_hmac), __EXIT);
+    TUYA_CALL_ERR_GOTO(tal_sha256_mac_starts(&sg_hmac, sg_key, sizeof(sg_key)), __EXIT);
+
+    PR_NOTICE("------ crypto benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_bench_len); i++) {
+        __bench_run("aes128-cbc oneshot", __aes_cbc_raw, sg_bench_len[i]);
+        __bench_run("aes128-cbc keyed", __aes_cbc_keyed, sg_bench_len[i]);
+        __bench_run("aes128-cbc-pkcs7 alloc", __aes_cbc_pkcs7_alloc, sg_bench_len[i]);
+        __bench_run("aes128-cbc-pkcs7 keyed", __aes_cbc_pkcs7_keyed, sg_bench_len[i]);
+        __bench_run("hmac-sha256 oneshot", __hmac_oneshot, sg_bench_len[i]);
+        __bench_run("hmac-sha256 keyed", __hmac_keyed, sg_bench_len[i]);
+    }
+
+    PR_NOTICE("------ crypto benchmark end ------");
+
+__EXIT:
+    tal_sha256_mac_free(&sg_hmac);
+    tal_aes_key_free(&sg_aes_key);
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
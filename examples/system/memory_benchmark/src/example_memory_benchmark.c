@@ -0,0 +1,239 @@
+/**
+ * @file example_memory_benchmark.c
+ * @brief Stress test comparing tal_malloc with the raw TKL heap.
+ *
+ * The workload mimics a long-running device: a table of slots is churned with
+ * random small allocations (cJSON nodes, queue items, packet buffers) while a
+ * fraction of the blocks is kept alive for a long time. The same sequence runs
+ * once on tkl_system_malloc/free and once on tal_malloc/free, and the example
+ * reports the average latency of an allocate/free pair for each.
+ *
+ * After the churn the short-lived blocks are freed and the largest block that
+ * can still be allocated from each heap is probed, which shows how much the
+ * surviving long-lived blocks fragment the heap. Build it with
+ * ENABLE_TAL_MEMORY_POOL and/or ENABLE_TAL_MEMORY_PROFILE to compare the pool
+ * layer against the raw heap; with both disabled tal_malloc is the raw heap.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+#include "tkl_memory.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_SLOT_NUM     1024   // blocks alive at the same time
+#define BENCH_ROUNDS       200000 // allocate/free pairs per run
+#define BENCH_KEEP_PERCENT 5      // blocks that survive the churn
+#define BENCH_SMALL_MAX    256    // most requests are up to this size
+#define BENCH_LARGE_MAX    2048   // one request in 16 is up to this size
+#define BENCH_PROBE_MAX    (1024 * 1024)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    const char *name;
+    void *(*alloc)(size_t size);
+    void (*free)(void *ptr);
+} BENCH_HEAP_T;
+
+typedef struct {
+    void *ptr;
+    uint8_t keep;
+} BENCH_SLOT_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static BENCH_SLOT_T sg_slot[BENCH_SLOT_NUM];
+static uint32_t sg_seed;
+
+static const BENCH_HEAP_T sg_heap[] = {
+    {"tkl heap", tkl_system_malloc, tkl_system_free},
+    {"tal_malloc", tal_malloc, tal_free},
+};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static uint32_t __bench_rand(void)
+{
+    sg_seed = sg_seed * 1103515245 + 12345;
+    return sg_seed >> 8;
+}
+
+static size_t __bench_size(void)
+{
+    if ((__bench_rand() & 0x0F) == 0) {
+        return 1 + __bench_rand() % BENCH_LARGE_MAX;
+    }
+
+    return 1 + __bench_rand() % BENCH_SMALL_MAX;
+}
+
+/**
+ * @brief Largest block that can be allocated right now, found by bisection
+ *
+ * @param[in] heap heap under test
+ *
+ * @return size in bytes
+ */
+static uint32_t __bench_probe_largest(const BENCH_HEAP_T *heap)
+{
+    uint32_t lo = 0, hi = BENCH_PROBE_MAX;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        void *ptr = heap->alloc(mid);
+        if (ptr) {
+            heap->free(ptr);
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * @brief Churns the slot table on one heap and prints latency and fragmentation
+ *
+ * @param[in] heap heap under test
+ *
+ * @return none
+ */
+static void __bench_run(const BENCH_HEAP_T *heap)
+{
+    uint32_t start_ms, elapsed_ms, i;
+    int free_before, free_after;
+    uint32_t kept = 0;
+
+    memset(sg_slot, 0, sizeof(sg_slot));
+    sg_seed = 0x5EED;
+    free_before = tal_system_get_free_heap_size();
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        BENCH_SLOT_T *slot = &sg_slot[__bench_rand() % BENCH_SLOT_NUM];
+
+        if (slot->keep) {
+            continue;
+        }
+        if (slot->ptr) {
+            heap->free(slot->ptr);
+        }
+        slot->ptr = heap->alloc(__bench_size());
+        if (slot->ptr && (__bench_rand() % 100) < BENCH_KEEP_PERCENT) {
+            slot->keep = TRUE;
+        }
+    }
+    elapsed_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+
+    // Drop the short-lived blocks, the kept ones pin the heap
+    for (i = 0; i < BENCH_SLOT_NUM; i++) {
+        if (sg_slot[i].ptr && !sg_slot[i].keep) {
+            heap->free(sg_slot[i].ptr);
+            sg_slot[i].ptr = NULL;
+        }
+        kept += sg_slot[i].keep;
+    }
+
+    free_after = tal_system_get_free_heap_size();
+    PR_NOTICE("%-10s %6d ns/pair, kept %d blocks, free heap %d -> %d, largest block %d", heap->name,
+              (uint32_t)((uint64_t)elapsed_ms * 1000000 / BENCH_ROUNDS), kept, free_before, free_after,
+              __bench_probe_largest(heap));
+
+    for (i = 0; i < BENCH_SLOT_NUM; i++) {
+        if (sg_slot[i].ptr) {
+            heap->free(sg_slot[i].ptr);
+            sg_slot[i].ptr = NULL;
+        }
+    }
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    uint32_t i;
+
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    PR_NOTICE("------ memory benchmark start ------");
+
+    for (i = 0; i < CNTSOF(sg_heap); i++) {
+        __bench_run(&sg_heap[i]);
+    }
+
+    tal_memory_profile_dump(TRUE);
+
+    PR_NOTICE("------ memory benchmark end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,461 @@
+/**
+ * @file example_memory_budget.c
+ * @brief Records the large buffers of a camera device session and replays them
+ * on a split heap, with and without memory budgets.
+ *
+ * The session mimics a camera device with a screen: display frame buffers and
+ * camera frames in PSRAM, LVGL draw buffers in DMA capable RAM, audio rings in
+ * internal RAM, and the RTP buffers of P2P viewers that come and go, in PSRAM
+ * with fallback to internal RAM. It runs once on the normal heap with
+ * tal_mem_budget_set_trace recording every buffer as a line of text.
+ *
+ * The recorded trace is then replayed on a simulated heap of
+ * BENCH_SRAM_SIZE bytes of internal RAM and BENCH_PSRAM_SIZE bytes of PSRAM,
+ * set with tal_mem_budget_set_heap. The simulation only counts bytes, it does
+ * not model fragmentation. Without limits the viewers take the PSRAM the
+ * camera needs to restart and spill into internal RAM; with limits their
+ * requests past the budget are refused and the other subsystems keep working.
+ * The example also prints the cost of a budgeted allocate/free pair against
+ * tal_malloc/tal_free.
+ *
+ * The budgets and limits here are those of the simulated session, including
+ * the 3 MB for 4 viewers; the SDK's own budgets ("p2p_media", "lv_draw_buf",
+ * ...) are unlimited unless their *_MEM_BUDGET option is set. The same replay
+ * is checked by src/tal_system/ut/test_mem_budget.cpp.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_SRAM_SIZE  (512 * 1024)
+#define BENCH_PSRAM_SIZE (6 * 1024 * 1024)
+
+#define BENCH_ROUNDS      60  // session rounds, viewers join and leave every round
+#define BENCH_VIEWER_MAX  8   // viewers at the same time
+#define BENCH_VIEWER_BUFS 3   // RTP buffers per viewer
+#define BENCH_CAM_RAW     2   // raw camera frames
+#define BENCH_CAM_ENC     8   // encoded camera frames
+#define BENCH_TRACE_SIZE  (256 * 1024)
+#define BENCH_LIVE_MAX    256 // buffers live at the same time during replay
+#define BENCH_PAIRS       200000
+
+#define BENCH_DISP_FB_SIZE  (480 * 272 * 2)
+#define BENCH_DRAW_BUF_SIZE (BENCH_DISP_FB_SIZE / 10)
+#define BENCH_AUDIO_SIZE    (32 * 1024)
+#define BENCH_CAM_RAW_SIZE  (640 * 480 * 2)
+#define BENCH_CAM_ENC_SIZE  (BENCH_CAM_RAW_SIZE / 5)
+#define BENCH_RTP_SIZE      (256 * 1024)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    const char *name;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t peak;
+} BENCH_REGION_T;
+
+typedef struct {
+    const void *old_ptr; // pointer in the recording
+    void *ptr;           // pointer in the replay, NULL if the request failed
+} BENCH_LIVE_T;
+
+typedef struct {
+    void *disp_fb[2];
+    void *draw_buf[2];
+    void *audio[2];
+    void *cam_raw[BENCH_CAM_RAW];
+    void *cam_enc[BENCH_CAM_ENC];
+    void *rtp[BENCH_VIEWER_MAX][BENCH_VIEWER_BUFS];
+} BENCH_SESSION_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+// the budgets of the subsystems, the limits are set per replay
+static TAL_MEM_BUDGET_DEFINE(sg_disp_fb, "disp_fb", 0, TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
+static TAL_MEM_BUDGET_DEFINE(sg_lvgl_draw, "lvgl_draw", 0, TAL_MEM_PLACE_DMA, 0);
+static TAL_MEM_BUDGET_DEFINE(sg_ai_audio, "ai_audio", 0, TAL_MEM_PLACE_SRAM, 0);
+static TAL_MEM_BUDGET_DEFINE(sg_camera, "sim_camera", 0, TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
+static TAL_MEM_BUDGET_DEFINE(sg_p2p_rtp, "p2p_rtp", 0, TAL_MEM_PLACE_PSRAM, 0);
+
+static TAL_MEM_BUDGET_T *sg_budget[] = {&sg_disp_fb, &sg_lvgl_draw, &sg_ai_audio, &sg_camera, &sg_p2p_rtp};
+
+// limits of the second replay
+static const uint32_t sg_budget_limit[] = {
+    2 * BENCH_DISP_FB_SIZE,
+    64 * 1024,
+    96 * 1024,
+    BENCH_CAM_RAW * BENCH_CAM_RAW_SIZE + BENCH_CAM_ENC * BENCH_CAM_ENC_SIZE,
+    4 * BENCH_VIEWER_BUFS * BENCH_RTP_SIZE,
+};
+
+static BENCH_REGION_T sg_region[TAL_MEM_PLACE_NUM] = {
+    {"sram", BENCH_SRAM_SIZE},
+    {"psram", BENCH_PSRAM_SIZE},
+    {"dma", 0}, // in sram
+};
+
+static BENCH_SESSION_T sg_session;
+static BENCH_LIVE_T sg_live[BENCH_LIVE_MAX];
+static char sg_trace[BENCH_TRACE_SIZE];
+static uint32_t sg_trace_len;
+static uint32_t sg_trace_lost;
+static uint32_t sg_seed;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static uint32_t __bench_rand(void)
+{
+    sg_seed = sg_seed * 1103515245 + 12345;
+    return sg_seed >> 8;
+}
+
+/* the simulated split heap, DMA buffers are in internal RAM */
+static BENCH_REGION_T *__sim_region(TAL_MEM_PLACE_E place)
+{
+    return &sg_region[(TAL_MEM_PLACE_DMA == place) ? TAL_MEM_PLACE_SRAM : place];
+}
+
+static void *__sim_malloc(TAL_MEM_PLACE_E place, size_t size)
+{
+    BENCH_REGION_T *region = __sim_region(place);
+    uint32_t *blk = NULL;
+
+    if (size > region->capacity - region->used) {
+        return NULL;
+    }
+    blk = tal_malloc(sizeof(uint64_t) + size);
+    if (NULL == blk) {
+        return NULL;
+    }
+    blk[0] = (uint32_t)size;
+    region->used += size;
+    if (region->used > region->peak) {
+        region->peak = region->used;
+    }
+
+    return (uint64_t *)blk + 1;
+}
+
+static void __sim_free(TAL_MEM_PLACE_E place, void *ptr)
+{
+    uint32_t *blk = (uint32_t *)((uint64_t *)ptr - 1);
+
+    __sim_region(place)->used -= blk[0];
+    tal_free(blk);
+}
+
+static const TAL_MEM_BUDGET_HEAP_T sg_sim_heap = {__sim_malloc, __sim_free};
+
+/* recording */
+static void __trace_record(const TAL_MEM_BUDGET_T *budget, const void *ptr, uint32_t size, TAL_MEM_PLACE_E place)
+{
+    int len;
+
+    (void)place;
+    if (NULL == ptr) {
+        return;
+    }
+    if (size) {
+        len = snprintf(sg_trace + sg_trace_len, sizeof(sg_trace) - sg_trace_len, "a %s %u %p\n", budget->name,
+                       (unsigned)size, ptr);
+    } else {
+        len = snprintf(sg_trace + sg_trace_len, sizeof(sg_trace) - sg_trace_len, "f %s %p\n", budget->name, ptr);
+    }
+    if (len < 0 || (uint32_t)len >= sizeof(sg_trace) - sg_trace_len) {
+        sg_trace_lost++;
+        return;
+    }
+    sg_trace_len += len;
+}
+
+static void __session_take(void **slot, TAL_MEM_BUDGET_T *budget, uint32_t size)
+{
+    if (NULL == *slot) {
+        *slot = tal_mem_budget_malloc(budget, size);
+    }
+}
+
+static void __session_drop(void **slot, uint32_t num)
+{
+    uint32_t i;
+
+    for (i = 0; i < num; i++) {
+        tal_mem_budget_free(slot[i]);
+        slot[i] = NULL;
+    }
+}
+
+static void __session_camera_start(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_CAM_RAW; i++) {
+        __session_take(&sg_session.cam_raw[i], &sg_camera, BENCH_CAM_RAW_SIZE);
+    }
+    for (i = 0; i < BENCH_CAM_ENC; i++) {
+        __session_take(&sg_session.cam_enc[i], &sg_camera, BENCH_CAM_ENC_SIZE);
+    }
+}
+
+/**
+ * @brief Runs the session on the normal heap and records its buffers
+ *
+ * @return none
+ */
+static void __session_record(void)
+{
+    uint32_t round, i, v;
+
+    memset(&sg_session, 0, sizeof(sg_session));
+    sg_trace_len = 0;
+    sg_seed = 0x5EED;
+    tal_mem_budget_set_trace(__trace_record);
+
+    __session_take(&sg_session.disp_fb[0], &sg_disp_fb, BENCH_DISP_FB_SIZE);
+    __session_take(&sg_session.disp_fb[1], &sg_disp_fb, BENCH_DISP_FB_SIZE);
+    __session_camera_start();
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        // the screen changes, LVGL draw buffers are set up again
+        if (0 == round % 3) {
+            __session_drop(sg_session.draw_buf, 2);
+        }
+        __session_take(&sg_session.draw_buf[0], &sg_lvgl_draw, BENCH_DRAW_BUF_SIZE);
+        __session_take(&sg_session.draw_buf[1], &sg_lvgl_draw, BENCH_DRAW_BUF_SIZE);
+
+        // a conversation opens the mic and speaker rings
+        __session_drop(sg_session.audio, 2);
+        __session_take(&sg_session.audio[0], &sg_ai_audio, BENCH_AUDIO_SIZE);
+        __session_take(&sg_session.audio[1], &sg_ai_audio, BENCH_AUDIO_SIZE);
+
+        // the camera switches resolution, a viewer may join while it restarts
+        if (0 == round % 5) {
+            __session_drop(sg_session.cam_raw, BENCH_CAM_RAW);
+            __session_drop(sg_session.cam_enc, BENCH_CAM_ENC);
+        }
+
+        // viewers come and go
+        for (v = 0; v < BENCH_VIEWER_MAX; v++) {
+            uint32_t dice = __bench_rand() % 4;
+            if (0 == dice) {
+                __session_drop(sg_session.rtp[v], BENCH_VIEWER_BUFS);
+            } else if (dice > 1) {
+                for (i = 0; i < BENCH_VIEWER_BUFS; i++) {
+                    __session_take(&sg_session.rtp[v][i], &sg_p2p_rtp, BENCH_RTP_SIZE);
+                }
+            }
+        }
+
+        __session_camera_start();
+    }
+
+    __session_drop((void **)&sg_session, sizeof(sg_session) / sizeof(void *));
+    tal_mem_budget_set_trace(NULL);
+}
+
+/* replay */
+static BENCH_LIVE_T *__live_find(const void *old_ptr)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_LIVE_MAX; i++) {
+        if (sg_live[i].old_ptr == old_ptr) {
+            return &sg_live[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Replays the recorded trace on the simulated heap with the given limits
+ *
+ * @param[in] limit limit per budget, NULL for none
+ *
+ * @return none
+ */
+static void __trace_replay(const uint32_t *limit)
+{
+    TAL_MEM_BUDGET_STATS_T before[CNTSOF(sg_budget)], after;
+    char op, name[32];
+    uint32_t i, size, requests = 0;
+    void *old_ptr = NULL;
+    const char *line = sg_trace;
+    const char *end = sg_trace + sg_trace_len;
+
+    memset(sg_live, 0, sizeof(sg_live));
+    for (i = 0; i < TAL_MEM_PLACE_NUM; i++) {
+        sg_region[i].used = 0;
+        sg_region[i].peak = 0;
+    }
+    for (i = 0; i < CNTSOF(sg_budget); i++) {
+        tal_mem_budget_set_limit(sg_budget[i], limit ? limit[i] : 0);
+        tal_mem_budget_peak_reset(sg_budget[i]);
+        tal_mem_budget_get_stats(sg_budget[i], &before[i]);
+    }
+    tal_mem_budget_set_heap(&sg_sim_heap);
+
+    while (line < end) {
+        TAL_MEM_BUDGET_T *budget = NULL;
+        BENCH_LIVE_T *live = NULL;
+
+        if ('a' == line[0] && 4 == sscanf(line, "%c %31s %u %p", &op, name, &size, &old_ptr)) {
+            budget = tal_mem_budget_find(name);
+            live = __live_find(NULL);
+            if (budget && live) {
+                live->old_ptr = old_ptr;
+                live->ptr = tal_mem_budget_malloc(budget, size);
+                requests++;
+            }
+        } else if ('f' == line[0] && 3 == sscanf(line, "%c %31s %p", &op, name, &old_ptr)) {
+            live = __live_find(old_ptr);
+            if (live) {
+                tal_mem_budget_free(live->ptr);
+                live->old_ptr = NULL;
+                live->ptr = NULL;
+            }
+        }
+        line = strchr(line, '\n');
+        line = line ? line + 1 : end;
+    }
+
+    PR_NOTICE("%s: %d requests, sram peak %d of %d, psram peak %d of %d", limit ? "with budgets" : "without budgets",
+              requests, sg_region[TAL_MEM_PLACE_SRAM].peak, BENCH_SRAM_SIZE, sg_region[TAL_MEM_PLACE_PSRAM].peak,
+              BENCH_PSRAM_SIZE);
+    PR_NOTICE("  %-12s %10s %10s %8s %8s %8s", "budget", "limit", "peak", "refused", "failed", "fallbk");
+    for (i = 0; i < CNTSOF(sg_budget); i++) {
+        tal_mem_budget_get_stats(sg_budget[i], &after);
+        PR_NOTICE("  %-12s %10d %10d %8d %8d %8d", sg_budget[i]->name, after.limit, after.peak_bytes,
+                  after.over_cnt - before[i].over_cnt, after.fail_cnt - before[i].fail_cnt,
+                  after.fallback_cnt - before[i].fallback_cnt);
+        if (after.live_bytes || after.place_bytes[TAL_MEM_PLACE_SRAM] || after.place_bytes[TAL_MEM_PLACE_PSRAM]) {
+            PR_ERR("  %s still holds %d bytes after the replay", sg_budget[i]->name, after.live_bytes);
+        }
+    }
+
+    tal_mem_budget_set_heap(NULL);
+}
+
+/**
+ * @brief Times allocate/free pairs of a budget against tal_malloc
+ *
+ * @return none
+ */
+static void __bench_pairs(void)
+{
+    uint32_t start_ms, raw_ms, budget_ms, i;
+    void *ptr = NULL;
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    for (i = 0; i < BENCH_PAIRS; i++) {
+        ptr = tal_malloc(4096);
+        tal_free(ptr);
+    }
+    raw_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+
+    start_ms = (uint32_t)tal_system_get_millisecond();
+    for (i = 0; i < BENCH_PAIRS; i++) {
+        ptr = tal_mem_budget_malloc(&sg_ai_audio, 4096);
+        tal_mem_budget_free(ptr);
+    }
+    budget_ms = (uint32_t)tal_system_get_millisecond() - start_ms;
+
+    PR_NOTICE("4 KB pair: tal_malloc %d ns, tal_mem_budget_malloc %d ns",
+              (uint32_t)((uint64_t)raw_ms * 1000000 / BENCH_PAIRS),
+              (uint32_t)((uint64_t)budget_ms * 1000000 / BENCH_PAIRS));
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_DEBUG, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+
+    PR_NOTICE("------ memory budget start ------");
+
+    __session_record();
+    PR_NOTICE("recorded %d bytes of trace%s", sg_trace_len, sg_trace_lost ? ", trace buffer too small" : "");
+
+    __trace_replay(NULL);
+    __trace_replay(sg_budget_limit);
+    tal_mem_budget_dump();
+
+    __bench_pairs();
+
+    PR_NOTICE("------ memory budget end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file example_metrics_benchmark.c
+ * @brief Measures the cost of one tal_metrics update.
+ *
+ * Each update kind (counter add, gauge set, histogram sample) runs
+ * BENCH_UPDATES times in a tight loop from one thread, then the counter and
+ * the histogram are hammered by BENCH_THREAD_NUM threads at once, so the cost
+ * of the contended cache line shows up as well. The example prints the average
+ * nanoseconds per update and finally the registry in Prometheus text, as the
+ * "metrics" CLI command does.
+ *
+ * The updates are compiled out without ENABLE_TAL_METRICS, the figures are
+ * then those of an empty loop.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "tuya_cloud_types.h"
+
+#include "tal_api.h"
+#include "tkl_output.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define BENCH_UPDATES    10000000
+#define BENCH_THREAD_NUM 4
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef enum {
+    BENCH_COUNTER,
+    BENCH_GAUGE,
+    BENCH_HISTOGRAM,
+} BENCH_KIND_E;
+
+typedef struct {
+    BENCH_KIND_E kind;
+    uint32_t updates;
+    SEM_HANDLE done;
+    THREAD_HANDLE thread;
+} BENCH_JOB_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static TAL_METRIC_COUNTER_DEFINE(sg_bench_counter, "bench_updates_total", "benchmark counter");
+static TAL_METRIC_GAUGE_DEFINE(sg_bench_gauge, "bench_gauge", "benchmark gauge");
+static TAL_METRIC_HISTOGRAM_DEFINE(sg_bench_hist, "bench_sample_us", "benchmark histogram", 4);
+
+static const char *sg_kind_name[] = {"counter add", "gauge set", "histogram"};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void __bench_loop(BENCH_KIND_E kind, uint32_t updates)
+{
+    uint32_t i;
+
+    switch (kind) {
+    case BENCH_COUNTER:
+        for (i = 0; i < updates; i++) {
+            tal_metric_inc(&sg_bench_counter);
+        }
+        break;
+    case BENCH_GAUGE:
+        for (i = 0; i < updates; i++) {
+            tal_metric_set(&sg_bench_gauge, i);
+        }
+        break;
+    case BENCH_HISTOGRAM:
+        // spread the samples over all the buckets
+        for (i = 0; i < updates; i++) {
+            tal_metric_observe(&sg_bench_hist, (i * 2654435761u) >> 12);
+        }
+        break;
+    }
+}
+
+static void __bench_thread(void *arg)
+{
+    BENCH_JOB_T *job = (BENCH_JOB_T *)arg;
+
+    __bench_loop(job->kind, job->updates);
+    tal_semaphore_post(job->done);
+    tal_thread_delete(job->thread);
+}
+
+/**
+ * @brief Runs BENCH_UPDATES updates of one kind split over thread_num threads
+ *
+ * @param[in] kind update kind
+ * @param[in] thread_num 1 to run in the calling thread
+ *
+ * @return none
+ */
+static void __bench_run(BENCH_KIND_E kind, uint32_t thread_num)
+{
+    BENCH_JOB_T job[BENCH_THREAD_NUM] = {0};
+    SEM_HANDLE done = NULL;
+    THREAD_CFG_T thrd_param = {0};
+    uint32_t updates = BENCH_UPDATES / thread_num;
+    SYS_TIME_T start_ms = 0, elapsed_ms = 0;
+    uint32_t i;
+
+    if (1 == thread_num) {
+        start_ms = tal_system_get_millisecond();
+        __bench_loop(kind, updates);
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+    } else {
+        if (thread_num > BENCH_THREAD_NUM || OPRT_OK != tal_semaphore_create_init(&done, 0, thread_num)) {
+            return;
+        }
+        thrd_param.stackDepth = 1024 * 2;
+        thrd_param.priority = THREAD_PRIO_1;
+        thrd_param.thrdname = "metrics_bench";
+
+        start_ms = tal_system_get_millisecond();
+        for (i = 0; i < thread_num; i++) {
+            job[i].kind = kind;
+            job[i].updates = updates;
+            job[i].done = done;
+            tal_thread_create_and_start(&job[i].thread, NULL, NULL, __bench_thread, &job[i], &thrd_param);
+        }
+        for (i = 0; i < thread_num; i++) {
+            tal_semaphore_wait_forever(done);
+        }
+        elapsed_ms = tal_system_get_millisecond() - start_ms;
+        tal_semaphore_release(done);
+    }
+
+    // every thread does updates updates in elapsed_ms
+    PR_NOTICE("%-12s x%d threads: %4d ns per update (%d ms)", sg_kind_name[kind], thread_num,
+              (uint32_t)(elapsed_ms * 1000000 / updates), (uint32_t)elapsed_ms);
+}
+
+static void __bench_print_line(const char *line, void *arg)
+{
+    PR_INFO("%s", line);
+}
+
+/**
+ * @brief user_main
+ *
+ * @return none
+ */
+void user_main(void)
+{
+    /* basic init */
+    tal_log_init(TAL_LOG_LEVEL_INFO, 1024, (TAL_LOG_OUTPUT_CB)tkl_log_output);
+
+    PR_NOTICE("Application information:");
+    PR_NOTICE("Project name:        %s", PROJECT_NAME);
+    PR_NOTICE("App version:         %s", PROJECT_VERSION);
+    PR_NOTICE("Compile time:        %s", __DATE__);
+    PR_NOTICE("TuyaOpen version:    %s", OPEN_VERSION);
+    PR_NOTICE("TuyaOpen commit-id:  %s", OPEN_COMMIT);
+    PR_NOTICE("Platform chip:       %s", PLATFORM_CHIP);
+    PR_NOTICE("Platform board:      %s", PLATFORM_BOARD);
+    PR_NOTICE("Platform commit-id:  %s", PLATFORM_COMMIT);
+
+    if (OPRT_OK != tal_metric_register(&sg_bench_counter)) {
+        PR_WARN("ENABLE_TAL_METRICS is off, the updates are compiled out");
+    }
+    tal_metric_register(&sg_bench_gauge);
+    tal_metric_register(&sg_bench_hist.base);
+
+    PR_NOTICE("------ metrics benchmark start ------");
+
+    __bench_run(BENCH_COUNTER, 1);
+    __bench_run(BENCH_GAUGE, 1);
+    __bench_run(BENCH_HISTOGRAM, 1);
+    __bench_run(BENCH_COUNTER, BENCH_THREAD_NUM);
+    __bench_run(BENCH_HISTOGRAM, BENCH_THREAD_NUM);
+
+    tal_metrics_print(__bench_print_line, NULL);
+
+    PR_NOTICE("------ metrics benchmark end ------");
+
+    return;
+}
+
+/**
+ * @brief main
+ *
+ * @param argc
+ * @param argv
+ * @return void
+ */
+#if OPERATING_SYSTEM == SYSTEM_LINUX
+void main(int argc, char *argv[])
+{
+    user_main();
+
+    while (1) {
+        tal_system_sleep(500);
+    }
+}
+#else
+
+/* Tuya thread handle */
+static THREAD_HANDLE ty_app_thread = NULL;
+
+/**
+ * @brief  task thread
+ *
+ * @param[in] arg:Parameters when creating a task
+ * @return none
+ */
+static void tuya_app_thread(void *arg)
+{
+    user_main();
+
+    tal_thread_delete(ty_app_thread);
+    ty_app_thread = NULL;
+}
+
+void tuya_app_main(void)
+{
+    THREAD_CFG_T thrd_param = {0};
+    thrd_param.stackDepth = 1024 * 4;
+    thrd_param.priority = THREAD_PRIO_1;
+    thrd_param.thrdname = "tuya_app_main";
+    tal_thread_create_and_start(&ty_app_thread, NULL, NULL, tuya_app_thread, NULL, &thrd_param);
+}
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file test_crc32i.cpp
+ * @brief Unit tests of crc32i.c against a bit-at-a-time CRC-32.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "crc32i.h"
+}
+
+#define CHECK_LEN 1024
+#define SPLIT_LEN 300
+
+static uint32_t crc32_reference(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+class Crc32iTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // 8 bytes of slack so every length can start at every alignment
+        buf.resize(CHECK_LEN + 8);
+        for (uint32_t i = 0; i < buf.size(); i++) {
+            buf[i] = (uint8_t)((i * 2654435761u) >> 13);
+        }
+    }
+
+    std::vector<uint8_t> buf;
+};
+
+TEST_F(Crc32iTest, KnownValue)
+{
+    EXPECT_EQ(0xCBF43926u, hash_crc32i_total("123456789", 9));
+    EXPECT_EQ(0u, hash_crc32i_total("", 0));
+}
+
+TEST_F(Crc32iTest, TotalEveryLengthAndAlignment)
+{
+    for (uint32_t offset = 0; offset < 8; offset++) {
+        for (uint32_t len = 0; len <= CHECK_LEN; len++) {
+            ASSERT_EQ(crc32_reference(&buf[offset], len), hash_crc32i_total(&buf[offset], len))
+                << "offset " << offset << " len " << len;
+        }
+    }
+}
+
+TEST_F(Crc32iTest, UpdateInTwoPieces)
+{
+    uint32_t expect = crc32_reference(buf.data(), SPLIT_LEN);
+
+    for (uint32_t split = 0; split <= SPLIT_LEN; split++) {
+        unsigned int hash = hash_crc32i_init();
+
+        hash = hash_crc32i_update(hash, buf.data(), split);
+        hash = hash_crc32i_update(hash, buf.data() + split, SPLIT_LEN - split);
+        ASSERT_EQ(expect, hash_crc32i_finish(hash)) << "split " << split;
+    }
+}
+
+TEST_F(Crc32iTest, CombineTwoPieces)
+{
+    uint32_t expect = crc32_reference(buf.data(), SPLIT_LEN);
+
+    for (uint32_t split = 0; split <= SPLIT_LEN; split++) {
+        unsigned int crc1 = hash_crc32i_total(buf.data(), split);
+        unsigned int crc2 = hash_crc32i_total(buf.data() + split, SPLIT_LEN - split);
+
+        ASSERT_EQ(expect, hash_crc32i_combine(crc1, crc2, SPLIT_LEN - split)) << "split " << split;
+    }
+}
@@ -0,0 +1,436 @@
+/**
+ * @file test_text_codec.cpp
+ * @brief Unit tests of text_codec.c and of the mix_method.c calls built on it,
+ * against byte-at-a-time references.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "mix_method.h"
+#include "text_codec.h"
+
+#define CHECK_LEN 600
+#define SUBST_LEN 128 // characters, two NEON blocks
+#define SPLIT_LEN 300
+
+static const char b64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int b64_value(char c)
+{
+    const char *pos;
+
+    if ('\0' == c) {
+        return -1;
+    }
+    pos = strchr(b64_alphabet, c);
+    return pos ? (int)(pos - b64_alphabet) : -1;
+}
+
+static size_t b64_encode_reference(const uint8_t *bin, size_t len, char *text)
+{
+    size_t n = 0;
+    uint32_t bits = 0, cnt = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        bits = bits << 8 | bin[i];
+        cnt += 8;
+        while (cnt >= 6) {
+            cnt -= 6;
+            text[n++] = b64_alphabet[(bits >> cnt) & 0x3F];
+        }
+    }
+    if (cnt) {
+        text[n++] = b64_alphabet[(bits << (6 - cnt)) & 0x3F];
+    }
+    while (n % 4) {
+        text[n++] = '=';
+    }
+    text[n] = '\0';
+
+    return n;
+}
+
+// The rules of text_codec.h: spaces are skipped, the data characters are followed by at most
+// the padding their count needs, a count of 4n + 1 is invalid
+static int b64_decode_reference(const char *text, size_t len, uint8_t *bin)
+{
+    char strip[SUBST_LEN * 2];
+    size_t n = 0, data, pad;
+    uint32_t bits = 0, cnt = 0;
+    int out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        if (' ' != text[i] && '\t' != text[i] && '\r' != text[i] && '\n' != text[i]) {
+            strip[n++] = text[i];
+        }
+    }
+    for (data = 0; data < n && '=' != strip[data]; data++) {
+        if (b64_value(strip[data]) < 0) {
+            return OPRT_INVALID_PARM;
+        }
+    }
+    for (pad = data; pad < n; pad++) {
+        if ('=' != strip[pad]) {
+            return OPRT_INVALID_PARM;
+        }
+    }
+    pad = n - data;
+    if (1 == data % 4 || (pad && (0 == data % 4 || pad > 4 - data % 4))) {
+        return OPRT_INVALID_PARM;
+    }
+
+    for (size_t i = 0; i < data; i++) {
+        bits = bits << 6 | b64_value(strip[i]);
+        cnt += 6;
+        if (cnt >= 8) {
+            cnt -= 8;
+            bin[out++] = (uint8_t)(bits >> cnt);
+        }
+    }
+
+    return out;
+}
+
+static void hex_encode_reference(const uint8_t *bin, size_t len, char *text, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    for (size_t i = 0; i < len; i++) {
+        text[2 * i] = digits[bin[i] >> 4];
+        text[2 * i + 1] = digits[bin[i] & 0x0F];
+    }
+    text[2 * len] = '\0';
+}
+
+static int hex_digit_reference(char c)
+{
+    if ('0' <= c && c <= '9') {
+        return c - '0';
+    }
+    if ('a' <= c && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if ('A' <= c && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static int hex_decode_reference(const char *text, size_t len, uint8_t *bin)
+{
+    if (len % 2) {
+        return OPRT_INVALID_PARM;
+    }
+    for (size_t i = 0; i < len; i += 2) {
+        int hi = hex_digit_reference(text[i]);
+        int lo = hex_digit_reference(text[i + 1]);
+
+        if (hi < 0 || lo < 0) {
+            return OPRT_INVALID_PARM;
+        }
+        bin[i / 2] = (uint8_t)(hi << 4 | lo);
+    }
+
+    return (int)(len / 2);
+}
+
+// Step 0: two pieces split at <split>, the first may be empty, else pieces of <step> bytes
+static std::vector<size_t> pieces_of(size_t total, uint32_t step, size_t split)
+{
+    std::vector<size_t> pieces;
+
+    if (0 == step) {
+        pieces.push_back(split);
+        pieces.push_back(total - split);
+        return pieces;
+    }
+    for (size_t pos = 0; pos < total; pos += step) {
+        pieces.push_back(total - pos < step ? total - pos : step);
+    }
+    return pieces;
+}
+
+class TextCodecTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // 16 bytes of slack so every length can start at every alignment
+        bin.resize(CHECK_LEN + 16);
+        for (uint32_t i = 0; i < bin.size(); i++) {
+            bin[i] = (uint8_t)((i * 2654435761u) >> 13);
+        }
+        text.resize(2 * bin.size() + 1);
+        ref_text.resize(2 * bin.size() + 1);
+        out.resize(bin.size());
+        ref_out.resize(bin.size());
+    }
+
+    std::vector<uint8_t> bin;
+    std::vector<char> text;
+    std::vector<char> ref_text;
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> ref_out;
+};
+
+TEST_F(TextCodecTest, Base64EveryLengthAndAlignment)
+{
+    for (uint32_t offset = 0; offset < 16; offset++) {
+        for (uint32_t len = 0; len <= CHECK_LEN; len++) {
+            size_t n = tuya_base64_encode_buf(&bin[offset], len, &text[offset]);
+            size_t ref_n = b64_encode_reference(&bin[offset], len, ref_text.data());
+
+            ASSERT_EQ(ref_n, n) << "offset " << offset << " len " << len;
+            ASSERT_EQ(ref_n, tuya_base64_encode_len(len)) << "len " << len;
+            ASSERT_STREQ(ref_text.data(), &text[offset]) << "offset " << offset << " len " << len;
+            ASSERT_EQ(len, tuya_base64_decode_len(&text[offset], n)) << "len " << len;
+            ASSERT_EQ((int)len, tuya_base64_decode_buf(&text[offset], n, &out[offset]))
+                << "offset " << offset << " len " << len;
+            ASSERT_EQ(0, memcmp(&out[offset], &bin[offset], len)) << "offset " << offset << " len " << len;
+        }
+    }
+}
+
+TEST_F(TextCodecTest, HexEveryLengthAndAlignment)
+{
+    for (uint32_t offset = 0; offset < 16; offset++) {
+        for (uint32_t len = 0; len <= CHECK_LEN; len++) {
+            bool upper = len & 1;
+            size_t n = tuya_hex_encode_buf(&bin[offset], len, &text[offset], upper);
+
+            hex_encode_reference(&bin[offset], len, ref_text.data(), upper);
+            ASSERT_EQ(2 * len, n) << "offset " << offset << " len " << len;
+            ASSERT_STREQ(ref_text.data(), &text[offset]) << "offset " << offset << " len " << len;
+            ASSERT_EQ((int)len, tuya_hex_decode_buf(&text[offset], n, &out[offset]))
+                << "offset " << offset << " len " << len;
+            ASSERT_EQ(0, memcmp(&out[offset], &bin[offset], len)) << "offset " << offset << " len " << len;
+        }
+    }
+}
+
+// Every byte value at every position, so that each position of a block meets every invalid
+// character, space and padding
+TEST_F(TextCodecTest, Base64EveryCharacterAtEveryPosition)
+{
+    char subst[SUBST_LEN + 1];
+
+    // with and without padding
+    for (uint32_t len = SUBST_LEN - 2; len <= SUBST_LEN; len++) {
+        b64_encode_reference(bin.data(), (len / 4) * 3 - (SUBST_LEN - len), subst);
+        for (uint32_t pos = 0; pos < len; pos++) {
+            for (uint32_t c = 0; c < 256; c++) {
+                char save = subst[pos];
+
+                subst[pos] = (char)c;
+                int dec = tuya_base64_decode_buf(subst, len, out.data());
+                int ref_dec = b64_decode_reference(subst, len, ref_out.data());
+                subst[pos] = save;
+
+                ASSERT_EQ(ref_dec, dec) << "len " << len << " char " << c << " at " << pos;
+                if (dec > 0) {
+                    ASSERT_EQ(0, memcmp(out.data(), ref_out.data(), dec))
+                        << "len " << len << " char " << c << " at " << pos;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TextCodecTest, HexEveryCharacterAtEveryPosition)
+{
+    char subst[SUBST_LEN + 1];
+
+    hex_encode_reference(bin.data(), SUBST_LEN / 2, subst, false);
+    for (uint32_t pos = 0; pos < SUBST_LEN; pos++) {
+        for (uint32_t c = 0; c < 256; c++) {
+            char save = subst[pos];
+
+            subst[pos] = (char)c;
+            int dec = tuya_hex_decode_buf(subst, SUBST_LEN, out.data());
+            int ref_dec = hex_decode_reference(subst, SUBST_LEN, ref_out.data());
+            subst[pos] = save;
+
+            ASSERT_EQ(ref_dec, dec) << "char " << c << " at " << pos;
+            if (dec > 0) {
+                ASSERT_EQ(0, memcmp(out.data(), ref_out.data(), dec)) << "char " << c << " at " << pos;
+            }
+        }
+    }
+}
+
+TEST_F(TextCodecTest, Base64PaddingAndSpaces)
+{
+    static const char *cases[] = {"Zg", "Zg=",   "Zg==",  "Zm8",   "Zm8=",     "Zm9v", "Zm9v\r\nYmFy\n", " Zm9v YmE= ",
+                                  "Z",  "Zg===", "Zm8==", "Zm9v=", "Zg==Zg==", "=Zg",  "Zm9v\x80"};
+
+    for (const char *c : cases) {
+        EXPECT_EQ(b64_decode_reference(c, strlen(c), ref_out.data()), tuya_base64_decode_buf(c, strlen(c), out.data()))
+            << "\"" << c << "\"";
+    }
+}
+
+// PEM style lines of 64 and 76 characters
+TEST_F(TextCodecTest, Base64Lines)
+{
+    for (uint32_t line = 64; line <= 76; line += 12) {
+        for (uint32_t len = 0; len <= SPLIT_LEN; len++) {
+            size_t n = b64_encode_reference(bin.data(), len, ref_text.data());
+            size_t w = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                text[w++] = ref_text[i];
+                if (0 == (i + 1) % line) {
+                    text[w++] = '\r';
+                    text[w++] = '\n';
+                }
+            }
+            ASSERT_EQ((int)len, tuya_base64_decode_buf(text.data(), w, out.data()))
+                << "line " << line << " len " << len;
+            ASSERT_EQ(0, memcmp(out.data(), bin.data(), len)) << "line " << line << " len " << len;
+        }
+    }
+}
+
+TEST_F(TextCodecTest, Base64EncodeContext)
+{
+    size_t text_len = b64_encode_reference(bin.data(), SPLIT_LEN, ref_text.data());
+
+    for (uint32_t step = 0; step <= 17; step++) {
+        for (uint32_t split = 0; split <= (step ? 0 : SPLIT_LEN); split++) {
+            TUYA_BASE64_ENC_CTX_T enc;
+            size_t n = 0;
+
+            size_t pos = 0;
+
+            tuya_base64_enc_init(&enc);
+            for (size_t piece : pieces_of(SPLIT_LEN, step, split)) {
+                n += tuya_base64_enc_update(&enc, &bin[pos], piece, &text[n]);
+                pos += piece;
+            }
+            n += tuya_base64_enc_final(&enc, &text[n]);
+            text[n] = '\0';
+
+            ASSERT_EQ(text_len, n) << "step " << step << " split " << split;
+            ASSERT_STREQ(ref_text.data(), text.data()) << "step " << step << " split " << split;
+        }
+    }
+}
+
+TEST_F(TextCodecTest, Base64DecodeContext)
+{
+    size_t text_len = b64_encode_reference(bin.data(), SPLIT_LEN, ref_text.data());
+
+    for (uint32_t step = 0; step <= 17; step++) {
+        for (uint32_t split = 0; split <= (step ? 0 : text_len); split++) {
+            TUYA_BASE64_DEC_CTX_T dec;
+            size_t pos = 0;
+            int n = 0, r;
+
+            tuya_base64_dec_init(&dec);
+            for (size_t piece : pieces_of(text_len, step, split)) {
+                r = tuya_base64_dec_update(&dec, &ref_text[pos], piece, &out[n]);
+                ASSERT_GE(r, 0) << "step " << step << " split " << split << " pos " << pos;
+                n += r;
+                pos += piece;
+            }
+            r = tuya_base64_dec_final(&dec, &out[n]);
+            ASSERT_GE(r, 0) << "step " << step << " split " << split;
+            n += r;
+
+            ASSERT_EQ(SPLIT_LEN, n) << "step " << step << " split " << split;
+            ASSERT_EQ(0, memcmp(out.data(), bin.data(), SPLIT_LEN)) << "step " << step << " split " << split;
+        }
+    }
+}
+
+TEST_F(TextCodecTest, HexDecodeContext)
+{
+    hex_encode_reference(bin.data(), SPLIT_LEN, text.data(), true);
+    for (uint32_t step = 0; step <= 17; step++) {
+        for (uint32_t split = 0; split <= (step ? 0 : 2 * SPLIT_LEN); split++) {
+            TUYA_HEX_DEC_CTX_T hex;
+            size_t pos = 0;
+            int n = 0;
+
+            tuya_hex_dec_init(&hex);
+            for (size_t piece : pieces_of(2 * SPLIT_LEN, step, split)) {
+                n += tuya_hex_dec_update(&hex, &text[pos], piece, &out[n]);
+                pos += piece;
+            }
+
+            ASSERT_EQ(OPRT_OK, tuya_hex_dec_final(&hex)) << "step " << step << " split " << split;
+            ASSERT_EQ(SPLIT_LEN, n) << "step " << step << " split " << split;
+            ASSERT_EQ(0, memcmp(out.data(), bin.data(), SPLIT_LEN)) << "step " << step << " split " << split;
+        }
+    }
+}
+
+TEST_F(TextCodecTest, InvalidInput)
+{
+    TUYA_BASE64_DEC_CTX_T dec;
+    TUYA_HEX_DEC_CTX_T hex;
+
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_base64_decode_buf("Zm9v!", 5, out.data()));
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_hex_decode_buf("0g", 2, out.data()));
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_hex_decode_buf("123", 3, out.data()));
+
+    // an error sticks to the context
+    tuya_base64_dec_init(&dec);
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_base64_dec_update(&dec, "Zg=x", 4, out.data()));
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_base64_dec_update(&dec, "Zm9v", 4, out.data()));
+
+    // an odd digit count is only known at the end
+    tuya_hex_dec_init(&hex);
+    EXPECT_EQ(1, tuya_hex_dec_update(&hex, "abc", 3, out.data()));
+    EXPECT_NE(OPRT_OK, tuya_hex_dec_final(&hex));
+}
+
+TEST_F(TextCodecTest, MixMethodBase64)
+{
+    for (uint32_t len = 0; len <= SPLIT_LEN; len++) {
+        b64_encode_reference(bin.data(), len, ref_text.data());
+        tuya_base64_encode(bin.data(), text.data(), len);
+        ASSERT_STREQ(ref_text.data(), text.data()) << "len " << len;
+        ASSERT_EQ((int)len, tuya_base64_decode(text.data(), out.data())) << "len " << len;
+        ASSERT_EQ(0, memcmp(out.data(), bin.data(), len)) << "len " << len;
+    }
+}
+
+TEST_F(TextCodecTest, MixMethodHex)
+{
+    for (uint32_t len = 0; len <= SPLIT_LEN; len++) {
+        hex2str((uint8_t *)text.data(), bin.data(), len);
+        text[2 * len] = '\0';
+        hex_encode_reference(bin.data(), len, ref_text.data(), true);
+        ASSERT_STREQ(ref_text.data(), text.data()) << "hex2str, len " << len;
+
+        byte2str((uint8_t *)text.data(), bin.data(), len, FALSE);
+        text[2 * len] = '\0';
+        hex_encode_reference(bin.data(), len, ref_text.data(), false);
+        ASSERT_STREQ(ref_text.data(), text.data()) << "byte2str, len " << len;
+    }
+}
+
+// ascs2hex keeps reading a character that is not a digit as 0 and dropping an odd one
+TEST_F(TextCodecTest, MixMethodAscs2hex)
+{
+    static const char *ascs[] = {"00fF7a", "0g1Z", "12345", "-1x9AbCdEf0123456789abcdefABCDEF0123456789"};
+
+    for (const char *a : ascs) {
+        uint32_t len = strlen(a);
+
+        memset(out.data(), 0xAA, len);
+        ascs2hex(out.data(), (uint8_t *)a, len);
+        for (uint32_t j = 0; j + 1 < len; j += 2) {
+            EXPECT_EQ(asc2hex(a[j]) << 4 | asc2hex(a[j + 1]), out[j / 2]) << "\"" << a << "\" at " << j;
+        }
+        EXPECT_EQ(0xAA, out[len / 2]) << "\"" << a << "\" wrote past the end";
+    }
+}
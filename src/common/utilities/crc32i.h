@@ -56,4 +56,18 @@ unsigned int hash_crc32i_finish(unsigned int hash);
  */
 unsigned int hash_crc32i_total(const void* data, unsigned int size);
 
+/**
+ * @brief Combines the CRC32I hash values of two consecutive blocks.
+ *
+ * Blocks hashed separately, in parallel for instance, are joined without
+ * reading their data again: the result is the hash of the first block
+ * followed by the second one.
+ *
+ * @param crc1 The CRC32I hash value of the first block.
+ * @param crc2 The CRC32I hash value of the second block.
+ * @param len2 The size of the second block in bytes.
+ * @return The CRC32I hash value of both blocks.
+ */
+unsigned int hash_crc32i_combine(unsigned int crc1, unsigned int crc2, unsigned int len2);
+
 #endif
@@ -16,13 +16,12 @@
 #define __MIX_METHOD_GLOBALS
 #include "mix_method.h"
 #include "tal_memory.h"
-#include "mbedtls/base64.h"
+#include "text_codec.h"
 
 /***********************************************************
 *************************micro define***********************
 ***********************************************************/
 #define __tolower(c)                 ((('A' <= (c)) && ((c) <= 'Z')) ? ((c) - 'A' + 'a') : (c))
-#define TY_BASE64_BUF_LEN_CALC(slen) (((slen) / 3 + ((slen) % 3 != 0)) * 4 + 1) // 1 for '\0'
 
 /***********************************************************
 *************************variable define********************
@@ -105,10 +104,15 @@ void ascs2hex(unsigned char *hex, unsigned char *ascs, int srclen)
         lenstr -= (lenstr % 2);
     }
 
-    if (lenstr == 0) {
+    if (lenstr <= 0) {
         return;
     }
 
+    if (tuya_hex_decode_buf((const char *)ascs, lenstr, hex) >= 0) {
+        return;
+    }
+
+    //! not only hex digits, the others count as 0
     for (i = 0; i < lenstr; i += 2) {
         h4 = asc2hex(ascs[i]);
         l4 = asc2hex(ascs[i + 1]);
@@ -125,23 +129,7 @@ void ascs2hex(unsigned char *hex, unsigned char *ascs, int srclen)
  */
 void hex2str(unsigned char *pbDest, unsigned char *pbSrc, int nLen)
 {
-    char ddl, ddh;
-    int i;
-
-    for (i = 0; i < nLen; i++) {
-        ddh = 48 + pbSrc[i] / 16;
-        ddl = 48 + pbSrc[i] % 16;
-        if (ddh > 57) {
-            ddh = ddh + 7;
-        }
-        if (ddl > 57) {
-            ddl = ddl + 7;
-        }
-        pbDest[i * 2] = ddh;
-        pbDest[i * 2 + 1] = ddl;
-    }
-
-    pbDest[nLen * 2] = '\0';
+    tuya_hex_encode_buf(pbSrc, nLen > 0 ? nLen : 0, (char *)pbDest, TRUE);
 }
 
 /**
@@ -168,19 +156,7 @@ void hex2str(unsigned char *pbDest, unsigned char *pbSrc, int nLen)
  */
 void byte2str(unsigned char *pbDest, unsigned char *pbSrc, int nLen, bool_t upper)
 {
-    char to_lower[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-    char to_upper[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-
-    char *tmp = upper ? to_upper : to_lower;
-
-    int i;
-    for (i = 0; i < nLen; i++) {
-        pbDest[i * 2] = tmp[((pbSrc[i] & 0xF0) >> 4)];
-        pbDest[i * 2 + 1] = tmp[(pbSrc[i] & 0x0F)];
-    }
-
-    pbDest[nLen * 2] = '\0';
-    return;
+    tuya_hex_encode_buf(pbSrc, nLen > 0 ? nLen : 0, (char *)pbDest, upper);
 }
 
 /**
@@ -466,9 +442,7 @@ int tuya_toupper(int c)
  */
 char *tuya_base64_encode(const unsigned char *bindata, char *base64, int binlength)
 {
-    size_t dlen, olen;
-    dlen = TY_BASE64_BUF_LEN_CALC(binlength);
-    mbedtls_base64_encode((unsigned char *)base64, dlen, &olen, bindata, binlength);
+    tuya_base64_encode_buf(bindata, binlength > 0 ? binlength : 0, base64);
     return base64;
 }
 
@@ -480,13 +454,13 @@ char *tuya_base64_encode(const unsigned char *bindata, char *base64, int binleng
  *
  * @param base64 The base64 encoded string to decode.
  * @param bindata The buffer to store the decoded data.
- * @return The length of the decoded data.
+ * @return The length of the decoded data, 0 when the string is not base64.
  */
 int tuya_base64_decode(const char *base64, unsigned char *bindata)
 {
-    size_t olen = 0;
+    int olen;
 
-    mbedtls_base64_decode(bindata, strlen(base64), &olen, (unsigned char *)base64, strlen(base64));
+    olen = tuya_base64_decode_buf(base64, strlen(base64), bindata);
 
-    return olen;
+    return olen < 0 ? 0 : olen;
 }
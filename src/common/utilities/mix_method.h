@@ -199,7 +199,7 @@ char *tuya_base64_encode(const unsigned char *bindata, char *base64,
  *
  * @param base64 The base64 encoded string to decode.
  * @param bindata The buffer to store the decoded data.
- * @return The length of the decoded data.
+ * @return The length of the decoded data, 0 when the string is not base64.
  */
 int tuya_base64_decode(const char * base64, unsigned char * bindata);
 
@@ -0,0 +1,990 @@
+/**
+ * @file text_codec.c
+ * @brief Implementation of base64 and hex encoding.
+ *
+ * The bulk of a buffer is converted by a block engine chosen at build time:
+ * NEON on AArch64 (48 bytes / 64 characters of base64 per step), SSSE3 on x86
+ * (12 / 16) and otherwise 64-bit SWAR on little-endian targets, which works on
+ * the characters of 6 bytes, or the digits of 4, in one register with no
+ * table lookup and no branch per character. The SWAR engine also converts what
+ * the vector engines leave, and a byte-wise loop does the last bytes. A block
+ * holding anything else than plain base64 or hex digits (spaces, padding,
+ * invalid characters) is left to the byte-wise loop, which reports errors.
+ * Build with TEXT_CODEC_BLOCK set to 0 to keep only the byte-wise loops.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+#include <string.h>
+
+#include "text_codec.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#ifndef TEXT_CODEC_BLOCK
+#define TEXT_CODEC_BLOCK 1
+#endif
+
+#if TEXT_CODEC_BLOCK && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TEXT_CODEC_NEON  1
+#define TEXT_CODEC_SSSE3 0
+#elif TEXT_CODEC_BLOCK && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define TEXT_CODEC_NEON  0
+#define TEXT_CODEC_SSSE3 1
+#else
+#define TEXT_CODEC_NEON  0
+#define TEXT_CODEC_SSSE3 0
+#endif
+
+#if TEXT_CODEC_BLOCK && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TEXT_CODEC_SWAR 1
+#else
+#define TEXT_CODEC_SWAR 0
+#endif
+
+#define B64_PAD   0xFD // '='
+#define B64_SPACE 0xFE // ' ', '\t', '\r', '\n'
+#define B64_BAD   0xFF
+#define HEX_BAD   0xFF
+
+#define SWAR_L 0x0101010101010101ULL
+#define SWAR_H 0x8080808080808080ULL
+
+/***********************************************************
+*************************variable define********************
+***********************************************************/
+static const char s_b64_enc[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// clang-format off
+static const uint8_t s_b64_dec[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFE, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFD, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static const uint8_t s_hex_dec[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+// clang-format on
+
+static const char s_hex_upper[16] = "0123456789ABCDEF";
+static const char s_hex_lower[16] = "0123456789abcdef";
+
+/***********************************************************
+*************************function define********************
+***********************************************************/
+#if TEXT_CODEC_SWAR
+/**
+ * @brief 0x80 in every byte of x that is >= n, the bytes of x are below 0x80
+ * and n is at most 0x80
+ */
+static inline uint64_t __swar_ge(uint64_t x, uint8_t n)
+{
+    return ((x | SWAR_H) - SWAR_L * n) & SWAR_H;
+}
+
+static inline uint64_t __swar_in(uint64_t x, uint8_t lo, uint8_t hi)
+{
+    return __swar_ge(x, lo) & ~__swar_ge(x, hi + 1);
+}
+
+static inline uint64_t __swar_load(const void *src)
+{
+    uint64_t x;
+
+    memcpy(&x, src, sizeof(x));
+    return x;
+}
+
+/**
+ * @brief 6 bytes to 8 base64 characters
+ */
+static inline void __b64_enc6_swar(const uint8_t *src, char *dst)
+{
+    uint64_t x, t;
+
+    x = ((uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2]) |
+        (uint64_t)((uint32_t)src[3] << 16 | (uint32_t)src[4] << 8 | src[5]) << 32;
+    //! 24 bits -> 2 x 12 bits -> 4 x 6 bits, the first index in the low byte
+    t = ((x >> 12) & 0x00000FFF00000FFFULL) | ((x & 0x00000FFF00000FFFULL) << 16);
+    x = ((t >> 6) & 0x003F003F003F003FULL) | ((t & 0x003F003F003F003FULL) << 8);
+
+    //! index to character, each step keeps every byte in 0..255
+    t = x + SWAR_L * 'A';
+    t += (__swar_ge(x, 26) >> 7) * ('a' - 'A' - 26);
+    t -= (__swar_ge(x, 52) >> 7) * (('a' - 26) - ('0' - 52));
+    t -= (__swar_ge(x, 62) >> 7) * (('0' - 52) - ('+' - 62));
+    t += (__swar_ge(x, 63) >> 7) * (('/' - 63) - ('+' - 62));
+    memcpy(dst, &t, sizeof(t));
+}
+
+/**
+ * @brief 8 base64 characters to 6 bytes
+ *
+ * @return 0 when one of the characters is not in the base64 alphabet
+ */
+static inline int __b64_dec8_swar(const char *src, uint8_t *dst)
+{
+    uint64_t c, upper, lower, digit, plus, slash, off, v;
+
+    c = __swar_load(src);
+    if (c & SWAR_H) {
+        return 0;
+    }
+    upper = __swar_in(c, 'A', 'Z');
+    lower = __swar_in(c, 'a', 'z');
+    digit = __swar_in(c, '0', '9');
+    plus = __swar_in(c, '+', '+');
+    slash = __swar_in(c, '/', '/');
+    if ((upper | lower | digit | plus | slash) != SWAR_H) {
+        return 0;
+    }
+
+    //! offset of each character to its value, added byte by byte modulo 256
+    off = (upper >> 7) * (uint8_t)(0 - 'A') | (lower >> 7) * (uint8_t)(26 - 'a') | (digit >> 7) * (52 - '0') |
+          (plus >> 7) * (62 - '+') | (slash >> 7) * (63 - '/');
+    v = (c + (off & ~SWAR_H)) ^ (off & SWAR_H);
+
+    //! 8 x 6 bits -> 4 x 12 bits -> 2 x 24 bits
+    v = ((v & 0x00FF00FF00FF00FFULL) << 6) | ((v >> 8) & 0x00FF00FF00FF00FFULL);
+    v = ((v & 0x0000FFFF0000FFFFULL) << 12) | ((v >> 16) & 0x0000FFFF0000FFFFULL);
+    dst[0] = (uint8_t)(v >> 16);
+    dst[1] = (uint8_t)(v >> 8);
+    dst[2] = (uint8_t)v;
+    dst[3] = (uint8_t)(v >> 48);
+    dst[4] = (uint8_t)(v >> 40);
+    dst[5] = (uint8_t)(v >> 32);
+
+    return 1;
+}
+
+/**
+ * @brief 4 bytes to 8 hex digits
+ *
+ * @param[in] alpha distance from '9' + 1 to 'A' or 'a'
+ */
+static inline void __hex_enc4_swar(const uint8_t *src, char *dst, uint8_t alpha)
+{
+    uint64_t x;
+
+    x = (uint32_t)src[0] | (uint32_t)src[1] << 8 | (uint32_t)src[2] << 16 | (uint32_t)src[3] << 24;
+    x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+    x = (x | x << 8) & 0x00FF00FF00FF00FFULL;
+    x = ((x >> 4) & 0x000F000F000F000FULL) | ((x & 0x000F000F000F000FULL) << 8);
+    x += SWAR_L * '0' + (((x + SWAR_L * (0x80 - 10)) & SWAR_H) >> 7) * alpha;
+    memcpy(dst, &x, sizeof(x));
+}
+
+/**
+ * @brief 8 hex digits to 4 bytes
+ *
+ * @return 0 when one of the characters is not a hex digit
+ */
+static inline int __hex_dec8_swar(const char *src, uint8_t *dst)
+{
+    uint64_t c, l, digit, alpha;
+    uint32_t v32;
+
+    c = __swar_load(src);
+    if (c & SWAR_H) {
+        return 0;
+    }
+    l = c | SWAR_L * 0x20;
+    digit = __swar_in(c, '0', '9');
+    alpha = __swar_in(l, 'a', 'f');
+    if ((digit | alpha) != SWAR_H) {
+        return 0;
+    }
+
+    c = (l & SWAR_L * 0x0F) + (alpha >> 7) * 9;
+    c = ((c & 0x00FF00FF00FF00FFULL) << 4) | ((c >> 8) & 0x00FF00FF00FF00FFULL);
+    c = (c | c >> 8) & 0x0000FFFF0000FFFFULL;
+    v32 = (uint32_t)(c | c >> 16);
+    memcpy(dst, &v32, sizeof(v32));
+
+    return 1;
+}
+#endif
+
+#if TEXT_CODEC_SSSE3
+/**
+ * @brief 12 bytes to 16 base64 characters, 16 bytes are read
+ */
+static inline void __b64_enc12_ssse3(const uint8_t *src, char *dst)
+{
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i in, t0, t1, idx, sel;
+
+    in = _mm_loadu_si128((const __m128i *)src);
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    idx = _mm_or_si128(t0, t1);
+
+    sel = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    sel = _mm_sub_epi8(sel, _mm_cmpgt_epi8(idx, _mm_set1_epi8(25)));
+    _mm_storeu_si128((__m128i *)dst, _mm_add_epi8(idx, _mm_shuffle_epi8(lut, sel)));
+}
+
+/**
+ * @brief 16 base64 characters to 12 bytes
+ *
+ * @return 0 when one of the characters is not in the base64 alphabet
+ */
+static inline int __b64_dec16_ssse3(const char *src, uint8_t *dst)
+{
+    const __m128i lut_lo =
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi =
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+    __m128i str, hi_nib, lo_nib, bad, roll, out;
+    uint32_t tail;
+
+    str = _mm_loadu_si128((const __m128i *)src);
+    hi_nib = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    lo_nib = _mm_and_si128(str, mask_2f);
+    bad = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo_nib), _mm_shuffle_epi8(lut_hi, hi_nib));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(bad, _mm_setzero_si128()))) {
+        return 0;
+    }
+    roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nib));
+    str = _mm_add_epi8(str, roll);
+
+    out = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    out = _mm_madd_epi16(out, _mm_set1_epi32(0x00011000));
+    out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storel_epi64((__m128i *)dst, out);
+    tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+    memcpy(dst + 8, &tail, sizeof(tail));
+
+    return 1;
+}
+
+/**
+ * @brief 16 bytes to 32 hex digits
+ */
+static inline void __hex_enc16_ssse3(const uint8_t *src, char *dst, __m128i lut)
+{
+    const __m128i mask_0f = _mm_set1_epi8(0x0f);
+    __m128i in, hi, lo;
+
+    in = _mm_loadu_si128((const __m128i *)src);
+    hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), mask_0f));
+    lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, mask_0f));
+    _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi8(hi, lo));
+}
+
+static inline __m128i __hex_val_ssse3(__m128i c, __m128i *ok)
+{
+    __m128i d, l, is_d, is_l;
+
+    d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    is_l = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+    *ok = _mm_and_si128(*ok, _mm_or_si128(is_d, is_l));
+
+    return _mm_or_si128(_mm_and_si128(is_d, d), _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+/**
+ * @brief 32 hex digits to 16 bytes
+ *
+ * @return 0 when one of the characters is not a hex digit
+ */
+static inline int __hex_dec32_ssse3(const char *src, uint8_t *dst)
+{
+    const __m128i weight = _mm_set1_epi16(0x0110);
+    __m128i ok = _mm_set1_epi8(-1);
+    __m128i v0, v1;
+
+    v0 = __hex_val_ssse3(_mm_loadu_si128((const __m128i *)src), &ok);
+    v1 = __hex_val_ssse3(_mm_loadu_si128((const __m128i *)(src + 16)), &ok);
+    if (0xFFFF != _mm_movemask_epi8(ok)) {
+        return 0;
+    }
+    _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(_mm_maddubs_epi16(v0, weight), _mm_maddubs_epi16(v1, weight)));
+
+    return 1;
+}
+#endif
+
+#if TEXT_CODEC_NEON
+/**
+ * @brief 48 bytes to 64 base64 characters
+ */
+static inline void __b64_enc48_neon(const uint8_t *src, char *dst, uint8x16x4_t lut)
+{
+    const uint8x16_t mask_3f = vdupq_n_u8(0x3f);
+    uint8x16x3_t in = vld3q_u8(src);
+    uint8x16x4_t out;
+
+    out.val[0] = vshrq_n_u8(in.val[0], 2);
+    out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask_3f);
+    out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask_3f);
+    out.val[3] = vandq_u8(in.val[2], mask_3f);
+    out.val[0] = vqtbl4q_u8(lut, out.val[0]);
+    out.val[1] = vqtbl4q_u8(lut, out.val[1]);
+    out.val[2] = vqtbl4q_u8(lut, out.val[2]);
+    out.val[3] = vqtbl4q_u8(lut, out.val[3]);
+    vst4q_u8((uint8_t *)dst, out);
+}
+
+/**
+ * @brief 64 base64 characters to 48 bytes
+ *
+ * @param[in] lo values of the characters 0..63, with bit 7 set for the invalid ones
+ * @param[in] hi values of the characters 64..127
+ *
+ * @return 0 when one of the characters is not in the base64 alphabet
+ */
+static inline int __b64_dec64_neon(const char *src, uint8_t *dst, uint8x16x4_t lo, uint8x16x4_t hi)
+{
+    const uint8x16_t flip = vdupq_n_u8(0x40);
+    uint8x16x4_t in = vld4q_u8((const uint8_t *)src);
+    uint8x16_t err = vdupq_n_u8(0);
+    uint8x16x3_t out;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        uint8x16_t v = vqtbx4q_u8(vqtbl4q_u8(lo, in.val[i]), hi, veorq_u8(in.val[i], flip));
+        err = vorrq_u8(err, vorrq_u8(v, in.val[i]));
+        in.val[i] = v;
+    }
+    if (vmaxvq_u8(err) & 0x80) {
+        return 0;
+    }
+
+    out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+    out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+    out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+    vst3q_u8(dst, out);
+
+    return 1;
+}
+
+/**
+ * @brief 16 bytes to 32 hex digits
+ */
+static inline void __hex_enc16_neon(const uint8_t *src, char *dst, uint8x16_t lut)
+{
+    uint8x16_t in = vld1q_u8(src);
+    uint8x16x2_t out;
+
+    out.val[0] = vqtbl1q_u8(lut, vshrq_n_u8(in, 4));
+    out.val[1] = vqtbl1q_u8(lut, vandq_u8(in, vdupq_n_u8(0x0f)));
+    vst2q_u8((uint8_t *)dst, out);
+}
+
+/**
+ * @brief 32 hex digits to 16 bytes
+ *
+ * @return 0 when one of the characters is not a hex digit
+ */
+static inline int __hex_dec32_neon(const char *src, uint8_t *dst)
+{
+    uint8x16x2_t in = vld2q_u8((const uint8_t *)src);
+    uint8x16_t ok = vdupq_n_u8(0xFF);
+    uint8x16_t d, l, is_d, is_l;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        d = vsubq_u8(in.val[i], vdupq_n_u8('0'));
+        l = vsubq_u8(vorrq_u8(in.val[i], vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+        is_d = vcltq_u8(d, vdupq_n_u8(10));
+        is_l = vcltq_u8(l, vdupq_n_u8(6));
+        ok = vandq_u8(ok, vorrq_u8(is_d, is_l));
+        in.val[i] = vbslq_u8(is_d, d, vaddq_u8(l, vdupq_n_u8(10)));
+    }
+    if (0 == vminvq_u8(ok)) {
+        return 0;
+    }
+    vst1q_u8(dst, vorrq_u8(vshlq_n_u8(in.val[0], 4), in.val[1]));
+
+    return 1;
+}
+#endif
+
+/**
+ * @brief encode the whole groups of 3 bytes
+ *
+ * @return bytes encoded, a multiple of 3
+ */
+static size_t __b64_enc_groups(const uint8_t *src, size_t len, char *dst)
+{
+    size_t i = 0;
+    uint32_t w;
+
+#if TEXT_CODEC_NEON
+    uint8x16x4_t lut = vld1q_u8_x4((const uint8_t *)s_b64_enc);
+    for (; len - i >= 48; i += 48, dst += 64) {
+        __b64_enc48_neon(src + i, dst, lut);
+    }
+#elif TEXT_CODEC_SSSE3
+    for (; len - i >= 16; i += 12, dst += 16) {
+        __b64_enc12_ssse3(src + i, dst);
+    }
+#endif
+#if TEXT_CODEC_SWAR
+    for (; len - i >= 6; i += 6, dst += 8) {
+        __b64_enc6_swar(src + i, dst);
+    }
+#endif
+    for (; len - i >= 3; i += 3, dst += 4) {
+        w = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 | src[i + 2];
+        dst[0] = s_b64_enc[w >> 18];
+        dst[1] = s_b64_enc[(w >> 12) & 0x3F];
+        dst[2] = s_b64_enc[(w >> 6) & 0x3F];
+        dst[3] = s_b64_enc[w & 0x3F];
+    }
+
+    return i;
+}
+
+/**
+ * @brief encode the last 1 or 2 bytes with padding
+ */
+static size_t __b64_enc_tail(const uint8_t *src, size_t len, char *dst)
+{
+    uint32_t w;
+
+    if (0 == len) {
+        return 0;
+    }
+    w = (uint32_t)src[0] << 16 | (len > 1 ? (uint32_t)src[1] << 8 : 0);
+    dst[0] = s_b64_enc[w >> 18];
+    dst[1] = s_b64_enc[(w >> 12) & 0x3F];
+    dst[2] = len > 1 ? s_b64_enc[(w >> 6) & 0x3F] : '=';
+    dst[3] = '=';
+
+    return 4;
+}
+
+/**
+ * @brief decode the leading blocks made only of base64 alphabet characters
+ *
+ * @return characters decoded, a multiple of 4
+ */
+static size_t __b64_dec_blocks(const char *src, size_t len, uint8_t *dst)
+{
+    size_t i = 0;
+
+#if !(TEXT_CODEC_NEON || TEXT_CODEC_SSSE3 || TEXT_CODEC_SWAR)
+    //! no block engine, the caller decodes one character at a time
+    (void)src;
+    (void)len;
+    (void)dst;
+#endif
+#if TEXT_CODEC_NEON
+    uint8x16x4_t lo = vld1q_u8_x4(s_b64_dec);
+    uint8x16x4_t hi = vld1q_u8_x4(s_b64_dec + 64);
+    for (; len - i >= 64; i += 64, dst += 48) {
+        if (!__b64_dec64_neon(src + i, dst, lo, hi)) {
+            break;
+        }
+    }
+#elif TEXT_CODEC_SSSE3
+    for (; len - i >= 16; i += 16, dst += 12) {
+        if (!__b64_dec16_ssse3(src + i, dst)) {
+            break;
+        }
+    }
+#endif
+#if TEXT_CODEC_SWAR
+    for (; len - i >= 8; i += 8, dst += 6) {
+        if (!__b64_dec8_swar(src + i, dst)) {
+            break;
+        }
+    }
+#endif
+
+    return i;
+}
+
+/**
+ * @brief length of the base64 text of binary data
+ *
+ * @param[in] binlen bytes of binary data
+ *
+ * @return characters, without the '\0'
+ */
+size_t tuya_base64_encode_len(size_t binlen)
+{
+    return TUYA_BASE64_ENCODE_LEN(binlen);
+}
+
+/**
+ * @brief length of the binary data of base64 text, without decoding it
+ *
+ * @param[in] base64 the text, it is not validated
+ * @param[in] len characters of the text
+ *
+ * @return bytes the text decodes to when it is valid
+ */
+size_t tuya_base64_decode_len(const char *base64, size_t len)
+{
+    size_t i, n = 0;
+
+    for (i = 0; i < len; i++) {
+        n += s_b64_dec[(uint8_t)base64[i]] < 64;
+    }
+
+    return (n / 4) * 3 + ((n % 4) ? (n % 4) - 1 : 0);
+}
+
+/**
+ * @brief encode binary data to base64
+ *
+ * @param[in] bin binary data
+ * @param[in] len bytes of binary data
+ * @param[out] base64 the text and a '\0', tuya_base64_encode_len(len) + 1 bytes
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_base64_encode_buf(const uint8_t *bin, size_t len, char *base64)
+{
+    size_t done, n;
+
+    done = __b64_enc_groups(bin, len, base64);
+    n = done / 3 * 4;
+    n += __b64_enc_tail(bin + done, len - done, base64 + n);
+    base64[n] = '\0';
+
+    return n;
+}
+
+/**
+ * @brief decode base64 text to binary data
+ *
+ * @param[in] base64 the text
+ * @param[in] len characters of the text
+ * @param[out] bin binary data, tuya_base64_decode_len() bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64
+ */
+int tuya_base64_decode_buf(const char *base64, size_t len, uint8_t *bin)
+{
+    TUYA_BASE64_DEC_CTX_T ctx;
+    int n, last;
+
+    tuya_base64_dec_init(&ctx);
+    n = tuya_base64_dec_update(&ctx, base64, len, bin);
+    if (n < 0) {
+        return n;
+    }
+    last = tuya_base64_dec_final(&ctx, bin + n);
+    if (last < 0) {
+        return last;
+    }
+
+    return n + last;
+}
+
+/**
+ * @brief start encoding a payload given in chunks
+ *
+ * @param[out] ctx encode context
+ */
+void tuya_base64_enc_init(TUYA_BASE64_ENC_CTX_T *ctx)
+{
+    memset(ctx, 0, sizeof(TUYA_BASE64_ENC_CTX_T));
+}
+
+/**
+ * @brief encode a chunk, the bytes short of a group of 3 wait for the next
+ * chunk or tuya_base64_enc_final
+ *
+ * @param[in] ctx encode context
+ * @param[in] bin chunk
+ * @param[in] len bytes of the chunk
+ * @param[out] base64 text, TUYA_BASE64_ENCODE_LEN(len) bytes, no '\0' is added
+ *
+ * @return characters written
+ */
+size_t tuya_base64_enc_update(TUYA_BASE64_ENC_CTX_T *ctx, const uint8_t *bin, size_t len, char *base64)
+{
+    uint8_t group[3];
+    size_t n = 0, done;
+
+    if (ctx->carry_len) {
+        if (ctx->carry_len + len < 3) {
+            memcpy(ctx->carry + ctx->carry_len, bin, len);
+            ctx->carry_len += len;
+            return 0;
+        }
+        memcpy(group, ctx->carry, ctx->carry_len);
+        memcpy(group + ctx->carry_len, bin, 3 - ctx->carry_len);
+        bin += 3 - ctx->carry_len;
+        len -= 3 - ctx->carry_len;
+        ctx->carry_len = 0;
+        n = __b64_enc_groups(group, 3, base64) / 3 * 4;
+    }
+
+    done = __b64_enc_groups(bin, len, base64 + n);
+    n += done / 3 * 4;
+    ctx->carry_len = len - done;
+    memcpy(ctx->carry, bin + done, ctx->carry_len);
+
+    return n;
+}
+
+/**
+ * @brief encode the last bytes with padding and add the '\0'
+ *
+ * @param[in] ctx encode context
+ * @param[out] base64 text, 5 bytes
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_base64_enc_final(TUYA_BASE64_ENC_CTX_T *ctx, char *base64)
+{
+    size_t n;
+
+    n = __b64_enc_tail(ctx->carry, ctx->carry_len, base64);
+    base64[n] = '\0';
+    ctx->carry_len = 0;
+
+    return n;
+}
+
+/**
+ * @brief start decoding a text given in chunks
+ *
+ * @param[out] ctx decode context
+ */
+void tuya_base64_dec_init(TUYA_BASE64_DEC_CTX_T *ctx)
+{
+    memset(ctx, 0, sizeof(TUYA_BASE64_DEC_CTX_T));
+}
+
+/**
+ * @brief decode a chunk, the characters short of a group of 4 wait for the
+ * next chunk or tuya_base64_dec_final
+ *
+ * @param[in] ctx decode context
+ * @param[in] base64 chunk of text
+ * @param[in] len characters of the chunk
+ * @param[out] bin binary data, TUYA_BASE64_DECODE_LEN_MAX(len) bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64
+ */
+int tuya_base64_dec_update(TUYA_BASE64_DEC_CTX_T *ctx, const char *base64, size_t len, uint8_t *bin)
+{
+    uint8_t *out = bin;
+    size_t i = 0, n;
+    uint8_t v;
+
+    if (ctx->err) {
+        return OPRT_INVALID_PARM;
+    }
+
+    while (i < len) {
+        if (0 == ctx->acc_cnt && 0 == ctx->pad) {
+            n = __b64_dec_blocks(base64 + i, len - i, out);
+            i += n;
+            out += n / 4 * 3;
+            if (i == len) {
+                break;
+            }
+        }
+
+        //! one character at a time until the block engine can take over again
+        do {
+            v = s_b64_dec[(uint8_t)base64[i++]];
+            if (v < 64) {
+                if (ctx->pad) {
+                    goto __err;
+                }
+                ctx->acc = ctx->acc << 6 | v;
+                if (4 == ++ctx->acc_cnt) {
+                    out[0] = (uint8_t)(ctx->acc >> 16);
+                    out[1] = (uint8_t)(ctx->acc >> 8);
+                    out[2] = (uint8_t)ctx->acc;
+                    out += 3;
+                    ctx->acc = 0;
+                    ctx->acc_cnt = 0;
+                }
+            } else if (B64_PAD == v) {
+                if (ctx->pad) {
+                    //! pad - 1 more '=' are allowed
+                    if (1 == ctx->pad) {
+                        goto __err;
+                    }
+                    ctx->pad--;
+                    continue;
+                }
+                if (ctx->acc_cnt < 2) {
+                    goto __err;
+                }
+                if (2 == ctx->acc_cnt) {
+                    out[0] = (uint8_t)(ctx->acc >> 4);
+                    out += 1;
+                } else {
+                    out[0] = (uint8_t)(ctx->acc >> 10);
+                    out[1] = (uint8_t)(ctx->acc >> 2);
+                    out += 2;
+                }
+                ctx->pad = 4 - ctx->acc_cnt;
+                ctx->acc = 0;
+                ctx->acc_cnt = 0;
+            } else if (B64_BAD == v) {
+                goto __err;
+            }
+        } while (i < len && (ctx->acc_cnt || ctx->pad));
+    }
+
+    return (int)(out - bin);
+
+__err:
+    ctx->err = 1;
+    return OPRT_INVALID_PARM;
+}
+
+/**
+ * @brief decode the characters of a text without padding
+ *
+ * @param[in] ctx decode context
+ * @param[out] bin binary data, 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64 or is cut
+ */
+int tuya_base64_dec_final(TUYA_BASE64_DEC_CTX_T *ctx, uint8_t *bin)
+{
+    int n = 0;
+
+    if (ctx->err || 1 == ctx->acc_cnt) {
+        ctx->err = 1;
+        return OPRT_INVALID_PARM;
+    }
+    if (2 == ctx->acc_cnt) {
+        bin[0] = (uint8_t)(ctx->acc >> 4);
+        n = 1;
+    } else if (3 == ctx->acc_cnt) {
+        bin[0] = (uint8_t)(ctx->acc >> 10);
+        bin[1] = (uint8_t)(ctx->acc >> 2);
+        n = 2;
+    }
+    ctx->acc = 0;
+    ctx->acc_cnt = 0;
+
+    return n;
+}
+
+/**
+ * @brief length of the hex text of binary data
+ *
+ * @param[in] binlen bytes of binary data
+ *
+ * @return characters, without the '\0'
+ */
+size_t tuya_hex_encode_len(size_t binlen)
+{
+    return binlen * 2;
+}
+
+/**
+ * @brief length of the binary data of hex text
+ *
+ * @param[in] len characters of the text
+ *
+ * @return bytes
+ */
+size_t tuya_hex_decode_len(size_t len)
+{
+    return len / 2;
+}
+
+/**
+ * @brief encode binary data to hex, 2 digits per byte
+ *
+ * @param[in] bin binary data
+ * @param[in] len bytes of binary data
+ * @param[out] hex the text and a '\0', 2 * len + 1 bytes
+ * @param[in] upper TRUE for 'A'-'F', FALSE for 'a'-'f'
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_hex_encode_buf(const uint8_t *bin, size_t len, char *hex, BOOL_T upper)
+{
+    const char *digits = upper ? s_hex_upper : s_hex_lower;
+    size_t i = 0;
+
+#if TEXT_CODEC_NEON
+    uint8x16_t lut = vld1q_u8((const uint8_t *)digits);
+    for (; len - i >= 16; i += 16) {
+        __hex_enc16_neon(bin + i, hex + 2 * i, lut);
+    }
+#elif TEXT_CODEC_SSSE3
+    __m128i lut = _mm_loadu_si128((const __m128i *)digits);
+    for (; len - i >= 16; i += 16) {
+        __hex_enc16_ssse3(bin + i, hex + 2 * i, lut);
+    }
+#endif
+#if TEXT_CODEC_SWAR
+    for (; len - i >= 4; i += 4) {
+        __hex_enc4_swar(bin + i, hex + 2 * i, digits[10] - '9' - 1);
+    }
+#endif
+    for (; i < len; i++) {
+        hex[2 * i] = digits[bin[i] >> 4];
+        hex[2 * i + 1] = digits[bin[i] & 0x0F];
+    }
+    hex[2 * len] = '\0';
+
+    return 2 * len;
+}
+
+/**
+ * @brief decode hex text to binary data
+ *
+ * @param[in] hex the text, digits of either case
+ * @param[in] len characters of the text, even
+ * @param[out] bin binary data, len / 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not hex or len is odd
+ */
+int tuya_hex_decode_buf(const char *hex, size_t len, uint8_t *bin)
+{
+    TUYA_HEX_DEC_CTX_T ctx;
+    int n;
+
+    if (len % 2) {
+        return OPRT_INVALID_PARM;
+    }
+    tuya_hex_dec_init(&ctx);
+    n = tuya_hex_dec_update(&ctx, hex, len, bin);
+
+    return n;
+}
+
+/**
+ * @brief start decoding hex text given in chunks
+ *
+ * @param[out] ctx decode context
+ */
+void tuya_hex_dec_init(TUYA_HEX_DEC_CTX_T *ctx)
+{
+    ctx->carry = HEX_BAD;
+    ctx->err = 0;
+}
+
+/**
+ * @brief decode a chunk, a digit short of a byte waits for the next chunk
+ *
+ * @param[in] ctx decode context
+ * @param[in] hex chunk of text
+ * @param[in] len characters of the chunk
+ * @param[out] bin binary data, (len + 1) / 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not hex
+ */
+int tuya_hex_dec_update(TUYA_HEX_DEC_CTX_T *ctx, const char *hex, size_t len, uint8_t *bin)
+{
+    uint8_t *out = bin;
+    size_t i = 0;
+    uint8_t v;
+
+    if (ctx->err) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (HEX_BAD != ctx->carry && len) {
+        v = s_hex_dec[(uint8_t)hex[i++]];
+        if (HEX_BAD == v) {
+            goto __err;
+        }
+        *out++ = ctx->carry << 4 | v;
+        ctx->carry = HEX_BAD;
+    }
+
+#if TEXT_CODEC_NEON
+    for (; len - i >= 32; i += 32, out += 16) {
+        if (!__hex_dec32_neon(hex + i, out)) {
+            break;
+        }
+    }
+#elif TEXT_CODEC_SSSE3
+    for (; len - i >= 32; i += 32, out += 16) {
+        if (!__hex_dec32_ssse3(hex + i, out)) {
+            break;
+        }
+    }
+#endif
+#if TEXT_CODEC_SWAR
+    for (; len - i >= 8; i += 8, out += 4) {
+        if (!__hex_dec8_swar(hex + i, out)) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        v = s_hex_dec[(uint8_t)hex[i]];
+        if (HEX_BAD == v) {
+            goto __err;
+        }
+        if (HEX_BAD == ctx->carry) {
+            ctx->carry = v;
+        } else {
+            *out++ = ctx->carry << 4 | v;
+            ctx->carry = HEX_BAD;
+        }
+    }
+
+    return (int)(out - bin);
+
+__err:
+    ctx->err = 1;
+    return OPRT_INVALID_PARM;
+}
+
+/**
+ * @brief end of hex text given in chunks
+ *
+ * @param[in] ctx decode context
+ *
+ * @return OPRT_OK, OPRT_INVALID_PARM when the text is not hex or has an odd length
+ */
+int tuya_hex_dec_final(TUYA_HEX_DEC_CTX_T *ctx)
+{
+    if (ctx->err || HEX_BAD != ctx->carry) {
+        ctx->err = 1;
+        return OPRT_INVALID_PARM;
+    }
+
+    return OPRT_OK;
+}
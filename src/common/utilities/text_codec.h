@@ -0,0 +1,235 @@
+/**
+ * @file text_codec.h
+ * @brief Base64 and hex encoding of binary data.
+ *
+ * One-shot calls encode or decode a whole buffer, sizing calls give the
+ * length of the result without producing it, and the encode / decode
+ * contexts take a payload in chunks of any size, as it arrives from the
+ * network or a file. Encoded text is standard base64 (RFC 4648, '+' '/' and
+ * '=' padding) or hex digits; the decoders accept either case of hex digits,
+ * base64 without padding, and skip spaces, tabs and line breaks in base64.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TEXT_CODEC_H__
+#define __TEXT_CODEC_H__
+
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+/**
+ * @brief characters of the base64 text of binlen bytes, without the '\0'
+ */
+#define TUYA_BASE64_ENCODE_LEN(binlen) ((((binlen) + 2) / 3) * 4)
+
+/**
+ * @brief most bytes the base64 text of len characters decodes to
+ */
+#define TUYA_BASE64_DECODE_LEN_MAX(len) (((len) / 4) * 3 + 2)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    uint8_t carry[2]; // bytes waiting for a third one
+    uint8_t carry_len;
+} TUYA_BASE64_ENC_CTX_T;
+
+typedef struct {
+    uint32_t acc;    // 6 bits per character of the quantum being decoded
+    uint8_t acc_cnt; // characters in acc
+    uint8_t pad;     // '=' seen, only padding and spaces may follow
+    uint8_t err;     // invalid text, the following calls fail
+} TUYA_BASE64_DEC_CTX_T;
+
+typedef struct {
+    uint8_t carry; // first digit of a byte, 0xFF when there is none
+    uint8_t err;
+} TUYA_HEX_DEC_CTX_T;
+
+/***********************************************************
+********************function declaration********************
+***********************************************************/
+/**
+ * @brief length of the base64 text of binary data
+ *
+ * @param[in] binlen bytes of binary data
+ *
+ * @return characters, without the '\0'
+ */
+size_t tuya_base64_encode_len(size_t binlen);
+
+/**
+ * @brief length of the binary data of base64 text, without decoding it
+ *
+ * @param[in] base64 the text, it is not validated
+ * @param[in] len characters of the text
+ *
+ * @return bytes the text decodes to when it is valid
+ */
+size_t tuya_base64_decode_len(const char *base64, size_t len);
+
+/**
+ * @brief encode binary data to base64
+ *
+ * @param[in] bin binary data
+ * @param[in] len bytes of binary data
+ * @param[out] base64 the text and a '\0', tuya_base64_encode_len(len) + 1 bytes
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_base64_encode_buf(const uint8_t *bin, size_t len, char *base64);
+
+/**
+ * @brief decode base64 text to binary data
+ *
+ * @param[in] base64 the text
+ * @param[in] len characters of the text
+ * @param[out] bin binary data, tuya_base64_decode_len() bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64
+ */
+int tuya_base64_decode_buf(const char *base64, size_t len, uint8_t *bin);
+
+/**
+ * @brief start encoding a payload given in chunks
+ *
+ * @param[out] ctx encode context
+ */
+void tuya_base64_enc_init(TUYA_BASE64_ENC_CTX_T *ctx);
+
+/**
+ * @brief encode a chunk, the bytes short of a group of 3 wait for the next
+ * chunk or tuya_base64_enc_final
+ *
+ * @param[in] ctx encode context
+ * @param[in] bin chunk
+ * @param[in] len bytes of the chunk
+ * @param[out] base64 text, TUYA_BASE64_ENCODE_LEN(len) bytes, no '\0' is added
+ *
+ * @return characters written
+ */
+size_t tuya_base64_enc_update(TUYA_BASE64_ENC_CTX_T *ctx, const uint8_t *bin, size_t len, char *base64);
+
+/**
+ * @brief encode the last bytes with padding and add the '\0'
+ *
+ * @param[in] ctx encode context
+ * @param[out] base64 text, 5 bytes
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_base64_enc_final(TUYA_BASE64_ENC_CTX_T *ctx, char *base64);
+
+/**
+ * @brief start decoding a text given in chunks
+ *
+ * @param[out] ctx decode context
+ */
+void tuya_base64_dec_init(TUYA_BASE64_DEC_CTX_T *ctx);
+
+/**
+ * @brief decode a chunk, the characters short of a group of 4 wait for the
+ * next chunk or tuya_base64_dec_final
+ *
+ * @param[in] ctx decode context
+ * @param[in] base64 chunk of text
+ * @param[in] len characters of the chunk
+ * @param[out] bin binary data, TUYA_BASE64_DECODE_LEN_MAX(len) bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64
+ */
+int tuya_base64_dec_update(TUYA_BASE64_DEC_CTX_T *ctx, const char *base64, size_t len, uint8_t *bin);
+
+/**
+ * @brief decode the characters of a text without padding
+ *
+ * @param[in] ctx decode context
+ * @param[out] bin binary data, 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not base64 or is cut
+ */
+int tuya_base64_dec_final(TUYA_BASE64_DEC_CTX_T *ctx, uint8_t *bin);
+
+/**
+ * @brief length of the hex text of binary data
+ *
+ * @param[in] binlen bytes of binary data
+ *
+ * @return characters, without the '\0'
+ */
+size_t tuya_hex_encode_len(size_t binlen);
+
+/**
+ * @brief length of the binary data of hex text
+ *
+ * @param[in] len characters of the text
+ *
+ * @return bytes
+ */
+size_t tuya_hex_decode_len(size_t len);
+
+/**
+ * @brief encode binary data to hex, 2 digits per byte
+ *
+ * @param[in] bin binary data
+ * @param[in] len bytes of binary data
+ * @param[out] hex the text and a '\0', 2 * len + 1 bytes
+ * @param[in] upper TRUE for 'A'-'F', FALSE for 'a'-'f'
+ *
+ * @return characters written, without the '\0'
+ */
+size_t tuya_hex_encode_buf(const uint8_t *bin, size_t len, char *hex, BOOL_T upper);
+
+/**
+ * @brief decode hex text to binary data
+ *
+ * @param[in] hex the text, digits of either case
+ * @param[in] len characters of the text, even
+ * @param[out] bin binary data, len / 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not hex or len is odd
+ */
+int tuya_hex_decode_buf(const char *hex, size_t len, uint8_t *bin);
+
+/**
+ * @brief start decoding hex text given in chunks
+ *
+ * @param[out] ctx decode context
+ */
+void tuya_hex_dec_init(TUYA_HEX_DEC_CTX_T *ctx);
+
+/**
+ * @brief decode a chunk, a digit short of a byte waits for the next chunk
+ *
+ * @param[in] ctx decode context
+ * @param[in] hex chunk of text
+ * @param[in] len characters of the chunk
+ * @param[out] bin binary data, (len + 1) / 2 bytes
+ *
+ * @return bytes written, OPRT_INVALID_PARM when the text is not hex
+ */
+int tuya_hex_dec_update(TUYA_HEX_DEC_CTX_T *ctx, const char *hex, size_t len, uint8_t *bin);
+
+/**
+ * @brief end of hex text given in chunks
+ *
+ * @param[in] ctx decode context
+ *
+ * @return OPRT_OK, OPRT_INVALID_PARM when the text is not hex or has an odd length
+ */
+int tuya_hex_dec_final(TUYA_HEX_DEC_CTX_T *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TEXT_CODEC_H__ */
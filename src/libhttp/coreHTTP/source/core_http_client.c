@@ -2914,6 +2914,11 @@ HTTPStatus_t HTTPClient_Request( const TransportInterface_t * pTransport,
         }
     }
 
+    /* The body buffers are one byte longer, end the body so that it parses as a string */
+    if (pResponse->pBody) {
+        ((uint8_t *)pResponse->pBody)[pResponse->bodyLen] = '\0';
+    }
+
     if (chunkBuffer) {
         HTTP_FREE(chunkBuffer);
     }
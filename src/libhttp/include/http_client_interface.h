@@ -3,6 +3,11 @@
 
 #include "tuya_cloud_types.h"
 #include "tal_memory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @ingroup http_enum_types
  * @brief The HTTP interface return status.
@@ -64,4 +69,8 @@ http_client_status_t http_client_request(const http_client_request_t *request, h
 
 int http_client_free(http_client_response_t *response);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* ifndef HTTP_CLIENT_INTERFACE_H */
@@ -14,9 +14,74 @@
 static TKL_THREAD_HANDLE g_disp_thread_handle = NULL;
 static TKL_MUTEX_HANDLE g_disp_mutex = NULL;
 static TKL_SEM_HANDLE lvgl_sem = NULL;
+static TKL_SEM_HANDLE lvgl_wake_sem = NULL;
 static uint8_t lvgl_task_state = STATE_INIT;
 static bool lv_vendor_initialized = false;
 
+static void (*lvgl_flush_cb)(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+
+/* The task sleeps until the next LVGL timer is due, clamped to this range, or
+ * until lv_vendor_disp_unlock() or lv_vendor_wakeup() wakes it up. The upper
+ * bound keeps tuya_app_gui_feed_watchdog() fed while the UI is idle. */
+#ifndef LV_VENDOR_SLEEP_MIN
+#define LV_VENDOR_SLEEP_MIN 4
+#endif
+#ifndef LV_VENDOR_SLEEP_MAX
+#define LV_VENDOR_SLEEP_MAX 500
+#endif
+
+/* Input devices are polled every LV_VENDOR_INDEV_IDLE_PERIOD ms instead of
+ * every INDEV_READ_PERIOD ms once nothing was touched for
+ * LV_VENDOR_INDEV_IDLE_TIME ms. A driver that knows about input earlier, from
+ * an interrupt for instance, calls lv_vendor_wakeup(). 0 disables it, the
+ * default: the touch panels and keys of this tree are only polled, nothing
+ * calls lv_vendor_wakeup() on a first touch, which would wait for the slow
+ * poll. Boards with such a driver set it, e.g. to 100. */
+#ifndef LV_VENDOR_INDEV_IDLE_PERIOD
+#define LV_VENDOR_INDEV_IDLE_PERIOD 0
+#endif
+#ifndef LV_VENDOR_INDEV_IDLE_TIME
+#define LV_VENDOR_INDEV_IDLE_TIME 3000
+#endif
+
+#define STATS_PERIOD_MS 1000
+
+#define INDEV_READ_TIMER(indev) ((indev)->driver->read_timer)
+#define INDEV_READ_PERIOD       LV_INDEV_DEF_READ_PERIOD
+
+static volatile bool lvgl_indev_pending = false;
+static bool lvgl_indev_idle = false;
+
+static uint32_t frame_start_ms;
+static uint32_t frame_flush_ms;
+static uint32_t flush_start_ms;
+static bool frame_rendered;
+
+static uint32_t stats_start_ms;
+static lv_vendor_stats_t stats_acc;
+static lv_vendor_stats_t stats_last;
+static volatile uint32_t stats_seq; // odd while stats_last is written
+static uint32_t stats_render_sum;
+static uint32_t stats_flush_sum;
+
+static void lv_vendor_frame_done(uint32_t render_ms, uint32_t flush_ms);
+
+/* v8 has no display events: the flush callback is wrapped to time the flush
+ * and monitor_cb reports the whole refresh once something was drawn. */
+static void lv_vendor_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    uint32_t start = (uint32_t)tkl_system_get_millisecond();
+
+    lvgl_flush_cb(disp_drv, area, color_p);
+    frame_flush_ms += (uint32_t)tkl_system_get_millisecond() - start;
+}
+
+static void lv_vendor_monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+    lv_vendor_frame_done(time > frame_flush_ms ? time - frame_flush_ms : 0, frame_flush_ms);
+    frame_flush_ms = 0;
+}
+
 void lv_vendor_disp_lock(void)
 {
     tkl_mutex_lock(g_disp_mutex);
@@ -25,6 +90,119 @@ void lv_vendor_disp_lock(void)
 void lv_vendor_disp_unlock(void)
 {
     tkl_mutex_unlock(g_disp_mutex);
+
+    /* whatever was changed under the lock is drawn right away */
+    if (lvgl_wake_sem) {
+        tkl_semaphore_post(lvgl_wake_sem);
+    }
+}
+
+void lv_vendor_wakeup(void)
+{
+    lvgl_indev_pending = true;
+
+    if (lvgl_wake_sem) {
+        tkl_semaphore_post(lvgl_wake_sem);
+    }
+}
+
+void lv_vendor_get_stats(lv_vendor_stats_t *stats)
+{
+    uint32_t seq;
+
+    if (NULL == stats) {
+        return;
+    }
+
+    /* lock free, so it can be called from an LVGL callback as well */
+    do {
+        seq = stats_seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        *stats = stats_last;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != stats_seq);
+}
+
+static void lv_vendor_frame_done(uint32_t render_ms, uint32_t flush_ms)
+{
+    stats_acc.frames++;
+    stats_render_sum += render_ms;
+    stats_flush_sum += flush_ms;
+    if (render_ms > stats_acc.render_max_ms) {
+        stats_acc.render_max_ms = render_ms;
+    }
+    if (flush_ms > stats_acc.flush_max_ms) {
+        stats_acc.flush_max_ms = flush_ms;
+    }
+}
+
+/* called with g_disp_mutex held, once per pass of the task */
+static void lv_vendor_stats_update(void)
+{
+    uint32_t now = (uint32_t)tkl_system_get_millisecond();
+    uint32_t elapsed = now - stats_start_ms;
+    uint32_t frames = stats_acc.frames;
+
+    stats_acc.wakeups++;
+    if (elapsed < STATS_PERIOD_MS) {
+        return;
+    }
+
+    stats_acc.fps = frames * 1000 / elapsed;
+    stats_acc.render_avg_ms = frames ? stats_render_sum / frames : 0;
+    stats_acc.flush_avg_ms = frames ? stats_flush_sum / frames : 0;
+    stats_acc.frames_total = stats_last.frames_total + frames;
+    stats_seq++;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    stats_last = stats_acc;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    stats_seq++;
+
+    memset(&stats_acc, 0, sizeof(stats_acc));
+    stats_render_sum = 0;
+    stats_flush_sum = 0;
+    stats_start_ms = now;
+}
+
+static void lv_vendor_indev_set_period(uint32_t period)
+{
+    lv_indev_t *indev = lv_indev_get_next(NULL);
+
+    while (indev) {
+        lv_timer_t *timer = INDEV_READ_TIMER(indev);
+        if (timer) {
+            lv_timer_set_period(timer, period);
+            if (lvgl_indev_pending) {
+                lv_timer_ready(timer);
+            }
+        }
+        indev = lv_indev_get_next(indev);
+    }
+}
+
+/* called with g_disp_mutex held, before lv_task_handler() */
+static void lv_vendor_indev_update(void)
+{
+#if LV_VENDOR_INDEV_IDLE_PERIOD
+    if (lvgl_indev_pending) {
+        lv_vendor_indev_set_period(INDEV_READ_PERIOD);
+        lvgl_indev_pending = false;
+        lvgl_indev_idle = false;
+    } else if (lv_disp_get_inactive_time(NULL) >= LV_VENDOR_INDEV_IDLE_TIME) {
+        if (!lvgl_indev_idle) {
+            lv_vendor_indev_set_period(LV_VENDOR_INDEV_IDLE_PERIOD);
+            lvgl_indev_idle = true;
+        }
+    } else if (lvgl_indev_idle) {
+        lv_vendor_indev_set_period(INDEV_READ_PERIOD);
+        lvgl_indev_idle = false;
+    }
+#else
+    if (lvgl_indev_pending) {
+        lv_vendor_indev_set_period(INDEV_READ_PERIOD);
+        lvgl_indev_pending = false;
+    }
+#endif
 }
 
 void lv_vendor_init(void *device)
@@ -40,6 +218,11 @@ void lv_vendor_init(void *device)
 
     lv_port_indev_init(device);
 
+    lv_disp_drv_t *disp_drv = lv_disp_get_default()->driver;
+    lvgl_flush_cb = disp_drv->flush_cb;
+    disp_drv->flush_cb = lv_vendor_flush_cb;
+    disp_drv->monitor_cb = lv_vendor_monitor_cb;
+
     if (OPRT_OK != tkl_mutex_create_init(&g_disp_mutex)) {
         LV_LOG_ERROR("%s g_disp_mutex init failed\n", __func__);
         return;
@@ -50,6 +233,11 @@ void lv_vendor_init(void *device)
         return;
     }
 
+    if (OPRT_OK != tkl_semaphore_create_init(&lvgl_wake_sem, 0, 1)) {
+        LV_LOG_ERROR("%s wake semaphore init failed\n", __func__);
+        return;
+    }
+
     lv_vendor_initialized = true;
 
     LV_LOG_INFO("%s complete\n", __func__);
@@ -60,25 +248,29 @@ static void lv_tast_entry(void *arg)
     uint32_t sleep_time;
 
     lvgl_task_state = STATE_RUNNING;
+    stats_start_ms = (uint32_t)tkl_system_get_millisecond();
 
     tkl_semaphore_post(lvgl_sem);
 
     while(lvgl_task_state == STATE_RUNNING) {
-        lv_vendor_disp_lock();
+        /* not lv_vendor_disp_unlock(), the task must not wake itself up */
+        tkl_mutex_lock(g_disp_mutex);
+        lv_vendor_indev_update();
         sleep_time = lv_task_handler();
-        lv_vendor_disp_unlock();
+        lv_vendor_stats_update();
+        tkl_mutex_unlock(g_disp_mutex);
 
         #if CONFIG_LVGL_TASK_SLEEP_TIME_CUSTOMIZE
             sleep_time = CONFIG_LVGL_TASK_SLEEP_TIME;
         #else
-            if (sleep_time > 500) {
-                sleep_time = 500;
-            } else if (sleep_time < 4) {
-                sleep_time = 4;
+            if (sleep_time > LV_VENDOR_SLEEP_MAX) {
+                sleep_time = LV_VENDOR_SLEEP_MAX;
+            } else if (sleep_time < LV_VENDOR_SLEEP_MIN) {
+                sleep_time = LV_VENDOR_SLEEP_MIN;
             }
         #endif
 
-        tkl_system_sleep(sleep_time);
+        tkl_semaphore_wait(lvgl_wake_sem, sleep_time);
         // Modified by TUYA Start
         extern void tuya_app_gui_feed_watchdog(void);
         tuya_app_gui_feed_watchdog();
@@ -123,6 +315,9 @@ void lv_vendor_stop(void)
     }
 
     lvgl_task_state = STATE_STOP;
+    if (lvgl_wake_sem) {
+        tkl_semaphore_post(lvgl_wake_sem);
+    }
 
     tkl_semaphore_wait(lvgl_sem, TKL_SEM_WAIT_FOREVER);
 
@@ -70,6 +70,20 @@
     #endif
 #endif  /*LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN*/
 
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+    /*Size of the TLSF pool port/lv_port_mem.c reserves for LVGL at lv_init(), in PSRAM with ENABLE_EXT_RAM.
+     *More pools, in internal RAM for instance, can be given with lv_mem_add_pool().
+     *0: no pool, lv_malloc() goes straight to the system heap*/
+    #if defined(LVGL_MEM_POOL_SIZE)
+        #define LV_PORT_MEM_POOL_SIZE LVGL_MEM_POOL_SIZE
+    #else
+        #define LV_PORT_MEM_POOL_SIZE 0
+    #endif
+
+    /*Maximum number of pools, the first one included*/
+    #define LV_PORT_MEM_POOL_MAX 4
+#endif  /*LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM*/
+
 /*====================
    HAL SETTINGS
  *====================*/
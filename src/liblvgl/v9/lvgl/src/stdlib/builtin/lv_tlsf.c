@@ -1,5 +1,8 @@
 #include "../../lv_conf_internal.h"
-#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+// Modified by TUYA Start
+/* also used by the pools of port/lv_port_mem.c */
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN || LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+// Modified by TUYA End
 
 #include <limits.h>
 #include "lv_tlsf.h"
@@ -10,7 +13,11 @@
 #undef  printf
 #define printf LV_LOG_ERROR
 
+// Modified by TUYA Start
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
 #define TLSF_MAX_POOL_SIZE (LV_MEM_SIZE + LV_MEM_POOL_EXPAND_SIZE)
+#endif
+// Modified by TUYA End
 
 #if !defined(_DEBUG)
     #define _DEBUG 0
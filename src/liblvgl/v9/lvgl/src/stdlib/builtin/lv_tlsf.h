@@ -1,5 +1,7 @@
 ﻿#include "../../lv_conf_internal.h"
-#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+// Modified by TUYA Start
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN || LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+// Modified by TUYA End
 
 #ifndef LV_TLSF_H
 #define LV_TLSF_H
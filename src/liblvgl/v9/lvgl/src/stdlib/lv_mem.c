@@ -154,6 +154,15 @@ lv_result_t lv_mem_test(void)
         return LV_RESULT_INVALID;
     }
 
+// Modified by TUYA Start
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+    if(lv_mem_test_core() != LV_RESULT_OK) {
+        LV_LOG_WARN("failed");
+        return LV_RESULT_INVALID;
+    }
+#endif
+// Modified by TUYA End
+
 #if LV_USE_STDLIB_MALLOC != LV_STDLIB_CUSTOM
     if(lv_tlsf_check(tlsf)) {
         LV_LOG_WARN("failed");
@@ -173,9 +182,10 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
 {
     lv_memzero(mon_p, sizeof(lv_mem_monitor_t));
 
-#if LV_USE_STDLIB_MALLOC != LV_STDLIB_CUSTOM
+// Modified by TUYA Start
+    /* port/lv_port_mem.c reports its pools */
     lv_mem_monitor_core(mon_p);
-#endif
+// Modified by TUYA End
 }
 
 /**********************
@@ -26,14 +26,9 @@
  *********************/
 #define DISP_DRAW_BUF_ALIGN    4
 
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-#define LV_MEM_CUSTOM_ALLOC   tkl_system_psram_malloc
-#define LV_MEM_CUSTOM_FREE    tkl_system_psram_free
-#define LV_MEM_CUSTOM_REALLOC tkl_system_psram_realloc
-#else
-#define LV_MEM_CUSTOM_ALLOC   tkl_system_malloc
-#define LV_MEM_CUSTOM_FREE    tkl_system_free
-#define LV_MEM_CUSTOM_REALLOC tkl_system_realloc
+/*bytes of draw buffers LVGL may hold, 0: not limited*/
+#ifndef LV_DISP_DRAW_BUF_MEM_BUDGET
+#define LV_DISP_DRAW_BUF_MEM_BUDGET 0
 #endif
 
 #define LV_DISP_FB_MAX_NUM    3
@@ -70,6 +65,9 @@ static void __disp_dma2d_init(void);
  *  STATIC VARIABLES
  **********************/
 static TDL_DISP_HANDLE_T sg_tdl_disp_hdl = NULL;
+/*draw buffers go to PSRAM when the board has it, as the LVGL heap does*/
+static TAL_MEM_BUDGET_DEFINE(sg_lv_draw_buf_budget, "lv_draw_buf", LV_DISP_DRAW_BUF_MEM_BUDGET, TAL_MEM_PLACE_PSRAM,
+                              TAL_MEM_BUDGET_STRICT);
 static TDL_DISP_DEV_INFO_T sg_display_info;
 
 static LV_DISP_FRAME_BUFF_T sg_disp_fb_arr[LV_DISP_FB_MAX_NUM];
@@ -443,7 +441,7 @@ static uint8_t *__disp_draw_buf_align_alloc(uint32_t size_bytes)
     uint8_t *buf_u8= NULL;
     /*Allocate larger memory to be sure it can be aligned as needed*/
     size_bytes += DISP_DRAW_BUF_ALIGN - 1;
-    buf_u8 = (uint8_t *)LV_MEM_CUSTOM_ALLOC(size_bytes);
+    buf_u8 = (uint8_t *)tal_mem_budget_malloc(&sg_lv_draw_buf_budget, size_bytes);
     if (buf_u8) {
         buf_u8 += DISP_DRAW_BUF_ALIGN - 1;
         buf_u8 = (uint8_t *)((uint32_t) buf_u8 & ~(DISP_DRAW_BUF_ALIGN - 1));
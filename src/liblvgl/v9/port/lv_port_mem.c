@@ -1,5 +1,12 @@
 /**
  * @file lv_malloc_core_tuya.c
+ *
+ * With LV_PORT_MEM_POOL_SIZE set, LVGL allocates from its own TLSF pools
+ * instead of the system heap, so widget churn no longer fragments the heap
+ * shared with the rest of the application. The first pool is reserved by the
+ * first allocation, in lv_init() (which does not call lv_mem_init() for a
+ * custom allocator), more can be added with lv_mem_add_pool(). A request no
+ * pool can serve falls back to the system heap.
  */
 
 /*********************
@@ -7,14 +14,47 @@
  *********************/
 #include "lvgl.h"
 #include "tkl_memory.h"
+#include "tkl_mutex.h"
+
+#if LV_PORT_MEM_POOL_SIZE
+#include "lvgl/src/stdlib/builtin/lv_tlsf.h"
+#endif
 
 /*********************
  *      DEFINES
  *********************/
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+#define SYS_MALLOC(size)     tkl_system_psram_malloc(size)
+#define SYS_REALLOC(p, size) tkl_system_psram_realloc(p, size)
+#define SYS_FREE(p)          tkl_system_psram_free(p)
+#else
+#define SYS_MALLOC(size)     tkl_system_malloc(size)
+#define SYS_REALLOC(p, size) tkl_system_realloc(p, size)
+#define SYS_FREE(p)          tkl_system_free(p)
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_PORT_MEM_POOL_SIZE
+typedef struct {
+    lv_pool_t pool;
+    uint8_t *start;
+    uint8_t *end;
+} lv_port_pool_t;
+
+typedef struct {
+    bool inited;
+    TKL_MUTEX_HANDLE mutex;
+    lv_tlsf_t tlsf;
+    void *first_mem;
+    lv_port_pool_t pools[LV_PORT_MEM_POOL_MAX];
+    uint32_t pool_cnt;
+    size_t cur_used;
+    size_t max_used;
+    uint32_t sys_fallback;
+} lv_port_mem_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -23,15 +63,264 @@
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if LV_PORT_MEM_POOL_SIZE
+static lv_port_mem_t sg_mem;
+#endif
 
 /**********************
  *      MACROS
  **********************/
+#if LV_PORT_MEM_POOL_SIZE
+#define MEM_LOCK()   tkl_mutex_lock(sg_mem.mutex)
+#define MEM_UNLOCK() tkl_mutex_unlock(sg_mem.mutex)
+#endif
 
 /**********************
  *   GLOBAL FUNCTIONS
  **********************/
 
+#if LV_PORT_MEM_POOL_SIZE
+
+static bool lv_port_mem_in_pool(const void *p)
+{
+    uint32_t i;
+
+    for (i = 0; i < sg_mem.pool_cnt; i++) {
+        if ((const uint8_t *)p >= sg_mem.pools[i].start && (const uint8_t *)p < sg_mem.pools[i].end) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void lv_port_mem_pool_record(lv_pool_t pool, void *mem, size_t bytes)
+{
+    lv_port_pool_t *rec = &sg_mem.pools[sg_mem.pool_cnt++];
+
+    rec->pool = pool;
+    rec->start = (uint8_t *)mem;
+    rec->end = (uint8_t *)mem + bytes;
+}
+
+static void lv_port_mem_walker(void *ptr, size_t size, int used, void *user)
+{
+    lv_mem_monitor_t *mon_p = user;
+
+    LV_UNUSED(ptr);
+
+    mon_p->total_size += size;
+    if (used) {
+        mon_p->used_cnt++;
+    } else {
+        mon_p->free_cnt++;
+        mon_p->free_size += size;
+        if (size > mon_p->free_biggest_size) {
+            mon_p->free_biggest_size = size;
+        }
+    }
+}
+
+void lv_mem_init(void)
+{
+    lv_memzero(&sg_mem, sizeof(sg_mem));
+    sg_mem.inited = true;
+
+    if (OPRT_OK != tkl_mutex_create_init(&sg_mem.mutex)) {
+        LV_LOG_ERROR("lv mem mutex init failed");
+        return;
+    }
+
+    sg_mem.first_mem = SYS_MALLOC(LV_PORT_MEM_POOL_SIZE);
+    if (NULL == sg_mem.first_mem) {
+        LV_LOG_WARN("lv mem pool %d alloc failed, use the system heap", LV_PORT_MEM_POOL_SIZE);
+        return;
+    }
+
+    sg_mem.tlsf = lv_tlsf_create_with_pool(sg_mem.first_mem, LV_PORT_MEM_POOL_SIZE);
+    lv_port_mem_pool_record(lv_tlsf_get_pool(sg_mem.tlsf), sg_mem.first_mem, LV_PORT_MEM_POOL_SIZE);
+}
+
+void lv_mem_deinit(void)
+{
+    if (sg_mem.tlsf) {
+        lv_tlsf_destroy(sg_mem.tlsf);
+    }
+    SYS_FREE(sg_mem.first_mem);
+    if (sg_mem.mutex) {
+        tkl_mutex_release(sg_mem.mutex);
+    }
+    lv_memzero(&sg_mem, sizeof(sg_mem));
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
+{
+    lv_pool_t pool = NULL;
+
+    if (!sg_mem.inited) {
+        lv_mem_init();
+    }
+    if (NULL == sg_mem.tlsf || NULL == mem) {
+        return NULL;
+    }
+
+    MEM_LOCK();
+    if (sg_mem.pool_cnt < LV_PORT_MEM_POOL_MAX) {
+        pool = lv_tlsf_add_pool(sg_mem.tlsf, mem, bytes);
+        if (pool) {
+            lv_port_mem_pool_record(pool, mem, bytes);
+        }
+    }
+    MEM_UNLOCK();
+
+    if (NULL == pool) {
+        LV_LOG_WARN("failed to add memory pool, address: %p, size: %zu", mem, bytes);
+    }
+
+    return pool;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool)
+{
+    uint32_t i;
+
+    MEM_LOCK();
+    // the first pool belongs to the TLSF control structure
+    for (i = 1; i < sg_mem.pool_cnt; i++) {
+        if (sg_mem.pools[i].pool == pool) {
+            lv_tlsf_remove_pool(sg_mem.tlsf, pool);
+            sg_mem.pools[i] = sg_mem.pools[--sg_mem.pool_cnt];
+            MEM_UNLOCK();
+            return;
+        }
+    }
+    MEM_UNLOCK();
+
+    LV_LOG_WARN("invalid pool: %p", pool);
+}
+
+void *lv_malloc_core(size_t size)
+{
+    void *p = NULL;
+
+    if (!sg_mem.inited) {
+        lv_mem_init();
+    }
+    if (sg_mem.tlsf) {
+        MEM_LOCK();
+        p = lv_tlsf_malloc(sg_mem.tlsf, size);
+        if (p) {
+            sg_mem.cur_used += lv_tlsf_block_size(p);
+            sg_mem.max_used = LV_MAX(sg_mem.cur_used, sg_mem.max_used);
+        }
+        MEM_UNLOCK();
+        if (p) {
+            return p;
+        }
+        if (0 == sg_mem.sys_fallback++) {
+            LV_LOG_WARN("lv mem pools exhausted, fall back to the system heap");
+        }
+    }
+
+    return SYS_MALLOC(size);
+}
+
+void *lv_realloc_core(void *p, size_t new_size)
+{
+    void *p_new = NULL;
+    size_t old_size;
+
+    if (NULL == p || !lv_port_mem_in_pool(p)) {
+        return SYS_REALLOC(p, new_size);
+    }
+
+    MEM_LOCK();
+    old_size = lv_tlsf_block_size(p);
+    p_new = lv_tlsf_realloc(sg_mem.tlsf, p, new_size);
+    if (p_new) {
+        sg_mem.cur_used -= old_size;
+        sg_mem.cur_used += lv_tlsf_block_size(p_new);
+        sg_mem.max_used = LV_MAX(sg_mem.cur_used, sg_mem.max_used);
+    }
+    MEM_UNLOCK();
+
+    if (NULL == p_new && new_size) {
+        // the pools are full, move the block to the system heap
+        p_new = SYS_MALLOC(new_size);
+        if (p_new) {
+            lv_memcpy(p_new, p, LV_MIN(old_size, new_size));
+            lv_free_core(p);
+        }
+    }
+
+    return p_new;
+}
+
+void lv_free_core(void *p)
+{
+    size_t size;
+
+    if (NULL == p || !lv_port_mem_in_pool(p)) {
+        SYS_FREE(p);
+        return;
+    }
+
+    MEM_LOCK();
+    size = lv_tlsf_block_size(p);
+    lv_tlsf_free(sg_mem.tlsf, p);
+    sg_mem.cur_used = sg_mem.cur_used > size ? sg_mem.cur_used - size : 0;
+    MEM_UNLOCK();
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
+{
+    uint32_t i;
+
+    lv_memzero(mon_p, sizeof(lv_mem_monitor_t));
+    if (NULL == sg_mem.tlsf) {
+        return;
+    }
+
+    MEM_LOCK();
+    for (i = 0; i < sg_mem.pool_cnt; i++) {
+        lv_tlsf_walk_pool(sg_mem.pools[i].pool, lv_port_mem_walker, mon_p);
+    }
+    mon_p->max_used = sg_mem.max_used;
+    MEM_UNLOCK();
+
+    if (mon_p->total_size) {
+        mon_p->used_pct = 100 - (uint64_t)100U * mon_p->free_size / mon_p->total_size;
+    }
+    if (mon_p->free_size > 0) {
+        mon_p->frag_pct = 100 - (uint64_t)mon_p->free_biggest_size * 100U / mon_p->free_size;
+    }
+}
+
+lv_result_t lv_mem_test_core(void)
+{
+    lv_result_t res = LV_RESULT_OK;
+    uint32_t i;
+
+    if (NULL == sg_mem.tlsf) {
+        return LV_RESULT_OK;
+    }
+
+    MEM_LOCK();
+    if (lv_tlsf_check(sg_mem.tlsf)) {
+        res = LV_RESULT_INVALID;
+    }
+    for (i = 0; i < sg_mem.pool_cnt && LV_RESULT_OK == res; i++) {
+        if (lv_tlsf_check_pool(sg_mem.pools[i].pool)) {
+            res = LV_RESULT_INVALID;
+        }
+    }
+    MEM_UNLOCK();
+
+    return res;
+}
+
+#else
+
 void lv_mem_init(void)
 {
     return; /*Nothing to init*/
@@ -44,7 +333,7 @@ void lv_mem_deinit(void)
 
 lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
 {
-    /*Not supported*/
+    /*Not supported without LV_PORT_MEM_POOL_SIZE*/
     LV_UNUSED(mem);
     LV_UNUSED(bytes);
     return NULL;
@@ -52,41 +341,29 @@ lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
 
 void lv_mem_remove_pool(lv_mem_pool_t pool)
 {
-    /*Not supported*/
+    /*Not supported without LV_PORT_MEM_POOL_SIZE*/
     LV_UNUSED(pool);
     return;
 }
 
 void *lv_malloc_core(size_t size)
 {
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-    return tkl_system_psram_malloc(size);
-#else
-    return tkl_system_malloc(size);
-#endif
+    return SYS_MALLOC(size);
 }
 
 void *lv_realloc_core(void *p, size_t new_size)
 {
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-    return tkl_system_psram_realloc(p, new_size);
-#else
-    return tkl_system_realloc(p, new_size);
-#endif
+    return SYS_REALLOC(p, new_size);
 }
 
 void lv_free_core(void *p)
 {
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-    tkl_system_psram_free(p);
-#else
-    tkl_system_free(p);
-#endif
+    SYS_FREE(p);
 }
 
 void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
 {
-    /*Not supported*/
+    /*The system heap does not report per user figures*/
     LV_UNUSED(mon_p);
     return;
 }
@@ -96,3 +373,5 @@ lv_result_t lv_mem_test_core(void)
     /*Not supported*/
     return LV_RESULT_OK;
 }
+
+#endif /*LV_PORT_MEM_POOL_SIZE*/
@@ -17,6 +17,18 @@ typedef enum{
     STATE_STOP
 } lvgl_task_state_t;
 
+/* Rendering statistics of the last complete second */
+typedef struct {
+    uint32_t fps;           // frames drawn
+    uint32_t render_avg_ms; // per frame: layout and drawing
+    uint32_t render_max_ms;
+    uint32_t flush_avg_ms;  // per frame: flush callbacks and waiting for them
+    uint32_t flush_max_ms;
+    uint32_t wakeups;       // passes of the LVGL task
+    uint32_t frames;        // frames drawn in the second
+    uint32_t frames_total;  // frames drawn since the task started
+} lv_vendor_stats_t;
+
 void lv_vendor_init(void *device);
 void lv_vendor_start(uint32_t lvgl_task_pri, uint32_t lvgl_stack_size);
 void lv_vendor_stop(void);
@@ -24,6 +36,12 @@ void lv_vendor_disp_lock(void);
 void lv_vendor_disp_unlock(void);
 void lv_vendor_set_backlight(uint8_t brightness);
 
+/* Wakes the LVGL task up and reads the input devices right away, e.g. from a
+ * touch interrupt or a key callback. Safe to call from any thread. */
+void lv_vendor_wakeup(void);
+
+void lv_vendor_get_stats(lv_vendor_stats_t *stats);
+
 #ifdef __cplusplus
 } /*extern "C"*/
 #endif
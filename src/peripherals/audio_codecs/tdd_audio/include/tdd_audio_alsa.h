@@ -10,6 +10,12 @@
  * The TDD (Tuya Device Driver) layer acts as an abstraction between ALSA-specific
  * implementations and the higher-level TDL (Tuya Driver Layer) audio management system.
  *
+ * Two transfer modes are available. The default one uses snd_pcm_readi/writei
+ * (RW_INTERLEAVED). With mmap_enable the driver uses MMAP_INTERLEAVED instead:
+ * the capture thread sleeps in poll() on the PCM descriptors and hands mic_cb
+ * pointers straight into the DMA ring, one period at a time, and play writes
+ * into the ring without an intermediate buffer.
+ *
  * This driver is only available when ENABLE_AUDIO_ALSA is enabled and the Ubuntu
  * platform is selected.
  *
@@ -83,8 +89,28 @@ typedef struct {
 
     // Optional features
     uint8_t aec_enable;                   /**< Enable acoustic echo cancellation (future use) */
+
+    // Transfer settings
+    uint8_t mmap_enable;                  /**< Use MMAP_INTERLEAVED driven by poll() instead of readi/writei */
+    uint32_t latency_ms;                  /**< Target buffer latency, overrides buffer_frames and period_frames
+                                               when not 0: the buffer holds latency_ms split in 4 periods */
 } TDD_AUDIO_ALSA_CFG_T;
 
+/**
+ * @brief ALSA stream statistics, counted since the device was opened
+ */
+typedef struct {
+    uint32_t capture_xruns;               /**< Capture overruns recovered */
+    uint32_t playback_xruns;              /**< Playback underruns recovered */
+    uint64_t capture_frames;              /**< Frames handed to mic_cb */
+    uint64_t playback_frames;             /**< Frames queued for playback */
+    uint32_t capture_period_frames;       /**< Capture period size granted by the device */
+    uint32_t capture_buffer_frames;       /**< Capture buffer size granted by the device */
+    uint32_t playback_period_frames;      /**< Playback period size granted by the device */
+    uint32_t playback_buffer_frames;      /**< Playback buffer size granted by the device */
+    uint32_t playback_delay_frames;       /**< Frames queued ahead of the speaker after the last play */
+} TDD_AUDIO_ALSA_STATS_T;
+
 /***********************************************************
 ********************function declaration********************
 ***********************************************************/
@@ -106,6 +132,18 @@ typedef struct {
  */
 OPERATE_RET tdd_audio_alsa_register(char *name, TDD_AUDIO_ALSA_CFG_T cfg);
 
+/**
+ * @brief Get the stream statistics of a registered ALSA audio driver
+ *
+ * @param[in] name      Driver name given to tdd_audio_alsa_register
+ * @param[out] stats    Statistics
+ *
+ * @return OPERATE_RET
+ * @retval OPRT_OK              Success
+ * @retval OPRT_NOT_FOUND       No ALSA driver registered with this name
+ */
+OPERATE_RET tdd_audio_alsa_get_stats(char *name, TDD_AUDIO_ALSA_STATS_T *stats);
+
 #ifdef __cplusplus
 }
 #endif
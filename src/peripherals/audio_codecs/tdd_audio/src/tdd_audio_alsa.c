@@ -12,6 +12,10 @@
  * - ALSA device registration and initialization
  * - Microphone data capture with threaded callback mechanism
  * - Speaker playback with ALSA PCM interface
+ * - Optional MMAP_INTERLEAVED transfer driven by poll(): captured periods are
+ *   handed to the callback in place in the DMA ring and played data is written
+ *   straight into it
+ * - Latency targets and xrun statistics
  * - Volume control through ALSA mixer API
  * - Frame-based audio data processing
  * - Proper resource cleanup and error handling
@@ -28,6 +32,7 @@
 #if defined(ENABLE_AUDIO_ALSA) && (ENABLE_AUDIO_ALSA == 1)
 
 #include <alsa/asoundlib.h>
+#include <poll.h>
 #include <pthread.h>
 
 #include "tal_log.h"
@@ -44,12 +49,20 @@
 #define ALSA_CAPTURE_THREAD_STACK_SIZE (4096)
 #define ALSA_CAPTURE_THREAD_PRIORITY   (THREAD_PRIO_2)
 
+#define ALSA_LATENCY_PERIODS 4   // periods per buffer when latency_ms is set
+#define ALSA_POLL_FD_MAX     8
+#define ALSA_POLL_TIMEOUT_MS 100 // bounds how long close() waits for the capture thread
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
-typedef struct {
+typedef struct tdd_audio_alsa_handle {
+    struct tdd_audio_alsa_handle *next;
+    char name[32];
+
     TDD_AUDIO_ALSA_CFG_T cfg;
     TDL_AUDIO_MIC_CB mic_cb;
+    uint32_t frame_bytes;
 
     // ALSA handles
     snd_pcm_t *capture_handle;
@@ -66,15 +79,18 @@ typedef struct {
     long mixer_min;
     long mixer_max;
 
-    // Buffer
+    // Buffer, readi mode only
     uint8_t *capture_buffer;
     uint32_t capture_buffer_size;
+
+    TDD_AUDIO_ALSA_STATS_T stats;
 } TDD_AUDIO_ALSA_HANDLE_T;
 
 /***********************************************************
 ********************function declaration********************
 ***********************************************************/
 static void *__alsa_capture_thread(void *arg);
+static void *__alsa_capture_mmap_thread(void *arg);
 static OPERATE_RET __alsa_setup_capture(TDD_AUDIO_ALSA_HANDLE_T *hdl);
 static OPERATE_RET __alsa_setup_playback(TDD_AUDIO_ALSA_HANDLE_T *hdl);
 static OPERATE_RET __alsa_setup_mixer(TDD_AUDIO_ALSA_HANDLE_T *hdl);
@@ -82,6 +98,7 @@ static OPERATE_RET __alsa_setup_mixer(TDD_AUDIO_ALSA_HANDLE_T *hdl);
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
+static TDD_AUDIO_ALSA_HANDLE_T *sg_alsa_list = NULL;
 
 /***********************************************************
 ***********************function define**********************
@@ -106,13 +123,99 @@ static snd_pcm_format_t __get_alsa_format(TDD_ALSA_DATABITS_E bits)
     }
 }
 
+/**
+ * @brief Apply the hardware and software parameters shared by both streams
+ *
+ * The buffer and period sizes come from latency_ms when it is set, otherwise
+ * from buffer_frames and period_frames. The device may grant each stream
+ * different sizes, they are returned in period_frames and buffer_frames.
+ */
+static int __alsa_set_params(TDD_AUDIO_ALSA_HANDLE_T *hdl, snd_pcm_t *pcm, unsigned int *rate,
+                             uint32_t *period_frames, uint32_t *buffer_frames)
+{
+    int err;
+    snd_pcm_hw_params_t *hw_params = NULL;
+    snd_pcm_sw_params_t *sw_params = NULL;
+    snd_pcm_access_t access = hdl->cfg.mmap_enable ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED;
+    snd_pcm_uframes_t buffer_size = hdl->cfg.buffer_frames;
+    snd_pcm_uframes_t period_size = hdl->cfg.period_frames;
+
+    if (hdl->cfg.latency_ms) {
+        buffer_size = (snd_pcm_uframes_t)(*rate) * hdl->cfg.latency_ms / 1000;
+        period_size = buffer_size / ALSA_LATENCY_PERIODS;
+    }
+
+    // Allocate hardware parameters object
+    snd_pcm_hw_params_alloca(&hw_params);
+    snd_pcm_hw_params_any(pcm, hw_params);
+
+    // Set parameters
+    err = snd_pcm_hw_params_set_access(pcm, hw_params, access);
+    if (err < 0) {
+        PR_ERR("Access %s not supported: %s", hdl->cfg.mmap_enable ? "mmap" : "rw", snd_strerror(err));
+        return err;
+    }
+    snd_pcm_hw_params_set_format(pcm, hw_params, __get_alsa_format(hdl->cfg.data_bits));
+    snd_pcm_hw_params_set_channels(pcm, hw_params, hdl->cfg.channels);
+    snd_pcm_hw_params_set_rate_near(pcm, hw_params, rate, 0);
+
+    // Period first, so the buffer is rounded to a whole number of periods
+    snd_pcm_hw_params_set_period_size_near(pcm, hw_params, &period_size, 0);
+    snd_pcm_hw_params_set_buffer_size_near(pcm, hw_params, &buffer_size);
+
+    // Write parameters to device
+    err = snd_pcm_hw_params(pcm, hw_params);
+    if (err < 0) {
+        return err;
+    }
+    snd_pcm_get_params(pcm, &buffer_size, &period_size);
+    *buffer_frames = buffer_size;
+    *period_frames = period_size;
+
+    // Wake up once a period is ready. Playback starts once half the buffer is queued; capture starts at the
+    // first read, a threshold above the period would keep readi from ever starting it
+    snd_pcm_sw_params_alloca(&sw_params);
+    snd_pcm_sw_params_current(pcm, sw_params);
+    snd_pcm_sw_params_set_avail_min(pcm, sw_params, period_size);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw_params,
+                                          SND_PCM_STREAM_PLAYBACK == snd_pcm_stream(pcm) ? buffer_size / 2 : 1);
+    return snd_pcm_sw_params(pcm, sw_params);
+}
+
+/**
+ * @brief Recover a stream from an xrun or a suspend, and count it
+ */
+static int __alsa_recover(TDD_AUDIO_ALSA_HANDLE_T *hdl, snd_pcm_t *pcm, int err)
+{
+    if (-EPIPE == err) {
+        if (pcm == hdl->capture_handle) {
+            hdl->stats.capture_xruns++;
+            PR_WARN("ALSA capture overrun occurred");
+        } else {
+            hdl->stats.playback_xruns++;
+            PR_WARN("ALSA playback underrun occurred");
+        }
+    }
+
+    err = snd_pcm_recover(pcm, err, 1);
+    if (err < 0) {
+        return err;
+    }
+
+    // a capture stream in mmap mode does not restart by itself
+    if (hdl->cfg.mmap_enable && pcm == hdl->capture_handle) {
+        err = snd_pcm_start(pcm);
+    }
+
+    return err;
+}
+
 /**
  * @brief Setup ALSA capture device
  */
 static OPERATE_RET __alsa_setup_capture(TDD_AUDIO_ALSA_HANDLE_T *hdl)
 {
     int err;
-    snd_pcm_hw_params_t *hw_params = NULL;
 
     // Open PCM device for capture (non-blocking mode to avoid hanging)
     err = snd_pcm_open(&hdl->capture_handle, hdl->cfg.capture_device, SND_PCM_STREAM_CAPTURE, SND_PCM_NONBLOCK);
@@ -122,27 +225,13 @@ static OPERATE_RET __alsa_setup_capture(TDD_AUDIO_ALSA_HANDLE_T *hdl)
         return OPRT_COM_ERROR;
     }
 
-    // Switch back to blocking mode for normal operation
-    snd_pcm_nonblock(hdl->capture_handle, 0);
-
-    // Allocate hardware parameters object
-    snd_pcm_hw_params_alloca(&hw_params);
-    snd_pcm_hw_params_any(hdl->capture_handle, hw_params);
-
-    // Set parameters
-    snd_pcm_hw_params_set_access(hdl->capture_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(hdl->capture_handle, hw_params, __get_alsa_format(hdl->cfg.data_bits));
-    snd_pcm_hw_params_set_channels(hdl->capture_handle, hw_params, hdl->cfg.channels);
-    snd_pcm_hw_params_set_rate_near(hdl->capture_handle, hw_params, (unsigned int *)&hdl->cfg.sample_rate, 0);
-
-    // Set buffer and period sizes
-    snd_pcm_uframes_t buffer_size = hdl->cfg.buffer_frames;
-    snd_pcm_uframes_t period_size = hdl->cfg.period_frames;
-    snd_pcm_hw_params_set_buffer_size_near(hdl->capture_handle, hw_params, &buffer_size);
-    snd_pcm_hw_params_set_period_size_near(hdl->capture_handle, hw_params, &period_size, 0);
+    // readi blocks in the capture thread, the mmap thread waits in poll() instead
+    if (!hdl->cfg.mmap_enable) {
+        snd_pcm_nonblock(hdl->capture_handle, 0);
+    }
 
-    // Write parameters to device
-    err = snd_pcm_hw_params(hdl->capture_handle, hw_params);
+    err = __alsa_set_params(hdl, hdl->capture_handle, (unsigned int *)&hdl->cfg.sample_rate,
+                            &hdl->stats.capture_period_frames, &hdl->stats.capture_buffer_frames);
     if (err < 0) {
         PR_ERR("Cannot set capture parameters: %s", snd_strerror(err));
         snd_pcm_close(hdl->capture_handle);
@@ -159,18 +248,21 @@ static OPERATE_RET __alsa_setup_capture(TDD_AUDIO_ALSA_HANDLE_T *hdl)
         return OPRT_COM_ERROR;
     }
 
-    // Calculate buffer size
-    hdl->capture_buffer_size = hdl->cfg.period_frames * hdl->cfg.channels * (hdl->cfg.data_bits / 8);
-    hdl->capture_buffer = (uint8_t *)tal_malloc(hdl->capture_buffer_size);
-    if (NULL == hdl->capture_buffer) {
-        PR_ERR("Cannot allocate capture buffer");
-        snd_pcm_close(hdl->capture_handle);
-        hdl->capture_handle = NULL;
-        return OPRT_MALLOC_FAILED;
+    // Calculate buffer size, mmap mode reads in place
+    if (!hdl->cfg.mmap_enable) {
+        hdl->capture_buffer_size = hdl->stats.capture_period_frames * hdl->frame_bytes;
+        hdl->capture_buffer = (uint8_t *)tal_malloc(hdl->capture_buffer_size);
+        if (NULL == hdl->capture_buffer) {
+            PR_ERR("Cannot allocate capture buffer");
+            snd_pcm_close(hdl->capture_handle);
+            hdl->capture_handle = NULL;
+            return OPRT_MALLOC_FAILED;
+        }
     }
 
-    PR_INFO("ALSA capture device setup: %s, rate=%d, channels=%d, bits=%d", hdl->cfg.capture_device,
-            hdl->cfg.sample_rate, hdl->cfg.channels, hdl->cfg.data_bits);
+    PR_INFO("ALSA capture device setup: %s, rate=%d, channels=%d, bits=%d, period=%d, buffer=%d, %s",
+            hdl->cfg.capture_device, hdl->cfg.sample_rate, hdl->cfg.channels, hdl->cfg.data_bits,
+            hdl->stats.capture_period_frames, hdl->stats.capture_buffer_frames, hdl->cfg.mmap_enable ? "mmap" : "rw");
 
     return OPRT_OK;
 }
@@ -181,7 +273,6 @@ static OPERATE_RET __alsa_setup_capture(TDD_AUDIO_ALSA_HANDLE_T *hdl)
 static OPERATE_RET __alsa_setup_playback(TDD_AUDIO_ALSA_HANDLE_T *hdl)
 {
     int err;
-    snd_pcm_hw_params_t *hw_params = NULL;
 
     // Open PCM device for playback (non-blocking mode to avoid hanging)
     err = snd_pcm_open(&hdl->playback_handle, hdl->cfg.playback_device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
@@ -191,27 +282,13 @@ static OPERATE_RET __alsa_setup_playback(TDD_AUDIO_ALSA_HANDLE_T *hdl)
         return OPRT_COM_ERROR;
     }
 
-    // Switch back to blocking mode for normal operation
-    snd_pcm_nonblock(hdl->playback_handle, 0);
-
-    // Allocate hardware parameters object
-    snd_pcm_hw_params_alloca(&hw_params);
-    snd_pcm_hw_params_any(hdl->playback_handle, hw_params);
-
-    // Set parameters
-    snd_pcm_hw_params_set_access(hdl->playback_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(hdl->playback_handle, hw_params, __get_alsa_format(hdl->cfg.data_bits));
-    snd_pcm_hw_params_set_channels(hdl->playback_handle, hw_params, hdl->cfg.channels);
-    snd_pcm_hw_params_set_rate_near(hdl->playback_handle, hw_params, (unsigned int *)&hdl->cfg.spk_sample_rate, 0);
-
-    // Set buffer and period sizes
-    snd_pcm_uframes_t buffer_size = hdl->cfg.buffer_frames;
-    snd_pcm_uframes_t period_size = hdl->cfg.period_frames;
-    snd_pcm_hw_params_set_buffer_size_near(hdl->playback_handle, hw_params, &buffer_size);
-    snd_pcm_hw_params_set_period_size_near(hdl->playback_handle, hw_params, &period_size, 0);
+    // writei blocks the caller, mmap play waits with snd_pcm_wait() instead
+    if (!hdl->cfg.mmap_enable) {
+        snd_pcm_nonblock(hdl->playback_handle, 0);
+    }
 
-    // Write parameters to device
-    err = snd_pcm_hw_params(hdl->playback_handle, hw_params);
+    err = __alsa_set_params(hdl, hdl->playback_handle, (unsigned int *)&hdl->cfg.spk_sample_rate,
+                            &hdl->stats.playback_period_frames, &hdl->stats.playback_buffer_frames);
     if (err < 0) {
         PR_ERR("Cannot set playback parameters: %s", snd_strerror(err));
         snd_pcm_close(hdl->playback_handle);
@@ -228,8 +305,9 @@ static OPERATE_RET __alsa_setup_playback(TDD_AUDIO_ALSA_HANDLE_T *hdl)
         return OPRT_COM_ERROR;
     }
 
-    PR_INFO("ALSA playback device setup: %s, rate=%d, channels=%d, bits=%d", hdl->cfg.playback_device,
-            hdl->cfg.spk_sample_rate, hdl->cfg.channels, hdl->cfg.data_bits);
+    PR_INFO("ALSA playback device setup: %s, rate=%d, channels=%d, bits=%d, period=%d, buffer=%d, %s",
+            hdl->cfg.playback_device, hdl->cfg.spk_sample_rate, hdl->cfg.channels, hdl->cfg.data_bits,
+            hdl->stats.playback_period_frames, hdl->stats.playback_buffer_frames, hdl->cfg.mmap_enable ? "mmap" : "rw");
 
     return OPRT_OK;
 }
@@ -296,7 +374,7 @@ static OPERATE_RET __alsa_setup_mixer(TDD_AUDIO_ALSA_HANDLE_T *hdl)
 }
 
 /**
- * @brief Audio capture thread
+ * @brief Audio capture thread, readi mode
  */
 static void *__alsa_capture_thread(void *arg)
 {
@@ -307,24 +385,22 @@ static void *__alsa_capture_thread(void *arg)
 
     while (hdl->capture_running) {
         // Read audio frames
-        frames = snd_pcm_readi(hdl->capture_handle, hdl->capture_buffer, hdl->cfg.period_frames);
+        frames = snd_pcm_readi(hdl->capture_handle, hdl->capture_buffer, hdl->stats.capture_period_frames);
 
         if (frames < 0) {
             // Handle buffer overrun
-            if (frames == -EPIPE) {
-                PR_WARN("ALSA capture overrun occurred");
-                snd_pcm_prepare(hdl->capture_handle);
-                continue;
-            } else {
+            if (__alsa_recover(hdl, hdl->capture_handle, frames) < 0) {
                 PR_ERR("ALSA capture error: %s", snd_strerror(frames));
                 break;
             }
+            continue;
         }
 
         // Call callback with captured data
         if (hdl->mic_cb && frames > 0) {
-            uint32_t data_size = frames * hdl->cfg.channels * (hdl->cfg.data_bits / 8);
-            hdl->mic_cb(TDL_AUDIO_FRAME_FORMAT_PCM, TDL_AUDIO_STATUS_RECEIVING, hdl->capture_buffer, data_size);
+            hdl->stats.capture_frames += frames;
+            hdl->mic_cb(TDL_AUDIO_FRAME_FORMAT_PCM, TDL_AUDIO_STATUS_RECEIVING, hdl->capture_buffer,
+                        frames * hdl->frame_bytes);
         }
     }
 
@@ -332,6 +408,86 @@ static void *__alsa_capture_thread(void *arg)
     return NULL;
 }
 
+/**
+ * @brief Audio capture thread, mmap mode
+ *
+ * Sleeps in poll() until at least a period is available, then passes every
+ * available period to mic_cb in place in the ring and gives it back to the
+ * device once the callback returns.
+ */
+static void *__alsa_capture_mmap_thread(void *arg)
+{
+    TDD_AUDIO_ALSA_HANDLE_T *hdl = (TDD_AUDIO_ALSA_HANDLE_T *)arg;
+    snd_pcm_t *pcm = hdl->capture_handle;
+    struct pollfd fds[ALSA_POLL_FD_MAX];
+    const snd_pcm_channel_area_t *areas = NULL;
+    snd_pcm_uframes_t offset, frames;
+    snd_pcm_sframes_t avail, committed;
+    unsigned short revents;
+    int nfds, err;
+
+    PR_INFO("ALSA capture mmap thread started");
+
+    nfds = snd_pcm_poll_descriptors(pcm, fds, ALSA_POLL_FD_MAX);
+    err = snd_pcm_start(pcm);
+    if (nfds <= 0 || err < 0) {
+        PR_ERR("ALSA capture start error: %s", snd_strerror(nfds <= 0 ? nfds : err));
+        return NULL;
+    }
+
+    while (hdl->capture_running) {
+        if (poll(fds, nfds, ALSA_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        snd_pcm_poll_descriptors_revents(pcm, fds, nfds, &revents);
+        if (revents & POLLERR) {
+            err = snd_pcm_state(pcm) == SND_PCM_STATE_SUSPENDED ? -ESTRPIPE : -EPIPE;
+            if (__alsa_recover(hdl, pcm, err) < 0) {
+                PR_ERR("ALSA capture error: %s", snd_strerror(err));
+                break;
+            }
+            continue;
+        }
+        if (!(revents & POLLIN)) {
+            continue;
+        }
+
+        avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            if (__alsa_recover(hdl, pcm, avail) < 0) {
+                PR_ERR("ALSA capture error: %s", snd_strerror(avail));
+                break;
+            }
+            continue;
+        }
+
+        while (avail >= (snd_pcm_sframes_t)hdl->stats.capture_period_frames) {
+            frames = hdl->stats.capture_period_frames;
+            err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+            if (err < 0 || 0 == frames) {
+                break;
+            }
+
+            if (hdl->mic_cb) {
+                uint8_t *data = (uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+                hdl->mic_cb(TDL_AUDIO_FRAME_FORMAT_PCM, TDL_AUDIO_STATUS_RECEIVING, data,
+                            frames * hdl->frame_bytes);
+            }
+
+            committed = snd_pcm_mmap_commit(pcm, offset, frames);
+            if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+                __alsa_recover(hdl, pcm, committed >= 0 ? -EPIPE : committed);
+                break;
+            }
+            hdl->stats.capture_frames += frames;
+            avail -= frames;
+        }
+    }
+
+    PR_INFO("ALSA capture mmap thread stopped");
+    return NULL;
+}
+
 /**
  * @brief Open audio device
  */
@@ -345,6 +501,7 @@ static OPERATE_RET __tdd_audio_alsa_open(TDD_AUDIO_HANDLE_T handle, TDL_AUDIO_MI
     }
 
     hdl->mic_cb = mic_cb;
+    memset(&hdl->stats, 0, sizeof(hdl->stats));
 
     // Setup capture device
     rt = __alsa_setup_capture(hdl);
@@ -380,7 +537,8 @@ static OPERATE_RET __tdd_audio_alsa_open(TDD_AUDIO_HANDLE_T handle, TDL_AUDIO_MI
 
     // Start capture thread
     hdl->capture_running = 1;
-    int err = pthread_create(&hdl->capture_thread, NULL, __alsa_capture_thread, hdl);
+    int err = pthread_create(&hdl->capture_thread, NULL,
+                             hdl->cfg.mmap_enable ? __alsa_capture_mmap_thread : __alsa_capture_thread, hdl);
     if (err != 0) {
         PR_ERR("Failed to create capture thread: %d", err);
         hdl->capture_running = 0;
@@ -399,6 +557,77 @@ static OPERATE_RET __tdd_audio_alsa_open(TDD_AUDIO_HANDLE_T handle, TDL_AUDIO_MI
     return rt;
 }
 
+/**
+ * @brief Play audio data, mmap mode
+ *
+ * Copies the frames straight into the ring, waiting in poll() whenever it is
+ * full, and starts the stream once the start threshold is queued.
+ */
+static OPERATE_RET __alsa_play_mmap(TDD_AUDIO_ALSA_HANDLE_T *hdl, uint8_t *data, snd_pcm_uframes_t total)
+{
+    snd_pcm_t *pcm = hdl->playback_handle;
+    const snd_pcm_channel_area_t *areas = NULL;
+    snd_pcm_uframes_t offset, frames;
+    snd_pcm_sframes_t avail, committed;
+    int err;
+
+    while (total > 0) {
+        avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            err = __alsa_recover(hdl, pcm, avail);
+            if (err < 0) {
+                PR_ERR("ALSA playback error: %s", snd_strerror(err));
+                return OPRT_COM_ERROR;
+            }
+            continue;
+        }
+
+        if (0 == avail) {
+            if (SND_PCM_STATE_PREPARED == snd_pcm_state(pcm)) {
+                // the buffer is full but below the start threshold
+                snd_pcm_start(pcm);
+            } else {
+                snd_pcm_wait(pcm, ALSA_POLL_TIMEOUT_MS);
+            }
+            continue;
+        }
+
+        frames = total < (snd_pcm_uframes_t)avail ? total : (snd_pcm_uframes_t)avail;
+        err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+        if (err < 0) {
+            if (__alsa_recover(hdl, pcm, err) < 0) {
+                PR_ERR("ALSA playback error: %s", snd_strerror(err));
+                return OPRT_COM_ERROR;
+            }
+            continue;
+        }
+
+        memcpy((uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8, data,
+               frames * hdl->frame_bytes);
+
+        committed = snd_pcm_mmap_commit(pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+            if (__alsa_recover(hdl, pcm, committed >= 0 ? -EPIPE : committed) < 0) {
+                PR_ERR("ALSA playback error: %s", snd_strerror(committed));
+                return OPRT_COM_ERROR;
+            }
+            continue;
+        }
+
+        data += frames * hdl->frame_bytes;
+        total -= frames;
+        hdl->stats.playback_frames += frames;
+
+        // mmap transfers do not trigger the start threshold themselves
+        if (SND_PCM_STATE_PREPARED == snd_pcm_state(pcm) &&
+            hdl->stats.playback_buffer_frames - snd_pcm_avail_update(pcm) >= hdl->stats.playback_buffer_frames / 2) {
+            snd_pcm_start(pcm);
+        }
+    }
+
+    return OPRT_OK;
+}
+
 /**
  * @brief Play audio data
  */
@@ -406,6 +635,7 @@ static OPERATE_RET __tdd_audio_alsa_play(TDD_AUDIO_HANDLE_T handle, uint8_t *dat
 {
     OPERATE_RET rt = OPRT_OK;
     TDD_AUDIO_ALSA_HANDLE_T *hdl = (TDD_AUDIO_ALSA_HANDLE_T *)handle;
+    snd_pcm_sframes_t delay = 0;
 
     TUYA_CHECK_NULL_RETURN(hdl, OPRT_COM_ERROR);
     TUYA_CHECK_NULL_RETURN(hdl->playback_handle, OPRT_COM_ERROR);
@@ -416,23 +646,29 @@ static OPERATE_RET __tdd_audio_alsa_play(TDD_AUDIO_HANDLE_T handle, uint8_t *dat
     }
 
     // Calculate number of frames
-    uint32_t frame_size = hdl->cfg.channels * (hdl->cfg.data_bits / 8);
-    snd_pcm_uframes_t frames = len / frame_size;
-
-    // Write audio frames
-    snd_pcm_sframes_t written = snd_pcm_writei(hdl->playback_handle, data, frames);
-    if (written < 0) {
-        // Handle buffer underrun
-        if (written == -EPIPE) {
-            PR_WARN("ALSA playback underrun occurred");
-            snd_pcm_prepare(hdl->playback_handle);
-            written = snd_pcm_writei(hdl->playback_handle, data, frames);
-        }
+    snd_pcm_uframes_t frames = len / hdl->frame_bytes;
 
+    if (hdl->cfg.mmap_enable) {
+        rt = __alsa_play_mmap(hdl, data, frames);
+    } else {
+        // Write audio frames
+        snd_pcm_sframes_t written = snd_pcm_writei(hdl->playback_handle, data, frames);
         if (written < 0) {
-            PR_ERR("ALSA playback error: %s", snd_strerror(written));
-            return OPRT_COM_ERROR;
+            // Handle buffer underrun
+            if (__alsa_recover(hdl, hdl->playback_handle, written) >= 0) {
+                written = snd_pcm_writei(hdl->playback_handle, data, frames);
+            }
+
+            if (written < 0) {
+                PR_ERR("ALSA playback error: %s", snd_strerror(written));
+                return OPRT_COM_ERROR;
+            }
         }
+        hdl->stats.playback_frames += written;
+    }
+
+    if (0 == snd_pcm_delay(hdl->playback_handle, &delay) && delay > 0) {
+        hdl->stats.playback_delay_frames = delay;
     }
 
     return rt;
@@ -563,6 +799,8 @@ OPERATE_RET tdd_audio_alsa_register(char *name, TDD_AUDIO_ALSA_CFG_T cfg)
 
     // Copy configuration
     memcpy(&_hdl->cfg, &cfg, sizeof(TDD_AUDIO_ALSA_CFG_T));
+    strncpy(_hdl->name, name, sizeof(_hdl->name) - 1);
+    _hdl->frame_bytes = cfg.channels * (cfg.data_bits / 8);
 
     // Set default play volume
     _hdl->play_volume = 80;
@@ -581,6 +819,9 @@ OPERATE_RET tdd_audio_alsa_register(char *name, TDD_AUDIO_ALSA_CFG_T cfg)
     // Register with TDL audio management
     TUYA_CALL_ERR_GOTO(tdl_audio_driver_register(name, (TDD_AUDIO_HANDLE_T)_hdl, &intfs, &info), __ERR);
 
+    _hdl->next = sg_alsa_list;
+    sg_alsa_list = _hdl;
+
     PR_INFO("ALSA audio driver registered: %s", name);
 
     return rt;
@@ -594,4 +835,24 @@ __ERR:
     return rt;
 }
 
+/**
+ * @brief Get the stream statistics of a registered ALSA audio driver
+ */
+OPERATE_RET tdd_audio_alsa_get_stats(char *name, TDD_AUDIO_ALSA_STATS_T *stats)
+{
+    TDD_AUDIO_ALSA_HANDLE_T *hdl = NULL;
+
+    TUYA_CHECK_NULL_RETURN(name, OPRT_INVALID_PARM);
+    TUYA_CHECK_NULL_RETURN(stats, OPRT_INVALID_PARM);
+
+    for (hdl = sg_alsa_list; hdl; hdl = hdl->next) {
+        if (0 == strncmp(hdl->name, name, sizeof(hdl->name))) {
+            memcpy(stats, &hdl->stats, sizeof(TDD_AUDIO_ALSA_STATS_T));
+            return OPRT_OK;
+        }
+    }
+
+    return OPRT_NOT_FOUND;
+}
+
 #endif /* ENABLE_AUDIO_ALSA */
@@ -29,6 +29,8 @@
 // #include "tal_api.h"
 #include "tal_memory.h"
 #include "tal_log.h"
+#include "tal_system.h"
+#include "tal_metrics.h"
 
 /***********************************************************
 ************************macro define************************
@@ -64,6 +66,11 @@ static TDL_AUDIO_LIST_T sg_audio_list = {
     .tail = NULL,
 };
 
+static TAL_METRIC_COUNTER_DEFINE(sg_metric_play, "audio_play_frames_total", "audio frames handed to the speaker");
+static TAL_METRIC_COUNTER_DEFINE(sg_metric_play_bytes, "audio_play_bytes_total", "audio bytes handed to the speaker");
+static TAL_METRIC_COUNTER_DEFINE(sg_metric_play_err, "audio_play_errors_total", "audio frames the driver refused");
+static TAL_METRIC_HISTOGRAM_DEFINE(sg_metric_play_ms, "audio_play_ms", "time blocked in the driver play call", 0);
+
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
@@ -181,7 +188,17 @@ OPERATE_RET tdl_audio_play(TDL_AUDIO_HANDLE_T handle, uint8_t *data, uint32_t le
         return OPRT_INVALID_PARM;
     }
 
-    return node->tdd_intfs.play(node->tdd_hdl, data, len);
+    SYS_TIME_T start_ms = tal_system_get_millisecond();
+    OPERATE_RET rt = node->tdd_intfs.play(node->tdd_hdl, data, len);
+    tal_metric_observe(&sg_metric_play_ms, (uint32_t)(tal_system_get_millisecond() - start_ms));
+    if (OPRT_OK == rt) {
+        tal_metric_inc(&sg_metric_play);
+        tal_metric_add(&sg_metric_play_bytes, len);
+    } else {
+        tal_metric_inc(&sg_metric_play_err);
+    }
+
+    return rt;
 }
 
 OPERATE_RET tdl_audio_play_stop(TDL_AUDIO_HANDLE_T handle)
@@ -266,5 +283,10 @@ OPERATE_RET tdl_audio_driver_register(char *name, TDD_AUDIO_HANDLE_T tdd_hdl,\
 
     __audio_node_add(node);
 
+    tal_metric_register(&sg_metric_play);
+    tal_metric_register(&sg_metric_play_bytes);
+    tal_metric_register(&sg_metric_play_err);
+    tal_metric_register(&sg_metric_play_ms.base);
+
     return rt;
 }
@@ -0,0 +1,109 @@
+/**
+ * @file tdl_button_engine.h
+ * @brief Tuya Driver Layer timestamp-based button event engine.
+ *
+ * This file declares the key event engine shared by the TDL button and
+ * joystick managers. The engine turns a sampled key level and a millisecond
+ * timestamp into press, release, click, multi-click and long press events.
+ * All timing is derived from timestamps instead of scan tick counts, so the
+ * caller may sample at a fixed period or only on GPIO edges and deadlines:
+ * every update returns the time until the engine next needs to be sampled.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef _TDL_BUTTON_ENGINE_H_
+#define _TDL_BUTTON_ENGINE_H_
+
+#include "tuya_cloud_types.h"
+#include "tdl_button_manage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define TDL_BUTTON_ENGINE_NO_DEADLINE 0xFFFFFFFF // Nothing pending, only a level change can produce an event
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef enum {
+    TDL_BUTTON_ENGINE_IDLE = 0,       // Released, no click sequence in progress
+    TDL_BUTTON_ENGINE_PRESSED,        // First press, waiting for release or long press start
+    TDL_BUTTON_ENGINE_RELEASED,       // Released, waiting for another press or the click window to close
+    TDL_BUTTON_ENGINE_REPRESSED,      // Pressed again inside the click window
+    TDL_BUTTON_ENGINE_LONG_PRESS = 5, // Long press started, generating hold events
+    TDL_BUTTON_ENGINE_RECOVER,        // Power-on active level restored, report recover event
+} TDL_BUTTON_ENGINE_STATE_E;
+
+typedef struct {
+    uint8_t state;      // TDL_BUTTON_ENGINE_STATE_E
+    uint8_t status;     // Debounced key status, 1 = pressed
+    uint8_t debouncing; // Raw level differs from status since debounce_ms
+    uint8_t repeat;     // Press count of the current click sequence
+    uint8_t pre_event;  // Previous event
+    uint8_t now_event;  // Last generated event
+    uint32_t debounce_ms; // Time the raw level started to differ
+    uint32_t press_ms;    // Time of the first press of the sequence
+    uint32_t release_ms;  // Time of the last release (click window start)
+    uint32_t hold_ms;     // Time of the next long press hold event
+} TDL_BUTTON_ENGINE_T;
+
+/**
+ * @brief engine event output
+ * @param[in] ctx caller context passed to tdl_button_engine_update
+ * @param[in] event generated event
+ * @param[in] arg repeat count or press duration in ms, depending on the event
+ * @return none
+ */
+typedef void (*TDL_BUTTON_ENGINE_EMIT_CB)(void *ctx, TDL_BUTTON_TOUCH_EVENT_E event, uint32_t arg);
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+/**
+ * @brief Reset an engine to the released idle state
+ * @param[in] engine engine instance
+ * @return none
+ */
+void tdl_button_engine_reset(TDL_BUTTON_ENGINE_T *engine);
+
+/**
+ * @brief Request a TDL_BUTTON_RECOVER_PRESS_UP event on the next update
+ * @param[in] engine engine instance
+ * @return none
+ */
+void tdl_button_engine_recover(TDL_BUTTON_ENGINE_T *engine);
+
+/**
+ * @brief Feed one level sample into the engine
+ * @param[in] engine engine instance
+ * @param[in] cfg timing configuration
+ * @param[in] level sampled key level, non-zero = pressed
+ * @param[in] now_ms current time in ms (wrap-around safe)
+ * @param[in] emit event output
+ * @param[in] ctx context passed to emit
+ * @return ms until the engine must be sampled again, TDL_BUTTON_ENGINE_NO_DEADLINE if no deadline is pending
+ * @note A held key has no deadline of its own, callers that cannot be woken by the
+ *       release edge must keep sampling while the level or status is active
+ */
+uint32_t tdl_button_engine_update(TDL_BUTTON_ENGINE_T *engine, const TDL_BUTTON_CFG_T *cfg, uint8_t level,
+                                  uint32_t now_ms, TDL_BUTTON_ENGINE_EMIT_CB emit, void *ctx);
+
+/**
+ * @brief Check whether the engine is fully released with nothing pending
+ * @param[in] engine engine instance
+ * @return TRUE if idle
+ */
+BOOL_T tdl_button_engine_is_idle(const TDL_BUTTON_ENGINE_T *engine);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*_TDL_BUTTON_ENGINE_H_*/
@@ -157,6 +157,8 @@ OPERATE_RET tdl_button_set_level(TDL_BUTTON_HANDLE handle, TUYA_GPIO_LEVEL_E lev
 
 /**
  * @brief set button scan time, default is 10ms
+ *        In interrupt mode this is the sampling period while a button is held,
+ *        idle buttons are not sampled at all.
  * @param[in] time_ms button scan time
  * @return OPRT_OK if successful
  */
@@ -0,0 +1,217 @@
+/**
+ * @file tdl_button_engine.c
+ * @brief Implementation of the Tuya Driver Layer timestamp-based button event engine.
+ *
+ * The engine reproduces the TDL button state machine (press, release, single,
+ * double and multi-click, long press start and hold, power-on recover) with
+ * every interval measured from millisecond timestamps. Each update reports the
+ * next deadline (debounce end, long press start, hold repeat or click window
+ * close), which lets the caller sleep until then instead of scanning.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include "string.h"
+
+#include "tdl_button_engine.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define TDL_BUTTON_ENGINE_HOLD_MIN 10 // ms, lower bound of the long press hold period
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void __engine_emit(TDL_BUTTON_ENGINE_T *engine, TDL_BUTTON_TOUCH_EVENT_E event, uint32_t arg,
+                          TDL_BUTTON_ENGINE_EMIT_CB emit, void *ctx)
+{
+    engine->pre_event = engine->now_event;
+    engine->now_event = event;
+    if (emit) {
+        emit(ctx, event, arg);
+    }
+}
+
+// Remaining ms until start_ms + period, 0 if already reached
+static uint32_t __engine_remain(uint32_t now_ms, uint32_t start_ms, uint32_t period)
+{
+    uint32_t elapsed = now_ms - start_ms;
+
+    return (elapsed >= period) ? 0 : (period - elapsed);
+}
+
+static uint32_t __engine_hold_period(const TDL_BUTTON_CFG_T *cfg)
+{
+    return (cfg->long_keep_timer < TDL_BUTTON_ENGINE_HOLD_MIN) ? TDL_BUTTON_ENGINE_HOLD_MIN : cfg->long_keep_timer;
+}
+
+void tdl_button_engine_reset(TDL_BUTTON_ENGINE_T *engine)
+{
+    if (NULL == engine) {
+        return;
+    }
+
+    memset(engine, 0, sizeof(TDL_BUTTON_ENGINE_T));
+    engine->state = TDL_BUTTON_ENGINE_IDLE;
+    engine->pre_event = TDL_BUTTON_PRESS_NONE;
+    engine->now_event = TDL_BUTTON_PRESS_NONE;
+}
+
+void tdl_button_engine_recover(TDL_BUTTON_ENGINE_T *engine)
+{
+    if (NULL == engine) {
+        return;
+    }
+
+    engine->state = TDL_BUTTON_ENGINE_RECOVER;
+}
+
+uint32_t tdl_button_engine_update(TDL_BUTTON_ENGINE_T *engine, const TDL_BUTTON_CFG_T *cfg, uint8_t level,
+                                  uint32_t now_ms, TDL_BUTTON_ENGINE_EMIT_CB emit, void *ctx)
+{
+    uint32_t wait = TDL_BUTTON_ENGINE_NO_DEADLINE;
+    uint32_t remain = 0;
+
+    if ((NULL == engine) || (NULL == cfg)) {
+        return TDL_BUTTON_ENGINE_NO_DEADLINE;
+    }
+
+    level = level ? 1 : 0;
+
+    // Debounce: the new level must hold for button_debounce_time before it is accepted
+    if (level != engine->status) {
+        if (!engine->debouncing) {
+            engine->debouncing = 1;
+            engine->debounce_ms = now_ms;
+        }
+        remain = __engine_remain(now_ms, engine->debounce_ms, cfg->button_debounce_time);
+        if (remain == 0) {
+            engine->status = level;
+            engine->debouncing = 0;
+        } else {
+            wait = remain;
+        }
+    } else {
+        engine->debouncing = 0;
+    }
+
+    switch (engine->state) {
+    case TDL_BUTTON_ENGINE_IDLE:
+        if (engine->status) {
+            engine->press_ms = now_ms;
+            engine->repeat = 1;
+            engine->state = TDL_BUTTON_ENGINE_PRESSED;
+            __engine_emit(engine, TDL_BUTTON_PRESS_DOWN, engine->repeat, emit, ctx);
+        } else {
+            engine->pre_event = engine->now_event;
+            engine->now_event = TDL_BUTTON_PRESS_NONE;
+        }
+        break;
+
+    case TDL_BUTTON_ENGINE_RELEASED:
+        if (engine->status) {
+            // Press again inside the click window
+            engine->repeat++;
+            engine->state = TDL_BUTTON_ENGINE_REPRESSED;
+            __engine_emit(engine, TDL_BUTTON_PRESS_DOWN, engine->repeat, emit, ctx);
+        } else if (__engine_remain(now_ms, engine->release_ms, cfg->button_repeat_valid_time) == 0) {
+            // Click window closed: report the click count
+            if (engine->repeat == 1) {
+                __engine_emit(engine, TDL_BUTTON_PRESS_SINGLE_CLICK, engine->repeat, emit, ctx);
+            } else if (engine->repeat == 2) {
+                __engine_emit(engine, TDL_BUTTON_PRESS_DOUBLE_CLICK, engine->repeat, emit, ctx);
+            } else if ((engine->repeat == cfg->button_repeat_valid_count) && (cfg->button_repeat_valid_count > 2)) {
+                __engine_emit(engine, TDL_BUTTON_PRESS_REPEAT, engine->repeat, emit, ctx);
+            }
+            engine->state = TDL_BUTTON_ENGINE_IDLE;
+        }
+        break;
+
+    case TDL_BUTTON_ENGINE_REPRESSED:
+        if (!engine->status) {
+            __engine_emit(engine, TDL_BUTTON_PRESS_UP, engine->repeat, emit, ctx);
+            if (__engine_remain(now_ms, engine->release_ms, cfg->button_repeat_valid_time) == 0) {
+                // Held past the click window, the sequence is dropped
+                engine->state = TDL_BUTTON_ENGINE_IDLE;
+            } else {
+                engine->release_ms = now_ms;
+                engine->state = TDL_BUTTON_ENGINE_RELEASED;
+            }
+        }
+        break;
+
+    case TDL_BUTTON_ENGINE_RECOVER:
+        // The active level seen at power-on has been released
+        __engine_emit(engine, TDL_BUTTON_RECOVER_PRESS_UP, 0, emit, ctx);
+        engine->state = TDL_BUTTON_ENGINE_IDLE;
+        break;
+
+    default:
+        break;
+    }
+
+    // First press may turn into a long press in the same update
+    if (engine->state == TDL_BUTTON_ENGINE_PRESSED) {
+        if (!engine->status) {
+            __engine_emit(engine, TDL_BUTTON_PRESS_UP, engine->repeat, emit, ctx);
+            engine->release_ms = now_ms;
+            engine->state = TDL_BUTTON_ENGINE_RELEASED;
+        } else if ((cfg->long_start_valid_time != 0) &&
+                   (__engine_remain(now_ms, engine->press_ms, cfg->long_start_valid_time) == 0)) {
+            uint32_t held = now_ms - engine->press_ms;
+            uint32_t period = __engine_hold_period(cfg);
+
+            __engine_emit(engine, TDL_BUTTON_LONG_PRESS_START, held, emit, ctx);
+            // Hold events fire on multiples of the hold period counted from the press
+            engine->hold_ms = engine->press_ms + (held / period + 1) * period;
+            engine->state = TDL_BUTTON_ENGINE_LONG_PRESS;
+        }
+    } else if (engine->state == TDL_BUTTON_ENGINE_LONG_PRESS) {
+        if (!engine->status) {
+            __engine_emit(engine, TDL_BUTTON_PRESS_UP, now_ms - engine->press_ms, emit, ctx);
+            engine->state = TDL_BUTTON_ENGINE_IDLE;
+        } else if ((int32_t)(now_ms - engine->hold_ms) >= 0) {
+            uint32_t period = __engine_hold_period(cfg);
+
+            __engine_emit(engine, TDL_BUTTON_LONG_PRESS_HOLD, now_ms - engine->press_ms, emit, ctx);
+            // Skip periods missed while the caller was not sampling
+            while ((int32_t)(now_ms - engine->hold_ms) >= 0) {
+                engine->hold_ms += period;
+            }
+        }
+    }
+
+    // Next deadline of the current state
+    remain = TDL_BUTTON_ENGINE_NO_DEADLINE;
+    switch (engine->state) {
+    case TDL_BUTTON_ENGINE_PRESSED:
+        if (cfg->long_start_valid_time != 0) {
+            remain = __engine_remain(now_ms, engine->press_ms, cfg->long_start_valid_time);
+        }
+        break;
+    case TDL_BUTTON_ENGINE_RELEASED:
+        remain = __engine_remain(now_ms, engine->release_ms, cfg->button_repeat_valid_time);
+        break;
+    case TDL_BUTTON_ENGINE_LONG_PRESS:
+        remain = engine->hold_ms - now_ms;
+        break;
+    case TDL_BUTTON_ENGINE_RECOVER:
+        remain = 0;
+        break;
+    default:
+        break;
+    }
+
+    return (remain < wait) ? remain : wait;
+}
+
+BOOL_T tdl_button_engine_is_idle(const TDL_BUTTON_ENGINE_T *engine)
+{
+    if (NULL == engine) {
+        return TRUE;
+    }
+
+    return ((engine->state == TDL_BUTTON_ENGINE_IDLE) && !engine->status && !engine->debouncing) ? TRUE : FALSE;
+}
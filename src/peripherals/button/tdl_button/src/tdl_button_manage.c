@@ -10,8 +10,13 @@
  * timer-based scanning and interrupt handling to detect button state changes
  * with configurable debouncing and timing parameters.
  *
+ * Event timing is computed by the timestamp-based engine in tdl_button_engine.c.
+ * In interrupt mode the button task is fully event-driven: a GPIO edge wakes it,
+ * each button reports its next deadline, and the task sleeps until the earliest
+ * one, or indefinitely when every button is idle.
+ *
  * Key features implemented:
- * - State machine-based button event detection
+ * - Timestamp-based state machine for button event detection
  * - Configurable debouncing for reliable button state reading
  * - Support for both timer-based scanning and interrupt-driven modes
  * - Multiple simultaneous button management using linked lists
@@ -43,6 +48,7 @@
 
 #include "tdl_button_driver.h"
 #include "tdl_button_manage.h"
+#include "tdl_button_engine.h"
 #include "tdd_button_gpio.h"
 
 /***********************************************************
@@ -57,9 +63,7 @@
 #define TDL_LONG_START_VAILD_TIMER 1500  // ms
 #define TDL_LONG_KEEP_TIMER        100   // ms
 #define TDL_BUTTON_DEBOUNCE_TIME   60    // ms
-#define TDL_BUTTON_IRQ_SCAN_TIME   10000 // ms
 #define TDL_BUTTON_SCAN_TIME       10    // 10ms
-#define TDL_BUTTON_IRQ_SCAN_CNT    (TDL_BUTTON_IRQ_SCAN_TIME / tdl_button_scan_time)
 #define TOUCH_DELAY                500 // Interval time 500ms for single/double click recognition
 #define PUT_EVENT_CB(btn, name, ev, arg)                                                                               \
     do {                                                                                                               \
@@ -80,15 +84,9 @@ typedef struct {
 } TDL_BUTTON_HARDWARE_CFG_T;
 
 typedef struct {
-    uint8_t pre_event : 4; // Previous event
-    uint8_t now_event : 4; // Currently generated event
-    uint8_t flag : 3;      // Button processing flow state
-    uint8_t debounce_cnt;  // Debounce count
-    uint16_t ticks;        // Press and hold count
-    uint8_t status;        // Actual button status
-    uint8_t repeat;        // Repeat press count
-    uint8_t ready;         // Flag indicating if the button is ready after power-on
-    uint8_t init_flag;     // Button initialized successfully
+    TDL_BUTTON_ENGINE_T engine; // Event state machine
+    uint8_t ready;              // Flag indicating if the button is ready after power-on
+    uint8_t init_flag;          // Button initialized successfully
 
     TDL_BUTTON_CTRL_INFO ctrl_info;    // Driver mount information
     DEVICE_BUTTON_HANDLE dev_handle;   // Driver handle
@@ -121,7 +119,6 @@ typedef struct {
     uint8_t irq_task_flag;    /*Interrupt thread flag*/
     uint8_t task_mode;        /*Thread type*/
     SEM_HANDLE irq_semaphore; /*Interrupt semaphore*/
-    uint32_t irq_scan_cnt;    /*Interrupt thread disconnection count*/
     MUTEX_HANDLE mutex;       /*Mutex lock*/
 } TDL_BUTTON_LOCAL_T;         // TDL local parameters
 
@@ -132,7 +129,6 @@ TDL_BUTTON_LOCAL_T tdl_button_local = {.irq_task_flag = FALSE,
                                        .scan_task_flag = FALSE,
                                        .task_mode = FALSE,
                                        .irq_semaphore = NULL,
-                                       .irq_scan_cnt = TDL_BUTTON_IRQ_SCAN_TIME / TDL_BUTTON_SCAN_TIME,
                                        .mutex = NULL};
 
 THREAD_HANDLE scan_thread_handle = NULL; // Scan thread handle
@@ -377,213 +373,23 @@ static TDL_BUTTON_LIST_NODE_T *__button_updata_userdata(char *name, TDL_BUTTON_C
         p_node->user_data.button_cfg.button_repeat_valid_count = button_cfg->button_repeat_valid_count;
     }
 
-    p_node->device_data.pre_event = TDL_BUTTON_PRESS_NONE;
-    p_node->device_data.now_event = TDL_BUTTON_PRESS_NONE;
+    tdl_button_engine_reset(&p_node->device_data.engine);
 
     return p_node;
 }
 
-// Button scan state machine: generates button trigger events
-static void __tdl_button_state_handle(TDL_BUTTON_LIST_NODE_T *p_node)
+// Deliver an engine event to the registered callback
+static void __tdl_button_event_emit(void *ctx, TDL_BUTTON_TOUCH_EVENT_E event, uint32_t arg)
 {
-    uint16_t hold_tick = 0;
-
-    if (NULL == p_node) {
-        return;
-    }
-
-    switch (p_node->device_data.flag) {
-    case 0: {
-        // PR_NOTICE("case0:tick=%d",p_node->device_data.ticks);
-        if (p_node->device_data.status != 0) {
-            if (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE) {
-                tdl_button_local.irq_scan_cnt = 0;
-            }
-            /*Trigger press down event*/
-            /*Trigger press down event*/
-            p_node->device_data.ticks = 0;
-            p_node->device_data.repeat = 1;
-            p_node->device_data.flag = 1;
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_DOWN;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_DOWN,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-
-        } else {
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_NONE; // Default state is no, no callback execution
-        }
-    } break;
-
-    case 1: {
-        // PR_NOTICE("case1:tick=%d",p_node->device_data.ticks);
-        if (p_node->device_data.status != 0) {
-            if (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE) {
-                tdl_button_local.irq_scan_cnt = 0;
-            }
-            if (p_node->user_data.button_cfg.long_start_valid_time == 0) {
-                // Long press valid time is 0, do not execute long press
-                // Long press valid time is 0, do not execute long press
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            } else if (p_node->device_data.ticks >
-                       (p_node->user_data.button_cfg.long_start_valid_time / tdl_button_scan_time)) {
-                /*Trigger long press start event*/
-                // PR_NOTICE("long tick =%d",p_node->device_data.ticks);
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-                p_node->device_data.now_event = TDL_BUTTON_LONG_PRESS_START;
-                PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_LONG_PRESS_START,
-                             (void *)((uint32_t)p_node->device_data.ticks * tdl_button_scan_time));
-                p_node->device_data.flag = 5;
-            } else {
-                // First press, holding, has not reached the long press start event, update the front and back status in
-                // time First press, holding, has not reached the long press start event, update the front and back
-                // status in time
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            }
-        } else {
-            /*Trigger release event*/
-            /*Trigger release event*/
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            p_node->device_data.flag = 2;
-            p_node->device_data.ticks = 0;
-        }
-    } break;
-
-    case 2: {
-        // PR_NOTICE("case2");
-        if (p_node->device_data.status != 0) {
-            /*press again*/
-            if (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE) {
-                tdl_button_local.irq_scan_cnt = 0;
-            }
-            p_node->device_data.repeat++;
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_DOWN;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_DOWN,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            p_node->device_data.flag = 3;
-        } else {
-            /*release timeout*/
-            if (p_node->device_data.ticks >=
-                (p_node->user_data.button_cfg.button_repeat_valid_time / tdl_button_scan_time)) {
-                /*Release timeout triggers single click*/
-                /*Release timeout triggers single click*/
-                if (p_node->device_data.repeat == 1) {
-                    p_node->device_data.pre_event = p_node->device_data.now_event;
-                    p_node->device_data.now_event = TDL_BUTTON_PRESS_SINGLE_CLICK;
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_SINGLE_CLICK,
-                                 (void *)((uint32_t)p_node->device_data.repeat));
-                } else if (p_node->device_data.repeat == 2) {
-                    /*Release triggers double click event*/
-                    /*Release triggers double click event*/
-                    p_node->device_data.pre_event = p_node->device_data.now_event;
-                    p_node->device_data.now_event = TDL_BUTTON_PRESS_DOUBLE_CLICK;
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_DOUBLE_CLICK,
-                                 (void *)((uint32_t)p_node->device_data.repeat));
-                } else if (p_node->device_data.repeat == p_node->user_data.button_cfg.button_repeat_valid_count) {
-                    if (p_node->user_data.button_cfg.button_repeat_valid_count > 2) {
-                        p_node->device_data.pre_event = p_node->device_data.now_event;
-                        p_node->device_data.now_event = TDL_BUTTON_PRESS_REPEAT;
-                        PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_REPEAT,
-                                     (void *)((uint32_t)p_node->device_data.repeat));
-                    }
-                }
-                p_node->device_data.flag = 0;
-            } else {
-                // Not timed out after release, update front and back status in time
-                // Not timed out after release, update front and back status in time
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            }
-        }
-    } break;
-
-    case 3: {
-        uint16_t repeat_tick = 0;
-        // PR_NOTICE("case3:tick=%d",p_node->device_data.ticks);
-        /*repeat up*/
-        // Released after more than one press
-        if (p_node->device_data.status == 0) {
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            repeat_tick = p_node->user_data.button_cfg.button_repeat_valid_time / tdl_button_scan_time;
-            if (p_node->device_data.ticks >= repeat_tick) {
-                // Timeout after release, double-click uses default interval, multiple-click uses user-configured
-                // interval Timeout after release, double-click uses default interval, multiple-click uses
-                // user-configured interval PR_NOTICE("3: tick=%d",p_node->device_data.ticks);
-                // PR_NOTICE("%d",repeat_tick);
-                p_node->device_data.flag = 0;
-            } else {
-                p_node->device_data.flag = 2;
-                p_node->device_data.ticks = 0;
-            }
-        } else {
-            // More than one press, holding, update front and back status in time
-            // More than one press, holding, update front and back status in time
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-        }
-
-    } break;
+    TDL_BUTTON_LIST_NODE_T *p_node = (TDL_BUTTON_LIST_NODE_T *)ctx;
 
-    case 5: {
-        if (p_node->device_data.status != 0) {
-            /*Trigger long press hold event*/
-            /*Trigger long press hold event*/
-            if (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE) {
-                tdl_button_local.irq_scan_cnt = 0;
-            }
-            hold_tick = p_node->user_data.button_cfg.long_keep_timer / tdl_button_scan_time;
-            if (hold_tick == 0) {
-                hold_tick = 1;
-            }
-            if (p_node->device_data.ticks >= hold_tick) {
-                // If the count is greater than the hold count, refresh the status immediately
-                // If the count is greater than the hold count, refresh the status immediately
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-                p_node->device_data.now_event = TDL_BUTTON_LONG_PRESS_HOLD;
-                if (p_node->device_data.ticks % hold_tick == 0) {
-                    // Execute only when it is confirmed that it is an integer multiple of hold
-                    // Execute only when it is confirmed that it is an integer multiple of hold
-                    // PR_NOTICE("hold,tick=%d",hold_tick);
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_LONG_PRESS_HOLD,
-                                 (void *)((uint32_t)p_node->device_data.ticks * tdl_button_scan_time));
-                }
-            }
-        } else {
-            /*hold release*/
-            /*hold release*/
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.ticks * tdl_button_scan_time));
-            p_node->device_data.ticks = 0;
-            p_node->device_data.flag = 0;
-        }
-    } break;
-    case 6: {
-        /*If the power is continuously maintained at an effective level and triggered after recovery*/
-        /*If the power is continuously maintained at an effective level and triggered after recovery*/
-        PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_RECOVER_PRESS_UP, NULL);
-        p_node->device_data.ticks = 0;
-        p_node->device_data.flag = 0;
-    } break;
-
-    default:
-        break;
-    }
-    return;
+    PUT_EVENT_CB(p_node->user_data, p_node->name, event, (void *)arg);
 }
 
-// Button interrupt callback function
+// Button interrupt callback function: wake the button task on every edge
 static void __tdl_button_irq_cb(void *arg)
 {
-    if (tdl_button_local.irq_scan_cnt >= TDL_BUTTON_IRQ_SCAN_CNT) {
-        tal_semaphore_post(tdl_button_local.irq_semaphore);
-    }
+    tal_semaphore_post(tdl_button_local.irq_semaphore);
     return;
 }
 
@@ -799,13 +605,7 @@ OPERATE_RET tdl_button_delete_without_hardware(TDL_BUTTON_HANDLE handle)
     tal_mutex_lock(p_node->button_mutex);
 
     memset(&p_node->user_data, 0, sizeof(BUTTON_USER_DATA_T));
-    p_node->device_data.pre_event = 0;
-    p_node->device_data.now_event = 0;
-    p_node->device_data.flag = 0;
-    p_node->device_data.debounce_cnt = 0;
-    p_node->device_data.ticks = 0;
-    p_node->device_data.status = 0;
-    p_node->device_data.repeat = 0;
+    tdl_button_engine_reset(&p_node->device_data.engine);
     p_node->device_data.ready = 0;
     p_node->device_data.init_flag = 0;
 
@@ -841,52 +641,47 @@ OPERATE_RET tdl_combine_button_delete(TDL_BUTTON_HANDLE p_handle)
 }
 #endif
 
-// Button flow: read, debounce, generate event
-static void __tdl_button_handle(TDL_BUTTON_LIST_NODE_T *p_node)
+// Button flow: read, debounce, generate event. Returns ms until the button needs to be sampled again
+static uint32_t __tdl_button_handle(TDL_BUTTON_LIST_NODE_T *p_node, uint32_t now_ms)
 {
     OPERATE_RET ret = OPRT_COM_ERROR;
     uint8_t status = 0;
+    uint32_t wait = TDL_BUTTON_ENGINE_NO_DEADLINE;
     TDL_BUTTON_OPRT_INFO button_oprt;
 
     ret = __tdl_get_operate_info(p_node, &button_oprt);
     if (OPRT_OK != ret) {
-        return;
+        return TDL_BUTTON_ENGINE_NO_DEADLINE;
     }
 
     if (p_node->device_data.init_flag == TRUE) {
         p_node->device_data.ctrl_info.read_value(&button_oprt, &status);
     } else {
         // PR_NOTICE("button is no init over, name=%s",p_node->name);
-        return;
+        return TDL_BUTTON_ENGINE_NO_DEADLINE;
     }
 
     // In scan mode, a long press at power-on may trigger a short press. Added a 'ready' state to prevent this. This is
     // not an issue in interrupt mode, so the 'ready' state is not needed.
     if ((p_node->device_data.dev_cfg.button_mode == BUTTON_TIMER_SCAN_MODE) && (p_node->device_data.ready == FALSE)) {
         if (status) {
-            return;
+            return TDL_BUTTON_ENGINE_NO_DEADLINE;
         } else {
             // PR_NOTICE("device_data.ready=TRUE,%s,status=%d",p_node->name,status);
-            p_node->device_data.flag = 6;
+            tdl_button_engine_recover(&p_node->device_data.engine);
             p_node->device_data.ready = TRUE;
         }
     }
 
-    if (p_node->device_data.flag > 0) {
-        p_node->device_data.ticks++;
-    }
+    wait = tdl_button_engine_update(&p_node->device_data.engine, &p_node->user_data.button_cfg, status, now_ms,
+                                    __tdl_button_event_emit, p_node);
 
-    if (status != p_node->device_data.status) { // Button status changed, perform debouncing
-        if (++(p_node->device_data.debounce_cnt) >=
-            (p_node->user_data.button_cfg.button_debounce_time / tdl_button_scan_time)) {
-            p_node->device_data.status = status;
-        }
-    } else {
-        p_node->device_data.debounce_cnt = 0;
+    // The release edge may not raise an interrupt, keep sampling while the button is held
+    if ((status || p_node->device_data.engine.status) && (wait > tdl_button_scan_time)) {
+        wait = tdl_button_scan_time;
     }
 
-    __tdl_button_state_handle(p_node);
-    return;
+    return wait;
 }
 
 // Button scan task: single button, combination button
@@ -899,12 +694,14 @@ static void __tdl_button_scan_thread(void *arg)
     LIST_HEAD *pos1 = NULL;
 
     while (1) {
+        uint32_t now_ms = (uint32_t)tal_system_get_millisecond();
+
         tuya_list_for_each(pos1, &p_head->hdr)
         {
             p_node = tuya_list_entry(pos1, TDL_BUTTON_LIST_NODE_T, hdr);
             if ((p_node != NULL) && (p_node->device_data.dev_cfg.button_mode == BUTTON_TIMER_SCAN_MODE)) {
                 tal_mutex_lock(p_node->button_mutex);
-                __tdl_button_handle(p_node);
+                __tdl_button_handle(p_node, now_ms);
                 tal_mutex_unlock(p_node->button_mutex);
             }
         }
@@ -922,49 +719,36 @@ static void __tdl_button_scan_thread(void *arg)
     }
 }
 
-// Button interrupt scan task
+// Button interrupt task: woken by GPIO edges, sleeps until the earliest button deadline
 static void __tdl_button_irq_thread(void *arg)
 {
     TDL_BUTTON_LIST_HEAD_T *p_head = p_button_list;
-    // TDL_BUTTON_LIST_HEAD_T *p_combine_head = p_combine_button_list;
     TDL_BUTTON_LIST_NODE_T *p_node = NULL;
-    // TDL_BUTTON_COMBINE_LIST_NODE_T *p_combine_node = NULL;
     LIST_HEAD *pos1 = NULL;
+    uint32_t wait = SEM_WAIT_FOREVER;
 
     while (1) {
-        PR_NOTICE("semaphore wait");
-        tal_semaphore_wait(tdl_button_local.irq_semaphore, SEM_WAIT_FOREVER);
-        tdl_button_local.irq_scan_cnt = 0;
-        PR_NOTICE("semaphore across");
-
-        while (1) {
-            tuya_list_for_each(pos1, &p_head->hdr)
-            {
-                p_node = tuya_list_entry(pos1, TDL_BUTTON_LIST_NODE_T, hdr);
-                if ((p_node != NULL) && (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE)) {
-                    tal_mutex_lock(p_node->button_mutex);
-                    __tdl_button_handle(p_node);
-                    tal_mutex_unlock(p_node->button_mutex);
-                }
-            }
-#if (COMBINE_BUTTON_ENABLE == 1)
-            // Combination key callback execution
-            if (tdl_button_local.scan_task_flag == FALSE) {
-                tuya_list_for_each(pos2, &p_combine_head->hdr)
-                {
-                    p_combine_node = tuya_list_entry(pos2, TDL_BUTTON_COMBINE_LIST_NODE_T, hdr);
-                    if (p_combine_node->combine_cb) {
-                        p_combine_node->combine_cb();
-                    }
+        // Timing out is the normal way to reach a deadline, the result is not checked
+        tal_semaphore_wait(tdl_button_local.irq_semaphore, wait);
+
+        uint32_t now_ms = (uint32_t)tal_system_get_millisecond();
+        wait = SEM_WAIT_FOREVER;
+
+        tuya_list_for_each(pos1, &p_head->hdr)
+        {
+            p_node = tuya_list_entry(pos1, TDL_BUTTON_LIST_NODE_T, hdr);
+            if ((p_node != NULL) && (p_node->device_data.dev_cfg.button_mode == BUTTON_IRQ_MODE)) {
+                tal_mutex_lock(p_node->button_mutex);
+                uint32_t node_wait = __tdl_button_handle(p_node, now_ms);
+                tal_mutex_unlock(p_node->button_mutex);
+                if (node_wait < wait) {
+                    wait = node_wait;
                 }
             }
-#endif
-            // Interrupt disconnection count check
-            if (++tdl_button_local.irq_scan_cnt >= TDL_BUTTON_IRQ_SCAN_CNT) {
-                break;
-            } else {
-                tal_system_sleep(tdl_button_scan_time);
-            }
+        }
+
+        if (wait == 0) {
+            wait = 1;
         }
     }
 }
@@ -1079,7 +863,7 @@ void tdl_button_get_current_long_press_time(TDL_BUTTON_HANDLE handle, uint16_t *
 
     p_node = __tdl_button_find_node(handle);
     if (NULL != p_node) {
-        *long_start_time = p_node->device_data.ticks * tdl_button_scan_time;
+        *long_start_time = (uint32_t)tal_system_get_millisecond() - p_node->device_data.engine.press_ms;
     }
     return;
 }
@@ -1105,7 +889,7 @@ void tdl_button_get_repeat_cnt(TDL_BUTTON_HANDLE handle, uint8_t *count)
 
     p_node = __tdl_button_find_node(handle);
     if (NULL != p_node) {
-        *count = p_node->device_data.repeat;
+        *count = p_node->device_data.engine.repeat;
     }
     return;
 }
@@ -1154,8 +938,8 @@ void tdl_button_get_event(TDL_BUTTON_HANDLE handle, TDL_BUTTON_TOUCH_EVENT_E *pr
 
     p_node = __tdl_button_find_node(handle);
     if (NULL != p_node) {
-        *pre_event = p_node->device_data.pre_event;
-        *now_event = p_node->device_data.now_event;
+        *pre_event = p_node->device_data.engine.pre_event;
+        *now_event = p_node->device_data.engine.now_event;
     }
     return;
 }
@@ -1269,6 +1053,5 @@ OPERATE_RET tdl_button_set_scan_time(uint8_t time_ms)
     if (time_ms < TDL_BUTTON_SCAN_TIME)
         return OPRT_INVALID_PARM;
     tdl_button_scan_time = time_ms;
-    tdl_button_local.irq_scan_cnt = TDL_BUTTON_IRQ_SCAN_TIME / time_ms;
     return OPRT_OK;
 }
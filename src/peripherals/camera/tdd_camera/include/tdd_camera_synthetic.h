@@ -0,0 +1,48 @@
+/**
+ * @file tdd_camera_synthetic.h
+ * @version 0.1
+ *
+ * A camera without hardware: a thread produces test frames at the configured
+ * rate, or as fast as frame buffers come back when fps is 0. Raw frames are
+ * YUV422 with a moving band, encoded frames are JPEG sized blocks with the SOI
+ * and EOI markers. It is meant for benchmarks and for running camera code on
+ * Linux.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ */
+
+#ifndef __TDD_CAMERA_SYNTHETIC_H__
+#define __TDD_CAMERA_SYNTHETIC_H__
+
+#include "tuya_cloud_types.h"
+#include "tdl_camera_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    uint16_t              max_fps;
+    uint32_t              max_width;
+    uint32_t              max_height;
+}TDD_SYNTHETIC_CFG_T;
+
+/***********************************************************
+********************function declaration********************
+***********************************************************/
+
+OPERATE_RET tdl_camera_synthetic_device_register(char *name, TDD_SYNTHETIC_CFG_T *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TDD_CAMERA_SYNTHETIC_H__ */
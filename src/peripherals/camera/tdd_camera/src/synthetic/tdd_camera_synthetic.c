@@ -0,0 +1,242 @@
+/**
+ * @file tdd_camera_synthetic.c
+ * @version 0.1
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ */
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+
+#include "tdd_camera_synthetic.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define SYNTHETIC_BAND_LINES        (16)
+#define SYNTHETIC_ENCODED_PCT       (10)  // encoded frame size, percent of the raw one
+#define SYNTHETIC_GOP               (30)
+#define SYNTHETIC_YUV422_BYTES      (2)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    TDD_SYNTHETIC_CFG_T       cfg;
+    TDD_CAMERA_OPEN_CFG_T     open_cfg;
+    THREAD_HANDLE             thrd;
+    volatile bool             is_running;
+    uint16_t                  frame_id;
+}CAMERA_SYNTHETIC_DEV_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static bool __synthetic_post_raw(CAMERA_SYNTHETIC_DEV_T *dev)
+{
+    TDD_CAMERA_FRAME_T *tdd_frame = NULL;
+    uint32_t line_len = dev->open_cfg.width * SYNTHETIC_YUV422_BYTES;
+    uint32_t len = line_len * dev->open_cfg.height;
+    uint32_t band;
+
+    tdd_frame = tdl_camera_create_tdd_frame((TDD_CAMERA_DEV_HANDLE_T)dev, TUYA_FRAME_FMT_YUV422);
+    if(NULL == tdd_frame) {
+        return false;
+    }
+
+    if(len > tdd_frame->frame.data_len) {
+        tdl_camera_release_tdd_frame((TDD_CAMERA_DEV_HANDLE_T)dev, tdd_frame);
+        return false;
+    }
+
+    // a DMA fills a real frame, only the moving band is written here
+    band = (dev->frame_id * 4) % dev->open_cfg.height;
+    if(band + SYNTHETIC_BAND_LINES > dev->open_cfg.height) {
+        band = dev->open_cfg.height - SYNTHETIC_BAND_LINES;
+    }
+    memset(tdd_frame->frame.data + band * line_len, dev->frame_id & 0xFF, SYNTHETIC_BAND_LINES * line_len);
+
+    tdd_frame->frame.id          = dev->frame_id;
+    tdd_frame->frame.is_i_frame  = 1;
+    tdd_frame->frame.is_complete = 1;
+    tdd_frame->frame.width       = dev->open_cfg.width;
+    tdd_frame->frame.height      = dev->open_cfg.height;
+    tdd_frame->frame.data_len    = len;
+    tdd_frame->frame.total_frame_len = len;
+
+    tdl_camera_post_tdd_frame((TDD_CAMERA_DEV_HANDLE_T)dev, tdd_frame);
+
+    return true;
+}
+
+static bool __synthetic_post_encoded(CAMERA_SYNTHETIC_DEV_T *dev)
+{
+    TDD_CAMERA_FRAME_T *tdd_frame = NULL;
+    TUYA_FRAME_FMT_E fmt = (dev->open_cfg.out_fmt & TDL_CAMERA_FMT_H264) ? TUYA_FRAME_FMT_H264 : TUYA_FRAME_FMT_JPEG;
+    uint32_t len = (uint32_t)dev->open_cfg.width * dev->open_cfg.height * SYNTHETIC_YUV422_BYTES * \
+                   SYNTHETIC_ENCODED_PCT / 100;
+    uint8_t *data = NULL;
+    bool is_i_frame = (0 == dev->frame_id % SYNTHETIC_GOP);
+
+    tdd_frame = tdl_camera_create_tdd_frame((TDD_CAMERA_DEV_HANDLE_T)dev, fmt);
+    if(NULL == tdd_frame) {
+        return false;
+    }
+
+    if(len > tdd_frame->frame.data_len) {
+        len = tdd_frame->frame.data_len;
+    }
+
+    data = tdd_frame->frame.data;
+    if(TUYA_FRAME_FMT_H264 == fmt) {
+        data[0] = 0x00;
+        data[1] = 0x00;
+        data[2] = 0x00;
+        data[3] = 0x01;
+        data[4] = is_i_frame ? 0x65 : 0x41;
+    } else {
+        data[0] = 0xFF;
+        data[1] = 0xD8;
+        data[len - 2] = 0xFF;
+        data[len - 1] = 0xD9;
+    }
+
+    tdd_frame->frame.id          = dev->frame_id;
+    tdd_frame->frame.is_i_frame  = (TUYA_FRAME_FMT_H264 == fmt) ? is_i_frame : 1;
+    tdd_frame->frame.is_complete = 1;
+    tdd_frame->frame.width       = dev->open_cfg.width;
+    tdd_frame->frame.height      = dev->open_cfg.height;
+    tdd_frame->frame.data_len    = len;
+    tdd_frame->frame.total_frame_len = len;
+
+    tdl_camera_post_tdd_frame((TDD_CAMERA_DEV_HANDLE_T)dev, tdd_frame);
+
+    return true;
+}
+
+static void __synthetic_task(void *args)
+{
+    CAMERA_SYNTHETIC_DEV_T *dev = (CAMERA_SYNTHETIC_DEV_T *)args;
+    uint32_t period_ms = dev->open_cfg.fps ? 1000 / dev->open_cfg.fps : 0;
+    SYS_TIME_T next_ms = tal_system_get_millisecond();
+    SYS_TIME_T now_ms;
+    THREAD_HANDLE thrd = NULL;
+    bool posted;
+
+    while(dev->is_running) {
+        posted = false;
+
+        if(dev->open_cfg.out_fmt & TDL_IMG_FMT_RAW_MASK) {
+            posted |= __synthetic_post_raw(dev);
+        }
+        if(dev->open_cfg.out_fmt & TDL_IMG_FMT_ENCODED_MASK) {
+            posted |= __synthetic_post_encoded(dev);
+        }
+        dev->frame_id++;
+
+        if(period_ms) {
+            next_ms += period_ms;
+            now_ms = tal_system_get_millisecond();
+            if((int32_t)(next_ms - now_ms) > 0) {
+                tal_system_sleep(next_ms - now_ms);
+            } else {
+                next_ms = now_ms;
+            }
+        } else if(false == posted) {
+            // every buffer is held by the subscribers
+            tal_system_sleep(1);
+        }
+    }
+
+    thrd = dev->thrd;
+    // close() waits for this
+    dev->thrd = NULL;
+    tal_thread_delete(thrd);
+}
+
+static OPERATE_RET __tdd_camera_synthetic_open(TDD_CAMERA_DEV_HANDLE_T device, TDD_CAMERA_OPEN_CFG_T *cfg)
+{
+    OPERATE_RET rt = OPRT_OK;
+    CAMERA_SYNTHETIC_DEV_T *dev = (CAMERA_SYNTHETIC_DEV_T *)device;
+
+    if(NULL == device || NULL == cfg) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if(dev->is_running) {
+        return OPRT_OK;
+    }
+
+    if(cfg->width > dev->cfg.max_width || cfg->height > dev->cfg.max_height || \
+       cfg->height < SYNTHETIC_BAND_LINES) {
+        PR_ERR("unsupported resolution: %dx%d", cfg->width, cfg->height);
+        return OPRT_INVALID_PARM;
+    }
+
+    memcpy(&dev->open_cfg, cfg, sizeof(TDD_CAMERA_OPEN_CFG_T));
+    dev->is_running = true;
+
+    THREAD_CFG_T thread_cfg = {4096, THREAD_PRIO_1, "synthetic_camera"};
+    rt = tal_thread_create_and_start(&dev->thrd, NULL, NULL, __synthetic_task, dev, &thread_cfg);
+    if(OPRT_OK != rt) {
+        dev->is_running = false;
+    }
+
+    return rt;
+}
+
+static OPERATE_RET __tdd_camera_synthetic_close(TDD_CAMERA_DEV_HANDLE_T device)
+{
+    CAMERA_SYNTHETIC_DEV_T *dev = (CAMERA_SYNTHETIC_DEV_T *)device;
+
+    if(NULL == device) {
+        return OPRT_INVALID_PARM;
+    }
+
+    dev->is_running = false;
+    while(dev->thrd) {
+        tal_system_sleep(10);
+    }
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tdl_camera_synthetic_device_register(char *name, TDD_SYNTHETIC_CFG_T *cfg)
+{
+    CAMERA_SYNTHETIC_DEV_T *dev = NULL;
+    TDD_CAMERA_DEV_INFO_T dev_info;
+
+    if(NULL == name || NULL == cfg) {
+        return OPRT_INVALID_PARM;
+    }
+
+    dev = (CAMERA_SYNTHETIC_DEV_T *)tal_malloc(sizeof(CAMERA_SYNTHETIC_DEV_T));
+    if(NULL == dev) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(dev, 0, sizeof(CAMERA_SYNTHETIC_DEV_T));
+
+    memcpy(&dev->cfg, cfg, sizeof(TDD_SYNTHETIC_CFG_T));
+
+    dev_info.type       = TDL_CAMERA_SYNTHETIC;
+    dev_info.max_fps    = cfg->max_fps;
+    dev_info.max_width  = cfg->max_width;
+    dev_info.max_height = cfg->max_height;
+    dev_info.fmt        = TUYA_FRAME_FMT_YUV422;
+
+    TDD_CAMERA_INTFS_T camera_intfs = {
+        .open  = __tdd_camera_synthetic_open,
+        .close = __tdd_camera_synthetic_close,
+    };
+
+    OPERATE_RET rt = tdl_camera_device_register(name, (TDD_CAMERA_DEV_HANDLE_T)dev, &camera_intfs, &dev_info);
+    if (OPRT_OK != rt) {
+        tal_free(dev);
+    }
+
+    return rt;
+}
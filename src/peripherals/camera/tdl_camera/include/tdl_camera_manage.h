@@ -1,6 +1,16 @@
 /**
  * @file tdl_camera_manage.h
  * @version 0.1
+ *
+ * Frames are reference counted and shared by every subscriber of a device:
+ * the display, an encoder and a stream can all receive the same frame buffer
+ * without copying it. Each subscriber has its own thread and its own queue, so
+ * a slow consumer only drops its own frames; TDL_CAMERA_SUB_LATEST keeps just
+ * the newest frame waiting, TDL_CAMERA_SUB_QUEUE keeps them in order and drops
+ * new ones when the queue is full. A frame goes back to the driver once every
+ * subscriber callback has returned and every tdl_camera_frame_ref() has been
+ * matched by tdl_camera_frame_unref().
+ *
  * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
  */
 
@@ -24,6 +34,7 @@ extern "C" {
 ***********************************************************/
 typedef enum  {
     TDL_CAMERA_DVP= 0,
+    TDL_CAMERA_SYNTHETIC,
 }TDL_CAMERA_TYPE_E;
 
 typedef enum {
@@ -70,8 +81,43 @@ typedef struct {
     TDL_CAMERA_FMT_E          out_fmt;
     TDL_CAMERA_GET_FRAME_CB   get_frame_cb;
     TDL_CAMERA_GET_FRAME_CB   get_encoded_frame_cb;
+    uint8_t                   raw_frame_cnt;      // frame buffers, 0: default, add one per subscriber
+    uint8_t                   encoded_frame_cnt;  // that holds frames
 }TDL_CAMERA_CFG_T;
 
+typedef enum {
+    TDL_CAMERA_SUB_QUEUE = 0,   // deliver every frame in order, drop new frames when the queue is full
+    TDL_CAMERA_SUB_LATEST,      // deliver only the newest frame, replace the one waiting
+} TDL_CAMERA_SUB_POLICY_E;
+
+typedef void*  TDL_CAMERA_SUB_HANDLE_T;
+
+/* the frame stays valid until the callback returns, tdl_camera_frame_ref() keeps it longer */
+typedef void (*TDL_CAMERA_SUB_CB)(TDL_CAMERA_HANDLE_T hdl, TDL_CAMERA_FRAME_T *frame, void *arg);
+
+typedef struct {
+    TDL_CAMERA_FMT_E          fmt;          // TDL_CAMERA_FMT_YUV422 for raw frames, JPEG or H264 for encoded ones
+    TDL_CAMERA_SUB_POLICY_E   policy;
+    uint8_t                   queue_depth;  // TDL_CAMERA_SUB_QUEUE only, 0: default
+    uint32_t                  stack_size;   // 0: default
+    uint8_t                   priority;     // THREAD_PRIO_E, 0: default
+    TDL_CAMERA_SUB_CB         cb;
+    void                     *arg;
+} TDL_CAMERA_SUB_CFG_T;
+
+typedef struct {
+    uint32_t                  delivered;
+    uint32_t                  dropped;      // frames this subscriber missed because it was behind
+    uint32_t                  age_avg_ms;   // from the driver posting a frame to the callback
+    uint32_t                  age_max_ms;
+} TDL_CAMERA_SUB_STATS_T;
+
+typedef struct {
+    uint32_t                  raw_posted;
+    uint32_t                  encoded_posted;
+    uint32_t                  no_buffer;    // frames the driver could not capture, every buffer was in use
+} TDL_CAMERA_DEV_STATS_T;
+
 
 /***********************************************************
 ********************function declaration********************
@@ -85,6 +131,19 @@ OPERATE_RET tdl_camera_dev_open(TDL_CAMERA_HANDLE_T camera_hdl,  TDL_CAMERA_CFG_
 
 OPERATE_RET tdl_camera_dev_close(TDL_CAMERA_HANDLE_T camera_hdl);
 
+OPERATE_RET tdl_camera_dev_get_stats(TDL_CAMERA_HANDLE_T camera_hdl, TDL_CAMERA_DEV_STATS_T *stats);
+
+OPERATE_RET tdl_camera_subscribe(TDL_CAMERA_HANDLE_T camera_hdl, TDL_CAMERA_SUB_CFG_T *cfg,\
+                                 TDL_CAMERA_SUB_HANDLE_T *sub_hdl);
+
+OPERATE_RET tdl_camera_unsubscribe(TDL_CAMERA_SUB_HANDLE_T sub_hdl);
+
+OPERATE_RET tdl_camera_sub_get_stats(TDL_CAMERA_SUB_HANDLE_T sub_hdl, TDL_CAMERA_SUB_STATS_T *stats);
+
+void tdl_camera_frame_ref(TDL_CAMERA_FRAME_T *frame);
+
+void tdl_camera_frame_unref(TDL_CAMERA_FRAME_T *frame);
+
 #ifdef __cplusplus
 }
 #endif
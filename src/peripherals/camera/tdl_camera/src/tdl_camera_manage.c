@@ -22,14 +22,20 @@
 #define CAMERA_RAW_PER_PIXEL_MAX_BYTE       (3)
 #define CAMERA_ENCODE_MIN_COMP_PCT          (20) // uint:ENCODE
 
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM==1)
-#define TDL_CAMERA_FRAME_MALLOC    tkl_system_psram_malloc
-#define TDL_CAMERA_FRAME_FREE      tkl_system_psram_free
-#else
-#define TDL_CAMERA_FRAME_MALLOC    tal_malloc
-#define TDL_CAMERA_FRAME_FREE      tal_free
+#define CAMERA_SUB_QUEUE_DEPTH_DEF          (2)
+#define CAMERA_SUB_QUEUE_DEPTH_MAX          (16)
+#define CAMERA_SUB_STACK_SIZE_DEF           (4096)
+#define CAMERA_SUB_PRIORITY_DEF             (THREAD_PRIO_1)
+
+// bytes of frame buffers all the cameras may hold, 0: not limited
+#ifndef TDL_CAMERA_FRAME_MEM_BUDGET
+#define TDL_CAMERA_FRAME_MEM_BUDGET 0
 #endif
 
+// frames are in PSRAM when the board has it, they would crowd internal RAM out otherwise
+#define TDL_CAMERA_FRAME_MALLOC(size) tal_mem_budget_malloc(&sg_camera_frame_budget, size)
+#define TDL_CAMERA_FRAME_FREE         tal_mem_budget_free
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -40,11 +46,13 @@ typedef struct {
     MUTEX_HANDLE                mutex;
    
     TDL_CAMERA_DEV_INFO_T       info;
-    TDL_CAMERA_GET_FRAME_CB     get_raw_frame_cb;
-    TDL_CAMERA_GET_FRAME_CB     get_encoded_frame_cb;
 
     struct tuya_list_head       raw_frame_node_list;
     struct tuya_list_head       encoded_frame_node_list;
+    struct tuya_list_head       sub_list;
+    TDL_CAMERA_SUB_HANDLE_T     raw_cb_sub;
+    TDL_CAMERA_SUB_HANDLE_T     encoded_cb_sub;
+    TDL_CAMERA_DEV_STATS_T      stats;
 
     TDD_CAMERA_DEV_HANDLE_T     tdd_hdl;
     TDD_CAMERA_INTFS_T          intfs;
@@ -52,26 +60,38 @@ typedef struct {
 
 typedef struct {
     struct tuya_list_head       node;
+    struct tuya_list_head      *free_list;
+    uint32_t                    buf_len;
+    uint32_t                    ref_cnt;
+    SYS_TIME_T                  post_ms;
     TDD_CAMERA_FRAME_T          tdd_frame;
 } CAMERA_FRAME_NODE_T;
 
 typedef struct {
-    QUEUE_HANDLE                raw_frame_queue;
-    QUEUE_HANDLE                encoded_frame_queue;
-    THREAD_HANDLE               raw_thrd;
-    THREAD_HANDLE               encoded_thrd;
-}CAMERA_MANAGE_INFO_T;
-
-typedef struct {
-    TDD_CAMERA_FRAME_T         *tdd_frame;
+    struct tuya_list_head       node;
     CAMERA_DEVICE_T            *dev;
-} CAMERA_MSG_T;
+    TDL_CAMERA_SUB_CFG_T        cfg;
+    bool                        is_encoded;
+    volatile bool               is_running;
+    SEM_HANDLE                  sem;
+    THREAD_HANDLE               thrd;
+
+    // frames waiting for the callback, each holds a reference
+    CAMERA_FRAME_NODE_T        *ring[CAMERA_SUB_QUEUE_DEPTH_MAX];
+    uint8_t                     depth;
+    uint8_t                     head;
+    uint8_t                     cnt;
+
+    TDL_CAMERA_SUB_STATS_T      stats;
+    uint64_t                    age_sum_ms;
+} CAMERA_SUB_T;
 
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
 static struct tuya_list_head sg_camera_list = LIST_HEAD_INIT(sg_camera_list);
-static CAMERA_MANAGE_INFO_T sg_camera_manage;
+static TAL_MEM_BUDGET_DEFINE(sg_camera_frame_budget, "camera_frame", TDL_CAMERA_FRAME_MEM_BUDGET, TAL_MEM_PLACE_PSRAM,
+                              TAL_MEM_BUDGET_STRICT);
 
 /***********************************************************
 ***********************function define**********************
@@ -163,6 +183,8 @@ static OPERATE_RET __camera_frame_node_init(struct tuya_list_head *phead, uint32
         }
         frame_node->tdd_frame.frame.data_len = buf_len;
         frame_node->tdd_frame.sys_param = (void *)frame_node;
+        frame_node->free_list = phead;
+        frame_node->buf_len = buf_len;
 
         tuya_list_add(&frame_node->node, phead);
 
@@ -172,76 +194,116 @@ static OPERATE_RET __camera_frame_node_init(struct tuya_list_head *phead, uint32
     return OPRT_OK;
 }
 
-static void __raw_flow_task(void *args)
+static CAMERA_FRAME_NODE_T *__camera_frame_node_of(TDL_CAMERA_FRAME_T *frame)
 {
-    CAMERA_MSG_T msg;
+    return (CAMERA_FRAME_NODE_T *)((uint8_t *)frame - offsetof(CAMERA_FRAME_NODE_T, tdd_frame.frame));
+}
 
-	while (1)
-	{
+/* called inside the critical section */
+static void __camera_frame_put(CAMERA_FRAME_NODE_T *pnode)
+{
+    if (pnode->ref_cnt && 0 == --pnode->ref_cnt) {
+        tuya_list_add_tail(&pnode->node, pnode->free_list);
+    }
+}
 
-		tal_queue_fetch(sg_camera_manage.raw_frame_queue, &msg, SEM_WAIT_FOREVER);
-		if(NULL == msg.dev || NULL == msg.tdd_frame) {
-            continue;
+/* called inside the critical section, the caller wakes the subscriber when it returns true */
+static bool __camera_sub_push(CAMERA_SUB_T *sub, CAMERA_FRAME_NODE_T *pnode)
+{
+    if (sub->cnt == sub->depth) {
+        sub->stats.dropped++;
+        if (TDL_CAMERA_SUB_QUEUE == sub->cfg.policy) {
+            return false;
         }
+        // latest only: the waiting frame is replaced
+        __camera_frame_put(sub->ring[sub->head]);
+        sub->head = (sub->head + 1) % sub->depth;
+        sub->cnt--;
+    }
 
-		if((true == msg.dev->is_open) && msg.dev->get_raw_frame_cb) {
-            msg.dev->get_raw_frame_cb((TDL_CAMERA_HANDLE_T)msg.dev, &msg.tdd_frame->frame);
-        }
+    pnode->ref_cnt++;
+    sub->ring[(sub->head + sub->cnt) % sub->depth] = pnode;
+    sub->cnt++;
 
-		tdl_camera_release_tdd_frame(msg.dev->tdd_hdl, msg.tdd_frame);
-	}
+    return true;
 }
 
-static void __encoded_flow_task(void *args)
+static CAMERA_FRAME_NODE_T *__camera_sub_pop(CAMERA_SUB_T *sub)
 {
-    CAMERA_MSG_T msg;
+    CAMERA_FRAME_NODE_T *pnode = NULL;
 
-	while (1)
-	{
-		tal_queue_fetch(sg_camera_manage.encoded_frame_queue, &msg, SEM_WAIT_FOREVER);
-		if(NULL == msg.dev || NULL == msg.tdd_frame) {
+    TAL_ENTER_CRITICAL();
+    if (sub->cnt) {
+        pnode = sub->ring[sub->head];
+        sub->head = (sub->head + 1) % sub->depth;
+        sub->cnt--;
+    }
+    TAL_EXIT_CRITICAL();
+
+    return pnode;
+}
+
+static void __camera_sub_task(void *args)
+{
+    CAMERA_SUB_T *sub = (CAMERA_SUB_T *)args;
+    CAMERA_FRAME_NODE_T *pnode = NULL;
+    THREAD_HANDLE thrd = NULL;
+    uint32_t age_ms;
+
+    while (1) {
+        tal_semaphore_wait(sub->sem, SEM_WAIT_FOREVER);
+        if (false == sub->is_running) {
+            break;
+        }
+
+        pnode = __camera_sub_pop(sub);
+        if (NULL == pnode) {
             continue;
         }
 
-		if ((true == msg.dev->is_open) && msg.dev->get_encoded_frame_cb) {
-            msg.dev->get_encoded_frame_cb((TDL_CAMERA_HANDLE_T)msg.dev, &msg.tdd_frame->frame);
+        age_ms = (uint32_t)(tal_system_get_millisecond() - pnode->post_ms);
+        sub->age_sum_ms += age_ms;
+        sub->stats.delivered++;
+        sub->stats.age_avg_ms = (uint32_t)(sub->age_sum_ms / sub->stats.delivered);
+        if (age_ms > sub->stats.age_max_ms) {
+            sub->stats.age_max_ms = age_ms;
         }
 
-		tdl_camera_release_tdd_frame(msg.dev->tdd_hdl, msg.tdd_frame);
-	}
+        sub->cfg.cb((TDL_CAMERA_HANDLE_T)sub->dev, &pnode->tdd_frame.frame, sub->cfg.arg);
+
+        tdl_camera_frame_unref(&pnode->tdd_frame.frame);
+    }
+
+    // unsubscribed, the queue was already emptied
+    thrd = sub->thrd;
+    tal_semaphore_release(sub->sem);
+    tal_free(sub);
+
+    tal_thread_delete(thrd);
+}
+
+static void __camera_legacy_frame_cb(TDL_CAMERA_HANDLE_T hdl, TDL_CAMERA_FRAME_T *frame, void *arg)
+{
+    ((TDL_CAMERA_GET_FRAME_CB)arg)(hdl, frame);
 }
 
-static OPERATE_RET __camera_manage_init(TDL_CAMERA_FMT_E out_fmt)
+static OPERATE_RET __camera_legacy_subscribe(CAMERA_DEVICE_T *camera_dev, TDL_CAMERA_FMT_E fmt,\
+                                             TDL_CAMERA_GET_FRAME_CB cb, TDL_CAMERA_SUB_HANDLE_T *sub_hdl)
 {
-    OPERATE_RET rt;
+    TDL_CAMERA_SUB_CFG_T sub_cfg;
 
-    if(out_fmt & TDL_IMG_FMT_RAW_MASK) {
-        if(NULL == sg_camera_manage.raw_frame_queue) {
-            TUYA_CALL_ERR_RETURN(tal_queue_create_init(&(sg_camera_manage.raw_frame_queue),\
-                                                     sizeof(CAMERA_MSG_T), CAMERA_RAW_FRAME_BUFF_CNT));
-        }
-    
-        if(NULL == sg_camera_manage.raw_thrd) {
-            THREAD_CFG_T thread_cfg = {4096, THREAD_PRIO_1, "raw_flow_task"};
-            TUYA_CALL_ERR_RETURN(tal_thread_create_and_start(&(sg_camera_manage.raw_thrd), NULL, NULL,\
-                                                             __raw_flow_task, NULL, &thread_cfg));
-        }
+    if (NULL == cb || *sub_hdl) {
+        return OPRT_OK;
     }
 
-    if(out_fmt & TDL_IMG_FMT_ENCODED_MASK) {
-        if(NULL == sg_camera_manage.encoded_frame_queue) {
-            TUYA_CALL_ERR_RETURN(tal_queue_create_init(&(sg_camera_manage.encoded_frame_queue),\
-                                                     sizeof(CAMERA_MSG_T), CAMERA_RAW_FRAME_BUFF_CNT));
-        }
-    
-        if(NULL == sg_camera_manage.encoded_thrd) {
-            THREAD_CFG_T thread_cfg = {4096, THREAD_PRIO_1, "encoded_flow_task"};
-            TUYA_CALL_ERR_RETURN(tal_thread_create_and_start(&(sg_camera_manage.encoded_thrd), NULL, NULL,\
-                                                             __encoded_flow_task, NULL, &thread_cfg));
-        }
-    }
+    memset(&sub_cfg, 0, sizeof(TDL_CAMERA_SUB_CFG_T));
+    sub_cfg.fmt         = fmt;
+    sub_cfg.policy      = TDL_CAMERA_SUB_QUEUE;
+    sub_cfg.queue_depth = CAMERA_RAW_FRAME_BUFF_CNT;
+    sub_cfg.cb          = __camera_legacy_frame_cb;
+    sub_cfg.arg         = (void *)cb;
 
-    return OPRT_OK;
+    return tdl_camera_subscribe((TDL_CAMERA_HANDLE_T)camera_dev, &sub_cfg, sub_hdl);
 }
 
 TDL_CAMERA_HANDLE_T tdl_camera_find_dev(char *name)
@@ -274,22 +336,27 @@ OPERATE_RET tdl_camera_dev_open(TDL_CAMERA_HANDLE_T camera_hdl,  TDL_CAMERA_CFG_
 
     camera_dev = (CAMERA_DEVICE_T *)camera_hdl;
 
-    TUYA_CALL_ERR_RETURN(__camera_manage_init(cfg->out_fmt));
-
     raw_buf_len = cfg->width * cfg->height * CAMERA_RAW_PER_PIXEL_MAX_BYTE;
 
-    if(cfg->out_fmt & TDL_IMG_FMT_RAW_MASK) {
+    // the buffers are kept across close and open
+    if((cfg->out_fmt & TDL_IMG_FMT_RAW_MASK) && tuya_list_empty(&camera_dev->raw_frame_node_list)) {
         TUYA_CALL_ERR_RETURN(__camera_frame_node_init(&camera_dev->raw_frame_node_list, \
-                                                      CAMERA_RAW_FRAME_BUFF_CNT, raw_buf_len));
-        camera_dev->get_raw_frame_cb = cfg->get_frame_cb;
+                                                      cfg->raw_frame_cnt ? cfg->raw_frame_cnt : CAMERA_RAW_FRAME_BUFF_CNT,\
+                                                      raw_buf_len));
     }
 
-    if(cfg->out_fmt & TDL_IMG_FMT_ENCODED_MASK) {
+    if((cfg->out_fmt & TDL_IMG_FMT_ENCODED_MASK) && tuya_list_empty(&camera_dev->encoded_frame_node_list)) {
         uint32_t encoded_buf_len = (raw_buf_len * CAMERA_ENCODE_MIN_COMP_PCT + 99) / 100;
         TUYA_CALL_ERR_RETURN(__camera_frame_node_init(&camera_dev->encoded_frame_node_list, \
+                                                      cfg->encoded_frame_cnt ? cfg->encoded_frame_cnt : \
                                                       CAMERA_ENCODE_FRAME_BUFF_CNT, encoded_buf_len));
-        camera_dev->get_encoded_frame_cb = cfg->get_encoded_frame_cb;
-    }  
+    }
+
+    // the callbacks of the configuration are subscribers like any other
+    TUYA_CALL_ERR_RETURN(__camera_legacy_subscribe(camera_dev, TDL_CAMERA_FMT_YUV422, cfg->get_frame_cb,\
+                                                   &camera_dev->raw_cb_sub));
+    TUYA_CALL_ERR_RETURN(__camera_legacy_subscribe(camera_dev, TDL_CAMERA_FMT_JPEG, cfg->get_encoded_frame_cb,\
+                                                   &camera_dev->encoded_cb_sub));
     
     camera_dev->info.fps     = cfg->fps;
     camera_dev->info.width   = cfg->width;
@@ -314,7 +381,170 @@ OPERATE_RET tdl_camera_dev_open(TDL_CAMERA_HANDLE_T camera_hdl,  TDL_CAMERA_CFG_
 
 OPERATE_RET tdl_camera_dev_close(TDL_CAMERA_HANDLE_T camera_hdl)
 {
-    return OPRT_NOT_SUPPORTED;
+    OPERATE_RET rt = OPRT_OK;
+    CAMERA_DEVICE_T *camera_dev = (CAMERA_DEVICE_T *)camera_hdl;
+
+    if (NULL == camera_dev) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (NULL == camera_dev->intfs.close) {
+        return OPRT_NOT_SUPPORTED;
+    }
+
+    if (camera_dev->is_open) {
+        TUYA_CALL_ERR_RETURN(camera_dev->intfs.close(camera_dev->tdd_hdl));
+        camera_dev->is_open = false;
+    }
+
+    if (camera_dev->raw_cb_sub) {
+        tdl_camera_unsubscribe(camera_dev->raw_cb_sub);
+        camera_dev->raw_cb_sub = NULL;
+    }
+
+    if (camera_dev->encoded_cb_sub) {
+        tdl_camera_unsubscribe(camera_dev->encoded_cb_sub);
+        camera_dev->encoded_cb_sub = NULL;
+    }
+
+    return rt;
+}
+
+OPERATE_RET tdl_camera_dev_get_stats(TDL_CAMERA_HANDLE_T camera_hdl, TDL_CAMERA_DEV_STATS_T *stats)
+{
+    CAMERA_DEVICE_T *camera_dev = (CAMERA_DEVICE_T *)camera_hdl;
+
+    if (NULL == camera_dev || NULL == stats) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memcpy(stats, &camera_dev->stats, sizeof(TDL_CAMERA_DEV_STATS_T));
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tdl_camera_subscribe(TDL_CAMERA_HANDLE_T camera_hdl, TDL_CAMERA_SUB_CFG_T *cfg,\
+                                 TDL_CAMERA_SUB_HANDLE_T *sub_hdl)
+{
+    OPERATE_RET rt = OPRT_OK;
+    CAMERA_DEVICE_T *camera_dev = (CAMERA_DEVICE_T *)camera_hdl;
+    CAMERA_SUB_T *sub = NULL;
+
+    if (NULL == camera_dev || NULL == cfg || NULL == cfg->cb || NULL == sub_hdl) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (cfg->queue_depth > CAMERA_SUB_QUEUE_DEPTH_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+
+    NEW_LIST_NODE(CAMERA_SUB_T, sub);
+    if (NULL == sub) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(sub, 0, sizeof(CAMERA_SUB_T));
+
+    sub->dev        = camera_dev;
+    sub->is_encoded = (cfg->fmt & TDL_IMG_FMT_ENCODED_MASK) ? true : false;
+    sub->is_running = true;
+    memcpy(&sub->cfg, cfg, sizeof(TDL_CAMERA_SUB_CFG_T));
+
+    if (TDL_CAMERA_SUB_LATEST == cfg->policy) {
+        sub->depth = 1;
+    } else {
+        sub->depth = cfg->queue_depth ? cfg->queue_depth : CAMERA_SUB_QUEUE_DEPTH_DEF;
+    }
+
+    // one count per waiting frame, plus one for unsubscribe
+    TUYA_CALL_ERR_GOTO(tal_semaphore_create_init(&sub->sem, 0, sub->depth + 1), __ERR);
+
+    THREAD_CFG_T thread_cfg = {cfg->stack_size ? cfg->stack_size : CAMERA_SUB_STACK_SIZE_DEF,\
+                               cfg->priority ? cfg->priority : CAMERA_SUB_PRIORITY_DEF, "camera_sub_task"};
+    TUYA_CALL_ERR_GOTO(tal_thread_create_and_start(&sub->thrd, NULL, NULL, __camera_sub_task, sub, &thread_cfg),\
+                       __ERR);
+
+    TAL_ENTER_CRITICAL();
+    tuya_list_add_tail(&sub->node, &camera_dev->sub_list);
+    TAL_EXIT_CRITICAL();
+
+    *sub_hdl = (TDL_CAMERA_SUB_HANDLE_T)sub;
+
+    return OPRT_OK;
+
+__ERR:
+    if (sub->sem) {
+        tal_semaphore_release(sub->sem);
+    }
+    FreeNode(sub);
+
+    return rt;
+}
+
+OPERATE_RET tdl_camera_unsubscribe(TDL_CAMERA_SUB_HANDLE_T sub_hdl)
+{
+    CAMERA_SUB_T *sub = (CAMERA_SUB_T *)sub_hdl;
+
+    if (NULL == sub) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TAL_ENTER_CRITICAL();
+    tuya_list_del(&sub->node);
+    sub->is_running = false;
+    while (sub->cnt) {
+        __camera_frame_put(sub->ring[sub->head]);
+        sub->head = (sub->head + 1) % sub->depth;
+        sub->cnt--;
+    }
+    TAL_EXIT_CRITICAL();
+
+    // the task frees the subscriber once its current callback has returned
+    tal_semaphore_post(sub->sem);
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tdl_camera_sub_get_stats(TDL_CAMERA_SUB_HANDLE_T sub_hdl, TDL_CAMERA_SUB_STATS_T *stats)
+{
+    CAMERA_SUB_T *sub = (CAMERA_SUB_T *)sub_hdl;
+
+    if (NULL == sub || NULL == stats) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memcpy(stats, &sub->stats, sizeof(TDL_CAMERA_SUB_STATS_T));
+
+    return OPRT_OK;
+}
+
+void tdl_camera_frame_ref(TDL_CAMERA_FRAME_T *frame)
+{
+    CAMERA_FRAME_NODE_T *pnode = NULL;
+
+    if (NULL == frame) {
+        return;
+    }
+
+    pnode = __camera_frame_node_of(frame);
+
+    TAL_ENTER_CRITICAL();
+    pnode->ref_cnt++;
+    TAL_EXIT_CRITICAL();
+}
+
+void tdl_camera_frame_unref(TDL_CAMERA_FRAME_T *frame)
+{
+    CAMERA_FRAME_NODE_T *pnode = NULL;
+
+    if (NULL == frame) {
+        return;
+    }
+
+    pnode = __camera_frame_node_of(frame);
+
+    TAL_ENTER_CRITICAL();
+    __camera_frame_put(pnode);
+    TAL_EXIT_CRITICAL();
 }
 
 OPERATE_RET tdl_camera_device_register(char *name, TDD_CAMERA_DEV_HANDLE_T tdd_hdl, \
@@ -342,6 +572,7 @@ OPERATE_RET tdl_camera_device_register(char *name, TDD_CAMERA_DEV_HANDLE_T tdd_h
 
     INIT_LIST_HEAD(&(camera_dev->raw_frame_node_list));
     INIT_LIST_HEAD(&(camera_dev->encoded_frame_node_list));
+    INIT_LIST_HEAD(&(camera_dev->sub_list));
 
     PR_DEBUG("raw_frame_node_list:%p next:%p pre:%p", &camera_dev->raw_frame_node_list, \
             camera_dev->raw_frame_node_list.next,camera_dev->raw_frame_node_list.prev);
@@ -368,26 +599,30 @@ TDD_CAMERA_FRAME_T *tdl_camera_create_tdd_frame(TDD_CAMERA_DEV_HANDLE_T tdd_hdl,
 
     pframe_list = (false == __is_camera_frame_encoded(fmt)) ? \
                   &camera_dev->raw_frame_node_list : &camera_dev->encoded_frame_node_list;
-             
-    if(tuya_list_empty(pframe_list)) {
-        return NULL;
-    }
 
-    pnode = tuya_list_entry(pframe_list->next, CAMERA_FRAME_NODE_T, node);
+    TAL_ENTER_CRITICAL();
+    if(false == tuya_list_empty(pframe_list)) {
+        pnode = tuya_list_entry(pframe_list->next, CAMERA_FRAME_NODE_T, node);
+        tuya_list_del(&pnode->node);
+        // the driver holds the first reference until it posts the frame
+        pnode->ref_cnt = 1;
+    } else {
+        camera_dev->stats.no_buffer++;
+    }
+    TAL_EXIT_CRITICAL();
 
-    tuya_list_del(&pnode->node);
+    if(NULL == pnode) {
+        return NULL;
+    }
 
     pnode->tdd_frame.frame.fmt = fmt;
+    pnode->tdd_frame.frame.data_len = pnode->buf_len;
 
     return &pnode->tdd_frame;
 }
 
 void tdl_camera_release_tdd_frame(TDD_CAMERA_DEV_HANDLE_T tdd_hdl, TDD_CAMERA_FRAME_T *frame)
 {    
-    CAMERA_DEVICE_T *camera_dev = NULL;
-    struct tuya_list_head *pframe_list = NULL;
-    CAMERA_FRAME_NODE_T *pnode = NULL;
-
     if(NULL == frame || NULL == tdd_hdl) {
         return;
     }
@@ -397,26 +632,18 @@ void tdl_camera_release_tdd_frame(TDD_CAMERA_DEV_HANDLE_T tdd_hdl, TDD_CAMERA_FR
         return;
     }
 
-    camera_dev = __find_camera_device_from_tdd(tdd_hdl);
-    if (NULL == camera_dev) {
-        return;
-    }
-
-    pframe_list = (false == __is_camera_frame_encoded(frame->frame.fmt)) ? \
-                  &camera_dev->raw_frame_node_list : &camera_dev->encoded_frame_node_list;
-
-    pnode = (CAMERA_FRAME_NODE_T *)frame->sys_param;
-
-    tuya_list_add_tail(&pnode->node, pframe_list);
+    tdl_camera_frame_unref(&frame->frame);
 
     return;
 }
 
 OPERATE_RET tdl_camera_post_tdd_frame(TDD_CAMERA_DEV_HANDLE_T tdd_hdl, TDD_CAMERA_FRAME_T *frame)
 {
-    CAMERA_MSG_T msg;
-    QUEUE_HANDLE queue;
     CAMERA_DEVICE_T *camera_dev = NULL;
+    CAMERA_FRAME_NODE_T *pnode = NULL;
+    CAMERA_SUB_T *sub = NULL;
+    struct tuya_list_head *pos = NULL;
+    bool is_encoded;
 
     if(NULL == frame || NULL == tdd_hdl) {
         return OPRT_INVALID_PARM;
@@ -427,20 +654,30 @@ OPERATE_RET tdl_camera_post_tdd_frame(TDD_CAMERA_DEV_HANDLE_T tdd_hdl, TDD_CAMER
         return OPRT_INVALID_PARM;
     }
 
-    queue = (false == __is_camera_frame_encoded(frame->frame.fmt)) ? \
-                sg_camera_manage.raw_frame_queue : sg_camera_manage.encoded_frame_queue;
-    if(NULL == queue) {
-        PR_ERR("queue is null");
-        return OPRT_COM_ERROR;
-    }
-
     camera_dev = __find_camera_device_from_tdd(tdd_hdl);
     if (NULL == camera_dev) {
         return OPRT_COM_ERROR;
     }
 
-    msg.tdd_frame = frame;
-    msg.dev       = camera_dev;
+    pnode = (CAMERA_FRAME_NODE_T *)frame->sys_param;
+    pnode->post_ms = tal_system_get_millisecond();
+    is_encoded = __is_camera_frame_encoded(frame->frame.fmt);
+
+    // every subscriber takes a reference, then the one of the driver is dropped
+    TAL_ENTER_CRITICAL();
+    if (is_encoded) {
+        camera_dev->stats.encoded_posted++;
+    } else {
+        camera_dev->stats.raw_posted++;
+    }
+    tuya_list_for_each(pos, &camera_dev->sub_list) {
+        sub = tuya_list_entry(pos, CAMERA_SUB_T, node);
+        if (sub->is_encoded == is_encoded && __camera_sub_push(sub, pnode)) {
+            tal_semaphore_post(sub->sem);
+        }
+    }
+    __camera_frame_put(pnode);
+    TAL_EXIT_CRITICAL();
 
-    return tal_queue_post(queue, &msg, 0);
-}
\ No newline at end of file
+    return OPRT_OK;
+}
@@ -29,6 +29,15 @@
 ***********************************************************/
 #define TDL_DISP_DRAW_BUF_ALIGN 4
 
+// bytes of frame buffers in internal RAM / PSRAM the displays may hold, 0: not limited
+#ifndef TDL_DISP_FB_SRAM_MEM_BUDGET
+#define TDL_DISP_FB_SRAM_MEM_BUDGET 0
+#endif
+
+#ifndef TDL_DISP_FB_PSRAM_MEM_BUDGET
+#define TDL_DISP_FB_PSRAM_MEM_BUDGET 0
+#endif
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -56,6 +65,10 @@ typedef struct {
 ***********************variable define**********************
 ***********************************************************/
 static struct tuya_list_head sg_display_list = LIST_HEAD_INIT(sg_display_list);
+static TAL_MEM_BUDGET_DEFINE(sg_disp_fb_sram_budget, "disp_fb_sram", TDL_DISP_FB_SRAM_MEM_BUDGET, TAL_MEM_PLACE_SRAM,
+                              TAL_MEM_BUDGET_STRICT);
+static TAL_MEM_BUDGET_DEFINE(sg_disp_fb_psram_budget, "disp_fb_psram", TDL_DISP_FB_PSRAM_MEM_BUDGET,
+                              TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
 
 /***********************************************************
 ***********************function define**********************
@@ -381,12 +394,12 @@ TDL_DISP_FRAME_BUFF_T *tdl_disp_create_frame_buff(DISP_FB_RAM_TP_E type, uint32_
 
 #if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
     if (type == DISP_FB_TP_SRAM) {
-        fb = tkl_system_malloc(size);
+        fb = tal_mem_budget_malloc(&sg_disp_fb_sram_budget, size);
     } else {
-        fb = tkl_system_psram_malloc(size);
+        fb = tal_mem_budget_malloc(&sg_disp_fb_psram_budget, size);
     }
 #else
-    fb = tkl_system_malloc(size);
+    fb = tal_mem_budget_malloc(&sg_disp_fb_sram_budget, size);
     fb_type = DISP_FB_TP_SRAM;
 #endif
 
@@ -419,17 +432,7 @@ TDL_DISP_FRAME_BUFF_T *tdl_disp_create_frame_buff(DISP_FB_RAM_TP_E type, uint32_
  */
 void tdl_disp_free_frame_buff(TDL_DISP_FRAME_BUFF_T *frame_buff)
 {
-    if (frame_buff) {
-        if (frame_buff->type == DISP_FB_TP_SRAM) {
-            tkl_system_free(frame_buff);
-        } else {
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-            tkl_system_psram_free(frame_buff);
-#else
-            tkl_system_free(frame_buff);
-#endif
-        }
-    }
+    tal_mem_budget_free(frame_buff);
 }
 
 /**
@@ -0,0 +1,121 @@
+/**
+ * @file tdl_ir_decoder.h
+ * @brief Streaming infrared decoder driven by protocol timing tables.
+ *
+ * The decoder takes the receiver output one edge at a time, as the duration
+ * of the level that just ended, the first one a mark (carrier on). Every
+ * enabled protocol runs its own small state machine over the same edges and
+ * a code is returned by the call that delivers its last bit, without waiting
+ * for the receiver to go idle. Protocols are described by timing tables:
+ * - pulse distance (NEC, with repeat frames);
+ * - pulse width (Sony SIRC);
+ * - bi-phase (RC5, RC6 mode 0);
+ * - learned codes, matched duration by duration against recorded timecodes.
+ *
+ * tdl_ir_decoder_feed() does no allocation, locking or logging, so it can be
+ * called from the receive interrupt.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TDL_IR_DECODER_H__
+#define __TDL_IR_DECODER_H__
+
+#include "tuya_cloud_types.h"
+
+#include "tdl_ir_dev_manage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define IR_PROT_BIT(prot)           (1u << (prot))
+#define IR_DECODE_PROT_ALL          (IR_PROT_BIT(IR_PROT_NEC) | IR_PROT_BIT(IR_PROT_RC5) | IR_PROT_BIT(IR_PROT_RC6) | \
+                                     IR_PROT_BIT(IR_PROT_SIRC) | IR_PROT_BIT(IR_PROT_LEARN))
+
+#define IR_DECODE_TOLERANCE_DEF     (25) // percent
+#define IR_DECODE_LEARN_MAX         (8)
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef void *IR_DECODER_HANDLE_T;
+
+typedef struct {
+    uint32_t prot_mask;  // IR_PROT_BIT() of the protocols to decode
+    uint8_t  tolerance;  // timing error percent, 0: IR_DECODE_TOLERANCE_DEF
+    uint8_t  sirc_bits;  // 12, 15 or 20, 0: 12
+    uint8_t  is_nec_msb; // 1: msb, 0: lsb
+} IR_DECODER_CFG_T;
+
+/***********************************************************
+********************function declaration********************
+***********************************************************/
+
+/**
+ * @brief Create a decoder, need to call tdl_ir_decoder_release to release it
+ *
+ * @param[in] cfg: decoder config
+ * @param[out] handle: decoder handle
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET tdl_ir_decoder_create(IR_DECODER_CFG_T *cfg, IR_DECODER_HANDLE_T *handle);
+
+/**
+ * @brief Release a decoder and its learned codes
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_release(IR_DECODER_HANDLE_T handle);
+
+/**
+ * @brief Start a new reception: the next edge is a mark and repeats are counted from zero
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_reset(IR_DECODER_HANDLE_T handle);
+
+/**
+ * @brief Decode one edge
+ *
+ * @param[in] handle: decoder handle
+ * @param[in] duration_us: duration of the level that just ended
+ * @param[out] code: the code completed by this edge
+ *
+ * @return 1 when this edge completes a code or a repeat, 0 otherwise
+ */
+uint8_t tdl_ir_decoder_feed(IR_DECODER_HANDLE_T handle, uint32_t duration_us, IR_DATA_CODE_T *code);
+
+/**
+ * @brief Add a learned code, reported with prot IR_PROT_LEARN and cmd = the order it was added in
+ *
+ * @param[in] handle: decoder handle
+ * @param[in] timecode: recorded durations, the first one a mark, a trailing space is ignored
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET tdl_ir_decoder_learn_add(IR_DECODER_HANDLE_T handle, IR_DATA_TIMECODE_T *timecode);
+
+/**
+ * @brief Remove all learned codes
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_learn_clean(IR_DECODER_HANDLE_T handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TDL_IR_DECODER_H__ */
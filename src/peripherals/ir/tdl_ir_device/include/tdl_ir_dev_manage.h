@@ -4,12 +4,14 @@
  *
  * This file provides comprehensive device management functionality for infrared
  * communication within the Tuya IoT ecosystem. It implements a complete infrared
- * device management system that supports multiple IR protocols (NEC, timecode),
- * device registration, and both synchronous and asynchronous communication modes.
+ * device management system that supports multiple IR protocols (NEC, RC5, RC6,
+ * SIRC, learned codes, timecode), device registration, and both synchronous and
+ * asynchronous communication modes.
  *
  * Key functionalities provided:
  * - IR device discovery, registration, and lifecycle management
- * - Support for multiple IR protocols (NEC protocol, raw timecode)
+ * - Support for multiple IR protocols (NEC, RC5, RC6, Sony SIRC, learned codes,
+ *   raw timecode), decoded edge by edge as the frame arrives
  * - Bidirectional IR communication (transmit and receive)
  * - Protocol-specific configuration and error handling
  * - Queue-based data management for IR receive operations
@@ -44,7 +46,12 @@ extern "C" {
 typedef uint8_t IR_PROT_E;
 #define IR_PROT_TIMECODE            0
 #define IR_PROT_NEC                 1
-#define IR_PROT_MAX                 2
+#define IR_PROT_RC5                 2 // receive only
+#define IR_PROT_RC6                 3 // receive only, mode 0
+#define IR_PROT_SIRC                4 // receive only, Sony 12, 15 or 20 bits
+#define IR_PROT_LEARN               5 // receive only, matches the codes added with IR_CMD_RECV_LEARN_ADD
+#define IR_PROT_AUTO                6 // receive only, any of NEC, RC5, RC6, SIRC and the learned codes
+#define IR_PROT_MAX                 7
 
 typedef unsigned char IR_SEND_STATUS;
 #define IR_STA_SEND_IDLE            0
@@ -74,6 +81,8 @@ typedef unsigned char IR_CMD_E;
 #define IR_CMD_RECV_CB_REGISTER     9
 #define IR_CMD_CODE_INTER_DELAY_SET 10 // Set the delay between continuous transmission of infrared code, unit: (uint32_t) us
 #define IR_CMD_RECV_TASK_STACK_SET  11 // Set the stack size of the infrared receive task
+#define IR_CMD_RECV_LEARN_ADD       12 // Add a learned code, (IR_DATA_TIMECODE_T *), it is reported with cmd = the order it was added in
+#define IR_CMD_RECV_LEARN_CLEAN     13 // Remove all learned codes
 
 /***********************************************************
 ***********************typedef define***********************
@@ -93,9 +102,17 @@ typedef struct {
     uint8_t repeat_err;
 } IR_NEC_CFG_T;
 
+/* rc5, rc6, sirc, learn and auto protocol config struct */
+typedef struct {
+    uint8_t tolerance; // timing error percent, 0: 25
+    uint8_t sirc_bits; // 12, 15 or 20, 0: 12
+    uint8_t is_nec_msb; // auto only, 1: msb, 0: lsb
+} IR_DECODE_CFG_T;
+
 /* ir protocol config union */
 typedef union {
     IR_NEC_CFG_T nec_cfg;
+    IR_DECODE_CFG_T decode_cfg;
 } IR_PROT_CFG_U;
 
 /* ir nec protocol data struct */
@@ -113,10 +130,22 @@ typedef struct {
     uint32_t *data;
 } IR_DATA_TIMECODE_T;
 
+/* ir decoded code struct, the data of rc5, rc6, sirc, learn and auto devices */
+typedef struct {
+    IR_PROT_E prot;
+    uint8_t bits; // payload bits
+    uint8_t toggle; // rc5, rc6 toggle bit
+    uint16_t addr; // nec: first two bytes, sirc: 5, 8 or 13 bits
+    uint16_t cmd; // nec: last two bytes, rc5: 7 bits with the field bit, learn: code index
+    uint16_t repeat_cnt;
+    uint32_t raw; // payload bits as received, the first one highest
+} IR_DATA_CODE_T;
+
 /* ir data union */
 typedef union {
     IR_DATA_NEC_T nec_data;
     IR_DATA_TIMECODE_T timecode;
+    IR_DATA_CODE_T code;
 } IR_DATA_U;
 
 /* ir device config struct */
@@ -131,6 +160,14 @@ typedef struct {
     IR_PROT_CFG_U prot_cfg;
 } IR_DEV_CFG_T;
 
+/**
+ * Decoding devices (every protocol but timecode) report a code as soon as the
+ * last bit of its frame arrives, with is_frame_finish = 0, then each repeat
+ * with the running repeat_cnt, and the last code again with is_frame_finish
+ * = 1 once the receiver is idle. Without a callback every code and repeat is
+ * posted to the receive queue as it arrives. Timecode devices report the
+ * whole capture once the receiver is idle.
+ */
 typedef void (*IR_APP_RECV_CB)(uint8_t is_frame_finish, IR_DATA_U *recv_data);
 
 /***********************************************************
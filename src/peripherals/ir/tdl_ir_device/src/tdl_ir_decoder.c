@@ -0,0 +1,631 @@
+/**
+ * @file tdl_ir_decoder.c
+ * @brief Streaming infrared decoder driven by protocol timing tables.
+ *
+ * Each protocol of sg_ir_prot_timing is decoded by the same state machine,
+ * parameterised by its coding:
+ * - pulse distance: a fixed mark, the following space gives the bit (NEC);
+ * - pulse width: the mark gives the bit, a fixed space follows (SIRC);
+ * - bi-phase: every bit is two half bits of opposite levels, their order
+ *   gives the bit, and an edge may carry one or two half bits (RC5, RC6).
+ *
+ * A bi-phase bit is known from its first half, so RC5 and RC6 codes are also
+ * returned at their last edge, even when the second half of the last bit
+ * merges into the idle level. Learned codes are matched duration by duration
+ * against the recorded timecode, any number of them in parallel.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tal_memory.h"
+#include "tal_system.h"
+
+#include "tdl_ir_decoder.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define IR_DEC_FRAME_GAP_US         (15000) // a longer space ends any frame
+#define IR_DEC_DURATION_MAX         (0xFFFFFF)
+#define IR_DEC_PROT_NUM             (4)
+#define IR_DEC_NO_BIT               (0xFF)
+#define IR_DEC_SIRC_BITS_DEF        (12)
+
+/* how a protocol carries its bits */
+#define IR_CODING_PULSE_DISTANCE    0
+#define IR_CODING_PULSE_WIDTH       1
+#define IR_CODING_BIPHASE           2
+
+/* decode state */
+#define IR_DEC_IDLE                 0
+#define IR_DEC_HDR_SPACE            1
+#define IR_DEC_BIT_MARK             2
+#define IR_DEC_BIT_SPACE            3
+#define IR_DEC_BIPHASE              4
+#define IR_DEC_STOP                 5 // the edge after the last bit is part of the frame
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    IR_PROT_E   prot;
+    uint8_t     coding;
+    uint8_t     bits;           // 0: IR_DECODER_CFG_T sirc_bits
+    uint8_t     wide_bit;       // bi-phase bit with double width halves, IR_DEC_NO_BIT: none
+    uint8_t     one_mark_first; // bi-phase: a 1 starts with the mark half
+    uint16_t    unit_us;        // bi-phase half bit
+    uint16_t    hdr_mark_us;    // 0: no header
+    uint16_t    hdr_space_us;
+    uint16_t    rpt_space_us;   // header mark then this space is a repeat frame, 0: none
+    uint16_t    zero_mark_us;
+    uint16_t    zero_space_us;
+    uint16_t    one_mark_us;
+    uint16_t    one_space_us;
+} IR_PROT_TIMING_T;
+
+typedef struct {
+    const IR_PROT_TIMING_T  *timing;
+    uint8_t                 bits;
+    uint8_t                 state;
+    uint8_t                 bit_cnt;
+    uint8_t                 half;       // bi-phase: the second half of the bit is due
+    uint8_t                 first_mark; // bi-phase: the first half of the bit was a mark
+    uint32_t                data;
+} IR_DEC_PROT_T;
+
+typedef struct {
+    uint32_t                *data;
+    uint16_t                len;        // durations to match, the last one a mark
+    uint16_t                idx;
+} IR_DEC_LEARN_T;
+
+typedef struct {
+    uint8_t                 tolerance;
+    uint8_t                 is_nec_msb;
+    uint8_t                 is_mark;    // level of the next edge
+    uint8_t                 prot_num;
+    IR_DEC_PROT_T           prot[IR_DEC_PROT_NUM];
+
+    uint8_t                 learn_en;
+    volatile uint8_t        learn_num;
+    IR_DEC_LEARN_T          learn[IR_DECODE_LEARN_MAX];
+
+    uint8_t                 has_last;
+    IR_DATA_CODE_T          last;
+} IR_DECODER_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static const IR_PROT_TIMING_T sg_ir_prot_timing[IR_DEC_PROT_NUM] = {
+    /* prot         coding                    bits wide_bit       1 mark first  unit  hdr mark/space rpt   0 mark/space 1 mark/space */
+    {IR_PROT_NEC,  IR_CODING_PULSE_DISTANCE, 32,  IR_DEC_NO_BIT,  0,            0,    9000, 4500,    2250, 560,  560,   560,  1690},
+    {IR_PROT_RC5,  IR_CODING_BIPHASE,        14,  IR_DEC_NO_BIT,  0,            889,  0,    0,       0,    0,    0,     0,    0},
+    /* start, 3 mode bits, toggle (the trailer bit, double width), 8 address and 8 command bits */
+    {IR_PROT_RC6,  IR_CODING_BIPHASE,        21,  4,              1,            444,  2666, 889,     0,    0,    0,     0,    0},
+    {IR_PROT_SIRC, IR_CODING_PULSE_WIDTH,    0,   IR_DEC_NO_BIT,  0,            0,    2400, 600,     0,    600,  600,   1200, 600},
+};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static inline uint8_t __ir_dec_match(IR_DECODER_T *dec, uint32_t duration, uint32_t ref_us)
+{
+    uint32_t err = ref_us * dec->tolerance / 100;
+
+    return (duration + err >= ref_us && duration <= ref_us + err) ? 1 : 0;
+}
+
+static uint32_t __ir_dec_reverse(uint32_t data, uint8_t bits)
+{
+    uint32_t value = 0;
+
+    while (bits--) {
+        value = (value << 1) | (data & 1);
+        data >>= 1;
+    }
+
+    return value;
+}
+
+/**
+ * @brief return a code, counting it as a repeat when the previous code had the same bits
+ *
+ * @param[in] dec: decoder
+ * @param[inout] code: the code
+ *
+ * @return 1
+ */
+static uint8_t __ir_dec_emit(IR_DECODER_T *dec, IR_DATA_CODE_T *code)
+{
+    if (dec->has_last && dec->last.prot == code->prot && dec->last.raw == code->raw) {
+        code->repeat_cnt = dec->last.repeat_cnt + 1;
+    }
+
+    dec->last = *code;
+    dec->has_last = 1;
+
+    return 1;
+}
+
+static uint8_t __ir_dec_frame(IR_DECODER_T *dec, IR_DEC_PROT_T *p, IR_DATA_CODE_T *code)
+{
+    uint32_t data = p->data;
+    uint8_t byte[4], i;
+
+    memset(code, 0, SIZEOF(IR_DATA_CODE_T));
+    code->prot = p->timing->prot;
+    code->bits = p->bits;
+    code->raw = data;
+
+    switch (code->prot) {
+    case IR_PROT_NEC:
+        for (i = 0; i < 4; i++) {
+            byte[i] = (data >> (24 - 8 * i)) & 0xFF;
+            if (!dec->is_nec_msb) {
+                byte[i] = __ir_dec_reverse(byte[i], 8);
+            }
+        }
+        code->addr = byte[0] << 8 | byte[1];
+        code->cmd = byte[2] << 8 | byte[3];
+        break;
+
+    case IR_PROT_RC5:
+        /* S1 S2 T A4..A0 C5..C0, the inverted S2 is command bit 6 (RC5X) */
+        code->toggle = (data >> 11) & 0x01;
+        code->addr = (data >> 6) & 0x1F;
+        code->cmd = (data & 0x3F) | ((~data >> 6) & 0x40);
+        break;
+
+    case IR_PROT_RC6:
+        /* only mode 0 has 16 payload bits */
+        if (0x01 != (data >> 20) || 0 != ((data >> 17) & 0x07)) {
+            return 0;
+        }
+        code->toggle = (data >> 16) & 0x01;
+        code->addr = (data >> 8) & 0xFF;
+        code->cmd = data & 0xFF;
+        break;
+
+    case IR_PROT_SIRC:
+        /* lsb first, 7 command bits then the address */
+        data = __ir_dec_reverse(data, p->bits);
+        code->cmd = data & 0x7F;
+        code->addr = data >> 7;
+        break;
+
+    default:
+        return 0;
+    }
+
+    return __ir_dec_emit(dec, code);
+}
+
+static uint8_t __ir_dec_repeat(IR_DECODER_T *dec, IR_DEC_PROT_T *p, IR_DATA_CODE_T *code)
+{
+    /* a repeat frame without the code it repeats is ignored */
+    if (!dec->has_last || dec->last.prot != p->timing->prot) {
+        return 0;
+    }
+
+    dec->last.repeat_cnt++;
+    *code = dec->last;
+
+    return 1;
+}
+
+static uint8_t __ir_dec_bit(IR_DECODER_T *dec, IR_DEC_PROT_T *p, uint8_t bit, uint8_t next_state, IR_DATA_CODE_T *code)
+{
+    p->data = (p->data << 1) | bit;
+
+    if (++p->bit_cnt == p->bits) {
+        p->state = IR_DEC_STOP;
+        return __ir_dec_frame(dec, p, code);
+    }
+
+    p->state = next_state;
+
+    return 0;
+}
+
+static uint8_t __ir_dec_biphase(IR_DECODER_T *dec, IR_DEC_PROT_T *p, uint8_t is_mark, uint32_t duration, IR_DATA_CODE_T *code)
+{
+    const IR_PROT_TIMING_T *t = p->timing;
+    /* an edge may carry the distortion of two half bits, allow twice the tolerance */
+    uint32_t err = t->unit_us * dec->tolerance / 50;
+    uint32_t units = (duration + t->unit_us / 2) / t->unit_us;
+    uint8_t width = 0;
+
+    if (0 == units || units > 4 || duration + err < units * t->unit_us || duration > units * t->unit_us + err) {
+        p->state = IR_DEC_IDLE;
+        return 0;
+    }
+
+    /* one edge is one or two half bits of the same level */
+    while (units) {
+        width = (p->bit_cnt - p->half == t->wide_bit) ? 2 : 1;
+        if (units < width) {
+            p->state = IR_DEC_IDLE;
+            return 0;
+        }
+        units -= width;
+
+        if (0 == p->half) {
+            p->first_mark = is_mark;
+            p->data = (p->data << 1) | (is_mark == t->one_mark_first);
+            p->half = 1;
+            if (++p->bit_cnt == p->bits) {
+                p->state = IR_DEC_STOP;
+                return __ir_dec_frame(dec, p, code);
+            }
+        } else {
+            if (is_mark == p->first_mark) {
+                p->state = IR_DEC_IDLE;
+                return 0;
+            }
+            p->half = 0;
+        }
+    }
+
+    return 0;
+}
+
+static void __ir_dec_start(IR_DEC_PROT_T *p)
+{
+    p->bit_cnt = 0;
+    p->half = 0;
+    p->data = 0;
+    p->state = (IR_CODING_BIPHASE == p->timing->coding) ? IR_DEC_BIPHASE : IR_DEC_BIT_MARK;
+}
+
+static void __ir_dec_idle(IR_DECODER_T *dec, IR_DEC_PROT_T *p, uint8_t is_mark, uint32_t duration, IR_DATA_CODE_T *code)
+{
+    const IR_PROT_TIMING_T *t = p->timing;
+
+    p->state = IR_DEC_IDLE;
+    if (!is_mark) {
+        return;
+    }
+
+    if (t->hdr_mark_us) {
+        if (__ir_dec_match(dec, duration, t->hdr_mark_us)) {
+            p->state = IR_DEC_HDR_SPACE;
+        }
+        return;
+    }
+
+    /* no header (RC5): the first half bit is a space, hidden in the idle level */
+    __ir_dec_start(p);
+    p->first_mark = 0;
+    p->data = (0 == t->one_mark_first);
+    p->bit_cnt = 1;
+    p->half = 1;
+    __ir_dec_biphase(dec, p, is_mark, duration, code);
+}
+
+static uint8_t __ir_dec_prot_feed(IR_DECODER_T *dec, IR_DEC_PROT_T *p, uint8_t is_mark, uint32_t duration, IR_DATA_CODE_T *code)
+{
+    const IR_PROT_TIMING_T *t = p->timing;
+    uint8_t ret = 0;
+
+    switch (p->state) {
+    case IR_DEC_HDR_SPACE:
+        if (is_mark) {
+            break;
+        }
+        if (__ir_dec_match(dec, duration, t->hdr_space_us)) {
+            __ir_dec_start(p);
+            return 0;
+        }
+        if (t->rpt_space_us && __ir_dec_match(dec, duration, t->rpt_space_us)) {
+            p->state = IR_DEC_STOP;
+            return __ir_dec_repeat(dec, p, code);
+        }
+        break;
+
+    case IR_DEC_BIT_MARK:
+        if (!is_mark) {
+            break;
+        }
+        if (IR_CODING_PULSE_DISTANCE == t->coding) {
+            if (__ir_dec_match(dec, duration, t->zero_mark_us)) {
+                p->state = IR_DEC_BIT_SPACE;
+                return 0;
+            }
+        } else if (__ir_dec_match(dec, duration, t->one_mark_us)) {
+            return __ir_dec_bit(dec, p, 1, IR_DEC_BIT_SPACE, code);
+        } else if (__ir_dec_match(dec, duration, t->zero_mark_us)) {
+            return __ir_dec_bit(dec, p, 0, IR_DEC_BIT_SPACE, code);
+        }
+        break;
+
+    case IR_DEC_BIT_SPACE:
+        if (is_mark) {
+            break;
+        }
+        if (IR_CODING_PULSE_WIDTH == t->coding) {
+            if (__ir_dec_match(dec, duration, t->zero_space_us)) {
+                p->state = IR_DEC_BIT_MARK;
+                return 0;
+            }
+        } else if (__ir_dec_match(dec, duration, t->one_space_us)) {
+            return __ir_dec_bit(dec, p, 1, IR_DEC_BIT_MARK, code);
+        } else if (__ir_dec_match(dec, duration, t->zero_space_us)) {
+            return __ir_dec_bit(dec, p, 0, IR_DEC_BIT_MARK, code);
+        }
+        break;
+
+    case IR_DEC_BIPHASE:
+        ret = __ir_dec_biphase(dec, p, is_mark, duration, code);
+        if (IR_DEC_IDLE != p->state || 0 == t->hdr_mark_us) {
+            return ret;
+        }
+        break;
+
+    case IR_DEC_STOP:
+        p->state = IR_DEC_IDLE;
+        return 0;
+
+    default:
+        break;
+    }
+
+    /* idle, or the edge does not fit the frame: it may start a new one */
+    __ir_dec_idle(dec, p, is_mark, duration, code);
+
+    return 0;
+}
+
+static uint8_t __ir_dec_learn_feed(IR_DECODER_T *dec, uint8_t is_mark, uint32_t duration, IR_DATA_CODE_T *code)
+{
+    IR_DEC_LEARN_T *learn = NULL;
+    uint8_t i, ret = 0;
+
+    for (i = 0; i < dec->learn_num; i++) {
+        learn = &dec->learn[i];
+
+        if (learn->idx && __ir_dec_match(dec, duration, learn->data[learn->idx])) {
+            learn->idx++;
+        } else {
+            learn->idx = (is_mark && __ir_dec_match(dec, duration, learn->data[0])) ? 1 : 0;
+        }
+
+        if (learn->idx >= learn->len) {
+            learn->idx = 0;
+            if (0 == ret) {
+                memset(code, 0, SIZEOF(IR_DATA_CODE_T));
+                code->prot = IR_PROT_LEARN;
+                code->cmd = i;
+                code->raw = i;
+                ret = __ir_dec_emit(dec, code);
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Create a decoder, need to call tdl_ir_decoder_release to release it
+ *
+ * @param[in] cfg: decoder config
+ * @param[out] handle: decoder handle
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET tdl_ir_decoder_create(IR_DECODER_CFG_T *cfg, IR_DECODER_HANDLE_T *handle)
+{
+    IR_DECODER_T *dec = NULL;
+    IR_DEC_PROT_T *p = NULL;
+    uint8_t i;
+
+    if (NULL == cfg || NULL == handle || 0 == (cfg->prot_mask & IR_DECODE_PROT_ALL) || cfg->tolerance >= 100) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (cfg->sirc_bits && 12 != cfg->sirc_bits && 15 != cfg->sirc_bits && 20 != cfg->sirc_bits) {
+        return OPRT_INVALID_PARM;
+    }
+
+    dec = (IR_DECODER_T *)tal_malloc(SIZEOF(IR_DECODER_T));
+    if (NULL == dec) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(dec, 0, SIZEOF(IR_DECODER_T));
+
+    dec->tolerance = cfg->tolerance ? cfg->tolerance : IR_DECODE_TOLERANCE_DEF;
+    dec->is_nec_msb = cfg->is_nec_msb;
+    dec->learn_en = (cfg->prot_mask & IR_PROT_BIT(IR_PROT_LEARN)) ? 1 : 0;
+
+    for (i = 0; i < IR_DEC_PROT_NUM; i++) {
+        if (0 == (cfg->prot_mask & IR_PROT_BIT(sg_ir_prot_timing[i].prot))) {
+            continue;
+        }
+        p = &dec->prot[dec->prot_num++];
+        p->timing = &sg_ir_prot_timing[i];
+        p->bits = sg_ir_prot_timing[i].bits;
+        if (0 == p->bits) {
+            p->bits = cfg->sirc_bits ? cfg->sirc_bits : IR_DEC_SIRC_BITS_DEF;
+        }
+    }
+
+    tdl_ir_decoder_reset(dec);
+    *handle = (IR_DECODER_HANDLE_T)dec;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Release a decoder and its learned codes
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_release(IR_DECODER_HANDLE_T handle)
+{
+    if (NULL == handle) {
+        return;
+    }
+
+    tdl_ir_decoder_learn_clean(handle);
+    tal_free(handle);
+
+    return;
+}
+
+/**
+ * @brief Start a new reception: the next edge is a mark and repeats are counted from zero
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_reset(IR_DECODER_HANDLE_T handle)
+{
+    IR_DECODER_T *dec = (IR_DECODER_T *)handle;
+    uint8_t i;
+
+    if (NULL == dec) {
+        return;
+    }
+
+    dec->is_mark = 1;
+    dec->has_last = 0;
+    for (i = 0; i < dec->prot_num; i++) {
+        dec->prot[i].state = IR_DEC_IDLE;
+    }
+    for (i = 0; i < dec->learn_num; i++) {
+        dec->learn[i].idx = 0;
+    }
+
+    return;
+}
+
+/**
+ * @brief Decode one edge
+ *
+ * @param[in] handle: decoder handle
+ * @param[in] duration_us: duration of the level that just ended
+ * @param[out] code: the code completed by this edge
+ *
+ * @return 1 when this edge completes a code or a repeat, 0 otherwise
+ */
+uint8_t tdl_ir_decoder_feed(IR_DECODER_HANDLE_T handle, uint32_t duration_us, IR_DATA_CODE_T *code)
+{
+    IR_DECODER_T *dec = (IR_DECODER_T *)handle;
+    IR_DATA_CODE_T spare;
+    uint8_t is_mark, i, ret = 0;
+
+    if (NULL == dec || NULL == code) {
+        return 0;
+    }
+
+    is_mark = dec->is_mark;
+    dec->is_mark = !is_mark;
+
+    if (duration_us > IR_DEC_DURATION_MAX) {
+        duration_us = IR_DEC_DURATION_MAX;
+    }
+
+    /* learned codes may hold long spaces, they see every edge */
+    if (dec->learn_num) {
+        ret = __ir_dec_learn_feed(dec, is_mark, duration_us, code);
+    }
+
+    if (!is_mark && duration_us > IR_DEC_FRAME_GAP_US) {
+        for (i = 0; i < dec->prot_num; i++) {
+            dec->prot[i].state = IR_DEC_IDLE;
+        }
+        return ret;
+    }
+
+    for (i = 0; i < dec->prot_num; i++) {
+        if (__ir_dec_prot_feed(dec, &dec->prot[i], is_mark, duration_us, ret ? &spare : code)) {
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Add a learned code, reported with prot IR_PROT_LEARN and cmd = the order it was added in
+ *
+ * @param[in] handle: decoder handle
+ * @param[in] timecode: recorded durations, the first one a mark, a trailing space is ignored
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET tdl_ir_decoder_learn_add(IR_DECODER_HANDLE_T handle, IR_DATA_TIMECODE_T *timecode)
+{
+    IR_DECODER_T *dec = (IR_DECODER_T *)handle;
+    IR_DEC_LEARN_T *learn = NULL;
+    uint16_t len, i;
+
+    if (NULL == dec || NULL == timecode || NULL == timecode->data || timecode->len < 2) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (0 == dec->learn_en) {
+        return OPRT_NOT_SUPPORTED;
+    }
+
+    if (dec->learn_num >= IR_DECODE_LEARN_MAX) {
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+
+    /* an odd count ends with a mark */
+    len = timecode->len | 1;
+    if (len > timecode->len) {
+        len -= 2;
+    }
+
+    learn = &dec->learn[dec->learn_num];
+    learn->data = (uint32_t *)tal_malloc(len * SIZEOF(uint32_t));
+    if (NULL == learn->data) {
+        return OPRT_MALLOC_FAILED;
+    }
+    for (i = 0; i < len; i++) {
+        learn->data[i] = (timecode->data[i] > IR_DEC_DURATION_MAX) ? IR_DEC_DURATION_MAX : timecode->data[i];
+    }
+    learn->len = len;
+    learn->idx = 0;
+
+    /* the receive interrupt sees the code once it is complete */
+    dec->learn_num++;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Remove all learned codes
+ *
+ * @param[in] handle: decoder handle
+ *
+ * @return none
+ */
+void tdl_ir_decoder_learn_clean(IR_DECODER_HANDLE_T handle)
+{
+    IR_DECODER_T *dec = (IR_DECODER_T *)handle;
+    uint8_t learn_num, i;
+
+    if (NULL == dec) {
+        return;
+    }
+
+    TAL_ENTER_CRITICAL();
+    learn_num = dec->learn_num;
+    dec->learn_num = 0;
+    TAL_EXIT_CRITICAL();
+
+    for (i = 0; i < learn_num; i++) {
+        tal_free(dec->learn[i].data);
+        dec->learn[i].data = NULL;
+    }
+
+    return;
+}
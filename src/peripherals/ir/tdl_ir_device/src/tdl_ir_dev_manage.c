@@ -10,7 +10,8 @@
  *
  * Key implementation features:
  * - Device registration and discovery management with linked list storage
- * - Multi-protocol support (NEC protocol and raw timecode transmission)
+ * - Multi-protocol support (NEC, RC5, RC6, SIRC and learned codes decoded edge
+ *   by edge as they arrive, raw timecode transmission)
  * - Ring buffer implementation for efficient IR data reception
  * - Asynchronous data processing with queue-based messaging
  * - Thread-safe operations with proper synchronization mechanisms
@@ -41,6 +42,7 @@
 
 #include "tdl_ir_dev_manage.h"
 #include "tdl_nec_protocol.h"
+#include "tdl_ir_decoder.h"
 
 /***********************************************************
 ************************macro define************************
@@ -49,11 +51,11 @@
 #define IR_SEND_INTER_DELAY_US   (300 * 1000) // unit: us, default: 300ms
 
 #define IR_RECV_TIMEOUT_MS      300
-#define OVERFLOW_TIME_MS        (0xffffffffUL)
 #define IR_RECV_POST_TIMEOUT_MS (3*1000)
 #define IR_RECV_VALID_LEN_MIN   20
 
 #define IR_DEVICE_NUM_MAX       5
+#define IR_RECV_CODE_NUM        8 // codes decoded in the interrupt, waiting for the receive task
 
 #ifndef QUEUE_WAIT_FOREVER
 #define QUEUE_WAIT_FOREVER      0xFFFFFFFF
@@ -85,15 +87,19 @@ typedef struct {
     IR_RING_BUF_T           *ring_buf;
 
     volatile uint32_t       last_time; /* tdl last receive data time, unit: ms */
-    void                    *recv_err_val;
     QUEUE_HANDLE            recv_queue_hdl;
     IR_APP_RECV_CB          app_recv_cb;
 
-    // NEC sync parser
-    volatile uint16_t                addr;
-    volatile uint16_t                cmd;
-    volatile uint16_t                repeat_cnt;
-    volatile uint16_t                have_data;
+    /* edge decoder, fed by the receive interrupt */
+    IR_DECODER_HANDLE_T     decoder;
+    SEM_HANDLE              recv_sem_hdl;
+    IR_DATA_CODE_T          code_buf[IR_RECV_CODE_NUM];
+    volatile uint8_t        code_wr;
+    volatile uint8_t        code_rd;
+
+    /* last code reported in this reception */
+    uint8_t                 have_data;
+    IR_DATA_U               last_data;
 }IR_DEV_RECV_T;
 
 typedef struct ir_dev_node {
@@ -157,6 +163,7 @@ static uint8_t sg_cpu_lp_dis_flag = 0;
 
 static OPERATE_RET __tdl_ir_recv_init(IR_DEV_NODE_T *ir_device);
 static OPERATE_RET __tdl_ir_recv_deinit(IR_DEV_NODE_T *ir_device);
+static void __tdl_ir_recv_code_deliver(IR_DEV_NODE_T *dev_info);
 
 /**
  * @brief ring buffer init
@@ -528,6 +535,34 @@ static int __tdl_ir_output_finish_cb(void *args)
     return op_ret;
 }
 
+/**
+ * @brief decode one edge in the receive interrupt, wake the receive task on a code
+ *
+ * @param[in] dev_info: device node
+ * @param[in] duration_us: duration of the level that just ended
+ *
+ * @return none
+ */
+static void __tdl_ir_recv_decode(IR_DEV_NODE_T *dev_info, uint32_t duration_us)
+{
+    IR_DEV_RECV_T *recv = &dev_info->recv_info;
+    uint8_t next = (recv->code_wr + 1) % IR_RECV_CODE_NUM;
+
+    if (0 == tdl_ir_decoder_feed(recv->decoder, duration_us, &recv->code_buf[recv->code_wr])) {
+        return;
+    }
+
+    /* the task is behind, drop the code */
+    if (next == recv->code_rd || NULL == recv->recv_sem_hdl) {
+        return;
+    }
+
+    recv->code_wr = next;
+    tal_semaphore_post(recv->recv_sem_hdl);
+
+    return;
+}
+
 /**
  * @brief ir receive callback
  *
@@ -566,6 +601,8 @@ static int __tdl_ir_recv_cb(IR_DRV_HANDLE_T drv_hdl, unsigned int raw_data, void
     }
 
     if (IR_STA_RECV_IDLE == dev_info->recv_status) {
+        /* the first edge ends the idle level, the next one is a mark */
+        tdl_ir_decoder_reset(dev_info->recv_info.decoder);
         dev_info->recv_status = IR_STA_RECVING;
         dev_info->drv_intfs->status_notif(dev_info->ir_drv_hdl, IR_DRV_PRE_RECV_STATE, NULL);
 
@@ -575,7 +612,11 @@ static int __tdl_ir_recv_cb(IR_DRV_HANDLE_T drv_hdl, unsigned int raw_data, void
         }
 
     } else if (IR_STA_RECVING == dev_info->recv_status) {
-        __tdl_ir_ring_buf_write_word(dev_info->recv_info.ring_buf, raw_data);
+        if (NULL != dev_info->recv_info.decoder) {
+            __tdl_ir_recv_decode(dev_info, raw_data);
+        } else {
+            __tdl_ir_ring_buf_write_word(dev_info->recv_info.ring_buf, raw_data);
+        }
     }
 
     return 0;
@@ -593,72 +634,23 @@ static OPERATE_RET __tdl_ir_recv_data_process(IR_DEV_NODE_T *dev_info)
     OPERATE_RET rt = OPRT_OK;
     IR_RING_BUF_T *tmp_rb = NULL;
     uint16_t data_len = 0;
-    uint32_t *tmp_buf = NULL;
-    uint16_t parser_head = 0, parser_offset = 0, parser_len = 0;
-    int ret_len = 0;
-    IR_DATA_U out_nec, *out_data = NULL;
-
+    IR_DATA_U *out_data = NULL;
 
     TUYA_CHECK_NULL_RETURN(dev_info, OPRT_INVALID_PARM);
 
     tmp_rb = dev_info->recv_info.ring_buf;
     data_len = RING_BUFFER_LENGTH_GET(tmp_rb);
 
-    if (dev_info->ir_dev_cfg.prot_opt == IR_PROT_NEC) {
+    if (NULL != dev_info->recv_info.decoder) {
+        /* the codes went out as they arrived, the last one again marks the end of the reception */
+        __tdl_ir_recv_code_deliver(dev_info);
+        if (0 == dev_info->recv_info.have_data) {
+            return OPRT_COM_ERROR;
+        }
         if (NULL != dev_info->recv_info.app_recv_cb) {
-            if (dev_info->recv_info.have_data) {
-                out_nec.nec_data.addr = dev_info->recv_info.addr;
-                out_nec.nec_data.cmd = dev_info->recv_info.cmd;
-                out_nec.nec_data.repeat_cnt = dev_info->recv_info.repeat_cnt;
-                dev_info->recv_info.app_recv_cb(1, &out_nec);
-
-                dev_info->recv_info.have_data = 0;
-                dev_info->recv_info.addr = 0;
-                dev_info->recv_info.cmd = 0;
-                dev_info->recv_info.repeat_cnt = 0;
-            } else {
-                return OPRT_COM_ERROR;
-            }
-        } else {
-            // NEC decode, post
-            tmp_buf = tal_malloc(data_len * SIZEOF(uint32_t));
-            TUYA_CHECK_NULL_RETURN(tmp_buf, OPRT_MALLOC_FAILED);
-            memset(tmp_buf, 0, data_len * SIZEOF(uint32_t));
-            __tdl_ir_ring_buf_read_no_update(tmp_rb, tmp_buf, data_len);
-            parser_offset = 0;
-            do {
-                parser_len = data_len-parser_offset;
-                rt = tdl_nec_get_frame_head((uint32_t *)&tmp_buf[parser_offset], parser_len, dev_info->recv_info.recv_err_val, &parser_head);
-                if (OPRT_OK != rt) {
-                    break;
-                }
-
-                out_data = __tdl_ir_recv_buf_malloc(IR_PROT_NEC, 0);
-                TUYA_CHECK_NULL_RETURN(out_data, OPRT_MALLOC_FAILED);
-
-                ret_len = tdl_ir_nec_parser_single(&tmp_buf[parser_head], parser_len, dev_info->recv_info.recv_err_val, \
-                                        dev_info->ir_dev_cfg.prot_cfg.nec_cfg.is_nec_msb, &out_data->nec_data);
-                parser_offset += ret_len;
-                parser_len -= ret_len;
-
-                if (ret_len >= 68) {
-                    rt = tal_queue_post(dev_info->recv_info.recv_queue_hdl, &out_data, IR_RECV_POST_TIMEOUT_MS);
-                    if (OPRT_OK != rt) {
-                        PR_ERR("post queue error, %d", rt);
-                        __tdl_ir_recv_buf_free(out_data);
-                        out_data = NULL;
-                    }
-                } else {
-                    __tdl_ir_recv_buf_free(out_data);
-                    out_data = NULL;
-                }
-            }while (parser_offset+68 <= data_len);
-
-            if (NULL != tmp_buf) {
-                tal_free(tmp_buf);
-                tmp_buf = NULL;
-            }
+            dev_info->recv_info.app_recv_cb(1, &dev_info->recv_info.last_data);
         }
+        dev_info->recv_info.have_data = 0;
     } else if (dev_info->ir_dev_cfg.prot_opt == IR_PROT_TIMECODE) {
         out_data = __tdl_ir_recv_buf_malloc(IR_PROT_TIMECODE, data_len * SIZEOF(uint32_t));
         TUYA_CHECK_NULL_RETURN(out_data, OPRT_MALLOC_FAILED);
@@ -682,125 +674,52 @@ static OPERATE_RET __tdl_ir_recv_data_process(IR_DEV_NODE_T *dev_info)
 }
 
 /**
- * @brief Receive and decode IR data at the same time
+ * @brief report the codes decoded since the last call
  *
  * @param[in] dev_info: ir device structure
  *
- * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ * @return none
  */
-static OPERATE_RET __tdl_ir_recv_data_process_sync(IR_DEV_NODE_T *dev_info)
+static void __tdl_ir_recv_code_deliver(IR_DEV_NODE_T *dev_info)
 {
     OPERATE_RET rt = OPRT_OK;
-    uint16_t recv_len = 0;
-    uint32_t *recv_buf = NULL, repeat_buf[8] = {0};
-    IR_RING_BUF_T *recv_rb = NULL;
-    uint16_t head_offset = 0, parser_len = 0, repeat_cnt=0, tmp_len = 0;
-    IR_DATA_U out_data;
-
-    if (NULL==dev_info) {
-        return OPRT_INVALID_PARM;
-    }
-
-    recv_rb = dev_info->recv_info.ring_buf;
-    recv_len = RING_BUFFER_LENGTH_GET(recv_rb);
-
-    if (dev_info->recv_info.have_data == 0) { // parser addr, cmd
-        if (recv_len < IR_NEC_MIN_LENGTH) {
-            /* data too short, no process */
-            rt = OPRT_OK;
-            goto __EXIT;
-        }
-
-        recv_buf = tal_malloc(recv_len * SIZEOF(uint32_t));
-        if (NULL == recv_buf) {
-            rt = OPRT_MALLOC_FAILED;
-            goto __ERR;
-        }
-        __tdl_ir_ring_buf_read_no_update(recv_rb, recv_buf, recv_len);
-
-        rt = tdl_nec_get_frame_head(recv_buf, recv_len, dev_info->recv_info.recv_err_val, &head_offset);
-        if (OPRT_OK != rt) {
-            /* no search nec head, discard invalid data */
-            __tdl_ir_ring_buf_data_discard(recv_rb, recv_len);
-            PR_ERR("no head");
-            rt = OPRT_COM_ERROR;
-            goto __ERR;
-        }
-
-        if (head_offset > 0) {
-            __tdl_ir_ring_buf_data_discard(recv_rb, head_offset);
+    IR_DEV_RECV_T *recv = &dev_info->recv_info;
+    IR_DATA_CODE_T *code = NULL;
+    IR_DATA_U *out_data = NULL;
+
+    while (recv->code_rd != recv->code_wr) {
+        code = &recv->code_buf[recv->code_rd];
+        if (IR_PROT_NEC == dev_info->ir_dev_cfg.prot_opt) {
+            recv->last_data.nec_data.addr = code->addr;
+            recv->last_data.nec_data.cmd = code->cmd;
+            recv->last_data.nec_data.repeat_cnt = code->repeat_cnt;
+        } else {
+            recv->last_data.code = *code;
         }
+        recv->have_data = 1;
+        recv->code_rd = (recv->code_rd + 1) % IR_RECV_CODE_NUM;
 
-        if (recv_len - head_offset < IR_NEC_MIN_LENGTH) {
-            /* wait data */
-            rt = OPRT_OK;
-            goto __EXIT;
+        if (NULL != recv->app_recv_cb) {
+            recv->app_recv_cb(0, &recv->last_data);
+            continue;
         }
 
-        parser_len = tdl_ir_nec_parser_single(&recv_buf[head_offset], recv_len-head_offset, dev_info->recv_info.recv_err_val, dev_info->ir_dev_cfg.prot_cfg.nec_cfg.is_nec_msb, &out_data.nec_data);
-        if (parser_len < IR_NEC_MIN_LENGTH) {
-            PR_ERR("nec decode err");
-            rt = OPRT_COM_ERROR;
-            goto __ERR;
-        }
-        
-        dev_info->recv_info.have_data = 1;
-        dev_info->recv_info.addr = out_data.nec_data.addr;
-        dev_info->recv_info.cmd = out_data.nec_data.cmd;
-        dev_info->recv_info.repeat_cnt = out_data.nec_data.repeat_cnt;
-        __tdl_ir_ring_buf_data_discard(recv_rb, parser_len);
-
-        if (dev_info->recv_info.app_recv_cb) {
-            dev_info->recv_info.app_recv_cb(0, &out_data);
-        }
-    } else { // parser repeat_cnt
-        if (recv_len < IR_NEC_REPEAT_LENGTH) {
-            rt = OPRT_OK;
-            goto __EXIT;
+        out_data = __tdl_ir_recv_buf_malloc(dev_info->ir_dev_cfg.prot_opt, 0);
+        if (NULL == out_data) {
+            continue;
         }
-        tmp_len = (recv_len>8) ? (8) : (recv_len);
-        while (tmp_len > 4) {
-            __tdl_ir_ring_buf_read_no_update(recv_rb, repeat_buf, tmp_len);
-            parser_len = tdl_ir_nec_parser_repeat(repeat_buf, tmp_len, dev_info->recv_info.recv_err_val, &repeat_cnt);
-            if (parser_len > 0) {
-                dev_info->recv_info.repeat_cnt += repeat_cnt;
-
-                out_data.nec_data.addr = dev_info->recv_info.addr;
-                out_data.nec_data.cmd = dev_info->recv_info.cmd;
-                out_data.nec_data.repeat_cnt = dev_info->recv_info.repeat_cnt;
-                if (dev_info->recv_info.app_recv_cb) {
-                    dev_info->recv_info.app_recv_cb(0, &out_data);
-                }
-                __tdl_ir_ring_buf_data_discard(recv_rb, parser_len);
-
-                recv_len = RING_BUFFER_LENGTH_GET(recv_rb);
-                tmp_len = (recv_len>8) ? (8) : (recv_len);
-            } else {
-                PR_ERR("repeat decode err");
-                rt = OPRT_COM_ERROR;
-                goto __ERR;
-            }
+        *out_data = recv->last_data;
+        rt = tal_queue_post(recv->recv_queue_hdl, &out_data, IR_RECV_POST_TIMEOUT_MS);
+        if (OPRT_OK != rt) {
+            PR_ERR("post queue error, %d", rt);
+            __tdl_ir_recv_buf_free(out_data);
+            out_data = NULL;
         }
     }
 
-__EXIT:
-    if (NULL != recv_buf) {
-        tal_free(recv_buf);
-        recv_buf = NULL;
-    }
-
-    return OPRT_OK;
-
-__ERR:
-    if (NULL != recv_buf) {
-        tal_free(recv_buf);
-        recv_buf = NULL;
-    }
-
-    return rt;
+    return;
 }
 
-
 /**
  * @brief ir receive task
  *
@@ -812,7 +731,7 @@ static void __tdl_ir_recv_task(void *args)
 {
     OPERATE_RET op_ret = OPRT_OK;
     IR_DEV_NODE_T *dev_node = NULL;
-    uint32_t cur_time = 0;
+    uint32_t idle_time = 0;
 
     PR_DEBUG("ir recv task start");
 
@@ -837,23 +756,21 @@ static void __tdl_ir_recv_task(void *args)
                 sg_cpu_lp_dis_flag = 1;
             }
 
-            tal_system_sleep(50);
-            cur_time = tal_system_get_millisecond();
-            if (cur_time > dev_node->recv_info.last_time) {
-                if (cur_time - dev_node->recv_info.last_time >= IR_RECV_TIMEOUT_MS) {
-                    dev_node->recv_status = IR_STA_RECV_FINISH;
-                }
-            } else if (cur_time < dev_node->recv_info.last_time && dev_node->recv_info.last_time-cur_time > OVERFLOW_TIME_MS) { /* time overflow */
-                if (OVERFLOW_TIME_MS-dev_node->recv_info.last_time+cur_time >= IR_RECV_TIMEOUT_MS) {
-                    dev_node->recv_status = IR_STA_RECV_FINISH;
-                }
+            /* wake up on a decoded code, or once the receiver has been idle for IR_RECV_TIMEOUT_MS */
+            idle_time = (uint32_t)tal_system_get_millisecond() - dev_node->recv_info.last_time;
+            if ((int32_t)idle_time < 0) { /* an edge arrived after the time was read */
+                idle_time = 0;
+            }
+            if (idle_time >= IR_RECV_TIMEOUT_MS) {
+                dev_node->recv_status = IR_STA_RECV_FINISH;
+            } else if (NULL != dev_node->recv_info.recv_sem_hdl) {
+                tal_semaphore_wait(dev_node->recv_info.recv_sem_hdl, IR_RECV_TIMEOUT_MS - idle_time);
+            } else {
+                tal_system_sleep(IR_RECV_TIMEOUT_MS - idle_time);
             }
 
-            if (NULL != dev_node->recv_info.app_recv_cb && dev_node->ir_dev_cfg.prot_opt == IR_PROT_NEC) {
-                op_ret = __tdl_ir_recv_data_process_sync(dev_node);
-                if (OPRT_OK != op_ret) {
-                    dev_node->recv_status = IR_STA_RECV_FINISH;
-                }
+            if (NULL != dev_node->recv_info.decoder) {
+                __tdl_ir_recv_code_deliver(dev_node);
             }
         }
 
@@ -1045,6 +962,11 @@ static OPERATE_RET __tdl_ir_recv_deinit(IR_DEV_NODE_T *ir_device)
         sg_list_head.recv_dev_run_num--;
     }
 
+    if (NULL != ir_device->recv_info.recv_sem_hdl) {
+        tal_semaphore_release(ir_device->recv_info.recv_sem_hdl);
+        ir_device->recv_info.recv_sem_hdl = NULL;
+    }
+
     ir_device->recv_info.is_run = 0;
 
     return OPRT_OK;
@@ -1086,6 +1008,14 @@ static OPERATE_RET __tdl_ir_recv_init(IR_DEV_NODE_T *ir_device)
         }
     }
 
+    if (NULL == ir_device->recv_info.recv_sem_hdl) {
+        op_ret = tal_semaphore_create_init(&ir_device->recv_info.recv_sem_hdl, 0, IR_RECV_CODE_NUM);
+        if (OPRT_OK != op_ret) {
+            PR_ERR("semaphore creat err, %d", op_ret);
+            goto __EXIT;
+        }
+    }
+
 __EXIT:
     if (OPRT_OK != op_ret) {
         if (NULL != ir_device->recv_info.ring_buf) {
@@ -1105,6 +1035,49 @@ __EXIT:
     return op_ret;
 }
 
+/**
+ * @brief create the edge decoder of a receiving device
+ *
+ * @param[in] ir_device: ir device struct
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+static OPERATE_RET __tdl_ir_decoder_init(IR_DEV_NODE_T *ir_device)
+{
+    IR_DEV_CFG_T *config = &ir_device->ir_dev_cfg;
+    IR_NEC_CFG_T *nec_cfg = &config->prot_cfg.nec_cfg;
+    IR_DECODER_CFG_T dec_cfg = {0};
+    uint8_t nec_err[5], i;
+
+    if (IR_PROT_NEC == config->prot_opt) {
+        /* one tolerance for every duration, the widest of the nec error percents */
+        nec_err[0] = nec_cfg->lead_err;
+        nec_err[1] = nec_cfg->logics_err;
+        nec_err[2] = nec_cfg->logic0_err;
+        nec_err[3] = nec_cfg->logic1_err;
+        nec_err[4] = nec_cfg->repeat_err;
+        for (i = 0; i < CNTSOF(nec_err); i++) {
+            if (nec_err[i] > dec_cfg.tolerance) {
+                dec_cfg.tolerance = nec_err[i];
+            }
+        }
+        dec_cfg.prot_mask = IR_PROT_BIT(IR_PROT_NEC);
+        dec_cfg.is_nec_msb = nec_cfg->is_nec_msb;
+    } else {
+        dec_cfg.prot_mask = (IR_PROT_AUTO == config->prot_opt) ? IR_DECODE_PROT_ALL : IR_PROT_BIT(config->prot_opt);
+        dec_cfg.tolerance = config->prot_cfg.decode_cfg.tolerance;
+        dec_cfg.sirc_bits = config->prot_cfg.decode_cfg.sirc_bits;
+        dec_cfg.is_nec_msb = config->prot_cfg.decode_cfg.is_nec_msb;
+    }
+
+    if (NULL != ir_device->recv_info.decoder) {
+        tdl_ir_decoder_release(ir_device->recv_info.decoder);
+        ir_device->recv_info.decoder = NULL;
+    }
+
+    return tdl_ir_decoder_create(&dec_cfg, &ir_device->recv_info.decoder);
+}
+
 /**
  * @brief open ir device
  *
@@ -1118,7 +1091,6 @@ OPERATE_RET tdl_ir_dev_open(IR_HANDLE_T handle, IR_DEV_CFG_T *config)
     OPERATE_RET op_ret = OPRT_OK;
     IR_DRV_HANDLE_T drv_hdl;
     IR_DEV_NODE_T *ir_device = NULL;
-    void *err_val = NULL;
 
     if (NULL==handle || NULL==config) {
         return OPRT_INVALID_PARM;
@@ -1163,13 +1135,12 @@ OPERATE_RET tdl_ir_dev_open(IR_HANDLE_T handle, IR_DEV_CFG_T *config)
         __tdl_ir_recv_server_start(handle);
 
         /* device receive resources request */
-        if (IR_PROT_NEC == config->prot_opt) {
-            op_ret = tdl_ir_nec_err_val_init(&err_val, &config->prot_cfg.nec_cfg);
+        if (IR_PROT_TIMECODE != config->prot_opt) {
+            op_ret = __tdl_ir_decoder_init(ir_device);
             if (OPRT_OK != op_ret) {
-                PR_ERR("nec error value init failed, ret=%d", op_ret);
+                PR_ERR("ir decoder init failed, ret=%d", op_ret);
                 return op_ret;
             }
-            ir_device->recv_info.recv_err_val = err_val;
         }
     }
 
@@ -1218,12 +1189,17 @@ OPERATE_RET tdl_ir_dev_close(IR_HANDLE_T handle)
 
     if (ir_device->ir_dev_cfg.ir_mode != IR_MODE_SEND_ONLY) {
         __tdl_ir_recv_deinit(ir_device);
-        tdl_ir_nec_err_val_init_release(ir_device->recv_info.recv_err_val);
     }
 
     drv_hdl = ir_device->ir_drv_hdl;
     ir_device->drv_intfs->close(drv_hdl, ir_device->ir_dev_cfg.ir_mode);
 
+    /* the receive interrupt is off */
+    if (NULL != ir_device->recv_info.decoder) {
+        tdl_ir_decoder_release(ir_device->recv_info.decoder);
+        ir_device->recv_info.decoder = NULL;
+    }
+
     ir_device->is_open = 0;
 
     return OPRT_OK;
@@ -1460,6 +1436,17 @@ OPERATE_RET tdl_ir_config(IR_HANDLE_T handle, IR_CMD_E cmd, void *params)
             PR_NOTICE("Set ir recv task stack size: %d", sg_list_head.stack_size);
         break;
 
+        case IR_CMD_RECV_LEARN_ADD:
+            if (NULL == params) { return OPRT_INVALID_PARM; }
+            if (NULL == ir_device->recv_info.decoder) { return OPRT_NOT_SUPPORTED; }
+            op_ret = tdl_ir_decoder_learn_add(ir_device->recv_info.decoder, (IR_DATA_TIMECODE_T *)params);
+        break;
+
+        case IR_CMD_RECV_LEARN_CLEAN:
+            if (NULL == ir_device->recv_info.decoder) { return OPRT_NOT_SUPPORTED; }
+            tdl_ir_decoder_learn_clean(ir_device->recv_info.decoder);
+        break;
+
         default: break;
     }
 
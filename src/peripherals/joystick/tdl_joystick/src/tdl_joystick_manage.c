@@ -19,6 +19,7 @@
 
 #include "tdl_joystick_driver.h"
 #include "tdl_joystick_manage.h"
+#include "tdl_button_engine.h"
 #include "tdd_joystick.h"
 #include "tkl_adc.h"
 
@@ -34,9 +35,8 @@
 #define TDL_LONG_START_VAILD_TIMER   1500  // ms
 #define TDL_LONG_KEEP_TIMER          100   // ms
 #define TDL_JOYSTICK_DEBOUNCE_TIME   60    // ms
-#define TDL_JOYSTICK_IRQ_SCAN_TIME   10000 // ms
+#define TDL_JOYSTICK_IRQ_SCAN_TIME   10000 // ms, keep sampling the stick this long after the last activity
 #define TDL_JOYSTICK_SCAN_TIME       20    // 10ms
-#define TDL_JOYSTICK_IRQ_SCAN_CNT    (TDL_JOYSTICK_IRQ_SCAN_TIME / TDL_JOYSTICK_SCAN_TIME)
 #define TOUCH_DELAY                  500 // Click interval for single/double click differentiation
 #define TDL_JOYSTICK_TASK_STACK_SIZE (4096)
 #define PUT_EVENT_CB(btn, name, ev, arg)                                                                               \
@@ -60,16 +60,12 @@ typedef struct {
 } TDL_JOYSTICK_HARDWARE_CFG_T;
 
 typedef struct {
-    uint8_t pre_event;      /* previous event */
-    uint8_t now_event;      /* current event */
-    uint8_t flag : 3;       /* button processing status */
-    uint8_t debounce_cnt;   /* debounce time conversion count */
-    uint16_t ticks;         /* press hold count */
-    uint8_t status;         /* button actual status */
-    uint8_t repeat;         /* repeat press count */
-    uint8_t ready;          /* button power ready status */
-    uint8_t init_flag;      /* button initialization success */
-    uint8_t last_direction; /* last direction event */
+    TDL_BUTTON_ENGINE_T engine; /* button event state machine */
+    uint8_t ready;              /* button power ready status */
+    uint8_t init_flag;          /* button initialization success */
+    uint8_t last_direction;     /* last direction event */
+    uint8_t direction_long;     /* long direction event already sent */
+    uint32_t direction_ms;      /* time the current direction started */
 
     TDL_JOYSTICK_CTRL_INFO ctrl_info;    /* joystick control info */
     TDL_JOYSTICK_DEV_HANDLE dev_handle;  /* joystick device handle */
@@ -94,7 +90,7 @@ typedef struct {
     uint8_t irq_task_flag;    /* irq task flag */
     uint8_t task_mode;        /* task mode */
     SEM_HANDLE irq_semaphore; /* irq semaphore */
-    uint32_t irq_scan_cnt;    /* irq scan cnt */
+    uint32_t active_ms;       /* last time a button or the stick was active */
     MUTEX_HANDLE mutex;       /* mutex */
 } TDL_JOYSTICK_LOCAL_T;       /* TDL joystick local parameters */
 
@@ -105,7 +101,7 @@ TDL_JOYSTICK_LOCAL_T tdl_joystick_local = {.irq_task_flag = FALSE,
                                            .scan_task_flag = FALSE,
                                            .task_mode = FALSE,
                                            .irq_semaphore = NULL,
-                                           .irq_scan_cnt = TDL_JOYSTICK_IRQ_SCAN_TIME / TDL_JOYSTICK_SCAN_TIME,
+                                           .active_ms = 0,
                                            .mutex = NULL};
 
 THREAD_HANDLE stick_scan_thread_handle = NULL;    /* scan thread handle */
@@ -116,7 +112,6 @@ static uint8_t g_tdl_joystick_list_exist = FALSE;                           /* j
 static uint8_t g_tdl_joystick_scan_mode_exist = 0xFF;                       /* joystick scan mode init flag */
 static uint32_t sg_joystick_task_stack_size = TDL_JOYSTICK_TASK_STACK_SIZE; /* joystick task stack size */
 static uint8_t tdl_joystick_scan_time = TDL_JOYSTICK_SCAN_TIME;             /* joystick scan time */
-static uint32_t joystick_ticks = 0;
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
@@ -324,8 +319,7 @@ static TDL_JOYSTICK_LIST_NODE_T *__tdl_joystick_updata_userdata(char *name, TDL_
         p_node->user_data.joystick_cfg.adc_cfg.sensitivity = joystick_cfg->adc_cfg.sensitivity;
     }
 
-    p_node->device_data.pre_event = TDL_JOYSTICK_TOUCH_EVENT_NONE;
-    p_node->device_data.now_event = TDL_JOYSTICK_TOUCH_EVENT_NONE;
+    tdl_button_engine_reset(&p_node->device_data.engine);
     p_node->device_data.last_direction = TDL_JOYSTICK_TOUCH_EVENT_NONE;
 
     return p_node;
@@ -337,6 +331,7 @@ void tdl_joystick_direction_event_proc(TDL_JOYSTICK_HANDLE handle)
     TDL_JOYSTICK_LIST_NODE_T *p_node = NULL;
     int x = 0, y = 0;
     int threshold;
+    uint32_t now_ms = 0;
     TDL_JOYSTICK_TOUCH_EVENT_E current_direction = TDL_JOYSTICK_TOUCH_EVENT_NONE;
 
     p_node = __tdl_joystick_find_node(handle);
@@ -361,243 +356,63 @@ void tdl_joystick_direction_event_proc(TDL_JOYSTICK_HANDLE handle)
         current_direction = TDL_JOYSTICK_DOWN;
     }
 
+    now_ms = (uint32_t)tal_system_get_millisecond();
     if (current_direction != p_node->device_data.last_direction) {
         if (p_node->device_data.last_direction != TDL_JOYSTICK_TOUCH_EVENT_NONE) {
-            if (TDL_LONG_START_VAILD_TIMER / tdl_joystick_scan_time / 30 < joystick_ticks &&
-                joystick_ticks < (TDL_LONG_START_VAILD_TIMER / tdl_joystick_scan_time)) {
+            uint32_t held = now_ms - p_node->device_data.direction_ms;
+            if (TDL_LONG_START_VAILD_TIMER / 30 < held && held < TDL_LONG_START_VAILD_TIMER) {
                 PUT_EVENT_CB(p_node->user_data, p_node->name, p_node->device_data.last_direction, NULL);
             }
         }
-        joystick_ticks = 0;
+        p_node->device_data.direction_ms = now_ms;
+        p_node->device_data.direction_long = FALSE;
         p_node->device_data.last_direction = current_direction;
-    } else {
-        if (current_direction != TDL_JOYSTICK_TOUCH_EVENT_NONE) {
-            joystick_ticks++;
-
-            if (joystick_ticks == (TDL_LONG_START_VAILD_TIMER / tdl_joystick_scan_time)) {
-                TDL_JOYSTICK_TOUCH_EVENT_E long_event = TDL_JOYSTICK_TOUCH_EVENT_NONE;
-                switch (p_node->device_data.last_direction) {
-                case TDL_JOYSTICK_UP:
-                    long_event = TDL_JOYSTICK_LONG_UP;
-                    break;
-                case TDL_JOYSTICK_DOWN:
-                    long_event = TDL_JOYSTICK_LONG_DOWN;
-                    break;
-                case TDL_JOYSTICK_LEFT:
-                    long_event = TDL_JOYSTICK_LONG_LEFT;
-                    break;
-                case TDL_JOYSTICK_RIGHT:
-                    long_event = TDL_JOYSTICK_LONG_RIGHT;
-                    break;
-                default:
-                    break;
-                }
-                if (long_event != TDL_JOYSTICK_TOUCH_EVENT_NONE) {
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, long_event, NULL);
-                }
-            }
-        } else {
-            joystick_ticks = 0;
+    } else if ((current_direction != TDL_JOYSTICK_TOUCH_EVENT_NONE) && (p_node->device_data.direction_long == FALSE) &&
+               (now_ms - p_node->device_data.direction_ms >= TDL_LONG_START_VAILD_TIMER)) {
+        TDL_JOYSTICK_TOUCH_EVENT_E long_event = TDL_JOYSTICK_TOUCH_EVENT_NONE;
+        switch (p_node->device_data.last_direction) {
+        case TDL_JOYSTICK_UP:
+            long_event = TDL_JOYSTICK_LONG_UP;
+            break;
+        case TDL_JOYSTICK_DOWN:
+            long_event = TDL_JOYSTICK_LONG_DOWN;
+            break;
+        case TDL_JOYSTICK_LEFT:
+            long_event = TDL_JOYSTICK_LONG_LEFT;
+            break;
+        case TDL_JOYSTICK_RIGHT:
+            long_event = TDL_JOYSTICK_LONG_RIGHT;
+            break;
+        default:
+            break;
         }
+        if (long_event != TDL_JOYSTICK_TOUCH_EVENT_NONE) {
+            PUT_EVENT_CB(p_node->user_data, p_node->name, long_event, NULL);
+        }
+        p_node->device_data.direction_long = TRUE;
     }
 }
 
 /**
- * @brief Joystick state machine to generate joystick trigger events.
- * @param[in] p_node Pointer to the joystick node.
+ * @brief Deliver a button engine event to the registered joystick callback.
+ * @param[in] ctx Pointer to the joystick node.
+ * @param[in] event Button event, numerically equal to the TDL_JOYSTICK_BUTTON_* event.
+ * @param[in] arg Repeat count or press duration in ms.
  */
-static void __tdl_joystick_state_handle(TDL_JOYSTICK_LIST_NODE_T *p_node)
+static void __tdl_joystick_event_emit(void *ctx, TDL_BUTTON_TOUCH_EVENT_E event, uint32_t arg)
 {
-    uint16_t hold_tick = 0;
-
-    if (NULL == p_node) {
-        return;
-    }
-
-    switch (p_node->device_data.flag) {
-    case 0: {
-        // PR_NOTICE("case0:tick=%d",p_node->device_data.ticks);
-        if (p_node->device_data.status != 0) {
-            if (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE) {
-                tdl_joystick_local.irq_scan_cnt = 0;
-            }
-            // press down
-            p_node->device_data.ticks = 0;
-            p_node->device_data.repeat = 1;
-            p_node->device_data.flag = 1;
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_JOYSTICK_BUTTON_PRESS_DOWN;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_JOYSTICK_BUTTON_PRESS_DOWN,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-
-        } else {
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_JOYSTICK_TOUCH_EVENT_NONE; // Default state is none, no callback needed
-        }
-
-    } break;
+    TDL_JOYSTICK_LIST_NODE_T *p_node = (TDL_JOYSTICK_LIST_NODE_T *)ctx;
 
-    case 1: {
-        // PR_NOTICE("case1:tick=%d",p_node->device_data.ticks);
-        if (p_node->device_data.status != 0) {
-            if (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE) {
-                tdl_joystick_local.irq_scan_cnt = 0;
-            }
-            if (p_node->user_data.joystick_cfg.button_cfg.long_start_valid_time == 0) {
-                // Long press valid time is 0, do not execute long press
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            } else if (p_node->device_data.ticks >
-                       (p_node->user_data.joystick_cfg.button_cfg.long_start_valid_time / tdl_joystick_scan_time)) {
-                // Long press start event is triggered
-                // PR_NOTICE("long tick =%d",p_node->device_data.ticks);
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-                p_node->device_data.now_event = TDL_BUTTON_LONG_PRESS_START;
-                PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_LONG_PRESS_START,
-                             (void *)((uint32_t)p_node->device_data.ticks * tdl_joystick_scan_time));
-                p_node->device_data.flag = 5;
-            } else {
-                // First press, holding down, not reaching long press start event, timely update front and back status
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            }
-        } else {
-            // Trigger release event
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            p_node->device_data.flag = 2;
-            p_node->device_data.ticks = 0;
-        }
-    } break;
-
-    case 2: {
-        // PR_NOTICE("case2");
-        if (p_node->device_data.status != 0) {
-            // Press again
-            if (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE) {
-                tdl_joystick_local.irq_scan_cnt = 0;
-            }
-            p_node->device_data.repeat++;
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_DOWN;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_DOWN,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            p_node->device_data.flag = 3;
-        } else {
-            // Release timeout
-            if (p_node->device_data.ticks >=
-                (p_node->user_data.joystick_cfg.button_cfg.button_repeat_valid_time / tdl_joystick_scan_time)) {
-                // Release timeout triggers single click
-                if (p_node->device_data.repeat == 1) {
-                    p_node->device_data.pre_event = p_node->device_data.now_event;
-                    p_node->device_data.now_event = TDL_BUTTON_PRESS_SINGLE_CLICK;
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_SINGLE_CLICK,
-                                 (void *)((uint32_t)p_node->device_data.repeat));
-                } else if (p_node->device_data.repeat == 2) {
-                    // Release triggers double click event
-                    p_node->device_data.pre_event = p_node->device_data.now_event;
-                    p_node->device_data.now_event = TDL_BUTTON_PRESS_DOUBLE_CLICK;
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_DOUBLE_CLICK,
-                                 (void *)((uint32_t)p_node->device_data.repeat));
-                } else if (p_node->device_data.repeat ==
-                           p_node->user_data.joystick_cfg.button_cfg.button_repeat_valid_count) {
-                    if (p_node->user_data.joystick_cfg.button_cfg.button_repeat_valid_count > 2) {
-                        p_node->device_data.pre_event = p_node->device_data.now_event;
-                        p_node->device_data.now_event = TDL_BUTTON_PRESS_REPEAT;
-                        PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_REPEAT,
-                                     (void *)((uint32_t)p_node->device_data.repeat));
-                    }
-                }
-                p_node->device_data.flag = 0;
-            } else {
-                // Release not timed out, timely update front and back status
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-            }
-        }
-    } break;
-
-    case 3: {
-        uint16_t repeat_tick = 0;
-        // PR_NOTICE("case3:tick=%d",p_node->device_data.ticks);
-        // repeat up
-        if (p_node->device_data.status == 0) {
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.repeat));
-            repeat_tick = p_node->user_data.joystick_cfg.button_cfg.button_repeat_valid_time / tdl_joystick_scan_time;
-            if (p_node->device_data.ticks >= repeat_tick) {
-                // Release timeout, double click uses default interval, multi-click uses user-configured interval
-                // PR_NOTICE("3: tick=%d",p_node->device_data.ticks);
-                // PR_NOTICE("%d",repeat_tick);
-                p_node->device_data.flag = 0;
-            } else {
-                p_node->device_data.flag = 2;
-                p_node->device_data.ticks = 0;
-            }
-        } else {
-            // Greater than one press, keep pressing, timely update front and back status
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-        }
-
-    } break;
-
-    case 5: {
-        if (p_node->device_data.status != 0) {
-            // Trigger long press hold event
-            if (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE) {
-                tdl_joystick_local.irq_scan_cnt = 0;
-            }
-            hold_tick = p_node->user_data.joystick_cfg.button_cfg.long_keep_timer / TDL_JOYSTICK_SCAN_TIME;
-            if (hold_tick == 0) {
-                hold_tick = 1;
-            }
-            if (p_node->device_data.ticks >= hold_tick) {
-                // Greater than hold count, immediately refresh status
-                p_node->device_data.pre_event = p_node->device_data.now_event;
-                p_node->device_data.now_event = TDL_BUTTON_LONG_PRESS_HOLD;
-                if (p_node->device_data.ticks % hold_tick == 0) {
-                    // Confirm that it reaches the hold integer multiple before executing
-                    // PR_NOTICE("hold,tick=%d",hold_tick);
-                    PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_LONG_PRESS_HOLD,
-                                 (void *)((uint32_t)p_node->device_data.ticks * tdl_joystick_scan_time));
-                }
-            }
-        } else {
-            // Hold release
-            p_node->device_data.pre_event = p_node->device_data.now_event;
-            p_node->device_data.now_event = TDL_BUTTON_PRESS_UP;
-            PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_PRESS_UP,
-                         (void *)((uint32_t)p_node->device_data.ticks * tdl_joystick_scan_time));
-            p_node->device_data.ticks = 0;
-            p_node->device_data.flag = 0;
-        }
-    } break;
-    case 6: {
-        // If the power is continuously maintained at an effective level and triggered after recovery
-        PUT_EVENT_CB(p_node->user_data, p_node->name, TDL_BUTTON_RECOVER_PRESS_UP, NULL);
-        p_node->device_data.ticks = 0;
-        p_node->device_data.flag = 0;
-    } break;
-
-    default:
-        break;
-    }
-
-    // stick scan
-    tdl_joystick_direction_event_proc(p_node);
-    return;
+    PUT_EVENT_CB(p_node->user_data, p_node->name, event, (void *)arg);
 }
 
 /**
- * @brief Joystick scan task, periodically scans joystick status.
+ * @brief Joystick interrupt callback, wakes the joystick task on every edge.
  * @param[in] arg Task argument, not used.
  */
 static void __tdl_joystick_irq_cb(void *arg)
 {
-    if (tdl_joystick_local.irq_scan_cnt >= TDL_JOYSTICK_IRQ_SCAN_CNT) {
-        tal_semaphore_post(tdl_joystick_local.irq_semaphore);
-    }
+    tal_semaphore_post(tdl_joystick_local.irq_semaphore);
     return;
 }
 
@@ -712,55 +527,57 @@ OPERATE_RET tdl_joystick_create(char *name, TDL_JOYSTICK_CFG_T *joystick_cfg, TD
 /**
  * @brief Handle joystick scanning and state management.
  * @param[in] p_node Pointer to the joystick node.
+ * @param[in] now_ms Current time in ms.
+ * @return ms until the joystick needs to be sampled again.
  */
-static void __tdl_joystick_handle(TDL_JOYSTICK_LIST_NODE_T *p_node)
+static uint32_t __tdl_joystick_handle(TDL_JOYSTICK_LIST_NODE_T *p_node, uint32_t now_ms)
 {
     OPERATE_RET ret = OPRT_COM_ERROR;
     uint8_t status = 0;
+    uint32_t wait = TDL_BUTTON_ENGINE_NO_DEADLINE;
     TDL_JOYSTICK_OPRT_INFO joystick_oprt;
 
     ret = __tdl_get_operate_info(p_node, &joystick_oprt);
     if (OPRT_OK != ret) {
-        return;
+        return TDL_BUTTON_ENGINE_NO_DEADLINE;
     }
 
     if (p_node->device_data.init_flag == TRUE) {
         p_node->device_data.ctrl_info.read_value(&joystick_oprt, &status);
     } else {
         PR_NOTICE("joystick is no init over, name=%s", p_node->name);
-        return;
+        return TDL_BUTTON_ENGINE_NO_DEADLINE;
     }
 
     // Handle the case where a long press on the button triggers a short press when powered on in scan mode.
     // This is not an issue in interrupt mode, where the ready state is not needed.
     if ((p_node->device_data.dev_cfg.stick_mode == JOYSTICK_TIMER_SCAN_MODE) && (p_node->device_data.ready == FALSE)) {
         if (status) {
-            return;
+            return TDL_BUTTON_ENGINE_NO_DEADLINE;
         } else {
             PR_NOTICE("device_data.ready=TRUE,%s,status=%d", p_node->name, status);
-            p_node->device_data.flag = 6;
+            tdl_button_engine_recover(&p_node->device_data.engine);
             p_node->device_data.ready = TRUE;
         }
     }
 
-    // If the joystick is not ready, return
-    if (p_node->device_data.flag > 0) {
-        p_node->device_data.ticks++;
-    }
+    // Update button state
+    wait = tdl_button_engine_update(&p_node->device_data.engine, &p_node->user_data.joystick_cfg.button_cfg, status,
+                                    now_ms, __tdl_joystick_event_emit, p_node);
 
-    // If the status is not changed, reset the debounce count
-    if (status != p_node->device_data.status) {
-        if (++(p_node->device_data.debounce_cnt) >=
-            (p_node->user_data.joystick_cfg.button_cfg.button_debounce_time / tdl_joystick_scan_time)) {
-            p_node->device_data.status = status;
+    // stick scan
+    tdl_joystick_direction_event_proc(p_node);
+
+    // Neither the release edge nor the stick position raise an interrupt, keep sampling while active
+    if (status || !tdl_button_engine_is_idle(&p_node->device_data.engine) ||
+        (p_node->device_data.last_direction != TDL_JOYSTICK_TOUCH_EVENT_NONE)) {
+        tdl_joystick_local.active_ms = now_ms;
+        if (wait > tdl_joystick_scan_time) {
+            wait = tdl_joystick_scan_time;
         }
-    } else {
-        p_node->device_data.debounce_cnt = 0;
     }
 
-    // Update joystick state
-    __tdl_joystick_state_handle(p_node);
-    return;
+    return wait;
 }
 
 /**
@@ -776,12 +593,14 @@ static void __tdl_joystick_scan_thread(void *arg)
     LIST_HEAD *pos1 = NULL;
 
     while (1) {
+        uint32_t now_ms = (uint32_t)tal_system_get_millisecond();
+
         tuya_list_for_each(pos1, &p_head->hdr)
         {
             p_node = tuya_list_entry(pos1, TDL_JOYSTICK_LIST_NODE_T, hdr);
             if ((p_node != NULL) && (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_TIMER_SCAN_MODE)) {
                 tal_mutex_lock(p_node->joystick_mutex);
-                __tdl_joystick_handle(p_node);
+                __tdl_joystick_handle(p_node, now_ms);
                 tal_mutex_unlock(p_node->joystick_mutex);
             }
         }
@@ -800,51 +619,43 @@ static void __tdl_joystick_scan_thread(void *arg)
 }
 
 /**
- * @brief Joystick interrupt scan task thread, handles joystick nodes in interrupt mode.
+ * @brief Joystick interrupt task thread, woken by button edges and sleeping until the earliest deadline.
+ * @note The stick itself has no interrupt, it is sampled for TDL_JOYSTICK_IRQ_SCAN_TIME after the last activity.
  * @param[in] arg Thread argument.
  */
 static void __tdl_joystick_irq_thread(void *arg)
 {
     TDL_JOYSTICK_LIST_HEAD_T *p_head = p_joystick_list;
-    // TDL_JOYSTICK_LIST_HEAD_T *p_combine_head = p_combine_joystick_list;
     TDL_JOYSTICK_LIST_NODE_T *p_node = NULL;
-    // TDL_JOYSTICK_COMBINE_LIST_NODE_T *p_combine_node = NULL;
     LIST_HEAD *pos1 = NULL;
+    uint32_t wait = SEM_WAIT_FOREVER;
 
     while (1) {
-        PR_NOTICE("semaphore wait");
-        tal_semaphore_wait(tdl_joystick_local.irq_semaphore, SEM_WAIT_FOREVER);
-        tdl_joystick_local.irq_scan_cnt = 0;
-        PR_NOTICE("semaphore across");
-
-        while (1) {
-            tuya_list_for_each(pos1, &p_head->hdr)
-            {
-                p_node = tuya_list_entry(pos1, TDL_JOYSTICK_LIST_NODE_T, hdr);
-                if ((p_node != NULL) && (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE)) {
-                    tal_mutex_lock(p_node->joystick_mutex);
-                    __tdl_joystick_handle(p_node);
-                    tal_mutex_unlock(p_node->joystick_mutex);
-                }
-            }
-#if (COMBINE_JOYSTICK_ENABLE == 1)
-            // Handle the case where the interrupt scan count has reached the limit
-            if (tdl_joystick_local.scan_task_flag == FALSE) {
-                tuya_list_for_each(pos2, &p_combine_head->hdr)
-                {
-                    p_combine_node = tuya_list_entry(pos2, TDL_JOYSTICK_COMBINE_LIST_NODE_T, hdr);
-                    if (p_combine_node->combine_cb) {
-                        p_combine_node->combine_cb();
-                    }
+        if (tal_semaphore_wait(tdl_joystick_local.irq_semaphore, wait) == OPRT_OK) {
+            tdl_joystick_local.active_ms = (uint32_t)tal_system_get_millisecond();
+        }
+
+        uint32_t now_ms = (uint32_t)tal_system_get_millisecond();
+        wait = SEM_WAIT_FOREVER;
+
+        tuya_list_for_each(pos1, &p_head->hdr)
+        {
+            p_node = tuya_list_entry(pos1, TDL_JOYSTICK_LIST_NODE_T, hdr);
+            if ((p_node != NULL) && (p_node->device_data.dev_cfg.stick_mode == JOYSTICK_IRQ_MODE)) {
+                tal_mutex_lock(p_node->joystick_mutex);
+                uint32_t node_wait = __tdl_joystick_handle(p_node, now_ms);
+                tal_mutex_unlock(p_node->joystick_mutex);
+                if (node_wait < wait) {
+                    wait = node_wait;
                 }
             }
-#endif
-            // Check if the interrupt scan count has reached the limit
-            if (++tdl_joystick_local.irq_scan_cnt >= TDL_JOYSTICK_IRQ_SCAN_CNT) {
-                break;
-            } else {
-                tal_system_sleep(tdl_joystick_scan_time);
-            }
+        }
+
+        if ((now_ms - tdl_joystick_local.active_ms < TDL_JOYSTICK_IRQ_SCAN_TIME) && (wait > tdl_joystick_scan_time)) {
+            wait = tdl_joystick_scan_time;
+        }
+        if (wait == 0) {
+            wait = 1;
         }
     }
 }
@@ -987,13 +798,7 @@ OPERATE_RET tdl_joystick_delete_without_hardware(TDL_JOYSTICK_HANDLE handle)
     tal_mutex_lock(p_node->joystick_mutex);
 
     memset(&p_node->user_data, 0, sizeof(JOYSTICK_USER_DATA_T));
-    p_node->device_data.pre_event = 0;
-    p_node->device_data.now_event = 0;
-    p_node->device_data.flag = 0;
-    p_node->device_data.debounce_cnt = 0;
-    p_node->device_data.ticks = 0;
-    p_node->device_data.status = 0;
-    p_node->device_data.repeat = 0;
+    tdl_button_engine_reset(&p_node->device_data.engine);
     p_node->device_data.ready = 0;
     p_node->device_data.init_flag = 0;
 
@@ -1146,7 +951,6 @@ OPERATE_RET tdl_joystick_set_scan_time(uint8_t time_ms)
     if (time_ms < TDL_JOYSTICK_SCAN_TIME)
         return OPRT_INVALID_PARM;
     tdl_joystick_scan_time = time_ms;
-    tdl_joystick_local.irq_scan_cnt = TDL_JOYSTICK_IRQ_SCAN_TIME / time_ms;
     return OPRT_OK;
 }
 
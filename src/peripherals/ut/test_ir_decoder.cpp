@@ -0,0 +1,441 @@
+/**
+ * @file test_ir_decoder.cpp
+ * @brief Unit tests of the streaming IR decoder of tdl_ir_device, replaying
+ * pulse traces through the decoder and through an IR device.
+ *
+ * The traces are synthesized from the protocol timings: NEC with two repeat
+ * frames, RC5, RC5X, RC6, Sony SIRC 12/15/20 and a 48 bit air conditioner
+ * code that only the learned mode decodes. They are distorted the way a
+ * demodulating receiver does: marks TEST_MARK_SKEW_US longer, spaces as much
+ * shorter, every duration off by up to TEST_JITTER_PCT percent. They are not
+ * real captures. The callback latency of the device case is recorded as a
+ * test property.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tdl_ir_dev_manage.h"
+#include "tdl_ir_driver.h"
+#include "tdl_ir_decoder.h"
+
+#define TEST_CODE_MAX      8
+#define TEST_MARK_SKEW_US  60
+#define TEST_JITTER_PCT    8
+#define TEST_IDLE_US       1000000
+#define TEST_RECV_TIMEOUT  300 // ms, the idle time that ends a reception
+#define TEST_LATENCY_MS    50  // a code reaches the callback well within this
+
+typedef struct {
+    const char *name;
+    IR_PROT_E   prot;
+    uint8_t     sirc_bits;
+    uint8_t     toggle;
+    uint16_t    addr;
+    uint16_t    cmd;
+    uint8_t     frames; // the first frame and its repeats
+} TEST_CASE_T;
+
+static const TEST_CASE_T sg_case[] = {
+    {"nec", IR_PROT_NEC, 0, 0, 0x807F, 0x1DE2, 3},
+    {"rc5", IR_PROT_RC5, 0, 1, 0x05, 0x35, 2},
+    {"rc5x", IR_PROT_RC5, 0, 0, 0x1A, 0x4C, 1},
+    {"rc6", IR_PROT_RC6, 0, 1, 0x04, 0x0C, 2},
+    {"sirc12", IR_PROT_SIRC, 12, 0, 0x01, 0x15, 3},
+    {"sirc15", IR_PROT_SIRC, 15, 0, 0x97, 0x2A, 3},
+    {"sirc20", IR_PROT_SIRC, 20, 0, 0x1C3A, 0x39, 3},
+    {"learned", IR_PROT_LEARN, 0, 0, 0, 0, 1},
+};
+
+static const uint8_t sg_ac_code[6] = {0x02, 0x20, 0xE0, 0x04, 0x00, 0x48};
+
+/**
+ * @brief Edge durations, the first one a mark
+ */
+struct Trace {
+    void add(bool is_mark, uint32_t us)
+    {
+        // a level that goes on lengthens the last duration
+        if (is_mark == !(dur.size() & 1)) {
+            dur.push_back(us);
+        } else if (!dur.empty()) {
+            dur.back() += us;
+        }
+    }
+
+    uint32_t us(size_t len) const
+    {
+        uint32_t sum = 0;
+
+        for (size_t i = 0; i < len; i++) {
+            sum += dur[i];
+        }
+        return sum;
+    }
+
+    std::vector<uint32_t> dur;
+    size_t frame_len = 0; // edges up to the last mark of the first frame
+};
+
+/**
+ * @brief Replay driver: the test plays the edges into the receive callback
+ */
+static IR_DRV_RECV_CB sg_drv_recv_cb = NULL;
+static void *sg_drv_args = NULL;
+
+static int __replay_open(IR_DRV_HANDLE_T drv_hdl, unsigned char mode, IR_TDL_TRANS_CB ir_tdl_cb, void *args)
+{
+    sg_drv_recv_cb = ir_tdl_cb.recv_cb;
+    sg_drv_args = args;
+    return OPRT_OK;
+}
+
+static int __replay_close(IR_DRV_HANDLE_T drv_hdl, unsigned char mode)
+{
+    sg_drv_recv_cb = NULL;
+    return OPRT_OK;
+}
+
+static int __replay_output(IR_DRV_HANDLE_T drv_hdl, unsigned int freq, unsigned char is_active, unsigned int time_us)
+{
+    return OPRT_NOT_SUPPORTED;
+}
+
+static int __replay_status_notif(IR_DRV_HANDLE_T drv_hdl, IR_DRIVER_STATE_E state, void *args)
+{
+    return OPRT_OK;
+}
+
+// the device keeps a pointer to it
+static TDD_IR_INTFS_T sg_replay_intfs = {
+    .open = __replay_open,
+    .close = __replay_close,
+    .output = __replay_output,
+    .status_notif = __replay_status_notif,
+};
+
+static std::atomic<uint32_t> sg_cb_codes{0};
+static std::atomic<uint32_t> sg_cb_finish{0};
+static std::chrono::steady_clock::time_point sg_cb_at[TEST_CODE_MAX + 1];
+static IR_DATA_NEC_T sg_cb_nec[TEST_CODE_MAX];
+
+static void __replay_recv_cb(uint8_t is_frame_finish, IR_DATA_U *recv_data)
+{
+    uint32_t n = sg_cb_codes.load();
+
+    if (is_frame_finish) {
+        sg_cb_at[TEST_CODE_MAX] = std::chrono::steady_clock::now();
+        sg_cb_finish++;
+        return;
+    }
+    if (n < TEST_CODE_MAX) {
+        sg_cb_at[n] = std::chrono::steady_clock::now();
+        sg_cb_nec[n] = recv_data->nec_data;
+    }
+    sg_cb_codes++;
+}
+
+class IrDecoderTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        for (size_t i = 0; i < CNTSOF(sg_case); i++) {
+            trace[i] = encode(sg_case[i]);
+        }
+        // the learned code is the clean frame
+        learned = encode(sg_case[CNTSOF(sg_case) - 1]);
+        learned_tc.len = learned.dur.size();
+        learned_tc.data = learned.dur.data();
+        seed = 1;
+    }
+
+    static void encode_pulse_distance(Trace &t, const uint8_t *byte, uint8_t bytes, uint32_t unit)
+    {
+        for (uint32_t i = 0; i < bytes * 8u; i++) {
+            t.add(true, unit);
+            t.add(false, ((byte[i / 8] >> (i % 8)) & 0x01) ? unit * 3 : unit);
+        }
+        t.add(true, unit);
+    }
+
+    static Trace encode(const TEST_CASE_T &c)
+    {
+        uint8_t byte[4] = {(uint8_t)(c.addr >> 8), (uint8_t)(c.addr & 0xFF), (uint8_t)(c.cmd >> 8),
+                           (uint8_t)(c.cmd & 0xFF)};
+        uint32_t start_us, data;
+        Trace t;
+
+        for (uint32_t frame = 0; frame < c.frames; frame++) {
+            start_us = t.us(t.dur.size());
+
+            switch (c.prot) {
+            case IR_PROT_NEC:
+                t.add(true, 9000);
+                if (0 == frame) {
+                    t.add(false, 4500);
+                    for (uint32_t i = 0; i < 32; i++) {
+                        t.add(true, 560);
+                        t.add(false, ((byte[i / 8] >> (i % 8)) & 0x01) ? 1690 : 560);
+                    }
+                } else {
+                    t.add(false, 2250);
+                }
+                t.add(true, 560);
+                break;
+
+            case IR_PROT_RC5:
+                data = (1 << 13) | (!(c.cmd & 0x40) << 12) | (c.toggle << 11) | ((c.addr & 0x1F) << 6) |
+                       (c.cmd & 0x3F);
+                for (int32_t bit = 13; bit >= 0; bit--) {
+                    t.add(!((data >> bit) & 0x01), 889);
+                    t.add((data >> bit) & 0x01, 889);
+                }
+                break;
+
+            case IR_PROT_RC6:
+                t.add(true, 2666);
+                t.add(false, 889);
+                // start bit 1, mode 0, the toggle in the double width trailer bit
+                data = (1 << 20) | (c.toggle << 16) | ((c.addr & 0xFF) << 8) | (c.cmd & 0xFF);
+                for (int32_t bit = 20; bit >= 0; bit--) {
+                    t.add((data >> bit) & 0x01, (16 == bit) ? 889 : 444);
+                    t.add(!((data >> bit) & 0x01), (16 == bit) ? 889 : 444);
+                }
+                break;
+
+            case IR_PROT_SIRC:
+                data = (c.cmd & 0x7F) | (c.addr << 7);
+                t.add(true, 2400);
+                t.add(false, 600);
+                for (uint32_t i = 0; i < c.sirc_bits; i++) {
+                    t.add(true, ((data >> i) & 0x01) ? 1200 : 600);
+                    t.add(false, 600);
+                }
+                break;
+
+            default:
+                // an air conditioner frame, pulse distance on a 432 us unit
+                t.add(true, 3456);
+                t.add(false, 1728);
+                encode_pulse_distance(t, sg_ac_code, sizeof(sg_ac_code), 432);
+                break;
+            }
+
+            if (0 == frame) {
+                t.frame_len = t.dur.size() - !(t.dur.size() & 1);
+            }
+            if (frame + 1u < c.frames) {
+                // the next frame starts one period later
+                t.add(false, ((IR_PROT_SIRC == c.prot) ? 45000 : 110000) - (t.us(t.dur.size()) - start_us));
+            }
+        }
+        return t;
+    }
+
+    Trace distort(const Trace &src)
+    {
+        Trace dst = src;
+
+        for (size_t i = 0; i < dst.dur.size(); i++) {
+            bool is_mark = !(i & 1);
+            int32_t jitter;
+
+            seed = seed * 1103515245 + 12345;
+            jitter = (int32_t)(src.dur[i] * TEST_JITTER_PCT / 100) * ((int32_t)((seed >> 16) % 201) - 100) / 100;
+            dst.dur[i] = (is_mark ? src.dur[i] + TEST_MARK_SKEW_US : src.dur[i] - TEST_MARK_SKEW_US) + jitter;
+        }
+        return dst;
+    }
+
+    /* Feeds a trace, returns the codes and the index of the edges that completed them */
+    static std::vector<IR_DATA_CODE_T> replay(IR_DECODER_HANDLE_T dec, const Trace &t,
+                                              std::vector<size_t> *code_idx = NULL)
+    {
+        std::vector<IR_DATA_CODE_T> codes;
+        IR_DATA_CODE_T code;
+
+        tdl_ir_decoder_reset(dec);
+        for (size_t i = 0; i < t.dur.size(); i++) {
+            if (tdl_ir_decoder_feed(dec, t.dur[i], &code)) {
+                codes.push_back(code);
+                if (code_idx) {
+                    code_idx->push_back(i);
+                }
+            }
+        }
+        return codes;
+    }
+
+    static void check(const TEST_CASE_T &c, const std::vector<IR_DATA_CODE_T> &codes)
+    {
+        ASSERT_EQ(c.frames, codes.size()) << c.name;
+        for (size_t i = 0; i < codes.size(); i++) {
+            EXPECT_EQ(c.prot, codes[i].prot) << c.name << " code " << i;
+            EXPECT_EQ(i, codes[i].repeat_cnt) << c.name << " code " << i;
+            EXPECT_EQ(c.addr, codes[i].addr) << c.name << " code " << i;
+            EXPECT_EQ(c.cmd, codes[i].cmd) << c.name << " code " << i;
+            EXPECT_EQ(c.toggle, codes[i].toggle) << c.name << " code " << i;
+        }
+    }
+
+    static IR_DECODER_HANDLE_T create(uint32_t prot_mask, uint8_t sirc_bits = 0)
+    {
+        IR_DECODER_CFG_T cfg;
+        IR_DECODER_HANDLE_T dec = NULL;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.prot_mask = prot_mask;
+        cfg.sirc_bits = sirc_bits;
+        EXPECT_EQ(OPRT_OK, tdl_ir_decoder_create(&cfg, &dec));
+        return dec;
+    }
+
+    Trace trace[CNTSOF(sg_case)];
+    Trace learned;
+    IR_DATA_TIMECODE_T learned_tc;
+    uint32_t seed = 1;
+};
+
+TEST_F(IrDecoderTest, EachProtocol)
+{
+    for (size_t i = 0; i < CNTSOF(sg_case); i++) {
+        IR_DECODER_HANDLE_T dec = create(IR_PROT_BIT(sg_case[i].prot), sg_case[i].sirc_bits);
+        ASSERT_NE(nullptr, dec) << sg_case[i].name;
+        if (IR_PROT_LEARN == sg_case[i].prot) {
+            ASSERT_EQ(OPRT_OK, tdl_ir_decoder_learn_add(dec, &learned_tc));
+        }
+
+        Trace t = distort(trace[i]);
+        std::vector<size_t> code_idx;
+        std::vector<IR_DATA_CODE_T> codes = replay(dec, t, &code_idx);
+        check(sg_case[i], codes);
+
+        // the first code comes out with the edges of the first frame, not at idle
+        if (!code_idx.empty()) {
+            EXPECT_LE(code_idx[0], t.frame_len) << sg_case[i].name;
+        }
+        tdl_ir_decoder_release(dec);
+    }
+}
+
+TEST_F(IrDecoderTest, AutoDecoder)
+{
+    IR_DECODER_HANDLE_T dec = create(IR_DECODE_PROT_ALL);
+    ASSERT_NE(nullptr, dec);
+    ASSERT_EQ(OPRT_OK, tdl_ir_decoder_learn_add(dec, &learned_tc));
+
+    for (size_t i = 0; i < CNTSOF(sg_case); i++) {
+        // the auto decoder only takes the default SIRC length
+        if (IR_PROT_SIRC == sg_case[i].prot && 12 != sg_case[i].sirc_bits) {
+            continue;
+        }
+        check(sg_case[i], replay(dec, distort(trace[i])));
+    }
+    tdl_ir_decoder_release(dec);
+}
+
+TEST_F(IrDecoderTest, LearnClean)
+{
+    const TEST_CASE_T &c = sg_case[CNTSOF(sg_case) - 1];
+    IR_DECODER_HANDLE_T dec = create(IR_PROT_BIT(IR_PROT_LEARN));
+    ASSERT_NE(nullptr, dec);
+
+    EXPECT_TRUE(replay(dec, distort(trace[CNTSOF(sg_case) - 1])).empty()) << "decoded before it was learned";
+    ASSERT_EQ(OPRT_OK, tdl_ir_decoder_learn_add(dec, &learned_tc));
+    check(c, replay(dec, distort(trace[CNTSOF(sg_case) - 1])));
+
+    tdl_ir_decoder_learn_clean(dec);
+    EXPECT_TRUE(replay(dec, distort(trace[CNTSOF(sg_case) - 1])).empty()) << "decoded after the clean";
+    tdl_ir_decoder_release(dec);
+}
+
+TEST_F(IrDecoderTest, WrongProtocolNotDecoded)
+{
+    IR_DECODER_HANDLE_T dec = create(IR_PROT_BIT(IR_PROT_NEC));
+    ASSERT_NE(nullptr, dec);
+
+    for (size_t i = 1; i < CNTSOF(sg_case); i++) {
+        EXPECT_TRUE(replay(dec, distort(trace[i])).empty()) << sg_case[i].name;
+    }
+    tdl_ir_decoder_release(dec);
+}
+
+TEST_F(IrDecoderTest, DeviceCallbackAtLastEdge)
+{
+    IR_HANDLE_T ir = NULL;
+    IR_DEV_CFG_T cfg;
+    std::vector<size_t> code_idx;
+    std::chrono::steady_clock::time_point edge_at[TEST_CODE_MAX], last_edge_at;
+
+    // the edges that complete a code, found offline
+    Trace t = distort(trace[0]);
+    IR_DECODER_HANDLE_T dec = create(IR_PROT_BIT(IR_PROT_NEC));
+    ASSERT_NE(nullptr, dec);
+    replay(dec, t, &code_idx);
+    tdl_ir_decoder_release(dec);
+    ASSERT_EQ(sg_case[0].frames, code_idx.size());
+
+    ASSERT_EQ(OPRT_OK, tdl_ir_dev_register((char *)"ir_replay", NULL, &sg_replay_intfs));
+    ASSERT_EQ(OPRT_OK, tdl_ir_dev_find((char *)"ir_replay", &ir));
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.ir_mode = IR_MODE_RECV_ONLY;
+    cfg.recv_queue_num = 3;
+    cfg.recv_buf_size = 1024;
+    cfg.recv_timeout = TEST_RECV_TIMEOUT;
+    cfg.prot_opt = IR_PROT_NEC;
+    cfg.prot_cfg.nec_cfg = (IR_NEC_CFG_T){0, 31, 46, 46, 40, 24};
+    ASSERT_EQ(OPRT_OK, tdl_ir_dev_open(ir, &cfg));
+    ASSERT_EQ(OPRT_OK, tdl_ir_config(ir, IR_CMD_RECV_CB_REGISTER, (void *)__replay_recv_cb));
+    ASSERT_NE(nullptr, sg_drv_recv_cb);
+
+    // play the edges at their pace, the first one ends the idle level
+    sg_drv_recv_cb(NULL, TEST_IDLE_US, sg_drv_args);
+    auto due = std::chrono::steady_clock::now();
+    for (size_t i = 0, k = 0; i < t.dur.size(); i++) {
+        due += std::chrono::microseconds(t.dur[i]);
+        std::this_thread::sleep_until(due);
+        last_edge_at = std::chrono::steady_clock::now();
+        if (k < code_idx.size() && code_idx[k] == i) {
+            edge_at[k++] = last_edge_at;
+        }
+        sg_drv_recv_cb(NULL, t.dur[i], sg_drv_args);
+    }
+
+    for (int i = 0; i < 10 && 0 == sg_cb_finish.load(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    ASSERT_EQ(code_idx.size(), sg_cb_codes.load());
+    int64_t code_ms_max = 0;
+    for (size_t k = 0; k < code_idx.size(); k++) {
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(sg_cb_at[k] - edge_at[k]).count();
+        code_ms_max = std::max(code_ms_max, ms);
+        EXPECT_EQ(sg_case[0].addr, sg_cb_nec[k].addr) << "code " << k;
+        EXPECT_EQ(sg_case[0].cmd, sg_cb_nec[k].cmd) << "code " << k;
+        EXPECT_EQ(k, sg_cb_nec[k].repeat_cnt) << "code " << k;
+    }
+    EXPECT_LT(code_ms_max, TEST_LATENCY_MS) << "a code waited for the end of reception";
+
+    // the end of reception comes once the receiver has been idle for the timeout
+    ASSERT_EQ(1, sg_cb_finish.load());
+    int64_t finish_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(sg_cb_at[TEST_CODE_MAX] - last_edge_at).count();
+    EXPECT_GE(finish_ms, TEST_RECV_TIMEOUT - TEST_LATENCY_MS);
+    EXPECT_LT(finish_ms, TEST_RECV_TIMEOUT + TEST_LATENCY_MS);
+
+    RecordProperty("code_latency_ms", (int)code_ms_max);
+    RecordProperty("finish_latency_ms", (int)finish_ms);
+    tdl_ir_dev_close(ir);
+}
@@ -40,6 +40,22 @@ typedef struct {
     cli_cmd_func_cb_t func;
 } cli_cmd_t;
 
+typedef struct {
+    /** read at least one byte, blocking; returns the bytes read, <=0 on error */
+    int (*read)(uint8_t *data, uint32_t len);
+    /** write len bytes */
+    int (*write)(const uint8_t *data, uint32_t len);
+} cli_io_t;
+
+typedef struct {
+    /** times the command ran */
+    uint32_t calls;
+    /** time spent in the command, ms */
+    uint32_t total_ms;
+    /** longest run, ms */
+    uint32_t max_ms;
+} cli_cmd_stat_t;
+
 /**
  * @brief cli init function,default uart0
  *
@@ -72,6 +88,40 @@ int tal_cli_cmd_register(const cli_cmd_t *cmd, uint8_t num);
  */
 int tal_cli_init_with_uart(uint8_t uart_num);
 
+/**
+ * @brief cli init on a stream other than a uart, a pipe or a pseudo uart
+ *
+ * @param[in] io Read and write functions of the stream
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ *
+ */
+int tal_cli_init_with_io(const cli_io_t *io);
+
+/**
+ * @brief batch mode, for scripts: no echo, history, line editing or
+ * completion, and empty lines are skipped. The prompt is still printed after
+ * every command, as the mark that it is done
+ *
+ * @param[in] enable 1 for batch mode, 0 for interactive
+ *
+ * @return None
+ *
+ */
+void tal_cli_batch_mode(uint8_t enable);
+
+/**
+ * @brief execution time of a command
+ *
+ * @param[in] name Command name
+ * @param[out] stat Calls and time spent
+ *
+ * @return OPRT_OK on success. OPRT_NOT_FOUND if no command has that name
+ *
+ */
+int tal_cli_cmd_stat_get(const char *name, cli_cmd_stat_t *stat);
+
 /**
  * @brief cli echo string
  *
@@ -10,18 +10,27 @@
  * dynamic command registration, facilitating development and debugging
  * processes.
  *
+ * Registered commands are indexed twice: a hash table of the names resolves
+ * the command of a line, and a radix trie of the names, sorted by character,
+ * gives the commands that start with what was typed for completion. The
+ * index of a table of commands is allocated in one block when it is
+ * registered. In batch mode lines are split into arguments and the name is
+ * hashed as the bytes arrive, so a command runs as soon as its line ends.
+ *
  * @copyright Copyright (c) 2021-2024 Tuya Inc. All Rights Reserved.
  *
  */
 
 /*============================ INCLUDES ======================================*/
 #include <string.h>
+#include <stdio.h>
 #include "tuya_slist.h"
 #include "tal_uart.h"
 #include "tal_log.h"
 #include "tal_cli.h"
 #include "tal_thread.h"
 #include "tal_memory.h"
+#include "tal_system.h"
 
 /*============================ MACROS ========================================*/
 #ifndef CLI_BUFFER_SIZE
@@ -43,11 +52,40 @@
 #ifndef CLI_CMD_NAME_MAX
 #define CLI_CMD_NAME_MAX 20
 #endif
+
+//! buckets of the command hash table, a power of 2
+#ifndef CLI_CMD_HASH_NUM
+#define CLI_CMD_HASH_NUM 64
+#endif
+
+//! bytes taken from the stream per read
+#ifndef CLI_RX_CHUNK
+#define CLI_RX_CHUNK 64
+#endif
 /*============================ MACROFIED FUNCTIONS ===========================*/
+//! FNV-1a, one step per character so that a name can be hashed as it arrives
+#define CLI_HASH_INIT          2166136261u
+#define CLI_HASH_STEP(hash, c) (((hash) ^ (uint8_t)(c)) * 16777619u)
 /*============================ TYPES =========================================*/
+typedef struct cli_cmd_entry {
+    struct cli_cmd_entry *next; //! next in the hash bucket
+    cli_cmd_t *cmd;
+    uint32_t hash;
+    cli_cmd_stat_t stat;
+} cli_cmd_entry_t;
+
+typedef struct cli_trie_node {
+    const char *label; //! part of the name of a command, not terminated
+    uint16_t len;
+    cli_cmd_entry_t *entry; //! command whose name ends here, NULL for an inner node
+    struct cli_trie_node *child; //! first child, children are sorted by their first character
+    struct cli_trie_node *sibling;
+} cli_trie_node_t;
+
 typedef struct {
     uint8_t num;
     cli_cmd_t *cmd;
+    cli_cmd_entry_t *entry; //! index of the commands, num entries then 2 * num trie nodes
 } cli_cmd_table_t;
 
 typedef struct {
@@ -82,44 +120,75 @@ typedef struct {
 
 typedef struct {
     TUYA_UART_NUM_E port_id;
+    cli_io_t io;
     THREAD_HANDLE thread;
     char *prompt;
     uint8_t echo;
+    uint8_t batch;
+    uint8_t in_arg; //! batch: the last byte belongs to an argument
     uint16_t index;
     uint16_t insert;
+    uint16_t rx_pos;
+    uint16_t rx_len;
+    uint32_t hash; //! batch: hash of argv[0] so far
     cli_history_t history;
     int argc;
     char *argv[CLI_ARGV_NUM];
     char buffer[CLI_BUFFER_SIZE + 1];
+    uint8_t rx[CLI_RX_CHUNK];
 } cli_t;
 
 /*============================ PROTOTYPES ====================================*/
 static void cli_hello(int argc, char *argv[]);
+static void cli_batch(int argc, char *argv[]);
+static void cli_cmd_time(int argc, char *argv[]);
 static void cli_print_prompt(cli_t *cli);
 
 /*============================ LOCAL VARIABLES ===============================*/
 static cli_t *s_cli_handle = NULL;
 static SLIST_HEAD s_cli_dynamic_table;
 static cli_cmd_table_t s_cli_static_table[CLI_CMD_TABLE_NUM];
+static cli_cmd_entry_t *s_cli_hash[CLI_CMD_HASH_NUM];
+static cli_trie_node_t s_cli_trie;
 
-static const cli_cmd_t s_cli_cmd[] = {{
-    .name = "hello",
-    .help = "print helo world",
-    .func = cli_hello,
-}};
+static const cli_cmd_t s_cli_cmd[] = {
+    {
+        .name = "hello",
+        .help = "print helo world",
+        .func = cli_hello,
+    },
+    {
+        .name = "batch",
+        .help = "batch on|off, no echo or history for scripts",
+        .func = cli_batch,
+    },
+    {
+        .name = "cmdtime",
+        .help = "cmdtime [clear], execution time per command",
+        .func = cli_cmd_time,
+    },
+};
 
 /*============================ IMPLEMENTATION ================================*/
-static int32_t cli_out_put(TUYA_UART_NUM_E port_id, char *out_str, uint32_t len)
+static int cli_uart_read(uint8_t *data, uint32_t len)
+{
+    return tal_uart_read(s_cli_handle->port_id, data, len);
+}
+
+static int cli_uart_write(const uint8_t *data, uint32_t len)
 {
-    return tal_uart_write(port_id, (const uint8_t *)out_str, len);
+    return tal_uart_write(s_cli_handle->port_id, data, len);
+}
+
+static int32_t cli_out_put(cli_t *cli, char *out_str, uint32_t len)
+{
+    return cli->io.write((const uint8_t *)out_str, len);
 }
 
 static void cli_print_string(cli_t *cli, char *string)
 {
-    cli_out_put(cli->port_id, "\r\n", 2);
-    while ('\0' != *string) {
-        cli_out_put(cli->port_id, string++, 1);
-    }
+    cli_out_put(cli, "\r\n", 2);
+    cli_out_put(cli, string, strlen(string));
 }
 
 static void cli_hello(int argc, char *argv[])
@@ -127,40 +196,179 @@ static void cli_hello(int argc, char *argv[])
     cli_print_string(s_cli_handle, "helo world");
 }
 
-static cli_cmd_t *cli_cmd_find_with_name(char *name)
+static void cli_batch(int argc, char *argv[])
 {
-    int i, j;
-    cli_cmd_t *cmd;
+    if (argc > 1) {
+        tal_cli_batch_mode(0 == strcmp(argv[1], "on"));
+    }
+    cli_print_string(s_cli_handle, s_cli_handle->batch ? "batch on" : "batch off");
+}
 
-    if (NULL == name) {
-        return NULL;
+static uint32_t cli_hash(const char *name)
+{
+    uint32_t hash = CLI_HASH_INIT;
+
+    while ('\0' != *name) {
+        hash = CLI_HASH_STEP(hash, *name++);
     }
 
-    for (i = 0; i < CLI_CMD_TABLE_NUM; i++) {
-        for (j = 0; j < s_cli_static_table[i].num; j++) {
-            cmd = s_cli_static_table[i].cmd + j;
-            if (0 != strcmp(cmd->name, name)) {
-                continue;
-            }
-            return cmd;
+    return hash;
+}
+
+static cli_cmd_entry_t *cli_cmd_find(const char *name, uint32_t hash)
+{
+    cli_cmd_entry_t *entry;
+
+    for (entry = s_cli_hash[hash & (CLI_CMD_HASH_NUM - 1)]; entry; entry = entry->next) {
+        if (entry->hash == hash && 0 == strcmp(entry->cmd->name, name)) {
+            return entry;
         }
     }
 
-    cli_cmd_node_t *node = NULL;
-    SLIST_HEAD *pos = NULL;
+    return NULL;
+}
 
-    SLIST_FOR_EACH_ENTRY(node, cli_cmd_node_t, pos, &s_cli_dynamic_table, next)
-    {
-        for (i = 0; i < node->table.num; i++) {
-            cmd = node->table.cmd + i;
-            if (0 != strcmp(cmd->name, name)) {
-                continue;
+/**
+ * @brief add a command to the trie, it takes 2 nodes from pool at most
+ *
+ * @return the nodes left in pool
+ */
+static cli_trie_node_t *cli_trie_insert(cli_cmd_entry_t *entry, cli_trie_node_t *pool)
+{
+    const char *name = entry->cmd->name;
+    cli_trie_node_t *parent = &s_cli_trie;
+    cli_trie_node_t **link;
+    cli_trie_node_t *node;
+    uint16_t i;
+
+    for (;;) {
+        link = &parent->child;
+        while (*link && (uint8_t)(*link)->label[0] < (uint8_t)*name) {
+            link = &(*link)->sibling;
+        }
+        node = *link;
+        if (NULL == node || node->label[0] != *name) {
+            node = pool++;
+            node->label = name;
+            node->len = strlen(name);
+            node->entry = entry;
+            node->child = NULL;
+            node->sibling = *link;
+            *link = node;
+            return pool;
+        }
+
+        for (i = 0; i < node->len && name[i] == node->label[i]; i++) {
+        }
+        if (i < node->len) {
+            //! split, the node keeps the common part
+            cli_trie_node_t *rest = pool++;
+            rest->label = node->label + i;
+            rest->len = node->len - i;
+            rest->entry = node->entry;
+            rest->child = node->child;
+            rest->sibling = NULL;
+            node->len = i;
+            node->entry = NULL;
+            node->child = rest;
+        }
+        name += i;
+        if ('\0' == *name) {
+            node->entry = entry;
+            return pool;
+        }
+        parent = node;
+    }
+}
+
+/**
+ * @brief the trie node under which all the names starting with prefix are
+ *
+ * @param[out] offset Characters of the label of the node in prefix
+ *
+ * @return NULL if no name starts with prefix
+ */
+static cli_trie_node_t *cli_trie_match(const char *prefix, uint16_t len, uint16_t *offset)
+{
+    cli_trie_node_t *node = &s_cli_trie;
+    uint16_t pos = 0, i = 0;
+
+    while (pos < len) {
+        node = node->child;
+        while (node && node->label[0] != prefix[pos]) {
+            node = node->sibling;
+        }
+        if (NULL == node) {
+            return NULL;
+        }
+        for (i = 0; i < node->len && pos < len; i++, pos++) {
+            if (node->label[i] != prefix[pos]) {
+                return NULL;
             }
-            return cmd;
         }
     }
+    *offset = i;
 
-    return NULL;
+    return node;
+}
+
+static int cli_trie_count(cli_trie_node_t *node, int max)
+{
+    int count = node->entry ? 1 : 0;
+
+    for (node = node->child; node && count < max; node = node->sibling) {
+        count += cli_trie_count(node, max - count);
+    }
+
+    return count;
+}
+
+static void cli_print_cmd(cli_t *cli, cli_cmd_t *cmd);
+
+static void cli_trie_print(cli_t *cli, cli_trie_node_t *node)
+{
+    if (node->entry) {
+        cli_print_cmd(cli, node->entry->cmd);
+    }
+    for (node = node->child; node; node = node->sibling) {
+        cli_trie_print(cli, node);
+    }
+}
+
+/**
+ * @brief index a table of commands, a name already indexed keeps its first command
+ */
+static cli_cmd_entry_t *cli_cmd_index(cli_cmd_t *cmd, uint8_t num)
+{
+    cli_cmd_entry_t *entry, *found;
+    cli_trie_node_t *pool;
+    int i;
+
+    entry = tal_malloc(num * (sizeof(cli_cmd_entry_t) + 2 * sizeof(cli_trie_node_t)));
+    if (NULL == entry) {
+        return NULL;
+    }
+    memset(entry, 0, num * sizeof(cli_cmd_entry_t));
+    pool = (cli_trie_node_t *)(entry + num);
+
+    for (i = 0; i < num; i++) {
+        entry[i].cmd = cmd + i;
+        if (NULL == cmd[i].name || '\0' == cmd[i].name[0]) {
+            continue;
+        }
+        entry[i].hash = cli_hash(cmd[i].name);
+
+        TAL_ENTER_CRITICAL();
+        found = cli_cmd_find(cmd[i].name, entry[i].hash);
+        if (NULL == found) {
+            pool = cli_trie_insert(&entry[i], pool);
+            entry[i].next = s_cli_hash[entry[i].hash & (CLI_CMD_HASH_NUM - 1)];
+            s_cli_hash[entry[i].hash & (CLI_CMD_HASH_NUM - 1)] = &entry[i];
+        }
+        TAL_EXIT_CRITICAL();
+    }
+
+    return entry;
 }
 
 static void cli_print_cmd(cli_t *cli, cli_cmd_t *cmd)
@@ -174,10 +382,10 @@ static void cli_print_cmd(cli_t *cli, cli_cmd_t *cmd)
     len = strlen(cmd->name);
     len = len > CLI_CMD_NAME_MAX ? CLI_CMD_NAME_MAX : len;
     strncpy(name, cmd->name, len);
-    cli_out_put(cli->port_id, "\r\n", 2);
-    cli_out_put(cli->port_id, name, strlen(name));
-    cli_out_put(cli->port_id, "\t", 1);
-    cli_out_put(cli->port_id, cmd->help, strlen(cmd->help));
+    cli_out_put(cli, "\r\n", 2);
+    cli_out_put(cli, name, strlen(name));
+    cli_out_put(cli, "\t", 1);
+    cli_out_put(cli, cmd->help, strlen(cmd->help));
 }
 
 static void cli_print_all_cmd(cli_t *cli)
@@ -208,25 +416,21 @@ static void cli_print_all_cmd(cli_t *cli)
 
 static void cli_print_cmd_title(cli_t *cli)
 {
-    int i;
-
-    cli_out_put(cli->port_id, "\r\ncmd", 5);
-    for (i = 3; i < CLI_CMD_NAME_MAX; i++) {
-        cli_out_put(cli->port_id, " ", 1);
-    }
-    cli_out_put(cli->port_id, "\thelp\r\n", 7);
-    for (i = 0; i < 2 * CLI_CMD_NAME_MAX; i++) {
-        cli_out_put(cli->port_id, "-", 1);
-    }
+    char line[2 * CLI_CMD_NAME_MAX + 1];
+
+    memset(line, ' ', CLI_CMD_NAME_MAX);
+    memcpy(line, "cmd", 3);
+    cli_out_put(cli, "\r\n", 2);
+    cli_out_put(cli, line, CLI_CMD_NAME_MAX);
+    cli_out_put(cli, "\thelp\r\n", 7);
+    memset(line, '-', 2 * CLI_CMD_NAME_MAX);
+    cli_out_put(cli, line, 2 * CLI_CMD_NAME_MAX);
 }
 
 static int cli_table_key(cli_t *cli)
 {
-    cli_cmd_t *cmd;
-    cli_cmd_t *match_cmd = NULL;
-
-    int i, j;
-    int count = 0;
+    cli_trie_node_t *node;
+    uint16_t offset = 0, len;
 
     //! print all cmd
     if (0 == cli->index) {
@@ -235,62 +439,34 @@ static int cli_table_key(cli_t *cli)
         return OPRT_OK;
     }
 
-    //! match one or more
-    for (i = 0; i < CLI_CMD_TABLE_NUM; i++) {
-        for (j = 0; j < s_cli_static_table[i].num; j++) {
-            cmd = s_cli_static_table[i].cmd + j;
-            if (0 != strncmp(cmd->name, cli->buffer, cli->index)) {
-                continue;
+    //! complete what all the matches have in common
+    node = cli_trie_match(cli->buffer, cli->index, &offset);
+    if (node) {
+        for (;;) {
+            len = node->len - offset;
+            if (cli->index + len > CLI_BUFFER_SIZE) {
+                break;
             }
-            match_cmd = cmd;
-            count++;
-        }
-    }
-
-    cli_cmd_node_t *node = NULL;
-    SLIST_HEAD *pos = NULL;
-
-    SLIST_FOR_EACH_ENTRY(node, cli_cmd_node_t, pos, &s_cli_dynamic_table, next)
-    {
-        for (i = 0; i < node->table.num; i++) {
-            cmd = node->table.cmd + i;
-            if (0 != strncmp(cmd->name, cli->buffer, cli->index)) {
-                continue;
+            memcpy(&cli->buffer[cli->index], node->label + offset, len);
+            cli->index += len;
+            cli->buffer[cli->index] = '\0';
+            if (node->entry || NULL == node->child || node->child->sibling) {
+                break;
             }
-            match_cmd = cmd;
-            count++;
+            node = node->child;
+            offset = 0;
         }
-    }
-
-    if (count > 1) { //! print more
-        cli_print_cmd_title(cli);
-        for (i = 0; i < CLI_CMD_TABLE_NUM; i++) {
-            for (j = 0; j < s_cli_static_table[i].num; j++) {
-                cmd = s_cli_static_table[i].cmd + j;
-                if (0 == strncmp(cmd->name, cli->buffer, cli->index)) {
-                    cli_print_cmd(cli, cmd);
-                }
-            }
-        }
-        SLIST_FOR_EACH_ENTRY(node, cli_cmd_node_t, pos, &s_cli_dynamic_table, next)
-        {
-            for (i = 0; i < node->table.num; i++) {
-                cmd = node->table.cmd + i;
-                if (0 == strncmp(cmd->name, cli->buffer, cli->index)) {
-                    cli_print_cmd(cli, cmd);
-                }
-            }
-        }
-    } else if (count) { //! print one
-        strcpy(cli->buffer, match_cmd->name);
-        cli->index = strlen(cli->buffer);
         cli->insert = cli->index;
+        if (cli_trie_count(node, 2) > 1) { //! print more
+            cli_print_cmd_title(cli);
+            cli_trie_print(cli, node);
+        }
     } else {
         cli->insert = cli->index;
     }
 
     cli_print_prompt(cli);
-    cli_out_put(cli->port_id, cli->buffer, cli->index);
+    cli_out_put(cli, cli->buffer, cli->index);
 
     return OPRT_OK;
 }
@@ -361,7 +537,24 @@ static int cli_histroy_data_save(cli_t *cli)
     return true;
 }
 
-static int cli_key_detect(TUYA_UART_NUM_E port_id, char *data, cli_key_t *key)
+static char cli_getc(cli_t *cli)
+{
+    int len;
+
+    while (cli->rx_pos == cli->rx_len) {
+        len = cli->io.read(cli->rx, CLI_RX_CHUNK);
+        if (len <= 0) {
+            tal_system_sleep(10);
+            continue;
+        }
+        cli->rx_pos = 0;
+        cli->rx_len = len;
+    }
+
+    return (char)cli->rx[cli->rx_pos++];
+}
+
+static int cli_key_detect(cli_t *cli, char *data, cli_key_t *key)
 {
     char ch;
     enum {
@@ -371,7 +564,7 @@ static int cli_key_detect(TUYA_UART_NUM_E port_id, char *data, cli_key_t *key)
     } state = CHECK_KEY;
 
     for (;;) {
-        tal_uart_read(port_id, (uint8_t *)&ch, 1);
+        ch = cli_getc(cli);
 
         switch (state) {
 
@@ -412,84 +605,78 @@ static int cli_key_detect(TUYA_UART_NUM_E port_id, char *data, cli_key_t *key)
 
 static void cli_print_prompt(cli_t *cli)
 {
-    cli_out_put(cli->port_id, "\r\n", 2);
-    cli_out_put(cli->port_id, cli->prompt, strlen(cli->prompt));
+    cli_out_put(cli, "\r\n", 2);
+    cli_out_put(cli, cli->prompt, strlen(cli->prompt));
 }
 
-static int cli_parse_buffer(char *buffer, int *argc, char **argv)
+/**
+ * @brief split the buffer into arguments in place, in one pass
+ *
+ * @return the hash of argv[0]
+ */
+static uint32_t cli_parse_buffer(char *buffer, int *argc, char **argv)
 {
-    enum {
-        PARSE_SPACE,
-        PARSE_ARG,
-    } state = PARSE_SPACE;
+    uint32_t hash = CLI_HASH_INIT;
     char *readchar = buffer;
     char *writechar = buffer;
 
     *argc = 0;
 
-    do {
-        switch (state) {
-
-        case PARSE_SPACE:
-            if (' ' == *readchar) {
-                readchar++;
-            } else if ('\0' == *readchar) {
-                *writechar = '\0';
-                goto __exit;
-            } else {
-                state = PARSE_ARG;
-            }
+    for (;;) {
+        while (' ' == *readchar) {
+            readchar++;
+        }
+        if ('\0' == *readchar || CLI_ARGV_NUM == *argc) {
             break;
-
-        case PARSE_ARG:
-            if (' ' == *readchar) {
-                *writechar++ = '\0';
-                readchar++;
-                (*argc)++;
-                state = PARSE_SPACE;
-            } else if ('\0' == *readchar) {
-                *writechar = '\0';
-                (*argc)++;
-                goto __exit;
-            } else {
-                *writechar++ = *readchar++;
-                ;
+        }
+        argv[(*argc)++] = writechar;
+        while (' ' != *readchar && '\0' != *readchar) {
+            if (1 == *argc) {
+                hash = CLI_HASH_STEP(hash, *readchar);
             }
-            break;
+            *writechar++ = *readchar++;
         }
-    } while (true);
+        if (' ' == *readchar) {
+            readchar++;
+        }
+        *writechar++ = '\0';
+    }
 
-__exit:
+    return hash;
+}
 
-    if (CLI_ARGV_NUM < *argc) {
-        *argc = CLI_ARGV_NUM;
-    }
+static int cli_cmd_exec(int argc, char **argv, uint32_t hash)
+{
+    cli_cmd_entry_t *entry;
+    SYS_TIME_T start_ms;
+    uint32_t elapsed_ms;
 
-    int i;
-    for (i = 0; i < *argc; i++) {
-        argv[i] = buffer;
-        buffer += strlen(buffer) + 1;
+    if (0 == argc) {
+        return OPRT_NOT_FOUND;
     }
 
-    return OPRT_OK;
-}
+    entry = cli_cmd_find(argv[0], hash);
+    if (NULL == entry) {
+        return OPRT_NOT_FOUND;
+    }
 
-static int cli_cmd_exec(int argc, char **argv)
-{
-    cli_cmd_t *cmd;
+    start_ms = tal_system_get_millisecond();
+    entry->cmd->func(argc, argv);
+    elapsed_ms = (uint32_t)(tal_system_get_millisecond() - start_ms);
 
-    cmd = cli_cmd_find_with_name(argv[0]);
-    if (cmd) {
-        cmd->func(argc, argv);
-        return OPRT_OK;
+    entry->stat.calls++;
+    entry->stat.total_ms += elapsed_ms;
+    if (elapsed_ms > entry->stat.max_ms) {
+        entry->stat.max_ms = elapsed_ms;
     }
 
-    return OPRT_NOT_FOUND;
+    return OPRT_OK;
 }
 
 static void cli_enter_key(cli_t *cli)
 {
     int result;
+    uint32_t hash;
 
     if (0 == cli->index) {
         cli_print_prompt(cli);
@@ -497,9 +684,9 @@ static void cli_enter_key(cli_t *cli)
     }
     cli->buffer[cli->index] = 0;
     cli_histroy_data_save(cli);
-    cli_parse_buffer(cli->buffer, &cli->argc, cli->argv);
-    cli_out_put(cli->port_id, "\r\n", 2);
-    result = cli_cmd_exec(cli->argc, cli->argv);
+    hash = cli_parse_buffer(cli->buffer, &cli->argc, cli->argv);
+    cli_out_put(cli, "\r\n", 2);
+    result = cli_cmd_exec(cli->argc, cli->argv, hash);
     if (OPRT_OK != result) {
         cli_print_string(cli, "No command or file name");
     }
@@ -520,18 +707,18 @@ static void cli_backspace_key(cli_t *cli)
         cli->insert--;
         memmove(&cli->buffer[cli->insert], &cli->buffer[cli->insert + 1], cli->index - cli->insert);
         cli->buffer[cli->index] = '\0';
-        cli_out_put(cli->port_id, &ch, 1);
-        cli_out_put(cli->port_id, &cli->buffer[cli->insert], cli->index - cli->insert);
-        cli_out_put(cli->port_id, " \b", 2);
+        cli_out_put(cli, &ch, 1);
+        cli_out_put(cli, &cli->buffer[cli->insert], cli->index - cli->insert);
+        cli_out_put(cli, " \b", 2);
         int i;
         for (i = 0; i < (cli->index - cli->insert); i++) {
-            cli_out_put(cli->port_id, &ch, 1);
+            cli_out_put(cli, &ch, 1);
         }
     } else {
         cli->index--;
         cli->insert--;
         cli->buffer[cli->insert] = '\0';
-        cli_out_put(cli->port_id, "\b \b", 3);
+        cli_out_put(cli, "\b \b", 3);
     }
 }
 
@@ -543,15 +730,15 @@ static void cli_up_key(cli_t *cli)
 
     if (cli_histroy_data_perv(cli, &history_data)) {
         ch = '\r';
-        cli_out_put(cli->port_id, &ch, 1);
+        cli_out_put(cli, &ch, 1);
         ch = ' ';
         for (i = 0; i < cli->index + strlen(cli->prompt); i++) {
-            cli_out_put(cli->port_id, &ch, 1);
+            cli_out_put(cli, &ch, 1);
         }
         ch = '\r';
-        cli_out_put(cli->port_id, &ch, 1);
-        cli_out_put(cli->port_id, cli->prompt, strlen(cli->prompt));
-        cli_out_put(cli->port_id, (char *)history_data, strlen((char *)history_data));
+        cli_out_put(cli, &ch, 1);
+        cli_out_put(cli, cli->prompt, strlen(cli->prompt));
+        cli_out_put(cli, (char *)history_data, strlen((char *)history_data));
         strcpy(cli->buffer, (char *)history_data);
         cli->index = strlen(cli->buffer);
         cli->buffer[cli->index] = '\0';
@@ -567,15 +754,15 @@ static void cli_down_key(cli_t *cli)
 
     if (cli_histroy_data_next(cli, &history_data)) {
         ch = '\r';
-        cli_out_put(cli->port_id, &ch, 1);
+        cli_out_put(cli, &ch, 1);
         ch = ' ';
         for (i = 0; i < cli->index + strlen(cli->prompt); i++) {
-            cli_out_put(cli->port_id, &ch, 1);
+            cli_out_put(cli, &ch, 1);
         }
         ch = '\r';
-        cli_out_put(cli->port_id, &ch, 1);
-        cli_out_put(cli->port_id, cli->prompt, strlen(cli->prompt));
-        cli_out_put(cli->port_id, (char *)history_data, strlen((char *)history_data));
+        cli_out_put(cli, &ch, 1);
+        cli_out_put(cli, cli->prompt, strlen(cli->prompt));
+        cli_out_put(cli, (char *)history_data, strlen((char *)history_data));
         strcpy(cli->buffer, (char *)history_data);
         cli->index = strlen(cli->buffer);
         cli->buffer[cli->index] = '\0';
@@ -588,7 +775,7 @@ static void cli_letf_key(cli_t *cli)
     char ch = '\b';
 
     if (cli->insert) {
-        cli_out_put(cli->port_id, &ch, 1);
+        cli_out_put(cli, &ch, 1);
         cli->insert--;
     }
 }
@@ -599,7 +786,7 @@ static void cli_right_key(cli_t *cli)
 
     if (cli->insert < cli->index) {
         ch = cli->buffer[cli->insert];
-        cli_out_put(cli->port_id, &ch, 1);
+        cli_out_put(cli, &ch, 1);
         cli->insert++;
     }
 }
@@ -643,6 +830,55 @@ static void cli_key_app(cli_t *cli, cli_key_t key)
     }
 }
 
+/**
+ * @brief batch mode: the line is split and the name hashed as it arrives
+ */
+static void cli_batch_char(cli_t *cli, char data)
+{
+    if (CLI_ENTER_KEY == data || CLI_ENTER2_KEY == data) {
+        if (cli->argc) {
+            if (CLI_BUFFER_SIZE < cli->index) {
+                cli->index = CLI_BUFFER_SIZE;
+            }
+            cli->buffer[cli->index] = '\0';
+            if (OPRT_OK != cli_cmd_exec(cli->argc, cli->argv, cli->hash)) {
+                cli_print_string(cli, "No command or file name");
+            }
+            cli_print_prompt(cli);
+        }
+        cli->index = 0;
+        cli->argc = 0;
+        cli->in_arg = 0;
+        cli->hash = CLI_HASH_INIT;
+        return;
+    }
+
+    if (' ' == data || CLI_TABLE_KEY == data) {
+        //! a full line keeps its last argument open, Enter terminates it
+        if (!cli->in_arg || CLI_BUFFER_SIZE - 1 < cli->index) {
+            return;
+        }
+        cli->buffer[cli->index++] = '\0';
+        cli->in_arg = 0;
+        return;
+    }
+
+    if (!((32 <= data) && (data < 127)) || CLI_BUFFER_SIZE - 1 < cli->index) {
+        return;
+    }
+    if (!cli->in_arg) {
+        if (CLI_ARGV_NUM == cli->argc) {
+            return;
+        }
+        cli->argv[cli->argc++] = &cli->buffer[cli->index];
+        cli->in_arg = 1;
+    }
+    if (1 == cli->argc) {
+        cli->hash = CLI_HASH_STEP(cli->hash, data);
+    }
+    cli->buffer[cli->index++] = data;
+}
+
 static void cli_task(void *parameter)
 {
     cli_t *cli;
@@ -655,12 +891,21 @@ static void cli_task(void *parameter)
     cli->echo = 1;
 
     for (;;) {
-        cli_key_detect(cli->port_id, &data, &key);
+        if (cli->batch) {
+            data = cli_getc(cli);
+            if (cli->batch) {
+                cli_batch_char(cli, data);
+                continue;
+            }
+            //! batch mode ended while waiting, the byte is read again as typed
+            cli->rx_pos--;
+        }
+        cli_key_detect(cli, &data, &key);
         if (CLI_NULL_KEY != key) {
             cli_key_app(cli, key);
             continue;
         }
-        if (!((32 <= data) && (127 >= data))) {
+        if (!((32 <= data) && (data < 127))) {
             continue;
         }
         if (CLI_BUFFER_SIZE - 1 < cli->index) {
@@ -670,12 +915,12 @@ static void cli_task(void *parameter)
             memmove(&cli->buffer[cli->insert + 1], &cli->buffer[cli->insert], cli->index - cli->insert);
             cli->buffer[cli->insert] = data;
             cli->index++;
-            cli_out_put(cli->port_id, &cli->buffer[cli->insert], cli->index - cli->insert);
+            cli_out_put(cli, &cli->buffer[cli->insert], cli->index - cli->insert);
             int i;
             char ch = '\b';
             cli->insert++;
             for (i = 0; i < (cli->index - cli->insert); i++) {
-                cli_out_put(cli->port_id, &ch, 1);
+                cli_out_put(cli, &ch, 1);
             }
             continue;
         } else {
@@ -683,7 +928,36 @@ static void cli_task(void *parameter)
             cli->insert = cli->index;
         }
         if (cli->echo) {
-            cli_out_put(cli->port_id, &data, 1);
+            cli_out_put(cli, &data, 1);
+        }
+    }
+}
+
+static void cli_cmd_time(int argc, char *argv[])
+{
+    char line[CLI_CMD_NAME_MAX + 48];
+    cli_cmd_entry_t *entry;
+    int i;
+
+    if (argc > 1 && 0 == strcmp(argv[1], "clear")) {
+        for (i = 0; i < CLI_CMD_HASH_NUM; i++) {
+            for (entry = s_cli_hash[i]; entry; entry = entry->next) {
+                memset(&entry->stat, 0, sizeof(cli_cmd_stat_t));
+            }
+        }
+        return;
+    }
+
+    snprintf(line, sizeof(line), "%-*s %10s %10s %8s", CLI_CMD_NAME_MAX, "cmd", "calls", "total ms", "max ms");
+    cli_print_string(s_cli_handle, line);
+    for (i = 0; i < CLI_CMD_HASH_NUM; i++) {
+        for (entry = s_cli_hash[i]; entry; entry = entry->next) {
+            if (0 == entry->stat.calls) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "%-*.*s %10u %10u %8u", CLI_CMD_NAME_MAX, CLI_CMD_NAME_MAX, entry->cmd->name,
+                     (unsigned)entry->stat.calls, (unsigned)entry->stat.total_ms, (unsigned)entry->stat.max_ms);
+            cli_print_string(s_cli_handle, line);
         }
     }
 }
@@ -691,6 +965,12 @@ static void cli_task(void *parameter)
 static int cli_cmd_register(cli_cmd_t *cmd, uint8_t num)
 {
     int i = 0;
+    cli_cmd_entry_t *entry;
+
+    entry = cli_cmd_index(cmd, num);
+    if (NULL == entry) {
+        return OPRT_MALLOC_FAILED;
+    }
 
     for (i = 0; i < CLI_CMD_TABLE_NUM; i++) {
         if (s_cli_static_table[i].cmd) {
@@ -698,14 +978,17 @@ static int cli_cmd_register(cli_cmd_t *cmd, uint8_t num)
         }
         s_cli_static_table[i].cmd = cmd;
         s_cli_static_table[i].num = num;
+        s_cli_static_table[i].entry = entry;
         return OPRT_OK;
     }
     cli_cmd_node_t *node = tal_malloc(sizeof(cli_cmd_node_t));
     if (NULL == node) {
+        //! the index stays, its commands run but are not listed
         return OPRT_MALLOC_FAILED;
     }
     node->table.cmd = cmd;
     node->table.num = num;
+    node->table.entry = entry;
     tuya_slist_add_head(&s_cli_dynamic_table, &node->next);
 
     return OPRT_OK;
@@ -743,6 +1026,70 @@ int tal_cli_cmd_register(const cli_cmd_t *cmd, uint8_t num)
     return cli_cmd_register((cli_cmd_t *)cmd, num);
 }
 
+/**
+ * @brief Switches the CLI between batch and interactive mode.
+ *
+ * @param enable 1 for batch mode: no echo, history, line editing or completion.
+ */
+void tal_cli_batch_mode(uint8_t enable)
+{
+    if (NULL == s_cli_handle) {
+        return;
+    }
+
+    //! a line typed so far is dropped
+    s_cli_handle->index = 0;
+    s_cli_handle->insert = 0;
+    s_cli_handle->argc = 0;
+    s_cli_handle->in_arg = 0;
+    s_cli_handle->hash = CLI_HASH_INIT;
+    s_cli_handle->batch = enable ? 1 : 0;
+}
+
+/**
+ * @brief Gets the execution time of a command.
+ *
+ * @param name Command name.
+ * @param stat Calls and time spent in the command.
+ * @return Returns OPRT_OK on success, OPRT_NOT_FOUND if no command has that name.
+ */
+int tal_cli_cmd_stat_get(const char *name, cli_cmd_stat_t *stat)
+{
+    cli_cmd_entry_t *entry;
+
+    if (NULL == name || NULL == stat) {
+        return OPRT_INVALID_PARM;
+    }
+
+    entry = cli_cmd_find(name, cli_hash(name));
+    if (NULL == entry) {
+        return OPRT_NOT_FOUND;
+    }
+    *stat = entry->stat;
+
+    return OPRT_OK;
+}
+
+static int cli_start(cli_t *cli)
+{
+    int result;
+
+    tal_cli_cmd_register((cli_cmd_t *)&s_cli_cmd, sizeof(s_cli_cmd) / sizeof(s_cli_cmd[0]));
+
+    THREAD_CFG_T param;
+
+    param.priority = THREAD_PRIO_3;
+    param.stackDepth = 3072;
+    param.thrdname = "cli";
+
+    result = tal_thread_create_and_start(&cli->thread, NULL, NULL, cli_task, cli, &param);
+    if (OPRT_OK != result) {
+        PR_ERR("tuya cli create thread failed %d", result);
+    }
+
+    return result;
+}
+
 /**
  * @brief Initializes the CLI (Command Line Interface) with the specified UART
  * number.
@@ -764,6 +1111,9 @@ int tal_cli_init_with_uart(uint8_t uart_num)
     }
     memset(s_cli_handle, 0, sizeof(cli_t));
     s_cli_handle->port_id = uart_num;
+    s_cli_handle->io.read = cli_uart_read;
+    s_cli_handle->io.write = cli_uart_write;
+    s_cli_handle->hash = CLI_HASH_INIT;
     TAL_UART_CFG_T cfg = {0};
     cfg.base_cfg.baudrate = 115200;
     cfg.base_cfg.databits = TUYA_UART_DATA_LEN_8BIT;
@@ -776,17 +1126,9 @@ int tal_cli_init_with_uart(uint8_t uart_num)
         PR_ERR("uart init failed", result);
         goto __exit;
     }
-    tal_cli_cmd_register((cli_cmd_t *)&s_cli_cmd, 1);
-
-    THREAD_CFG_T param;
-
-    param.priority = THREAD_PRIO_3;
-    param.stackDepth = 3072;
-    param.thrdname = "cli";
 
-    result = tal_thread_create_and_start(&s_cli_handle->thread, NULL, NULL, cli_task, s_cli_handle, &param);
+    result = cli_start(s_cli_handle);
     if (OPRT_OK != result) {
-        PR_ERR("tuya cli create thread failed %d", result);
         goto __exit;
     }
 
@@ -798,6 +1140,39 @@ __exit:
 
     return OPRT_COM_ERROR;
 }
+
+/**
+ * @brief Initializes the CLI on a stream other than a UART.
+ *
+ * @param io Read and write functions of the stream.
+ * @return Returns OPRT_OK if the CLI is successfully initialized, otherwise
+ * returns an error code.
+ */
+int tal_cli_init_with_io(const cli_io_t *io)
+{
+    if (NULL == io || NULL == io->read || NULL == io->write) {
+        return OPRT_INVALID_PARM;
+    }
+    if (s_cli_handle) {
+        return OPRT_OK;
+    }
+    s_cli_handle = tal_malloc(sizeof(cli_t));
+    if (NULL == s_cli_handle) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(s_cli_handle, 0, sizeof(cli_t));
+    s_cli_handle->io = *io;
+    s_cli_handle->hash = CLI_HASH_INIT;
+
+    if (OPRT_OK != cli_start(s_cli_handle)) {
+        tal_free(s_cli_handle);
+        s_cli_handle = NULL;
+        return OPRT_COM_ERROR;
+    }
+
+    return OPRT_OK;
+}
+
 /**
  * @brief Initializes the CLI module.
  *
@@ -0,0 +1,313 @@
+/**
+ * @file test_tal_cli.cpp
+ * @brief Unit tests of the CLI fed with scripted commands through a pseudo UART.
+ *
+ * The CLI is started once with tal_cli_init_with_io on an in-memory stream:
+ * reads take the bytes of the script a test hands over, writes are counted
+ * and captured, both under a mutex as the CLI runs in its own thread. Every
+ * script ends with "ut_done", which releases the test.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tal_api.h"
+#include "tal_cli.h"
+
+#define TEST_CMD_NUM       50
+#define TEST_TABLE_CMD_NUM 10
+#define TEST_LINES         2000
+#define TEST_LINE_SIZE     1200 // longer than the line buffer of the CLI
+#define TEST_DONE_TIMEOUT  5000
+
+/* the pseudo UART */
+typedef struct {
+    MUTEX_HANDLE mutex;
+    std::string data;
+    uint32_t pos;
+    SEM_HANDLE ready;
+    uint32_t out_bytes;
+    std::string out;
+} TEST_UART_T;
+
+static TEST_UART_T *sg_uart; // never freed, the CLI thread outlives the tests
+static SEM_HANDLE sg_done;
+
+static char sg_name[TEST_CMD_NUM][12];
+static cli_cmd_t sg_cmd[TEST_CMD_NUM];
+static uint32_t sg_calls[TEST_CMD_NUM];
+static uint32_t sg_bad_argv;
+static size_t sg_long_len;
+
+static int __uart_read(uint8_t *data, uint32_t len)
+{
+    uint32_t n;
+
+    tal_mutex_lock(sg_uart->mutex);
+    while (sg_uart->pos == sg_uart->data.size()) {
+        tal_mutex_unlock(sg_uart->mutex);
+        tal_semaphore_wait(sg_uart->ready, SEM_WAIT_FOREVER);
+        tal_mutex_lock(sg_uart->mutex);
+    }
+
+    n = sg_uart->data.size() - sg_uart->pos;
+    n = n > len ? len : n;
+    memcpy(data, sg_uart->data.data() + sg_uart->pos, n);
+    sg_uart->pos += n;
+    tal_mutex_unlock(sg_uart->mutex);
+
+    return n;
+}
+
+static int __uart_write(const uint8_t *data, uint32_t len)
+{
+    tal_mutex_lock(sg_uart->mutex);
+    sg_uart->out_bytes += len;
+    sg_uart->out.append((const char *)data, len);
+    tal_mutex_unlock(sg_uart->mutex);
+
+    return len;
+}
+
+static const cli_io_t sg_io = {
+    .read = __uart_read,
+    .write = __uart_write,
+};
+
+/* the commands are called "ut_cmd_<i> <i> <i * 7>" */
+static void __test_cmd(int argc, char *argv[])
+{
+    int i;
+
+    if (3 != argc || 0 != strncmp(argv[0], "ut_cmd_", 7)) {
+        sg_bad_argv++;
+        return;
+    }
+    i = atoi(argv[0] + 7);
+    if (i < 0 || i >= TEST_CMD_NUM || atoi(argv[1]) != i || atoi(argv[2]) != i * 7) {
+        sg_bad_argv++;
+        return;
+    }
+    sg_calls[i]++;
+}
+
+static void __test_long(int argc, char *argv[])
+{
+    sg_long_len = (2 == argc) ? strlen(argv[1]) : 0;
+}
+
+static void __test_done(int argc, char *argv[])
+{
+    tal_semaphore_post(sg_done);
+}
+
+static const cli_cmd_t sg_test_cmd[] = {
+    {
+        .name = (char *)"ut_long",
+        .help = (char *)"length of the one argument",
+        .func = __test_long,
+    },
+    {
+        .name = (char *)"ut_done",
+        .help = (char *)"end of a test script",
+        .func = __test_done,
+    },
+};
+
+class CliTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite()
+    {
+        int i;
+
+        sg_uart = new TEST_UART_T();
+        tal_mutex_create_init(&sg_uart->mutex);
+        tal_semaphore_create_init(&sg_uart->ready, 0, 1);
+        tal_semaphore_create_init(&sg_done, 0, 1);
+        for (i = 0; i < TEST_CMD_NUM; i++) {
+            snprintf(sg_name[i], sizeof(sg_name[i]), "ut_cmd_%03d", i);
+            sg_cmd[i].name = sg_name[i];
+            sg_cmd[i].help = (char *)"test command";
+            sg_cmd[i].func = __test_cmd;
+        }
+        for (i = 0; i < TEST_CMD_NUM; i += TEST_TABLE_CMD_NUM) {
+            tal_cli_cmd_register(&sg_cmd[i], TEST_TABLE_CMD_NUM);
+        }
+        tal_cli_cmd_register(sg_test_cmd, CNTSOF(sg_test_cmd));
+        ASSERT_EQ(OPRT_OK, tal_cli_init_with_io(&sg_io));
+    }
+
+    void SetUp() override
+    {
+        memset(sg_calls, 0, sizeof(sg_calls));
+        sg_bad_argv = 0;
+        sg_long_len = 0;
+        tal_mutex_lock(sg_uart->mutex);
+        sg_uart->out_bytes = 0;
+        sg_uart->out.clear();
+        tal_mutex_unlock(sg_uart->mutex);
+    }
+
+    void TearDown() override
+    {
+        tal_cli_batch_mode(0);
+    }
+
+    /* hands a script to the CLI and waits for its last line, "ut_done" */
+    static OPERATE_RET run(const std::string &script)
+    {
+        tal_mutex_lock(sg_uart->mutex);
+        sg_uart->data = script;
+        sg_uart->pos = 0;
+        tal_mutex_unlock(sg_uart->mutex);
+        tal_semaphore_post(sg_uart->ready);
+
+        return tal_semaphore_wait(sg_done, TEST_DONE_TIMEOUT);
+    }
+
+    /* hands over bytes that do not end with "ut_done" and waits until they are read */
+    static void feed(const std::string &script)
+    {
+        uint32_t left;
+
+        tal_mutex_lock(sg_uart->mutex);
+        sg_uart->data = script;
+        sg_uart->pos = 0;
+        tal_mutex_unlock(sg_uart->mutex);
+        tal_semaphore_post(sg_uart->ready);
+
+        do {
+            tal_system_sleep(1);
+            tal_mutex_lock(sg_uart->mutex);
+            left = sg_uart->data.size() - sg_uart->pos;
+            tal_mutex_unlock(sg_uart->mutex);
+        } while (left);
+        tal_system_sleep(10);
+    }
+
+    /* what the CLI has written back since SetUp */
+    static std::string output(uint32_t *bytes)
+    {
+        tal_mutex_lock(sg_uart->mutex);
+        std::string out = sg_uart->out;
+        *bytes = sg_uart->out_bytes;
+        tal_mutex_unlock(sg_uart->mutex);
+
+        return out;
+    }
+
+    /* TEST_LINES commands with extra spaces, tabs and empty lines */
+    static std::string script(uint32_t *calls)
+    {
+        static const char *space[] = {" ", "  ", " \t "};
+        std::string text;
+        uint32_t seed = 1;
+        char line[48];
+        int i, cmd;
+
+        for (i = 0; i < TEST_LINES; i++) {
+            seed = seed * 1103515245 + 12345;
+            cmd = (seed >> 16) % TEST_CMD_NUM;
+            calls[cmd]++;
+            snprintf(line, sizeof(line), "%sut_cmd_%03d%s%d %d\r\n", (i % 5) ? "" : " ", cmd, space[i % 3], cmd,
+                     cmd * 7);
+            text += line;
+            if (0 == i % 50) {
+                text += '\n';
+            }
+        }
+
+        return text + "ut_done\r";
+    }
+};
+
+TEST_F(CliTest, ScriptedCommands)
+{
+    uint32_t calls[TEST_CMD_NUM] = {0};
+    std::string text = script(calls);
+    uint32_t bytes;
+
+    ASSERT_EQ(OPRT_OK, run(text)) << "the script did not finish";
+    EXPECT_EQ(0u, sg_bad_argv);
+    for (int i = 0; i < TEST_CMD_NUM; i++) {
+        EXPECT_EQ(calls[i], sg_calls[i]) << sg_name[i];
+    }
+    output(&bytes);
+    RecordProperty("bytes_sent_back", bytes);
+}
+
+TEST_F(CliTest, ScriptedCommandsBatch)
+{
+    uint32_t calls[TEST_CMD_NUM] = {0};
+    std::string text = script(calls);
+    uint32_t interactive_bytes, bytes;
+
+    ASSERT_EQ(OPRT_OK, run(text));
+    output(&interactive_bytes);
+
+    SetUp();
+    tal_cli_batch_mode(1);
+    ASSERT_EQ(OPRT_OK, run(text)) << "the script did not finish in batch mode";
+    EXPECT_EQ(0u, sg_bad_argv);
+    for (int i = 0; i < TEST_CMD_NUM; i++) {
+        EXPECT_EQ(calls[i], sg_calls[i]) << sg_name[i];
+    }
+    output(&bytes);
+    EXPECT_LT(bytes, interactive_bytes) << "batch mode still echoes the script";
+    RecordProperty("batch_bytes_sent_back", bytes);
+}
+
+TEST_F(CliTest, BatchLongLineTruncated)
+{
+    std::string text = "ut_long " + std::string(TEST_LINE_SIZE, 'y') + " \t " + std::string(16, 'z') + "\r";
+
+    tal_cli_batch_mode(1);
+    ASSERT_EQ(OPRT_OK, run(text + "ut_cmd_001 1 7\rut_done\r"));
+    EXPECT_GT(sg_long_len, 0u) << "the long line did not run";
+    EXPECT_LT(sg_long_len, (size_t)TEST_LINE_SIZE) << "the argument was not cut at the line buffer";
+    EXPECT_EQ(1u, sg_calls[1]) << "the line after the long one was lost";
+    EXPECT_EQ(0u, sg_bad_argv);
+}
+
+TEST_F(CliTest, CompletionAndStats)
+{
+    cli_cmd_stat_t before, after;
+    uint32_t bytes;
+
+    ASSERT_EQ(OPRT_OK, tal_cli_cmd_stat_get("ut_cmd_002", &before));
+    ASSERT_EQ(OPRT_OK, run("hel\t\rut_cmd_002 2 14\rut_done\r"));
+    EXPECT_NE(std::string::npos, output(&bytes).find("helo world")) << "\"hel<tab>\" did not complete to hello";
+
+    ASSERT_EQ(OPRT_OK, tal_cli_cmd_stat_get("ut_cmd_002", &after));
+    EXPECT_EQ(before.calls + 1, after.calls);
+    EXPECT_NE(OPRT_OK, tal_cli_cmd_stat_get("ut_cmd_none", &after));
+}
+
+TEST_F(CliTest, CompletionListsMatches)
+{
+    uint32_t bytes;
+    size_t pos = 0;
+    int rows = 0;
+
+    //! the tab does not end a line, the CLI is done when it reads the rest
+    feed("ut_cmd_04\t");
+    std::string out = output(&bytes);
+    while (std::string::npos != (pos = out.find("\r\nut_cmd_04", pos))) {
+        rows++;
+        pos++;
+    }
+    EXPECT_EQ(TEST_TABLE_CMD_NUM, rows) << out;
+
+    ASSERT_EQ(OPRT_OK, run("9 49 343\rut_done\r"));
+    EXPECT_EQ(1u, sg_calls[49]) << "the completed line did not run ut_cmd_049";
+    EXPECT_EQ(0u, sg_bad_argv);
+}
@@ -329,6 +329,20 @@ OPERATE_RET tal_sha256_mac_free(tal_hash_mac_context_t *hmac_handle);
  * tuya_error_code.h
  */
 OPERATE_RET tal_sha256_mac_starts(tal_hash_mac_context_t *hmac_handle, const uint8_t *key, size_t keylen);
+/**
+ * @brief This function restarts a sha256 mac calculation with the key
+ *                 already bound by tal_sha256_mac_starts().
+ *
+ * @param[in] hmac_handle: The context to use. It must have been started
+ *                 with a key at least once.
+ *
+ * @note The key is not hashed or padded again, use it to sign many
+ *       messages with one long-lived context (per session or per peer).
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_sha256_mac_reset(tal_hash_mac_context_t *hmac_handle);
 /**
  * @brief This function feeds an input buffer into an ongoing
  *                 sha256 mac checksum calculation.
@@ -420,6 +434,20 @@ OPERATE_RET tal_sha1_mac_free(tal_hash_mac_context_t *hmac_handle);
  * tuya_error_code.h
  */
 OPERATE_RET tal_sha1_mac_starts(tal_hash_mac_context_t *hmac_handle, const uint8_t *key, size_t keylen);
+/**
+ * @brief This function restarts a sha1 mac calculation with the key
+ *                 already bound by tal_sha1_mac_starts().
+ *
+ * @param[in] hmac_handle: The context to use. It must have been started
+ *                 with a key at least once.
+ *
+ * @note The key is not hashed or padded again, use it to sign many
+ *       messages with one long-lived context (per session or per peer).
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_sha1_mac_reset(tal_hash_mac_context_t *hmac_handle);
 /**
  * @brief This function feeds an input buffer into an ongoing
  *                 sha1 mac checksum calculation.
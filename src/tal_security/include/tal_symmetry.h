@@ -37,6 +37,18 @@ typedef enum {
     SYMMETRY_ENCRYPT = 1,
 } TAL_SYMMETRY_CRYPT_MODE;
 
+typedef struct {
+    TKL_SYMMETRY_HANDLE enc; /*!< expanded encryption key, created on first use */
+    TKL_SYMMETRY_HANDLE dec; /*!< expanded decryption key, created on first use */
+    uint32_t keybits;        /*!< 128, 192 or 256, 0 if no key is bound */
+    uint8_t key[32];         /*!< raw key, kept to expand the other direction lazily */
+} tal_aes_key_context_t;
+
+typedef struct {
+    const uint8_t *data; /*!< segment start */
+    size_t len;          /*!< segment length in bytes, any size */
+} tal_symmetry_iov_t;
+
 /**
  * @brief This function Create&initializes a aes context.
  *
@@ -406,6 +418,155 @@ OPERATE_RET tal_aes128_cbc_decode(uint8_t *data, uint32_t len, uint8_t *key, uin
  */
 OPERATE_RET tal_aes_free_data(uint8_t *data);
 
+/**
+ * @brief Initializes a keyed AES context.
+ *
+ * A keyed context keeps the expanded encryption and decryption keys across
+ * calls, so a session or peer pays for the key schedule once instead of on
+ * every message as the tal_aes128_xxx / tal_aes256_xxx helpers do.
+ *
+ * @param[out] key_ctx: The keyed context to initialize.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_init(tal_aes_key_context_t *key_ctx);
+
+/**
+ * @brief Binds a key to a keyed AES context.
+ *
+ * The key schedule of each direction is expanded the first time it is used.
+ * Calling it again re-keys the context in place without reallocating it.
+ *
+ * @param[in] key_ctx: The keyed context, initialized by tal_aes_key_init().
+ * @param[in] key:     The key.
+ * @param[in] keybits: 128, 192 or 256.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_setkey(tal_aes_key_context_t *key_ctx, const uint8_t *key, uint32_t keybits);
+
+/**
+ * @brief Releases a keyed AES context and wipes the key material.
+ *
+ * @param[in] key_ctx: The keyed context.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_free(tal_aes_key_context_t *key_ctx);
+
+/**
+ * @brief AES-ECB on full blocks with a keyed context.
+ *
+ * @param[in] key_ctx: The keyed context, bound to a key.
+ * @param[in] mode:    SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in] length:  Length in bytes, a multiple of 16.
+ * @param[in] input:   Input data.
+ * @param[out] output: Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_ecb(tal_aes_key_context_t *key_ctx, int32_t mode, size_t length, const uint8_t *input,
+                                  uint8_t *output);
+
+/**
+ * @brief AES-CBC on full blocks with a keyed context.
+ *
+ * @param[in] key_ctx:   The keyed context, bound to a key.
+ * @param[in] mode:      SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in] length:    Length in bytes, a multiple of 16.
+ * @param[in,out] iv:    Initialization vector, updated after use so that
+ *                       consecutive calls continue the same stream.
+ * @param[in] input:     Input data.
+ * @param[out] output:   Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_cbc(tal_aes_key_context_t *key_ctx, int32_t mode, size_t length, uint8_t iv[16],
+                                  const uint8_t *input, uint8_t *output);
+
+/**
+ * @brief AES-CTR with a keyed context.
+ *
+ * @param[in] key_ctx:          The keyed context, bound to a key.
+ * @param[in] length:           Length in bytes, any size.
+ * @param[in,out] nc_off:       Offset in the current stream block.
+ * @param[in,out] nonce_counter: 128-bit nonce and counter.
+ * @param[in,out] stream_block: Saved stream block for resuming.
+ * @param[in] input:            Input data.
+ * @param[out] output:          Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_ctr(tal_aes_key_context_t *key_ctx, size_t length, size_t *nc_off,
+                                  uint8_t nonce_counter[16], uint8_t stream_block[16], const uint8_t *input,
+                                  uint8_t *output);
+
+/**
+ * @brief AES-CBC over a scatter list with a keyed context.
+ *
+ * The segments are processed as one continuous stream, they may have any
+ * length as long as the total is a multiple of 16. Blocks straddling two
+ * segments are staged on the stack, everything else is processed in place
+ * from the caller buffers, nothing is allocated.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in] mode:     SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in,out] iv:   Initialization vector, updated after use.
+ * @param[in] iov:      Input segments.
+ * @param[in] iov_cnt:  Number of segments.
+ * @param[out] output:  Contiguous output, must not overlap the segments
+ *                      unless \p iov_cnt is 1.
+ * @param[in] out_size: Size of \p output in bytes.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_cbc_iov(tal_aes_key_context_t *key_ctx, int32_t mode, uint8_t iv[16],
+                                      const tal_symmetry_iov_t *iov, uint32_t iov_cnt, uint8_t *output,
+                                      size_t out_size);
+
+/**
+ * @brief PKCS7-pads and encrypts data into a caller buffer.
+ *
+ * Replaces the tal_aes128_ecb_encode / tal_aes128_cbc_encode pattern without
+ * the output allocation. Only the final partial block is copied.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in,out] iv:   CBC initialization vector, updated after use, or NULL for ECB.
+ * @param[in] data:     Plain data.
+ * @param[in] len:      Plain data length.
+ * @param[out] output:  Cipher output, may be the same buffer as \p data.
+ * @param[in] out_size: Size of \p output, at least (len / 16 + 1) * 16.
+ * @param[out] out_len: Cipher length.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_pkcs7_encode(tal_aes_key_context_t *key_ctx, uint8_t iv[16], const uint8_t *data,
+                                     uint32_t len, uint8_t *output, uint32_t out_size, uint32_t *out_len);
+
+/**
+ * @brief Decrypts data into a caller buffer and strips the PKCS7 padding.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in,out] iv:   CBC initialization vector, updated after use, or NULL for ECB.
+ * @param[in] data:     Cipher data.
+ * @param[in] len:      Cipher length, a multiple of 16.
+ * @param[out] output:  Plain output of at least \p len bytes, may be the same buffer as \p data.
+ * @param[out] out_len: Plain length without padding.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_pkcs7_decode(tal_aes_key_context_t *key_ctx, uint8_t iv[16], const uint8_t *data,
+                                     uint32_t len, uint8_t *output, uint32_t *out_len);
+
 /**
  * @brief Performs a self-test for the AES encryption algorithm.
  *
@@ -507,6 +507,33 @@ cleanup:
 
     return (ret);
 }
+/**
+ * @brief This function restarts a sha256 mac calculation with the key
+ *                 already bound by tal_sha256_mac_starts().
+ *
+ * @param[in] hmac_handle: The context to use. It must have been started
+ *                 with a key at least once.
+ *
+ * @note The key is not hashed or padded again, use it to sign many
+ *       messages with one long-lived context (per session or per peer).
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_sha256_mac_reset(tal_hash_mac_context_t *hmac_handle)
+{
+    OPERATE_RET ret = OPRT_COM_ERROR;
+
+    if (hmac_handle == NULL || hmac_handle->ctx == NULL) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if ((ret = tal_sha256_starts_ret(hmac_handle->ctx, 0)) != OPRT_OK) {
+        return ret;
+    }
+
+    return tal_sha256_update_ret(hmac_handle->ctx, hmac_handle->ipad, 64);
+}
 /**
  * @brief This function feeds an input buffer into an ongoing
  *                 sha256 mac checksum calculation.
@@ -716,6 +743,33 @@ cleanup:
 
     return (ret);
 }
+/**
+ * @brief This function restarts a sha1 mac calculation with the key
+ *                 already bound by tal_sha1_mac_starts().
+ *
+ * @param[in] hmac_handle: The context to use. It must have been started
+ *                 with a key at least once.
+ *
+ * @note The key is not hashed or padded again, use it to sign many
+ *       messages with one long-lived context (per session or per peer).
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_sha1_mac_reset(tal_hash_mac_context_t *hmac_handle)
+{
+    OPERATE_RET ret = OPRT_COM_ERROR;
+
+    if (hmac_handle == NULL || hmac_handle->ctx == NULL) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if ((ret = tal_sha1_starts_ret(hmac_handle->ctx)) != OPRT_OK) {
+        return ret;
+    }
+
+    return tal_sha1_update_ret(hmac_handle->ctx, hmac_handle->ipad, 64);
+}
 /**
  * @brief This function feeds an input buffer into an ongoing
  *                 sha1 mac checksum calculation.
@@ -729,6 +729,403 @@ OPERATE_RET tal_aes_free_data(uint8_t *data)
     return OPRT_OK;
 }
 
+/**
+ * @brief Returns the expanded key handle for one direction, expanding it on
+ * first use.
+ */
+static OPERATE_RET __aes_key_handle(tal_aes_key_context_t *key_ctx, int32_t mode, TKL_SYMMETRY_HANDLE *handle)
+{
+    OPERATE_RET ret = OPRT_OK;
+    TKL_SYMMETRY_HANDLE *slot = NULL;
+
+    if (NULL == key_ctx || 0 == key_ctx->keybits) {
+        return OPRT_INVALID_PARM;
+    }
+
+    slot = (mode == SYMMETRY_ENCRYPT) ? &key_ctx->enc : &key_ctx->dec;
+    if (NULL == *slot) {
+        if ((ret = tal_aes_create_init(slot)) != OPRT_OK) {
+            *slot = NULL;
+            return ret;
+        }
+
+        if (mode == SYMMETRY_ENCRYPT) {
+            ret = tal_aes_setkey_enc(*slot, key_ctx->key, key_ctx->keybits);
+        } else {
+            ret = tal_aes_setkey_dec(*slot, key_ctx->key, key_ctx->keybits);
+        }
+        if (ret != OPRT_OK) {
+            tal_aes_free(*slot);
+            *slot = NULL;
+            return ret;
+        }
+    }
+
+    *handle = *slot;
+    return OPRT_OK;
+}
+
+/**
+ * @brief Initializes a keyed AES context.
+ *
+ * @param[out] key_ctx: The keyed context to initialize.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_init(tal_aes_key_context_t *key_ctx)
+{
+    if (NULL == key_ctx) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memset(key_ctx, 0, sizeof(tal_aes_key_context_t));
+    return OPRT_OK;
+}
+
+/**
+ * @brief Binds a key to a keyed AES context, re-expanding the directions
+ * already in use.
+ *
+ * @param[in] key_ctx: The keyed context.
+ * @param[in] key:     The key.
+ * @param[in] keybits: 128, 192 or 256.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_setkey(tal_aes_key_context_t *key_ctx, const uint8_t *key, uint32_t keybits)
+{
+    OPERATE_RET ret = OPRT_OK;
+
+    if (NULL == key_ctx || NULL == key || (keybits != 128 && keybits != 192 && keybits != 256)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memset(key_ctx->key, 0, sizeof(key_ctx->key));
+    memcpy(key_ctx->key, key, keybits / 8);
+    key_ctx->keybits = keybits;
+
+    if (key_ctx->enc && (ret = tal_aes_setkey_enc(key_ctx->enc, key_ctx->key, keybits)) != OPRT_OK) {
+        goto exit;
+    }
+
+    if (key_ctx->dec && (ret = tal_aes_setkey_dec(key_ctx->dec, key_ctx->key, keybits)) != OPRT_OK) {
+        goto exit;
+    }
+
+exit:
+    if (ret != OPRT_OK) {
+        key_ctx->keybits = 0;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Releases a keyed AES context and wipes the key material.
+ *
+ * @param[in] key_ctx: The keyed context.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_free(tal_aes_key_context_t *key_ctx)
+{
+    OPERATE_RET ret = OPRT_OK;
+
+    if (NULL == key_ctx) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (key_ctx->enc) {
+        ret |= tal_aes_free(key_ctx->enc);
+    }
+
+    if (key_ctx->dec) {
+        ret |= tal_aes_free(key_ctx->dec);
+    }
+
+    memset(key_ctx, 0, sizeof(tal_aes_key_context_t));
+
+    return ret;
+}
+
+/**
+ * @brief AES-ECB on full blocks with a keyed context.
+ *
+ * @param[in] key_ctx: The keyed context, bound to a key.
+ * @param[in] mode:    SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in] length:  Length in bytes, a multiple of 16.
+ * @param[in] input:   Input data.
+ * @param[out] output: Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_ecb(tal_aes_key_context_t *key_ctx, int32_t mode, size_t length, const uint8_t *input,
+                                  uint8_t *output)
+{
+    OPERATE_RET ret;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+
+    if ((ret = __aes_key_handle(key_ctx, mode, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    return tal_aes_crypt_ecb(handle, mode, length, (uint8_t *)input, output);
+}
+
+/**
+ * @brief AES-CBC on full blocks with a keyed context.
+ *
+ * @param[in] key_ctx: The keyed context, bound to a key.
+ * @param[in] mode:    SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in] length:  Length in bytes, a multiple of 16.
+ * @param[in,out] iv:  Initialization vector, updated after use.
+ * @param[in] input:   Input data.
+ * @param[out] output: Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_cbc(tal_aes_key_context_t *key_ctx, int32_t mode, size_t length, uint8_t iv[16],
+                                  const uint8_t *input, uint8_t *output)
+{
+    OPERATE_RET ret;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+
+    if ((ret = __aes_key_handle(key_ctx, mode, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    return tal_aes_crypt_cbc(handle, mode, length, iv, (uint8_t *)input, output);
+}
+
+/**
+ * @brief AES-CTR with a keyed context, CTR only uses the encryption key.
+ *
+ * @param[in] key_ctx:           The keyed context, bound to a key.
+ * @param[in] length:            Length in bytes, any size.
+ * @param[in,out] nc_off:        Offset in the current stream block.
+ * @param[in,out] nonce_counter: 128-bit nonce and counter.
+ * @param[in,out] stream_block:  Saved stream block for resuming.
+ * @param[in] input:             Input data.
+ * @param[out] output:           Output data, may be the same buffer as \p input.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_ctr(tal_aes_key_context_t *key_ctx, size_t length, size_t *nc_off,
+                                  uint8_t nonce_counter[16], uint8_t stream_block[16], const uint8_t *input,
+                                  uint8_t *output)
+{
+    OPERATE_RET ret;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+
+    if ((ret = __aes_key_handle(key_ctx, SYMMETRY_ENCRYPT, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    return tal_aes_crypt_ctr(handle, length, nc_off, nonce_counter, stream_block, (uint8_t *)input, output);
+}
+
+/**
+ * @brief AES-CBC over a scatter list with a keyed context.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in] mode:     SYMMETRY_ENCRYPT or SYMMETRY_DECRYPT.
+ * @param[in,out] iv:   Initialization vector, updated after use.
+ * @param[in] iov:      Input segments, the total length must be a multiple of 16.
+ * @param[in] iov_cnt:  Number of segments.
+ * @param[out] output:  Contiguous output.
+ * @param[in] out_size: Size of \p output in bytes.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_crypt_cbc_iov(tal_aes_key_context_t *key_ctx, int32_t mode, uint8_t iv[16],
+                                      const tal_symmetry_iov_t *iov, uint32_t iov_cnt, uint8_t *output,
+                                      size_t out_size)
+{
+    OPERATE_RET ret = OPRT_OK;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+    uint8_t block[16];
+    size_t fill = 0, total = 0, off = 0;
+    uint32_t i;
+
+    if (NULL == iv || NULL == output || (NULL == iov && iov_cnt)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    for (i = 0; i < iov_cnt; i++) {
+        total += iov[i].len;
+    }
+    if ((total % 16) != 0 || total > out_size) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if ((ret = __aes_key_handle(key_ctx, mode, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    for (i = 0; i < iov_cnt; i++) {
+        const uint8_t *p = iov[i].data;
+        size_t n = iov[i].len;
+        size_t take;
+
+        // Complete a block left over from the previous segment
+        if (fill) {
+            take = (n < 16 - fill) ? n : 16 - fill;
+            memcpy(block + fill, p, take);
+            fill += take;
+            p += take;
+            n -= take;
+            if (fill < 16) {
+                continue;
+            }
+            if ((ret = tal_aes_crypt_cbc(handle, mode, 16, iv, block, output + off)) != OPRT_OK) {
+                goto exit;
+            }
+            off += 16;
+            fill = 0;
+        }
+
+        // Full blocks straight from the caller buffer
+        take = n & ~(size_t)0x0F;
+        if (take) {
+            if ((ret = tal_aes_crypt_cbc(handle, mode, take, iv, (uint8_t *)p, output + off)) != OPRT_OK) {
+                goto exit;
+            }
+            off += take;
+            p += take;
+            n -= take;
+        }
+
+        if (n) {
+            memcpy(block, p, n);
+            fill = n;
+        }
+    }
+
+exit:
+    memset(block, 0, sizeof(block));
+
+    return ret;
+}
+
+/**
+ * @brief PKCS7-pads and encrypts data into a caller buffer.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in,out] iv:   CBC initialization vector, or NULL for ECB.
+ * @param[in] data:     Plain data.
+ * @param[in] len:      Plain data length.
+ * @param[out] output:  Cipher output, may be the same buffer as \p data.
+ * @param[in] out_size: Size of \p output.
+ * @param[out] out_len: Cipher length.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_pkcs7_encode(tal_aes_key_context_t *key_ctx, uint8_t iv[16], const uint8_t *data,
+                                     uint32_t len, uint8_t *output, uint32_t out_size, uint32_t *out_len)
+{
+    OPERATE_RET ret = OPRT_OK;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+    uint8_t block[16];
+    uint32_t full = len & ~0x0FU;
+    uint32_t tail = len - full;
+
+    if ((NULL == data && len) || NULL == output || NULL == out_len || out_size < full + 16) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if ((ret = __aes_key_handle(key_ctx, SYMMETRY_ENCRYPT, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    // Stage the padded tail first, in place encoding overwrites it otherwise
+    if (tail) {
+        memcpy(block, data + full, tail);
+    }
+    add_pkcs_padding(block, 16, tail);
+
+    if (full) {
+        if (iv) {
+            ret = tal_aes_crypt_cbc(handle, SYMMETRY_ENCRYPT, full, iv, (uint8_t *)data, output);
+        } else {
+            ret = tal_aes_crypt_ecb(handle, SYMMETRY_ENCRYPT, full, (uint8_t *)data, output);
+        }
+        if (ret != OPRT_OK) {
+            goto exit;
+        }
+    }
+
+    if (iv) {
+        ret = tal_aes_crypt_cbc(handle, SYMMETRY_ENCRYPT, 16, iv, block, output + full);
+    } else {
+        ret = tal_aes_crypt_ecb(handle, SYMMETRY_ENCRYPT, 16, block, output + full);
+    }
+    if (ret != OPRT_OK) {
+        goto exit;
+    }
+
+    *out_len = full + 16;
+
+exit:
+    memset(block, 0, sizeof(block));
+
+    return ret;
+}
+
+/**
+ * @brief Decrypts data into a caller buffer and strips the PKCS7 padding.
+ *
+ * @param[in] key_ctx:  The keyed context, bound to a key.
+ * @param[in,out] iv:   CBC initialization vector, or NULL for ECB.
+ * @param[in] data:     Cipher data.
+ * @param[in] len:      Cipher length, a multiple of 16.
+ * @param[out] output:  Plain output of at least \p len bytes.
+ * @param[out] out_len: Plain length without padding.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tal_aes_key_pkcs7_decode(tal_aes_key_context_t *key_ctx, uint8_t iv[16], const uint8_t *data,
+                                     uint32_t len, uint8_t *output, uint32_t *out_len)
+{
+    OPERATE_RET ret = OPRT_OK;
+    TKL_SYMMETRY_HANDLE handle = NULL;
+    uint8_t pad;
+
+    if (NULL == data || NULL == output || NULL == out_len || 0 == len || (len % 16) != 0) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if ((ret = __aes_key_handle(key_ctx, SYMMETRY_DECRYPT, &handle)) != OPRT_OK) {
+        return ret;
+    }
+
+    if (iv) {
+        ret = tal_aes_crypt_cbc(handle, SYMMETRY_DECRYPT, len, iv, (uint8_t *)data, output);
+    } else {
+        ret = tal_aes_crypt_ecb(handle, SYMMETRY_DECRYPT, len, (uint8_t *)data, output);
+    }
+    if (ret != OPRT_OK) {
+        return ret;
+    }
+
+    // unlike tal_aes_get_actual_length, a block of padding only is empty data, as encoded above
+    pad = output[len - 1];
+    if (pad > 16) {
+        return OPRT_COM_ERROR;
+    }
+
+    *out_len = len - pad;
+    return OPRT_OK;
+}
+
 #if defined(ENABLE_TAL_SECURITY_SELF_TEST)
 /*
  * AES test vectors from:
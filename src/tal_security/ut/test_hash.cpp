@@ -0,0 +1,112 @@
+/**
+ * @file test_hash.cpp
+ * @brief Unit tests of the HMAC contexts restarted with their bound key
+ * against the one-shot HMAC helpers and the RFC 2202 / RFC 4231 vectors.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tal_hash.h"
+
+#define CHECK_LEN 300
+
+// RFC 4231 test case 2 and RFC 2202 test case 2
+static const char sg_rfc_key[] = "Jefe";
+static const char sg_rfc_data[] = "what do ya want for nothing?";
+static const uint8_t sg_rfc_sha256[32] = {0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24,
+                                          0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27,
+                                          0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43};
+static const uint8_t sg_rfc_sha1[20] = {0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74,
+                                        0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c, 0x25, 0x9a, 0x7c, 0x79};
+
+class HashMacTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        msg.resize(CHECK_LEN);
+        for (uint32_t i = 0; i < msg.size(); i++) {
+            msg[i] = (uint8_t)((i * 2654435761u) >> 13);
+        }
+        // longer than a block, so the key is hashed first
+        long_key.assign(msg.begin(), msg.begin() + 100);
+    }
+
+    std::vector<uint8_t> msg;
+    std::vector<uint8_t> long_key;
+};
+
+TEST_F(HashMacTest, KnownValue)
+{
+    tal_hash_mac_context_t hmac;
+    uint8_t out[32];
+
+    ASSERT_EQ(OPRT_OK, tal_sha256_mac((const uint8_t *)sg_rfc_key, strlen(sg_rfc_key), (const uint8_t *)sg_rfc_data,
+                                      strlen(sg_rfc_data), out));
+    EXPECT_EQ(0, memcmp(sg_rfc_sha256, out, 32));
+
+    ASSERT_EQ(OPRT_OK, tal_sha1_mac((const uint8_t *)sg_rfc_key, strlen(sg_rfc_key), (const uint8_t *)sg_rfc_data,
+                                    strlen(sg_rfc_data), out));
+    EXPECT_EQ(0, memcmp(sg_rfc_sha1, out, 20));
+
+    // a reset context gives the same MAC a second time
+    ASSERT_EQ(OPRT_OK, tal_sha256_mac_create_init(&hmac));
+    ASSERT_EQ(OPRT_OK, tal_sha256_mac_starts(&hmac, (const uint8_t *)sg_rfc_key, strlen(sg_rfc_key)));
+    for (int round = 0; round < 2; round++) {
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_reset(&hmac));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_update(&hmac, (const uint8_t *)sg_rfc_data, strlen(sg_rfc_data)));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_finish(&hmac, out));
+        EXPECT_EQ(0, memcmp(sg_rfc_sha256, out, 32)) << "round " << round;
+    }
+    tal_sha256_mac_free(&hmac);
+}
+
+TEST_F(HashMacTest, Sha256ResetSameAsOneShot)
+{
+    tal_hash_mac_context_t hmac;
+    uint8_t expect[32], out[32];
+
+    ASSERT_EQ(OPRT_OK, tal_sha256_mac_create_init(&hmac));
+    ASSERT_EQ(OPRT_OK, tal_sha256_mac_starts(&hmac, long_key.data(), long_key.size()));
+    for (uint32_t len = 0; len <= CHECK_LEN; len++) {
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac(long_key.data(), long_key.size(), msg.data(), len, expect));
+
+        // one message, and the same message split in two updates
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_reset(&hmac));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_update(&hmac, msg.data(), len));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_finish(&hmac, out));
+        ASSERT_EQ(0, memcmp(expect, out, 32)) << "len " << len;
+
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_reset(&hmac));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_update(&hmac, msg.data(), len / 3));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_update(&hmac, msg.data() + len / 3, len - len / 3));
+        ASSERT_EQ(OPRT_OK, tal_sha256_mac_finish(&hmac, out));
+        ASSERT_EQ(0, memcmp(expect, out, 32)) << "split len " << len;
+    }
+    tal_sha256_mac_free(&hmac);
+}
+
+TEST_F(HashMacTest, Sha1ResetSameAsOneShot)
+{
+    tal_hash_mac_context_t hmac;
+    uint8_t expect[20], out[20];
+
+    ASSERT_EQ(OPRT_OK, tal_sha1_mac_create_init(&hmac));
+    ASSERT_EQ(OPRT_OK, tal_sha1_mac_starts(&hmac, long_key.data(), long_key.size()));
+    for (uint32_t len = 0; len <= CHECK_LEN; len++) {
+        ASSERT_EQ(OPRT_OK, tal_sha1_mac(long_key.data(), long_key.size(), msg.data(), len, expect));
+        ASSERT_EQ(OPRT_OK, tal_sha1_mac_reset(&hmac));
+        ASSERT_EQ(OPRT_OK, tal_sha1_mac_update(&hmac, msg.data(), len));
+        ASSERT_EQ(OPRT_OK, tal_sha1_mac_finish(&hmac, out));
+        ASSERT_EQ(0, memcmp(expect, out, 20)) << "len " << len;
+    }
+    tal_sha1_mac_free(&hmac);
+}
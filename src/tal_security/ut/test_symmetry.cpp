@@ -0,0 +1,220 @@
+/**
+ * @file test_symmetry.cpp
+ * @brief Unit tests of the keyed AES contexts against the one-shot helpers
+ * and the NIST SP 800-38A vectors.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tal_symmetry.h"
+
+#define CHECK_LEN 1024
+
+// SP 800-38A F.2.1 and F.5.1
+static const uint8_t sg_nist_key[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t sg_nist_iv[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                       0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+static const uint8_t sg_nist_ctr[16] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                        0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+static const uint8_t sg_nist_plain[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+static const uint8_t sg_nist_cbc[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7};
+static const uint8_t sg_nist_ctr_out[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+
+class SymmetryTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        plain.resize(CHECK_LEN + 16);
+        for (uint32_t i = 0; i < plain.size(); i++) {
+            plain[i] = (uint8_t)((i * 2654435761u) >> 13);
+        }
+        memcpy(key, sg_nist_key, sizeof(key));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_init(&ctx));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_setkey(&ctx, key, 128));
+    }
+
+    void TearDown() override
+    {
+        tal_aes_key_free(&ctx);
+    }
+
+    std::vector<uint8_t> plain;
+    uint8_t key[16];
+    tal_aes_key_context_t ctx;
+};
+
+TEST_F(SymmetryTest, KnownValue)
+{
+    uint8_t iv[16], nc[16], stream[16], out[64];
+    size_t nc_off = 0;
+
+    memcpy(iv, sg_nist_iv, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_ENCRYPT, 64, iv, sg_nist_plain, out));
+    EXPECT_EQ(0, memcmp(sg_nist_cbc, out, 64));
+    // the iv carries the chain on
+    EXPECT_EQ(0, memcmp(&sg_nist_cbc[48], iv, 16));
+
+    memcpy(iv, sg_nist_iv, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_DECRYPT, 64, iv, sg_nist_cbc, out));
+    EXPECT_EQ(0, memcmp(sg_nist_plain, out, 64));
+
+    memcpy(nc, sg_nist_ctr, sizeof(nc));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_ctr(&ctx, 64, &nc_off, nc, stream, sg_nist_plain, out));
+    EXPECT_EQ(0, memcmp(sg_nist_ctr_out, out, 64));
+}
+
+TEST_F(SymmetryTest, SameAsOneShot)
+{
+    std::vector<uint8_t> expect(CHECK_LEN), out(CHECK_LEN);
+
+    for (uint32_t len = 16; len <= CHECK_LEN; len += 16) {
+        uint8_t iv[16] = {0}, iv_raw[16] = {0};
+
+        ASSERT_EQ(OPRT_OK, tal_aes128_cbc_encode_raw(plain.data(), len, key, iv_raw, expect.data()));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_ENCRYPT, len, iv, plain.data(), out.data()));
+        ASSERT_EQ(0, memcmp(expect.data(), out.data(), len)) << "cbc len " << len;
+
+        ASSERT_EQ(OPRT_OK, tal_aes128_ecb_encode_raw(plain.data(), len, expect.data(), key));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_ecb(&ctx, SYMMETRY_ENCRYPT, len, plain.data(), out.data()));
+        ASSERT_EQ(0, memcmp(expect.data(), out.data(), len)) << "ecb len " << len;
+    }
+}
+
+TEST_F(SymmetryTest, InPlaceAndRekey)
+{
+    std::vector<uint8_t> buf(plain.begin(), plain.begin() + CHECK_LEN), expect(CHECK_LEN);
+    uint8_t other[16] = {0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+                         0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01};
+    uint8_t iv[16] = {0}, iv_raw[16] = {0};
+
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_ENCRYPT, CHECK_LEN, iv, buf.data(), buf.data()));
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_DECRYPT, CHECK_LEN, iv, buf.data(), buf.data()));
+    ASSERT_EQ(0, memcmp(plain.data(), buf.data(), CHECK_LEN));
+
+    // both directions follow a new key
+    ASSERT_EQ(OPRT_OK, tal_aes_key_setkey(&ctx, other, 128));
+    ASSERT_EQ(OPRT_OK, tal_aes128_cbc_encode_raw(plain.data(), CHECK_LEN, other, iv_raw, expect.data()));
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_ENCRYPT, CHECK_LEN, iv, plain.data(), buf.data()));
+    ASSERT_EQ(0, memcmp(expect.data(), buf.data(), CHECK_LEN));
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_DECRYPT, CHECK_LEN, iv, buf.data(), buf.data()));
+    ASSERT_EQ(0, memcmp(plain.data(), buf.data(), CHECK_LEN));
+}
+
+TEST_F(SymmetryTest, CbcIovSameAsContiguous)
+{
+    static const size_t cuts[] = {0, 1, 5, 15, 16, 17, 31, 33, 100};
+    std::vector<uint8_t> expect(CHECK_LEN), out(CHECK_LEN);
+    uint8_t iv[16] = {0};
+
+    ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc(&ctx, SYMMETRY_ENCRYPT, CHECK_LEN, iv, plain.data(), expect.data()));
+
+    // segments of every size in cuts[], repeated until CHECK_LEN, the last one takes the rest
+    for (size_t first = 0; first < CNTSOF(cuts); first++) {
+        std::vector<tal_symmetry_iov_t> iov;
+        size_t off = 0;
+
+        for (size_t i = first; off < CHECK_LEN; i++) {
+            size_t len = cuts[i % CNTSOF(cuts)];
+
+            len = (off + len > CHECK_LEN) ? CHECK_LEN - off : len;
+            iov.push_back({&plain[off], len});
+            off += len;
+        }
+        memset(iv, 0, sizeof(iv));
+        memset(out.data(), 0, CHECK_LEN);
+        ASSERT_EQ(OPRT_OK, tal_aes_key_crypt_cbc_iov(&ctx, SYMMETRY_ENCRYPT, iv, iov.data(), iov.size(), out.data(),
+                                                     out.size()))
+            << "first cut " << first;
+        ASSERT_EQ(0, memcmp(expect.data(), out.data(), CHECK_LEN)) << "first cut " << first;
+    }
+
+    // a total that is not whole blocks, or does not fit the output, is refused
+    tal_symmetry_iov_t odd = {plain.data(), 17};
+    tal_symmetry_iov_t big = {plain.data(), CHECK_LEN};
+    EXPECT_EQ(OPRT_INVALID_PARM, tal_aes_key_crypt_cbc_iov(&ctx, SYMMETRY_ENCRYPT, iv, &odd, 1, out.data(), 32));
+    EXPECT_EQ(OPRT_INVALID_PARM, tal_aes_key_crypt_cbc_iov(&ctx, SYMMETRY_ENCRYPT, iv, &big, 1, out.data(), 16));
+}
+
+TEST_F(SymmetryTest, Pkcs7SameAsAllocating)
+{
+    std::vector<uint8_t> out(CHECK_LEN + 16), dec(CHECK_LEN + 16);
+
+    // the allocating helpers refuse empty data
+    for (uint32_t len = 1; len <= 80; len++) {
+        uint8_t iv[16] = {0}, iv_alloc[16] = {0};
+        uint8_t *ec_data = NULL;
+        uint32_t ec_len = 0, out_len = 0, dec_len = 0;
+
+        ASSERT_EQ(OPRT_OK, tal_aes128_cbc_encode(plain.data(), len, key, iv_alloc, &ec_data, &ec_len));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_encode(&ctx, iv, plain.data(), len, out.data(), out.size(), &out_len));
+        ASSERT_EQ(ec_len, out_len) << "cbc len " << len;
+        ASSERT_EQ(0, memcmp(ec_data, out.data(), ec_len)) << "cbc len " << len;
+        tal_aes_free_data(ec_data);
+
+        memset(iv, 0, sizeof(iv));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_decode(&ctx, iv, out.data(), out_len, dec.data(), &dec_len));
+        ASSERT_EQ(len, dec_len);
+        ASSERT_EQ(0, memcmp(plain.data(), dec.data(), len)) << "cbc len " << len;
+
+        ASSERT_EQ(OPRT_OK, tal_aes128_ecb_encode(plain.data(), len, &ec_data, &ec_len, key));
+        ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_encode(&ctx, NULL, plain.data(), len, out.data(), out.size(), &out_len));
+        ASSERT_EQ(ec_len, out_len) << "ecb len " << len;
+        ASSERT_EQ(0, memcmp(ec_data, out.data(), ec_len)) << "ecb len " << len;
+        tal_aes_free_data(ec_data);
+
+        ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_decode(&ctx, NULL, out.data(), out_len, dec.data(), &dec_len));
+        ASSERT_EQ(len, dec_len);
+    }
+}
+
+TEST_F(SymmetryTest, Pkcs7InPlaceAndBounds)
+{
+    std::vector<uint8_t> buf(plain.begin(), plain.begin() + 64);
+    uint8_t iv[16] = {0};
+    uint32_t out_len = 0, dec_len = 0;
+
+    // 37 bytes encode in place into 48
+    ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_encode(&ctx, iv, buf.data(), 37, buf.data(), 48, &out_len));
+    ASSERT_EQ(48u, out_len);
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_decode(&ctx, iv, buf.data(), 48, buf.data(), &dec_len));
+    ASSERT_EQ(37u, dec_len);
+    EXPECT_EQ(0, memcmp(plain.data(), buf.data(), 37));
+
+    // empty data is a whole padding block
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_encode(&ctx, iv, NULL, 0, buf.data(), 16, &out_len));
+    ASSERT_EQ(16u, out_len);
+    memset(iv, 0, sizeof(iv));
+    ASSERT_EQ(OPRT_OK, tal_aes_key_pkcs7_decode(&ctx, iv, buf.data(), 16, buf.data(), &dec_len));
+    EXPECT_EQ(0u, dec_len);
+
+    // an output without room for the padding block, and cipher text that is not whole blocks
+    EXPECT_EQ(OPRT_INVALID_PARM, tal_aes_key_pkcs7_encode(&ctx, iv, plain.data(), 32, buf.data(), 32, &out_len));
+    EXPECT_EQ(OPRT_INVALID_PARM, tal_aes_key_pkcs7_decode(&ctx, iv, plain.data(), 20, buf.data(), &dec_len));
+}
@@ -13,7 +13,8 @@
  *
  * Included modules cover a wide range of functionalities:
  * - Logging and diagnostics (tal_log.h)
- * - Memory management (tal_memory.h)
+ * - Memory management (tal_memory.h, tal_mem_budget.h)
+ * - Runtime metrics (tal_metrics.h)
  * - Concurrency primitives (tal_mutex.h, tal_semaphore.h, tal_thread.h)
  * - OTA updates (tal_ota.h)
  * - Inter-thread communication (tal_queue.h, tal_workqueue.h)
@@ -43,6 +44,8 @@
 
 #include "tal_log.h"
 #include "tal_memory.h"
+#include "tal_mem_budget.h"
+#include "tal_metrics.h"
 #include "tal_mutex.h"
 #include "tal_ota.h"
 #include "tal_queue.h"
@@ -0,0 +1,224 @@
+/**
+ * @file tal_mem_budget.h
+ * @brief Memory budgets: large buffers charged to the subsystem that owns them.
+ *
+ * A subsystem defines a named budget with TAL_MEM_BUDGET_DEFINE, giving the
+ * most bytes it may hold and where its buffers should go: internal RAM, PSRAM
+ * or RAM that peripherals can DMA from. Buffers taken with
+ * tal_mem_budget_malloc are charged to the budget; a request that would take
+ * it over its limit fails at once, before the heap is touched, so one
+ * subsystem cannot starve the others. Live and peak usage, per RAM, can be
+ * read back per budget or printed for all of them with tal_mem_budget_dump.
+ *
+ * The buffers come from tal_malloc / tal_psram_malloc, so the pool and
+ * profiling layers of tal_memory.h still see them. Each buffer carries a
+ * 16-byte header naming its budget and RAM and must be released with
+ * tal_mem_budget_free. Budgets are meant for the few large, long-lived
+ * buffers of a device (frames, draw buffers, rings), not for small objects.
+ *
+ * A placement is a preference: a buffer that does not fit in the RAM asked for
+ * is taken from the other one, unless the budget has TAL_MEM_BUDGET_STRICT.
+ * DMA buffers never go to PSRAM. Without ENABLE_EXT_RAM the default heap
+ * puts PSRAM buffers in internal RAM.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TAL_MEM_BUDGET_H__
+#define __TAL_MEM_BUDGET_H__
+
+#include "tuya_cloud_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************
+ ********************* constant ( macro and enum ) *********************
+ **********************************************************************/
+typedef enum {
+    TAL_MEM_PLACE_SRAM,  // internal RAM
+    TAL_MEM_PLACE_PSRAM, // external PSRAM
+    TAL_MEM_PLACE_DMA,   // RAM peripherals can DMA from, internal RAM unless the heap says otherwise
+    TAL_MEM_PLACE_NUM,
+} TAL_MEM_PLACE_E;
+
+#define TAL_MEM_BUDGET_STRICT 0x01 // only the RAM of the placement, no fallback
+
+/***********************************************************************
+ ********************* struct ******************************************
+ **********************************************************************/
+typedef struct {
+    uint32_t limit;                        // most bytes held, 0: not limited, only accounted
+    uint32_t live_bytes;                   // bytes held now
+    uint32_t peak_bytes;                   // highest live_bytes since the budget was defined or reset
+    uint32_t live_cnt;                     // buffers held now
+    uint32_t alloc_cnt;                    // buffers taken
+    uint32_t over_cnt;                     // requests refused because of the limit
+    uint32_t fail_cnt;                     // requests within the limit the heap could not serve
+    uint32_t fallback_cnt;                 // buffers taken from another RAM than the placement
+    uint32_t place_bytes[TAL_MEM_PLACE_NUM]; // live bytes per RAM the buffers are in
+} TAL_MEM_BUDGET_STATS_T;
+
+typedef struct tal_mem_budget {
+    const char *name;
+    uint8_t place; // TAL_MEM_PLACE_E
+    uint8_t flags; // TAL_MEM_BUDGET_xxx
+    uint8_t registered;
+    struct tal_mem_budget *next;
+    TAL_MEM_BUDGET_STATS_T stats;
+} TAL_MEM_BUDGET_T;
+
+/**
+ * @brief define a budget of limit bytes, 0 for no limit
+ */
+#define TAL_MEM_BUDGET_DEFINE(var, name, limit, place, flags)                                                          \
+    TAL_MEM_BUDGET_T var = {name, place, flags, 0, NULL, {limit}}
+
+/**
+ * @brief the heap of the budgets, one pair of functions for all the RAMs
+ */
+typedef struct {
+    void *(*malloc)(TAL_MEM_PLACE_E place, size_t size); // NULL when it is full or the RAM does not exist
+    void (*free)(TAL_MEM_PLACE_E place, void *ptr);
+} TAL_MEM_BUDGET_HEAP_T;
+
+/**
+ * @brief called for every buffer taken, refused or released
+ *
+ * @param[in] budget: budget of the buffer
+ * @param[in] ptr: the buffer, NULL when the request was refused
+ * @param[in] size: bytes asked for, 0 when the buffer is released
+ * @param[in] place: RAM of the buffer
+ */
+typedef void (*TAL_MEM_BUDGET_TRACE_CB)(const TAL_MEM_BUDGET_T *budget, const void *ptr, uint32_t size,
+                                        TAL_MEM_PLACE_E place);
+
+typedef void (*TAL_MEM_BUDGET_VISIT_CB)(const TAL_MEM_BUDGET_T *budget, void *arg);
+
+/***********************************************************************
+ ********************* function ****************************************
+ **********************************************************************/
+
+/**
+ * @brief Add a budget to the list of tal_mem_budget_find and tal_mem_budget_dump,
+ * done by the first allocation when not called before
+ *
+ * @param[in] budget: budget, it must stay valid for the life of the program
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_register(TAL_MEM_BUDGET_T *budget);
+
+/**
+ * @brief Find a registered budget by name
+ *
+ * @param[in] name: budget name
+ *
+ * @return the budget, NULL if none has that name
+ */
+TAL_MEM_BUDGET_T *tal_mem_budget_find(const char *name);
+
+/**
+ * @brief Change the limit of a budget, the buffers it holds are kept when it
+ * is lowered below its live bytes
+ *
+ * @param[in] budget: budget
+ * @param[in] limit: most bytes held, 0: not limited
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_set_limit(TAL_MEM_BUDGET_T *budget, uint32_t limit);
+
+/**
+ * @brief Take a buffer charged to a budget
+ *
+ * @param[in] budget: budget
+ * @param[in] size: bytes
+ *
+ * @return the buffer, NULL when it would take the budget over its limit or the heap is full
+ */
+void *tal_mem_budget_malloc(TAL_MEM_BUDGET_T *budget, size_t size);
+
+/**
+ * @brief Take a cleared buffer charged to a budget
+ *
+ * @param[in] budget: budget
+ * @param[in] nitems: number of items
+ * @param[in] size: bytes per item
+ *
+ * @return the buffer, NULL when it would take the budget over its limit or the heap is full
+ */
+void *tal_mem_budget_calloc(TAL_MEM_BUDGET_T *budget, size_t nitems, size_t size);
+
+/**
+ * @brief Release a buffer of tal_mem_budget_malloc / tal_mem_budget_calloc
+ *
+ * @param[in] ptr: buffer, NULL is ignored
+ *
+ * @return none
+ */
+void tal_mem_budget_free(void *ptr);
+
+/**
+ * @brief Get the usage of a budget
+ *
+ * @param[in] budget: budget
+ * @param[out] stats: usage
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_get_stats(const TAL_MEM_BUDGET_T *budget, TAL_MEM_BUDGET_STATS_T *stats);
+
+/**
+ * @brief Restart the peak_bytes watermark of a budget from its live bytes
+ *
+ * @param[in] budget: budget
+ *
+ * @return none
+ */
+void tal_mem_budget_peak_reset(TAL_MEM_BUDGET_T *budget);
+
+/**
+ * @brief Call cb for every registered budget
+ *
+ * @param[in] cb: visitor
+ * @param[in] arg: visitor argument
+ *
+ * @return none
+ */
+void tal_mem_budget_foreach(TAL_MEM_BUDGET_VISIT_CB cb, void *arg);
+
+/**
+ * @brief Print the usage of every registered budget
+ *
+ * @return none
+ */
+void tal_mem_budget_dump(void);
+
+/**
+ * @brief Replace the heap the buffers are taken from, by default tal_malloc
+ * for internal and DMA RAM and tal_psram_malloc for PSRAM. A heap set here is
+ * asked for PSRAM too. Set it while no buffer is taken
+ *
+ * @param[in] heap: heap, NULL for the default one. It must stay valid
+ *
+ * @return none
+ */
+void tal_mem_budget_set_heap(const TAL_MEM_BUDGET_HEAP_T *heap);
+
+/**
+ * @brief Set the function called for every buffer, to record an allocation trace
+ *
+ * @param[in] cb: trace function, NULL to stop
+ *
+ * @return none
+ */
+void tal_mem_budget_set_trace(TAL_MEM_BUDGET_TRACE_CB cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TAL_MEM_BUDGET_H__ */
@@ -44,6 +44,15 @@ extern "C" {
 /***********************************************************************
  ********************* struct ******************************************
  **********************************************************************/
+typedef struct {
+    uint32_t live_bytes;       // bytes requested and not freed yet
+    uint32_t peak_bytes;       // highest live_bytes since boot or tal_memory_peak_reset
+    uint32_t live_cnt;         // blocks not freed yet
+    uint32_t alloc_cnt;        // allocations since boot
+    uint32_t pool_slabs;       // slabs currently taken from the heap
+    uint32_t pool_bytes;       // bytes held by those slabs
+    uint32_t pool_free_blocks; // free blocks kept inside the slabs
+} TAL_MEMORY_STATS_T;
 
 /***********************************************************************
  ********************* variable ****************************************
@@ -103,6 +112,34 @@ void *tal_psram_calloc(size_t nitems, size_t size);
 void *tal_psram_realloc(void *ptr, size_t size);
 #endif
 
+/**
+ * @brief Get the statistics of the pool and profiling layer
+ *
+ * @param[out] stats: statistics
+ *
+ * @return OPRT_OK on success, OPRT_NOT_SUPPORTED if neither
+ * ENABLE_TAL_MEMORY_POOL nor ENABLE_TAL_MEMORY_PROFILE is enabled
+ */
+OPERATE_RET tal_memory_get_stats(TAL_MEMORY_STATS_T *stats);
+
+/**
+ * @brief Restart the peak_bytes watermark from the current live bytes, so the
+ * peak of one operation can be measured
+ *
+ * @return none
+ */
+void tal_memory_peak_reset(void);
+
+/**
+ * @brief Print the heap profile: totals, pool usage and, with
+ * ENABLE_TAL_MEMORY_PROFILE, live bytes, peak and allocation rate per call site
+ *
+ * @param[in] leak_only: only list the call sites still holding memory
+ *
+ * @return none
+ */
+void tal_memory_profile_dump(BOOL_T leak_only);
+
 /**
  * @brief Get system free heap size
  *
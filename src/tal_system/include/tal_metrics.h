@@ -0,0 +1,213 @@
+/**
+ * @file tal_metrics.h
+ * @brief Lightweight metrics registry: counters, gauges and histograms.
+ *
+ * Metrics are plain statically allocated objects that any module defines with
+ * the TAL_METRIC_xxx_DEFINE macros and registers once with tal_metric_register.
+ * Updates are one or two relaxed atomic operations with no lock, so they can be
+ * made from hot paths, other threads and interrupts alike. Targets without
+ * lock-free 32-bit atomics (e.g. Cortex-M0) make each update in a short
+ * critical section instead. Histograms use
+ * TAL_METRIC_HIST_BUCKETS power-of-two buckets, picked with one
+ * count-leading-zeros instruction.
+ *
+ * Readers walk the registry with tal_metrics_foreach or print it in the
+ * Prometheus text format with tal_metrics_print. The values read are not a
+ * consistent snapshot across metrics, each field is read once.
+ *
+ * Without ENABLE_TAL_METRICS the update functions are empty and the registry
+ * stays empty, the metric objects themselves are still defined.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TAL_METRICS_H__
+#define __TAL_METRICS_H__
+
+#include "tuya_cloud_types.h"
+#include "tal_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************
+ ********************* constant ( macro and enum ) *********************
+ **********************************************************************/
+#if defined(ENABLE_TAL_METRICS) && (ENABLE_TAL_METRICS == 1)
+#define TAL_METRICS_ON 1
+#else
+#define TAL_METRICS_ON 0
+#endif
+
+// bucket i counts the samples below 2^(i + shift), the last one the rest
+#define TAL_METRIC_HIST_BUCKETS 16
+
+typedef enum {
+    TAL_METRIC_COUNTER,
+    TAL_METRIC_GAUGE,
+    TAL_METRIC_HISTOGRAM,
+} TAL_METRIC_TYPE_E;
+
+/***********************************************************************
+ ********************* struct ******************************************
+ **********************************************************************/
+typedef struct tal_metric {
+    const char *name; // [a-z0-9_], used as the Prometheus metric name
+    const char *help;
+    uint8_t type;  // TAL_METRIC_TYPE_E
+    uint8_t shift; // histogram only, see TAL_METRIC_HIST_BUCKETS
+    uint8_t registered;
+    struct tal_metric *next;
+    volatile uint32_t value; // counter or gauge value, unused for a histogram (the buckets add up to its count)
+    volatile uint32_t sum;   // histogram only, sum of the samples
+} TAL_METRIC_T;
+
+typedef struct {
+    TAL_METRIC_T base;
+    volatile uint32_t bucket[TAL_METRIC_HIST_BUCKETS];
+} TAL_METRIC_HIST_T;
+
+typedef void (*TAL_METRIC_VISIT_CB)(const TAL_METRIC_T *metric, void *arg);
+
+typedef void (*TAL_METRIC_LINE_CB)(const char *line, void *arg);
+
+/**
+ * @brief define a counter, a value that only goes up
+ */
+#define TAL_METRIC_COUNTER_DEFINE(var, name, help) TAL_METRIC_T var = {name, help, TAL_METRIC_COUNTER, 0, 0, NULL, 0, 0}
+
+/**
+ * @brief define a gauge, a value that is set or goes up and down
+ */
+#define TAL_METRIC_GAUGE_DEFINE(var, name, help) TAL_METRIC_T var = {name, help, TAL_METRIC_GAUGE, 0, 0, NULL, 0, 0}
+
+/**
+ * @brief define a histogram, its first bucket holds the samples below 2^shift
+ */
+#define TAL_METRIC_HISTOGRAM_DEFINE(var, name, help, shift)                                                           \
+    TAL_METRIC_HIST_T var = {{name, help, TAL_METRIC_HISTOGRAM, shift, 0, NULL, 0, 0}, {0}}
+
+#if defined(__GCC_ATOMIC_INT_LOCK_FREE) && (__GCC_ATOMIC_INT_LOCK_FREE == 2)
+#define TAL_METRIC_ATOMIC_ADD(ptr, val)   (void)__atomic_fetch_add((ptr), (val), __ATOMIC_RELAXED)
+#define TAL_METRIC_ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
+#else
+// the __atomic builtins would be libatomic calls, or missing without GCC
+#define TAL_METRIC_ATOMIC_ADD(ptr, val)                                                                                \
+    do {                                                                                                               \
+        TAL_ENTER_CRITICAL();                                                                                          \
+        *(ptr) += (val);                                                                                               \
+        TAL_EXIT_CRITICAL();                                                                                           \
+    } while (0)
+#define TAL_METRIC_ATOMIC_STORE(ptr, val)                                                                              \
+    do {                                                                                                               \
+        TAL_ENTER_CRITICAL();                                                                                          \
+        *(ptr) = (val);                                                                                                \
+        TAL_EXIT_CRITICAL();                                                                                           \
+    } while (0)
+#endif
+
+/***********************************************************************
+ ********************* function ****************************************
+ **********************************************************************/
+
+/**
+ * @brief Add a metric to the registry, a metric already registered is ignored
+ *
+ * @param[in] metric: metric, it must stay valid for the life of the program
+ *
+ * @return OPRT_OK on success, OPRT_NOT_SUPPORTED without ENABLE_TAL_METRICS
+ */
+OPERATE_RET tal_metric_register(TAL_METRIC_T *metric);
+
+/**
+ * @brief Call cb for every registered metric
+ *
+ * @param[in] cb: visitor
+ * @param[in] arg: visitor argument
+ *
+ * @return none
+ */
+void tal_metrics_foreach(TAL_METRIC_VISIT_CB cb, void *arg);
+
+/**
+ * @brief Print every registered metric in the Prometheus text format, one
+ * line per call of cb, without the line feed
+ *
+ * @param[in] cb: line output
+ * @param[in] arg: line output argument
+ *
+ * @return none
+ */
+void tal_metrics_print(TAL_METRIC_LINE_CB cb, void *arg);
+
+/**
+ * @brief Add to a counter or a gauge
+ *
+ * @param[in] metric: counter or gauge
+ * @param[in] val: value to add, two's complement to subtract from a gauge
+ *
+ * @return none
+ */
+static inline void tal_metric_add(TAL_METRIC_T *metric, uint32_t val)
+{
+#if TAL_METRICS_ON
+    TAL_METRIC_ATOMIC_ADD(&metric->value, val);
+#endif
+}
+
+/**
+ * @brief Add one to a counter or a gauge
+ *
+ * @param[in] metric: counter or gauge
+ *
+ * @return none
+ */
+static inline void tal_metric_inc(TAL_METRIC_T *metric)
+{
+    tal_metric_add(metric, 1);
+}
+
+/**
+ * @brief Set a gauge
+ *
+ * @param[in] metric: gauge
+ * @param[in] val: new value
+ *
+ * @return none
+ */
+static inline void tal_metric_set(TAL_METRIC_T *metric, uint32_t val)
+{
+#if TAL_METRICS_ON
+    TAL_METRIC_ATOMIC_STORE(&metric->value, val);
+#endif
+}
+
+/**
+ * @brief Record one sample in a histogram
+ *
+ * @param[in] hist: histogram
+ * @param[in] val: sample
+ *
+ * @return none
+ */
+static inline void tal_metric_observe(TAL_METRIC_HIST_T *hist, uint32_t val)
+{
+#if TAL_METRICS_ON
+    uint32_t idx = val >> hist->base.shift;
+
+    idx = idx ? 32 - __builtin_clz(idx) : 0;
+    if (idx >= TAL_METRIC_HIST_BUCKETS) {
+        idx = TAL_METRIC_HIST_BUCKETS - 1;
+    }
+    TAL_METRIC_ATOMIC_ADD(&hist->bucket[idx], 1);
+    TAL_METRIC_ATOMIC_ADD(&hist->base.sum, val);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TAL_METRICS_H__ */
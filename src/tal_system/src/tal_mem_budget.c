@@ -0,0 +1,463 @@
+/**
+ * @file tal_mem_budget.c
+ * @brief Implements the memory budgets declared in tal_mem_budget.h.
+ *
+ * The bytes of a request are reserved in its budget inside a critical section
+ * before the heap is asked, so two threads cannot both pass the limit, and
+ * given back if the heap fails. The list of budgets is threaded through the
+ * budget objects as the metrics registry is: budgets are only ever added, at
+ * the head, so readers walk it without any lock.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tal_system.h"
+#include "tal_log.h"
+#include "tal_memory.h"
+#include "tal_mem_budget.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define TAL_MEM_BUDGET_MAGIC 0xB6E7
+
+#define TAL_MEM_BUDGET_HDR(ptr)  ((TAL_MEM_BUDGET_HDR_T *)(ptr) - 1)
+#define TAL_MEM_BUDGET_USER(hdr) ((void *)((TAL_MEM_BUDGET_HDR_T *)(hdr) + 1))
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+// 16 bytes on 32 and 64-bit targets, the buffer keeps the alignment of the heap
+typedef union {
+    struct {
+        TAL_MEM_BUDGET_T *budget;
+        uint32_t size;  // bytes asked for
+        uint16_t magic; // TAL_MEM_BUDGET_MAGIC while the buffer is live
+        uint8_t place;  // TAL_MEM_PLACE_E the buffer is in
+    } h;
+    uint64_t align[2];
+} TAL_MEM_BUDGET_HDR_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+static void *__budget_heap_malloc(TAL_MEM_PLACE_E place, size_t size);
+static void __budget_heap_free(TAL_MEM_PLACE_E place, void *ptr);
+
+static const TAL_MEM_BUDGET_HEAP_T sg_budget_default_heap = {
+    __budget_heap_malloc,
+    __budget_heap_free,
+};
+
+static const TAL_MEM_BUDGET_HEAP_T *sg_budget_heap = &sg_budget_default_heap;
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+static uint8_t sg_budget_has_psram = TRUE;
+#else
+static uint8_t sg_budget_has_psram = FALSE;
+#endif
+static TAL_MEM_BUDGET_TRACE_CB sg_budget_trace = NULL;
+static TAL_MEM_BUDGET_T *volatile sg_budget_head = NULL;
+
+static const char *sg_budget_place_name[TAL_MEM_PLACE_NUM] = {"sram", "psram", "dma"};
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static void *__budget_heap_malloc(TAL_MEM_PLACE_E place, size_t size)
+{
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    if (TAL_MEM_PLACE_PSRAM == place) {
+        return tal_psram_malloc(size);
+    }
+#else
+    (void)place;
+#endif
+    return tal_malloc(size);
+}
+
+static void __budget_heap_free(TAL_MEM_PLACE_E place, void *ptr)
+{
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    if (TAL_MEM_PLACE_PSRAM == place) {
+        tal_psram_free(ptr);
+        return;
+    }
+#else
+    (void)place;
+#endif
+    tal_free(ptr);
+}
+
+/**
+ * @brief the RAM tried when the placement of the budget is full
+ *
+ * @return TAL_MEM_PLACE_NUM when there is none
+ */
+static TAL_MEM_PLACE_E __budget_fallback(const TAL_MEM_BUDGET_T *budget, TAL_MEM_PLACE_E place)
+{
+    if (budget->flags & TAL_MEM_BUDGET_STRICT) {
+        return TAL_MEM_PLACE_NUM;
+    }
+    if (TAL_MEM_PLACE_PSRAM == place) {
+        return TAL_MEM_PLACE_SRAM;
+    }
+    if (TAL_MEM_PLACE_SRAM == place && sg_budget_has_psram) {
+        return TAL_MEM_PLACE_PSRAM;
+    }
+    // DMA buffers stay in DMA capable RAM
+    return TAL_MEM_PLACE_NUM;
+}
+
+/**
+ * @brief Add a budget to the list of tal_mem_budget_find and tal_mem_budget_dump,
+ * done by the first allocation when not called before
+ *
+ * @param[in] budget: budget, it must stay valid for the life of the program
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_register(TAL_MEM_BUDGET_T *budget)
+{
+    if (NULL == budget || NULL == budget->name || budget->place >= TAL_MEM_PLACE_NUM) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TAL_ENTER_CRITICAL();
+    if (!budget->registered) {
+        budget->registered = 1;
+        budget->next = sg_budget_head;
+        sg_budget_head = budget;
+    }
+    TAL_EXIT_CRITICAL();
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Find a registered budget by name
+ *
+ * @param[in] name: budget name
+ *
+ * @return the budget, NULL if none has that name
+ */
+TAL_MEM_BUDGET_T *tal_mem_budget_find(const char *name)
+{
+    TAL_MEM_BUDGET_T *budget = NULL;
+
+    if (NULL == name) {
+        return NULL;
+    }
+
+    for (budget = sg_budget_head; budget; budget = budget->next) {
+        if (0 == strcmp(budget->name, name)) {
+            return budget;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Change the limit of a budget
+ *
+ * @param[in] budget: budget
+ * @param[in] limit: most bytes held, 0: not limited
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_set_limit(TAL_MEM_BUDGET_T *budget, uint32_t limit)
+{
+    if (NULL == budget) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TAL_ENTER_CRITICAL();
+    budget->stats.limit = limit;
+    TAL_EXIT_CRITICAL();
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Take a buffer charged to a budget
+ *
+ * @param[in] budget: budget
+ * @param[in] size: bytes
+ *
+ * @return the buffer, NULL when it would take the budget over its limit or the heap is full
+ */
+void *tal_mem_budget_malloc(TAL_MEM_BUDGET_T *budget, size_t size)
+{
+    TAL_MEM_BUDGET_TRACE_CB trace = sg_budget_trace;
+    TAL_MEM_BUDGET_HDR_T *hdr = NULL;
+    TAL_MEM_PLACE_E place, want;
+    uint32_t irq_mask, limit;
+    BOOL_T over = FALSE;
+
+    if (NULL == budget || 0 == size || size > 0xFFFFFFFF - sizeof(TAL_MEM_BUDGET_HDR_T)) {
+        return NULL;
+    }
+    if (!budget->registered && OPRT_OK != tal_mem_budget_register(budget)) {
+        return NULL;
+    }
+
+    place = (TAL_MEM_PLACE_E)budget->place;
+    if (TAL_MEM_PLACE_PSRAM == place && !sg_budget_has_psram) {
+        place = TAL_MEM_PLACE_SRAM;
+    }
+    want = place;
+
+    // reserve the bytes first, the heap is not asked for a request over the limit
+    irq_mask = tal_system_enter_critical();
+    limit = budget->stats.limit;
+    if (limit && (size > limit || budget->stats.live_bytes > limit - size)) {
+        budget->stats.over_cnt++;
+        over = TRUE;
+    } else {
+        budget->stats.live_bytes += size;
+    }
+    tal_system_exit_critical(irq_mask);
+
+    if (over) {
+        PR_WARN("mem budget %s over: live:%d + %d > limit:%d", budget->name, budget->stats.live_bytes, size, limit);
+        if (trace) {
+            trace(budget, NULL, (uint32_t)size, place);
+        }
+        return NULL;
+    }
+
+    hdr = sg_budget_heap->malloc(place, sizeof(TAL_MEM_BUDGET_HDR_T) + size);
+    if (NULL == hdr) {
+        TAL_MEM_PLACE_E other = __budget_fallback(budget, place);
+        if (other < TAL_MEM_PLACE_NUM) {
+            hdr = sg_budget_heap->malloc(other, sizeof(TAL_MEM_BUDGET_HDR_T) + size);
+            if (hdr) {
+                place = other;
+            }
+        }
+    }
+
+    irq_mask = tal_system_enter_critical();
+    if (NULL == hdr) {
+        budget->stats.live_bytes -= size;
+        budget->stats.fail_cnt++;
+    } else {
+        budget->stats.live_cnt++;
+        budget->stats.alloc_cnt++;
+        budget->stats.place_bytes[place] += size;
+        if (place != want) {
+            budget->stats.fallback_cnt++;
+        }
+        if (budget->stats.live_bytes > budget->stats.peak_bytes) {
+            budget->stats.peak_bytes = budget->stats.live_bytes;
+        }
+    }
+    tal_system_exit_critical(irq_mask);
+
+    if (NULL == hdr) {
+        PR_ERR("mem budget %s malloc failed:%d in %s", budget->name, size, sg_budget_place_name[place]);
+        if (trace) {
+            trace(budget, NULL, (uint32_t)size, place);
+        }
+        return NULL;
+    }
+
+    hdr->h.budget = budget;
+    hdr->h.size = (uint32_t)size;
+    hdr->h.magic = TAL_MEM_BUDGET_MAGIC;
+    hdr->h.place = (uint8_t)place;
+    if (trace) {
+        trace(budget, TAL_MEM_BUDGET_USER(hdr), (uint32_t)size, place);
+    }
+
+    return TAL_MEM_BUDGET_USER(hdr);
+}
+
+/**
+ * @brief Take a cleared buffer charged to a budget
+ *
+ * @param[in] budget: budget
+ * @param[in] nitems: number of items
+ * @param[in] size: bytes per item
+ *
+ * @return the buffer, NULL when it would take the budget over its limit or the heap is full
+ */
+void *tal_mem_budget_calloc(TAL_MEM_BUDGET_T *budget, size_t nitems, size_t size)
+{
+    void *ptr = NULL;
+
+    if (0 == nitems || 0 == size || nitems > ((size_t)-1) / size) {
+        return NULL;
+    }
+
+    ptr = tal_mem_budget_malloc(budget, nitems * size);
+    if (ptr) {
+        memset(ptr, 0, nitems * size);
+    }
+
+    return ptr;
+}
+
+/**
+ * @brief Release a buffer of tal_mem_budget_malloc / tal_mem_budget_calloc
+ *
+ * @param[in] ptr: buffer, NULL is ignored
+ *
+ * @return none
+ */
+void tal_mem_budget_free(void *ptr)
+{
+    TAL_MEM_BUDGET_TRACE_CB trace = sg_budget_trace;
+    TAL_MEM_BUDGET_HDR_T *hdr = NULL;
+    TAL_MEM_BUDGET_T *budget = NULL;
+    TAL_MEM_PLACE_E place;
+    uint32_t irq_mask;
+
+    if (NULL == ptr) {
+        return;
+    }
+
+    hdr = TAL_MEM_BUDGET_HDR(ptr);
+    if (TAL_MEM_BUDGET_MAGIC != hdr->h.magic || hdr->h.place >= TAL_MEM_PLACE_NUM) {
+        PR_ERR("0x%x mem budget free invalid or freed block %p", __builtin_return_address(0), ptr);
+        return;
+    }
+
+    budget = hdr->h.budget;
+    place = (TAL_MEM_PLACE_E)hdr->h.place;
+
+    irq_mask = tal_system_enter_critical();
+    budget->stats.live_bytes -= hdr->h.size;
+    budget->stats.live_cnt--;
+    budget->stats.place_bytes[place] -= hdr->h.size;
+    hdr->h.magic = 0;
+    tal_system_exit_critical(irq_mask);
+
+    if (trace) {
+        trace(budget, ptr, 0, place);
+    }
+    sg_budget_heap->free(place, hdr);
+}
+
+/**
+ * @brief Get the usage of a budget
+ *
+ * @param[in] budget: budget
+ * @param[out] stats: usage
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tal_mem_budget_get_stats(const TAL_MEM_BUDGET_T *budget, TAL_MEM_BUDGET_STATS_T *stats)
+{
+    if (NULL == budget || NULL == stats) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TAL_ENTER_CRITICAL();
+    *stats = budget->stats;
+    TAL_EXIT_CRITICAL();
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Restart the peak_bytes watermark of a budget from its live bytes
+ *
+ * @param[in] budget: budget
+ *
+ * @return none
+ */
+void tal_mem_budget_peak_reset(TAL_MEM_BUDGET_T *budget)
+{
+    if (NULL == budget) {
+        return;
+    }
+
+    TAL_ENTER_CRITICAL();
+    budget->stats.peak_bytes = budget->stats.live_bytes;
+    TAL_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Call cb for every registered budget
+ *
+ * @param[in] cb: visitor
+ * @param[in] arg: visitor argument
+ *
+ * @return none
+ */
+void tal_mem_budget_foreach(TAL_MEM_BUDGET_VISIT_CB cb, void *arg)
+{
+    TAL_MEM_BUDGET_T *budget = NULL;
+
+    if (NULL == cb) {
+        return;
+    }
+
+    for (budget = sg_budget_head; budget; budget = budget->next) {
+        cb(budget, arg);
+    }
+}
+
+static void __budget_print(const TAL_MEM_BUDGET_T *budget, void *arg)
+{
+    TAL_MEM_BUDGET_STATS_T stats;
+
+    (void)arg;
+    tal_mem_budget_get_stats(budget, &stats);
+    PR_NOTICE("%-12s %-5s %10d %10d %10d %6d %6d %6d %6d %10d %10d %10d", budget->name,
+              sg_budget_place_name[budget->place], stats.limit, stats.live_bytes, stats.peak_bytes, stats.live_cnt,
+              stats.over_cnt, stats.fail_cnt, stats.fallback_cnt, stats.place_bytes[TAL_MEM_PLACE_SRAM],
+              stats.place_bytes[TAL_MEM_PLACE_PSRAM], stats.place_bytes[TAL_MEM_PLACE_DMA]);
+}
+
+/**
+ * @brief Print the usage of every registered budget
+ *
+ * @return none
+ */
+void tal_mem_budget_dump(void)
+{
+    PR_NOTICE("%-12s %-5s %10s %10s %10s %6s %6s %6s %6s %10s %10s %10s", "budget", "place", "limit", "live", "peak",
+              "bufs", "over", "fail", "fallbk", "sram", "psram", "dma");
+    tal_mem_budget_foreach(__budget_print, NULL);
+}
+
+/**
+ * @brief Replace the heap the buffers are taken from
+ *
+ * @param[in] heap: heap, NULL for the default one. It must stay valid
+ *
+ * @return none
+ */
+void tal_mem_budget_set_heap(const TAL_MEM_BUDGET_HEAP_T *heap)
+{
+    if (heap && heap->malloc && heap->free) {
+        sg_budget_heap = heap;
+        // PSRAM requests are left to the heap, it returns NULL if it has none
+        sg_budget_has_psram = TRUE;
+        return;
+    }
+
+    sg_budget_heap = &sg_budget_default_heap;
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    sg_budget_has_psram = TRUE;
+#else
+    sg_budget_has_psram = FALSE;
+#endif
+}
+
+/**
+ * @brief Set the function called for every buffer, to record an allocation trace
+ *
+ * @param[in] cb: trace function, NULL to stop
+ *
+ * @return none
+ */
+void tal_mem_budget_set_trace(TAL_MEM_BUDGET_TRACE_CB cb)
+{
+    sg_budget_trace = cb;
+}
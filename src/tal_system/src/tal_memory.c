@@ -0,0 +1,864 @@
+/**
+ * @file tal_memory.c
+ * @brief Implements the TAL heap interface with optional pooling and profiling.
+ *
+ * tal_malloc() and friends pass straight through to the TKL heap by default.
+ * Two Kconfig options put a thin layer in between:
+ *
+ * - ENABLE_TAL_MEMORY_POOL serves small requests from size-class slabs, so the
+ *   thousands of short-lived cJSON nodes, queue items and packet buffers of a
+ *   long-running device stop fragmenting the heap. Slabs are taken from the
+ *   TKL heap (or PSRAM for the tal_psram_xxx variants) and given back as soon
+ *   as a class has another slab with free blocks.
+ * - ENABLE_TAL_MEMORY_PROFILE accounts every allocation to its call site:
+ *   live bytes and blocks, peak, allocation count and rate, and prints a
+ *   leak dump of the sites still holding memory.
+ *
+ * With either option enabled every block carries an 8-byte header recording
+ * its size and origin, so memory from tal_malloc() must be released with
+ * tal_free() / tal_psram_free() and never with the TKL functions directly.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+
+#include "tkl_system.h"
+#include "tkl_memory.h"
+#include "tal_system.h"
+#include "tal_log.h"
+#include "tal_memory.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#if (defined(ENABLE_TAL_MEMORY_POOL) && (ENABLE_TAL_MEMORY_POOL == 1))
+#define TAL_MEM_POOL 1
+#else
+#define TAL_MEM_POOL 0
+#endif
+
+#if (defined(ENABLE_TAL_MEMORY_PROFILE) && (ENABLE_TAL_MEMORY_PROFILE == 1))
+#define TAL_MEM_PROFILE 1
+#else
+#define TAL_MEM_PROFILE 0
+#endif
+
+#define TAL_MEM_LAYER (TAL_MEM_POOL || TAL_MEM_PROFILE)
+
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+#define TAL_MEM_REGION_NUM 2
+#else
+#define TAL_MEM_REGION_NUM 1
+#endif
+
+#ifndef TAL_MEMORY_POOL_SLAB_SIZE
+#define TAL_MEMORY_POOL_SLAB_SIZE 2048
+#endif
+
+#ifndef TAL_MEMORY_POOL_SLAB_NUM
+#define TAL_MEMORY_POOL_SLAB_NUM 32
+#endif
+
+#ifndef TAL_MEMORY_POOL_MAX_SIZE
+#define TAL_MEMORY_POOL_MAX_SIZE 256
+#endif
+
+#ifndef TAL_MEMORY_PROFILE_SITE_NUM
+#define TAL_MEMORY_PROFILE_SITE_NUM 64
+#endif
+
+// Block origin, upper nibble of TAL_MEM_HDR_T.kind. The values double as a
+// marker so that foreign or already freed pointers are detected on free.
+#define TAL_MEM_KIND_HEAP       0xA0
+#define TAL_MEM_KIND_PSRAM_HEAP 0xB0
+#define TAL_MEM_KIND_POOL       0xC0
+#define TAL_MEM_KIND_PSRAM_POOL 0xD0
+#define TAL_MEM_KIND_MASK       0xF0
+#define TAL_MEM_CLASS_MASK      0x0F
+
+#define TAL_MEM_SLAB_NONE 0xFF
+#define TAL_MEM_SITE_NONE 0xFFFF
+
+#define TAL_MEM_HDR(ptr)  ((TAL_MEM_HDR_T *)(ptr) - 1)
+#define TAL_MEM_USER(hdr) ((void *)((TAL_MEM_HDR_T *)(hdr) + 1))
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+#if TAL_MEM_LAYER
+typedef struct {
+    uint32_t size; // requested size
+    uint8_t kind;  // TAL_MEM_KIND_xxx | size class
+    uint8_t slab;  // owner slab of a pool block
+    uint16_t site; // call site index, TAL_MEM_SITE_NONE if not profiled
+} TAL_MEM_HDR_T;
+#endif
+
+#if TAL_MEM_POOL
+typedef struct {
+    uint8_t *base;      // slab memory, NULL if the slot is unused
+    void *free_list;    // free blocks of this slab
+    uint16_t used;      // blocks handed out
+    uint16_t total;     // blocks in the slab
+    uint8_t cls;        // size class
+    uint8_t region;     // 0 = sram, 1 = psram
+    uint8_t next;       // next slab of the class with free blocks
+    uint8_t in_partial; // slab is linked in the partial list
+} TAL_MEM_SLAB_T;
+#endif
+
+#if TAL_MEM_PROFILE
+typedef struct {
+    void *caller;            // return address of the allocating call
+    uint32_t live_bytes;     // bytes currently held
+    uint32_t live_cnt;       // blocks currently held
+    uint32_t peak_bytes;     // highest live_bytes
+    uint32_t alloc_cnt;      // allocations since boot
+    uint32_t last_alloc_cnt; // alloc_cnt at the previous dump
+} TAL_MEM_SITE_T;
+#endif
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if TAL_MEM_LAYER
+static TAL_MEMORY_STATS_T sg_mem_stats;
+#endif
+
+#if TAL_MEM_POOL
+static const uint16_t sg_mem_class_size[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+static TAL_MEM_SLAB_T sg_mem_slab[TAL_MEMORY_POOL_SLAB_NUM];
+static uint8_t sg_mem_partial[TAL_MEM_REGION_NUM][CNTSOF(sg_mem_class_size)];
+static uint8_t sg_mem_pool_ready = FALSE;
+#endif
+
+#if TAL_MEM_PROFILE
+// Slot 0 collects the call sites that no longer fit in the table
+static TAL_MEM_SITE_T sg_mem_site[TAL_MEMORY_PROFILE_SITE_NUM];
+static uint32_t sg_mem_last_dump_ms = 0;
+static uint32_t sg_mem_last_alloc_cnt = 0;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+#if TAL_MEM_LAYER
+static void *__mem_raw_alloc(uint8_t region, size_t size)
+{
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    if (region) {
+        return tkl_system_psram_malloc(size);
+    }
+#endif
+    return tkl_system_malloc(size);
+}
+
+static void __mem_raw_free(uint8_t region, void *ptr)
+{
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    if (region) {
+        tkl_system_psram_free(ptr);
+        return;
+    }
+#endif
+    tkl_system_free(ptr);
+}
+
+static void *__mem_raw_realloc(uint8_t region, void *ptr, size_t size)
+{
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+    if (region) {
+        return tkl_system_psram_realloc(ptr, size);
+    }
+#endif
+    return tkl_system_realloc(ptr, size);
+}
+#endif
+
+#if TAL_MEM_PROFILE
+static uint16_t __mem_site_get(void *caller)
+{
+    uint32_t slots = TAL_MEMORY_PROFILE_SITE_NUM - 1;
+    uint32_t idx = (uint32_t)(((uintptr_t)caller >> 2) * 2654435761u) % slots;
+    uint32_t i;
+
+    for (i = 0; i < slots; i++) {
+        TAL_MEM_SITE_T *site = &sg_mem_site[idx + 1];
+        if (site->caller == caller) {
+            return (uint16_t)(idx + 1);
+        }
+        if (NULL == site->caller) {
+            site->caller = caller;
+            return (uint16_t)(idx + 1);
+        }
+        idx = (idx + 1 == slots) ? 0 : idx + 1;
+    }
+
+    return 0;
+}
+#endif
+
+#if TAL_MEM_LAYER
+// Called inside the critical section
+static void __mem_account_alloc(TAL_MEM_HDR_T *hdr, void *caller)
+{
+    sg_mem_stats.live_bytes += hdr->size;
+    sg_mem_stats.live_cnt++;
+    sg_mem_stats.alloc_cnt++;
+    if (sg_mem_stats.live_bytes > sg_mem_stats.peak_bytes) {
+        sg_mem_stats.peak_bytes = sg_mem_stats.live_bytes;
+    }
+
+#if TAL_MEM_PROFILE
+    TAL_MEM_SITE_T *site = &sg_mem_site[__mem_site_get(caller)];
+
+    hdr->site = (uint16_t)(site - sg_mem_site);
+    site->live_bytes += hdr->size;
+    site->live_cnt++;
+    site->alloc_cnt++;
+    if (site->live_bytes > site->peak_bytes) {
+        site->peak_bytes = site->live_bytes;
+    }
+#else
+    hdr->site = TAL_MEM_SITE_NONE;
+#endif
+}
+
+// Called inside the critical section
+static void __mem_account_free(TAL_MEM_HDR_T *hdr)
+{
+    sg_mem_stats.live_bytes -= hdr->size;
+    sg_mem_stats.live_cnt--;
+
+#if TAL_MEM_PROFILE
+    if (hdr->site < TAL_MEMORY_PROFILE_SITE_NUM) {
+        sg_mem_site[hdr->site].live_bytes -= hdr->size;
+        sg_mem_site[hdr->site].live_cnt--;
+    }
+#endif
+}
+#endif
+
+#if TAL_MEM_POOL
+static int __mem_class_get(size_t size)
+{
+    int cls;
+
+    if (size > TAL_MEMORY_POOL_MAX_SIZE) {
+        return -1;
+    }
+
+    for (cls = 0; cls < (int)CNTSOF(sg_mem_class_size); cls++) {
+        if (size <= sg_mem_class_size[cls]) {
+            // A slab must hold at least two blocks to be worth it
+            if ((sizeof(TAL_MEM_HDR_T) + sg_mem_class_size[cls]) * 2 > TAL_MEMORY_POOL_SLAB_SIZE) {
+                return -1;
+            }
+            return cls;
+        }
+    }
+
+    return -1;
+}
+
+static void __mem_pool_init(void)
+{
+    memset(sg_mem_partial, TAL_MEM_SLAB_NONE, sizeof(sg_mem_partial));
+    sg_mem_pool_ready = TRUE;
+}
+
+// Called inside the critical section
+static void __mem_partial_remove(TAL_MEM_SLAB_T *slab)
+{
+    uint8_t *link = &sg_mem_partial[slab->region][slab->cls];
+    uint8_t idx = (uint8_t)(slab - sg_mem_slab);
+
+    while (*link != TAL_MEM_SLAB_NONE) {
+        if (*link == idx) {
+            *link = slab->next;
+            break;
+        }
+        link = &sg_mem_slab[*link].next;
+    }
+    slab->next = TAL_MEM_SLAB_NONE;
+    slab->in_partial = FALSE;
+}
+
+// Called inside the critical section
+static TAL_MEM_HDR_T *__mem_pool_take(uint8_t region, int cls)
+{
+    uint8_t idx = sg_mem_partial[region][cls];
+    TAL_MEM_SLAB_T *slab = NULL;
+    TAL_MEM_HDR_T *hdr = NULL;
+
+    if (idx == TAL_MEM_SLAB_NONE) {
+        return NULL;
+    }
+
+    slab = &sg_mem_slab[idx];
+    hdr = TAL_MEM_HDR(slab->free_list);
+    slab->free_list = *(void **)slab->free_list;
+    slab->used++;
+    sg_mem_stats.pool_free_blocks--;
+    if (NULL == slab->free_list) {
+        __mem_partial_remove(slab);
+    }
+
+    hdr->kind = (region ? TAL_MEM_KIND_PSRAM_POOL : TAL_MEM_KIND_POOL) | (uint8_t)cls;
+    hdr->slab = idx;
+
+    return hdr;
+}
+
+/**
+ * @brief Takes a new slab from the heap and links it as partial slab of the class.
+ *
+ * @return FALSE if the slab table is full or the heap is exhausted.
+ */
+static BOOL_T __mem_pool_grow(uint8_t region, int cls)
+{
+    uint32_t stride = sizeof(TAL_MEM_HDR_T) + sg_mem_class_size[cls];
+    uint32_t total = TAL_MEMORY_POOL_SLAB_SIZE / stride;
+    uint8_t *base = NULL;
+    void *free_list = NULL;
+    uint32_t irq_mask, i;
+    int idx = -1;
+
+    base = __mem_raw_alloc(region, TAL_MEMORY_POOL_SLAB_SIZE);
+    if (NULL == base) {
+        return FALSE;
+    }
+
+    // Thread the free list from the end so blocks are handed out in address order
+    for (i = total; i > 0; i--) {
+        TAL_MEM_HDR_T *hdr = (TAL_MEM_HDR_T *)(base + (i - 1) * stride);
+        hdr->kind = 0;
+        *(void **)TAL_MEM_USER(hdr) = free_list;
+        free_list = TAL_MEM_USER(hdr);
+    }
+
+    irq_mask = tal_system_enter_critical();
+    for (i = 0; i < TAL_MEMORY_POOL_SLAB_NUM; i++) {
+        if (NULL == sg_mem_slab[i].base) {
+            idx = (int)i;
+            break;
+        }
+    }
+    if (idx >= 0) {
+        TAL_MEM_SLAB_T *slab = &sg_mem_slab[idx];
+        slab->base = base;
+        slab->free_list = free_list;
+        slab->used = 0;
+        slab->total = (uint16_t)total;
+        slab->cls = (uint8_t)cls;
+        slab->region = region;
+        slab->next = sg_mem_partial[region][cls];
+        slab->in_partial = TRUE;
+        sg_mem_partial[region][cls] = (uint8_t)idx;
+        sg_mem_stats.pool_slabs++;
+        sg_mem_stats.pool_bytes += TAL_MEMORY_POOL_SLAB_SIZE;
+        sg_mem_stats.pool_free_blocks += total;
+    }
+    tal_system_exit_critical(irq_mask);
+
+    if (idx < 0) {
+        __mem_raw_free(region, base);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Returns a pool block to its slab.
+ *
+ * @return the slab memory to give back to the heap, NULL if the slab is kept
+ */
+static uint8_t *__mem_pool_put(TAL_MEM_HDR_T *hdr)
+{
+    TAL_MEM_SLAB_T *slab = &sg_mem_slab[hdr->slab];
+    uint8_t *release = NULL;
+    uint32_t irq_mask;
+
+    irq_mask = tal_system_enter_critical();
+    __mem_account_free(hdr);
+    hdr->kind = 0;
+    *(void **)TAL_MEM_USER(hdr) = slab->free_list;
+    slab->free_list = TAL_MEM_USER(hdr);
+    slab->used--;
+    sg_mem_stats.pool_free_blocks++;
+
+    if (!slab->in_partial) {
+        slab->next = sg_mem_partial[slab->region][slab->cls];
+        slab->in_partial = TRUE;
+        sg_mem_partial[slab->region][slab->cls] = (uint8_t)(slab - sg_mem_slab);
+    }
+
+    // Give an empty slab back unless it is the last one with free blocks of its class
+    if ((0 == slab->used) &&
+        ((sg_mem_partial[slab->region][slab->cls] != (uint8_t)(slab - sg_mem_slab)) || (slab->next != TAL_MEM_SLAB_NONE))) {
+        __mem_partial_remove(slab);
+        release = slab->base;
+        sg_mem_stats.pool_slabs--;
+        sg_mem_stats.pool_bytes -= TAL_MEMORY_POOL_SLAB_SIZE;
+        sg_mem_stats.pool_free_blocks -= slab->total;
+        slab->base = NULL;
+    }
+    tal_system_exit_critical(irq_mask);
+
+    return release;
+}
+#endif
+
+#if TAL_MEM_LAYER
+static void *__mem_alloc(uint8_t region, size_t size, void *caller)
+{
+    TAL_MEM_HDR_T *hdr = NULL;
+    uint32_t irq_mask;
+
+    if (size > 0xFFFFFFFF - sizeof(TAL_MEM_HDR_T)) {
+        return NULL;
+    }
+
+#if TAL_MEM_POOL
+    int cls = __mem_class_get(size);
+
+    if (cls >= 0) {
+        if (!sg_mem_pool_ready) {
+            __mem_pool_init();
+        }
+
+        irq_mask = tal_system_enter_critical();
+        hdr = __mem_pool_take(region, cls);
+        if (hdr) {
+            hdr->size = (uint32_t)size;
+            __mem_account_alloc(hdr, caller);
+        }
+        tal_system_exit_critical(irq_mask);
+
+        if (NULL == hdr && __mem_pool_grow(region, cls)) {
+            irq_mask = tal_system_enter_critical();
+            hdr = __mem_pool_take(region, cls);
+            if (hdr) {
+                hdr->size = (uint32_t)size;
+                __mem_account_alloc(hdr, caller);
+            }
+            tal_system_exit_critical(irq_mask);
+        }
+
+        if (hdr) {
+            return TAL_MEM_USER(hdr);
+        }
+        // Slab table full, fall back to the heap
+    }
+#endif
+
+    hdr = __mem_raw_alloc(region, sizeof(TAL_MEM_HDR_T) + size);
+    if (NULL == hdr) {
+        return NULL;
+    }
+
+    hdr->size = (uint32_t)size;
+    hdr->kind = region ? TAL_MEM_KIND_PSRAM_HEAP : TAL_MEM_KIND_HEAP;
+    hdr->slab = TAL_MEM_SLAB_NONE;
+
+    irq_mask = tal_system_enter_critical();
+    __mem_account_alloc(hdr, caller);
+    tal_system_exit_critical(irq_mask);
+
+    return TAL_MEM_USER(hdr);
+}
+
+static void __mem_free(void *ptr, void *caller)
+{
+    TAL_MEM_HDR_T *hdr = TAL_MEM_HDR(ptr);
+    uint8_t kind = hdr->kind & TAL_MEM_KIND_MASK;
+    uint32_t irq_mask;
+
+    if (kind == TAL_MEM_KIND_HEAP || kind == TAL_MEM_KIND_PSRAM_HEAP) {
+        irq_mask = tal_system_enter_critical();
+        __mem_account_free(hdr);
+        hdr->kind = 0;
+        tal_system_exit_critical(irq_mask);
+        __mem_raw_free(kind == TAL_MEM_KIND_PSRAM_HEAP, hdr);
+        return;
+    }
+
+#if TAL_MEM_POOL
+    if ((kind == TAL_MEM_KIND_POOL || kind == TAL_MEM_KIND_PSRAM_POOL) && (hdr->slab < TAL_MEMORY_POOL_SLAB_NUM)) {
+        uint8_t region = sg_mem_slab[hdr->slab].region;
+        uint8_t *release = __mem_pool_put(hdr);
+        if (release) {
+            __mem_raw_free(region, release);
+        }
+        return;
+    }
+#endif
+
+    PR_ERR("0x%x free invalid or freed block %p", caller, ptr);
+}
+
+static size_t __mem_capacity(TAL_MEM_HDR_T *hdr)
+{
+#if TAL_MEM_POOL
+    uint8_t kind = hdr->kind & TAL_MEM_KIND_MASK;
+    if (kind == TAL_MEM_KIND_POOL || kind == TAL_MEM_KIND_PSRAM_POOL) {
+        return sg_mem_class_size[hdr->kind & TAL_MEM_CLASS_MASK];
+    }
+#endif
+    return hdr->size;
+}
+
+static void *__mem_realloc(uint8_t region, void *ptr, size_t size, void *caller)
+{
+    TAL_MEM_HDR_T *hdr = NULL, *new_hdr = NULL;
+    uint8_t kind;
+    uint32_t irq_mask;
+    void *new_ptr = NULL;
+
+    if (NULL == ptr) {
+        return __mem_alloc(region, size, caller);
+    }
+
+    if (0 == size) {
+        __mem_free(ptr, caller);
+        return NULL;
+    }
+
+    hdr = TAL_MEM_HDR(ptr);
+    kind = hdr->kind & TAL_MEM_KIND_MASK;
+
+    // Shrinking or growing inside the same size class keeps the block
+    if ((kind == TAL_MEM_KIND_POOL || kind == TAL_MEM_KIND_PSRAM_POOL) && size <= __mem_capacity(hdr)) {
+        irq_mask = tal_system_enter_critical();
+        __mem_account_free(hdr);
+        hdr->size = (uint32_t)size;
+        sg_mem_stats.live_bytes += hdr->size;
+        sg_mem_stats.live_cnt++;
+#if TAL_MEM_PROFILE
+        if (hdr->site < TAL_MEMORY_PROFILE_SITE_NUM) {
+            sg_mem_site[hdr->site].live_bytes += hdr->size;
+            sg_mem_site[hdr->site].live_cnt++;
+        }
+#endif
+        tal_system_exit_critical(irq_mask);
+        return ptr;
+    }
+
+    // Large blocks keep using the heap realloc, which may grow in place
+    if (kind == TAL_MEM_KIND_HEAP || kind == TAL_MEM_KIND_PSRAM_HEAP) {
+#if TAL_MEM_POOL
+        if (__mem_class_get(size) < 0)
+#endif
+        {
+            uint32_t old_size = hdr->size;
+
+            if (size > 0xFFFFFFFF - sizeof(TAL_MEM_HDR_T)) {
+                return NULL;
+            }
+            new_hdr = __mem_raw_realloc(kind == TAL_MEM_KIND_PSRAM_HEAP, hdr, sizeof(TAL_MEM_HDR_T) + size);
+            if (NULL == new_hdr) {
+                return NULL;
+            }
+
+            irq_mask = tal_system_enter_critical();
+            new_hdr->size = old_size;
+            __mem_account_free(new_hdr);
+            new_hdr->size = (uint32_t)size;
+            sg_mem_stats.live_bytes += new_hdr->size;
+            sg_mem_stats.live_cnt++;
+            if (sg_mem_stats.live_bytes > sg_mem_stats.peak_bytes) {
+                sg_mem_stats.peak_bytes = sg_mem_stats.live_bytes;
+            }
+#if TAL_MEM_PROFILE
+            if (new_hdr->site < TAL_MEMORY_PROFILE_SITE_NUM) {
+                TAL_MEM_SITE_T *site = &sg_mem_site[new_hdr->site];
+                site->live_bytes += new_hdr->size;
+                site->live_cnt++;
+                if (site->live_bytes > site->peak_bytes) {
+                    site->peak_bytes = site->live_bytes;
+                }
+            }
+#endif
+            tal_system_exit_critical(irq_mask);
+            return TAL_MEM_USER(new_hdr);
+        }
+    }
+
+    if (kind != TAL_MEM_KIND_HEAP && kind != TAL_MEM_KIND_PSRAM_HEAP && kind != TAL_MEM_KIND_POOL &&
+        kind != TAL_MEM_KIND_PSRAM_POOL) {
+        PR_ERR("0x%x realloc invalid or freed block %p", caller, ptr);
+        return NULL;
+    }
+
+    new_ptr = __mem_alloc(region, size, caller);
+    if (NULL == new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, (hdr->size < size) ? hdr->size : size);
+    __mem_free(ptr, caller);
+
+    return new_ptr;
+}
+#endif
+
+/**
+ * @brief Allocates a block of memory of the specified size.
+ *
+ * This function is used to dynamically allocate memory of the specified size.
+ *
+ * @param size The size of the memory block to allocate.
+ * @return A pointer to the allocated memory block, or NULL if the allocation
+ * fails.
+ */
+void *tal_malloc(size_t size)
+{
+    if (0 == size) {
+        return NULL;
+    }
+
+    void *ptr = NULL;
+#if TAL_MEM_LAYER
+    ptr = __mem_alloc(0, size, __builtin_return_address(0));
+#else
+    ptr = tkl_system_malloc(size);
+#endif
+    if (NULL == ptr) {
+        PR_ERR("0x%x malloc failed:0x%x free:0x%x", __builtin_return_address(0), size, tal_system_get_free_heap_size());
+    }
+
+    return ptr;
+}
+
+/**
+ * @brief Frees the memory pointed to by the given pointer.
+ *
+ * This function is used to deallocate memory that was previously allocated
+ * using the `malloc` or `calloc` functions. It takes a pointer to the memory
+ * block that needs to be freed and releases the memory back to the system.
+ *
+ * @param ptr Pointer to the memory block to be freed.
+ */
+void tal_free(void *ptr)
+{
+    if (NULL == ptr) {
+        return;
+    }
+
+#if TAL_MEM_LAYER
+    __mem_free(ptr, __builtin_return_address(0));
+#else
+    tkl_system_free(ptr);
+#endif
+}
+
+/**
+ * Allocates memory for an array of elements, initialized to zero.
+ *
+ * This function allocates memory for an array of elements, where each element
+ * is of size 'size'. The memory is initialized to zero.
+ *
+ * @param nitems The number of elements to allocate memory for.
+ * @param size The size of each element in bytes.
+ * @return A pointer to the allocated memory, or NULL if the allocation fails.
+ */
+void *tal_calloc(size_t nitems, size_t size)
+{
+#if TAL_MEM_LAYER
+    void *ptr = NULL;
+
+    if (0 == nitems || 0 == size || nitems > ((size_t)-1) / size) {
+        return NULL;
+    }
+
+    ptr = __mem_alloc(0, nitems * size, __builtin_return_address(0));
+    if (ptr) {
+        memset(ptr, 0, nitems * size);
+    }
+
+    return ptr;
+#else
+    return tkl_system_calloc(nitems, size);
+#endif
+}
+
+/**
+ * @brief Reallocates a block of memory.
+ *
+ *
+ * @param ptr   Pointer to the memory block to be reallocated.
+ * @param size  New size for the memory block, in bytes.
+ * @return      Pointer to the reallocated memory block, or `NULL` if the
+ * operation fails.
+ */
+void *tal_realloc(void *ptr, size_t size)
+{
+#if TAL_MEM_LAYER
+    return __mem_realloc(0, ptr, size, __builtin_return_address(0));
+#else
+    return tkl_system_realloc(ptr, size);
+#endif
+}
+
+#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
+void *tal_psram_malloc(size_t size)
+{
+    if (0 == size) {
+        return NULL;
+    }
+
+    void *ptr = NULL;
+#if TAL_MEM_LAYER
+    ptr = __mem_alloc(1, size, __builtin_return_address(0));
+#else
+    ptr = tkl_system_psram_malloc(size);
+#endif
+
+    if (NULL == ptr) {
+        PR_ERR("0x%x psram malloc failed:0x%x free:0x%x", __builtin_return_address(0), size,
+               tal_system_get_free_heap_size());
+    }
+
+    return ptr;
+}
+
+void tal_psram_free(void *ptr)
+{
+    if (NULL == ptr) {
+        return;
+    }
+
+#if TAL_MEM_LAYER
+    __mem_free(ptr, __builtin_return_address(0));
+#else
+    tkl_system_psram_free(ptr);
+#endif
+}
+
+void *tal_psram_calloc(size_t nitems, size_t size)
+{
+#if TAL_MEM_LAYER
+    void *ptr = NULL;
+
+    if (0 == nitems || 0 == size || nitems > ((size_t)-1) / size) {
+        return NULL;
+    }
+
+    ptr = __mem_alloc(1, nitems * size, __builtin_return_address(0));
+    if (ptr) {
+        memset(ptr, 0, nitems * size);
+    }
+
+    return ptr;
+#else
+    return tkl_system_psram_calloc(nitems, size);
+#endif
+}
+
+void *tal_psram_realloc(void *ptr, size_t size)
+{
+#if TAL_MEM_LAYER
+    return __mem_realloc(1, ptr, size, __builtin_return_address(0));
+#else
+    return tkl_system_psram_realloc(ptr, size);
+#endif
+}
+#endif
+
+/**
+ * @brief Get the statistics of the pool and profiling layer
+ *
+ * @param[out] stats: statistics
+ *
+ * @return OPRT_OK on success, OPRT_NOT_SUPPORTED if neither
+ * ENABLE_TAL_MEMORY_POOL nor ENABLE_TAL_MEMORY_PROFILE is enabled
+ */
+OPERATE_RET tal_memory_get_stats(TAL_MEMORY_STATS_T *stats)
+{
+    if (NULL == stats) {
+        return OPRT_INVALID_PARM;
+    }
+
+#if TAL_MEM_LAYER
+    uint32_t irq_mask = tal_system_enter_critical();
+    *stats = sg_mem_stats;
+    tal_system_exit_critical(irq_mask);
+
+    return OPRT_OK;
+#else
+    memset(stats, 0, sizeof(TAL_MEMORY_STATS_T));
+    return OPRT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Restart the peak_bytes watermark from the current live bytes
+ *
+ * @return none
+ */
+void tal_memory_peak_reset(void)
+{
+#if TAL_MEM_LAYER
+    uint32_t irq_mask = tal_system_enter_critical();
+    sg_mem_stats.peak_bytes = sg_mem_stats.live_bytes;
+    tal_system_exit_critical(irq_mask);
+#endif
+}
+
+/**
+ * @brief Print the heap profile
+ *
+ * @param[in] leak_only: only list the call sites still holding memory
+ *
+ * @return none
+ */
+void tal_memory_profile_dump(BOOL_T leak_only)
+{
+#if TAL_MEM_LAYER
+    TAL_MEMORY_STATS_T stats;
+    uint32_t now_ms = (uint32_t)tal_system_get_millisecond();
+
+    tal_memory_get_stats(&stats);
+
+#if TAL_MEM_PROFILE
+    uint32_t elapsed_ms = now_ms - sg_mem_last_dump_ms;
+    uint32_t i;
+
+    if (0 == elapsed_ms) {
+        elapsed_ms = 1;
+    }
+
+    PR_NOTICE("heap live:%d peak:%d blocks:%d allocs:%d rate:%d/s", stats.live_bytes, stats.peak_bytes,
+              stats.live_cnt, stats.alloc_cnt,
+              (uint32_t)((uint64_t)(stats.alloc_cnt - sg_mem_last_alloc_cnt) * 1000 / elapsed_ms));
+    PR_NOTICE("%-10s %10s %8s %10s %10s %8s", "caller", "live", "blocks", "peak", "allocs", "rate/s");
+    for (i = 0; i < TAL_MEMORY_PROFILE_SITE_NUM; i++) {
+        TAL_MEM_SITE_T site;
+        uint32_t irq_mask = tal_system_enter_critical();
+        site = sg_mem_site[i];
+        sg_mem_site[i].last_alloc_cnt = site.alloc_cnt;
+        tal_system_exit_critical(irq_mask);
+
+        if (0 == site.alloc_cnt || (leak_only && 0 == site.live_cnt)) {
+            continue;
+        }
+        PR_NOTICE("%p%s %10d %8d %10d %10d %8d", site.caller, (0 == i) ? "(other)" : "", site.live_bytes,
+                  site.live_cnt, site.peak_bytes, site.alloc_cnt,
+                  (uint32_t)((uint64_t)(site.alloc_cnt - site.last_alloc_cnt) * 1000 / elapsed_ms));
+    }
+    sg_mem_last_alloc_cnt = stats.alloc_cnt;
+    sg_mem_last_dump_ms = now_ms;
+#else
+    (void)leak_only;
+    (void)now_ms;
+    PR_NOTICE("heap live:%d peak:%d blocks:%d allocs:%d", stats.live_bytes, stats.peak_bytes, stats.live_cnt,
+              stats.alloc_cnt);
+#endif
+    PR_NOTICE("pool slabs:%d bytes:%d free blocks:%d", stats.pool_slabs, stats.pool_bytes, stats.pool_free_blocks);
+#else
+    (void)leak_only;
+    PR_NOTICE("heap profile not enabled, free heap:%d", tal_system_get_free_heap_size());
+#endif
+}
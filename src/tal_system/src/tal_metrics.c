@@ -0,0 +1,153 @@
+/**
+ * @file tal_metrics.c
+ * @brief Implements the metrics registry declared in tal_metrics.h.
+ *
+ * The registry is a singly linked list threaded through the metric objects.
+ * Metrics are only ever added, at the head and inside a critical section, and
+ * a metric is fully set up before it becomes the head, so readers walk the
+ * list without any lock.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdio.h>
+
+#include "tal_system.h"
+#include "tal_metrics.h"
+
+/***********************************************************
+*************************micro define***********************
+***********************************************************/
+#define TAL_METRIC_LINE_LEN 128
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+#if TAL_METRICS_ON
+static TAL_METRIC_T *volatile sg_metric_head = NULL;
+#endif
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+
+/**
+ * @brief Add a metric to the registry, a metric already registered is ignored
+ *
+ * @param[in] metric: metric, it must stay valid for the life of the program
+ *
+ * @return OPRT_OK on success, OPRT_NOT_SUPPORTED without ENABLE_TAL_METRICS
+ */
+OPERATE_RET tal_metric_register(TAL_METRIC_T *metric)
+{
+#if TAL_METRICS_ON
+    if (NULL == metric || NULL == metric->name) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TAL_ENTER_CRITICAL();
+    if (!metric->registered) {
+        metric->registered = 1;
+        metric->next = sg_metric_head;
+        sg_metric_head = metric;
+    }
+    TAL_EXIT_CRITICAL();
+
+    return OPRT_OK;
+#else
+    return OPRT_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @brief Call cb for every registered metric
+ *
+ * @param[in] cb: visitor
+ * @param[in] arg: visitor argument
+ *
+ * @return none
+ */
+void tal_metrics_foreach(TAL_METRIC_VISIT_CB cb, void *arg)
+{
+#if TAL_METRICS_ON
+    TAL_METRIC_T *metric = NULL;
+
+    if (NULL == cb) {
+        return;
+    }
+
+    for (metric = sg_metric_head; metric; metric = metric->next) {
+        cb(metric, arg);
+    }
+#endif
+}
+
+#if TAL_METRICS_ON
+static void __metric_hist_print(const TAL_METRIC_HIST_T *hist, TAL_METRIC_LINE_CB cb, void *arg, char *line)
+{
+    const char *name = hist->base.name;
+    uint32_t cumulative = 0;
+    uint32_t i;
+
+    for (i = 0; i < TAL_METRIC_HIST_BUCKETS - 1 && i + hist->base.shift < 32; i++) {
+        cumulative += hist->bucket[i];
+        snprintf(line, TAL_METRIC_LINE_LEN, "%s_bucket{le=\"%u\"} %u", name,
+                 (unsigned)((1UL << (i + hist->base.shift)) - 1), (unsigned)cumulative);
+        cb(line, arg);
+    }
+    for (; i < TAL_METRIC_HIST_BUCKETS; i++) {
+        cumulative += hist->bucket[i];
+    }
+    snprintf(line, TAL_METRIC_LINE_LEN, "%s_bucket{le=\"+Inf\"} %u", name, (unsigned)cumulative);
+    cb(line, arg);
+    snprintf(line, TAL_METRIC_LINE_LEN, "%s_sum %u", name, (unsigned)hist->base.sum);
+    cb(line, arg);
+    snprintf(line, TAL_METRIC_LINE_LEN, "%s_count %u", name, (unsigned)cumulative);
+    cb(line, arg);
+}
+
+static void __metric_print(const TAL_METRIC_T *metric, void *arg)
+{
+    static const char *type_name[] = {"counter", "gauge", "histogram"};
+    void **ctx = (void **)arg;
+    TAL_METRIC_LINE_CB cb = (TAL_METRIC_LINE_CB)ctx[0];
+    char line[TAL_METRIC_LINE_LEN];
+
+    if (metric->help) {
+        snprintf(line, sizeof(line), "# HELP %s %s", metric->name, metric->help);
+        cb(line, ctx[1]);
+    }
+    snprintf(line, sizeof(line), "# TYPE %s %s", metric->name, type_name[metric->type]);
+    cb(line, ctx[1]);
+
+    if (TAL_METRIC_HISTOGRAM == metric->type) {
+        __metric_hist_print((const TAL_METRIC_HIST_T *)metric, cb, ctx[1], line);
+    } else {
+        snprintf(line, sizeof(line), "%s %u", metric->name, (unsigned)metric->value);
+        cb(line, ctx[1]);
+    }
+}
+#endif
+
+/**
+ * @brief Print every registered metric in the Prometheus text format, one
+ * line per call of cb, without the line feed
+ *
+ * @param[in] cb: line output
+ * @param[in] arg: line output argument
+ *
+ * @return none
+ */
+void tal_metrics_print(TAL_METRIC_LINE_CB cb, void *arg)
+{
+#if TAL_METRICS_ON
+    void *ctx[2] = {(void *)cb, arg};
+
+    if (NULL == cb) {
+        return;
+    }
+
+    tal_metrics_foreach(__metric_print, ctx);
+#endif
+}
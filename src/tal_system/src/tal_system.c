@@ -3,16 +3,13 @@
  * @brief Implements system-level functionalities for Tuya IoT applications.
  *
  * This source file provides the implementation of system-level functionalities
- * for Tuya IoT applications, including memory allocation and deallocation. It
- * serves as a wrapper around the Tuya Kernel Layer (TKL) memory management
- * functions, offering a simplified interface for dynamic memory management
- * within the Tuya Abstract Layer (TAL). Additionally, it integrates logging
- * functionalities to report memory allocation failures, aiding in the debugging
- * and monitoring of memory usage.
+ * for Tuya IoT applications. It serves as a wrapper around the Tuya Kernel
+ * Layer (TKL) system functions such as sleep, reset, critical sections and
+ * free heap size. The heap allocation functions live in tal_memory.c.
  *
  * Key functionalities include:
- * - Dynamic memory allocation and deallocation.
- * - Logging of memory allocation failures with current free heap size.
+ * - System sleep, reset and critical sections.
+ * - Free heap size query.
  * - Integration with Tuya's IoT SDK for system-level operations.
  *
  * The implementation aims to provide robust and efficient memory management
@@ -34,115 +31,6 @@
 #include "tal_log.h"
 #include "tal_memory.h"
 
-/**
- * @brief Allocates a block of memory of the specified size.
- *
- * This function is used to dynamically allocate memory of the specified size.
- *
- * @param size The size of the memory block to allocate.
- * @return A pointer to the allocated memory block, or NULL if the allocation
- * fails.
- */
-void *tal_malloc(size_t size)
-{
-    if (0 == size) {
-        return NULL;
-    }
-
-    void *ptr = NULL;
-    ptr = tkl_system_malloc(size);
-    if (NULL == ptr) {
-        PR_ERR("0x%x malloc failed:0x%x free:0x%x", __builtin_return_address(0), size, tal_system_get_free_heap_size());
-    }
-
-    return ptr;
-}
-
-/**
- * @brief Frees the memory pointed to by the given pointer.
- *
- * This function is used to deallocate memory that was previously allocated
- * using the `malloc` or `calloc` functions. It takes a pointer to the memory
- * block that needs to be freed and releases the memory back to the system.
- *
- * @param ptr Pointer to the memory block to be freed.
- */
-void tal_free(void *ptr)
-{
-    if (NULL == ptr) {
-        return;
-    }
-
-    tkl_system_free(ptr);
-}
-
-/**
- * Allocates memory for an array of elements, initialized to zero.
- *
- * This function allocates memory for an array of elements, where each element
- * is of size 'size'. The memory is initialized to zero.
- *
- * @param nitems The number of elements to allocate memory for.
- * @param size The size of each element in bytes.
- * @return A pointer to the allocated memory, or NULL if the allocation fails.
- */
-void *tal_calloc(size_t nitems, size_t size)
-{
-    return tkl_system_calloc(nitems, size);
-}
-
-/**
- * @brief Reallocates a block of memory.
- *
- *
- * @param ptr   Pointer to the memory block to be reallocated.
- * @param size  New size for the memory block, in bytes.
- * @return      Pointer to the reallocated memory block, or `NULL` if the
- * operation fails.
- */
-void *tal_realloc(void *ptr, size_t size)
-{
-    return tkl_system_realloc(ptr, size);
-}
-
-#if defined(ENABLE_EXT_RAM) && (ENABLE_EXT_RAM == 1)
-void *tal_psram_malloc(size_t size)
-{
-    if (0 == size) {
-        return NULL;
-    }
-
-    void *ptr = NULL;
-    ptr = tkl_system_psram_malloc(size);
-
-    if (NULL == ptr) {
-        PR_ERR("0x%x psram malloc failed:0x%x free:0x%x", __builtin_return_address(0), size,
-               tal_system_get_free_heap_size());
-    }
-
-    return ptr;
-}
-
-void tal_psram_free(void *ptr)
-{
-    if (NULL == ptr) {
-        return;
-    }
-
-    tkl_system_psram_free(ptr);
-}
-
-void *tal_psram_calloc(size_t nitems, size_t size)
-{
-    return tkl_system_psram_calloc(nitems, size);
-}
-
-void *tal_psram_realloc(void *ptr, size_t size)
-{
-    return tkl_system_psram_realloc(ptr, size);
-}
-#endif
-
 /**
  * @brief Sleeps for the specified amount of time in milliseconds.
  *
@@ -0,0 +1,361 @@
+/**
+ * @file test_mem_budget.cpp
+ * @brief Unit tests of the memory budgets on a simulated split heap.
+ *
+ * The heap is replaced with tal_mem_budget_set_heap by one that only counts
+ * the bytes of each RAM against a capacity, so the tests choose when internal
+ * RAM or PSRAM is full. The last test records a camera device session through
+ * the trace hook and replays it on 512 KB of internal RAM and 6 MB of PSRAM,
+ * once without limits and once with a limit per subsystem.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tal_mem_budget.h"
+
+#define TEST_SRAM_SIZE  (512 * 1024)
+#define TEST_PSRAM_SIZE (6 * 1024 * 1024)
+
+#define TEST_ROUNDS      60 // session rounds, viewers join and leave every round
+#define TEST_VIEWER_MAX  8  // viewers at the same time
+#define TEST_VIEWER_BUFS 3  // RTP buffers per viewer
+#define TEST_CAM_RAW     2  // raw camera frames
+#define TEST_CAM_ENC     8  // encoded camera frames
+
+#define TEST_DISP_FB_SIZE  (480 * 272 * 2)
+#define TEST_DRAW_BUF_SIZE (TEST_DISP_FB_SIZE / 10)
+#define TEST_AUDIO_SIZE    (32 * 1024)
+#define TEST_CAM_RAW_SIZE  (640 * 480 * 2)
+#define TEST_CAM_ENC_SIZE  (TEST_CAM_RAW_SIZE / 5)
+#define TEST_RTP_SIZE      (256 * 1024)
+
+/**
+ * @brief Split heap that counts bytes per RAM, DMA buffers are in internal RAM
+ */
+typedef struct {
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t peak;
+} TEST_REGION_T;
+
+static TEST_REGION_T sg_region[TAL_MEM_PLACE_NUM];
+static uint32_t sg_heap_calls;
+
+static TEST_REGION_T *__sim_region(TAL_MEM_PLACE_E place)
+{
+    return &sg_region[(TAL_MEM_PLACE_DMA == place) ? TAL_MEM_PLACE_SRAM : place];
+}
+
+static void *__sim_malloc(TAL_MEM_PLACE_E place, size_t size)
+{
+    TEST_REGION_T *region = __sim_region(place);
+    uint64_t *blk = NULL;
+
+    sg_heap_calls++;
+    if (size > region->capacity - region->used) {
+        return NULL;
+    }
+    blk = (uint64_t *)malloc(sizeof(uint64_t) + size);
+    if (NULL == blk) {
+        return NULL;
+    }
+    blk[0] = size;
+    region->used += size;
+    if (region->used > region->peak) {
+        region->peak = region->used;
+    }
+    return blk + 1;
+}
+
+static void __sim_free(TAL_MEM_PLACE_E place, void *ptr)
+{
+    uint64_t *blk = (uint64_t *)ptr - 1;
+
+    __sim_region(place)->used -= (uint32_t)blk[0];
+    free(blk);
+}
+
+static const TAL_MEM_BUDGET_HEAP_T sg_sim_heap = {__sim_malloc, __sim_free};
+
+/* the budgets of a camera device with a screen */
+static TAL_MEM_BUDGET_DEFINE(sg_disp_fb, "ut_disp_fb", 0, TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
+static TAL_MEM_BUDGET_DEFINE(sg_lvgl_draw, "ut_lvgl_draw", 0, TAL_MEM_PLACE_DMA, 0);
+static TAL_MEM_BUDGET_DEFINE(sg_ai_audio, "ut_ai_audio", 0, TAL_MEM_PLACE_SRAM, 0);
+static TAL_MEM_BUDGET_DEFINE(sg_camera, "ut_camera_frame", 0, TAL_MEM_PLACE_PSRAM, TAL_MEM_BUDGET_STRICT);
+static TAL_MEM_BUDGET_DEFINE(sg_p2p, "ut_p2p_media", 0, TAL_MEM_PLACE_PSRAM, 0);
+
+static TAL_MEM_BUDGET_T *sg_budget[] = {&sg_disp_fb, &sg_lvgl_draw, &sg_ai_audio, &sg_camera, &sg_p2p};
+
+/* one line of the trace: a buffer taken or released */
+typedef struct {
+    std::string name;
+    uint32_t size; // 0: released
+    const void *ptr;
+} TEST_TRACE_T;
+
+static std::vector<TEST_TRACE_T> sg_trace;
+
+static void __trace_record(const TAL_MEM_BUDGET_T *budget, const void *ptr, uint32_t size, TAL_MEM_PLACE_E place)
+{
+    (void)place;
+    if (ptr) {
+        sg_trace.push_back({budget->name, size, ptr});
+    }
+}
+
+class MemBudgetTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        memset(sg_region, 0, sizeof(sg_region));
+        sg_region[TAL_MEM_PLACE_SRAM].capacity = TEST_SRAM_SIZE;
+        sg_region[TAL_MEM_PLACE_PSRAM].capacity = TEST_PSRAM_SIZE;
+        for (TAL_MEM_BUDGET_T *budget : sg_budget) {
+            tal_mem_budget_set_limit(budget, 0);
+            tal_mem_budget_peak_reset(budget);
+        }
+        tal_mem_budget_set_heap(&sg_sim_heap);
+    }
+
+    void TearDown() override
+    {
+        for (TAL_MEM_BUDGET_T *budget : sg_budget) {
+            TAL_MEM_BUDGET_STATS_T stats;
+            tal_mem_budget_get_stats(budget, &stats);
+            EXPECT_EQ(0u, stats.live_bytes) << budget->name << " still holds buffers";
+        }
+        tal_mem_budget_set_trace(NULL);
+        tal_mem_budget_set_heap(NULL);
+    }
+
+    static TAL_MEM_BUDGET_STATS_T stats_of(const TAL_MEM_BUDGET_T *budget)
+    {
+        TAL_MEM_BUDGET_STATS_T stats;
+        tal_mem_budget_get_stats(budget, &stats);
+        return stats;
+    }
+};
+
+TEST_F(MemBudgetTest, OverLimitRefusedBeforeHeap)
+{
+    TAL_MEM_BUDGET_STATS_T before = stats_of(&sg_ai_audio);
+
+    ASSERT_EQ(OPRT_OK, tal_mem_budget_set_limit(&sg_ai_audio, 96 * 1024));
+    void *first = tal_mem_budget_malloc(&sg_ai_audio, 64 * 1024);
+    ASSERT_NE(nullptr, first);
+
+    uint32_t calls = sg_heap_calls;
+    EXPECT_EQ(nullptr, tal_mem_budget_malloc(&sg_ai_audio, 64 * 1024));
+    EXPECT_EQ(calls, sg_heap_calls) << "the heap was asked for a request over the limit";
+    EXPECT_EQ(before.over_cnt + 1, stats_of(&sg_ai_audio).over_cnt);
+    EXPECT_EQ(64u * 1024, stats_of(&sg_ai_audio).live_bytes);
+
+    tal_mem_budget_free(first);
+    void *second = tal_mem_budget_malloc(&sg_ai_audio, 64 * 1024);
+    EXPECT_NE(nullptr, second) << "the released bytes were not given back to the budget";
+    tal_mem_budget_free(second);
+}
+
+TEST_F(MemBudgetTest, FallbackUnlessStrict)
+{
+    TAL_MEM_BUDGET_STATS_T p2p = stats_of(&sg_p2p);
+    TAL_MEM_BUDGET_STATS_T camera = stats_of(&sg_camera);
+
+    sg_region[TAL_MEM_PLACE_PSRAM].capacity = 0;
+
+    void *ptr = tal_mem_budget_malloc(&sg_p2p, 4096);
+    ASSERT_NE(nullptr, ptr) << "a full PSRAM did not fall back to internal RAM";
+    EXPECT_EQ(p2p.fallback_cnt + 1, stats_of(&sg_p2p).fallback_cnt);
+    EXPECT_EQ(4096u, stats_of(&sg_p2p).place_bytes[TAL_MEM_PLACE_SRAM]);
+    EXPECT_GE(sg_region[TAL_MEM_PLACE_SRAM].used, 4096u);
+    EXPECT_EQ(0u, sg_region[TAL_MEM_PLACE_PSRAM].used);
+
+    EXPECT_EQ(nullptr, tal_mem_budget_malloc(&sg_camera, 4096)) << "a strict budget left its RAM";
+    EXPECT_EQ(camera.fail_cnt + 1, stats_of(&sg_camera).fail_cnt);
+
+    tal_mem_budget_free(ptr);
+    EXPECT_EQ(0u, sg_region[TAL_MEM_PLACE_SRAM].used);
+}
+
+TEST_F(MemBudgetTest, DmaNeverInPsram)
+{
+    sg_region[TAL_MEM_PLACE_SRAM].capacity = 0;
+
+    EXPECT_EQ(nullptr, tal_mem_budget_malloc(&sg_lvgl_draw, TEST_DRAW_BUF_SIZE));
+    EXPECT_EQ(0u, sg_region[TAL_MEM_PLACE_PSRAM].used);
+}
+
+/* the buffers of a session, taken and released as a device would */
+typedef struct {
+    void *disp_fb[2];
+    void *draw_buf[2];
+    void *audio[2];
+    void *cam_raw[TEST_CAM_RAW];
+    void *cam_enc[TEST_CAM_ENC];
+    void *rtp[TEST_VIEWER_MAX][TEST_VIEWER_BUFS];
+} TEST_SESSION_T;
+
+static void __session_take(void **slot, TAL_MEM_BUDGET_T *budget, uint32_t size)
+{
+    if (NULL == *slot) {
+        *slot = tal_mem_budget_malloc(budget, size);
+    }
+}
+
+static void __session_drop(void **slot, uint32_t num)
+{
+    for (uint32_t i = 0; i < num; i++) {
+        tal_mem_budget_free(slot[i]);
+        slot[i] = NULL;
+    }
+}
+
+static void __session_camera_start(TEST_SESSION_T *session)
+{
+    for (uint32_t i = 0; i < TEST_CAM_RAW; i++) {
+        __session_take(&session->cam_raw[i], &sg_camera, TEST_CAM_RAW_SIZE);
+    }
+    for (uint32_t i = 0; i < TEST_CAM_ENC; i++) {
+        __session_take(&session->cam_enc[i], &sg_camera, TEST_CAM_ENC_SIZE);
+    }
+}
+
+static void __session_run(void)
+{
+    TEST_SESSION_T session;
+    uint32_t seed = 0x5EED;
+
+    memset(&session, 0, sizeof(session));
+    __session_take(&session.disp_fb[0], &sg_disp_fb, TEST_DISP_FB_SIZE);
+    __session_take(&session.disp_fb[1], &sg_disp_fb, TEST_DISP_FB_SIZE);
+    __session_camera_start(&session);
+
+    for (uint32_t round = 0; round < TEST_ROUNDS; round++) {
+        // the screen changes, LVGL draw buffers are set up again
+        if (0 == round % 3) {
+            __session_drop(session.draw_buf, 2);
+        }
+        __session_take(&session.draw_buf[0], &sg_lvgl_draw, TEST_DRAW_BUF_SIZE);
+        __session_take(&session.draw_buf[1], &sg_lvgl_draw, TEST_DRAW_BUF_SIZE);
+
+        // a conversation opens the mic and speaker rings
+        __session_drop(session.audio, 2);
+        __session_take(&session.audio[0], &sg_ai_audio, TEST_AUDIO_SIZE);
+        __session_take(&session.audio[1], &sg_ai_audio, TEST_AUDIO_SIZE);
+
+        // the camera switches resolution, a viewer may join while it restarts
+        if (0 == round % 5) {
+            __session_drop(session.cam_raw, TEST_CAM_RAW);
+            __session_drop(session.cam_enc, TEST_CAM_ENC);
+        }
+
+        // viewers come and go
+        for (uint32_t v = 0; v < TEST_VIEWER_MAX; v++) {
+            seed = seed * 1103515245 + 12345;
+            uint32_t dice = (seed >> 8) % 4;
+            if (0 == dice) {
+                __session_drop(session.rtp[v], TEST_VIEWER_BUFS);
+            } else if (dice > 1) {
+                for (uint32_t i = 0; i < TEST_VIEWER_BUFS; i++) {
+                    __session_take(&session.rtp[v][i], &sg_p2p, TEST_RTP_SIZE);
+                }
+            }
+        }
+
+        __session_camera_start(&session);
+    }
+
+    __session_drop((void **)&session, sizeof(session) / sizeof(void *));
+}
+
+/* replays the trace with a limit per budget, returns the usage each budget added */
+static std::map<std::string, TAL_MEM_BUDGET_STATS_T> __trace_replay(const uint32_t *limit)
+{
+    std::map<std::string, TAL_MEM_BUDGET_STATS_T> before, added;
+    std::map<const void *, void *> live;
+
+    for (TAL_MEM_PLACE_E place : {TAL_MEM_PLACE_SRAM, TAL_MEM_PLACE_PSRAM}) {
+        sg_region[place].used = 0;
+        sg_region[place].peak = 0;
+    }
+    for (uint32_t i = 0; i < CNTSOF(sg_budget); i++) {
+        tal_mem_budget_set_limit(sg_budget[i], limit ? limit[i] : 0);
+        tal_mem_budget_peak_reset(sg_budget[i]);
+        tal_mem_budget_get_stats(sg_budget[i], &before[sg_budget[i]->name]);
+    }
+
+    for (const TEST_TRACE_T &line : sg_trace) {
+        if (line.size) {
+            TAL_MEM_BUDGET_T *budget = tal_mem_budget_find(line.name.c_str());
+            if (budget) {
+                live[line.ptr] = tal_mem_budget_malloc(budget, line.size);
+            }
+        } else if (live.count(line.ptr)) {
+            tal_mem_budget_free(live[line.ptr]);
+            live.erase(line.ptr);
+        }
+    }
+
+    for (TAL_MEM_BUDGET_T *budget : sg_budget) {
+        TAL_MEM_BUDGET_STATS_T stats, &from = before[budget->name];
+        tal_mem_budget_get_stats(budget, &stats);
+        stats.over_cnt -= from.over_cnt;
+        stats.fail_cnt -= from.fail_cnt;
+        stats.fallback_cnt -= from.fallback_cnt;
+        added[budget->name] = stats;
+    }
+    return added;
+}
+
+TEST_F(MemBudgetTest, TraceReplay)
+{
+    // record on heaps large enough for everything
+    sg_region[TAL_MEM_PLACE_SRAM].capacity = UINT32_MAX;
+    sg_region[TAL_MEM_PLACE_PSRAM].capacity = UINT32_MAX;
+    sg_trace.clear();
+    tal_mem_budget_set_trace(__trace_record);
+    __session_run();
+    tal_mem_budget_set_trace(NULL);
+    ASSERT_FALSE(sg_trace.empty());
+
+    sg_region[TAL_MEM_PLACE_SRAM].capacity = TEST_SRAM_SIZE;
+    sg_region[TAL_MEM_PLACE_PSRAM].capacity = TEST_PSRAM_SIZE;
+
+    // without limits the viewers take the PSRAM the camera needs and spill into internal RAM
+    auto open = __trace_replay(NULL);
+    EXPECT_GT(open["ut_p2p_media"].fallback_cnt, 0u);
+    EXPECT_GT(open["ut_camera_frame"].fail_cnt, 0u);
+    EXPECT_LE(sg_region[TAL_MEM_PLACE_SRAM].peak, (uint32_t)TEST_SRAM_SIZE);
+    EXPECT_LE(sg_region[TAL_MEM_PLACE_PSRAM].peak, (uint32_t)TEST_PSRAM_SIZE);
+    RecordProperty("open_p2p_fallbacks", open["ut_p2p_media"].fallback_cnt);
+    RecordProperty("open_camera_failures", open["ut_camera_frame"].fail_cnt);
+
+    // with limits the viewers past theirs are refused up front, nothing else fails
+    const uint32_t limit[] = {
+        2 * TEST_DISP_FB_SIZE,
+        64 * 1024,
+        96 * 1024,
+        TEST_CAM_RAW * TEST_CAM_RAW_SIZE + TEST_CAM_ENC * TEST_CAM_ENC_SIZE,
+        4 * TEST_VIEWER_BUFS * TEST_RTP_SIZE,
+    };
+    auto capped = __trace_replay(limit);
+    EXPECT_GT(capped["ut_p2p_media"].over_cnt, 0u);
+    for (TAL_MEM_BUDGET_T *budget : sg_budget) {
+        EXPECT_EQ(0u, capped[budget->name].fail_cnt) << budget->name;
+        EXPECT_EQ(0u, capped[budget->name].fallback_cnt) << budget->name;
+        EXPECT_LE(capped[budget->name].peak_bytes, capped[budget->name].limit) << budget->name;
+    }
+    RecordProperty("capped_p2p_refused", capped["ut_p2p_media"].over_cnt);
+}
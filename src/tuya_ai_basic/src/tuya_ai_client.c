@@ -74,6 +74,13 @@ typedef struct {
 
 static AI_BASIC_CLIENT_T *ai_basic_client = NULL;
 
+static TAL_METRIC_COUNTER_DEFINE(s_metric_ai_rx, "ai_rx_packets_total", "AI packets received");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_ai_rx_bytes, "ai_rx_bytes_total", "AI payload bytes received");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_ai_reconnect, "ai_reconnects_total", "AI connections dropped while running");
+static TAL_METRIC_HISTOGRAM_DEFINE(s_metric_ai_rtt, "ai_ping_rtt_ms", "AI ping to pong round trip", 2);
+static TAL_METRIC_HISTOGRAM_DEFINE(s_metric_ai_handle, "ai_handle_ms", "AI packet handling by the application", 0);
+static SYS_TIME_T s_ai_ping_ms = 0;
+
 static uint32_t __ai_get_random_value(uint32_t min, uint32_t max)
 {
     return min + uni_random() % (max - min + 1);
@@ -172,6 +179,7 @@ static void __ai_client_handle_err()
         __ai_client_set_state(AI_STATE_SETUP);
     } else if (ai_basic_client->state == AI_STATE_RUNNING) {
         PR_NOTICE("ai client running error, reconnect");
+        tal_metric_inc(&s_metric_ai_reconnect);
         __ai_conn_close();
     } else {
         tal_system_sleep(1000);
@@ -243,6 +251,10 @@ static void __ai_handle_conn_close(char *data, uint32_t len)
 static void __ai_handle_pong(char *data, uint32_t len)
 {
     tuya_ai_pong(data, len);
+    if (s_ai_ping_ms) {
+        tal_metric_observe(&s_metric_ai_rtt, (uint32_t)(tal_system_get_millisecond() - s_ai_ping_ms));
+        s_ai_ping_ms = 0;
+    }
     tal_workq_start_delayed(ai_basic_client->alive_work, (ai_basic_client->heartbeat_interval * 1000), LOOP_ONCE);
     PR_NOTICE("ai pong");
 }
@@ -262,6 +274,9 @@ static OPERATE_RET __ai_running(void)
         return rt;
     }
     __ai_stop_alive_time();
+    tal_metric_inc(&s_metric_ai_rx);
+    tal_metric_add(&s_metric_ai_rx_bytes, de_len);
+    SYS_TIME_T start_ms = tal_system_get_millisecond();
     if ((frag == AI_PACKET_NO_FRAG) || (frag == AI_PACKET_FRAG_START)) {
         AI_PACKET_PT pkt_type = tuya_ai_basic_get_pkt_type(de_buf);
         AI_PROTO_D("ai recv data type:%d, %d", pkt_type, de_len);
@@ -281,6 +296,7 @@ static OPERATE_RET __ai_running(void)
             ai_basic_client->cb(de_buf, de_len, frag);
         }
     }
+    tal_metric_observe(&s_metric_ai_handle, (uint32_t)(tal_system_get_millisecond() - start_ms));
 
     tuya_ai_basic_pkt_free(de_buf);
     return rt;
@@ -395,6 +411,7 @@ static void __ai_ping(void *data)
 {
     OPERATE_RET rt = OPRT_OK;
     tal_sw_timer_start(ai_basic_client->alive_timeout_timer, AT_PING_TIMEOUT * 1000, TAL_TIMER_ONCE);
+    s_ai_ping_ms = tal_system_get_millisecond();
     rt = tuya_ai_basic_ping();
     if (OPRT_OK != rt) {
         PR_ERR("send ping to cloud failed, rt:%d", rt);
@@ -470,6 +487,11 @@ OPERATE_RET tuya_ai_client_init(void)
     AI_RECONN_TIME_T reconn[AI_RECONN_TIME_NUM] = {{5, 10},   {10, 20},   {20, 40},  {40, 80},
                                                    {80, 160}, {160, 320}, {320, 640}};
     memcpy(ai_basic_client->reconn, reconn, sizeof(reconn));
+    tal_metric_register(&s_metric_ai_rx);
+    tal_metric_register(&s_metric_ai_rx_bytes);
+    tal_metric_register(&s_metric_ai_reconnect);
+    tal_metric_register(&s_metric_ai_rtt.base);
+    tal_metric_register(&s_metric_ai_handle.base);
     tuya_ai_biz_init();
     TUYA_CALL_ERR_GOTO(tal_sw_timer_create(__ai_conn_refresh, NULL, &ai_basic_client->tid), EXIT);
     TUYA_CALL_ERR_GOTO(__ai_client_create_task(), EXIT);
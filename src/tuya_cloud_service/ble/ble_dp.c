@@ -1,11 +1,12 @@
 /**
- * @file ble_dp.C
- * @brief This file contains functions to manage BLE data points (DPs) including
- * creating, parsing, and freeing KLV (Key-Length-Value) lists for BLE
- * communication. It provides mechanisms to serialize and deserialize data
- * points for transmission over BLE, handling different data types like enums,
- * booleans, and various sized integers. Additionally, it includes utilities for
- * managing memory and ensuring data integrity during the process.
+ * @file ble_dp.c
+ * @brief This file contains functions to report and receive BLE data points
+ * (DPs) as v4 TLV (Type-Length-Value) frames. Reports are encoded in a single
+ * pass from structured DPs or schema nodes into a stack buffer, and into one
+ * heap buffer of the exact size only when the frame does not fit. Received
+ * frames are read in place, without copying the DPs out of the packet, and
+ * handed to the DP parser as JSON. It handles the different data types like
+ * enums, booleans, values, bitmaps, strings and raw data.
  *
  * @copyright Copyright (c) 2021-2024 Tuya Inc. All Rights Reserved.
  *
@@ -43,288 +44,222 @@ typedef uint8_t dp_type;
 #define DT_RAW_MAX    255
 #define DT_INT_LEN    DT_VALUE_LEN
 
-typedef struct s_klv_node {
-    struct s_klv_node *next;
+#define DP_V4_TLV_HEAD 4 // id(1)+type(1)+len(2)
+
+// Frames up to this size are encoded on the stack without touching the heap
+#define DP_TLV_STACK_BUF_LEN 128
+
+/**
+ * @brief Single-pass TLV writer.
+ *
+ * The writer always advances offset, but only stores bytes while they fit in
+ * buf, so one pass over the DPs either produces the frame or reports the exact
+ * size required for a second pass into a larger buffer.
+ */
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t offset;
+} dp_tlv_writer_t;
+
+/**
+ * @brief In-place TLV reader, data points into the received frame.
+ */
+typedef struct {
+    const uint8_t *buf;
+    uint32_t len;
+    uint32_t offset;
+} dp_tlv_reader_t;
+
+typedef struct {
     uint8_t id;
     dp_type type;
     uint16_t len;
-    uint8_t *data;
-} klv_node_s;
+    const uint8_t *data;
+} dp_tlv_t;
+
+static uint32_t s_dp_sn = 1;
 
-void tuya_change_bt_dp_tlv(dp_type type, void *data, uint16_t *len)
+static void __tlv_writer_init(dp_tlv_writer_t *w, uint8_t *buf, uint32_t size)
 {
-    if (DT_ENUM == type) {
-        uint32_t enum_value = *(uint32_t *)data;
-        if (enum_value <= 0xff) {
-            uint8_t enum_byte = *(uint32_t *)data;
-            *len = 1;
-            memcpy(data, &enum_byte, *len);
-        } else if (enum_value <= 0xffff) {
-            uint16_t enum_short = *(uint32_t *)data;
-            *len = 2;
-            enum_short = UNI_HTONS(enum_short);
-            memcpy(data, &enum_short, *len);
-        } else {
-            uint32_t enum_int = *(uint32_t *)data;
-            *len = 4;
-            enum_int = UNI_HTONL(enum_int);
-            memcpy(data, &enum_int, *len);
-        }
-    } else if (DT_BOOL == type) {
-        uint8_t bool_value = *(uint32_t *)data;
-        *len = 1;
-        memcpy(data, &bool_value, *len);
-    }
+    w->buf = buf;
+    w->size = size;
+    w->offset = 0;
 }
 
-void free_klv_list(klv_node_s *list)
+static void __tlv_put_u8(dp_tlv_writer_t *w, uint8_t value)
 {
-    if (NULL == list) {
-        return;
+    if (w->offset < w->size) {
+        w->buf[w->offset] = value;
     }
-
-    klv_node_s *node = list;
-    klv_node_s *next_node = NULL;
-
-    do {
-        next_node = node->next;
-        // free(node);
-        tal_free((uint8_t *)(node->data));
-        tal_free((uint8_t *)node);
-        node = next_node;
-    } while (node);
+    w->offset++;
 }
 
-klv_node_s *make_klv_list(klv_node_s *list, uint8_t id, dp_type type, void *data, uint16_t len)
+static void __tlv_put_be(dp_tlv_writer_t *w, uint32_t value, uint8_t len)
 {
-    klv_node_s *node;
-    void *p_data = NULL;
-
-    if (NULL == data || type >= DT_LMT) {
-        PR_ERR("input invalid");
-        return NULL;
+    while (len--) {
+        __tlv_put_u8(w, (value >> (len * 8)) & 0xff);
     }
+}
 
-    if (DT_VALUE == type && DT_VALUE_LEN != len) {
-        goto err_ret;
-    } else if (DT_BITMAP == type && len > DT_BITMAP_MAX) {
-        goto err_ret;
-    } else if (DT_BOOL == type && DT_BOOL_LEN != len) {
-        goto err_ret;
-    } else if (DT_ENUM == type && DT_ENUM_LEN != len) {
-        goto err_ret;
+static void __tlv_put_bytes(dp_tlv_writer_t *w, const void *data, uint16_t len)
+{
+    if (len > 0 && w->offset + len <= w->size) {
+        memcpy(&w->buf[w->offset], data, len);
     }
+    w->offset += len;
+}
 
-    if (len > 0) {
-        p_data = tal_malloc(len);
-        if (NULL == p_data) {
-            goto err_ret;
-        }
-        memcpy(p_data, data, len);
+static void __tlv_put_head(dp_tlv_writer_t *w, uint32_t sn, BOOL_T query, uint8_t flag, uint32_t time_stamp)
+{
+    __tlv_put_u8(w, 0); // version
+    __tlv_put_be(w, sn, 4);
+    __tlv_put_u8(w, query ? 1 : 0);
+    __tlv_put_u8(w, flag);
+    if (time_stamp > 0) {
+        __tlv_put_u8(w, 1);
+        __tlv_put_be(w, time_stamp, 4);
     }
+}
 
-    tuya_change_bt_dp_tlv(type, p_data, &len);
+static void __tlv_put_int(dp_tlv_writer_t *w, uint8_t id, dp_type type, uint32_t value)
+{
+    uint8_t len = 4;
 
-    node = (klv_node_s *)tal_malloc(sizeof(klv_node_s));
-    if (NULL == node) {
-        goto err_ret;
-    }
-    memset(node, 0, sizeof(klv_node_s));
-    if (len > 0) {
-        node->data = tal_malloc(len);
-        if (node->data == NULL) {
-            tal_free((uint8_t *)node);
-            goto err_ret;
-        }
+    if (DT_BOOL == type) {
+        len = 1;
+        value = value ? 1 : 0;
+    } else if (DT_ENUM == type) {
+        len = (value <= 0xff) ? 1 : ((value <= 0xffff) ? 2 : 4);
     }
-    node->id = id;
-    node->len = len;
-    node->type = type;
-
-    if (DT_VALUE == type || DT_BITMAP == type) {
-        // change to big-end
-        unsigned int tmp = *(unsigned int *)p_data;
-        // unsigned char shift = 0;
-        node->data[0] = (tmp >> 24) & 0xff;
-        node->data[1] = (tmp >> 16) & 0xff;
-        node->data[2] = (tmp >> 8) & 0xff;
-        node->data[3] = (tmp >> 0) & 0xff;
-    } else {
-        // Enumerations and BOOL have been converted to byte order in tuya_change_bt_dp_tlv. You can copy them directly
-        if (len > 0) {
-            memcpy((void *)node->data, (unsigned char *)p_data, len);
-        }
-    }
-    node->next = list;
-    tal_free(p_data);
-    return node;
 
-err_ret:
-    PR_ERR("input err");
-    free_klv_list(list);
-    tal_free(p_data);
-    return NULL;
+    __tlv_put_u8(w, id);
+    __tlv_put_u8(w, type);
+    __tlv_put_be(w, len, 2);
+    __tlv_put_be(w, value, len);
 }
 
-OPERATE_RET klvlist_2_data(klv_node_s *list, uint8_t **data, uint32_t *len, uint32_t *time_stamp, BOOL_T query,
-                           uint8_t flag)
+static void __tlv_put_raw(dp_tlv_writer_t *w, uint8_t id, dp_type type, const void *data, uint16_t len)
 {
-    if (NULL == list || NULL == data || NULL == len) {
-        PR_ERR("para err");
-        return OPRT_INVALID_PARM;
-    }
-
-    static uint32_t sn = 1;
-    klv_node_s *node = list;
-    // type: 1: 4.x protocol dp report
-    uint8_t type = 1;
-
-    // count data len
-    unsigned int mk_data_len = 0;
+    __tlv_put_u8(w, id);
+    __tlv_put_u8(w, type);
+    __tlv_put_be(w, len, 2);
+    __tlv_put_bytes(w, data, len);
+}
 
-    if (1 == type) {
-        mk_data_len += 7; // version(1)+sn(4)+type(1)+flag(1)
-        if (NULL != time_stamp) {
-            mk_data_len += 5; // lenth of timeType+time_data
-        }
-    } else if (2 == type) {
-        mk_data_len += 3; // sn(2)+flag(1)
-    }
-
-    while (node) {
-        mk_data_len += sizeof(klv_node_s) + node->len - sizeof(struct s_klv_node *);
-        node = node->next;
-    }
-
-    unsigned char *mk_data = (unsigned char *)tal_malloc(mk_data_len);
-    if (NULL == mk_data) {
-        return OPRT_MALLOC_FAILED;
-    }
-
-    unsigned int offset = 0;
-    // fill v4 head info
-    if (1 == type) {
-        mk_data[offset++] = 0;
-        mk_data[offset++] = (sn & 0xff000000) >> 24;
-        mk_data[offset++] = (sn & 0xff0000) >> 16;
-        mk_data[offset++] = (sn & 0xff00) >> 8;
-        mk_data[offset++] = (sn & 0xff);
-        mk_data[offset++] = (query ? 1 : 0); // type
-        mk_data[offset++] = flag;
-        // fill time
-        if (NULL != time_stamp) {
-            mk_data[offset++] = 1;
-            memcpy(&mk_data[offset], time_stamp, 4);
-            offset += 4;
-        }
-    } else if (2 == type) {
-        mk_data[offset++] = (sn & 0xff00) >> 8;
-        mk_data[offset++] = (sn & 0xff);
-        mk_data[offset++] = flag;
-    }
-
-    // fill data
-    node = list;
-    while (node) {
-        mk_data[offset++] = node->id;
-        mk_data[offset++] = node->type;
-        if (1 == type) {
-            mk_data[offset++] = 0xff & (node->len >> 8);
-            mk_data[offset++] = node->len;
-        } else {
-            mk_data[offset++] = node->len;
-        }
-        if (node->len > 0) {
-            memcpy(&mk_data[offset], node->data, node->len);
-        }
-        offset += node->len;
-        node = node->next;
+static OPERATE_RET __tlv_put_dp_obj(dp_tlv_writer_t *w, const dp_obj_t *dp)
+{
+    switch (dp->type) {
+    case PROP_BOOL:
+        __tlv_put_int(w, dp->id, DT_BOOL, dp->value.dp_bool);
+        break;
+    case PROP_VALUE:
+        __tlv_put_int(w, dp->id, DT_VALUE, (uint32_t)dp->value.dp_value);
+        break;
+    case PROP_STR: {
+        uint16_t len = dp->value.dp_str ? strlen(dp->value.dp_str) : 0;
+        __tlv_put_raw(w, dp->id, DT_STRING, dp->value.dp_str, len);
+        break;
+    }
+    case PROP_ENUM:
+        __tlv_put_int(w, dp->id, DT_ENUM, dp->value.dp_enum);
+        break;
+    case PROP_BITMAP:
+        __tlv_put_int(w, dp->id, DT_BITMAP, dp->value.dp_bitmap);
+        break;
+    default:
+        PR_ERR("p_dp->type:%d invalid", dp->type);
+        return OPRT_INVALID_PARM;
     }
-    *len = offset;
-    *data = mk_data;
-
-    // if(ty_get_sync_rpt_flag() && (FALSE == query)){
-    //     ty_upd_dp_sync_sn(sn);
-    // }
-
-    sn++;
     return OPRT_OK;
 }
 
-OPERATE_RET data_2_klvlist(uint8_t *data, uint32_t len, klv_node_s **list)
+static OPERATE_RET __tlv_put_dp_node(dp_tlv_writer_t *w, const dp_node_t *node)
 {
-    if (NULL == data || NULL == list) {
+    switch (node->desc.prop_tp) {
+    case PROP_BOOL:
+        __tlv_put_int(w, node->desc.id, DT_BOOL, node->prop.prop_bool.value);
+        break;
+    case PROP_VALUE:
+        __tlv_put_int(w, node->desc.id, DT_VALUE, (uint32_t)node->prop.prop_int.value);
+        break;
+    case PROP_STR: {
+        uint16_t len = node->prop.prop_str.value ? strlen(node->prop.prop_str.value) : 0;
+        __tlv_put_raw(w, node->desc.id, DT_STRING, node->prop.prop_str.value, len);
+        break;
+    }
+    case PROP_ENUM:
+        __tlv_put_int(w, node->desc.id, DT_ENUM, (uint32_t)node->prop.prop_enum.value);
+        break;
+    case PROP_BITMAP:
+        __tlv_put_int(w, node->desc.id, DT_BITMAP, node->prop.prop_bitmap.value);
+        break;
+    default:
+        PR_ERR("unsupport dp type:%d", node->desc.prop_tp);
         return OPRT_INVALID_PARM;
     }
+    return OPRT_OK;
+}
 
-    uint8_t type = 1;
-
-    tuya_ble_raw_print("data_2_klvlist", 16, data, len);
-
-    unsigned int offset = 0;
-    klv_node_s *klv_list = NULL;
-    klv_node_s *node = NULL;
-    do {
-        // not full klv
-        if (type == 1) {
-            if ((len - offset) < 4) {
-                free_klv_list(klv_list);
-                return OPRT_COM_ERROR;
-            }
-        } else {
-            if ((len - offset) < 3) {
-                free_klv_list(klv_list);
-                return OPRT_COM_ERROR;
-            }
-        }
-
-        node = (klv_node_s *)tal_malloc(sizeof(klv_node_s));
-        if (NULL == node) {
-            free_klv_list(klv_list);
-            return OPRT_MALLOC_FAILED;
-        }
-        memset(node, 0, sizeof(klv_node_s));
-
-        node->id = data[offset++];
-        node->type = data[offset++];
-        if (1 == type) {
-            node->len = data[offset++];
-            node->len = (node->len << 8) + data[offset++];
-        } else {
-            node->len = data[offset++];
+static BOOL_T __dp_id_selected(uint8_t id, const uint8_t *dpid, uint8_t dpid_num)
+{
+    if (NULL == dpid) {
+        return TRUE;
+    }
+    for (uint8_t i = 0; i < dpid_num; i++) {
+        if (dpid[i] == id) {
+            return TRUE;
         }
+    }
+    return FALSE;
+}
 
-        if (node->len > 0) {
-            node->data = tal_malloc(node->len + 1);
-            if (node->data == NULL) {
-                tal_free((uint8_t *)node);
-                free_klv_list(klv_list);
-                return OPRT_MALLOC_FAILED;
-            }
-
-            if ((len - offset) < node->len) { // is remain data len enougn?
-                tal_free(node->data);
-                tal_free((uint8_t *)node);
-                free_klv_list(klv_list);
-                return OPRT_COM_ERROR;
-            }
+static void __tlv_reader_init(dp_tlv_reader_t *r, const uint8_t *buf, uint32_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->offset = 0;
+}
 
-            memcpy(node->data, &data[offset], node->len);
-            node->data[node->len] = 0;
-        }
+/**
+ * @brief Fetches the next TLV without copying its value.
+ *
+ * @return OPRT_OK on success, OPRT_EOD when the frame is exhausted and
+ * OPRT_COM_ERROR when the frame is truncated.
+ */
+static OPERATE_RET __tlv_reader_next(dp_tlv_reader_t *r, dp_tlv_t *tlv)
+{
+    if (r->offset >= r->len) {
+        return OPRT_EOD;
+    }
+    if ((r->len - r->offset) < DP_V4_TLV_HEAD) {
+        return OPRT_COM_ERROR;
+    }
 
-        offset += node->len;
-        node->next = klv_list;
-        klv_list = node;
-    } while (offset < len);
+    const uint8_t *p = &r->buf[r->offset];
+    tlv->id = p[0];
+    tlv->type = p[1];
+    tlv->len = (p[2] << 8) | p[3];
+    r->offset += DP_V4_TLV_HEAD;
 
-    if (NULL == klv_list) {
+    if ((r->len - r->offset) < tlv->len) {
         return OPRT_COM_ERROR;
     }
-    *list = klv_list;
+    tlv->data = tlv->len ? &r->buf[r->offset] : NULL;
+    r->offset += tlv->len;
+
     return OPRT_OK;
 }
 
+static uint32_t __tlv_get_be32(const dp_tlv_t *tlv)
+{
+    if (tlv->len < 4) {
+        return 0;
+    }
+    return ((uint32_t)tlv->data[0] << 24) | ((uint32_t)tlv->data[1] << 16) | ((uint32_t)tlv->data[2] << 8) |
+           tlv->data[3];
+}
+
 static OPERATE_RET __result_code_resp(uint16_t type, uint32_t ack_sn, uint8_t result_code)
 {
     return tuya_ble_send(type, ack_sn, &result_code, 1);
@@ -349,142 +284,176 @@ static OPERATE_RET __dp_data_report_data(uint16_t type, uint8_t *p_data, uint32_
     return tuya_ble_send(type, 0, p_data, len);
 }
 
-klv_node_s *__make_obj_dp_klv_list(dp_rept_in_t *dpin)
+/**
+ * @brief Sends an encoded v4 DP frame, growing into a heap buffer only when
+ * the frame does not fit the stack buffer used by the first pass.
+ */
+typedef OPERATE_RET (*dp_tlv_fill_cb_t)(dp_tlv_writer_t *w, void *ctx);
+
+static OPERATE_RET __dp_tlv_frame_send(uint16_t type, dp_tlv_fill_cb_t fill, void *ctx)
 {
-    klv_node_s *p_node = NULL;
-    int index = 0;
-
-    for (index = 0; index < dpin->dpscnt; index++) {
-        dp_obj_t *p_dp = dpin->dps + index;
-        dp_type new_type = 0;
-        void *new_data = NULL;
-        uint16_t new_len = 0;
-
-        switch (p_dp->type) {
-        case PROP_BOOL: {
-            new_type = DT_BOOL;
-            new_data = &(p_dp->value.dp_bool);
-            new_len = DT_BOOL_LEN;
-            break;
-        }
-        case PROP_VALUE: {
-            new_type = DT_VALUE;
-            new_data = &(p_dp->value.dp_value);
-            new_len = DT_VALUE_LEN;
-            break;
-        }
-        case PROP_STR: {
-            new_type = DT_STRING;
-            new_data = p_dp->value.dp_str;
-            new_len = strlen(p_dp->value.dp_str);
-            break;
-        }
-        case PROP_ENUM: {
-            new_type = DT_ENUM;
-            new_data = &(p_dp->value.dp_enum);
-            new_len = DT_ENUM_LEN;
-            break;
-        }
-        case PROP_BITMAP: {
-            new_type = DT_BITMAP;
-            new_data = &(p_dp->value.dp_bitmap);
-            new_len = DT_BITMAP_MAX;
-            break;
-        }
-        default:
-            PR_ERR("p_dp->type:%d invalid", p_dp->type);
-            continue;
+    OPERATE_RET rt = OPRT_OK;
+    uint8_t stack_buf[DP_TLV_STACK_BUF_LEN];
+    uint8_t *heap_buf = NULL;
+    dp_tlv_writer_t w;
+
+    __tlv_writer_init(&w, stack_buf, sizeof(stack_buf));
+    rt = fill(&w, ctx);
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+
+    if (w.offset > w.size) {
+        uint32_t need = w.offset;
+        heap_buf = tal_malloc(need);
+        if (NULL == heap_buf) {
+            return OPRT_MALLOC_FAILED;
         }
-        p_node = make_klv_list(p_node, p_dp->id, new_type, new_data, new_len);
+        __tlv_writer_init(&w, heap_buf, need);
+        rt = fill(&w, ctx);
     }
 
-    return p_node;
+    if (OPRT_OK == rt) {
+        rt = __dp_data_report_data(type, w.buf, w.offset);
+    }
+    tal_free(heap_buf);
+
+    return rt;
 }
 
-OPERATE_RET ty_bt_dp_data_report(klv_node_s *p_node, uint32_t time_stamp)
+/**
+ * @brief Encodes structured DPs into a v4 BLE DP report frame.
+ *
+ * @param[in] dps DP array to encode.
+ * @param[in] dpscnt Count of dps.
+ * @param[in] dpid Optional list of DP ids to encode, NULL to encode all dps.
+ * @param[in] dpid_num Count of dpid.
+ * @param[in] time_stamp Report time, 0 to omit the time field.
+ * @param[out] buf Output buffer, may be NULL to query the frame size.
+ * @param[in] size Size of buf.
+ * @param[out] len Encoded (or required) frame length.
+ *
+ * @return OPRT_OK on success, OPRT_BUFFER_NOT_ENOUGH if buf is too small, in
+ * which case len holds the required size.
+ */
+int tuya_ble_dp_obj_encode(const dp_obj_t *dps, uint16_t dpscnt, const uint8_t *dpid, uint8_t dpid_num,
+                           uint32_t time_stamp, uint8_t *buf, uint32_t size, uint32_t *len)
 {
-    OPERATE_RET ret = OPRT_OK;
-    uint16_t type = FRM_STAT_REPORT;
+    dp_tlv_writer_t w;
 
-    if (NULL == p_node) {
+    if (NULL == dps || NULL == len) {
         return OPRT_INVALID_PARM;
     }
 
-    time_stamp = UNI_HTONL(time_stamp);
-    uint32_t *p_time_stamp = (time_stamp > 0) ? &time_stamp : NULL;
-    uint8_t *p_new_data = NULL;
-    uint32_t new_data_len = 0;
-    klvlist_2_data(p_node, &p_new_data, &new_data_len, p_time_stamp, FALSE, 0);
-    free_klv_list(p_node);
+    __tlv_writer_init(&w, buf, buf ? size : 0);
+    __tlv_put_head(&w, s_dp_sn, FALSE, 0, time_stamp);
+    for (uint16_t i = 0; i < dpscnt; i++) {
+        if (__dp_id_selected(dps[i].id, dpid, dpid_num)) {
+            __tlv_put_dp_obj(&w, &dps[i]);
+        }
+    }
+    *len = w.offset;
 
-    type = (NULL != p_time_stamp) ? FRM_DP_STAT_REPORT_WITH_TIME_V4 : FRM_DP_STAT_REPORT_V4;
-    ret = __dp_data_report_data(type, p_new_data, new_data_len);
-    tal_free(p_new_data);
-    return ret;
+    return (w.offset > w.size) ? OPRT_BUFFER_NOT_ENOUGH : OPRT_OK;
+}
+
+typedef struct {
+    const dp_obj_t *dps;
+    uint16_t dpscnt;
+    const uint8_t *dpid;
+    uint8_t dpid_num;
+    uint32_t time_stamp;
+} dp_obj_fill_ctx_t;
+
+static OPERATE_RET __dp_obj_fill(dp_tlv_writer_t *w, void *ctx)
+{
+    dp_obj_fill_ctx_t *obj = (dp_obj_fill_ctx_t *)ctx;
+    uint32_t len = 0;
+
+    tuya_ble_dp_obj_encode(obj->dps, obj->dpscnt, obj->dpid, obj->dpid_num, obj->time_stamp, w->buf, w->size, &len);
+    w->offset = len;
+
+    return OPRT_OK;
 }
 
-static __attribute__((unused)) klv_node_s *__get_response_query_dp_data(const uint8_t *dpid, const uint8_t num)
+static OPERATE_RET __dp_raw_fill(dp_tlv_writer_t *w, void *ctx)
 {
-    uint16_t i;
-    klv_node_s *p_node = NULL;
-    dp_schema_t *schema = tuya_iot_client_get()->schema;
+    dp_raw_t *dp = (dp_raw_t *)ctx;
 
-    tal_mutex_lock(schema->mutex);
-    for (i = 0; i < num; i++) {
-        int id = dpid[i];
-        dp_type new_type = 0;
-        void *new_data = NULL;
-        uint16_t new_len = 0;
+    __tlv_put_head(w, s_dp_sn, FALSE, 0, 0);
+    __tlv_put_raw(w, dp->id, DT_RAW, dp->data, dp->len);
 
-        dp_node_t *dpnode = dp_node_find(schema, id);
+    return OPRT_OK;
+}
+
+typedef struct {
+    dp_schema_t *schema;
+    const uint8_t *dpid;
+    uint8_t dpid_num;
+    uint8_t dp_cnt;
+} dp_query_fill_ctx_t;
+
+static BOOL_T __dp_node_queryable(dp_node_t *dpnode)
+{
+    return (dpnode->desc.mode != M_WR) && (dpnode->desc.type == T_OBJ);
+}
 
+static OPERATE_RET __dp_query_fill(dp_tlv_writer_t *w, void *ctx)
+{
+    dp_query_fill_ctx_t *query = (dp_query_fill_ctx_t *)ctx;
+    dp_schema_t *schema = query->schema;
+    int i;
+
+    query->dp_cnt = 0;
+    __tlv_put_head(w, s_dp_sn, TRUE, 0, 0);
+
+    if (NULL == query->dpid) {
+        for (i = 0; i < schema->num; i++) {
+            dp_node_t *dpnode = &(schema->node[i]);
+            if (!__dp_node_queryable(dpnode)) {
+                PR_TRACE("Skip DP ID %d", dpnode->desc.id);
+                continue;
+            }
+            if (OPRT_OK == __tlv_put_dp_node(w, dpnode)) {
+                query->dp_cnt++;
+            }
+        }
+        return query->dp_cnt ? OPRT_OK : OPRT_NOT_FOUND;
+    }
+
+    for (i = 0; i < query->dpid_num; i++) {
+        dp_node_t *dpnode = dp_node_find(schema, query->dpid[i]);
         if (dpnode == NULL) {
-            PR_ERR("dp id Invalid %d", id);
+            PR_ERR("dp id Invalid %d", query->dpid[i]);
             continue;
         }
-
-        if ((dpnode->desc.mode == M_WR) || (dpnode->desc.type != T_OBJ) || (dpnode->pv_stat == PV_STAT_INVALID) ||
+        if (!__dp_node_queryable(dpnode) || (dpnode->pv_stat == PV_STAT_INVALID) ||
             ((schema->actv.preprocess == TRUE) && (dpnode->desc.passive == PSV_TRUE))) {
-            PR_ERR("dp id %d Skip", id);
+            PR_ERR("dp id %d Skip", query->dpid[i]);
             continue;
         }
-
-        switch (dpnode->desc.prop_tp) {
-        case PROP_BOOL: {
-            new_type = DT_BOOL;
-            new_data = &(dpnode->prop.prop_bool.value);
-            new_len = DT_BOOL_LEN;
-        } break;
-        case PROP_VALUE: {
-            new_type = DT_VALUE;
-            new_data = &(dpnode->prop.prop_int.value);
-            new_len = DT_VALUE_LEN;
-        } break;
-        case PROP_STR: {
-            new_type = DT_STRING;
-            new_data = dpnode->prop.prop_str.value;
-            new_len = strlen(dpnode->prop.prop_str.value);
-        } break;
-        case PROP_ENUM: {
-            new_type = DT_ENUM;
-            new_data = &(dpnode->prop.prop_enum.value);
-            new_len = DT_ENUM_LEN;
-        } break;
-        case PROP_BITMAP: {
-            new_type = DT_BITMAP;
-            new_data = &(dpnode->prop.prop_bitmap.value);
-            new_len = DT_BITMAP_MAX;
-        } break;
-        default:
-            break;
+        if (OPRT_OK == __tlv_put_dp_node(w, dpnode)) {
+            query->dp_cnt++;
         }
-        p_node = make_klv_list(p_node, dpnode->desc.id, new_type, new_data, new_len);
     }
-    tal_mutex_unlock(schema->mutex);
-    return p_node;
+
+    return query->dp_cnt ? OPRT_OK : OPRT_NOT_FOUND;
 }
 
-uint32_t __dp_get_time_stamp(dp_obj_t *dp_data, const uint32_t cnt)
+static __attribute__((unused)) OPERATE_RET __response_query_dp_data(const uint8_t *dpid, const uint8_t num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_query_fill_ctx_t ctx = {.schema = tuya_iot_client_get()->schema, .dpid = dpid, .dpid_num = num};
+
+    tal_mutex_lock(ctx.schema->mutex);
+    rt = __dp_tlv_frame_send(FRM_DP_STAT_REPORT_V4, __dp_query_fill, &ctx);
+    tal_mutex_unlock(ctx.schema->mutex);
+    s_dp_sn++;
+
+    return rt;
+}
+
+static uint32_t __dp_get_time_stamp(const dp_obj_t *dp_data, const uint32_t cnt)
 {
     // time_stamp:0 indicates the current time.
     if (NULL == dp_data || 0 == cnt || 0 == dp_data[0].time_stamp) {
@@ -496,10 +465,34 @@ uint32_t __dp_get_time_stamp(dp_obj_t *dp_data, const uint32_t cnt)
     return dp_data[0].time_stamp;
 }
 
+static int ble_dp_obj_report(const dp_obj_t *dps, uint16_t dpscnt, const uint8_t *dpid, uint8_t dpid_num)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_obj_fill_ctx_t ctx = {.dps = dps, .dpscnt = dpscnt, .dpid = dpid, .dpid_num = dpid_num};
+
+    if (NULL == dps || 0 == dpscnt) {
+        return OPRT_INVALID_PARM;
+    }
+
+    uint16_t first = 0;
+    while (first < dpscnt && !__dp_id_selected(dps[first].id, dpid, dpid_num)) {
+        first++;
+    }
+    if (first == dpscnt) {
+        return OPRT_INVALID_PARM;
+    }
+
+    ctx.time_stamp = __dp_get_time_stamp(&dps[first], dpscnt - first);
+    uint16_t type = (ctx.time_stamp > 0) ? FRM_DP_STAT_REPORT_WITH_TIME_V4 : FRM_DP_STAT_REPORT_V4;
+    rt = __dp_tlv_frame_send(type, __dp_obj_fill, &ctx);
+    s_dp_sn++;
+
+    return rt;
+}
+
 static int ble_dp_report(const dp_rept_in_t *dpin)
 {
-    klv_node_s *p_node = NULL;
-    uint32_t time_stamp = 0;
+    OPERATE_RET rt = OPRT_OK;
 
     if (NULL == dpin) {
         return OPRT_INVALID_PARM;
@@ -507,23 +500,23 @@ static int ble_dp_report(const dp_rept_in_t *dpin)
 
     switch (dpin->rept_type) {
     case T_OBJ_REPT: {
-        time_stamp = __dp_get_time_stamp(dpin->dps, dpin->dpscnt);
-        p_node = __make_obj_dp_klv_list((dp_rept_in_t *)dpin);
-        break;
+        return ble_dp_obj_report(dpin->dps, dpin->dpscnt, NULL, 0);
     }
     case T_STAT_REPT: {
         //! TODO:
-        break;
+        return OPRT_INVALID_PARM;
     }
     case T_RAW_REPT: {
-        p_node = make_klv_list(NULL, dpin->dp->id, DT_RAW, dpin->dp->data, dpin->dp->len);
-        break;
+        if (NULL == dpin->dp) {
+            return OPRT_INVALID_PARM;
+        }
+        rt = __dp_tlv_frame_send(FRM_DP_STAT_REPORT_V4, __dp_raw_fill, dpin->dp);
+        s_dp_sn++;
+        return rt;
     }
     default:
         return OPRT_INVALID_PARM;
     }
-
-    return ty_bt_dp_data_report(p_node, time_stamp);
 }
 
 static int ble_dp_req(ble_packet_t *req, void *priv_data)
@@ -541,6 +534,11 @@ static int ble_dp_req(ble_packet_t *req, void *priv_data)
         return OPRT_NOT_SUPPORTED;
     }
 
+    if (0 == len) {
+        PR_ERR("parse err:%d", OPRT_COM_ERROR);
+        return OPRT_CJSON_PARSE_ERR;
+    }
+
     cJSON *p_root = cJSON_CreateObject();
     if (NULL == p_root) {
         PR_DEBUG("json err");
@@ -553,47 +551,48 @@ static int ble_dp_req(ble_packet_t *req, void *priv_data)
         return OPRT_CR_CJSON_ERR;
     }
     cJSON_AddItemToObject(p_root, "dps", p_dps);
-    klv_node_s *list = NULL;
-    int ret = data_2_klvlist(data, len, &list);
-    if (OPRT_OK != ret) {
-        PR_ERR("parse err:%d", ret);
-        cJSON_Delete(p_root);
-        return OPRT_CJSON_PARSE_ERR;
-    }
 
-    klv_node_s *p_tmp = list;
-    while (p_tmp != NULL) {
-        PR_DEBUG("ble dp id:%d type:%d len:%d", p_tmp->id, p_tmp->type, p_tmp->len);
+    int ret = OPRT_OK;
+    dp_tlv_reader_t reader;
+    dp_tlv_t tlv;
+
+    __tlv_reader_init(&reader, data, len);
+    while (OPRT_OK == (ret = __tlv_reader_next(&reader, &tlv))) {
+        PR_DEBUG("ble dp id:%d type:%d len:%d", tlv.id, tlv.type, tlv.len);
         char dp_id_str[5] = {0};
-        snprintf(dp_id_str, 5, "%d", p_tmp->id);
-        switch (p_tmp->type) {
+        snprintf(dp_id_str, 5, "%d", tlv.id);
+        switch (tlv.type) {
         case DT_RAW: {
-            char *p_base64 = tal_malloc(p_tmp->len / 3 * 4 + 5);
+            char *p_base64 = tal_malloc(tlv.len / 3 * 4 + 5);
             if (NULL == p_base64) {
-                PR_ERR("malloc base64 failed, len:%d", p_tmp->len);
+                PR_ERR("malloc base64 failed, len:%d", tlv.len);
                 ret = OPRT_MALLOC_FAILED;
                 goto EXIT;
             }
-            tuya_base64_encode(p_tmp->data, p_base64, p_tmp->len);
+            tuya_base64_encode(tlv.data, p_base64, tlv.len);
             cJSON_AddStringToObject(p_dps, dp_id_str, p_base64);
             tal_free(p_base64);
             break;
         }
         case DT_BOOL: {
-            cJSON_AddBoolToObject(p_dps, dp_id_str, *(p_tmp->data));
+            cJSON_AddBoolToObject(p_dps, dp_id_str, tlv.len ? tlv.data[0] : 0);
             break;
         }
         case DT_BITMAP:
         case DT_VALUE: {
-            int val = (p_tmp->data[0] << 24) + (p_tmp->data[1] << 16) + (p_tmp->data[2] << 8) + (p_tmp->data[3] << 0);
+            int val = (int)__tlv_get_be32(&tlv);
             cJSON_AddNumberToObject(p_dps, dp_id_str, val);
             break;
         }
         case DT_ENUM: {
-            int val = p_tmp->data[0];
-            dp_node_t *dpnode = dp_node_find(tuya_iot_client_get()->schema, p_tmp->id);
+            int val = tlv.len ? tlv.data[0] : 0;
+            dp_node_t *dpnode = dp_node_find(tuya_iot_client_get()->schema, tlv.id);
             if (NULL == dpnode) {
-                PR_ERR("invalid dp id[%d]", p_tmp->id);
+                PR_ERR("invalid dp id[%d]", tlv.id);
+                break;
+            }
+            if (val >= dpnode->prop.prop_enum.cnt) {
+                PR_ERR("invalid enum[%d] of dp id[%d]", val, tlv.id);
                 break;
             }
             cJSON_AddStringToObject(p_dps, dp_id_str, dpnode->prop.prop_enum.pp_enum[val]);
@@ -601,112 +600,66 @@ static int ble_dp_req(ble_packet_t *req, void *priv_data)
         }
 
         case DT_STRING: {
-            // In the Bluetooth protocol, empty strings do not include a
-            // terminator and require special handling.
-            char *str_val = (NULL == p_tmp->data) ? "" : (char *)(p_tmp->data);
+            // TLV values are not NUL terminated. In the Bluetooth protocol,
+            // empty strings do not include a terminator either.
+            char *str_val = tal_malloc(tlv.len + 1);
+            if (NULL == str_val) {
+                ret = OPRT_MALLOC_FAILED;
+                goto EXIT;
+            }
+            if (tlv.len > 0) {
+                memcpy(str_val, tlv.data, tlv.len);
+            }
+            str_val[tlv.len] = 0;
             cJSON_AddStringToObject(p_dps, dp_id_str, str_val);
+            tal_free(str_val);
             break;
         }
         default:
-            PR_NOTICE("type not support:%d", p_tmp->type);
+            PR_NOTICE("type not support:%d", tlv.type);
             break;
         }
-        p_tmp = p_tmp->next;
     }
+    if (OPRT_EOD != ret) {
+        PR_ERR("parse err:%d", ret);
+        cJSON_Delete(p_root);
+        return OPRT_CJSON_PARSE_ERR;
+    }
+
     ret = tuya_iot_dp_parse(tuya_iot_client_get(), DP_CMD_BT, p_root);
-    free_klv_list(list);
     if (ret != OPRT_OK) {
         cJSON_Delete(p_root);
     }
     return ret;
 
 EXIT:
-    free_klv_list(list);
     cJSON_Delete(p_root);
     return ret;
 }
 
 static int ble_dp_query(ble_packet_t *req, void *priv_data)
 {
+    OPERATE_RET rt = OPRT_OK;
+
     PR_NOTICE("ble recv dp query");
     tuya_ble_raw_print("ble dp query", 16, req->data, req->len);
     __result_code_resp(req->type, req->sn, 0);
 
-    dp_schema_t *schema = dp_schema_find(tuya_iot_client_get()->activate.devid);
-
-    int i;
-    klv_node_s *p_node = NULL;
-    if (schema == NULL) {
+    dp_query_fill_ctx_t ctx = {.schema = dp_schema_find(tuya_iot_client_get()->activate.devid)};
+    if (ctx.schema == NULL) {
         PR_DEBUG("schema null");
         return OPRT_INVALID_PARM;
     }
-    tal_mutex_lock(schema->mutex);
-    for (i = 0; i < schema->num; i++) {
-        dp_node_t *dpnode = &(schema->node[i]);
-        if (dpnode->desc.mode == M_WR) {
-            PR_TRACE("Skip DP ID %d", dpnode->desc.id);
-            continue;
-        }
-        if (dpnode->desc.type == T_RAW) {
-            // do nth for now
-        }
-        if (dpnode->desc.type == T_OBJ) {
-            dp_type new_type = 0;
-            void *new_data = NULL;
-            uint16_t new_len = 0;
-
-            switch (dpnode->desc.prop_tp) {
-            case PROP_BOOL: {
-                new_type = DT_BOOL;
-                new_data = &(dpnode->prop.prop_bool.value);
-                new_len = DT_BOOL_LEN;
-            } break;
-            case PROP_VALUE: {
-                new_type = DT_VALUE;
-                new_data = &(dpnode->prop.prop_int.value);
-                new_len = DT_VALUE_LEN;
-            } break;
-            case PROP_STR: {
-                new_type = DT_STRING;
-                new_data = dpnode->prop.prop_str.value;
-                if(dpnode->prop.prop_str.value) {
-                    new_len = strlen(dpnode->prop.prop_str.value);
-                }else {
-                    new_len = 0;
-                }
-            } break;
-            case PROP_ENUM: {
-                new_type = DT_ENUM;
-                new_data = &(dpnode->prop.prop_enum.value);
-                new_len = DT_ENUM_LEN;
-            } break;
-            case PROP_BITMAP: {
-                new_type = DT_BITMAP;
-                new_data = &(dpnode->prop.prop_bitmap.value);
-                new_len = DT_BITMAP_MAX;
-            } break;
-            default: {
-                PR_ERR("unsupport dp type:%d", dpnode->desc.prop_tp);
-            } break;
-            }
-            p_node = make_klv_list(p_node, dpnode->desc.id, new_type, new_data, new_len);
-        }
-
-    } /* end of for */
-    tal_mutex_unlock(schema->mutex);
 
-    if (p_node != NULL) {
-        uint16_t type = FRM_DP_STAT_REPORT_V4;
-        uint8_t *p_new_data = NULL;
-        uint32_t new_data_len = 0;
-
-        klvlist_2_data(p_node, &p_new_data, &new_data_len, NULL, TRUE, 0);
-        free_klv_list(p_node);
-        __dp_data_report_data(type, p_new_data, new_data_len);
-        tal_free(p_new_data);
+    tal_mutex_lock(ctx.schema->mutex);
+    rt = __dp_tlv_frame_send(FRM_DP_STAT_REPORT_V4, __dp_query_fill, &ctx);
+    tal_mutex_unlock(ctx.schema->mutex);
+    if (OPRT_NOT_FOUND == rt) {
+        return OPRT_OK;
     }
+    s_dp_sn++;
 
-    return OPRT_OK;
+    return rt;
 }
 
 /**
@@ -725,6 +678,25 @@ int tuya_ble_dp_report(dp_rept_in_t *dpin)
     return ble_dp_report(dpin);
 }
 
+/**
+ * @brief Reports the selected structured DPs to the Tuya BLE device.
+ *
+ * The DPs are encoded straight from dps, no filtered copy of the array is
+ * made.
+ *
+ * @param[in] dps DP array to report.
+ * @param[in] dpscnt Count of dps.
+ * @param[in] dpid DP ids to report, NULL to report all dps.
+ * @param[in] dpid_num Count of dpid.
+ * @return Returns the status of the DP report operation.
+ *     - 0: Success
+ *     - Other values: Error codes
+ */
+int tuya_ble_dp_obj_report(const dp_obj_t *dps, uint16_t dpscnt, const uint8_t *dpid, uint8_t dpid_num)
+{
+    return ble_dp_obj_report(dps, dpscnt, dpid, dpid_num);
+}
+
 /**
  * @brief Processes the BLE session data point (DP) packet.
  *
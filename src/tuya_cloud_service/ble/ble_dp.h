@@ -36,6 +36,43 @@ extern "C" {
  */
 int tuya_ble_dp_report(dp_rept_in_t *dpin);
 
+/**
+ * @brief Reports the selected structured DPs to the Tuya BLE device.
+ *
+ * The DPs are encoded straight from dps, no filtered copy of the array is
+ * made.
+ *
+ * @param[in] dps DP array to report.
+ * @param[in] dpscnt Count of dps.
+ * @param[in] dpid DP ids to report, NULL to report all dps.
+ * @param[in] dpid_num Count of dpid.
+ * @return Returns the status of the DP report operation.
+ *     - 0: Success
+ *     - Other values: Error codes
+ */
+int tuya_ble_dp_obj_report(const dp_obj_t *dps, uint16_t dpscnt, const uint8_t *dpid, uint8_t dpid_num);
+
+/**
+ * @brief Encodes structured DPs into a v4 BLE DP report frame.
+ *
+ * The frame is written in a single pass into the caller's buffer, using the
+ * current report sequence number.
+ *
+ * @param[in] dps DP array to encode.
+ * @param[in] dpscnt Count of dps.
+ * @param[in] dpid Optional list of DP ids to encode, NULL to encode all dps.
+ * @param[in] dpid_num Count of dpid.
+ * @param[in] time_stamp Report time, 0 to omit the time field.
+ * @param[out] buf Output buffer, may be NULL to query the frame size.
+ * @param[in] size Size of buf.
+ * @param[out] len Encoded (or required) frame length.
+ *
+ * @return OPRT_OK on success, OPRT_BUFFER_NOT_ENOUGH if buf is too small, in
+ * which case len holds the required size.
+ */
+int tuya_ble_dp_obj_encode(const dp_obj_t *dps, uint16_t dpscnt, const uint8_t *dpid, uint8_t dpid_num,
+                           uint32_t time_stamp, uint8_t *buf, uint32_t size, uint32_t *len);
+
 /**
  * @brief Processes the BLE session data point (DP) packet.
  *
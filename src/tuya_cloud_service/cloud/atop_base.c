@@ -9,6 +9,10 @@
  * transmission through encryption and decryption, as well as data integrity
  * verification through MD5 signatures.
  *
+ * Requests are signed and encrypted into one buffer, and responses are
+ * base64 decoded and decrypted in place in the HTTP receive buffer, so a large
+ * reply (schema, upgrade info) costs little more than its own size on the heap.
+ *
  * The functions implemented in this file are essential for devices to correctly
  * format requests to the Tuya cloud platform and to parse responses from the
  * platform. They ensure that data is transmitted securely and efficiently,
@@ -28,65 +32,63 @@
 #include "http_client_interface.h"
 #include "cJSON.h"
 #include "tal_security.h"
-#include "mbedtls/base64.h"
+#include "mbedtls/gcm.h"
 #include "tal_memory.h"
-#include "cipher_wrapper.h"
 #include "uni_random.h"
 
 #define MD5SUM_LENGTH               (16)
 #define POST_DATA_PREFIX            (5) // 'data='
-#define MAX_URL_LENGTH              (255)
+#define MAX_URL_LENGTH              ATOP_BASE_URL_LEN
 #define DEFAULT_RESPONSE_BUFFER_LEN (1024)
 #define AES_GCM128_NONCE_LEN        12
 #define AES_GCM128_TAG_LEN          16
+#define ATOP_CRYPT_CHUNK            64 // bytes encrypted per step into the hex output
 
 typedef struct {
     char *key;
     char *value;
 } url_param_t;
 
+static const char s_hex_upper[] = "0123456789ABCDEF";
+static const char s_hex_lower[] = "0123456789abcdef";
+
+static void atop_hex_encode(const uint8_t *input, size_t ilen, const char *digits, char *out)
+{
+    size_t i;
+
+    for (i = 0; i < ilen; i++) {
+        *out++ = digits[input[i] >> 4];
+        *out++ = digits[input[i] & 0x0F];
+    }
+}
+
 static int atop_url_params_sign(const char *key, url_param_t *params, int param_num, uint8_t *out, size_t *olen)
 {
     int rt = OPRT_OK;
-    size_t printlen = 0;
     int i = 0;
     uint8_t digest[MD5SUM_LENGTH];
+    TKL_HASH_HANDLE md5 = NULL;
 
-    char *buffer = tal_malloc(512);
-    TUYA_CHECK_NULL_RETURN(buffer, OPRT_MALLOC_FAILED);
-
+    // md5 of "k1=v1||k2=v2||...key", hashed piece by piece
+    TUYA_CALL_ERR_RETURN(tal_md5_create_init(&md5));
+    TUYA_CALL_ERR_GOTO(tal_md5_starts_ret(md5), __exit);
     for (i = 0; i < param_num; ++i) {
-        int ret = snprintf(buffer + printlen, 512 - printlen, "%s=%s||", params[i].key, params[i].value);
-        if (ret < 0 || (size_t)ret >= 512 - printlen) {
-            tal_free(buffer);
-            return OPRT_BUFFER_NOT_ENOUGH;
-        }
-        printlen += (size_t)ret;
-    }
-    int ret = snprintf(buffer + printlen, 512 - printlen, "%s", (char *)key);
-    if (ret < 0 || (size_t)ret >= 512 - printlen) {
-        tal_free(buffer);
-        return OPRT_BUFFER_NOT_ENOUGH;
+        TUYA_CALL_ERR_GOTO(tal_md5_update_ret(md5, (const uint8_t *)params[i].key, strlen(params[i].key)), __exit);
+        TUYA_CALL_ERR_GOTO(tal_md5_update_ret(md5, (const uint8_t *)"=", 1), __exit);
+        TUYA_CALL_ERR_GOTO(tal_md5_update_ret(md5, (const uint8_t *)params[i].value, strlen(params[i].value)),
+                           __exit);
+        TUYA_CALL_ERR_GOTO(tal_md5_update_ret(md5, (const uint8_t *)"||", 2), __exit);
     }
-    printlen += (size_t)ret;
-
-    // make md5 digest bin
-    tal_md5_ret((const uint8_t *)buffer, printlen, digest);
-    tal_free(buffer);
+    TUYA_CALL_ERR_GOTO(tal_md5_update_ret(md5, (const uint8_t *)key, strlen(key)), __exit);
+    TUYA_CALL_ERR_GOTO(tal_md5_finish_ret(md5, digest), __exit);
 
     // make digest hex
-    char sign_buf[MD5SUM_LENGTH * 2 + 1] = {0};
-    size_t sign_offset = 0;
-    for (i = 0; i < MD5SUM_LENGTH; i++) {
-        ret = snprintf(sign_buf + sign_offset, sizeof(sign_buf) - sign_offset, "%02x", digest[i]);
-        if (ret < 0 || (size_t)ret >= sizeof(sign_buf) - sign_offset) {
-            return OPRT_BUFFER_NOT_ENOUGH;
-        }
-        sign_offset += (size_t)ret;
-    }
-    memcpy(out, sign_buf, sign_offset);
-    out[sign_offset] = '\0';
-    *olen = sign_offset;
+    atop_hex_encode(digest, MD5SUM_LENGTH, s_hex_lower, (char *)out);
+    out[MD5SUM_LENGTH * 2] = '\0';
+    *olen = MD5SUM_LENGTH * 2;
+
+__exit:
+    tal_md5_free(md5);
     return rt;
 }
 
@@ -114,16 +116,15 @@ static int atop_url_params_encode(const char *key, url_param_t *params, int para
         return OPRT_BUFFER_NOT_ENOUGH;
     }
     printlen += (size_t)ret;
+    if (out_len - printlen < MD5SUM_LENGTH * 2 + 1) {
+        return OPRT_BUFFER_NOT_ENOUGH;
+    }
     rt = atop_url_params_sign(key, params, param_num, (uint8_t *)buffer + printlen, &sign_len);
     if (rt != 0) {
         PR_ERR("atop_url_params_sign error:%d", rt);
         return rt;
     }
     printlen += sign_len;
-    if (printlen >= out_len) {
-        return OPRT_BUFFER_NOT_ENOUGH;
-    }
-    buffer[printlen] = '\0';
     *olen = printlen;
     return rt;
 }
@@ -134,137 +135,214 @@ static int atop_request_data_encode(const char *key, const uint8_t *input, int i
     if (key == NULL || input == NULL || ilen == 0 || output == NULL || olen == NULL) {
         return OPRT_INVALID_PARM;
     }
+    if (output_len < ATOP_BASE_BODY_SIZE(ilen)) {
+        return OPRT_BUFFER_NOT_ENOUGH;
+    }
 
     int ret = 0;
-    size_t printlen = 0;
-    int i;
+    size_t offset = 0, chunk_len = 0, crypt_len = 0;
+    uint8_t block[ATOP_CRYPT_CHUNK];
+    char *out = (char *)output;
+    mbedtls_gcm_context gcm;
 
-    /* Encode buffer */
-    size_t encrypt_olen = 0;
-    size_t buflen = AES_GCM128_NONCE_LEN + ilen + AES_GCM128_TAG_LEN;
-    uint8_t *encrypted_buffer = tal_malloc(buflen);
-    if (encrypted_buffer == NULL) {
-        return OPRT_MALLOC_FAILED;
-    }
+    // "data=" HEX(nonce | AES128-GCM(input) | tag), encrypted chunk by chunk straight into the hex output
+    memcpy(out, "data=", POST_DATA_PREFIX);
+    out += POST_DATA_PREFIX;
 
     /* Nonce */
-    uni_random_string((char *)encrypted_buffer, AES_GCM128_NONCE_LEN);
+    uni_random_string((char *)block, AES_GCM128_NONCE_LEN);
+    atop_hex_encode(block, AES_GCM128_NONCE_LEN, s_hex_upper, out);
+    out += AES_GCM128_NONCE_LEN * 2;
 
     /* AES128-GCM */
-    ret = mbedtls_cipher_auth_encrypt_wrapper(&(const cipher_params_t){.cipher_type = MBEDTLS_CIPHER_AES_128_GCM,
-                                                                       .key = (unsigned char *)key,
-                                                                       .key_len = 16,
-                                                                       .nonce = encrypted_buffer,
-                                                                       .nonce_len = AES_GCM128_NONCE_LEN,
-                                                                       .ad = NULL,
-                                                                       .ad_len = 0,
-                                                                       .data = (unsigned char *)input,
-                                                                       .data_len = ilen},
-                                              encrypted_buffer + AES_GCM128_NONCE_LEN, &encrypt_olen,
-                                              encrypted_buffer + AES_GCM128_NONCE_LEN + ilen, AES_GCM128_TAG_LEN);
-    if (ret != OPRT_OK) {
-        PR_ERR("mbedtls_cipher_auth_encrypt_wrapper:0x%x", ret);
+    mbedtls_gcm_init(&gcm);
+    ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, (const unsigned char *)key, 128);
+    if (ret == 0) {
+        ret = mbedtls_gcm_starts(&gcm, MBEDTLS_GCM_ENCRYPT, block, AES_GCM128_NONCE_LEN);
+    }
+    for (offset = 0; ret == 0 && offset < (size_t)ilen; offset += chunk_len) {
+        chunk_len = ((size_t)ilen - offset < sizeof(block)) ? (size_t)ilen - offset : sizeof(block);
+        ret = mbedtls_gcm_update(&gcm, input + offset, chunk_len, block, sizeof(block), &crypt_len);
+        atop_hex_encode(block, crypt_len, s_hex_upper, out);
+        out += crypt_len * 2;
+    }
+    if (ret == 0) {
+        ret = mbedtls_gcm_finish(&gcm, NULL, 0, &crypt_len, block, AES_GCM128_TAG_LEN);
+        atop_hex_encode(block, AES_GCM128_TAG_LEN, s_hex_upper, out);
+        out += AES_GCM128_TAG_LEN * 2;
+    }
+    mbedtls_gcm_free(&gcm);
+    if (ret != 0) {
+        PR_ERR("aes128 gcm encrypt:0x%x", ret);
         return ret;
     }
 
-    // output the hex data
-    int write_len = snprintf((char *)output + printlen, output_len - printlen, "%s", "data=");
-    if (write_len < 0 || (size_t)write_len >= output_len - printlen) {
-        tal_free(encrypted_buffer);
-        return OPRT_BUFFER_NOT_ENOUGH;
+    *out = '\0';
+    *olen = out - (char *)output;
+    return OPRT_OK;
+}
+
+static int atop_base64_value(uint8_t c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
     }
-    printlen += (size_t)write_len;
-    for (i = 0; i < (int)buflen; i++) {
-        write_len =
-            snprintf((char *)output + printlen, output_len - printlen, "%02X", (uint8_t)(encrypted_buffer[i]));
-        if (write_len < 0 || (size_t)write_len >= output_len - printlen) {
-            tal_free(encrypted_buffer);
-            return OPRT_BUFFER_NOT_ENOUGH;
-        }
-        printlen += (size_t)write_len;
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
     }
 
-    tal_free(encrypted_buffer);
-    if (printlen >= output_len) {
-        return OPRT_BUFFER_NOT_ENOUGH;
+    return -1;
+}
+
+/* Decodes base64 over itself, the output never overtakes the input. JSON escapes ('\/') are skipped. */
+static int atop_base64_decode_inplace(uint8_t *buffer, size_t len, size_t *olen)
+{
+    uint32_t bits = 0;
+    size_t i, out = 0;
+    int nbits = 0, value;
+
+    for (i = 0; i < len; i++) {
+        if (buffer[i] == '\\') {
+            continue;
+        }
+        if (buffer[i] == '=') {
+            break;
+        }
+        value = atop_base64_value(buffer[i]);
+        if (value < 0) {
+            return OPRT_COM_ERROR;
+        }
+        bits = (bits << 6) | (uint32_t)value;
+        nbits += 6;
+        if (nbits >= 8) {
+            nbits -= 8;
+            buffer[out++] = (uint8_t)(bits >> nbits);
+        }
     }
-    output[printlen] = '\0';
-    *olen = printlen;
-    return ret;
+
+    *olen = out;
+    return OPRT_OK;
 }
 
-static int atop_response_result_decrpyt(const char *key, const uint8_t *input, int ilen, uint8_t *output, size_t *olen)
+/* Decrypts nonce | ciphertext | tag over itself, the plaintext starts at input[0] */
+static int atop_response_result_decrpyt(const char *key, uint8_t *input, size_t ilen, size_t *olen)
 {
-    if (key == NULL || input == NULL || ilen == 0 || output == NULL || olen == NULL) {
+    if (key == NULL || input == NULL || olen == NULL || ilen < AES_GCM128_NONCE_LEN + AES_GCM128_TAG_LEN) {
         return OPRT_INVALID_PARM;
     }
 
     int rt = OPRT_OK;
+    size_t data_len = ilen - AES_GCM128_NONCE_LEN - AES_GCM128_TAG_LEN;
+    size_t crypt_len = 0;
+    uint8_t tag[AES_GCM128_TAG_LEN];
+    uint8_t diff = 0;
+    mbedtls_gcm_context gcm;
+    int i;
 
-    rt = mbedtls_cipher_auth_decrypt_wrapper(
-        &(const cipher_params_t){.cipher_type = MBEDTLS_CIPHER_AES_128_GCM,
-                                 .key = (unsigned char *)key,
-                                 .key_len = 16,
-                                 .nonce = (unsigned char *)input,
-                                 .nonce_len = AES_GCM128_NONCE_LEN,
-                                 .ad = NULL,
-                                 .ad_len = 0,
-                                 .data = (unsigned char *)(input + AES_GCM128_NONCE_LEN),
-                                 .data_len = ilen - AES_GCM128_NONCE_LEN - AES_GCM128_TAG_LEN},
-        output, olen, (unsigned char *)(input + (ilen - AES_GCM128_TAG_LEN)), AES_GCM128_TAG_LEN);
-    if (rt != OPRT_OK) {
-        PR_ERR("aes128_ecb_decode error:%d", rt);
+    mbedtls_gcm_init(&gcm);
+    rt = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, (const unsigned char *)key, 128);
+    if (rt == 0) {
+        rt = mbedtls_gcm_starts(&gcm, MBEDTLS_GCM_DECRYPT, input, AES_GCM128_NONCE_LEN);
+    }
+    if (rt == 0) {
+        rt = mbedtls_gcm_update(&gcm, input + AES_GCM128_NONCE_LEN, data_len, input, ilen, &crypt_len);
+    }
+    if (rt == 0) {
+        rt = mbedtls_gcm_finish(&gcm, NULL, 0, &crypt_len, tag, AES_GCM128_TAG_LEN);
+    }
+    mbedtls_gcm_free(&gcm);
+    if (rt != 0) {
+        PR_ERR("aes128 gcm decrypt error:%d", rt);
         return rt;
     }
 
+    // the received tag sits behind the plaintext and was not overwritten
+    for (i = 0; i < AES_GCM128_TAG_LEN; i++) {
+        diff |= tag[i] ^ input[AES_GCM128_NONCE_LEN + data_len + i];
+    }
+    if (diff != 0) {
+        PR_ERR("aes128 gcm tag mismatch");
+        return MBEDTLS_ERR_GCM_AUTH_FAILED;
+    }
+
+    *olen = data_len;
     return rt;
 }
 
-static int atop_response_data_decode(const char *key, const uint8_t *input, size_t ilen, uint8_t *output, size_t *olen)
+/* Finds the string value of the top level "result" key, NULL if there is none */
+static uint8_t *atop_response_result_find(uint8_t *input, size_t ilen, size_t *value_len)
 {
-    int rt = OPRT_OK;
+    static const char pattern[] = "\"result\"";
+    uint8_t *end = input + ilen;
+    uint8_t *p = input, *value = NULL;
 
-    char *value;
-    size_t value_length;
+    for (; p + sizeof(pattern) - 1 <= end; p++) {
+        if (*p == '"' && 0 == memcmp(p, pattern, sizeof(pattern) - 1)) {
+            break;
+        }
+    }
+    if (p + sizeof(pattern) - 1 > end) {
+        return NULL;
+    }
 
-    cJSON *root = cJSON_Parse((char *)input);
-    if (NULL == root) {
-        return OPRT_CJSON_PARSE_ERR;
+    for (p += sizeof(pattern) - 1; p < end && (*p == ' ' || *p == ':' || *p == '\t' || *p == '\r' || *p == '\n');
+         p++) {
+    }
+    if (p >= end || *p != '"') {
+        return NULL;
+    }
+
+    value = ++p;
+    for (; p < end && *p != '"'; p++) {
+    }
+    if (p >= end) {
+        return NULL;
     }
 
-    cJSON *item = cJSON_GetObjectItem(root, "result");
-    if (NULL == item) {
+    *value_len = p - value;
+    return value;
+}
+
+/* Decodes the encrypted "result" in place, the plaintext is returned NUL terminated inside input */
+static int atop_response_data_decode(const char *key, uint8_t *input, size_t ilen, uint8_t **output, size_t *olen)
+{
+    int rt = OPRT_OK;
+
+    uint8_t *value;
+    size_t value_length = 0, raw_length = 0;
+
+    value = atop_response_result_find(input, ilen, &value_length);
+    if (NULL == value) {
         PR_ERR("no result");
         return OPRT_CJSON_GET_ERR;
     }
 
-    value = item->valuestring;
-    value_length = strlen(value);
-
     PR_TRACE("base64 encode result:\r\n%.*s", value_length, value);
 
-    // base64 decode buffer
-    size_t b64buffer_len = value_length * 3 / 4;
-    uint8_t *b64buffer = tal_malloc(b64buffer_len);
-    size_t b64buffer_olen = 0;
-
     // base64 decode
-    rt = mbedtls_base64_decode(b64buffer, b64buffer_len, &b64buffer_olen, (const uint8_t *)value, value_length);
+    rt = atop_base64_decode_inplace(value, value_length, &raw_length);
     if (rt != OPRT_OK) {
         PR_ERR("base64 decode error:%d", rt);
-        tal_free(b64buffer);
-        cJSON_Delete(root);
         return rt;
     }
 
-    rt = atop_response_result_decrpyt(key, (const uint8_t *)b64buffer, b64buffer_olen, output, olen);
-    cJSON_Delete(root);
-    tal_free(b64buffer);
+    rt = atop_response_result_decrpyt(key, value, raw_length, olen);
     if (rt != OPRT_OK) {
         PR_ERR("atop_data_decrpyt error: %d", rt);
         return rt;
     }
-    PR_DEBUG("result:\r\n%.*s", *olen, output);
+    value[*olen] = '\0';
+    *output = value;
+    PR_DEBUG("result:\r\n%.*s", *olen, value);
 
     return rt;
 }
@@ -336,24 +414,26 @@ static int atop_response_result_parse_cjson(const uint8_t *input, size_t ilen, a
 }
 
 /**
- * Sends a request to the Tuya cloud service.
+ * @brief Signs and encrypts an ATOP request into a single buffer.
  *
- * This function sends a request to the Tuya cloud service using the provided
- * request parameters.
+ * The URL (path, parameters and md5 signature) and the POST body
+ * ("data=" followed by the hex of nonce, AES128-GCM ciphertext and tag) are
+ * both written into buffer, nothing else is allocated apart from the hash
+ * context. ATOP_BASE_BUFFER_SIZE(request->datalen) bytes are always enough.
  *
- * @param request The request parameters for the Tuya cloud service.
- * @param response The response structure to store the response from the Tuya
- * cloud service.
- * @return Returns an integer value indicating the status of the request:
- *         - OPRT_OK: The request was successful.
- *         - OPRT_INVALID_PARM: Invalid parameters were provided.
- *         - OPRT_MALLOC_FAILED: Memory allocation failed.
- *         - OPRT_LINK_CORE_HTTP_CLIENT_SEND_ERROR: Error occurred while sending
- * the HTTP request.
+ * @param request The request parameters.
+ * @param buffer Caller buffer that receives the URL and the body.
+ * @param buffer_len Length of buffer.
+ * @param path Set to the NUL terminated URL inside buffer.
+ * @param body Set to the NUL terminated body inside buffer.
+ * @param body_len Set to the length of the body.
+ * @return OPRT_OK on success, OPRT_BUFFER_NOT_ENOUGH if buffer is too small,
+ * or another error code on failure.
  */
-int atop_base_request(const atop_base_request_t *request, atop_base_response_t *response)
+int atop_base_request_encode(const atop_base_request_t *request, uint8_t *buffer, size_t buffer_len, char **path,
+                             uint8_t **body, size_t *body_len)
 {
-    if (NULL == request || NULL == response) {
+    if (NULL == request || NULL == buffer || NULL == path || NULL == body || NULL == body_len) {
         return OPRT_INVALID_PARM;
     }
     if (request->path == NULL || request->key == NULL || request->api == NULL || request->path[0] == '\0' ||
@@ -363,12 +443,11 @@ int atop_base_request(const atop_base_request_t *request, atop_base_response_t *
     if ((request->data == NULL && request->datalen > 0) || (request->data != NULL && request->datalen == 0)) {
         return OPRT_INVALID_PARM;
     }
+    if (buffer_len < MAX_URL_LENGTH + ATOP_BASE_BODY_SIZE(request->datalen)) {
+        return OPRT_BUFFER_NOT_ENOUGH;
+    }
 
     int rt = OPRT_OK;
-    http_client_status_t http_status;
-
-    /* user data */
-    response->user_data = (void *)request->user_data;
 
     /* params fill */
     url_param_t params[6];
@@ -399,62 +478,136 @@ int atop_base_request(const atop_base_request_t *request, atop_base_response_t *
         params[idx++].value = (char *)request->version;
     }
 
-    /* url param buffer make */
-    char *path_buffer = tal_malloc(MAX_URL_LENGTH);
-    if (NULL == path_buffer) {
-        PR_ERR("path_buffer malloc fail");
-        return OPRT_MALLOC_FAILED;
-    }
+    /* url params take the first MAX_URL_LENGTH bytes, the body the rest */
+    char *path_buffer = (char *)buffer;
+    uint8_t *body_buffer = buffer + MAX_URL_LENGTH;
 
     /* attach path prefix */
     int path_buffer_len = snprintf(path_buffer, MAX_URL_LENGTH, "%s?", (char *)request->path);
     if (path_buffer_len < 0 || path_buffer_len >= MAX_URL_LENGTH) {
         PR_ERR("path_buffer snprintf fail");
-        tal_free(path_buffer);
         return OPRT_BUFFER_NOT_ENOUGH;
     }
-    
+
     PR_DEBUG("TUYA_HTTPS_ATOP_URL: %s", path_buffer);
 
     /* param encode */
     size_t encode_len = 0;
-    size_t path_buffer_remain = (path_buffer_len < MAX_URL_LENGTH) ? (MAX_URL_LENGTH - path_buffer_len) : 0;
-    if (path_buffer_remain == 0) {
-        tal_free(path_buffer);
-        return OPRT_BUFFER_NOT_ENOUGH;
-    }
-    rt = atop_url_params_encode((char *)request->key, params, idx, path_buffer + path_buffer_len, path_buffer_remain,
-                                &encode_len);
+    rt = atop_url_params_encode((char *)request->key, params, idx, path_buffer + path_buffer_len,
+                                MAX_URL_LENGTH - path_buffer_len, &encode_len);
     if (rt != OPRT_OK) {
         PR_ERR("url param encode error:%d", rt);
-        tal_free(path_buffer);
         return rt;
     }
     path_buffer_len += encode_len;
     PR_DEBUG("request url len:%d: %s", path_buffer_len, path_buffer);
 
-    /* POST data buffer */
-    size_t body_length = 0;
-    size_t body_buffer_len =
-        POST_DATA_PREFIX + (request->datalen + AES_GCM128_NONCE_LEN + AES_GCM128_TAG_LEN) * 2 + 1;
-    uint8_t *body_buffer = tal_malloc(body_buffer_len);
-    if (NULL == body_buffer) {
-        PR_ERR("body_buffer malloc fail");
-        tal_free(path_buffer);
-        return OPRT_MALLOC_FAILED;
-    }
-
     /* POST data encode */
     PR_DEBUG("atop_request_data_encode");
-    rt = atop_request_data_encode((char *)request->key, request->data, request->datalen, body_buffer, body_buffer_len,
-                                  &body_length);
+    rt = atop_request_data_encode((char *)request->key, request->data, request->datalen, body_buffer,
+                                  buffer_len - MAX_URL_LENGTH, body_len);
     if (rt != OPRT_OK) {
         PR_ERR("atop_post_data_encrypt error:%d", rt);
-        tal_free(path_buffer);
-        tal_free(body_buffer);
         return rt;
     }
-    PR_DEBUG("out post data len:%d, data:%s", body_length, body_buffer);
+    PR_DEBUG("out post data len:%d, data:%s", *body_len, body_buffer);
+
+    *path = path_buffer;
+    *body = body_buffer;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Decrypts and parses an ATOP response body.
+ *
+ * The base64 "result" is decoded and decrypted in place, so body is
+ * overwritten and no intermediate buffer is allocated. A body without an
+ * encrypted result (an error reply, for instance) is parsed as plaintext.
+ *
+ * @param key The request key.
+ * @param body The HTTP response body, NUL terminated.
+ * @param body_len Length of the body.
+ * @param response Receives the parsed response.
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int atop_base_response_decode(const char *key, uint8_t *body, size_t body_len, atop_base_response_t *response)
+{
+    if (NULL == key || NULL == body || NULL == response) {
+        return OPRT_INVALID_PARM;
+    }
+
+    int rt = OPRT_OK;
+    uint8_t *result = NULL;
+    size_t result_length = 0;
+
+    /* Decoded response data */
+    rt = atop_response_data_decode(key, body, body_len, &result, &result_length);
+    if (OPRT_OK == rt) {
+        return atop_response_result_parse_cjson(result, result_length, response);
+    }
+    if (OPRT_CJSON_GET_ERR != rt) {
+        // the body was already decoded over, there is no plaintext left to try
+        return rt;
+    }
+
+    PR_NOTICE("atop_response_decode error:%d, try parse the plaintext data.", rt);
+    return atop_response_result_parse_cjson(body, body_len, response);
+}
+
+/**
+ * Sends a request to the Tuya cloud service.
+ *
+ * This function sends a request to the Tuya cloud service using the provided
+ * request parameters. The URL and body are built in request->buffer when it is
+ * large enough, otherwise in one temporary allocation, and the response is
+ * decrypted in place in the HTTP receive buffer.
+ *
+ * @param request The request parameters for the Tuya cloud service.
+ * @param response The response structure to store the response from the Tuya
+ * cloud service.
+ * @return Returns an integer value indicating the status of the request:
+ *         - OPRT_OK: The request was successful.
+ *         - OPRT_INVALID_PARM: Invalid parameters were provided.
+ *         - OPRT_MALLOC_FAILED: Memory allocation failed.
+ *         - OPRT_LINK_CORE_HTTP_CLIENT_SEND_ERROR: Error occurred while sending
+ * the HTTP request.
+ */
+int atop_base_request(const atop_base_request_t *request, atop_base_response_t *response)
+{
+    if (NULL == request || NULL == response) {
+        return OPRT_INVALID_PARM;
+    }
+
+    int rt = OPRT_OK;
+    http_client_status_t http_status;
+    size_t buffer_len = ATOP_BASE_BUFFER_SIZE(request->datalen);
+    uint8_t *buffer = request->buffer;
+    char *path = NULL;
+    uint8_t *body = NULL;
+    size_t body_length = 0;
+
+    /* user data */
+    response->user_data = (void *)request->user_data;
+
+    /* request buffer */
+    if (NULL == buffer || request->buffer_len < buffer_len) {
+        buffer = tal_malloc(buffer_len);
+        if (NULL == buffer) {
+            PR_ERR("request buffer malloc fail");
+            return OPRT_MALLOC_FAILED;
+        }
+    } else {
+        buffer_len = request->buffer_len;
+    }
+
+    rt = atop_base_request_encode(request, buffer, buffer_len, &path, &body, &body_length);
+    if (rt != OPRT_OK) {
+        if (buffer != request->buffer) {
+            tal_free(buffer);
+        }
+        return rt;
+    }
 
     /* HTTP headers */
     http_client_header_t headers[] = {
@@ -473,44 +626,28 @@ int atop_base_request(const atop_base_request_t *request, atop_base_response_t *
                                                                      .host = endpoint->atop.host,
                                                                      .port = endpoint->atop.port,
                                                                      .method = "POST",
-                                                                     .path = path_buffer,
+                                                                     .path = path,
                                                                      .headers = headers,
                                                                      .headers_count = headers_count,
-                                                                     .body = body_buffer,
+                                                                     .body = body,
                                                                      .body_length = body_length,
                                                                      .timeout_ms = HTTP_TIMEOUT_MS_DEFAULT},
                                       &http_response);
 
-    /* Release http buffer */
-    tal_free(path_buffer);
-    tal_free(body_buffer);
+    /* Release request buffer */
+    if (buffer != request->buffer) {
+        tal_free(buffer);
+    }
 
     if (HTTP_CLIENT_SUCCESS != http_status) {
         PR_ERR("http_request_send error:%d", http_status);
         return OPRT_LINK_CORE_HTTP_CLIENT_SEND_ERROR;
     }
 
-    size_t result_buffer_length = 0;
-    uint8_t *result_buffer = tal_calloc(1, http_response.body_length);
-    if (NULL == result_buffer) {
-        PR_ERR("result_buffer malloc fail");
-        http_client_free(&http_response);
-        return OPRT_MALLOC_FAILED;
-    }
-
-    /* Decoded response data */
-    rt = atop_response_data_decode(request->key, http_response.body, http_response.body_length, result_buffer,
-                                   &result_buffer_length);
-
-    if (OPRT_OK == rt) {
-        rt = atop_response_result_parse_cjson(result_buffer, result_buffer_length, response);
-    } else {
-        PR_NOTICE("atop_response_decode error:%d, try parse the plaintext data.", rt);
-        rt = atop_response_result_parse_cjson(http_response.body, http_response.body_length, response);
-    }
+    /* Decrypted in the receive buffer, which is released right after */
+    rt = atop_base_response_decode(request->key, (uint8_t *)http_response.body, http_response.body_length, response);
 
     http_client_free(&http_response);
-    tal_free(result_buffer);
 
     return rt;
 }
@@ -26,6 +26,15 @@
 extern "C" {
 #endif
 
+/* Longest request URL, path and signed parameters */
+#define ATOP_BASE_URL_LEN (255)
+
+/* POST body for datalen bytes of data: "data=" + HEX(nonce | ciphertext | tag) + '\0' */
+#define ATOP_BASE_BODY_SIZE(datalen) (5 + ((datalen) + 12 + 16) * 2 + 1)
+
+/* Request buffer atop_base_request_encode needs: URL followed by the body */
+#define ATOP_BASE_BUFFER_SIZE(datalen) (ATOP_BASE_URL_LEN + ATOP_BASE_BODY_SIZE(datalen))
+
 typedef struct {
     const char *path;
     const char *key;
@@ -38,6 +47,8 @@ typedef struct {
     void *data;
     size_t datalen;
     const void *user_data;
+    uint8_t *buffer;   // optional request buffer, used if at least ATOP_BASE_BUFFER_SIZE(datalen)
+    size_t buffer_len; // length of buffer
 } atop_base_request_t;
 
 typedef struct {
@@ -66,6 +77,40 @@ typedef struct {
  */
 int atop_base_request(const atop_base_request_t *request, atop_base_response_t *response);
 
+/**
+ * @brief Signs and encrypts an ATOP request into a single buffer.
+ *
+ * The URL (path, parameters and md5 signature) and the POST body are both
+ * written into buffer. ATOP_BASE_BUFFER_SIZE(request->datalen) bytes are
+ * always enough.
+ *
+ * @param request Pointer to the request data.
+ * @param buffer Caller buffer that receives the URL and the body.
+ * @param buffer_len Length of buffer.
+ * @param path Set to the NUL terminated URL inside buffer.
+ * @param body Set to the NUL terminated body inside buffer.
+ * @param body_len Set to the length of the body.
+ * @return Returns 0 on success, OPRT_BUFFER_NOT_ENOUGH if buffer is too small,
+ * or another error code on failure.
+ */
+int atop_base_request_encode(const atop_base_request_t *request, uint8_t *buffer, size_t buffer_len, char **path,
+                             uint8_t **body, size_t *body_len);
+
+/**
+ * @brief Decrypts and parses an ATOP response body.
+ *
+ * The response is decoded in place, so body is overwritten. A body without an
+ * encrypted result is parsed as plaintext.
+ *
+ * @param key The request key.
+ * @param body The HTTP response body, NUL terminated.
+ * @param body_len Length of the body.
+ * @param response Pointer to the `atop_base_response_t` structure to store the
+ * response data.
+ * @return Returns 0 on success, or an error code on failure.
+ */
+int atop_base_response_decode(const char *key, uint8_t *body, size_t body_len, atop_base_response_t *response);
+
 /**
  * @brief Frees the memory allocated for an atop_base_response_t object.
  *
@@ -12,6 +12,13 @@
  * URLs of the Tuya cloud services they need to communicate with, based on their
  * region and environment settings.
  *
+ * Endpoints and host certificates are cached in memory and in KV with a TTL.
+ * A fresh entry is returned without any request; a stale one is returned at
+ * once and refreshed in the background (stale-while-revalidate), so a device
+ * rebooting or reconnecting does not wait for the IoT DNS round trip. An entry
+ * past its stale limit is fetched again synchronously, and is still used if
+ * that fetch fails.
+ *
  * @copyright Copyright (c) 2021-2024 Tuya Inc. All Rights Reserved.
  *
  */
@@ -29,6 +36,15 @@
 #include "http_client_interface.h"
 #include "tuya_register_center.h"
 #include "mix_method.h"
+#include "tal_kv.h"
+#include "tal_mutex.h"
+#include "tal_thread.h"
+#include "tal_time_service.h"
+#include "iotdns.h"
+
+#define IOTDNS_CACHE_KV_KEY       "iotdns.%08x"
+#define IOTDNS_CACHE_MAGIC        0x49444331 // "IDC1"
+#define IOTDNS_REFRESH_STACK_SIZE 4096
 
 #define IOTDNS_REQUEST_FMT                                                                                             \
     "{\"config\":[{\"key\":\"httpsSelfUrl\",\"need_ca\":true},{\"key\":"                                               \
@@ -38,6 +54,54 @@
     "{\"config\":[{\"key\":\"httpsSelfUrl\",\"need_ca\":true},{\"key\":"                                               \
     "\"mqttsSelfUrl\",\"need_ca\":true}],\"env\":\"%s\"}"
 
+typedef enum {
+    IOTDNS_CACHE_ENDPOINT,
+    IOTDNS_CACHE_CERT,
+} iotdns_cache_type_t;
+
+typedef enum {
+    IOTDNS_CACHE_FRESH,
+    IOTDNS_CACHE_STALE,
+    IOTDNS_CACHE_EXPIRED,
+} iotdns_cache_state_t;
+
+/* Cache key, zero filled so that it can be compared and hashed as bytes */
+typedef struct {
+    uint8_t type;
+    uint16_t port;                       // cert: port of the host
+    char host[MAX_LENGTH_TUYA_HOST + 1]; // cert: queried host, endpoint: register center
+    char region[MAX_LENGTH_REGION + 1];  // endpoint only, empty if not given
+    char env[MAX_LENGTH_REGIST + 1];     // endpoint only
+} iotdns_request_t;
+
+/* Endpoint: tuya_endpoint_t (cert pointer cleared) followed by the cert.
+ * Cert: the DER certificate. */
+typedef struct {
+    iotdns_request_t req;
+    uint8_t *data;
+    size_t len;
+    TIME_T fetched;     // posix time of the fetch, 0 if the clock was not synced
+    uint32_t used;      // LRU tick
+    uint8_t verified;   // fetched from the cloud since boot
+    uint8_t refreshing; // queued for the background refresh
+} iotdns_cache_entry_t;
+
+/* KV record: iotdns_kv_head_t followed by the cached data */
+typedef struct {
+    uint32_t magic;
+    uint32_t fetched;
+    iotdns_request_t req;
+} iotdns_kv_head_t;
+
+static iotdns_http_request_cb_t s_iotdns_http_request = http_client_request;
+
+#if (IOTDNS_CACHE_NUM > 0)
+static MUTEX_HANDLE s_iotdns_mutex = NULL;
+static THREAD_HANDLE s_iotdns_refresh_thread = NULL;
+static iotdns_cache_entry_t s_iotdns_cache[IOTDNS_CACHE_NUM];
+static uint32_t s_iotdns_tick = 0;
+#endif
+
 static int iotdns_response_decode(const uint8_t *input, size_t ilen, tuya_endpoint_t *endport)
 {
     cJSON *root = cJSON_Parse((const char *)input);
@@ -113,7 +177,7 @@ static int iotdns_base_request(char *body, char *path, http_client_response_t *h
 
     /* HTTP Request send */
     PR_DEBUG("http request send!");
-    http_status = http_client_request(
+    http_status = s_iotdns_http_request(
         &(const http_client_request_t){
             .cacert = rcs.ca_cert,
             .cacert_len = rcs.ca_cert_len,
@@ -137,24 +201,8 @@ static int iotdns_base_request(char *body, char *path, http_client_response_t *h
     return OPRT_OK;
 }
 
-/**
- * @brief Retrieves the cloud endpoint for the specified region and environment.
- *
- * This function sends an HTTP POST request to retrieve the cloud endpoint for
- * the specified region and environment.
- *
- * @param region The region to retrieve the cloud endpoint for. Can be NULL.
- * @param env The environment to retrieve the cloud endpoint for.
- * @param endpoint Pointer to a tuya_endpoint_t structure to store the retrieved
- * endpoint.
- *
- * @return Returns OPRT_OK on success, or an error code on failure.
- *         Possible error codes:
- *         - OPRT_INVALID_PARM: Invalid parameter (env or endpoint is NULL).
- *         - OPRT_MALLOC_FAILED: Memory allocation failed.
- *         - OPRT_LINK_CORE_HTTP_CLIENT_SEND_ERROR: Error sending HTTP request.
- */
-int iotdns_cloud_endpoint_get(const char *region, const char *env, tuya_endpoint_t *endpoint)
+/* Requests the endpoint from the IoT DNS service, bypassing the cache */
+static int iotdns_cloud_endpoint_fetch(const char *region, const char *env, tuya_endpoint_t *endpoint)
 {
     if (NULL == env || NULL == endpoint) {
         return OPRT_INVALID_PARM;
@@ -199,7 +247,7 @@ int iotdns_cloud_endpoint_get(const char *region, const char *env, tuya_endpoint
 
     /* HTTP Request send */
     PR_DEBUG("http request send!");
-    http_status = http_client_request(
+    http_status = s_iotdns_http_request(
         &(const http_client_request_t){
             .cacert = rcs.ca_cert,
             .cacert_len = rcs.ca_cert_len,
@@ -256,7 +304,7 @@ static int iotdns_query_domain_certs_parser(const uint8_t *input, uint8_t **cace
         goto __exit;
     }
     cJSON *ca = cJSON_GetObjectItem(item, "ca");
-    if (item == NULL) {
+    if (ca == NULL) {
         rt = OPRT_CJSON_GET_ERR;
         goto __exit;
     }
@@ -272,22 +320,8 @@ __exit:
     return rt;
 }
 
-/**
- * @brief Queries the host certificates using the IoT DNS service.
- *
- * This function queries the host certificates for a given host and port using
- * the IoT DNS service.
- *
- * @param[in] host The host name or IP address.
- * @param[in] port The port number.
- * @param[out] cacert A pointer to the buffer that will hold the retrieved CA
- * certificate.
- * @param[out] cacert_len A pointer to the variable that will hold the length of
- * the retrieved CA certificate.
- *
- * @return OPRT_OK if the operation is successful, otherwise an error code.
- */
-int tuya_iotdns_query_host_certs(char *host, uint16_t port, uint8_t **cacert, uint16_t *cacert_len)
+/* Requests the certificate of a host from the IoT DNS service, bypassing the cache */
+static int iotdns_host_certs_fetch(char *host, uint16_t port, uint8_t **cacert, uint16_t *cacert_len)
 {
     if (NULL == host) {
         return OPRT_INVALID_PARM;
@@ -316,6 +350,572 @@ int tuya_iotdns_query_host_certs(char *host, uint16_t port, uint8_t **cacert, ui
         http_client_free(&http_response);
     }
 
+    return rt;
+}
+
+/* Runs the request without the cache, the result is a tal_malloc buffer in the cached layout */
+static int __iotdns_fetch(const iotdns_request_t *req, uint8_t **data, size_t *len)
+{
+    int rt = OPRT_OK;
+
+    if (IOTDNS_CACHE_ENDPOINT == req->type) {
+        tuya_endpoint_t endpoint;
+        memset(&endpoint, 0, sizeof(tuya_endpoint_t));
+
+        rt = iotdns_cloud_endpoint_fetch(req->region[0] ? req->region : NULL, req->env, &endpoint);
+        if (OPRT_OK != rt) {
+            return rt;
+        }
+
+        *len = sizeof(tuya_endpoint_t) + endpoint.cert_len;
+        *data = tal_malloc(*len);
+        if (NULL == *data) {
+            tal_free(endpoint.cert);
+            return OPRT_MALLOC_FAILED;
+        }
+        memcpy(*data + sizeof(tuya_endpoint_t), endpoint.cert, endpoint.cert_len);
+        tal_free(endpoint.cert);
+        endpoint.cert = NULL;
+        memcpy(*data, &endpoint, sizeof(tuya_endpoint_t));
+    } else {
+        uint8_t *cert = NULL;
+        uint16_t cert_len = 0;
+
+        rt = iotdns_host_certs_fetch((char *)req->host, req->port, &cert, &cert_len);
+        if (OPRT_OK != rt || NULL == cert || 0 == cert_len) {
+            tal_free(cert);
+            return (OPRT_OK != rt) ? rt : OPRT_COM_ERROR;
+        }
+        *data = cert;
+        *len = cert_len;
+    }
+
+    return OPRT_OK;
+}
+
+#if (IOTDNS_CACHE_NUM > 0)
+static uint32_t __iotdns_cache_hash(const iotdns_request_t *req)
+{
+    const uint8_t *p = (const uint8_t *)req;
+    uint32_t hash = 0x811c9dc5; // FNV-1a of the request
+    size_t i;
+
+    for (i = 0; i < sizeof(iotdns_request_t); i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+
+    return hash;
+}
+
+static iotdns_cache_state_t __iotdns_cache_state(const iotdns_cache_entry_t *entry)
+{
+    TIME_T now = 0;
+
+    if (OPRT_OK == tal_time_check_time_sync()) {
+        now = tal_time_get_posix();
+    }
+
+    // Age unknown without a synced clock: revalidate once per boot, then trust it
+    if (0 == now || 0 == entry->fetched || now < entry->fetched) {
+        return entry->verified ? IOTDNS_CACHE_FRESH : IOTDNS_CACHE_STALE;
+    }
+    if (now - entry->fetched < IOTDNS_CACHE_TTL) {
+        return IOTDNS_CACHE_FRESH;
+    }
+    if (now - entry->fetched < IOTDNS_CACHE_TTL + IOTDNS_CACHE_MAX_STALE) {
+        return IOTDNS_CACHE_STALE;
+    }
+
+    return IOTDNS_CACHE_EXPIRED;
+}
+
+/* Checks a record read back from KV before it is trusted */
+static BOOL_T __iotdns_cache_valid(const iotdns_request_t *req, const uint8_t *data, size_t len)
+{
+    tuya_endpoint_t endpoint;
+
+    if (IOTDNS_CACHE_CERT == req->type) {
+        return len > 0;
+    }
+    if (len < sizeof(tuya_endpoint_t)) {
+        return FALSE;
+    }
+    memcpy(&endpoint, data, sizeof(tuya_endpoint_t));
+
+    return endpoint.cert_len == len - sizeof(tuya_endpoint_t) && endpoint.cert_len > 0;
+}
+
+static iotdns_cache_entry_t *__iotdns_cache_find(const iotdns_request_t *req)
+{
+    uint32_t i;
+
+    for (i = 0; i < IOTDNS_CACHE_NUM; i++) {
+        if (s_iotdns_cache[i].data && 0 == memcmp(&s_iotdns_cache[i].req, req, sizeof(iotdns_request_t))) {
+            return &s_iotdns_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Takes a free slot, or the least recently used one that is not being refreshed */
+static iotdns_cache_entry_t *__iotdns_cache_alloc(const iotdns_request_t *req)
+{
+    iotdns_cache_entry_t *entry = NULL;
+    uint32_t i;
+
+    for (i = 0; i < IOTDNS_CACHE_NUM; i++) {
+        if (NULL == s_iotdns_cache[i].data) {
+            entry = &s_iotdns_cache[i];
+            break;
+        }
+        if (s_iotdns_cache[i].refreshing) {
+            continue;
+        }
+        if (NULL == entry || s_iotdns_cache[i].used < entry->used) {
+            entry = &s_iotdns_cache[i];
+        }
+    }
+
+    if (entry) {
+        tal_free(entry->data);
+        memset(entry, 0, sizeof(iotdns_cache_entry_t));
+        memcpy(&entry->req, req, sizeof(iotdns_request_t));
+    }
+
+    return entry;
+}
+
+static void __iotdns_cache_kv_key(const iotdns_request_t *req, char *key, size_t key_len)
+{
+    snprintf(key, key_len, IOTDNS_CACHE_KV_KEY, __iotdns_cache_hash(req));
+}
+
+static iotdns_cache_entry_t *__iotdns_cache_kv_load(const iotdns_request_t *req)
+{
+    iotdns_cache_entry_t *entry = NULL;
+    iotdns_kv_head_t head;
+    uint8_t *value = NULL, *data = NULL;
+    size_t len = 0;
+    char key[24];
+
+    __iotdns_cache_kv_key(req, key, sizeof(key));
+    if (OPRT_OK != tal_kv_get(key, &value, &len)) {
+        return NULL;
+    }
+
+    if (len > sizeof(iotdns_kv_head_t)) {
+        memcpy(&head, value, sizeof(iotdns_kv_head_t));
+        len -= sizeof(iotdns_kv_head_t);
+        if (IOTDNS_CACHE_MAGIC == head.magic && 0 == memcmp(&head.req, req, sizeof(iotdns_request_t)) &&
+            __iotdns_cache_valid(req, value + sizeof(iotdns_kv_head_t), len)) {
+            data = tal_malloc(len);
+        }
+    }
+
+    if (data && NULL != (entry = __iotdns_cache_alloc(req))) {
+        memcpy(data, value + sizeof(iotdns_kv_head_t), len);
+        entry->data = data;
+        entry->len = len;
+        entry->fetched = head.fetched;
+        entry->used = ++s_iotdns_tick;
+        PR_DEBUG("iotdns cache %s loaded, fetched at %d", key, entry->fetched);
+    } else {
+        tal_free(data);
+    }
+    tal_kv_free(value);
+
+    return entry;
+}
+
+static void __iotdns_cache_kv_save(const iotdns_cache_entry_t *entry)
+{
+    size_t len = sizeof(iotdns_kv_head_t) + entry->len;
+    iotdns_kv_head_t *head = NULL;
+    uint8_t *value = NULL;
+    char key[24];
+
+    value = tal_malloc(len);
+    if (NULL == value) {
+        return;
+    }
+
+    head = (iotdns_kv_head_t *)value;
+    memset(head, 0, sizeof(iotdns_kv_head_t));
+    head->magic = IOTDNS_CACHE_MAGIC;
+    head->fetched = entry->fetched;
+    memcpy(&head->req, &entry->req, sizeof(iotdns_request_t));
+    memcpy(value + sizeof(iotdns_kv_head_t), entry->data, entry->len);
+
+    __iotdns_cache_kv_key(&entry->req, key, sizeof(key));
+    if (OPRT_OK != tal_kv_set(key, value, len)) {
+        PR_WARN("iotdns cache %s save failed", key);
+    }
+    tal_free(value);
+}
+
+/* Stores a fetched result in memory and KV, called with the mutex held */
+static void __iotdns_cache_store(const iotdns_request_t *req, const uint8_t *data, size_t len)
+{
+    iotdns_cache_entry_t *entry = __iotdns_cache_find(req);
+    TIME_T fetched = 0;
+    uint8_t *copy = NULL;
+
+    if (OPRT_OK == tal_time_check_time_sync()) {
+        fetched = tal_time_get_posix();
+    }
+
+    // Unchanged data only needs a new timestamp, skip the flash write if there is none
+    if (entry && entry->len == len && 0 == memcmp(entry->data, data, len)) {
+        entry->verified = 1;
+        entry->used = ++s_iotdns_tick;
+        if (fetched) {
+            entry->fetched = fetched;
+            __iotdns_cache_kv_save(entry);
+        }
+        return;
+    }
+
+    copy = tal_malloc(len);
+    if (NULL == copy) {
+        return;
+    }
+    memcpy(copy, data, len);
+
+    if (NULL == entry) {
+        entry = __iotdns_cache_alloc(req);
+    } else {
+        tal_free(entry->data);
+    }
+    if (NULL == entry) {
+        tal_free(copy);
+        return;
+    }
+
+    entry->data = copy;
+    entry->len = len;
+    entry->fetched = fetched;
+    entry->verified = 1;
+    entry->used = ++s_iotdns_tick;
+    __iotdns_cache_kv_save(entry);
+}
+
+/* Returns a private copy of the entry, NUL terminated for PEM parsers */
+static int __iotdns_cache_copy(iotdns_cache_entry_t *entry, uint8_t **data, size_t *len)
+{
+    *data = tal_malloc(entry->len + 1);
+    if (NULL == *data) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memcpy(*data, entry->data, entry->len);
+    (*data)[entry->len] = '\0';
+    *len = entry->len;
+    entry->used = ++s_iotdns_tick;
+
+    return OPRT_OK;
+}
+
+static void __iotdns_refresh_thread(void *arg)
+{
+    THREAD_HANDLE thread = NULL;
+    iotdns_request_t req;
+    uint8_t *data = NULL;
+    size_t len = 0;
+    uint32_t i;
+    int rt;
+
+    for (;;) {
+        tal_mutex_lock(s_iotdns_mutex);
+        for (i = 0; i < IOTDNS_CACHE_NUM; i++) {
+            if (s_iotdns_cache[i].data && s_iotdns_cache[i].refreshing) {
+                memcpy(&req, &s_iotdns_cache[i].req, sizeof(iotdns_request_t));
+                break;
+            }
+        }
+        if (i == IOTDNS_CACHE_NUM) {
+            thread = s_iotdns_refresh_thread;
+            s_iotdns_refresh_thread = NULL;
+            tal_mutex_unlock(s_iotdns_mutex);
+            break;
+        }
+        tal_mutex_unlock(s_iotdns_mutex);
+
+        rt = __iotdns_fetch(&req, &data, &len);
+
+        tal_mutex_lock(s_iotdns_mutex);
+        if (OPRT_OK == rt) {
+            __iotdns_cache_store(&req, data, len);
+            tal_free(data);
+            data = NULL;
+        } else {
+            PR_WARN("iotdns refresh failed %d, keep the stale entry", rt);
+        }
+        iotdns_cache_entry_t *entry = __iotdns_cache_find(&req);
+        if (entry) {
+            entry->refreshing = 0;
+        }
+        tal_mutex_unlock(s_iotdns_mutex);
+    }
+
+    tal_thread_delete(thread);
+}
+
+/* Queues a background refresh of the entry, called with the mutex held */
+static void __iotdns_refresh_schedule(iotdns_cache_entry_t *entry)
+{
+    if (entry->refreshing) {
+        return;
+    }
+    entry->refreshing = 1;
+
+    if (s_iotdns_refresh_thread) {
+        return;
+    }
+
+    THREAD_CFG_T thrd_param = {
+        .priority = THREAD_PRIO_3, .stackDepth = IOTDNS_REFRESH_STACK_SIZE, .thrdname = "iotdns_refresh"};
+    if (OPRT_OK != tal_thread_create_and_start(&s_iotdns_refresh_thread, NULL, NULL, __iotdns_refresh_thread, NULL,
+                                               &thrd_param)) {
+        PR_ERR("iotdns refresh thread create failed");
+        s_iotdns_refresh_thread = NULL;
+        entry->refreshing = 0;
+    }
+}
+
+static int __iotdns_cache_query(const iotdns_request_t *req, uint8_t **data, size_t *len)
+{
+    iotdns_cache_state_t state = IOTDNS_CACHE_EXPIRED;
+    iotdns_cache_entry_t *entry = NULL;
+    int rt = OPRT_OK;
+
+    if (NULL == s_iotdns_mutex) {
+        return __iotdns_fetch(req, data, len);
+    }
+
+    tal_mutex_lock(s_iotdns_mutex);
+    entry = __iotdns_cache_find(req);
+    if (NULL == entry) {
+        entry = __iotdns_cache_kv_load(req);
+    }
+    if (entry) {
+        state = __iotdns_cache_state(entry);
+    }
+    if (entry && IOTDNS_CACHE_EXPIRED != state) {
+        rt = __iotdns_cache_copy(entry, data, len);
+        if (OPRT_OK == rt && IOTDNS_CACHE_STALE == state) {
+            __iotdns_refresh_schedule(entry);
+        }
+        tal_mutex_unlock(s_iotdns_mutex);
+        return rt;
+    }
+    tal_mutex_unlock(s_iotdns_mutex);
+
+    rt = __iotdns_fetch(req, data, len);
+
+    tal_mutex_lock(s_iotdns_mutex);
+    if (OPRT_OK == rt) {
+        __iotdns_cache_store(req, *data, *len);
+    } else if (NULL != (entry = __iotdns_cache_find(req))) {
+        PR_WARN("iotdns fetch failed %d, use the expired entry", rt);
+        rt = __iotdns_cache_copy(entry, data, len);
+    }
+    tal_mutex_unlock(s_iotdns_mutex);
+
+    return rt;
+}
+#else
+static int __iotdns_cache_query(const iotdns_request_t *req, uint8_t **data, size_t *len)
+{
+    return __iotdns_fetch(req, data, len);
+}
+#endif
+
+/**
+ * @brief Initializes the IoT DNS cache.
+ *
+ * Until this is called every query goes to the IoT DNS service.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_cache_init(void)
+{
+#if (IOTDNS_CACHE_NUM > 0)
+    if (NULL == s_iotdns_mutex) {
+        return tal_mutex_create_init(&s_iotdns_mutex);
+    }
+#endif
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Drops the cached endpoints and certificates.
+ *
+ * @param[in] kv TRUE to delete the KV copies of the dropped entries as well,
+ * FALSE to keep them so that they are reloaded by the next query.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_cache_clear(BOOL_T kv)
+{
+#if (IOTDNS_CACHE_NUM > 0)
+    char key[24];
+    uint32_t i;
+
+    if (NULL == s_iotdns_mutex) {
+        return OPRT_COM_ERROR;
+    }
+
+    tal_mutex_lock(s_iotdns_mutex);
+    for (i = 0; i < IOTDNS_CACHE_NUM; i++) {
+        if (NULL == s_iotdns_cache[i].data) {
+            continue;
+        }
+        if (kv) {
+            __iotdns_cache_kv_key(&s_iotdns_cache[i].req, key, sizeof(key));
+            tal_kv_del(key);
+        }
+        tal_free(s_iotdns_cache[i].data);
+        memset(&s_iotdns_cache[i], 0, sizeof(iotdns_cache_entry_t));
+    }
+    tal_mutex_unlock(s_iotdns_mutex);
+#endif
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Set up a customized HTTP request interface for the IoT DNS service.
+ *
+ * @param[in] request_func The request function, NULL restores http_client_request.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_http_port_register(iotdns_http_request_cb_t request_func)
+{
+    s_iotdns_http_request = request_func ? request_func : http_client_request;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Retrieves the cloud endpoint for the specified region and environment.
+ *
+ * The endpoint is served from the cache when present. A stale entry is
+ * returned at once and refreshed in the background; a missing or expired one
+ * is requested from the IoT DNS service with an HTTP POST. The caller owns
+ * endpoint->cert and releases it with tal_free.
+ *
+ * @param region The region to retrieve the cloud endpoint for. Can be NULL.
+ * @param env The environment to retrieve the cloud endpoint for.
+ * @param endpoint Pointer to a tuya_endpoint_t structure to store the retrieved
+ * endpoint.
+ *
+ * @return Returns OPRT_OK on success, or an error code on failure.
+ *         Possible error codes:
+ *         - OPRT_INVALID_PARM: Invalid parameter (env or endpoint is NULL).
+ *         - OPRT_MALLOC_FAILED: Memory allocation failed.
+ *         - OPRT_LINK_CORE_HTTP_CLIENT_SEND_ERROR: Error sending HTTP request.
+ */
+int iotdns_cloud_endpoint_get(const char *region, const char *env, tuya_endpoint_t *endpoint)
+{
+    if (NULL == env || NULL == endpoint) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (strlen(env) > MAX_LENGTH_REGIST || (region && strlen(region) > MAX_LENGTH_REGION)) {
+        return iotdns_cloud_endpoint_fetch(region, env, endpoint);
+    }
+
+    int rt = OPRT_OK;
+    iotdns_request_t req;
+    register_center_t rcs;
+    tuya_endpoint_t cached;
+    uint8_t *data = NULL;
+    size_t len = 0;
+
+    /* The register center is part of the key, switching it drops the old entries */
+    tuya_register_center_get(&rcs);
+    memset(&req, 0, sizeof(iotdns_request_t));
+    req.type = IOTDNS_CACHE_ENDPOINT;
+    if (rcs.urlx || rcs.url0) {
+        strncpy(req.host, rcs.urlx ? rcs.urlx : rcs.url0, MAX_LENGTH_TUYA_HOST);
+    }
+    if (region) {
+        strcpy(req.region, region);
+    }
+    strcpy(req.env, env);
+
+    rt = __iotdns_cache_query(&req, &data, &len);
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+
+    memcpy(&cached, data, sizeof(tuya_endpoint_t));
+    endpoint->cert = tal_malloc(cached.cert_len + 1);
+    if (NULL == endpoint->cert) {
+        tal_free(data);
+        return OPRT_MALLOC_FAILED;
+    }
+    memcpy(endpoint->cert, data + sizeof(tuya_endpoint_t), cached.cert_len);
+    endpoint->cert[cached.cert_len] = '\0';
+    endpoint->cert_len = cached.cert_len;
+    tal_free(data);
+
+    memcpy(&endpoint->atop, &cached.atop, sizeof(endpoint->atop));
+    memcpy(&endpoint->mqtt, &cached.mqtt, sizeof(endpoint->mqtt));
+    if (region) {
+        strcpy(endpoint->region, region);
+    }
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Queries the host certificates using the IoT DNS service.
+ *
+ * This function queries the host certificates for a given host and port using
+ * the IoT DNS service. The certificate is served from the cache when present,
+ * with the same refresh rules as iotdns_cloud_endpoint_get. The caller owns
+ * the returned buffer and releases it with tal_free.
+ *
+ * @param[in] host The host name or IP address.
+ * @param[in] port The port number.
+ * @param[out] cacert A pointer to the buffer that will hold the retrieved CA
+ * certificate.
+ * @param[out] cacert_len A pointer to the variable that will hold the length of
+ * the retrieved CA certificate.
+ *
+ * @return OPRT_OK if the operation is successful, otherwise an error code.
+ */
+int tuya_iotdns_query_host_certs(char *host, uint16_t port, uint8_t **cacert, uint16_t *cacert_len)
+{
+    if (NULL == host || NULL == cacert || NULL == cacert_len) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (strlen(host) > MAX_LENGTH_TUYA_HOST) {
+        return iotdns_host_certs_fetch(host, port, cacert, cacert_len);
+    }
+
+    int rt = OPRT_OK;
+    iotdns_request_t req;
+    uint8_t *data = NULL;
+    size_t len = 0;
+
+    memset(&req, 0, sizeof(iotdns_request_t));
+    req.type = IOTDNS_CACHE_CERT;
+    req.port = port;
+    strcpy(req.host, host);
+
+    rt = __iotdns_cache_query(&req, &data, &len);
+    if (OPRT_OK != rt) {
+        return rt;
+    }
+
+    *cacert = data;
+    *cacert_len = (uint16_t)len;
+
     return OPRT_OK;
 }
 
@@ -21,11 +21,15 @@
 
 #include "tuya_cloud_types.h"
 #include "tuya_endpoint.h"
+#include "http_client_interface.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef http_client_status_t (*iotdns_http_request_cb_t)(const http_client_request_t *request,
+                                                         http_client_response_t *response);
+
 /**
  * @brief Queries the domain certificates for a given URL.
  *
@@ -59,6 +63,37 @@ int tuya_iotdns_query_domain_certs(char *url, uint8_t **cacert, uint16_t *cacert
  */
 int tuya_iotdns_query_host_certs(char *host, uint16_t port, uint8_t **cacert, uint16_t *cacert_len);
 
+/**
+ * @brief Initializes the IoT DNS cache.
+ *
+ * Until this is called every query goes to the IoT DNS service.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_cache_init(void);
+
+/**
+ * @brief Drops the cached endpoints and certificates.
+ *
+ * @param[in] kv TRUE to delete the KV copies of the dropped entries as well,
+ * FALSE to keep them so that they are reloaded by the next query.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_cache_clear(BOOL_T kv);
+
+/**
+ * @brief Set up a customized HTTP request interface for the IoT DNS service.
+ *
+ * The requests to the register center go through request_func instead of
+ * http_client_request, e.g. to answer them from a local stand-in.
+ *
+ * @param[in] request_func The request function, NULL restores http_client_request.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int tuya_iotdns_http_port_register(iotdns_http_request_cb_t request_func);
+
 #ifdef __cplusplus
 }
 #endif
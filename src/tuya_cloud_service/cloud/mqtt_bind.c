@@ -192,7 +192,7 @@ void mqtt_bind_token_get_thread(void *args)
             rt = tuya_mqtt_start(&mqbind->mqctx);
             if (OPRT_OK != rt) {
                 PR_ERR("tuya mqtt connect fail:%d, retry..", rt);
-                tal_system_sleep(1000);
+                tal_system_sleep(1000 + mqbind->mqctx.retry_backoff_ms);
                 break;
             }
             mqbind->state = STATE_MQTT_BIND_CONNECTED_WAIT;
@@ -37,6 +37,13 @@
 
 static void on_subscribe_message_default(uint16_t msgid, const mqtt_client_message_t *msg, void *userdata);
 
+static TAL_METRIC_COUNTER_DEFINE(s_metric_mqtt_rx, "mqtt_rx_messages_total", "MQTT messages received");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_mqtt_rx_bytes, "mqtt_rx_bytes_total", "MQTT payload bytes received");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_mqtt_tx, "mqtt_tx_messages_total", "MQTT messages published");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_mqtt_tx_bytes, "mqtt_tx_bytes_total", "MQTT payload bytes published");
+static TAL_METRIC_HISTOGRAM_DEFINE(s_metric_mqtt_dispatch, "mqtt_dispatch_ms", "protocol message decode and dispatch",
+                                   0);
+
 typedef struct {
     uint32_t sequence;
     uint32_t source;
@@ -224,6 +231,7 @@ static void mqtt_subscribe_message_distribute(tuya_mqtt_context_t *context, uint
 static int tuya_protocol_message_parse_process(tuya_mqtt_context_t *context, const uint8_t *payload, size_t payload_len)
 {
     int ret = OPRT_OK;
+    SYS_TIME_T start_ms = tal_system_get_millisecond();
 
     char *jsonstr = NULL;
     ret = tuya_parse_protocol_data(DP_CMD_MQ, (uint8_t *)payload, payload_len, context->signature.cipherkey,
@@ -278,6 +286,7 @@ static int tuya_protocol_message_parse_process(tuya_mqtt_context_t *context, con
     /* UNLOCK */
 
     cJSON_Delete(root);
+    tal_metric_observe(&s_metric_mqtt_dispatch, (uint32_t)(tal_system_get_millisecond() - start_ms));
     return OPRT_OK;
 }
 
@@ -324,6 +333,9 @@ static void mqtt_client_message_cb(void *client, uint16_t msgid, const mqtt_clie
     client = client;
     tuya_mqtt_context_t *context = (tuya_mqtt_context_t *)userdata;
 
+    tal_metric_inc(&s_metric_mqtt_rx);
+    tal_metric_add(&s_metric_mqtt_rx_bytes, msg->length);
+
     /* topic filter */
     PR_DEBUG("recv message TopicName:%s, payload len:%d", msg->topic, msg->length);
     mqtt_subscribe_message_distribute(context, msgid, msg);
@@ -376,6 +388,13 @@ int tuya_mqtt_init(tuya_mqtt_context_t *context, const tuya_mqtt_config_t *confi
     /* Clean to zero */
     memset(context, 0, sizeof(tuya_mqtt_context_t));
 
+    /* Metrics, registered once */
+    tal_metric_register(&s_metric_mqtt_rx);
+    tal_metric_register(&s_metric_mqtt_rx_bytes);
+    tal_metric_register(&s_metric_mqtt_tx);
+    tal_metric_register(&s_metric_mqtt_tx_bytes);
+    tal_metric_register(&s_metric_mqtt_dispatch.base);
+
     /* configuration */
     context->user_data = config->user_data;
     context->on_unbind = config->on_unbind;
@@ -478,16 +497,18 @@ int tuya_mqtt_start(tuya_mqtt_context_t *context)
         PR_ERR("MQTT connect fail:%d", mqtt_status);
         /* Generate a random number and get back-off value (in milliseconds) for
          * the next connection retry. */
-        uint16_t nextRetryBackOff = 0U;
+        uint16_t nextRetryBackOff = MQTT_CONNECT_RETRY_MAX_DELAY_MS;
         if (BackoffAlgorithm_GetNextBackoff(&context->backoff_algorithm, rand(), &nextRetryBackOff) ==
             BackoffAlgorithmSuccess) {
             PR_WARN("Connection to the MQTT server failed. Retrying "
                     "connection after %hu ms backoff.",
                     (unsigned short)nextRetryBackOff);
-            tal_system_sleep(nextRetryBackOff + 10000);
         }
+        /* Waited out by the caller, so a link change can cut it short */
+        context->retry_backoff_ms = nextRetryBackOff;
         return OPRT_COM_ERROR;
     }
+    context->retry_backoff_ms = 0;
     return OPRT_OK;
 }
 
@@ -651,6 +672,9 @@ int tuya_mqtt_client_publish_common(tuya_mqtt_context_t *context, const char *to
         return OPRT_INVALID_PARM;
     }
 
+    tal_metric_inc(&s_metric_mqtt_tx);
+    tal_metric_add(&s_metric_mqtt_tx_bytes, payload_length);
+
     if (cb == NULL) {
         uint16_t msgid = mqtt_client_publish(context->mqtt_client, topic, payload, payload_length, MQTT_QOS_0);
         if (msgid <= 0) {
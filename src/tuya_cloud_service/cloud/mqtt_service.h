@@ -171,6 +171,7 @@ typedef struct {
     mqtt_subscribe_handle_t *subscribe_list;
     mqtt_publish_handle_t *publish_list;
     BackoffAlgorithmContext_t backoff_algorithm;
+    uint16_t retry_backoff_ms; // wait before the next tuya_mqtt_start, set when it fails
     uint32_t sequence_in;
     uint32_t sequence_out;
     bool manual_disconnect;
@@ -198,6 +199,8 @@ int tuya_mqtt_init(tuya_mqtt_context_t *context, const tuya_mqtt_config_t *confi
  * @brief Starts the MQTT service.
  *
  * This function starts the MQTT service using the provided MQTT context.
+ * It does not sleep when the connection fails, the caller waits
+ * context->retry_backoff_ms before it retries.
  *
  * @param context The MQTT context to be used for starting the service.
  * @return Returns 0 on success, or a negative error code on failure.
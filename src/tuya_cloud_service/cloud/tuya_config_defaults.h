@@ -97,4 +97,25 @@
 #define MATOP_TIMEOUT_MS_DEFAULT (8000U)
 #endif
 
+/**
+ * @brief Number of IoT DNS endpoints and certificates cached in RAM, 0 disables the cache.
+ */
+#ifndef IOTDNS_CACHE_NUM
+#define IOTDNS_CACHE_NUM 4
+#endif
+
+/**
+ * @brief Seconds an IoT DNS cache entry is used without a request.
+ */
+#ifndef IOTDNS_CACHE_TTL
+#define IOTDNS_CACHE_TTL (24 * 3600)
+#endif
+
+/**
+ * @brief Seconds past the TTL an IoT DNS cache entry is still used while it is refreshed in the background.
+ */
+#ifndef IOTDNS_CACHE_MAX_STALE
+#define IOTDNS_CACHE_MAX_STALE (7 * 24 * 3600)
+#endif
+
 #endif /* ifndef TUYA_CONFIG_DEFAULTS_H_ */
@@ -19,6 +19,13 @@
  * additional functionalities like watchdog timer management, based on the
  * project configuration.
  *
+ * With ENABLE_TAL_METRICS the monitor also feeds the tal_metrics registry:
+ * it samples heap, queue and timer gauges every HEALTH_METRICS_INTERVAL
+ * seconds and exposes all registered metrics through the "metrics" CLI
+ * command and, when HEALTH_METRICS_PORT is set, as Prometheus text on that
+ * port: in reply to any UDP datagram and to any HTTP request over TCP, so a
+ * Prometheus server can scrape http://<device>:<port>/metrics directly.
+ *
  * @copyright Copyright (c) 2021-2024 Tuya Inc. All Rights Reserved.
  *
  */
@@ -33,6 +40,14 @@
 #ifndef STACK_SIZE_HEALTH_MONITOR
 #define STACK_SIZE_HEALTH_MONITOR (2048)
 #endif
+#ifndef HEALTH_METRICS_PORT
+#define HEALTH_METRICS_PORT 0
+#endif
+#ifndef STACK_SIZE_HEALTH_METRICS
+#define STACK_SIZE_HEALTH_METRICS (3072)
+#endif
+// one datagram or TCP segment stays below the usual MTU
+#define HEALTH_METRICS_DGRAM_LEN (1024)
 
 // health monitor detection index
 typedef struct {
@@ -441,6 +456,239 @@ static health_policy_t g_health_policy[] = {
     {HEALTH_RULE_FEED_WATCH_DOG, 0, HEALTH_WATCHDOG_INTERVAL, __watchdog_feed, NULL},
 };
 
+#if TAL_METRICS_ON
+static TAL_METRIC_GAUGE_DEFINE(s_metric_free_heap, "sys_free_heap_bytes", "free heap");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_uptime, "sys_uptime_seconds", "seconds since boot");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_heap_live, "sys_heap_live_bytes", "bytes held through tal_malloc");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_heap_peak, "sys_heap_peak_bytes", "peak of sys_heap_live_bytes");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_workq_sys, "sys_workq_system_depth", "system workqueue depth");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_workq_high, "sys_workq_highpri_depth", "high priority workqueue depth");
+static TAL_METRIC_GAUGE_DEFINE(s_metric_timer_num, "sys_sw_timer_num", "software timers");
+
+static TAL_METRIC_T *const s_health_metrics[] = {
+    &s_metric_free_heap, &s_metric_uptime,   &s_metric_heap_live, &s_metric_heap_peak,
+    &s_metric_workq_sys, &s_metric_workq_high, &s_metric_timer_num,
+};
+
+// Query type item that never fires, it only refreshes the system gauges
+static bool __health_metrics_sample(void)
+{
+    TAL_MEMORY_STATS_T stats;
+
+    tal_metric_set(&s_metric_free_heap, tal_system_get_free_heap_size());
+    tal_metric_set(&s_metric_uptime, (uint32_t)(tal_system_get_millisecond() / 1000));
+    if (OPRT_OK == tal_memory_get_stats(&stats)) {
+        tal_metric_set(&s_metric_heap_live, stats.live_bytes);
+        tal_metric_set(&s_metric_heap_peak, stats.peak_bytes);
+    }
+    tal_metric_set(&s_metric_workq_sys, tal_workq_get_num(WORKQ_SYSTEM));
+    tal_metric_set(&s_metric_workq_high, tal_workq_get_num(WORKQ_HIGHTPRI));
+    tal_metric_set(&s_metric_timer_num, tal_sw_timer_get_num());
+
+    return FALSE;
+}
+
+static void __health_metrics_echo(const char *line, void *arg)
+{
+    tal_cli_echo((char *)line);
+}
+
+static void __cli_metrics(int argc, char *argv[])
+{
+    __health_metrics_sample();
+    tal_metrics_print(__health_metrics_echo, NULL);
+}
+
+static const cli_cmd_t s_health_cli_cmd[] = {
+    {
+        .name = "metrics",
+        .help = "Print the runtime metrics in Prometheus text format",
+        .func = __cli_metrics,
+    },
+};
+
+#if HEALTH_METRICS_PORT
+typedef struct {
+    int udp_fd;
+    int tcp_fd;
+    int conn_fd; // HTTP connection being answered, -1 for a datagram reply
+    TUYA_IP_ADDR_T addr;
+    uint16_t port;
+    uint32_t len;
+    char buf[HEALTH_METRICS_DGRAM_LEN];
+} health_metrics_srv_t;
+
+static void __health_metrics_flush(health_metrics_srv_t *srv)
+{
+    if (srv->len) {
+        if (srv->conn_fd >= 0) {
+            tal_net_send(srv->conn_fd, srv->buf, srv->len);
+        } else {
+            tal_net_send_to(srv->udp_fd, srv->buf, srv->len, srv->addr, srv->port);
+        }
+    }
+    srv->len = 0;
+}
+
+static void __health_metrics_line(const char *line, void *arg)
+{
+    health_metrics_srv_t *srv = (health_metrics_srv_t *)arg;
+    uint32_t line_len = strlen(line);
+
+    if (line_len + 1 > sizeof(srv->buf)) {
+        return;
+    }
+    if (srv->len + line_len + 1 > sizeof(srv->buf)) {
+        __health_metrics_flush(srv);
+    }
+    memcpy(srv->buf + srv->len, line, line_len);
+    srv->len += line_len;
+    srv->buf[srv->len++] = '\n';
+}
+
+static void __health_metrics_reply(health_metrics_srv_t *srv)
+{
+    __health_metrics_sample();
+    tal_metrics_print(__health_metrics_line, srv);
+    __health_metrics_flush(srv);
+}
+
+// Answers any request with the metrics, it is all a Prometheus scrape needs
+static void __health_metrics_http(health_metrics_srv_t *srv)
+{
+    static const char head[] = "HTTP/1.0 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Connection: close\r\n\r\n";
+    int rlen = 0;
+
+    srv->conn_fd = tal_net_accept(srv->tcp_fd, &srv->addr, &srv->port);
+    if (srv->conn_fd < 0) {
+        return;
+    }
+    tal_net_set_timeout(srv->conn_fd, 1000, TRANS_RECV);
+    tal_net_set_timeout(srv->conn_fd, 1000, TRANS_SEND);
+
+    // read the request header, closing with unread data would reset the reply
+    srv->len = 0;
+    while (srv->len < sizeof(srv->buf) - 1) {
+        rlen = tal_net_recv(srv->conn_fd, srv->buf + srv->len, sizeof(srv->buf) - 1 - srv->len);
+        if (rlen <= 0) {
+            break;
+        }
+        srv->len += rlen;
+        srv->buf[srv->len] = '\0';
+        if (strstr(srv->buf, "\r\n\r\n")) {
+            break;
+        }
+    }
+
+    memcpy(srv->buf, head, sizeof(head) - 1);
+    srv->len = sizeof(head) - 1;
+    __health_metrics_reply(srv);
+
+    tal_net_close(srv->conn_fd);
+    srv->conn_fd = -1;
+}
+
+static void __health_metrics_task(void *arg)
+{
+    health_metrics_srv_t *srv = (health_metrics_srv_t *)arg;
+    int maxfd = srv->udp_fd > srv->tcp_fd ? srv->udp_fd : srv->tcp_fd;
+    TUYA_FD_SET_T readfds;
+    char req[16];
+
+    while (1) {
+        TAL_FD_ZERO(&readfds);
+        TAL_FD_SET(srv->udp_fd, &readfds);
+        TAL_FD_SET(srv->tcp_fd, &readfds);
+        if (tal_net_select(maxfd + 1, &readfds, NULL, NULL, 1000) <= 0) {
+            continue;
+        }
+
+        if (TAL_FD_ISSET(srv->udp_fd, &readfds) &&
+            tal_net_recvfrom(srv->udp_fd, req, sizeof(req), &srv->addr, &srv->port) >= 0) {
+            srv->len = 0;
+            __health_metrics_reply(srv);
+        }
+        if (TAL_FD_ISSET(srv->tcp_fd, &readfds)) {
+            __health_metrics_http(srv);
+        }
+    }
+}
+
+static int __health_metrics_socket(TUYA_PROTOCOL_TYPE_E type)
+{
+    int fd = tal_net_socket_create(type);
+
+    if (fd < 0) {
+        PR_ERR("metrics socket create fail:%d", tal_net_get_errno());
+        return -1;
+    }
+    if (OPRT_OK != tal_net_set_reuse(fd) || OPRT_OK != tal_net_bind(fd, TY_IPADDR_ANY, HEALTH_METRICS_PORT) ||
+        (PROTOCOL_TCP == type && OPRT_OK != tal_net_listen(fd, 1))) {
+        PR_ERR("metrics socket bind fail:%d", tal_net_get_errno());
+        tal_net_close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int __health_metrics_srv_start(void)
+{
+    int rt = OPRT_OK;
+    THREAD_HANDLE thread = NULL;
+    health_metrics_srv_t *srv = NULL;
+
+    srv = (health_metrics_srv_t *)Malloc(sizeof(health_metrics_srv_t));
+    TUYA_CHECK_NULL_RETURN(srv, OPRT_MALLOC_FAILED);
+    srv->conn_fd = -1;
+    srv->udp_fd = __health_metrics_socket(PROTOCOL_UDP);
+    srv->tcp_fd = __health_metrics_socket(PROTOCOL_TCP);
+    if (srv->udp_fd < 0 || srv->tcp_fd < 0) {
+        rt = OPRT_SOCK_ERR;
+        goto __exit;
+    }
+
+    THREAD_CFG_T thrd_param;
+    thrd_param.priority = THREAD_PRIO_3;
+    thrd_param.stackDepth = STACK_SIZE_HEALTH_METRICS;
+    thrd_param.thrdname = "health_metrics";
+    TUYA_CALL_ERR_GOTO(tal_thread_create_and_start(&thread, NULL, NULL, __health_metrics_task, srv, &thrd_param),
+                       __exit);
+    PR_DEBUG("metrics on udp and http port %d", HEALTH_METRICS_PORT);
+
+    return OPRT_OK;
+
+__exit:
+    PR_ERR("metrics server start fail:%d", rt);
+    if (srv->udp_fd >= 0) {
+        tal_net_close(srv->udp_fd);
+    }
+    if (srv->tcp_fd >= 0) {
+        tal_net_close(srv->tcp_fd);
+    }
+    Free(srv);
+    return rt;
+}
+#endif
+
+static void __health_metrics_init(void)
+{
+    int idx = 0;
+
+    for (idx = 0; idx < CNTSOF(s_health_metrics); idx++) {
+        tal_metric_register(s_health_metrics[idx]);
+    }
+    __health_metrics_sample();
+    tuya_health_item_add(0, HEALTH_METRICS_INTERVAL, __health_metrics_sample, NULL);
+    tal_cli_cmd_register(s_health_cli_cmd, CNTSOF(s_health_cli_cmd));
+#if HEALTH_METRICS_PORT
+    __health_metrics_srv_start();
+#endif
+}
+#endif
+
 static void __health_item_load(void)
 {
     int idx = 0;
@@ -485,6 +733,9 @@ int tuya_health_monitor_init(void)
         tal_event_subscribe(EVENT_REBOOT_ACK, "health_monitor", __health_reboot_cb, SUBSCRIBE_TYPE_NORMAL), __exit);
 
     __health_item_load();
+#if TAL_METRICS_ON
+    __health_metrics_init();
+#endif
     // init and start watch dog, use the return value as the real watch dog
     // interval
 #if defined(ENABLE_WATCHDOG) && (ENABLE_WATCHDOG == 1)
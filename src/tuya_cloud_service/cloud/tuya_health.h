@@ -49,6 +49,10 @@ extern "C" {
 // Default health monitoring scan interval, in seconds, must be a multiple of 20
 // seconds
 #define HEALTH_DETECT_INTERVAL 600
+// Default interval of the system gauges sampled into tal_metrics, in seconds
+#ifndef HEALTH_METRICS_INTERVAL
+#define HEALTH_METRICS_INTERVAL 10
+#endif
 
 // Health indicators, must be defined in the order of g_health_policy, otherwise
 // the reallocation of global type will be inaccurate
@@ -28,9 +28,15 @@
 #include "tal_api.h"
 #include "tuya_iot_dp.h"
 #include "tuya_register_center.h"
+#include "iotdns.h"
 #include "tuya_tls.h"
 #include "netmgr.h"
 #include "tuya_health.h"
+
+#define IOT_RETRY_MIN_MS        1000
+#define IOT_RETRY_MAX_MS        32000 // back-off cap of failed cloud requests
+#define IOT_NETWORK_POLL_MAX_MS 4000  // network_check poll cap, link up wakes the loop earlier
+
 typedef enum {
     STATE_IDLE,
     STATE_START,
@@ -58,6 +64,32 @@ static tuya_iot_client_t *s_iot_client_solo;
 /*                          Internal utils functions                          */
 /* -------------------------------------------------------------------------- */
 
+static void iot_wakeup(tuya_iot_client_t *client)
+{
+    if (client->wakeup) {
+        tal_semaphore_post(client->wakeup);
+    }
+}
+
+/* Block until an event wakes the state machine or the back-off expires,
+ * the back-off doubles on each call and is reset on every state change. */
+static void iot_retry_wait(tuya_iot_client_t *client, uint32_t max_ms)
+{
+    uint32_t wait_ms = client->retry_ms < max_ms ? client->retry_ms : max_ms;
+
+    tal_semaphore_wait(client->wakeup, wait_ms);
+    client->retry_ms = wait_ms < max_ms / 2 ? wait_ms * 2 : max_ms;
+}
+
+static void iot_stamp(tuya_iot_client_t *client, tuya_iot_stamp_t stamp)
+{
+    if (client->stamp_flag & (1 << stamp)) {
+        return;
+    }
+    client->stamp_ms[stamp] = (uint32_t)tal_system_get_millisecond();
+    client->stamp_flag |= (1 << stamp);
+}
+
 static int iot_dispatch_event(tuya_iot_client_t *client)
 {
     if (client->config.event_handler) {
@@ -110,18 +142,46 @@ __exit:
     return result;
 }
 
+#define SCHEMA_BIN_KEY_SUFFIX ".bin"
+
+static void schema_bin_key_get(const char *schema_id, char *key, size_t key_len)
+{
+    snprintf(key, key_len, "%s%s", schema_id, SCHEMA_BIN_KEY_SUFFIX);
+}
+
 static dp_schema_t *schema_instance_create(char *devid, char *schema_id)
 {
     dp_schema_t *schema = NULL;
     size_t readlen = 0;
     uint8_t *schema_data = NULL;
+    char bin_key[MAX_LENGTH_SCHEMA_ID + sizeof(SCHEMA_BIN_KEY_SUFFIX)];
+
+    /* Binary cache first, it skips JSON parsing entirely */
+    schema_bin_key_get(schema_id, bin_key, sizeof(bin_key));
+    if (OPRT_OK == tal_kv_get(bin_key, &schema_data, &readlen)) {
+        int rt = dp_schema_create_from_bin(devid, schema_data, readlen, &schema);
+        tal_kv_free(schema_data);
+        schema_data = NULL;
+        if (OPRT_OK == rt) {
+            return schema;
+        }
+        PR_WARN("schema bin invalid:%d", rt);
+        tal_kv_del(bin_key);
+    }
 
     if (OPRT_OK != tal_kv_get((const char *)schema_id, &schema_data, &readlen)) {
         PR_WARN("schema data read failed");
         goto __exit;
     }
 
-    dp_schema_create(devid, (char *)schema_data, &schema);
+    if (OPRT_OK == dp_schema_create(devid, (char *)schema_data, &schema)) {
+        uint8_t *bin = NULL;
+        size_t bin_len = 0;
+        if (OPRT_OK == dp_schema_bin_encode(schema, &bin, &bin_len)) {
+            tal_kv_set(bin_key, bin, bin_len);
+            tal_free(bin);
+        }
+    }
 
 __exit:
     if (schema_data) {
@@ -189,6 +249,9 @@ static int activate_response_parse(atop_base_response_t *response)
     cJSON *schema_obj = cJSON_DetachItemFromObject(result_root, "schema");
     ret = tal_kv_set(schemaId, (const uint8_t *)schema_obj->valuestring, strlen(schema_obj->valuestring));
     cJSON_Delete(schema_obj);
+    char bin_key[MAX_LENGTH_SCHEMA_ID + sizeof(SCHEMA_BIN_KEY_SUFFIX)];
+    schema_bin_key_get(schemaId, bin_key, sizeof(bin_key));
+    tal_kv_del(bin_key);
     if (ret != OPRT_OK) {
         PR_ERR("activate data save error:%d", ret);
         return OPRT_KVS_WR_FAIL;
@@ -494,7 +557,11 @@ static int run_state_mqtt_connect_start(tuya_iot_client_t *client)
 {
     int rt = tuya_mqtt_start(&client->mqctx);
     if (OPRT_OK != rt) {
-        PR_ERR("tuya mqtt start error:%d", rt);
+        PR_ERR("tuya mqtt start error:%d, retry in %d ms", rt, client->mqctx.retry_backoff_ms);
+        /* Link up or an API call ends the back-off early */
+        if (OPRT_COM_ERROR == rt) {
+            tal_semaphore_wait(client->wakeup, client->mqctx.retry_backoff_ms);
+        }
         return rt;
     }
 
@@ -577,6 +644,10 @@ int tuya_iot_init(tuya_iot_client_t *client, const tuya_iot_config_t *config)
     // PR_DEBUG("authkey:%s", client->config.authkey);
 
     tal_semaphore_create_init(&client->token_get.sem, 0, 1);
+    ret = tal_semaphore_create_init(&client->wakeup, 0, 1);
+    if (OPRT_OK != ret) {
+        return ret;
+    }
 
     /* Default storage namespace */
     if (client->config.storage_namespace == NULL) {
@@ -585,6 +656,7 @@ int tuya_iot_init(tuya_iot_client_t *client, const tuya_iot_config_t *config)
     /* Software timer Init */
     tuya_tls_init();
     tuya_register_center_init();
+    tuya_iotdns_cache_init();
     /* Load Tuya cloud endpoint config */
     tuya_endpoint_init();
     /* Try to read the local activation data.
@@ -634,6 +706,7 @@ int tuya_iot_start(tuya_iot_client_t *client)
         return OPRT_COM_ERROR;
     }
     client->nextstate = STATE_START;
+    iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -648,6 +721,7 @@ int tuya_iot_start(tuya_iot_client_t *client)
 int tuya_iot_stop(tuya_iot_client_t *client)
 {
     client->nextstate = STATE_STOP;
+    iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -668,6 +742,7 @@ int tuya_iot_reconnect(tuya_iot_client_t *client)
         return OPRT_COM_ERROR;
     }
     client->nextstate = STATE_MQTT_RECONNECT;
+    iot_wakeup(client);
     return OPRT_OK;
 }
 
@@ -707,6 +782,7 @@ int tuya_iot_reset(tuya_iot_client_t *client)
         client->token_get.result = OPRT_COM_ERROR;
         tal_semaphore_post(client->token_get.sem);
     }
+    iot_wakeup(client);
 
     return ret;
 }
@@ -777,13 +853,30 @@ static OPERATE_RET __tuya_iot_link_type_change_cb(void *data)
     return rt;
 }
 
+static OPERATE_RET __tuya_iot_link_status_change_cb(void *data)
+{
+    netmgr_status_e status = (netmgr_status_e)data;
+
+    tuya_iot_client_t *p_client = tuya_iot_client_get();
+    if (p_client && status == NETMGR_LINK_UP) {
+        /* Retry at once on the new link */
+        p_client->retry_ms = IOT_RETRY_MIN_MS;
+        iot_wakeup(p_client);
+    }
+
+    return OPRT_OK;
+}
+
 /**
  * @brief Yields control to the Tuya IoT client for processing incoming messages
  * and events.
  *
  * This function allows the Tuya IoT client to process any pending messages or
- * events in a non-blocking manner. It should be called periodically to ensure
- * timely processing of incoming data.
+ * events. It should be called periodically to ensure timely processing of
+ * incoming data. While the client waits for the network, the MQTT connection
+ * or a retry, the call blocks on the client wakeup semaphore until link up
+ * or an API call posts it, or until the exponential back-off of the failing
+ * state expires.
  *
  * @param client Pointer to the Tuya IoT client structure.
  * @return Returns 0 on success, or a negative error code on failure.
@@ -795,6 +888,13 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     }
 
     int rt = OPRT_OK;
+    if (client->state != client->nextstate) {
+        /* Posts made for the previous state are stale, the new state checks
+         * its own condition before it blocks */
+        while (OPRT_OK == tal_semaphore_wait(client->wakeup, 0)) {
+        }
+        client->retry_ms = IOT_RETRY_MIN_MS;
+    }
     client->state = client->nextstate;
 
     switch (client->state) {
@@ -805,11 +905,14 @@ int tuya_iot_yield(tuya_iot_client_t *client)
         break;
 
     case STATE_IDLE:
-        tal_system_sleep(500);
+        /* tuya_iot_start() wakes the loop */
+        tal_semaphore_wait_forever(client->wakeup);
         break;
 
     case STATE_START:
         PR_DEBUG("STATE_START");
+        client->stamp_flag = 0;
+        iot_stamp(client, TUYA_IOT_STAMP_START);
         if (client->is_activated) {
             client->nextstate = STATE_NETWORK_CHECK;
             client->status = TUYA_STATUS_UNCONNECT_ROUTER;
@@ -819,6 +922,8 @@ int tuya_iot_yield(tuya_iot_client_t *client)
         }
         TUYA_CALL_ERR_LOG(
             tal_event_subscribe(EVENT_LINK_TYPE_CHG, "iot", __tuya_iot_link_type_change_cb, SUBSCRIBE_TYPE_NORMAL));
+        TUYA_CALL_ERR_LOG(
+            tal_event_subscribe(EVENT_LINK_STATUS_CHG, "iot", __tuya_iot_link_status_change_cb, SUBSCRIBE_TYPE_NORMAL));
         break;
 
     case STATE_DATA_LOAD:
@@ -852,6 +957,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             break;
         }
 
+        iot_stamp(client, TUYA_IOT_STAMP_TOKEN);
         PR_INFO("token: %s", client->binding->token);
         PR_INFO("region: %s", client->binding->region);
         PR_INFO("regist_key: %s", client->binding->regist_key);
@@ -873,8 +979,9 @@ int tuya_iot_yield(tuya_iot_client_t *client)
         if (client->config.network_check && client->config.network_check()) {
             client->status = TUYA_STATUS_WIFI_CONNECTED;
             client->nextstate = client->is_activated ? STATE_ENDPOINT_GET : STATE_ENDPOINT_UPDATE;
+            iot_stamp(client, TUYA_IOT_STAMP_NETWORK);
         } else {
-            tal_system_sleep(1000);
+            iot_retry_wait(client, IOT_NETWORK_POLL_MAX_MS);
         }
         break;
 
@@ -886,15 +993,18 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             client->nextstate = STATE_ENDPOINT_UPDATE;
         } else {
             client->nextstate = STATE_STARTUP_UPDATE;
+            iot_stamp(client, TUYA_IOT_STAMP_ENDPOINT);
         }
         break;
 
     case STATE_ENDPOINT_UPDATE:
         rt = tuya_endpoint_update();
         if (rt != OPRT_OK) {
-            tal_system_sleep(1000);
+            PR_WARN("tuya endpoint update error %d, retry in %d ms", rt, client->retry_ms);
+            iot_retry_wait(client, IOT_RETRY_MAX_MS);
             break;
         }
+        iot_stamp(client, TUYA_IOT_STAMP_ENDPOINT);
         if (client->is_activated) {
             rt = tuya_endpoint_cert_set((tuya_endpoint_t *)tuya_endpoint_get());
             rt |= tuya_endpoint_domain_set((tuya_endpoint_t *)tuya_endpoint_get());
@@ -910,7 +1020,8 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     case STATE_ACTIVATING:
         rt = client_activate_process(client, client->binding->token);
         if (rt != OPRT_OK) {
-            tal_system_sleep(1000);
+            PR_WARN("activate error %d, retry in %d ms", rt, client->retry_ms);
+            iot_retry_wait(client, IOT_RETRY_MAX_MS);
             break;
         }
 
@@ -932,6 +1043,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             PR_WARN("tuya endpoint set error %d; need restart update", rt);
         }
         client->is_activated = true;
+        iot_stamp(client, TUYA_IOT_STAMP_ACTIVATED);
 
         /* Retry to load activate */
         client->nextstate = STATE_STARTUP_UPDATE;
@@ -953,6 +1065,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
         break;
 
     case STATE_MQTT_CONNECT_START:
+        iot_stamp(client, TUYA_IOT_STAMP_MQTT_START);
         if (run_state_mqtt_connect_start(client) == OPRT_OK) {
             client->nextstate = STATE_MQTT_CONNECTING;
         }
@@ -963,6 +1076,15 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             PR_INFO("Tuya MQTT connected.");
             client->status = TUYA_STATUS_MQTT_CONNECTED;
             client->nextstate = STATE_MQTT_YIELD;
+            if (!(client->stamp_flag & (1 << TUYA_IOT_STAMP_MQTT_CONNECTED))) {
+                iot_stamp(client, TUYA_IOT_STAMP_MQTT_CONNECTED);
+                PR_INFO("time to online %d ms",
+                        client->stamp_ms[TUYA_IOT_STAMP_MQTT_CONNECTED] - client->stamp_ms[TUYA_IOT_STAMP_START]);
+            }
+        } else {
+            /* tuya_mqtt_start connects synchronously, only stop or
+             * reconnect move on from here */
+            iot_retry_wait(client, IOT_RETRY_MAX_MS);
         }
         break;
 
@@ -982,7 +1104,7 @@ int tuya_iot_yield(tuya_iot_client_t *client)
             client->status = TUYA_STATUS_WIFI_CONNECTED;
             client->nextstate = STATE_MQTT_CONNECT_START;
         } else {
-            tal_system_sleep(1000);
+            iot_retry_wait(client, IOT_NETWORK_POLL_MAX_MS);
         }
         break;
 
@@ -1009,6 +1131,33 @@ int tuya_iot_yield(tuya_iot_client_t *client)
     return rt;
 }
 
+/**
+ * @brief Gets the time a start-up milestone was reached.
+ *
+ * The milestones are stamped by tuya_iot_yield() the first time they are
+ * reached after the client enters STATE_START, so the difference to
+ * TUYA_IOT_STAMP_START splits the time to online into network, endpoint,
+ * activation and MQTT phases.
+ *
+ * @param client Pointer to the Tuya IoT client structure.
+ * @param stamp The milestone to query.
+ * @param elapsed_ms Elapsed ms from the start to the milestone.
+ * @return OPRT_OK on success, OPRT_NOT_FOUND if the milestone is not reached.
+ */
+int tuya_iot_stamp_get(tuya_iot_client_t *client, tuya_iot_stamp_t stamp, uint32_t *elapsed_ms)
+{
+    if (client == NULL || elapsed_ms == NULL || stamp >= TUYA_IOT_STAMP_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+
+    if (!(client->stamp_flag & (1 << stamp))) {
+        return OPRT_NOT_FOUND;
+    }
+
+    *elapsed_ms = client->stamp_ms[stamp] - client->stamp_ms[TUYA_IOT_STAMP_START];
+    return OPRT_OK;
+}
+
 /**
  * @brief Checks if the Tuya IoT client is activated.
  *
@@ -1045,6 +1194,9 @@ int tuya_iot_activated_data_remove(tuya_iot_client_t *client)
     /* Clean client local data */
     dp_schema_delete(client->activate.devid);
     tal_kv_del((const char *)(client->activate.schemaId));
+    char bin_key[MAX_LENGTH_SCHEMA_ID + sizeof(SCHEMA_BIN_KEY_SUFFIX)];
+    schema_bin_key_get(client->activate.schemaId, bin_key, sizeof(bin_key));
+    tal_kv_del(bin_key);
     tal_kv_del((const char *)(client->config.storage_namespace));
     tuya_endpoint_remove();
     client->is_activated = false;
@@ -217,6 +217,21 @@ typedef struct {
     tuya_token_get_cb_t cb[MAX_TOKEN_GET_NUM];
 } tuya_token_get_t;
 
+/**
+ * @brief Start-up milestones of the client, each one is stamped the first time
+ * it is reached after tuya_iot_start(), see tuya_iot_stamp_get().
+ */
+typedef enum {
+    TUYA_IOT_STAMP_START,          // state machine left idle
+    TUYA_IOT_STAMP_TOKEN,          // binding token received, unactivated device only
+    TUYA_IOT_STAMP_NETWORK,        // network_check passed
+    TUYA_IOT_STAMP_ENDPOINT,       // cloud endpoint ready
+    TUYA_IOT_STAMP_ACTIVATED,      // activation done, unactivated device only
+    TUYA_IOT_STAMP_MQTT_START,     // MQTT connect started
+    TUYA_IOT_STAMP_MQTT_CONNECTED, // MQTT connected, the device is online
+    TUYA_IOT_STAMP_MAX,
+} tuya_iot_stamp_t;
+
 struct tuya_iot_client_handle {
     tuya_iot_config_t config;
     tuya_activated_data_t activate;
@@ -230,6 +245,11 @@ struct tuya_iot_client_handle {
     uint8_t state;
     uint8_t nextstate;
     bool is_activated;
+    /** state machine wakeup, posted on link up and API calls */
+    SEM_HANDLE wakeup;
+    uint32_t retry_ms;
+    uint32_t stamp_flag;
+    uint32_t stamp_ms[TUYA_IOT_STAMP_MAX];
     /** device manage */
     dp_schema_t *schema;
 };
@@ -299,6 +319,16 @@ int tuya_iot_destroy(tuya_iot_client_t *client);
  */
 int tuya_iot_yield(tuya_iot_client_t *client);
 
+/**
+ * @brief Get the time a start-up milestone was reached, counted from tuya_iot_start().
+ *
+ * @param client - The Tuya client context.
+ * @param stamp - The milestone, TUYA_IOT_STAMP_MQTT_CONNECTED gives the time to online.
+ * @param elapsed_ms - Elapsed ms from TUYA_IOT_STAMP_START to the milestone.
+ * @return int - OPRT_OK successful, OPRT_NOT_FOUND if the milestone is not reached yet.
+ */
+int tuya_iot_stamp_get(tuya_iot_client_t *client, tuya_iot_stamp_t stamp, uint32_t *elapsed_ms);
+
 /**
  * @brief Report Tuya data point(DP) services to the cloud.
  *
@@ -97,6 +97,12 @@ typedef struct {
     uint8_t recv_buf[0]; // keep it last !!!
 } lan_mgr_t;
 
+static TAL_METRIC_COUNTER_DEFINE(s_metric_lan_rx, "lan_rx_frames_total", "LAN frames received");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_lan_tx, "lan_tx_frames_total", "LAN frames sent");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_lan_tx_bytes, "lan_tx_bytes_total", "LAN bytes sent");
+static TAL_METRIC_COUNTER_DEFINE(s_metric_lan_tx_err, "lan_tx_errors_total", "LAN frames that failed to send");
+static TAL_METRIC_HISTOGRAM_DEFINE(s_metric_lan_process, "lan_process_ms", "LAN frame decode and handling", 0);
+
 static uint8_t app_key2[APP_KEY_LEN] = {0};
 static uint8_t app_key3[APP_KEY_LEN] = {0};
 
@@ -508,10 +514,15 @@ static int lan_send(lan_session_t *session, uint32_t fr_num, uint32_t fr_type, u
 
     tal_free(send_buf);
     if (op_ret == OPRT_SVC_LAN_SEND_ERR) {
+        tal_metric_inc(&s_metric_lan_tx_err);
         lan_session_fault_set(session);
         PR_ERR("ret:%d send_len:%d errno:%d", ret, send_len, tal_net_get_errno());
     }
     tal_mutex_unlock(s_lan_mgr->mutex);
+    if (op_ret == OPRT_OK) {
+        tal_metric_inc(&s_metric_lan_tx);
+        tal_metric_add(&s_metric_lan_tx_bytes, send_len);
+    }
     return op_ret;
 }
 
@@ -738,6 +749,9 @@ static void lan_protocol_process(lan_mgr_t *lan, lan_session_t *session, lpv35_f
     int op_ret = OPRT_OK;
     uint8_t *out = frame->data;
     uint32_t out_len = frame->data_len;
+    SYS_TIME_T start_ms = tal_system_get_millisecond();
+
+    tal_metric_inc(&s_metric_lan_rx);
 
     PR_DEBUG("Process Data. FD:%d, Num:%d, Type:%d, Len:%d", session->fd, frame->sequence, frame->type,
              frame->data_len);
@@ -887,6 +901,8 @@ static void lan_protocol_process(lan_mgr_t *lan, lan_session_t *session, lpv35_f
         break;
     } break;
     }
+
+    tal_metric_observe(&s_metric_lan_process, (uint32_t)(tal_system_get_millisecond() - start_ms));
 }
 
 static void lan_tcp_client_sock_err(int fd)
@@ -1306,6 +1322,12 @@ int tuya_lan_init(tuya_iot_client_t *iot_client)
 
     lan_app_key_make();
 
+    tal_metric_register(&s_metric_lan_rx);
+    tal_metric_register(&s_metric_lan_tx);
+    tal_metric_register(&s_metric_lan_tx_bytes);
+    tal_metric_register(&s_metric_lan_tx_err);
+    tal_metric_register(&s_metric_lan_process.base);
+
     s_lan_mgr = tal_malloc(sizeof(lan_mgr_t) + s_lan_cfg.bufsize);
     if (NULL == s_lan_mgr) {
         PR_ERR("tal_malloc fail");
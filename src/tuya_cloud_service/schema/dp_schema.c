@@ -18,13 +18,15 @@
 #include "dp_schema.h"
 #include "cJSON.h"
 #include "mix_method.h"
+#include "crc32i.h"
 #include "tal_api.h"
 
 #define MAX_ITEM_LEN 1024
 
 #define MAX_TRANS_TYPE_NUM (DTT_SCT_SCENE + 1)
 
-#define DP_SCHEMA_NUM_MAX 1
+// open addressing slots of the devid index, kept at most half full
+#define DP_SCHEMA_HASH_NUM (2 * DP_SCHEMA_NUM_MAX)
 
 typedef struct {
     // DELAYED_WORK_HANDLE tmm_dp_sync;
@@ -32,10 +34,74 @@ typedef struct {
     MUTEX_HANDLE mutex;
     uint8_t schema_num;
     dp_schema_t *schema_list[DP_SCHEMA_NUM_MAX];
+    /** schema_list[] position + 1 by devid_hash, linear probing, 0 if empty */
+    uint16_t hash_index[DP_SCHEMA_HASH_NUM];
 } dp_schema_mgr_t;
 
 static dp_schema_mgr_t s_dsmgr = {0};
 
+static uint32_t dp_devid_hash(const char *devid)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    while (*devid) {
+        hash ^= (uint8_t)*devid++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Returns the index slot holding devid, or the empty slot ending its probe. */
+static uint32_t dp_schema_hash_slot(const char *devid, uint32_t hash)
+{
+    dp_schema_mgr_t *dsmgr = &s_dsmgr;
+    uint32_t slot = hash % DP_SCHEMA_HASH_NUM;
+
+    while (dsmgr->hash_index[slot]) {
+        dp_schema_t *schema = dsmgr->schema_list[dsmgr->hash_index[slot] - 1];
+        if (hash == schema->devid_hash && 0 == strcmp(devid, schema->devid)) {
+            break;
+        }
+        slot = (slot + 1) % DP_SCHEMA_HASH_NUM;
+    }
+    return slot;
+}
+
+static void dp_schema_hash_insert(uint32_t hash, uint16_t pos)
+{
+    dp_schema_mgr_t *dsmgr = &s_dsmgr;
+    uint32_t slot = hash % DP_SCHEMA_HASH_NUM;
+
+    while (dsmgr->hash_index[slot]) {
+        slot = (slot + 1) % DP_SCHEMA_HASH_NUM;
+    }
+    dsmgr->hash_index[slot] = pos + 1;
+}
+
+/* Empties a slot and shifts back the entries whose probe passed over it. */
+static void dp_schema_hash_remove(uint32_t slot)
+{
+    dp_schema_mgr_t *dsmgr = &s_dsmgr;
+    uint32_t next = slot, home;
+
+    dsmgr->hash_index[slot] = 0;
+    for (;;) {
+        next = (next + 1) % DP_SCHEMA_HASH_NUM;
+        if (0 == dsmgr->hash_index[next]) {
+            return;
+        }
+        home = dsmgr->schema_list[dsmgr->hash_index[next] - 1]->devid_hash % DP_SCHEMA_HASH_NUM;
+        // keep the entry when its home lies cyclically in (slot, next]
+        if ((slot < next) ? (slot < home && home <= next) : (slot < home || home <= next)) {
+            continue;
+        }
+        dsmgr->hash_index[slot] = dsmgr->hash_index[next];
+        dsmgr->hash_index[next] = 0;
+        slot = next;
+    }
+}
+
 static bool dp_snprintf_append(char *buf, size_t buf_len, size_t *offset, const char *fmt, ...)
 {
     if (buf == NULL || offset == NULL || *offset >= buf_len) {
@@ -143,16 +209,11 @@ __err_exit:
  */
 dp_node_t *dp_node_find(dp_schema_t *schema, int id)
 {
-    int i;
-    dp_node_t *dpnode = NULL;
-
-    for (i = 0; i < schema->num; i++) {
-        if (schema->node[i].desc.id == id) {
-            dpnode = &schema->node[i];
-            break;
-        }
+    if (id < 0 || id >= (int)sizeof(schema->index) || 0 == schema->index[id]) {
+        return NULL;
     }
-    return dpnode;
+
+    return &schema->node[schema->index[id] - 1];
 }
 
 /**
@@ -163,22 +224,15 @@ dp_node_t *dp_node_find(dp_schema_t *schema, int id)
  */
 dp_schema_t *dp_schema_find(const char *devid)
 {
-    int i = 0;
-
     PR_TRACE("try to find schema devid %s", devid);
     dp_schema_mgr_t *dsmgr = &s_dsmgr;
-    for (i = 0; i < DP_SCHEMA_NUM_MAX; i++) {
-        if (NULL == dsmgr->schema_list[i]) {
-            continue;
-        }
-        if (0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
-            return dsmgr->schema_list[i];
-        }
-
-        PR_TRACE("find schema devid %s, not match!", dsmgr->schema_list[i]->devid);
+    uint32_t slot = dp_schema_hash_slot(devid, dp_devid_hash(devid));
+    if (0 == dsmgr->hash_index[slot]) {
+        PR_TRACE("find schema devid %s, not match!", devid);
+        return NULL;
     }
 
-    return NULL;
+    return dsmgr->schema_list[dsmgr->hash_index[slot] - 1];
 }
 
 /**
@@ -193,20 +247,12 @@ dp_schema_t *dp_schema_find(const char *devid)
  */
 dp_node_t *dp_node_find_by_devid(char *devid, int id)
 {
-    int i;
-    dp_node_t *dpnode = NULL;
-
     dp_schema_t *schema = dp_schema_find(devid);
     if (NULL == schema) {
         return NULL;
     }
-    for (i = 0; i < schema->num; i++) {
-        if (schema->node[i].desc.id == id) {
-            dpnode = &schema->node[i];
-            break;
-        }
-    }
-    return dpnode;
+
+    return dp_node_find(schema, id);
 }
 
 static __attribute__((unused)) OPERATE_RET dp_obj_equal_resp(dp_schema_t *schema, uint8_t *dpid, uint8_t num,
@@ -680,6 +726,100 @@ static bool dp_rept_update(dp_rept_type_t rept_type, dp_obj_t *dp, dp_node_t *dp
     return (FALSE == is_need_update);
 }
 
+static bool dp_check_bool(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if ((TRUE != dp->value.dp_bool) && (FALSE != dp->value.dp_bool)) {
+        PR_ERR("bool check err,val:%u", dp->value.dp_bool);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static bool dp_check_value(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if (dp->value.dp_value > node->prop.prop_int.max || dp->value.dp_value < node->prop.prop_int.min) {
+        PR_ERR("value check err:%d[%d,%d]", dp->value.dp_value, node->prop.prop_int.min, node->prop.prop_int.max);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static bool dp_check_value_step(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if (!dp_check_value(node, dp)) {
+        return FALSE;
+    }
+    if (((int64_t)dp->value.dp_value - node->prop.prop_int.min) % node->prop.prop_int.step) {
+        PR_ERR("value step err:%d step %d", dp->value.dp_value, node->prop.prop_int.step);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static bool dp_check_str(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if (NULL == dp->value.dp_str || strlen(dp->value.dp_str) > node->prop.prop_str.max_len) {
+        PR_ERR("str check err %s %d", dp->value.dp_str ? dp->value.dp_str : "null", node->prop.prop_str.max_len);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static bool dp_check_enum(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if (dp->value.dp_enum >= node->prop.prop_enum.cnt) {
+        PR_ERR("enum check err:%d %d", dp->value.dp_enum, node->prop.prop_enum.cnt);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static bool dp_check_bitmap(const dp_node_t *node, const dp_obj_t *dp)
+{
+    if (dp->value.dp_bitmap & ~node->prop.prop_bitmap.mask) {
+        PR_ERR("bitmap check fail %u %u", dp->value.dp_bitmap, node->prop.prop_bitmap.max_len);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Selects the node validator and derives its constants, so a report
+ * only pays for the checks its schema actually needs.
+ */
+static void dp_node_check_compile(dp_node_t *node)
+{
+    node->check = NULL;
+    if (T_OBJ != node->desc.type) {
+        return;
+    }
+
+    switch (node->desc.prop_tp) {
+    case PROP_BOOL:
+        node->check = dp_check_bool;
+        break;
+    case PROP_VALUE:
+        node->check = (node->prop.prop_int.step > 1) ? dp_check_value_step : dp_check_value;
+        break;
+    case PROP_STR:
+        node->check = dp_check_str;
+        break;
+    case PROP_ENUM:
+        node->check = dp_check_enum;
+        break;
+    case PROP_BITMAP:
+        if (0 == node->prop.prop_bitmap.max_len || node->prop.prop_bitmap.max_len >= 32) {
+            node->prop.prop_bitmap.mask = 0xFFFFFFFF;
+        } else {
+            node->prop.prop_bitmap.mask = (1u << node->prop.prop_bitmap.max_len) - 1;
+        }
+        node->check = dp_check_bitmap;
+        break;
+    default:
+        break;
+    }
+}
+
 static bool dp_type_check(dp_rept_type_t dp_rept_type, dp_obj_t *dp, dp_node_t *node)
 {
     if ((node->desc.mode == M_WR) ||                                    /* DP is write-only, verification failed */
@@ -692,53 +832,11 @@ static bool dp_type_check(dp_rept_type_t dp_rept_type, dp_obj_t *dp, dp_node_t *
     // Verifying dp validity
     switch (node->desc.type) {
     case T_OBJ: {
-        switch (node->desc.prop_tp) {
-        case PROP_BOOL: {
-            if ((TRUE != dp->value.dp_bool) && (FALSE != dp->value.dp_bool)) {
-                PR_ERR("bool check err,val:%u", dp->value.dp_bool);
-                return FALSE;
-            }
-            break;
-        }
-
-        case PROP_VALUE: {
-            if (dp->value.dp_value > node->prop.prop_int.max || dp->value.dp_value < node->prop.prop_int.min) {
-                PR_ERR("value check err:%d[%d,%d]", dp->value.dp_value, node->prop.prop_int.min,
-                       node->prop.prop_int.max);
-                return FALSE;
-            }
-            break;
-        }
-
-        case PROP_STR: {
-            if (strlen(dp->value.dp_str) > node->prop.prop_str.max_len) {
-                PR_ERR("str check err %s %d", dp->value.dp_str, node->prop.prop_str.max_len);
-                return FALSE;
-            }
-            break;
-        }
-
-        case PROP_ENUM: {
-            if (dp->value.dp_enum >= node->prop.prop_enum.cnt) {
-                PR_ERR("enum check err:%d %d", dp->value.dp_enum, node->prop.prop_enum.cnt);
-                return FALSE;
-            }
-            break;
-        }
-
-        case PROP_BITMAP:
-            if (dp->type != cJSON_Number) {
-                PR_ERR("bitmap check fail %d %d %d", dp->type, dp->value.dp_bitmap, node->prop.prop_bitmap.max_len);
-                return FALSE;
-            }
-            break;
-
-        default: {
+        if (NULL == node->check) {
             PR_ERR("prop_tp err:%d", node->desc.prop_tp);
             return FALSE;
         }
-        }
-        break;
+        return node->check(node, dp);
     }
     case T_RAW:
 
@@ -1290,292 +1388,687 @@ char *dp_obj_dump_all_json(char *devid, int flags)
     return out;
 }
 
+/**
+ * The schema is parsed by a small streaming tokenizer instead of cJSON. It
+ * runs twice over the text: the first pass validates the schema and sizes
+ * the arena, the second one fills it. The schema header, the node array,
+ * the enum pointer tables and the (interned) enum strings all live in that
+ * single allocation.
+ */
 typedef struct {
-    uint16_t start;
-    uint16_t end;
-} dp_node_pos_t;
+    const char *cur;
+    const char *end;
+} dp_json_lex_t;
 
-#define MAX_ITEM_LEN 1024
+typedef struct {
+    const char *str;
+    uint16_t len;
+} dp_json_span_t;
 
-static int dp_node_pos_decode(char *schema_json, dp_node_pos_t pos[], int pos_num)
+typedef struct {
+    /** NULL in the sizing pass */
+    dp_schema_t *schema;
+    /** next free enum pointer slot */
+    char **enum_ptr;
+    char *pool;
+    uint32_t pool_len;
+    /** sizing results */
+    uint16_t node_num;
+    uint32_t enum_num;
+    uint32_t pool_need;
+    const char *json_end;
+    SCHEMA_OTHER_ATTR_S *other_attr;
+} dp_schema_builder_t;
+
+#define DP_SCHEMA_NODE_MAX 254
+#define DP_PROP_TP_INVALID 0xff
+
+static void dp_json_ws(dp_json_lex_t *lex)
 {
-    if (!schema_json) {
-        return 0;
+    while (lex->cur < lex->end &&
+           (*lex->cur == ' ' || *lex->cur == '\t' || *lex->cur == '\r' || *lex->cur == '\n')) {
+        lex->cur++;
     }
+}
 
-    int i = 0, brace = 0, n = 0;
+static bool dp_json_peek(dp_json_lex_t *lex, char c)
+{
+    dp_json_ws(lex);
+    return (lex->cur < lex->end) && (*lex->cur == c);
+}
 
-    while (*schema_json) {
-        if (*schema_json == '{') {
-            if (brace == 0) {
-                pos[n].start = i;
-            }
-            brace++;
-        } else if (*schema_json == '}') {
-            brace--;
-            if (brace == 0) {
-                pos[n++].end = i;
+static bool dp_json_expect(dp_json_lex_t *lex, char c)
+{
+    if (!dp_json_peek(lex, c)) {
+        return FALSE;
+    }
+    lex->cur++;
+    return TRUE;
+}
+
+/* Returns the raw string body, escapes are left in place. */
+static bool dp_json_string(dp_json_lex_t *lex, dp_json_span_t *span)
+{
+    if (!dp_json_expect(lex, '"')) {
+        return FALSE;
+    }
+
+    span->str = lex->cur;
+    while (lex->cur < lex->end && *lex->cur != '"') {
+        if (*lex->cur == '\\') {
+            lex->cur++;
+        }
+        lex->cur++;
+    }
+    if (lex->cur >= lex->end) {
+        return FALSE;
+    }
+    span->len = lex->cur - span->str;
+    lex->cur++;
+
+    return TRUE;
+}
+
+static bool dp_json_number(dp_json_lex_t *lex, int *value)
+{
+    int sign = 1;
+    int64_t v = 0;
+
+    dp_json_ws(lex);
+    if (lex->cur < lex->end && *lex->cur == '-') {
+        sign = -1;
+        lex->cur++;
+    }
+    if (lex->cur >= lex->end || *lex->cur < '0' || *lex->cur > '9') {
+        return FALSE;
+    }
+    while (lex->cur < lex->end && *lex->cur >= '0' && *lex->cur <= '9') {
+        v = v * 10 + (*lex->cur++ - '0');
+    }
+    // fraction and exponent are truncated, like cJSON valueint
+    while (lex->cur < lex->end && (*lex->cur == '.' || *lex->cur == 'e' || *lex->cur == 'E' || *lex->cur == '+' ||
+                                   *lex->cur == '-' || (*lex->cur >= '0' && *lex->cur <= '9'))) {
+        lex->cur++;
+    }
+    *value = (int)(sign * v);
+
+    return TRUE;
+}
+
+static bool dp_json_skip(dp_json_lex_t *lex)
+{
+    dp_json_span_t span;
+    int depth = 0;
+
+    dp_json_ws(lex);
+    if (lex->cur >= lex->end) {
+        return FALSE;
+    }
+    if (*lex->cur == '"') {
+        return dp_json_string(lex, &span);
+    }
+    if (*lex->cur != '{' && *lex->cur != '[') {
+        // number, true, false, null
+        while (lex->cur < lex->end && *lex->cur != ',' && *lex->cur != '}' && *lex->cur != ']') {
+            lex->cur++;
+        }
+        return TRUE;
+    }
+
+    do {
+        if (*lex->cur == '"') {
+            if (!dp_json_string(lex, &span)) {
+                return FALSE;
             }
+            continue;
+        }
+        if (*lex->cur == '{' || *lex->cur == '[') {
+            depth++;
+        } else if (*lex->cur == '}' || *lex->cur == ']') {
+            depth--;
+        }
+        lex->cur++;
+    } while (depth > 0 && lex->cur < lex->end);
+
+    return (0 == depth);
+}
+
+static bool dp_json_span_eq(const dp_json_span_t *span, const char *str)
+{
+    return (strlen(str) == span->len) && (0 == memcmp(span->str, str, span->len));
+}
+
+/* Reads the 4 hex digits of a \u escape at str, -1 if they are not hex. */
+static int dp_json_hex4(const char *str, uint16_t left)
+{
+    int cp = 0;
+
+    if (left < 4) {
+        return -1;
+    }
+    for (int k = 0; k < 4; k++) {
+        char h = str[k];
+        if (h >= '0' && h <= '9') {
+            cp = (cp << 4) | (h - '0');
+        } else if (h >= 'a' && h <= 'f') {
+            cp = (cp << 4) | (h - 'a' + 10);
+        } else if (h >= 'A' && h <= 'F') {
+            cp = (cp << 4) | (h - 'A' + 10);
+        } else {
+            return -1;
+        }
+    }
+    return cp;
+}
+
+/*
+ * Decodes the \u escape after "\u" at span->str[*i] to UTF-8 in dst, a
+ * surrogate pair taking the following \u escape too, and leaves *i on the
+ * last digit read. Returns the bytes written, never more than the escape
+ * text, so the pool sized from the raw span holds the result. An escape
+ * that cJSON rejects, bad digits or a lone surrogate, becomes '?'.
+ */
+static uint16_t dp_json_utf8(const dp_json_span_t *span, uint16_t *i, char *dst)
+{
+    int cp = dp_json_hex4(&span->str[*i + 1], span->len - *i - 1);
+
+    if (cp < 0) {
+        dst[0] = '?';
+        return 1;
+    }
+    *i += 4;
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        dst[0] = '?';
+        return 1;
+    }
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        int low = -1;
+        if (*i + 2 < span->len && span->str[*i + 1] == '\\' && span->str[*i + 2] == 'u') {
+            low = dp_json_hex4(&span->str[*i + 3], span->len - *i - 3);
+        }
+        if (low < 0xDC00 || low > 0xDFFF) {
+            dst[0] = '?';
+            return 1;
+        }
+        *i += 6;
+        cp = 0x10000 + (((cp & 0x3FF) << 10) | (low & 0x3FF));
+    }
+
+    if (cp < 0x80) {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
 
-            if (n >= pos_num) {
-                return n;
+/* Unescapes span into dst, returns the length without terminator. */
+static uint16_t dp_json_unescape(const dp_json_span_t *span, char *dst)
+{
+    uint16_t i, n = 0;
+
+    for (i = 0; i < span->len; i++) {
+        char c = span->str[i];
+        if (c == '\\' && i + 1 < span->len) {
+            c = span->str[++i];
+            switch (c) {
+            case 'n':
+                c = '\n';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'u':
+                n += dp_json_utf8(span, &i, &dst[n]);
+                continue;
+            default:
+                break;
             }
         }
-        i++;
-        schema_json++;
+        dst[n++] = c;
     }
+    dst[n] = '\0';
 
     return n;
 }
 
-static OPERATE_RET dp_node_parse(char *schema_json, dp_node_pos_t *nodepos, uint16_t nodenum, dp_node_t *dpnode,
-                                 SCHEMA_OTHER_ATTR_S *other_attr)
+static char *dp_schema_intern(dp_schema_builder_t *builder, const dp_json_span_t *span)
 {
-    OPERATE_RET op_ret = OPRT_OK;
-    dp_desc_t *dp_desc;
-    dp_prop_vaule_t *prop;
-
-    cJSON *cjson = NULL;
-    cJSON *item = NULL;
-    char *pBuf = NULL;
+    char *dst = builder->pool + builder->pool_len;
+    uint16_t len = dp_json_unescape(span, dst);
+    char *str = builder->pool;
 
-    pBuf = (char *)tal_malloc(MAX_ITEM_LEN);
-    if (NULL == pBuf) {
-        PR_ERR("malloc fail");
-        op_ret = OPRT_COM_ERROR;
-        goto __exit;
+    // reuse an identical string already in the pool
+    while (str < dst) {
+        size_t str_len = strlen(str);
+        if (str_len == len && 0 == memcmp(str, dst, len)) {
+            return str;
+        }
+        str += str_len + 1;
     }
+    builder->pool_len += len + 1;
 
-    int i = 0;
+    return dst;
+}
 
-    for (i = 0; i < nodenum; i++) {
-        dp_desc = &(dpnode[i].desc);
-        prop = &(dpnode[i].prop);
+typedef struct {
+    dp_prop_tp_t prop_tp;
+    bool has_type;
+    bool has_max;
+    bool has_min;
+    bool has_maxlen;
+    int max;
+    int min;
+    int step;
+    int scale;
+    int maxlen;
+    const char *range;
+} dp_prop_scan_t;
+
+/* Reads a number, ids and limits are sometimes sent as strings. */
+static bool dp_json_int(dp_json_lex_t *lex, int *value)
+{
+    dp_json_span_t span;
 
-        memset(pBuf, 0, MAX_ITEM_LEN);
-        memcpy(pBuf, schema_json + nodepos[i].start, nodepos[i].end - nodepos[i].start + 1);
-        cjson = cJSON_Parse(pBuf);
-        if (NULL == cjson) {
-            PR_ERR("cjson NULL:%s", pBuf);
-            op_ret = OPRT_CJSON_PARSE_ERR;
-            goto __exit;
+    if (dp_json_peek(lex, '"')) {
+        if (!dp_json_string(lex, &span)) {
+            return FALSE;
         }
-        item = cJSON_GetObjectItem(cjson, "id"); // id
-        if (NULL == item) {
-            PR_ERR("get id null");
-            op_ret = OPRT_CJSON_GET_ERR;
-            goto __exit;
+        dp_json_lex_t sub = {.cur = span.str, .end = span.str + span.len};
+        if (!dp_json_number(&sub, value)) {
+            *value = 0;
         }
-        if (item->type == cJSON_String) {
-            dp_desc->id = atoi(item->valuestring);
-        } else {
-            dp_desc->id = item->valueint;
+        return TRUE;
+    }
+    if (!dp_json_number(lex, value)) {
+        // true/false/null etc.
+        *value = 0;
+        return dp_json_skip(lex);
+    }
+    return TRUE;
+}
+
+/* Iterates "key": value pairs, the callback must consume the value. */
+typedef OPERATE_RET (*dp_json_member_cb_t)(dp_json_lex_t *lex, const dp_json_span_t *key, void *ctx);
+
+static OPERATE_RET dp_json_object(dp_json_lex_t *lex, dp_json_member_cb_t member_cb, void *ctx)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_json_span_t key;
+
+    if (!dp_json_expect(lex, '{')) {
+        return OPRT_CJSON_PARSE_ERR;
+    }
+    if (dp_json_expect(lex, '}')) {
+        return OPRT_OK;
+    }
+    do {
+        if (!dp_json_string(lex, &key) || !dp_json_expect(lex, ':')) {
+            return OPRT_CJSON_PARSE_ERR;
         }
-        //! mode
-        item = cJSON_GetObjectItem(cjson, "mode");
-        if (NULL == item) {
-            PR_ERR("get mode null");
-            op_ret = OPRT_CJSON_GET_ERR;
-            goto __exit;
+        rt = member_cb(lex, &key, ctx);
+        if (OPRT_OK != rt) {
+            return rt;
         }
-        if (!strcmp(item->valuestring, "rw")) {
-            dp_desc->mode = M_RW;
-        } else if (!strcmp(item->valuestring, "ro")) {
-            dp_desc->mode = M_RO;
+    } while (dp_json_expect(lex, ','));
+
+    return dp_json_expect(lex, '}') ? OPRT_OK : OPRT_CJSON_PARSE_ERR;
+}
+
+static OPERATE_RET dp_prop_member(dp_json_lex_t *lex, const dp_json_span_t *key, void *ctx)
+{
+    dp_prop_scan_t *scan = (dp_prop_scan_t *)ctx;
+    dp_json_span_t val;
+
+    if (dp_json_span_eq(key, "type")) {
+        if (!dp_json_string(lex, &val)) {
+            return OPRT_CJSON_GET_ERR;
+        }
+        scan->has_type = TRUE;
+        if (dp_json_span_eq(&val, "bool")) {
+            scan->prop_tp = PROP_BOOL;
+        } else if (dp_json_span_eq(&val, "value")) {
+            scan->prop_tp = PROP_VALUE;
+        } else if (dp_json_span_eq(&val, "string")) {
+            scan->prop_tp = PROP_STR;
+        } else if (dp_json_span_eq(&val, "enum")) {
+            scan->prop_tp = PROP_ENUM;
+        } else if (dp_json_span_eq(&val, "bitmap")) {
+            scan->prop_tp = PROP_BITMAP;
         } else {
-            dp_desc->mode = M_WR;
+            // only an error for obj dp, checked once the node is complete
+            scan->prop_tp = DP_PROP_TP_INVALID;
         }
-        //! passive
-        item = cJSON_GetObjectItem(cjson, "passive");
-        if (item == NULL) {
-            dp_desc->passive = PSV_FALSE;
+        return OPRT_OK;
+    }
+
+    bool ok;
+    if (dp_json_span_eq(key, "max")) {
+        ok = scan->has_max = dp_json_int(lex, &scan->max);
+    } else if (dp_json_span_eq(key, "min")) {
+        ok = scan->has_min = dp_json_int(lex, &scan->min);
+    } else if (dp_json_span_eq(key, "step")) {
+        ok = dp_json_int(lex, &scan->step);
+    } else if (dp_json_span_eq(key, "scale")) {
+        ok = dp_json_int(lex, &scan->scale);
+    } else if (dp_json_span_eq(key, "maxlen")) {
+        ok = scan->has_maxlen = dp_json_int(lex, &scan->maxlen);
+    } else if (dp_json_span_eq(key, "range")) {
+        scan->range = dp_json_peek(lex, '[') ? lex->cur : NULL;
+        ok = dp_json_skip(lex);
+    } else {
+        ok = dp_json_skip(lex);
+    }
+
+    return ok ? OPRT_OK : OPRT_CJSON_PARSE_ERR;
+}
+
+typedef struct {
+    dp_schema_builder_t *builder;
+    dp_desc_t desc;
+    bool has_id;
+    bool has_mode;
+    bool has_prop;
+    dp_prop_scan_t prop;
+} dp_node_scan_t;
+
+static OPERATE_RET dp_node_member(dp_json_lex_t *lex, const dp_json_span_t *key, void *ctx)
+{
+    dp_node_scan_t *scan = (dp_node_scan_t *)ctx;
+    dp_json_span_t val;
+    int num = 0;
+
+    if (dp_json_span_eq(key, "id")) {
+        if (!dp_json_int(lex, &num)) {
+            return OPRT_CJSON_PARSE_ERR;
+        }
+        scan->desc.id = num;
+        scan->has_id = TRUE;
+    } else if (dp_json_span_eq(key, "mode")) {
+        if (!dp_json_string(lex, &val)) {
+            return OPRT_CJSON_GET_ERR;
+        }
+        scan->has_mode = TRUE;
+        if (dp_json_span_eq(&val, "rw")) {
+            scan->desc.mode = M_RW;
+        } else if (dp_json_span_eq(&val, "ro")) {
+            scan->desc.mode = M_RO;
         } else {
-            other_attr->preprocess = TRUE;
-            // passive processing is disabled first. The default value is false
-            dp_desc->passive = PSV_FALSE;
-        }
-        //! trigger
-        item = cJSON_GetObjectItem(cjson, "trigger");
-        if (NULL == item) {
-            dp_desc->trig = TRIG_PULSE;
+            scan->desc.mode = M_WR;
+        }
+    } else if (dp_json_span_eq(key, "passive")) {
+        scan->builder->other_attr->preprocess = TRUE;
+        // passive processing is disabled first. The default value is false
+        scan->desc.passive = PSV_FALSE;
+        return dp_json_skip(lex) ? OPRT_OK : OPRT_CJSON_PARSE_ERR;
+    } else if (dp_json_span_eq(key, "trigger")) {
+        if (!dp_json_string(lex, &val)) {
+            return OPRT_CJSON_GET_ERR;
+        }
+        scan->desc.trig = dp_json_span_eq(&val, "pulse") ? TRIG_PULSE : TRIG_DIRECT;
+    } else if (dp_json_span_eq(key, "route")) {
+        if (!dp_json_int(lex, &num)) {
+            return OPRT_CJSON_PARSE_ERR;
+        }
+        scan->desc.route_t = (num == 2) ? ROUTE_FORCE_BT : ((num == 1) ? ROUTE_BLE_FIRST : ROUTE_DEFAULT);
+    } else if (dp_json_span_eq(key, "stat")) {
+        if (!dp_json_string(lex, &val)) {
+            return OPRT_CJSON_GET_ERR;
+        }
+        scan->desc.stat = dp_json_span_eq(&val, "total") ? DST_TOTAL : DST_INC;
+    } else if (dp_json_span_eq(key, "type")) {
+        if (!dp_json_string(lex, &val)) {
+            return OPRT_CJSON_GET_ERR;
+        }
+        if (dp_json_span_eq(&val, "obj")) {
+            scan->desc.type = T_OBJ;
+        } else if (dp_json_span_eq(&val, "raw")) {
+            scan->desc.type = T_RAW;
         } else {
-            if (!strcmp(item->valuestring, "pulse")) {
-                dp_desc->trig = TRIG_PULSE;
-            } else {
-                dp_desc->trig = TRIG_DIRECT;
-            }
+            scan->desc.type = T_FILE;
         }
-        // route
-        item = cJSON_GetObjectItem(cjson, "route");
-        if (NULL == item) {
-            dp_desc->route_t = ROUTE_DEFAULT;
-        } else {
-            if (item->valueint == 2) {
-                dp_desc->route_t = ROUTE_FORCE_BT;
-            }
+    } else if (dp_json_span_eq(key, "property")) {
+        scan->has_prop = TRUE;
+        memset(&scan->prop, 0, sizeof(dp_prop_scan_t));
+        scan->prop.step = 1;
+        return dp_json_object(lex, dp_prop_member, &scan->prop);
+    } else {
+        return dp_json_skip(lex) ? OPRT_OK : OPRT_CJSON_PARSE_ERR;
+    }
 
-            else if (item->valueint == 1) {
-                dp_desc->route_t = ROUTE_BLE_FIRST;
-            } else {
-                dp_desc->route_t = ROUTE_DEFAULT;
-            }
+    return OPRT_OK;
+}
+
+static OPERATE_RET dp_node_enum_build(dp_schema_builder_t *builder, const dp_prop_scan_t *prop, dp_node_t *dpnode)
+{
+    dp_json_lex_t lex = {.cur = prop->range, .end = builder->json_end};
+    dp_json_span_t span;
+    int cnt = 0;
+
+    if (NULL == prop->range) {
+        PR_ERR("get range null");
+        return OPRT_CJSON_GET_ERR;
+    }
+    dp_json_expect(&lex, '[');
+    if (dp_json_expect(&lex, ']')) {
+        PR_ERR("get array size null");
+        return OPRT_CJSON_GET_ERR;
+    }
+    if (dpnode) {
+        dpnode->prop.prop_enum.pp_enum = builder->enum_ptr;
+    }
+    do {
+        if (!dp_json_string(&lex, &span)) {
+            PR_ERR("get array null");
+            return OPRT_CJSON_GET_ERR;
         }
-        // stat //todo
-        item = cJSON_GetObjectItem(cjson, "stat");
-        if (NULL == item) {
-            dp_desc->stat = DST_NONE;
+        if (dpnode) {
+            dpnode->prop.prop_enum.pp_enum[cnt] = dp_schema_intern(builder, &span);
         } else {
-            if (!strcmp(item->valuestring, "total")) {
-                dp_desc->stat = DST_TOTAL;
-            } else {
-                dp_desc->stat = DST_INC;
-            }
+            builder->pool_need += span.len + 1;
         }
-        // type
-        item = cJSON_GetObjectItem(cjson, "type");
-        if (NULL == item) {
-            dp_desc->type = T_OBJ;
-        } else {
-            if (!strcmp(item->valuestring, "obj")) {
-                dp_desc->type = T_OBJ;
-            } else {
-                if (!strcmp(item->valuestring, "raw")) {
-                    dp_desc->type = T_RAW;
-                } else {
-                    dp_desc->type = T_FILE;
-                }
-                cJSON_Delete(cjson);
-                continue;
-            }
-        }
-        // property
-        item = cJSON_GetObjectItem(cjson, "property");
-        if (NULL == item) {
+        cnt++;
+    } while (dp_json_expect(&lex, ','));
+    if (!dp_json_expect(&lex, ']')) {
+        return OPRT_CJSON_PARSE_ERR;
+    }
+
+    if (dpnode) {
+        dpnode->prop.prop_enum.cnt = cnt;
+        builder->enum_ptr += cnt;
+    } else {
+        builder->enum_num += cnt;
+    }
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET dp_node_build(dp_schema_builder_t *builder, dp_json_lex_t *lex)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_node_scan_t scan;
+    dp_node_t *dpnode = NULL;
+
+    memset(&scan, 0, sizeof(scan));
+    scan.builder = builder;
+    scan.desc.trig = TRIG_PULSE;
+    scan.desc.type = T_OBJ;
+
+    rt = dp_json_object(lex, dp_node_member, &scan);
+    if (OPRT_OK != rt) {
+        PR_ERR("dp node parse err:%d", rt);
+        return rt;
+    }
+    if (!scan.has_id || !scan.has_mode) {
+        PR_ERR("get %s null", scan.has_id ? "mode" : "id");
+        return OPRT_CJSON_GET_ERR;
+    }
+    if (builder->node_num >= DP_SCHEMA_NODE_MAX) {
+        return OPRT_SVC_DEVOS_DEV_DP_CNT_INVALID;
+    }
+
+    if (builder->schema) {
+        dpnode = &builder->schema->node[builder->node_num];
+        dpnode->desc = scan.desc;
+    }
+    builder->node_num++;
+
+    if (T_OBJ != scan.desc.type) {
+        return OPRT_OK;
+    }
+    if (!scan.has_prop || !scan.prop.has_type) {
+        PR_ERR("get property null");
+        return OPRT_CJSON_GET_ERR;
+    }
+
+    dp_prop_scan_t *prop = &scan.prop;
+    switch (prop->prop_tp) {
+    case PROP_VALUE:
+        if (!prop->has_max || !prop->has_min) {
             PR_ERR("get property null");
-            op_ret = OPRT_CJSON_GET_ERR;
-            goto __exit;
+            return OPRT_CJSON_GET_ERR;
         }
-        cJSON *child;
-        child = cJSON_GetObjectItem(item, "type");
-        if (NULL == child) {
-            PR_ERR("get type null");
-            op_ret = OPRT_CJSON_GET_ERR;
-            goto __exit;
+        if (dpnode) {
+            dpnode->prop.prop_int.max = prop->max;
+            dpnode->prop.prop_int.min = prop->min;
+            dpnode->prop.prop_int.step = prop->step;
+            dpnode->prop.prop_int.scale = prop->scale;
         }
-        if (!strcmp(child->valuestring, "bool")) {
-            dp_desc->prop_tp = PROP_BOOL;
-        } else if (!strcmp(child->valuestring, "value")) {
-            dp_desc->prop_tp = PROP_VALUE;
-            char *str[] = {"max", "min", "scale"};
-            int i;
-            for (i = 0; i < CNTSOF(str); i++) {
-                child = cJSON_GetObjectItem(item, str[i]);
-                if (NULL == child && (i != CNTSOF(str) - 1)) {
-                    PR_ERR("get property null");
-                    op_ret = OPRT_CJSON_GET_ERR;
-                    goto __exit;
-                } else if (NULL == child && (i == CNTSOF(str) - 1)) {
-                    prop->prop_int.scale = 0;
-                } else {
-                    switch (i) {
-                    case 0:
-                        prop->prop_int.max = child->valueint;
-                        break;
-                    case 1:
-                        prop->prop_int.min = child->valueint;
-                        break;
-                    case 2:
-                        prop->prop_int.scale = child->valueint;
-                        break;
-                    }
-                }
-            }
-        } else if (!strcmp(child->valuestring, "string")) {
-            dp_desc->prop_tp = PROP_STR;
-            child = cJSON_GetObjectItem(item, "maxlen");
-            if (NULL == child) {
-                PR_ERR("get maxlen null");
-                op_ret = OPRT_CJSON_GET_ERR;
-                goto __exit;
-            }
-            prop->prop_str.max_len = child->valueint;
-            prop->prop_str.value = NULL;
-            prop->prop_str.cur_len = 0;
-            op_ret = tal_mutex_create_init(&prop->prop_str.dp_str_mutex);
-            if (OPRT_OK != op_ret) {
-                PR_ERR("mutex init fail:%d", op_ret);
-                op_ret = OPRT_CR_MUTEX_ERR;
-                goto __exit;
-            }
-        } else if (!strcmp(child->valuestring, "enum")) {
-            dp_desc->prop_tp = PROP_ENUM;
-            child = cJSON_GetObjectItem(item, "range");
-            if (NULL == child) {
-                PR_ERR("get range null");
-                op_ret = OPRT_CJSON_GET_ERR;
-                goto __exit;
-            }
-            int i, num;
-            num = cJSON_GetArraySize(child);
-            if (num == 0) {
-                PR_ERR("get array size null");
-                op_ret = OPRT_CJSON_GET_ERR;
-                goto __exit;
-            }
-            prop->prop_enum.pp_enum = tal_malloc(num * sizeof(char *));
-            if (NULL == prop->prop_enum.pp_enum) {
-                PR_ERR("malloc fail");
-                op_ret = OPRT_MALLOC_FAILED;
-                goto __exit;
-            }
-            prop->prop_enum.cnt = num;
-            for (i = 0; i < num; i++) {
-                cJSON *c_child = cJSON_GetArrayItem(child, i);
-                if (NULL == c_child) {
-                    PR_ERR("get array null");
-                    op_ret = OPRT_CJSON_GET_ERR;
-                    goto __exit;
-                }
-                prop->prop_enum.pp_enum[i] = mm_strdup(c_child->valuestring);
-                if (NULL == prop->prop_enum.pp_enum[i]) {
-                    PR_ERR("malloc fail");
-                    op_ret = OPRT_MALLOC_FAILED;
-                    goto __exit;
-                }
-            }
-        } else if (!strcmp(child->valuestring, "bitmap")) {
-            dp_desc->prop_tp = PROP_BITMAP;
-            child = cJSON_GetObjectItem(item, "maxlen");
-            if (NULL == child) {
-                PR_ERR("get maxlen null");
-                op_ret = OPRT_CJSON_GET_ERR;
-                goto __exit;
-            }
+        break;
+    case PROP_STR:
+    case PROP_BITMAP:
+        if (!prop->has_maxlen) {
+            PR_ERR("get maxlen null");
+            return OPRT_CJSON_GET_ERR;
+        }
+        if (dpnode && PROP_STR == prop->prop_tp) {
+            dpnode->prop.prop_str.max_len = prop->maxlen;
+        } else if (dpnode) {
+            dpnode->prop.prop_bitmap.max_len = prop->maxlen;
+        }
+        break;
+    case PROP_ENUM:
+        rt = dp_node_enum_build(builder, prop, dpnode);
+        break;
+    case PROP_BOOL:
+        break;
+    default:
+        return OPRT_SVC_DEVOS_SCMA_INVALID;
+    }
+    if (dpnode) {
+        dpnode->desc.prop_tp = prop->prop_tp;
+    }
 
-            prop->prop_bitmap.max_len = child->valueint;
-        } else {
-            op_ret = OPRT_SVC_DEVOS_SCMA_INVALID;
-            goto __exit;
+    return rt;
+}
+
+static OPERATE_RET dp_schema_build(dp_schema_builder_t *builder, const char *schema_json)
+{
+    OPERATE_RET rt = OPRT_OK;
+    dp_json_lex_t lex = {.cur = schema_json, .end = builder->json_end};
+
+    builder->node_num = 0;
+    if (!dp_json_expect(&lex, '[')) {
+        return OPRT_CJSON_PARSE_ERR;
+    }
+    if (dp_json_expect(&lex, ']')) {
+        return OPRT_SVC_DEVOS_DEV_DP_CNT_INVALID;
+    }
+    do {
+        rt = dp_node_build(builder, &lex);
+        if (OPRT_OK != rt) {
+            return rt;
         }
+    } while (dp_json_expect(&lex, ','));
 
-        cJSON_Delete(cjson);
-        cjson = NULL;
+    return dp_json_expect(&lex, ']') ? OPRT_OK : OPRT_CJSON_PARSE_ERR;
+}
+
+static void dp_schema_free(dp_schema_t *dp_schema)
+{
+    for (int i = 0; i < dp_schema->num; i++) {
+        dp_node_t *dpnode = &dp_schema->node[i];
+        if (T_OBJ != dpnode->desc.type || PROP_STR != dpnode->desc.prop_tp) {
+            continue;
+        }
+        if (dpnode->prop.prop_str.dp_str_mutex) {
+            tal_mutex_release(dpnode->prop.prop_str.dp_str_mutex);
+        }
+        if (dpnode->prop.prop_str.value) {
+            tal_free(dpnode->prop.prop_str.value);
+        }
+    }
+    if (dp_schema->mutex) {
+        tal_mutex_release(dp_schema->mutex);
     }
+    tal_free(dp_schema);
+}
 
-    tal_free(pBuf);
+/* Creates the runtime parts of a filled arena and publishes the schema. */
+static OPERATE_RET dp_schema_setup(dp_schema_t *dp_schema, char *devid, dp_schema_t **dp_schema_out)
+{
+    OPERATE_RET op_ret = OPRT_OK;
 
-    return OPRT_OK;
+    op_ret = tal_mutex_create_init(&(dp_schema->mutex));
+    if (OPRT_OK != op_ret) {
+        PR_ERR("mutex create fail:%d", op_ret);
+        return op_ret;
+    }
 
-__exit:
-    if (pBuf) {
-        tal_free(pBuf);
+    memset(dp_schema->index, 0, sizeof(dp_schema->index));
+    for (int i = 0; i < dp_schema->num; i++) {
+        dp_node_t *dpnode = &dp_schema->node[i];
+        if (0 == dp_schema->index[dpnode->desc.id]) {
+            dp_schema->index[dpnode->desc.id] = i + 1;
+        }
+        if (T_OBJ == dpnode->desc.type && PROP_STR == dpnode->desc.prop_tp) {
+            op_ret = tal_mutex_create_init(&dpnode->prop.prop_str.dp_str_mutex);
+            if (OPRT_OK != op_ret) {
+                PR_ERR("mutex init fail:%d", op_ret);
+                return OPRT_CR_MUTEX_ERR;
+            }
+        }
+        dp_node_check_compile(dpnode);
     }
 
-    if (cjson) {
-        cJSON_Delete(cjson);
+    strncpy(dp_schema->devid, devid, DEV_ID_LEN);
+    dp_schema->devid_hash = dp_devid_hash(dp_schema->devid);
+    if (dp_schema_out) {
+        *dp_schema_out = dp_schema;
+    }
+    for (int i = 0; i < DP_SCHEMA_NUM_MAX; i++) {
+        if (NULL == s_dsmgr.schema_list[i]) {
+            s_dsmgr.schema_list[i] = dp_schema;
+            s_dsmgr.schema_num++;
+            dp_schema_hash_insert(dp_schema->devid_hash, i);
+            break;
+        }
     }
 
-    return op_ret;
+    return OPRT_OK;
 }
 
 /**
@@ -1595,64 +2088,240 @@ __exit:
 int dp_schema_create(char *devid, char *schema_json, dp_schema_t **dp_schema_out)
 {
     OPERATE_RET op_ret = OPRT_OK;
-    dp_node_pos_t *nodepos = NULL;
-    int nodenum;
+    SCHEMA_OTHER_ATTR_S other_attr;
+    dp_schema_builder_t builder;
 
-    nodepos = tal_malloc(sizeof(dp_node_pos_t) * 255);
-    if (NULL == nodepos) {
-        PR_ERR("malloc fail");
-        return OPRT_MALLOC_FAILED;
+    if (NULL == devid || NULL == schema_json) {
+        return OPRT_INVALID_PARM;
     }
     PR_DEBUG("devid %s, schema_json %s", devid, schema_json);
 
-    nodenum = dp_node_pos_decode(schema_json, nodepos, 255);
-    if (0 == nodenum || nodenum >= 255) {
-        PR_ERR("dp num parse err:%d", nodenum);
-        tal_free(nodepos);
-        return OPRT_SVC_DEVOS_DEV_DP_CNT_INVALID;
+    // sizing pass
+    memset(&other_attr, 0, sizeof(other_attr));
+    memset(&builder, 0, sizeof(builder));
+    builder.json_end = schema_json + strlen(schema_json);
+    builder.other_attr = &other_attr;
+    op_ret = dp_schema_build(&builder, schema_json);
+    if (OPRT_OK != op_ret) {
+        PR_ERR("dp schema parse err:%d", op_ret);
+        return op_ret;
     }
-    dp_schema_t *dp_schema = (dp_schema_t *)tal_malloc(sizeof(dp_schema_t) + nodenum * sizeof(dp_node_t));
+
+    size_t node_size = sizeof(dp_schema_t) + builder.node_num * sizeof(dp_node_t);
+    size_t size = node_size + builder.enum_num * sizeof(char *) + builder.pool_need;
+    dp_schema_t *dp_schema = (dp_schema_t *)tal_malloc(size);
     if (NULL == dp_schema) {
-        tal_free(nodepos);
-        PR_ERR("malloc fail:%d", nodenum);
+        PR_ERR("malloc fail:%d", builder.node_num);
         return OPRT_MALLOC_FAILED;
     }
-    memset(dp_schema, 0, sizeof(dp_schema_t) + nodenum * sizeof(dp_node_t));
-    op_ret = tal_mutex_create_init(&(dp_schema->mutex));
+    memset(dp_schema, 0, size);
+    dp_schema->num = builder.node_num;
+    dp_schema->size = size;
+
+    // fill pass
+    builder.schema = dp_schema;
+    builder.enum_ptr = (char **)((uint8_t *)dp_schema + node_size);
+    builder.pool = (char *)(builder.enum_ptr + builder.enum_num);
+    builder.pool_len = 0;
+    op_ret = dp_schema_build(&builder, schema_json);
     if (OPRT_OK != op_ret) {
-        PR_ERR("mutex create fail:%d", op_ret);
+        PR_ERR("dp schema fill fail:%d", op_ret);
         goto __exit;
     }
-    dp_schema->num = nodenum;
-    // dp schema parse
-    SCHEMA_OTHER_ATTR_S other_attr;
-    memset(&other_attr, 0, sizeof(other_attr));
-    tal_mutex_lock(dp_schema->mutex);
-    op_ret = dp_node_parse(schema_json, nodepos, nodenum, dp_schema->node, &other_attr);
-    tal_mutex_unlock(dp_schema->mutex);
+    dp_schema->actv.preprocess = other_attr.preprocess;
+    dp_schema->actv.attach_dp_if = TRUE;
+
+    op_ret = dp_schema_setup(dp_schema, devid, dp_schema_out);
     if (OPRT_OK != op_ret) {
-        PR_ERR("dp_node_parse fail:%d", op_ret);
         goto __exit;
     }
-    dp_schema->actv.preprocess = other_attr.preprocess;
-    dp_schema->actv.attach_dp_if = TRUE;
-    strncpy(dp_schema->devid, devid, DEV_ID_LEN);
-    if (dp_schema_out) {
-        *dp_schema_out = dp_schema;
+    PR_DEBUG("create dp_schema Success, %d dp %d bytes", dp_schema->num, (int)size);
+
+    return OPRT_OK;
+
+__exit:
+    dp_schema_free(dp_schema);
+    return op_ret;
+}
+
+#define DP_SCHEMA_BIN_MAGIC   0x44505342 // "DPSB"
+// 2: strings keep non-ASCII \u escapes as UTF-8, version 1 blobs hold '?'
+#define DP_SCHEMA_BIN_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    /** layout guard, the blob is only valid for the build that wrote it */
+    uint16_t node_size;
+    uint16_t head_size;
+    uint16_t ptr_size;
+    /** arena bytes following the header */
+    uint32_t size;
+    /** crc32 of the arena bytes */
+    uint32_t crc;
+    /** keeps the arena that follows 8-byte aligned */
+    uint32_t reserved;
+} dp_schema_bin_head_t;
+
+/**
+ * @brief Encodes a schema into its binary cache form.
+ *
+ * The arena is copied with its pointers turned into offsets and its runtime
+ * state (values, mutexes, upload status) cleared, so the result can be
+ * stored in KV and handed to dp_schema_create_from_bin on a later boot.
+ *
+ * @param schema The schema to encode.
+ * @param bin Receives the blob, release it with tal_free.
+ * @param len Receives the blob length.
+ *
+ * @return OPRT_OK on success, or an error code on failure.
+ */
+int dp_schema_bin_encode(dp_schema_t *schema, uint8_t **bin, size_t *len)
+{
+    if (NULL == schema || NULL == bin || NULL == len) {
+        return OPRT_INVALID_PARM;
+    }
+
+    dp_schema_bin_head_t *head = tal_malloc(sizeof(dp_schema_bin_head_t) + schema->size);
+    if (NULL == head) {
+        return OPRT_MALLOC_FAILED;
+    }
+    dp_schema_t *copy = (dp_schema_t *)(head + 1);
+    uintptr_t base = (uintptr_t)schema;
+
+    tal_mutex_lock(schema->mutex);
+    memcpy(copy, schema, schema->size);
+    tal_mutex_unlock(schema->mutex);
+
+    copy->mutex = NULL;
+    memset(copy->devid, 0, sizeof(copy->devid));
+    copy->devid_hash = 0;
+    for (int i = 0; i < copy->num; i++) {
+        dp_node_t *dpnode = &copy->node[i];
+        memset(&dpnode->pv_stat, 0, sizeof(dp_node_t) - offsetof(dp_node_t, pv_stat));
+        if (T_OBJ != dpnode->desc.type) {
+            memset(&dpnode->prop, 0, sizeof(dpnode->prop));
+            continue;
+        }
+        switch (dpnode->desc.prop_tp) {
+        case PROP_ENUM: {
+            char **pp_enum = (char **)((uint8_t *)copy + ((uintptr_t)dpnode->prop.prop_enum.pp_enum - base));
+            for (int j = 0; j < dpnode->prop.prop_enum.cnt; j++) {
+                pp_enum[j] = (char *)((uintptr_t)pp_enum[j] - base);
+            }
+            dpnode->prop.prop_enum.pp_enum = (char **)((uintptr_t)dpnode->prop.prop_enum.pp_enum - base);
+            dpnode->prop.prop_enum.value = 0;
+            break;
+        }
+        case PROP_STR:
+            dpnode->prop.prop_str.cur_len = 0;
+            dpnode->prop.prop_str.dp_str_mutex = NULL;
+            dpnode->prop.prop_str.value = NULL;
+            break;
+        case PROP_VALUE:
+            dpnode->prop.prop_int.value = 0;
+            break;
+        case PROP_BOOL:
+            dpnode->prop.prop_bool.value = 0;
+            break;
+        case PROP_BITMAP:
+            dpnode->prop.prop_bitmap.value = 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    head->magic = DP_SCHEMA_BIN_MAGIC;
+    head->version = DP_SCHEMA_BIN_VERSION;
+    head->node_size = sizeof(dp_node_t);
+    head->head_size = sizeof(dp_schema_t);
+    head->ptr_size = sizeof(void *);
+    head->size = schema->size;
+    head->crc = hash_crc32i_total(copy, schema->size);
+    head->reserved = 0;
+
+    *bin = (uint8_t *)head;
+    *len = sizeof(dp_schema_bin_head_t) + schema->size;
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Creates a data point schema from its binary cache form.
+ *
+ * @param devid The device ID for which the schema is being created.
+ * @param bin The blob produced by dp_schema_bin_encode.
+ * @param len The blob length.
+ * @param dp_schema_out A pointer to a variable that will hold the created data
+ * point schema.
+ *
+ * @return 0 if the schema was successfully created, or an error code if the
+ * blob is invalid or stale.
+ */
+int dp_schema_create_from_bin(char *devid, const uint8_t *bin, size_t len, dp_schema_t **dp_schema_out)
+{
+    OPERATE_RET op_ret = OPRT_OK;
+    dp_schema_bin_head_t head;
+
+    if (NULL == devid || NULL == bin || len < sizeof(head)) {
+        return OPRT_INVALID_PARM;
+    }
+    memcpy(&head, bin, sizeof(head));
+    if (head.magic != DP_SCHEMA_BIN_MAGIC || head.version != DP_SCHEMA_BIN_VERSION ||
+        head.node_size != sizeof(dp_node_t) || head.head_size != sizeof(dp_schema_t) ||
+        head.ptr_size != sizeof(void *) || head.size != len - sizeof(head) || head.size < sizeof(dp_schema_t)) {
+        PR_WARN("dp schema bin mismatch");
+        return OPRT_VERSION_FMT_ERR;
+    }
+    if (head.crc != hash_crc32i_total(bin + sizeof(head), head.size)) {
+        PR_WARN("dp schema bin crc err");
+        return OPRT_CRC32_FAILED;
+    }
+
+    dp_schema_t *dp_schema = tal_malloc(head.size);
+    if (NULL == dp_schema) {
+        return OPRT_MALLOC_FAILED;
+    }
+    memcpy(dp_schema, bin + sizeof(head), head.size);
+
+    uintptr_t base = (uintptr_t)dp_schema;
+    size_t node_end = sizeof(dp_schema_t) + dp_schema->num * sizeof(dp_node_t);
+    if (dp_schema->size != head.size || node_end > head.size) {
+        op_ret = OPRT_VERSION_FMT_ERR;
+        goto __exit;
+    }
+    for (int i = 0; i < dp_schema->num; i++) {
+        dp_node_t *dpnode = &dp_schema->node[i];
+        if (T_OBJ != dpnode->desc.type || PROP_ENUM != dpnode->desc.prop_tp) {
+            continue;
+        }
+        uintptr_t off = (uintptr_t)dpnode->prop.prop_enum.pp_enum;
+        if (off < node_end || dpnode->prop.prop_enum.cnt <= 0 ||
+            off + dpnode->prop.prop_enum.cnt * sizeof(char *) > head.size) {
+            op_ret = OPRT_VERSION_FMT_ERR;
+            goto __exit;
+        }
+        dpnode->prop.prop_enum.pp_enum = (char **)(base + off);
+        for (int j = 0; j < dpnode->prop.prop_enum.cnt; j++) {
+            off = (uintptr_t)dpnode->prop.prop_enum.pp_enum[j];
+            if (off < node_end || off >= head.size) {
+                op_ret = OPRT_VERSION_FMT_ERR;
+                goto __exit;
+            }
+            dpnode->prop.prop_enum.pp_enum[j] = (char *)(base + off);
+        }
     }
-    if (s_dsmgr.schema_num < DP_SCHEMA_NUM_MAX) {
-        s_dsmgr.schema_list[s_dsmgr.schema_num] = dp_schema;
-        s_dsmgr.schema_num++;
+    op_ret = dp_schema_setup(dp_schema, devid, dp_schema_out);
+    if (OPRT_OK != op_ret) {
+        goto __exit;
     }
-    PR_DEBUG("create dp_schema Success ");
-    tal_free(nodepos);
+    PR_DEBUG("create dp_schema from bin Success, %d dp", dp_schema->num);
 
     return OPRT_OK;
 
 __exit:
-    tal_mutex_release(dp_schema->mutex);
-    tal_free(dp_schema);
-    tal_free(nodepos);
+    dp_schema_free(dp_schema);
     return op_ret;
 }
 
@@ -1668,23 +2337,18 @@ __exit:
  */
 int dp_schema_delete(char *devid)
 {
-    int i = 0;
-
     PR_TRACE("try to delete schema devid %s", devid);
     dp_schema_mgr_t *dsmgr = &s_dsmgr;
-    for (i = 0; i < DP_SCHEMA_NUM_MAX; i++) {
-        if (NULL == dsmgr->schema_list[i]) {
-            continue;
-        }
-
-        if (0 == strcmp(devid, dsmgr->schema_list[i]->devid)) {
-            tal_mutex_release(dsmgr->schema_list[i]->mutex);
-            tal_free(dsmgr->schema_list[i]);
-            dsmgr->schema_list[i] = NULL;
-            dsmgr->schema_num--;
-            return OPRT_OK;
-        }
+    uint32_t slot = dp_schema_hash_slot(devid, dp_devid_hash(devid));
+    if (0 == dsmgr->hash_index[slot]) {
+        return OPRT_OK;
     }
 
+    int i = dsmgr->hash_index[slot] - 1;
+    dp_schema_hash_remove(slot);
+    dp_schema_free(dsmgr->schema_list[i]);
+    dsmgr->schema_list[i] = NULL;
+    dsmgr->schema_num--;
+
     return OPRT_OK;
 }
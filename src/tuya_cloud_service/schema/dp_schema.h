@@ -27,6 +27,11 @@ extern "C" {
 
 #define DEV_ID_LEN 25
 
+// schemas registered at once, a gateway raises it for its sub-devices
+#ifndef DP_SCHEMA_NUM_MAX
+#define DP_SCHEMA_NUM_MAX 1
+#endif
+
 /**
  * @brief  Definition of dp property type
  */
@@ -272,6 +277,8 @@ typedef struct {
     uint32_t max_len;
     /** value */
     uint32_t value;
+    /** valid bits, derived from max_len */
+    uint32_t mask;
 } dp_prop_bitmap_t;
 
 /**
@@ -293,7 +300,7 @@ typedef union {
 /**
  * @brief Definition of dp  control
  */
-typedef struct {
+typedef struct dp_node_s {
     /** see dp_desc_t */
     dp_desc_t desc;
     /** see dp_prop_vaule_t */
@@ -305,6 +312,8 @@ typedef struct {
     // DP_REPT_FLOW_CTRL rept_flow_ctrl;
     /** time stamp for dp sync */
     TIME_T time_stamp;
+    /** value validator, selected when the schema is parsed */
+    bool (*check)(const struct dp_node_s *node, const dp_obj_t *dp);
     /** sn for ble dp sync report */
     // uint32_t ble_send_sn;
 } dp_node_t; // dp_obj_t
@@ -329,6 +338,12 @@ typedef struct {
     dp_prop_actv_t actv;
     /** exclusive access to dp */
     MUTEX_HANDLE mutex;
+    /** hash of devid, key of the devid index of dp_schema.c */
+    uint32_t devid_hash;
+    /** node[] position + 1 indexed by dp id, 0 if the id is not in schema */
+    uint8_t index[256];
+    /** bytes of the allocation holding schema, nodes and enum strings */
+    uint32_t size;
     /** count of dp */
     uint8_t num;
     /** dp info */
@@ -512,6 +527,34 @@ int dp_rept_json_append(dp_schema_t *schema, char *data, char *time, char *type,
  * @return Returns 0 on success, or a negative error code on failure.
  */
 int dp_schema_create(char *devid, char *schema_json, dp_schema_t **dp_schema_out);
+
+/**
+ * @brief Creates a data point schema from its binary cache form.
+ *
+ * The blob is the output of dp_schema_bin_encode, so no JSON is parsed.
+ *
+ * @param devid The device ID for which the schema is being created.
+ * @param bin The blob produced by dp_schema_bin_encode.
+ * @param len The blob length.
+ * @param dp_schema_out A pointer to a variable that will hold the created data
+ * point schema.
+ *
+ * @return Returns 0 on success, or a negative error code if the blob is
+ * invalid or was written by an incompatible build.
+ */
+int dp_schema_create_from_bin(char *devid, const uint8_t *bin, size_t len, dp_schema_t **dp_schema_out);
+
+/**
+ * @brief Encodes a data point schema into its binary cache form.
+ *
+ * @param schema The schema to encode.
+ * @param bin Receives the blob, release it with tal_free.
+ * @param len Receives the blob length.
+ *
+ * @return Returns 0 on success, or a negative error code on failure.
+ */
+int dp_schema_bin_encode(dp_schema_t *schema, uint8_t **bin, size_t *len);
+
 /**
  * @brief Deletes the data point schema for a specific device.
  *
@@ -254,30 +254,8 @@ int tuya_iot_dp_obj_report(tuya_iot_client_t *client, const char *devid, dp_obj_
 #ifdef ENABLE_BLUETOOTH
     //! BLE TLV FORMAT
     if (tuya_ble_is_connected()) {
-        dp_rept_in_t *ble_dpin = NULL;
-
-        ble_dpin = tal_malloc(sizeof(dp_rept_in_t) + sizeof(dp_obj_t) * dpvalid->num);
-        if (NULL == ble_dpin) {
-            tal_free(dpvalid);
-            return OPRT_MALLOC_FAILED;
-        }
-        ble_dpin->flags = flags;
-        ble_dpin->rept_type = T_OBJ_REPT;
-        ble_dpin->dpscnt = dpvalid->num;
-        ble_dpin->dps = (dp_obj_t *)(ble_dpin + sizeof(dp_rept_in_t));
-        //! copy vaild dpid
-        int i, j;
-        for (i = 0; i < dpvalid->num; i++) {
-            for (j = 0; j < dpin.dpscnt; j++) {
-                if (dpvalid->dpid[i] != dpin.dps[j].id) {
-                    continue;
-                }
-                memcpy(&ble_dpin->dps[i], &dpin.dps[j], sizeof(dp_obj_t));
-            }
-        }
         PR_DEBUG("ble channel report");
-        ret = tuya_ble_dp_report(ble_dpin);
-        tal_free(ble_dpin);
+        ret = tuya_ble_dp_obj_report(dpin.dps, dpin.dpscnt, dpvalid->dpid, dpvalid->num);
         tal_free(dpvalid);
         tuya_iot_dp_sync_start(client, 5);
 
@@ -7,6 +7,11 @@
  * over TLS secured connections, handling of X.509 certificates for TLS, and
  * logging for TLS operations.
  *
+ * Parsed CA chains are cached process-wide by content digest, and the session
+ * of each host:port is kept for resumption (optionally persisted in KV), so a
+ * reconnect after a link flap skips the certificate parsing and, when the
+ * server accepts the session, the asymmetric part of the handshake.
+ *
  * @copyright Copyright (c) 2021-2024 Tuya Inc. All Rights Reserved.
  *
  */
@@ -38,9 +43,35 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/hkdf.h"
 #include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
 
 #define TLS_URL_LEN (128 + 16)
 
+#ifndef TLS_CA_CACHE_NUM
+#define TLS_CA_CACHE_NUM 2
+#endif
+
+#ifndef TLS_SESSION_CACHE_NUM
+#define TLS_SESSION_CACHE_NUM 4
+#endif
+
+#define TLS_SESSION_KV_KEY "tls.ss.%08x"
+
+typedef struct {
+    uint8_t digest[32];
+    mbedtls_x509_crt crt;
+    uint16_t ref;
+    uint32_t used;
+} tuya_tls_ca_cache_t;
+
+typedef struct {
+    char host[TLS_URL_LEN];
+    uint16_t port;
+    bool valid;
+    uint32_t used;
+    mbedtls_ssl_session session;
+} tuya_tls_session_cache_t;
+
 typedef struct {
     tuya_tls_config_t config;
     mbedtls_ssl_context ssl_ctx;
@@ -48,6 +79,7 @@ typedef struct {
     mbedtls_x509_crt cacert;
     mbedtls_x509_crt client_cert;
     mbedtls_pk_context client_pkey;
+    tuya_tls_ca_cache_t *ca_cache;
     int socket_fd;
     int overtime_s;
     MUTEX_HANDLE mutex;
@@ -60,6 +92,16 @@ static tuya_tls_pre_conn_cb s_pre_conn_cb = NULL;
 static mbedtls_entropy_context ty_entropy;
 static mbedtls_ctr_drbg_context ty_ctr_drbg;
 
+static MUTEX_HANDLE s_cache_mutex = NULL;
+static uint32_t s_cache_tick = 0;
+static tuya_tls_stat_t s_tls_stat;
+#if (TLS_CA_CACHE_NUM > 0)
+static tuya_tls_ca_cache_t s_ca_cache[TLS_CA_CACHE_NUM];
+#endif
+#if (TLS_SESSION_CACHE_NUM > 0)
+static tuya_tls_session_cache_t s_session_cache[TLS_SESSION_CACHE_NUM];
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*                                  TLS Mutex                                 */
 /* -------------------------------------------------------------------------- */
@@ -309,6 +351,280 @@ static int __tuya_tls_socket_recv_cb(void *ctx, unsigned char *buf, size_t len)
     return rv;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                                  CA cache                                  */
+/* -------------------------------------------------------------------------- */
+#if (TLS_CA_CACHE_NUM > 0)
+/**
+ * @brief Get the parsed chain of a CA blob, parsing it only on a cache miss.
+ *
+ * The entry is referenced until __tuya_tls_ca_cache_put(). When every entry is
+ * referenced, NULL is returned and the caller parses into its own context.
+ */
+static tuya_tls_ca_cache_t *__tuya_tls_ca_cache_get(const uint8_t *ca, size_t ca_len, int *err)
+{
+    uint8_t digest[32];
+    tuya_tls_ca_cache_t *entry = NULL;
+    int i;
+
+    *err = mbedtls_sha256(ca, ca_len, digest, 0);
+    if (*err != 0) {
+        return NULL;
+    }
+
+    tal_mutex_lock(s_cache_mutex);
+    for (i = 0; i < TLS_CA_CACHE_NUM; i++) {
+        if (s_ca_cache[i].crt.version != 0 && 0 == memcmp(s_ca_cache[i].digest, digest, sizeof(digest))) {
+            entry = &s_ca_cache[i];
+            s_tls_stat.ca_hit++;
+            goto __EXIT;
+        }
+    }
+
+    // miss, reuse the least recently used entry nobody holds
+    for (i = 0; i < TLS_CA_CACHE_NUM; i++) {
+        if (s_ca_cache[i].ref == 0 && (entry == NULL || s_ca_cache[i].used < entry->used)) {
+            entry = &s_ca_cache[i];
+        }
+    }
+    if (entry == NULL) {
+        goto __EXIT;
+    }
+
+    s_tls_stat.ca_miss++;
+    mbedtls_x509_crt_free(&entry->crt);
+    mbedtls_x509_crt_init(&entry->crt);
+    *err = mbedtls_x509_crt_parse(&entry->crt, ca, ca_len);
+    if (*err != 0) {
+        mbedtls_x509_crt_free(&entry->crt);
+        mbedtls_x509_crt_init(&entry->crt);
+        entry = NULL;
+        goto __EXIT;
+    }
+    memcpy(entry->digest, digest, sizeof(digest));
+
+__EXIT:
+    if (entry) {
+        entry->ref++;
+        entry->used = ++s_cache_tick;
+    }
+    tal_mutex_unlock(s_cache_mutex);
+
+    return entry;
+}
+
+static void __tuya_tls_ca_cache_put(tuya_tls_ca_cache_t *entry)
+{
+    tal_mutex_lock(s_cache_mutex);
+    if (entry->ref > 0) {
+        entry->ref--;
+    }
+    tal_mutex_unlock(s_cache_mutex);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                                Session cache                               */
+/* -------------------------------------------------------------------------- */
+#if (TLS_SESSION_CACHE_NUM > 0)
+static tuya_tls_session_cache_t *__tuya_tls_session_find(const char *host, uint16_t port)
+{
+    int i;
+
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+        if (s_session_cache[i].port == port && 0 == strcmp(s_session_cache[i].host, host)) {
+            return &s_session_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static tuya_tls_session_cache_t *__tuya_tls_session_alloc(const char *host, uint16_t port)
+{
+    tuya_tls_session_cache_t *entry = __tuya_tls_session_find(host, port);
+    int i;
+
+    if (entry) {
+        return entry;
+    }
+
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+        if (entry == NULL || !s_session_cache[i].valid ||
+            (entry->valid && s_session_cache[i].used < entry->used)) {
+            entry = &s_session_cache[i];
+        }
+    }
+
+    mbedtls_ssl_session_free(&entry->session);
+    mbedtls_ssl_session_init(&entry->session);
+    entry->valid = false;
+    entry->port = port;
+    strncpy(entry->host, host, sizeof(entry->host) - 1);
+    entry->host[sizeof(entry->host) - 1] = '\0';
+
+    return entry;
+}
+
+#if defined(ENABLE_TLS_SESSION_KV) && (ENABLE_TLS_SESSION_KV == 1)
+static void __tuya_tls_session_kv_key(const char *host, uint16_t port, char *key, size_t key_len)
+{
+    uint32_t hash = 0x811c9dc5; // FNV-1a of host and port
+
+    while (*host) {
+        hash = (hash ^ (uint8_t)*host++) * 0x01000193;
+    }
+    hash = (hash ^ (port & 0xff)) * 0x01000193;
+    hash = (hash ^ (port >> 8)) * 0x01000193;
+
+    snprintf(key, key_len, TLS_SESSION_KV_KEY, hash);
+}
+
+/* KV record: host, '\0', port (2 bytes, big endian), serialized session */
+static void __tuya_tls_session_kv_load(tuya_tls_session_cache_t *entry)
+{
+    char key[16];
+    uint8_t *value = NULL;
+    size_t len = 0, host_len = strlen(entry->host) + 1;
+
+    __tuya_tls_session_kv_key(entry->host, entry->port, key, sizeof(key));
+    if (OPRT_OK != tal_kv_get(key, &value, &len)) {
+        return;
+    }
+
+    if (len > host_len + 2 && 0 == memcmp(value, entry->host, host_len) &&
+        ((value[host_len] << 8) | value[host_len + 1]) == entry->port &&
+        0 == mbedtls_ssl_session_load(&entry->session, value + host_len + 2, len - host_len - 2)) {
+        entry->valid = true;
+    } else {
+        mbedtls_ssl_session_free(&entry->session);
+        mbedtls_ssl_session_init(&entry->session);
+    }
+    tal_kv_free(value);
+}
+
+static void __tuya_tls_session_kv_save(tuya_tls_session_cache_t *entry)
+{
+    char key[16];
+    uint8_t *value = NULL;
+    size_t len = 0, host_len = strlen(entry->host) + 1;
+
+    if (MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL != mbedtls_ssl_session_save(&entry->session, NULL, 0, &len)) {
+        return;
+    }
+
+    value = tal_malloc(host_len + 2 + len);
+    if (NULL == value) {
+        return;
+    }
+
+    memcpy(value, entry->host, host_len);
+    value[host_len] = entry->port >> 8;
+    value[host_len + 1] = entry->port & 0xff;
+    if (0 == mbedtls_ssl_session_save(&entry->session, value + host_len + 2, len, &len)) {
+        __tuya_tls_session_kv_key(entry->host, entry->port, key, sizeof(key));
+        tal_kv_set(key, value, host_len + 2 + len);
+    }
+    tal_free(value);
+}
+#endif
+
+/**
+ * @brief Offer the cached session of host:port for resumption.
+ *
+ * @return true if a session was set on the SSL context, its id is copied out
+ * so the caller can tell a resumed handshake from a full one.
+ */
+static bool __tuya_tls_session_offer(mbedtls_ssl_context *ssl, const char *host, uint16_t port, uint8_t *id,
+                                     size_t *id_len)
+{
+    tuya_tls_session_cache_t *entry = NULL;
+    bool offered = false;
+
+    tal_mutex_lock(s_cache_mutex);
+    entry = __tuya_tls_session_find(host, port);
+#if defined(ENABLE_TLS_SESSION_KV) && (ENABLE_TLS_SESSION_KV == 1)
+    if (NULL == entry) {
+        entry = __tuya_tls_session_alloc(host, port);
+        __tuya_tls_session_kv_load(entry);
+    }
+#endif
+    if (entry && entry->valid && 0 == mbedtls_ssl_set_session(ssl, &entry->session)) {
+        entry->used = ++s_cache_tick;
+        *id_len = entry->session.MBEDTLS_PRIVATE(id_len);
+        memcpy(id, entry->session.MBEDTLS_PRIVATE(id), *id_len);
+        offered = true;
+    }
+    tal_mutex_unlock(s_cache_mutex);
+
+    return offered;
+}
+
+/**
+ * @brief Keep the session of a finished handshake, or drop the cached one
+ * after a failed handshake.
+ *
+ * @return true if the server echoed the offered session id, i.e. the
+ * handshake resumed the offered session.
+ */
+static bool __tuya_tls_session_update(mbedtls_ssl_context *ssl, const char *host, uint16_t port, bool ok,
+                                      const uint8_t *offered_id, size_t offered_id_len)
+{
+    tuya_tls_session_cache_t *entry = NULL;
+    bool resumed = false;
+
+    tal_mutex_lock(s_cache_mutex);
+    if (!ok) {
+        entry = __tuya_tls_session_find(host, port);
+        if (entry) {
+            mbedtls_ssl_session_free(&entry->session);
+            mbedtls_ssl_session_init(&entry->session);
+            entry->valid = false;
+        }
+        goto __EXIT;
+    }
+
+    entry = __tuya_tls_session_alloc(host, port);
+    mbedtls_ssl_session_free(&entry->session);
+    mbedtls_ssl_session_init(&entry->session);
+    entry->valid = (0 == mbedtls_ssl_get_session(ssl, &entry->session));
+    entry->used = ++s_cache_tick;
+    resumed = entry->valid && offered_id_len > 0 && entry->session.MBEDTLS_PRIVATE(id_len) == offered_id_len &&
+              0 == memcmp(entry->session.MBEDTLS_PRIVATE(id), offered_id, offered_id_len);
+#if defined(ENABLE_TLS_SESSION_KV) && (ENABLE_TLS_SESSION_KV == 1)
+    // only new sessions reach the flash
+    if (entry->valid && !resumed) {
+        __tuya_tls_session_kv_save(entry);
+    }
+#endif
+
+__EXIT:
+    tal_mutex_unlock(s_cache_mutex);
+    return resumed;
+}
+#endif
+
+static void __tuya_tls_stat_update(bool ok, bool resumed, uint32_t handshake_ms)
+{
+    tal_mutex_lock(s_cache_mutex);
+    if (!ok) {
+        s_tls_stat.fail_cnt++;
+    } else if (resumed) {
+        s_tls_stat.resume_cnt++;
+        s_tls_stat.resume_ms += handshake_ms;
+        if (handshake_ms > s_tls_stat.resume_max_ms) {
+            s_tls_stat.resume_max_ms = handshake_ms;
+        }
+    } else {
+        s_tls_stat.full_cnt++;
+        s_tls_stat.full_ms += handshake_ms;
+        if (handshake_ms > s_tls_stat.full_max_ms) {
+            s_tls_stat.full_max_ms = handshake_ms;
+        }
+    }
+    tal_mutex_unlock(s_cache_mutex);
+}
+
 static int tuya_tls_ciphersuite_list_PSK[] = {MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256, 0};
 
 static void mbedtls_cert_pkey_free(tuya_tls_hander p_tls_handler)
@@ -318,6 +634,13 @@ static void mbedtls_cert_pkey_free(tuya_tls_hander p_tls_handler)
 
     PR_DEBUG("mbedtls_cert_pkey_free.");
 
+#if (TLS_CA_CACHE_NUM > 0)
+    if (tls_context->ca_cache) {
+        __tuya_tls_ca_cache_put(tls_context->ca_cache);
+        tls_context->ca_cache = NULL;
+    }
+#endif
+
     if (config->ca_cert) {
         mbedtls_x509_crt_free(&tls_context->cacert);
     } else if (config->client_cert && config->client_pkey) {
@@ -348,12 +671,24 @@ static OPERATE_RET mbedtls_cert_pkey_parse(tuya_tls_hander p_tls_handler)
     // parse ca cert
     if (config->ca_cert) {
         PR_DEBUG("load root ca cert.");
-        op_ret = mbedtls_x509_crt_parse(p_cert_ctx, (const unsigned char *)config->ca_cert, config->ca_cert_size);
-        if (op_ret != OPRT_OK) {
-            PR_ERR("mbedtls_x509_crt_parse Fail. 0x%x %d", -op_ret, op_ret);
-            return op_ret;
+        op_ret = OPRT_OK;
+#if (TLS_CA_CACHE_NUM > 0)
+        tls_context->ca_cache =
+            __tuya_tls_ca_cache_get((const uint8_t *)config->ca_cert, config->ca_cert_size, (int *)&op_ret);
+#endif
+        if (tls_context->ca_cache) {
+            mbedtls_ssl_conf_ca_chain(&(tls_context->conf_ctx), &tls_context->ca_cache->crt, NULL);
+        } else {
+            if (op_ret == OPRT_OK) {
+                op_ret = mbedtls_x509_crt_parse(p_cert_ctx, (const unsigned char *)config->ca_cert,
+                                                config->ca_cert_size);
+            }
+            if (op_ret != OPRT_OK) {
+                PR_ERR("mbedtls_x509_crt_parse Fail. 0x%x %d", -op_ret, op_ret);
+                return op_ret;
+            }
+            mbedtls_ssl_conf_ca_chain(&(tls_context->conf_ctx), p_cert_ctx, NULL);
         }
-        mbedtls_ssl_conf_ca_chain(&(tls_context->conf_ctx), p_cert_ctx, NULL);
     }
 
     /* parse client own cert */
@@ -406,6 +741,14 @@ OPERATE_RET tuya_tls_init(void)
 {
     OPERATE_RET op_ret = OPRT_OK;
 
+    if (NULL == s_cache_mutex) {
+        op_ret = tal_mutex_create_init(&s_cache_mutex);
+        if (op_ret != OPRT_OK) {
+            PR_ERR("cache mutex create Fail. %d", op_ret);
+            return op_ret;
+        }
+    }
+
     mbedtls_threading_set_alt(__tuya_tls_mutex_init, __tuya_tls_mutex_free, __tuya_tls_mutex_lock,
                               __tuya_tls_mutex_unlock);
 
@@ -550,6 +893,13 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
 {
     OPERATE_RET op_ret;
     tuya_mbedtls_context_t *tls_context = (tuya_mbedtls_context_t *)p_tls_handler;
+    bool resumed = false;
+    uint32_t handshake_ms = 0;
+#if (TLS_SESSION_CACHE_NUM > 0)
+    bool resumable = false, offered = false;
+    uint8_t offered_id[32];
+    size_t offered_id_len = 0;
+#endif
 
     if (NULL == p_tls_handler || socket_fd < 0) {
         PR_ERR("INPUT INVALID PARM");
@@ -619,6 +969,9 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
                 mbedtls_cert_pkey_free(p_tls_handler);
                 return op_ret;
             }
+#if (TLS_SESSION_CACHE_NUM > 0)
+            resumable = true;
+#endif
         }
         mbedtls_ssl_conf_ciphersuites(p_conf_ctx, tuya_tls_ciphersuite_list);
     }
@@ -639,7 +992,14 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
     mbedtls_ssl_set_bio(p_ssl_ctx, tls_context, __tuya_tls_socket_send_cb, __tuya_tls_socket_recv_cb, NULL);
     PR_DEBUG("socket fd is set. set to inner send/recv to handshake");
 
+#if (TLS_SESSION_CACHE_NUM > 0)
+    if (resumable) {
+        offered = __tuya_tls_session_offer(p_ssl_ctx, hostname, port_num, offered_id, &offered_id_len);
+    }
+#endif
+
     TIME_T cur_time = tal_time_get_posix();
+    handshake_ms = (uint32_t)tal_system_get_millisecond();
 
     while ((op_ret = mbedtls_ssl_handshake(p_ssl_ctx)) != 0) {
         if (op_ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
@@ -678,7 +1038,17 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
         goto tuya_tls_connect_EXIT;
     }
 
-    PR_DEBUG("handshake finish for %s. set send/recv to user set", (hostname ? hostname : ""));
+    handshake_ms = (uint32_t)tal_system_get_millisecond() - handshake_ms;
+#if (TLS_SESSION_CACHE_NUM > 0)
+    if (resumable) {
+        resumed = __tuya_tls_session_update(p_ssl_ctx, hostname, port_num, true, offered_id,
+                                            offered ? offered_id_len : 0);
+    }
+#endif
+    __tuya_tls_stat_update(true, resumed, handshake_ms);
+
+    PR_DEBUG("handshake finish for %s in %d ms%s. set send/recv to user set", (hostname ? hostname : ""),
+             handshake_ms, resumed ? " (resumed)" : "");
     if (tls_context->config.f_send && tls_context->config.f_recv) {
         mbedtls_ssl_set_bio(p_ssl_ctx, tls_context->config.user_data, tls_context->config.f_send,
                             tls_context->config.f_recv, NULL);
@@ -691,6 +1061,12 @@ OPERATE_RET tuya_tls_connect(tuya_tls_hander p_tls_handler, char *hostname, int
 
 tuya_tls_connect_EXIT:
 
+#if (TLS_SESSION_CACHE_NUM > 0)
+    if (offered) {
+        __tuya_tls_session_update(p_ssl_ctx, hostname, port_num, false, NULL, 0);
+    }
+#endif
+    __tuya_tls_stat_update(false, false, 0);
     PR_ERR("TUYA_TLS faild Connect %s:%d", (hostname ? hostname : ""), port_num);
 
     return op_ret;
@@ -824,6 +1200,75 @@ OPERATE_RET tuya_tls_disconnect(tuya_tls_hander tls_handler)
     return OPRT_OK;
 }
 
+/**
+ * @brief Gets the handshake counters.
+ *
+ * @param[out] stat full and resumed handshake counts and latency, CA cache hits
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tuya_tls_stat_get(tuya_tls_stat_t *stat)
+{
+    if (NULL == stat || NULL == s_cache_mutex) {
+        return OPRT_INVALID_PARM;
+    }
+
+    tal_mutex_lock(s_cache_mutex);
+    *stat = s_tls_stat;
+    tal_mutex_unlock(s_cache_mutex);
+
+    return OPRT_OK;
+}
+
+/**
+ * @brief Resets the handshake counters.
+ */
+void tuya_tls_stat_reset(void)
+{
+    tal_mutex_lock(s_cache_mutex);
+    memset(&s_tls_stat, 0, sizeof(s_tls_stat));
+    tal_mutex_unlock(s_cache_mutex);
+}
+
+/**
+ * @brief Drops the cached sessions and the CA chains not in use. The next
+ * connection to each host does a full handshake.
+ */
+void tuya_tls_cache_clear(void)
+{
+    int i;
+
+    if (NULL == s_cache_mutex) {
+        return;
+    }
+
+    tal_mutex_lock(s_cache_mutex);
+#if (TLS_SESSION_CACHE_NUM > 0)
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+#if defined(ENABLE_TLS_SESSION_KV) && (ENABLE_TLS_SESSION_KV == 1)
+        if (s_session_cache[i].host[0]) {
+            char key[16];
+            __tuya_tls_session_kv_key(s_session_cache[i].host, s_session_cache[i].port, key, sizeof(key));
+            tal_kv_del(key);
+        }
+#endif
+        mbedtls_ssl_session_free(&s_session_cache[i].session);
+        memset(&s_session_cache[i], 0, sizeof(tuya_tls_session_cache_t));
+    }
+#endif
+#if (TLS_CA_CACHE_NUM > 0)
+    for (i = 0; i < TLS_CA_CACHE_NUM; i++) {
+        if (s_ca_cache[i].ref == 0) {
+            mbedtls_x509_crt_free(&s_ca_cache[i].crt);
+            memset(&s_ca_cache[i], 0, sizeof(tuya_tls_ca_cache_t));
+        }
+    }
+#endif
+    tal_mutex_unlock(s_cache_mutex);
+    (void)i;
+}
+
 /**
  * Retrieves the callback function for Tuya TLS events.
  *
@@ -91,6 +91,18 @@ typedef struct {
     void *user_data;
 } tuya_tls_config_t;
 
+typedef struct {
+    uint32_t full_cnt;      // full handshakes
+    uint32_t full_ms;       // total time of full handshakes
+    uint32_t full_max_ms;   // slowest full handshake
+    uint32_t resume_cnt;    // handshakes that resumed a cached session
+    uint32_t resume_ms;     // total time of resumed handshakes
+    uint32_t resume_max_ms; // slowest resumed handshake
+    uint32_t fail_cnt;      // failed connects
+    uint32_t ca_hit;        // CA chains taken from the cache
+    uint32_t ca_miss;       // CA chains parsed
+} tuya_tls_stat_t;
+
 /**
  * @brief Get mbedtls random data in the specified length
  *
@@ -221,6 +233,27 @@ OPERATE_RET tuya_tls_disconnect(tuya_tls_hander tls_handler);
  */
 const tuya_tls_config_t *tuya_tls_psk_mode_config_get(void);
 
+/**
+ * @brief get the handshake counters
+ *
+ * @param[out] stat full and resumed handshake counts and latency, CA cache hits
+ *
+ * @return OPRT_OK on success. Others on error, please refer to
+ * tuya_error_code.h
+ */
+OPERATE_RET tuya_tls_stat_get(tuya_tls_stat_t *stat);
+
+/**
+ * @brief reset the handshake counters
+ */
+void tuya_tls_stat_reset(void);
+
+/**
+ * @brief drop the cached TLS sessions and CA chains, the next connection to
+ * each host does a full handshake
+ */
+void tuya_tls_cache_clear(void);
+
 /**
  * Retrieves the callback function for Tuya TLS events.
  *
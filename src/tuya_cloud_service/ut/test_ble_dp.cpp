@@ -0,0 +1,206 @@
+/**
+ * @file test_ble_dp.cpp
+ * @brief Unit tests of the BLE DP report encoder against the TLVs of the
+ * former KLV list encoder.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "ble_dp.h"
+
+#define TEST_TIME_STAMP  1700000000
+#define TEST_HEAD_LEN    12 // version, sn(4), query, flag, time type, time(4)
+#define TEST_GUARD       0xA5
+#define TEST_LONG_STRING "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+
+#define LEGACY_DT_BOOL   1
+#define LEGACY_DT_VALUE  2
+#define LEGACY_DT_STRING 3
+#define LEGACY_DT_ENUM   4
+#define LEGACY_DT_BITMAP 5
+
+static const dp_obj_t sg_switch_dps[] = {
+    {.id = 1, .type = PROP_BOOL, .value = {.dp_bool = true}},
+};
+
+static const dp_obj_t sg_sensor_dps[] = {
+    {.id = 1, .type = PROP_BOOL, .value = {.dp_bool = true}},
+    {.id = 2, .type = PROP_VALUE, .value = {.dp_value = 235}},
+    {.id = 3, .type = PROP_VALUE, .value = {.dp_value = -12}},
+    {.id = 4, .type = PROP_ENUM, .value = {.dp_enum = 2}},
+    {.id = 5, .type = PROP_ENUM, .value = {.dp_enum = 300}},
+    {.id = 6, .type = PROP_BITMAP, .value = {.dp_bitmap = 5}},
+    {.id = 7, .type = PROP_ENUM, .value = {.dp_enum = 70000}},
+    {.id = 8, .type = PROP_BOOL, .value = {.dp_bool = false}},
+};
+
+static const dp_obj_t sg_config_dps[] = {
+    {.id = 101, .type = PROP_STR, .value = {.dp_str = (char *)TEST_LONG_STRING}},
+    {.id = 102, .type = PROP_VALUE, .value = {.dp_value = 3600}},
+    {.id = 103, .type = PROP_STR, .value = {.dp_str = (char *)""}},
+    {.id = 104, .type = PROP_ENUM, .value = {.dp_enum = 1}},
+    {.id = 105, .type = PROP_STR, .value = {.dp_str = (char *)"Living room"}},
+};
+
+/**
+ * @brief One TLV the way the former make_klv_list and klvlist_2_data laid it
+ * out: id, type, big endian length and big endian value
+ */
+static void legacy_tlv_append(std::vector<uint8_t> &out, const dp_obj_t *dp)
+{
+    uint32_t value = 0;
+    uint16_t len = 4;
+    uint8_t type = 0;
+
+    switch (dp->type) {
+    case PROP_BOOL:
+        type = LEGACY_DT_BOOL;
+        value = dp->value.dp_bool ? 1 : 0;
+        len = 1;
+        break;
+    case PROP_VALUE:
+        type = LEGACY_DT_VALUE;
+        value = (uint32_t)dp->value.dp_value;
+        break;
+    case PROP_ENUM:
+        type = LEGACY_DT_ENUM;
+        value = dp->value.dp_enum;
+        len = (value <= 0xff) ? 1 : ((value <= 0xffff) ? 2 : 4);
+        break;
+    case PROP_BITMAP:
+        type = LEGACY_DT_BITMAP;
+        value = dp->value.dp_bitmap;
+        break;
+    default:
+        type = LEGACY_DT_STRING;
+        len = strlen(dp->value.dp_str);
+        break;
+    }
+
+    out.push_back(dp->id);
+    out.push_back(type);
+    out.push_back(len >> 8);
+    out.push_back(len & 0xff);
+    if (LEGACY_DT_STRING == type) {
+        out.insert(out.end(), dp->value.dp_str, dp->value.dp_str + len);
+        return;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        out.push_back((uint8_t)(value >> ((len - 1 - i) * 8)));
+    }
+}
+
+static std::vector<uint8_t> legacy_tlvs(const dp_obj_t *dps, uint16_t cnt, const uint8_t *dpid, uint8_t dpid_num)
+{
+    std::vector<uint8_t> out;
+
+    for (uint16_t i = 0; i < cnt; i++) {
+        if (dpid && NULL == memchr(dpid, dps[i].id, dpid_num)) {
+            continue;
+        }
+        legacy_tlv_append(out, &dps[i]);
+    }
+    return out;
+}
+
+class BleDpTest : public ::testing::Test {
+  protected:
+    std::vector<uint8_t> encode(const dp_obj_t *dps, uint16_t cnt, const uint8_t *dpid, uint8_t dpid_num,
+                                uint32_t time_stamp)
+    {
+        std::vector<uint8_t> frame;
+        uint32_t len = 0;
+
+        EXPECT_EQ(OPRT_BUFFER_NOT_ENOUGH, tuya_ble_dp_obj_encode(dps, cnt, dpid, dpid_num, time_stamp, NULL, 0, &len));
+        frame.resize(len);
+        EXPECT_EQ(OPRT_OK, tuya_ble_dp_obj_encode(dps, cnt, dpid, dpid_num, time_stamp, frame.data(), len, &len));
+        EXPECT_EQ(frame.size(), len);
+        return frame;
+    }
+
+    void expect_same_tlvs(const dp_obj_t *dps, uint16_t cnt)
+    {
+        std::vector<uint8_t> frame = encode(dps, cnt, NULL, 0, TEST_TIME_STAMP);
+        std::vector<uint8_t> tlvs = legacy_tlvs(dps, cnt, NULL, 0);
+
+        ASSERT_EQ(TEST_HEAD_LEN + tlvs.size(), frame.size());
+        EXPECT_EQ(0, memcmp(&frame[TEST_HEAD_LEN], tlvs.data(), tlvs.size()));
+    }
+};
+
+TEST_F(BleDpTest, Head)
+{
+    std::vector<uint8_t> frame = encode(sg_switch_dps, 1, NULL, 0, TEST_TIME_STAMP);
+    const uint8_t time[4] = {0x65, 0x53, 0xF1, 0x00}; // 1700000000, big endian
+
+    ASSERT_EQ(TEST_HEAD_LEN + 5u, frame.size());
+    EXPECT_EQ(0, frame[0]) << "version";
+    EXPECT_EQ(0, frame[5]) << "query";
+    EXPECT_EQ(0, frame[6]) << "flag";
+    EXPECT_EQ(1, frame[7]) << "time type";
+    EXPECT_EQ(0, memcmp(&frame[8], time, 4));
+
+    // without a time stamp the head ends after the flag
+    frame = encode(sg_switch_dps, 1, NULL, 0, 0);
+    EXPECT_EQ(7u + 5u, frame.size());
+}
+
+TEST_F(BleDpTest, SameTlvsAsKlvList)
+{
+    expect_same_tlvs(sg_switch_dps, CNTSOF(sg_switch_dps));
+    expect_same_tlvs(sg_sensor_dps, CNTSOF(sg_sensor_dps));
+    expect_same_tlvs(sg_config_dps, CNTSOF(sg_config_dps));
+}
+
+TEST_F(BleDpTest, DpidFilter)
+{
+    const uint8_t dpid[] = {8, 2, 5, 99};
+    std::vector<uint8_t> frame = encode(sg_sensor_dps, CNTSOF(sg_sensor_dps), dpid, sizeof(dpid), TEST_TIME_STAMP);
+    std::vector<uint8_t> tlvs = legacy_tlvs(sg_sensor_dps, CNTSOF(sg_sensor_dps), dpid, sizeof(dpid));
+
+    // report order follows the DPs, not the id list
+    ASSERT_EQ(TEST_HEAD_LEN + tlvs.size(), frame.size());
+    EXPECT_EQ(2, frame[TEST_HEAD_LEN]);
+    EXPECT_EQ(0, memcmp(&frame[TEST_HEAD_LEN], tlvs.data(), tlvs.size()));
+
+    // no id selected leaves the bare head
+    frame = encode(sg_sensor_dps, CNTSOF(sg_sensor_dps), &dpid[3], 1, TEST_TIME_STAMP);
+    EXPECT_EQ((size_t)TEST_HEAD_LEN, frame.size());
+}
+
+TEST_F(BleDpTest, BufferNotEnough)
+{
+    std::vector<uint8_t> full = encode(sg_config_dps, CNTSOF(sg_config_dps), NULL, 0, TEST_TIME_STAMP);
+
+    for (uint32_t size = 0; size < full.size(); size++) {
+        std::vector<uint8_t> buf(size + 16, TEST_GUARD);
+        uint32_t len = 0;
+
+        ASSERT_EQ(OPRT_BUFFER_NOT_ENOUGH, tuya_ble_dp_obj_encode(sg_config_dps, CNTSOF(sg_config_dps), NULL, 0,
+                                                                 TEST_TIME_STAMP, buf.data(), size, &len))
+            << "size " << size;
+        ASSERT_EQ(full.size(), len) << "size " << size;
+        // nothing is written past the given size
+        for (uint32_t i = size; i < buf.size(); i++) {
+            ASSERT_EQ(TEST_GUARD, buf[i]) << "size " << size << " byte " << i;
+        }
+    }
+}
+
+TEST_F(BleDpTest, InvalidParam)
+{
+    uint8_t buf[32];
+    uint32_t len = 0;
+
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_ble_dp_obj_encode(NULL, 1, NULL, 0, 0, buf, sizeof(buf), &len));
+    EXPECT_EQ(OPRT_INVALID_PARM, tuya_ble_dp_obj_encode(sg_switch_dps, 1, NULL, 0, 0, buf, sizeof(buf), NULL));
+}
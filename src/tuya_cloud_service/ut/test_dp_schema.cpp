@@ -0,0 +1,223 @@
+/**
+ * @file test_dp_schema.cpp
+ * @brief Unit tests of the DP schema indexes and of report validation.
+ *
+ * The devid and DP id lookups are checked against scans of the registered
+ * schemas and of schema->node[], the lookups they replaced.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "dp_schema.h"
+
+#define TEST_DEV_NUM   64 // devids the registry churns through, power of 2
+#define TEST_DEVID_FMT "6c8f1a2b3c4d5e%04dsub"
+
+// a DP of every property type, ids out of order and spread over 1..255
+static const char sg_schema_json[] =
+    "[{\"id\":20,\"mode\":\"rw\",\"type\":\"obj\",\"property\":{\"type\":\"bool\"}},"
+    "{\"id\":3,\"mode\":\"rw\",\"type\":\"obj\",\"property\":"
+    "{\"type\":\"value\",\"min\":-20,\"max\":100,\"step\":1,\"scale\":0}},"
+    "{\"id\":250,\"mode\":\"ro\",\"type\":\"obj\",\"property\":"
+    "{\"type\":\"value\",\"min\":0,\"max\":1000,\"step\":5,\"scale\":1}},"
+    "{\"id\":101,\"mode\":\"rw\",\"type\":\"obj\",\"property\":"
+    "{\"type\":\"enum\",\"range\":[\"low\",\"middle\",\"high\"]}},"
+    "{\"id\":7,\"mode\":\"rw\",\"type\":\"obj\",\"property\":{\"type\":\"string\",\"maxlen\":8}},"
+    "{\"id\":55,\"mode\":\"ro\",\"type\":\"obj\",\"property\":"
+    "{\"type\":\"bitmap\",\"label\":[\"a\",\"b\",\"c\"],\"maxlen\":3}},"
+    "{\"id\":9,\"mode\":\"wr\",\"type\":\"obj\",\"property\":{\"type\":\"bool\"}},"
+    "{\"id\":1,\"mode\":\"rw\",\"type\":\"raw\",\"property\":{\"type\":\"raw\"}}]";
+
+static dp_node_t *node_find_scan(dp_schema_t *schema, int id)
+{
+    for (int i = 0; i < schema->num; i++) {
+        if (schema->node[i].desc.id == id) {
+            return &schema->node[i];
+        }
+    }
+    return NULL;
+}
+
+class DpSchemaTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        json.assign(sg_schema_json, sg_schema_json + sizeof(sg_schema_json));
+        dpvalid = (dp_rept_valid_t *)calloc(1, sizeof(dp_rept_valid_t) + 16);
+    }
+
+    void TearDown() override
+    {
+        for (auto &devid : registered) {
+            dp_schema_delete(&devid[0]);
+        }
+        free(dpvalid);
+    }
+
+    std::string devid_of(int i)
+    {
+        char devid[DEV_ID_LEN + 1];
+
+        snprintf(devid, sizeof(devid), TEST_DEVID_FMT, i);
+        return devid;
+    }
+
+    dp_schema_t *create(const std::string &devid)
+    {
+        std::string id = devid;
+        dp_schema_t *schema = NULL;
+
+        if (OPRT_OK != dp_schema_create(&id[0], json.data(), &schema)) {
+            return NULL;
+        }
+        EXPECT_EQ(schema, dp_schema_find(devid.c_str())) << devid;
+        registered.push_back(devid);
+        return schema;
+    }
+
+    void remove(const std::string &devid)
+    {
+        std::string id = devid;
+
+        dp_schema_delete(&id[0]);
+        for (auto it = registered.begin(); it != registered.end(); it++) {
+            if (*it == devid) {
+                registered.erase(it);
+                break;
+            }
+        }
+    }
+
+    int validate(dp_schema_t *schema, dp_obj_t *dps, uint8_t cnt, uint32_t flags)
+    {
+        dp_rept_in_t dpin = {.rept_type = T_OBJ_REPT, .flags = flags, .dp = NULL, .dpscnt = cnt, .dps = dps};
+
+        memset(dpvalid, 0, sizeof(dp_rept_valid_t));
+        return dp_rept_valid_check(schema, &dpin, dpvalid);
+    }
+
+    std::vector<char> json;
+    std::vector<std::string> registered;
+    dp_rept_valid_t *dpvalid = NULL;
+};
+
+TEST_F(DpSchemaTest, NodeFindMatchesScan)
+{
+    dp_schema_t *schema = create(devid_of(0));
+
+    ASSERT_NE(nullptr, schema);
+    ASSERT_EQ(8, schema->num);
+    for (int id = -2; id <= 300; id++) {
+        ASSERT_EQ(node_find_scan(schema, id), dp_node_find(schema, id)) << "id " << id;
+    }
+}
+
+TEST_F(DpSchemaTest, SchemaFindMatchesScan)
+{
+    std::vector<std::string> all;
+    uint32_t seed = 1;
+
+    for (int i = 0; i < TEST_DEV_NUM; i++) {
+        all.push_back(devid_of(i));
+    }
+
+    // register, then delete and re-add in a pseudo random order, so deletions
+    // shift back probe chains of the devid index
+    for (int round = 0; round < 4 * TEST_DEV_NUM; round++) {
+        const std::string &devid = all[(seed = seed * 1103515245 + 12345) >> 16 & (TEST_DEV_NUM - 1)];
+        bool known = false;
+
+        for (auto &r : registered) {
+            known |= (r == devid);
+        }
+        // a schema beyond DP_SCHEMA_NUM_MAX of the build would not be registered
+        if (known) {
+            remove(devid);
+        } else if (registered.size() < DP_SCHEMA_NUM_MAX) {
+            ASSERT_NE(nullptr, create(devid)) << "round " << round;
+        }
+
+        for (auto &d : all) {
+            dp_schema_t *expect = NULL;
+
+            for (auto &r : registered) {
+                if (r == d) {
+                    expect = dp_schema_find(r.c_str());
+                    ASSERT_NE(nullptr, expect) << "round " << round << " " << d;
+                    ASSERT_STREQ(d.c_str(), expect->devid);
+                }
+            }
+            ASSERT_EQ(expect, dp_schema_find(d.c_str())) << "round " << round << " " << d;
+        }
+    }
+}
+
+TEST_F(DpSchemaTest, ReportAccepted)
+{
+    dp_schema_t *schema = create(devid_of(0));
+    dp_obj_t dps[6];
+
+    ASSERT_NE(nullptr, schema);
+    memset(dps, 0, sizeof(dps));
+    dps[0].id = 20, dps[0].type = PROP_BOOL, dps[0].value.dp_bool = true;
+    dps[1].id = 3, dps[1].type = PROP_VALUE, dps[1].value.dp_value = -20;
+    dps[2].id = 250, dps[2].type = PROP_VALUE, dps[2].value.dp_value = 995;
+    dps[3].id = 101, dps[3].type = PROP_ENUM, dps[3].value.dp_enum = 2;
+    dps[4].id = 7, dps[4].type = PROP_STR, dps[4].value.dp_str = (char *)"12345678";
+    dps[5].id = 55, dps[5].type = PROP_BITMAP, dps[5].value.dp_bitmap = 0x7;
+
+    ASSERT_EQ(OPRT_OK, validate(schema, dps, 6, DP_REPT_NO_FILTER_FLAG));
+    ASSERT_EQ(6, dpvalid->num);
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(dps[i].id, dpvalid->dpid[i]);
+    }
+    EXPECT_EQ(schema, dpvalid->schema);
+
+    // once uploaded, the same values again are filtered out unless forced
+    for (int i = 0; i < 6; i++) {
+        dp_pv_stat_set(schema, dps[i].id, PV_STAT_CLOUD);
+    }
+    EXPECT_EQ(OPRT_SVC_DP_ID_NOT_FOUND, validate(schema, dps, 6, 0));
+    dps[1].value.dp_value = 100;
+    ASSERT_EQ(OPRT_OK, validate(schema, dps, 6, 0));
+    ASSERT_EQ(1, dpvalid->num);
+    EXPECT_EQ(3, dpvalid->dpid[0]);
+}
+
+TEST_F(DpSchemaTest, ReportRejected)
+{
+    dp_schema_t *schema = create(devid_of(0));
+    dp_obj_t dps[8];
+
+    ASSERT_NE(nullptr, schema);
+    memset(dps, 0, sizeof(dps));
+    dps[0].id = 3, dps[0].type = PROP_VALUE, dps[0].value.dp_value = 101;       // above max
+    dps[1].id = 3, dps[1].type = PROP_VALUE, dps[1].value.dp_value = -21;       // below min
+    dps[2].id = 250, dps[2].type = PROP_VALUE, dps[2].value.dp_value = 12;      // off step
+    dps[3].id = 7, dps[3].type = PROP_STR, dps[3].value.dp_str = (char *)"123456789"; // too long
+    dps[4].id = 55, dps[4].type = PROP_BITMAP, dps[4].value.dp_bitmap = 0x8;    // beyond maxlen bits
+    dps[5].id = 9, dps[5].type = PROP_BOOL, dps[5].value.dp_bool = true;        // write only
+    dps[6].id = 200, dps[6].type = PROP_BOOL, dps[6].value.dp_bool = true;      // not in the schema
+    dps[7].id = 20, dps[7].type = PROP_BOOL, dps[7].value.dp_bool = true;       // the only valid one
+
+    ASSERT_EQ(OPRT_OK, validate(schema, dps, 8, DP_REPT_NO_FILTER_FLAG));
+    ASSERT_EQ(1, dpvalid->num);
+    EXPECT_EQ(20, dpvalid->dpid[0]);
+
+    EXPECT_EQ(OPRT_SVC_DP_ID_NOT_FOUND, validate(schema, dps, 7, DP_REPT_NO_FILTER_FLAG));
+
+    // a type other than the schema's fails the whole report
+    dps[0].id = 101, dps[0].type = PROP_VALUE, dps[0].value.dp_value = 1;
+    EXPECT_EQ(OPRT_SVC_DP_TP_NOT_MATCH, validate(schema, dps, 8, DP_REPT_NO_FILTER_FLAG));
+}
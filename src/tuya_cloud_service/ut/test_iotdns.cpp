@@ -0,0 +1,407 @@
+/**
+ * @file test_iotdns.cpp
+ * @brief Unit tests of the IoT DNS endpoint and certificate cache against a
+ * local IoT DNS stand-in.
+ *
+ * The requests to the register center are redirected to a plain HTTP
+ * stand-in on 127.0.0.1 through tuya_iotdns_http_port_register, so the cold
+ * path still goes through the HTTP client. The cold and cached query times
+ * are recorded as test properties.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tuya_config_defaults.h"
+#include "tal_kv.h"
+#include "tal_memory.h"
+#include "tal_time_service.h"
+#include "iotdns.h"
+
+#define TEST_HOST        "127.0.0.1"
+#define TEST_CERT_HOST   "m1.tuyacn.com"
+#define TEST_CERT_PORT   8883
+#define TEST_REGION      "AY"
+#define TEST_ENV         "prod"
+#define TEST_POSIX       1700000000
+#define TEST_LATENCY_MS  50 // round trip of the stand-in, the cached path makes none
+#define TEST_TIMEOUT_MS  3000
+#define TEST_CERT_A      "cert-a"
+#define TEST_CERT_A_B64  "Y2VydC1h"
+#define TEST_CERT_B      "cert-b"
+#define TEST_CERT_B_B64  "Y2VydC1i"
+
+#define TEST_ENDPOINT_FMT                                                                                              \
+    "{\"httpsSelfUrl\":{\"addr\":\"https://a1.tuyacn.com/d.json\"},"                                                   \
+    "\"mqttsSelfUrl\":{\"addr\":\"" TEST_CERT_HOST ":8883\"},\"caArr\":[\"%s\"]}"
+
+// declared the same way by tuya_endpoint.c
+extern "C" int iotdns_cloud_endpoint_get(const char *region, const char *env, tuya_endpoint_t *endpoint);
+
+/**
+ * @brief Minimal IoT DNS service, one HTTP/1.1 request per connection
+ */
+class IotdnsStandIn {
+  public:
+    ~IotdnsStandIn()
+    {
+        stop();
+    }
+
+    /* Takes a free port and leaves it closed, so a request is refused */
+    uint16_t reserve()
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr(TEST_HOST);
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        getsockname(fd, (struct sockaddr *)&addr, &len);
+        close(fd);
+        port = ntohs(addr.sin_port);
+        return port;
+    }
+
+    bool start()
+    {
+        int on = 1;
+        struct sockaddr_in addr = {};
+
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr(TEST_HOST);
+        addr.sin_port = htons(port);
+        if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 4) < 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        running = true;
+        worker = std::thread(&IotdnsStandIn::serve, this);
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+
+    /* Certificate of the following answers, base64 encoded */
+    void set_cert(const char *b64)
+    {
+        std::lock_guard<std::mutex> lock(cert_lock);
+        cert_b64 = b64;
+    }
+
+    uint16_t port = 0;
+    std::atomic<int> requests{0};
+
+  private:
+    bool wait_readable(int fd)
+    {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+
+        while (running) {
+            if (poll(&pfd, 1, 50) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Reads the head and the body of one request */
+    bool read_request(int fd, std::string &path)
+    {
+        std::string req;
+        size_t head_end = std::string::npos;
+        size_t body_len = 0;
+        char buf[512];
+
+        while (std::string::npos == head_end || req.size() < head_end + 4 + body_len) {
+            if (!wait_readable(fd)) {
+                return false;
+            }
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                return false;
+            }
+            req.append(buf, n);
+            if (std::string::npos == head_end && std::string::npos != (head_end = req.find("\r\n\r\n"))) {
+                size_t cl = req.find("Content-Length:");
+                body_len = (cl < head_end) ? strtoul(req.c_str() + cl + 15, NULL, 10) : 0;
+            }
+        }
+        path = req.substr(req.find(' ') + 1, req.find(' ', req.find(' ') + 1) - req.find(' ') - 1);
+        return true;
+    }
+
+    void session(int fd)
+    {
+        std::string path, body;
+        char json[256];
+
+        if (!read_request(fd, path)) {
+            close(fd);
+            return;
+        }
+        requests++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(TEST_LATENCY_MS));
+
+        std::lock_guard<std::mutex> lock(cert_lock);
+        if (path == "/v2/url_config") {
+            snprintf(json, sizeof(json), TEST_ENDPOINT_FMT, cert_b64.c_str());
+        } else {
+            snprintf(json, sizeof(json), "[{\"host\":\"" TEST_CERT_HOST "\",\"ca\":\"%s\"}]", cert_b64.c_str());
+        }
+        body = json;
+        std::string rsp = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                          std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        send(fd, rsp.data(), rsp.size(), MSG_NOSIGNAL);
+        close(fd);
+    }
+
+    void serve()
+    {
+        while (wait_readable(listen_fd)) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                session(fd);
+            }
+        }
+    }
+
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread worker;
+    std::mutex cert_lock;
+    std::string cert_b64 = TEST_CERT_A_B64;
+};
+
+static IotdnsStandIn *sg_standin = NULL;
+
+/* Sends the register center request to the stand-in, over plain HTTP */
+static http_client_status_t __standin_request(const http_client_request_t *request, http_client_response_t *response)
+{
+    http_client_request_t local = *request;
+
+    local.host = TEST_HOST;
+    local.port = sg_standin->port;
+    local.cacert = NULL;
+    local.cacert_len = 0;
+    return http_client_request(&local, response);
+}
+
+class IotdnsTest : public ::testing::Test {
+  protected:
+    static void SetUpTestCase()
+    {
+        tal_kv_cfg_t kv_cfg = {.seed = "vmlkasdh93dlvlcy", .key = "dflfuap134ddlduq"};
+
+        tal_kv_init(&kv_cfg);
+        tal_time_service_init();
+        tuya_iotdns_cache_init();
+        tuya_iotdns_http_port_register(__standin_request);
+    }
+
+    static void TearDownTestCase()
+    {
+        tuya_iotdns_http_port_register(NULL);
+    }
+
+    void SetUp() override
+    {
+        // the cache ages entries on the synced clock
+        tal_time_set_posix(TEST_POSIX, 1);
+        sg_standin = &standin;
+        ASSERT_NE(0, standin.reserve());
+        ASSERT_TRUE(standin.start());
+
+        // loads the KV copies an earlier run may have left, then drops them
+        std::string cert;
+        tuya_endpoint_t endpoint = {};
+        ASSERT_EQ(OPRT_OK, query_cert(cert));
+        ASSERT_EQ(OPRT_OK, iotdns_cloud_endpoint_get(TEST_REGION, TEST_ENV, &endpoint));
+        tal_free(endpoint.cert);
+        ASSERT_EQ(OPRT_OK, tuya_iotdns_cache_clear(TRUE));
+        standin.requests = 0;
+    }
+
+    void TearDown() override
+    {
+        standin.stop();
+        tuya_iotdns_cache_clear(TRUE);
+        sg_standin = NULL;
+    }
+
+    int query_cert(std::string &cert)
+    {
+        uint8_t *cacert = NULL;
+        uint16_t cacert_len = 0;
+
+        int rt = tuya_iotdns_query_host_certs((char *)TEST_CERT_HOST, TEST_CERT_PORT, &cacert, &cacert_len);
+        if (OPRT_OK == rt) {
+            cert.assign((const char *)cacert, cacert_len);
+            tal_free(cacert);
+        }
+        return rt;
+    }
+
+    int64_t timed_query_cert(std::string &cert)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        EXPECT_EQ(OPRT_OK, query_cert(cert));
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin)
+            .count();
+    }
+
+    /* Waits for the background refresh to bring in the expected certificate */
+    bool wait_cert(const char *expect)
+    {
+        std::string cert;
+
+        for (int waited = 0; waited < TEST_TIMEOUT_MS; waited += 10) {
+            if (OPRT_OK == query_cert(cert) && cert == expect) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    IotdnsStandIn standin;
+};
+
+TEST_F(IotdnsTest, ColdThenCached)
+{
+    std::string cert;
+
+    int64_t cold_ms = timed_query_cert(cert);
+    EXPECT_EQ(TEST_CERT_A, cert);
+    EXPECT_EQ(1, standin.requests.load());
+    EXPECT_GE(cold_ms, TEST_LATENCY_MS);
+
+    // served from RAM without a request
+    int64_t ram_ms = timed_query_cert(cert);
+    EXPECT_EQ(TEST_CERT_A, cert);
+    EXPECT_EQ(1, standin.requests.load());
+    EXPECT_LT(ram_ms, TEST_LATENCY_MS);
+
+    // after a reboot the KV copy is served without a request
+    ASSERT_EQ(OPRT_OK, tuya_iotdns_cache_clear(FALSE));
+    int64_t kv_ms = timed_query_cert(cert);
+    EXPECT_EQ(TEST_CERT_A, cert);
+    EXPECT_EQ(1, standin.requests.load());
+    EXPECT_LT(kv_ms, TEST_LATENCY_MS);
+
+    // without the KV copy the next query is cold again
+    ASSERT_EQ(OPRT_OK, tuya_iotdns_cache_clear(TRUE));
+    timed_query_cert(cert);
+    EXPECT_EQ(2, standin.requests.load());
+
+    RecordProperty("cold_ms", (int)cold_ms);
+    RecordProperty("ram_ms", (int)ram_ms);
+    RecordProperty("kv_ms", (int)kv_ms);
+}
+
+TEST_F(IotdnsTest, StaleServedThenRefreshed)
+{
+    std::string cert;
+
+    ASSERT_EQ(OPRT_OK, query_cert(cert));
+    standin.set_cert(TEST_CERT_B_B64);
+
+    // past the TTL the old certificate is returned at once
+    tal_time_set_posix(TEST_POSIX + IOTDNS_CACHE_TTL + 1, 1);
+    int64_t stale_ms = timed_query_cert(cert);
+    EXPECT_EQ(TEST_CERT_A, cert);
+    EXPECT_LT(stale_ms, TEST_LATENCY_MS);
+
+    // and replaced by the background refresh
+    ASSERT_TRUE(wait_cert(TEST_CERT_B));
+    EXPECT_EQ(2, standin.requests.load());
+    RecordProperty("stale_ms", (int)stale_ms);
+}
+
+TEST_F(IotdnsTest, ExpiredFetchedAgain)
+{
+    std::string cert;
+
+    ASSERT_EQ(OPRT_OK, query_cert(cert));
+    standin.set_cert(TEST_CERT_B_B64);
+
+    // past the stale limit the query waits for the service
+    tal_time_set_posix(TEST_POSIX + IOTDNS_CACHE_TTL + IOTDNS_CACHE_MAX_STALE + 1, 1);
+    int64_t expired_ms = timed_query_cert(cert);
+    EXPECT_EQ(TEST_CERT_B, cert);
+    EXPECT_EQ(2, standin.requests.load());
+    EXPECT_GE(expired_ms, TEST_LATENCY_MS);
+}
+
+TEST_F(IotdnsTest, ExpiredUsedWhenServiceDown)
+{
+    std::string cert;
+
+    ASSERT_EQ(OPRT_OK, query_cert(cert));
+    standin.stop();
+
+    tal_time_set_posix(TEST_POSIX + IOTDNS_CACHE_TTL + IOTDNS_CACHE_MAX_STALE + 1, 1);
+    EXPECT_EQ(OPRT_OK, query_cert(cert));
+    EXPECT_EQ(TEST_CERT_A, cert);
+    EXPECT_EQ(1, standin.requests.load());
+}
+
+TEST_F(IotdnsTest, ServiceDownWithoutCache)
+{
+    std::string cert;
+
+    standin.stop();
+    EXPECT_NE(OPRT_OK, query_cert(cert));
+}
+
+TEST_F(IotdnsTest, EndpointCached)
+{
+    tuya_endpoint_t endpoint;
+
+    for (int round = 0; round < 2; round++) {
+        memset(&endpoint, 0, sizeof(endpoint));
+        ASSERT_EQ(OPRT_OK, iotdns_cloud_endpoint_get(TEST_REGION, TEST_ENV, &endpoint)) << "round " << round;
+        EXPECT_STREQ("a1.tuyacn.com", endpoint.atop.host) << "round " << round;
+        EXPECT_STREQ("/d.json", endpoint.atop.path) << "round " << round;
+        EXPECT_EQ(443, endpoint.atop.port) << "round " << round;
+        EXPECT_STREQ(TEST_CERT_HOST, endpoint.mqtt.host) << "round " << round;
+        EXPECT_EQ(8883, endpoint.mqtt.port) << "round " << round;
+        EXPECT_STREQ(TEST_REGION, endpoint.region) << "round " << round;
+        ASSERT_EQ(strlen(TEST_CERT_A), endpoint.cert_len) << "round " << round;
+        EXPECT_EQ(0, memcmp(TEST_CERT_A, endpoint.cert, endpoint.cert_len)) << "round " << round;
+        tal_free(endpoint.cert);
+    }
+    EXPECT_EQ(1, standin.requests.load());
+}
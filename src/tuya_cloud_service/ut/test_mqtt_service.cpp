@@ -0,0 +1,267 @@
+/**
+ * @file test_mqtt_service.cpp
+ * @brief Unit tests of the MQTT service connection and its retry back-off
+ * against a local broker stand-in.
+ *
+ * The stand-in listens on 127.0.0.1 and answers CONNECT, SUBSCRIBE,
+ * UNSUBSCRIBE and PINGREQ, which is all the service needs to go online and
+ * to stop. The time to online of each case is recorded as a test property.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "tuya_cloud_types.h"
+#include "tuya_config_defaults.h"
+#include "mqtt_service.h"
+
+#define TEST_HOST       "127.0.0.1"
+#define TEST_UUID       "uuid0123456789ab"
+#define TEST_AUTHKEY    "0123456789abcdef0123456789abcdef"
+#define TEST_TIMEOUT_MS 3000
+#define TEST_ONLINE_MS  1000 // a local broker answers well within this
+
+/**
+ * @brief Minimal MQTT 3.1.1 broker, one client at a time
+ */
+class BrokerStandIn {
+  public:
+    ~BrokerStandIn()
+    {
+        stop();
+    }
+
+    /* Takes a free port and leaves it closed, so a connect is refused */
+    uint16_t reserve()
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr(TEST_HOST);
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        getsockname(fd, (struct sockaddr *)&addr, &len);
+        close(fd);
+        port = ntohs(addr.sin_port);
+        return port;
+    }
+
+    bool start()
+    {
+        int on = 1;
+        struct sockaddr_in addr = {};
+
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = inet_addr(TEST_HOST);
+        addr.sin_port = htons(port);
+        if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 1) < 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        running = true;
+        worker = std::thread(&BrokerStandIn::serve, this);
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+
+    uint16_t port = 0;
+    std::atomic<int> connects{0};
+
+  private:
+    bool wait_readable(int fd)
+    {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+
+        while (running) {
+            if (poll(&pfd, 1, 50) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool read_all(int fd, uint8_t *buf, size_t len)
+    {
+        for (size_t got = 0; got < len;) {
+            if (!wait_readable(fd)) {
+                return false;
+            }
+            ssize_t n = recv(fd, buf + got, len - got, 0);
+            if (n <= 0) {
+                return false;
+            }
+            got += n;
+        }
+        return true;
+    }
+
+    /* Answers the packets of one client until it disconnects */
+    void session(int fd)
+    {
+        uint8_t type;
+        std::string body;
+
+        while (read_all(fd, &type, 1)) {
+            uint32_t remain = 0;
+            uint8_t byte;
+
+            for (int shift = 0; read_all(fd, &byte, 1); shift += 7) {
+                remain |= (byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+            body.resize(remain);
+            if (remain && !read_all(fd, (uint8_t *)&body[0], remain)) {
+                break;
+            }
+
+            if (type == 0x10) { // CONNECT
+                const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                connects++;
+                send(fd, connack, sizeof(connack), 0);
+            } else if (type == 0x82 && remain >= 2) { // SUBSCRIBE
+                const uint8_t suback[] = {0x90, 0x03, (uint8_t)body[0], (uint8_t)body[1], 0x01};
+                send(fd, suback, sizeof(suback), 0);
+            } else if (type == 0xa2 && remain >= 2) { // UNSUBSCRIBE
+                const uint8_t unsuback[] = {0xb0, 0x02, (uint8_t)body[0], (uint8_t)body[1]};
+                send(fd, unsuback, sizeof(unsuback), 0);
+            } else if (type == 0xc0) { // PINGREQ
+                const uint8_t pingresp[] = {0xd0, 0x00};
+                send(fd, pingresp, sizeof(pingresp), 0);
+            } else if (type == 0xe0) { // DISCONNECT
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    void serve()
+    {
+        while (wait_readable(listen_fd)) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                session(fd);
+            }
+        }
+    }
+
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+class MqttServiceTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        tuya_mqtt_config_t config;
+
+        port = broker.reserve();
+        ASSERT_NE(0, port);
+        // no CA certificate, the client connects over plain TCP
+        memset(&config, 0, sizeof(config));
+        config.host = TEST_HOST;
+        config.port = port;
+        config.timeout = TEST_TIMEOUT_MS;
+        config.uuid = TEST_UUID;
+        config.authkey = TEST_AUTHKEY;
+        memset(&mqctx, 0, sizeof(mqctx));
+        ASSERT_EQ(OPRT_OK, tuya_mqtt_init(&mqctx, &config));
+    }
+
+    void TearDown() override
+    {
+        if (tuya_mqtt_connected(&mqctx)) {
+            tuya_mqtt_stop(&mqctx);
+        }
+        tuya_mqtt_destory(&mqctx);
+        broker.stop();
+    }
+
+    static int64_t elapsed_ms(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since)
+            .count();
+    }
+
+    BrokerStandIn broker;
+    tuya_mqtt_context_t mqctx;
+    uint16_t port = 0;
+};
+
+TEST_F(MqttServiceTest, TimeToOnline)
+{
+    ASSERT_TRUE(broker.start());
+
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_EQ(OPRT_OK, tuya_mqtt_start(&mqctx));
+    int64_t online_ms = elapsed_ms(begin);
+
+    EXPECT_TRUE(tuya_mqtt_connected(&mqctx));
+    EXPECT_EQ(0, mqctx.retry_backoff_ms);
+    EXPECT_EQ(1, broker.connects.load());
+    EXPECT_LT(online_ms, TEST_ONLINE_MS);
+    RecordProperty("time_to_online_ms", (int)online_ms);
+}
+
+TEST_F(MqttServiceTest, FailedStartDoesNotSleep)
+{
+    // nothing listens on the port, the connect is refused at once
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_EQ(OPRT_COM_ERROR, tuya_mqtt_start(&mqctx));
+    int64_t fail_ms = elapsed_ms(begin);
+
+    EXPECT_FALSE(tuya_mqtt_connected(&mqctx));
+    EXPECT_LT(fail_ms, (int64_t)MQTT_CONNECT_RETRY_MIN_DELAY_MS) << "start slept on failure";
+    EXPECT_LE(mqctx.retry_backoff_ms, MQTT_CONNECT_RETRY_MAX_DELAY_MS);
+}
+
+TEST_F(MqttServiceTest, TimeToOnlineAfterBrokerUp)
+{
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_EQ(OPRT_COM_ERROR, tuya_mqtt_start(&mqctx));
+    uint16_t backoff_ms = mqctx.retry_backoff_ms;
+
+    // the broker comes up while the caller waits out the back-off
+    ASSERT_TRUE(broker.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+    ASSERT_EQ(OPRT_OK, tuya_mqtt_start(&mqctx));
+    int64_t online_ms = elapsed_ms(begin);
+
+    EXPECT_TRUE(tuya_mqtt_connected(&mqctx));
+    EXPECT_EQ(0, mqctx.retry_backoff_ms);
+    EXPECT_LT(online_ms, backoff_ms + TEST_ONLINE_MS);
+    RecordProperty("retry_backoff_ms", backoff_ms);
+    RecordProperty("time_to_online_ms", (int)online_ms);
+}
@@ -25,6 +25,8 @@ extern "C" {
 #define TUYA_P2P_SESSION_NUMBER_MAX 1024
 #define TUYA_P2P_VIDEO_BITRATE_MIN  (600)
 #define TUYA_P2P_VIDEO_BITRATE_MAX  (4000)
+#define TUYA_P2P_SEGMENT_DATA_LEN   (1200) // data carried by one send buffer segment
+#define TUYA_P2P_SEGMENT_SIZE       (1600) // send buffer space one segment occupies
 
 #define TUYA_P2P_ERROR_SUCCESSFUL                         0
 #define TUYA_P2P_ERROR_NOT_INITIALIZED                    -1
@@ -416,9 +418,11 @@ void tuya_p2p_rtc_notify_exit();
 // Check the current send/receive buffer status of a connection:
 // handle: connection handle
 // channel_id: channel number
-// write_size: after function returns, updated to current bytes written to send buffer but not sent successfully
+// write_size: after function returns, updated to send buffer space taken by data not acknowledged yet
 // read_size: after function returns, updated to current bytes received successfully but not read by application layer
 // send_free_size: after function returns, updated to remaining space in send buffer
+// The send buffer is counted in segments of TUYA_P2P_SEGMENT_SIZE, each tuya_p2p_rtc_send_data call takes one
+// segment per TUYA_P2P_SEGMENT_DATA_LEN bytes of data
 // return value: undefined
 int32_t tuya_p2p_rtc_check_buffer(int32_t handle, uint32_t channel_id, uint32_t *write_size, uint32_t *read_size,
                                   uint32_t *send_free_size);
@@ -1492,8 +1492,8 @@ int tuya_p2p_rtc_channels_init(tuya_p2p_rtc_session_t *rtc)
         }
 
         ikcp_setoutput(chan->kcp, on_kcp_output);
-        ikcp_wndsize(chan->kcp, send_buf_size / 1600  /*TUYA_MBUF_HUGE_SIZE*/,
-                     recv_buf_size / 1600 /*TUYA_MBUF_HUGE_SIZE*/);
+        ikcp_wndsize(chan->kcp, send_buf_size / TUYA_P2P_SEGMENT_SIZE /*TUYA_MBUF_HUGE_SIZE*/,
+                     recv_buf_size / TUYA_P2P_SEGMENT_SIZE /*TUYA_MBUF_HUGE_SIZE*/);
         ikcp_nodelay(chan->kcp, 0, 10, 20, 1);
         ikcp_setmtu(chan->kcp, 1400);
         ikcp_setprocesspkt(chan->kcp, ctx_session_channel_process_pkt);
@@ -1608,7 +1608,7 @@ int32_t tuya_p2p_rtc_dosend_data(tuya_p2p_rtc_session_t *rtc, uint32_t channel_i
         //     continue;
         // }
 
-        int fragement_len = 1200;
+        int fragement_len = TUYA_P2P_SEGMENT_DATA_LEN;
         int current = (remain > fragement_len) ? (fragement_len) : remain;
         char decrypted[1500];
         char *encrypted;
@@ -1861,14 +1861,18 @@ int32_t tuya_p2p_rtc_check_buffer(int32_t handle, uint32_t channel_id, uint32_t
     pthread_mutex_lock(&rtc->channel_lock);
     if (rtc->channels != NULL) {
         rtc_channel_t *chan = &rtc->channels[channel_id];
-        // if (write_size != NULL) {
-        //     *write_size = tuya_mbuf_queue_get_used_size(chan->send_queue);
-        // }
+        /* kcp queues every segment sent, the window is what the buffer was sized for */
+        int waitsnd = ikcp_waitsnd(chan->kcp);
+        int freesnd = (int)chan->kcp->snd_wnd - waitsnd;
+        if (write_size != NULL) {
+            *write_size = waitsnd * TUYA_P2P_SEGMENT_SIZE /*tuya_mbuf_queue_get_used_size(chan->send_queue)*/;
+        }
         // if (read_size != NULL) {
         //     *read_size = tuya_mbuf_queue_get_used_size(chan->recv_queue);
         // }
         if (send_free_size != NULL) {
-            *send_free_size = 160 * 1024 /*tuya_mbuf_queue_get_free_size(chan->send_queue)*/;
+            *send_free_size = (freesnd > 0 ? freesnd : 0) *
+                              TUYA_P2P_SEGMENT_SIZE /*tuya_mbuf_queue_get_free_size(chan->send_queue)*/;
         }
     } else {
         ret = TUYA_P2P_ERROR_INVALID_SESSION_HANDLE;
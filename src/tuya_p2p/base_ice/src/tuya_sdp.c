@@ -3,64 +3,93 @@
 #include "tuya_log.h"
 #include <string.h>
 
-#define SDP_TEMPLATE_PART_SESSION_HEADER                                                                               \
-    "v=0\r\n"                                                                                                          \
-    "o=- %lu 1 IN IP4 127.0.0.1\r\n"                                                                                   \
-    "s=-\r\n"                                                                                                          \
-    "t=0 0\r\n"                                                                                                        \
-    "a=group:BUNDLE%s\r\n"                                                                                             \
-    "a=msid-semantic: WMS %s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_HEADER "m=%s 9 %s%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_TRANSPORT                                                                              \
-    "c=IN IP4 0.0.0.0\r\n"                                                                                             \
-    "a=rtcp:9 IN IP4 0.0.0.0\r\n"                                                                                      \
-    "a=ice-ufrag:%s\r\n"                                                                                               \
-    "a=ice-pwd:%s\r\n"                                                                                                 \
-    "a=ice-options:trickle\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_TRANSPORT_CANDIDATE "%s"
-
-#define SDP_TEMPLATE_PART_MEDIA_DTLS                                                                                   \
-    "a=fingerprint:%s\r\n"                                                                                             \
-    "a=setup:%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_MID "a=mid:%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_DIRECTION "a=%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_MSID "a=msid:%s %s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_RTCP_MUX "a=rtcp-mux\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_SSRC "a=ssrc:%u cname:%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_SSRC_GROUP                                                                             \
-    "a=ssrc-group:FID %u %u\r\n"                                                                                       \
-    "a=ssrc:%u cname:%s\r\n"                                                                                           \
-    "a=ssrc:%u cname:%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_APPLICATION_RTPMAP "a=rtpmap:%d %s %d\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_AUDIO_RTPMAP "a=rtpmap:%d %s/%d\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPMAP "a=rtpmap:%d %s/%d\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_FIR "a=rtcp-fb:%d ccm fir\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_NACK "a=rtcp-fb:%d nack\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_PLI "a=rtcp-fb:%d nack pli\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_VIDEO_ATTR                                                                             \
-    "a=fmtp:%d level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=%s\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_RTX                                                                                    \
-    "a=rtpmap:%d rtx/%d\r\n"                                                                                           \
-    "a=fmtp:%d apt=%d\r\n"
-
-#define SDP_TEMPLATE_PART_MEDIA_APPLICATION_KEY "a=aes-key:%s\r\n"
+#define SDP_FNV_OFFSET_BASIS (0xcbf29ce484222325ULL)
+#define SDP_FNV_PRIME        (0x100000001b3ULL)
+
+#define SDP_MEDIA_AUDIO 0
+#define SDP_MEDIA_VIDEO 1
+#define SDP_MEDIA_TUYA  2
+
+#define SDP_BUNDLE_SIZE 64
+
+#define SDP_NEGO_CACHE_NUM 8
+
+// sdp text is written with the put helpers below, the literal parts of every line are copied as they are
+// and only the fields are formatted
+typedef struct {
+    char *buf;
+    int size;
+    int len; // -1 once the text did not fit
+} sdp_writer_t;
+
+#define SDP_PUT_LIT(w, s) tuya_p2p_rtc_sdp_put((w), (s), sizeof(s) - 1)
+
+// a negotiation result, as the position of the matching codecs in their lists
+typedef struct {
+    uint64_t local_hash;
+    uint64_t remote_hash;
+    uint32_t used;
+    int audio_local;
+    int audio_remote;
+    int video_local;
+    int video_remote;
+    int rtx_remote;
+} sdp_nego_cache_t;
+
+typedef struct {
+    rtc_audio_codec_t *audio_local;
+    rtc_audio_codec_t *audio_remote;
+    rtc_video_codec_t *video_local;
+    rtc_video_codec_t *video_remote;
+    rtc_video_codec_t *rtx_remote;
+} sdp_nego_t;
+
+typedef enum {
+    SDP_ATTR_MSID_SEMANTIC,
+    SDP_ATTR_MSID,
+    SDP_ATTR_GROUP,
+    SDP_ATTR_RTPMAP,
+    SDP_ATTR_FMTP,
+    SDP_ATTR_SSRC_GROUP,
+    SDP_ATTR_SSRC,
+    SDP_ATTR_MID,
+    SDP_ATTR_ICE_UFRAG,
+    SDP_ATTR_ICE_PWD,
+    SDP_ATTR_FINGERPRINT,
+    SDP_ATTR_AES_KEY,
+    SDP_ATTR_CANDIDATE,
+} sdp_attr_e;
+
+typedef struct {
+    const char *name;
+    int len;
+    sdp_attr_e attr;
+} sdp_attr_t;
+
+#define SDP_ATTR(name, attr) {name, sizeof(name) - 1, attr}
+
+// attributes the decoder reads, looked up by the name between "a=" and ':'
+static const sdp_attr_t sdp_attrs[] = {
+    SDP_ATTR("candidate", SDP_ATTR_CANDIDATE),
+    SDP_ATTR("ssrc", SDP_ATTR_SSRC),
+    SDP_ATTR("rtpmap", SDP_ATTR_RTPMAP),
+    SDP_ATTR("fmtp", SDP_ATTR_FMTP),
+    SDP_ATTR("ssrc-group", SDP_ATTR_SSRC_GROUP),
+    SDP_ATTR("mid", SDP_ATTR_MID),
+    SDP_ATTR("msid", SDP_ATTR_MSID),
+    SDP_ATTR("msid-semantic", SDP_ATTR_MSID_SEMANTIC),
+    SDP_ATTR("group", SDP_ATTR_GROUP),
+    SDP_ATTR("ice-ufrag", SDP_ATTR_ICE_UFRAG),
+    SDP_ATTR("ice-pwd", SDP_ATTR_ICE_PWD),
+    SDP_ATTR("fingerprint", SDP_ATTR_FINGERPRINT),
+    SDP_ATTR("aes-key", SDP_ATTR_AES_KEY),
+};
+
+static sdp_nego_cache_t sdp_nego_cache[SDP_NEGO_CACHE_NUM];
+static uint32_t sdp_nego_cache_used = 0;
+static uint32_t sdp_nego_cache_hit = 0;
+static uint32_t sdp_nego_cache_miss = 0;
+static pthread_mutex_t sdp_nego_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 
 rtc_audio_codec_t default_audio_rtpmaps[] = {{{NULL, NULL}, "PCMU", 0, 0, 8000, 1}};
 
@@ -101,484 +130,446 @@ static tuya_p2p_rtc_media_direction_e tuya_p2p_rtc_media_direction_number(char *
     return MEDIA_DIRECTION_NONE;
 }
 #endif
-static int tuya_p2p_rtc_sdp_encode_session(rtc_sdp_t *sdp, char *buf, int size)
+
+static uint64_t tuya_p2p_rtc_sdp_hash(uint64_t hash, const void *data, int len)
 {
-    int ret;
-    int index = 0;
-    char bundle[64] = {0};
-    QUEUE *q;
-    QUEUE_FOREACH(q, &sdp->media_info_list.queue)
-    {
-        media_info_t *info = QUEUE_DATA(q, media_info_t, queue);
-        ret = snprintf(bundle + index, sizeof(bundle) - index, " %s", info->mid);
-        if (ret < 0 || ret >= (int)sizeof(bundle) - index) {
-            return -1;
-        }
-        index += ret;
+    const unsigned char *p = (const unsigned char *)data;
+    int i;
+    for (i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= SDP_FNV_PRIME;
     }
+    return hash;
+}
 
-    ret = snprintf(buf, size, SDP_TEMPLATE_PART_SESSION_HEADER, (unsigned long)time(NULL), bundle, sdp->wms_id);
-    if (ret < 0 || ret >= size) {
-        return -1;
+static uint64_t tuya_p2p_rtc_sdp_hash_str(uint64_t hash, const char *str)
+{
+    if (str == NULL) {
+        return tuya_p2p_rtc_sdp_hash(hash, "\xff", 1);
     }
-    return ret;
+    return tuya_p2p_rtc_sdp_hash(hash, str, strlen(str) + 1);
 }
 
-static int tuya_p2p_rtc_sdp_encode_media_audio(rtc_sdp_t *sdp, char *type, char *mid, char *buf, int size)
+static uint64_t tuya_p2p_rtc_sdp_hash_int(uint64_t hash, int value)
 {
-    int ret;
-    int index = 0;
-    int already = 0;
-    int remain = size;
+    return tuya_p2p_rtc_sdp_hash(hash, &value, sizeof(value));
+}
 
-    char pt[128] = {0};
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->audio.codec_list)
-        {
-            rtc_audio_codec_t *codec = QUEUE_DATA(q, rtc_audio_codec_t, queue);
-            ret = snprintf(pt + index, sizeof(pt) - index, " %d", codec->pt);
-            if (ret < 0 || ret >= (int)sizeof(pt) - index) {
-                return -1;
-            }
-            index += ret;
-        }
-    } else {
-        ret = snprintf(pt, sizeof(pt), " %d", sdp->audio.negotiated_codec.pt);
-        if (ret < 0 || ret >= (int)sizeof(pt)) {
-            return -1;
-        }
+// the codec parts built for the previous caps_gen are stale from now on
+static void tuya_p2p_rtc_sdp_caps_touch(rtc_sdp_t *sdp)
+{
+    sdp->caps_gen++;
+    if (sdp->caps_gen == 0) {
+        sdp->caps_gen = 1;
     }
+}
 
-    // m line
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_HEADER, "audio", "UDP/TLS/RTP/SAVPF", pt);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+// fold a change of the codecs into the fingerprint, ssrc are left out as they differ per session
+static void tuya_p2p_rtc_sdp_caps_update(rtc_sdp_t *sdp, char tag, uint64_t hash)
+{
+    sdp->caps_hash = tuya_p2p_rtc_sdp_hash(sdp->caps_hash, &tag, 1);
+    sdp->caps_hash = tuya_p2p_rtc_sdp_hash(sdp->caps_hash, &hash, sizeof(hash));
+    tuya_p2p_rtc_sdp_caps_touch(sdp);
+}
 
-    // ice
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_TRANSPORT, sdp->ufrag, sdp->password);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static uint64_t tuya_p2p_rtc_sdp_hash_audio_codec(rtc_audio_codec_t *codec)
+{
+    uint64_t hash = SDP_FNV_OFFSET_BASIS;
+    hash = tuya_p2p_rtc_sdp_hash_str(hash, codec->name);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->pt);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->sample_rate);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->channel_number);
+    return hash;
+}
 
-    // dtls
-    char dtls_role[32] = {0};
-    if (sdp->dtls_role == DTLS_ROLE_CLIENT) {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "active");
-    } else if (sdp->dtls_role == DTLS_ROLE_SERVER) {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "passive");
-    } else {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "actpass");
-    }
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_DTLS, sdp->fingerprint, dtls_role);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static uint64_t tuya_p2p_rtc_sdp_hash_video_codec(rtc_video_codec_t *codec)
+{
+    uint64_t hash = SDP_FNV_OFFSET_BASIS;
+    hash = tuya_p2p_rtc_sdp_hash_str(hash, codec->name);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->pt);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->original_pt);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->clock_rate);
+    hash = tuya_p2p_rtc_sdp_hash_str(hash, codec->profile_level_id);
+    return hash;
+}
 
-    // mid
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_MID, mid);
-    if (ret < 0 || ret >= remain) {
-        return -1;
+static void tuya_p2p_rtc_sdp_put(sdp_writer_t *w, const char *str, int len)
+{
+    if (w->len < 0) {
+        return;
     }
-    already += ret;
-    remain -= ret;
-
-    // media direction
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_DIRECTION,
-                   tuya_p2p_rtc_media_direction_str(sdp->audio.direction));
-    if (ret < 0 || ret >= remain) {
-        return -1;
+    // keep a byte for the terminating '\0', as snprintf does
+    if (len >= w->size - w->len) {
+        w->len = -1;
+        return;
     }
-    already += ret;
-    remain -= ret;
+    memcpy(w->buf + w->len, str, len);
+    w->len += len;
+}
 
-    // msid
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_MSID, sdp->wms_id, sdp->audio.track_id);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_put_str(sdp_writer_t *w, const char *str)
+{
+    tuya_p2p_rtc_sdp_put(w, str, strlen(str));
+}
 
-    // rtcp-mux
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_RTCP_MUX);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_put_uint(sdp_writer_t *w, uint64_t value)
+{
+    char tmp[20];
+    int i = sizeof(tmp);
+    do {
+        tmp[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    tuya_p2p_rtc_sdp_put(w, tmp + i, sizeof(tmp) - i);
+}
 
-    // rtpmap
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->audio.codec_list)
-        {
-            rtc_audio_codec_t *codec = QUEUE_DATA(q, rtc_audio_codec_t, queue);
-            ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_AUDIO_RTPMAP, codec->pt, codec->name,
-                           codec->sample_rate);
-            if (ret < 0 || ret >= remain) {
-                return -1;
-            }
-            already += ret;
-            remain -= ret;
-        }
+static void tuya_p2p_rtc_sdp_put_int(sdp_writer_t *w, int value)
+{
+    if (value < 0) {
+        SDP_PUT_LIT(w, "-");
+        tuya_p2p_rtc_sdp_put_uint(w, (uint64_t)(-(int64_t)value));
     } else {
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_AUDIO_RTPMAP, sdp->audio.negotiated_codec.pt,
-                       sdp->audio.negotiated_codec.name, sdp->audio.negotiated_codec.sample_rate);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
-    }
-
-    // ssrc
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_SSRC, sdp->audio.negotiated_codec.ssrc, sdp->cname);
-    if (ret < 0 || ret >= remain) {
-        return -1;
+        tuya_p2p_rtc_sdp_put_uint(w, (uint64_t)value);
     }
-    already += ret;
-    remain -= ret;
-
-    return already;
 }
 
-static int tuya_p2p_rtc_sdp_encode_media_video(rtc_sdp_t *sdp, char *type, char *mid, char *buf, int size)
+static void tuya_p2p_rtc_sdp_put_video_rtpmap(sdp_writer_t *w, int pt, char *name, int clock_rate,
+                                              char *profile_level_id)
 {
-    int ret;
-    int index = 0;
-    int already = 0;
-    int remain = size;
-
-    char pt[128] = {0};
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->video.codec_list)
-        {
-            rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
-            ret = snprintf(pt + index, sizeof(pt) - index, " %d", codec->pt);
-            if (ret < 0 || ret >= (int)sizeof(pt) - index) {
-                return -1;
-            }
-            index += ret;
-        }
-    } else {
-        ret = snprintf(pt + index, sizeof(pt) - index, " %d", sdp->video.negotiated_codec.pt);
-        if (ret < 0 || ret >= (int)sizeof(pt) - index) {
-            return -1;
-        }
-        index += ret;
+    // rtpmap
+    SDP_PUT_LIT(w, "a=rtpmap:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    SDP_PUT_LIT(w, " ");
+    tuya_p2p_rtc_sdp_put_str(w, name);
+    SDP_PUT_LIT(w, "/");
+    tuya_p2p_rtc_sdp_put_int(w, clock_rate);
+    // rtcp ccm fir
+    SDP_PUT_LIT(w, "\r\na=rtcp-fb:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    // rtcp nack
+    SDP_PUT_LIT(w, " ccm fir\r\na=rtcp-fb:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    // rtcp pli
+    SDP_PUT_LIT(w, " nack\r\na=rtcp-fb:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    // attr
+    SDP_PUT_LIT(w, " nack pli\r\na=fmtp:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    SDP_PUT_LIT(w, " level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=");
+    tuya_p2p_rtc_sdp_put_str(w, profile_level_id);
+    SDP_PUT_LIT(w, "\r\n");
+}
 
-        if (sdp->video.rtx_codec.pt != -1) {
-            ret = snprintf(pt + index, sizeof(pt) - index, " %d", sdp->video.rtx_codec.pt);
-            if (ret < 0 || ret >= (int)sizeof(pt) - index) {
-                return -1;
-            }
-            index += ret;
-        }
-    }
+static void tuya_p2p_rtc_sdp_put_rtx(sdp_writer_t *w, int pt, int clock_rate, int original_pt)
+{
+    SDP_PUT_LIT(w, "a=rtpmap:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    SDP_PUT_LIT(w, " rtx/");
+    tuya_p2p_rtc_sdp_put_int(w, clock_rate);
+    SDP_PUT_LIT(w, "\r\na=fmtp:");
+    tuya_p2p_rtc_sdp_put_int(w, pt);
+    SDP_PUT_LIT(w, " apt=");
+    tuya_p2p_rtc_sdp_put_int(w, original_pt);
+    SDP_PUT_LIT(w, "\r\n");
+}
 
-    // m line
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_HEADER, "video", "UDP/TLS/RTP/SAVPF", pt);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_put_ssrc(sdp_writer_t *w, uint32_t ssrc, char *cname)
+{
+    SDP_PUT_LIT(w, "a=ssrc:");
+    tuya_p2p_rtc_sdp_put_uint(w, ssrc);
+    SDP_PUT_LIT(w, " cname:");
+    tuya_p2p_rtc_sdp_put_str(w, cname);
+    SDP_PUT_LIT(w, "\r\n");
+}
 
-    // ice
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_TRANSPORT, sdp->ufrag, sdp->password);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_put_transport(rtc_sdp_t *sdp, sdp_writer_t *w)
+{
+    SDP_PUT_LIT(w, "c=IN IP4 0.0.0.0\r\n"
+                   "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+                   "a=ice-ufrag:");
+    tuya_p2p_rtc_sdp_put_str(w, sdp->ufrag);
+    SDP_PUT_LIT(w, "\r\na=ice-pwd:");
+    tuya_p2p_rtc_sdp_put_str(w, sdp->password);
+    SDP_PUT_LIT(w, "\r\na=ice-options:trickle\r\n");
+}
 
-    // dtls
-    char dtls_role[32] = {0};
+// dtls, mid, media direction, msid and rtcp-mux of an audio or video media
+static void tuya_p2p_rtc_sdp_put_rtp_media(rtc_sdp_t *sdp, char *mid, tuya_p2p_rtc_media_direction_e direction,
+                                           char *track_id, sdp_writer_t *w)
+{
+    SDP_PUT_LIT(w, "a=fingerprint:");
+    tuya_p2p_rtc_sdp_put_str(w, sdp->fingerprint);
     if (sdp->dtls_role == DTLS_ROLE_CLIENT) {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "active");
+        SDP_PUT_LIT(w, "\r\na=setup:active\r\n");
     } else if (sdp->dtls_role == DTLS_ROLE_SERVER) {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "passive");
+        SDP_PUT_LIT(w, "\r\na=setup:passive\r\n");
     } else {
-        snprintf(dtls_role, sizeof(dtls_role), "%s", "actpass");
-    }
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_DTLS, sdp->fingerprint, dtls_role);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
-
-    // mid
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_MID, mid);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
-
-    // media direction
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_DIRECTION,
-                   tuya_p2p_rtc_media_direction_str(sdp->video.direction));
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
-
-    // msid
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_MSID, sdp->wms_id, sdp->video.track_id);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
-
-    // rtcp-mux
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_RTCP_MUX);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
-
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->video.codec_list)
-        {
-            rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
-            if (strcmp(codec->name, "rtx")) {
-                // rtpmap
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPMAP, codec->pt, codec->name,
-                               codec->clock_rate);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
-
-                // rtcp ccm fir
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_FIR, codec->pt);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
-
-                // rtcp nack
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_NACK, codec->pt);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
+        SDP_PUT_LIT(w, "\r\na=setup:actpass\r\n");
+    }
+
+    SDP_PUT_LIT(w, "a=mid:");
+    tuya_p2p_rtc_sdp_put_str(w, mid);
+    SDP_PUT_LIT(w, "\r\na=");
+    tuya_p2p_rtc_sdp_put_str(w, tuya_p2p_rtc_media_direction_str(direction));
+    SDP_PUT_LIT(w, "\r\na=msid:");
+    tuya_p2p_rtc_sdp_put_str(w, sdp->wms_id);
+    SDP_PUT_LIT(w, " ");
+    tuya_p2p_rtc_sdp_put_str(w, track_id);
+    SDP_PUT_LIT(w, "\r\na=rtcp-mux\r\n");
+}
 
-                // rtcp pli
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_PLI, codec->pt);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
-
-                // attr
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_ATTR, codec->pt,
-                               codec->profile_level_id);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
-            } else {
-                ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_RTX, codec->pt, codec->clock_rate,
-                               codec->pt, codec->original_pt);
-                if (ret < 0 || ret >= remain) {
-                    return -1;
-                }
-                already += ret;
-                remain -= ret;
+// payload types listed in the m line
+static void tuya_p2p_rtc_sdp_encode_pt(rtc_sdp_t *sdp, int offer, int media, sdp_writer_t *w)
+{
+    QUEUE *q;
+    if (media == SDP_MEDIA_AUDIO) {
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->audio.codec_list)
+            {
+                rtc_audio_codec_t *codec = QUEUE_DATA(q, rtc_audio_codec_t, queue);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_int(w, codec->pt);
             }
+        } else if (sdp->audio.negotiated_codec.name[0] != '\0') {
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->audio.negotiated_codec.pt);
         }
-    } else {
-        // rtpmap
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPMAP, sdp->video.negotiated_codec.pt,
-                       sdp->video.negotiated_codec.name, sdp->video.negotiated_codec.clock_rate);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
-
-        // rtcp ccm fir
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_FIR, sdp->video.negotiated_codec.pt);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
-
-        // rtcp nack
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_NACK, sdp->video.negotiated_codec.pt);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
-
-        // rtcp pli
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_RTPFB_PLI, sdp->video.negotiated_codec.pt);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
-
-        // attr
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_VIDEO_ATTR, sdp->video.negotiated_codec.pt,
-                       sdp->video.negotiated_codec.profile_level_id);
-        if (ret < 0 || ret >= remain) {
-            return -1;
+    } else if (media == SDP_MEDIA_VIDEO) {
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->video.codec_list)
+            {
+                rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_int(w, codec->pt);
+            }
+        } else if (sdp->video.negotiated_codec.name[0] != '\0') {
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->video.negotiated_codec.pt);
+            if (sdp->video.rtx_codec.pt != -1) {
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_int(w, sdp->video.rtx_codec.pt);
+            }
         }
-        already += ret;
-        remain -= ret;
-
-        if (sdp->video.rtx_mode == RTX_MODE_SSRC_MULTIPLEX) {
-            // rtx
-            ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_RTX, sdp->video.rtx_codec.pt,
-                           sdp->video.rtx_codec.clock_rate, sdp->video.rtx_codec.pt, sdp->video.negotiated_codec.pt);
-            if (ret < 0 || ret >= remain) {
-                return -1;
+    } else {
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->tuya.codec_list)
+            {
+                rtc_tuya_codec_t *codec = QUEUE_DATA(q, rtc_tuya_codec_t, queue);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_int(w, codec->pt);
             }
-            already += ret;
-            remain -= ret;
+        } else {
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->tuya.negotiated_codec.pt);
         }
     }
+}
 
-    if (sdp->video.rtx_mode == RTX_MODE_SSRC_MULTIPLEX) {
-        // ssrc group
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_SSRC_GROUP, sdp->video.negotiated_codec.ssrc,
-                       sdp->video.rtx_codec.ssrc, sdp->video.negotiated_codec.ssrc, sdp->cname,
-                       sdp->video.rtx_codec.ssrc, sdp->cname);
-        if (ret < 0 || ret >= remain) {
-            return -1;
+// rtpmap and the attributes of every payload type, an answer lists none for a media nothing matched in
+static void tuya_p2p_rtc_sdp_encode_codecs(rtc_sdp_t *sdp, int offer, int media, sdp_writer_t *w)
+{
+    QUEUE *q;
+    if (media == SDP_MEDIA_AUDIO) {
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->audio.codec_list)
+            {
+                rtc_audio_codec_t *codec = QUEUE_DATA(q, rtc_audio_codec_t, queue);
+                SDP_PUT_LIT(w, "a=rtpmap:");
+                tuya_p2p_rtc_sdp_put_int(w, codec->pt);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_str(w, codec->name);
+                SDP_PUT_LIT(w, "/");
+                tuya_p2p_rtc_sdp_put_int(w, codec->sample_rate);
+                SDP_PUT_LIT(w, "\r\n");
+            }
+        } else if (sdp->audio.negotiated_codec.name[0] != '\0') {
+            SDP_PUT_LIT(w, "a=rtpmap:");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->audio.negotiated_codec.pt);
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_str(w, sdp->audio.negotiated_codec.name);
+            SDP_PUT_LIT(w, "/");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->audio.negotiated_codec.sample_rate);
+            SDP_PUT_LIT(w, "\r\n");
+        }
+    } else if (media == SDP_MEDIA_VIDEO) {
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->video.codec_list)
+            {
+                rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
+                if (strcmp(codec->name, "rtx")) {
+                    tuya_p2p_rtc_sdp_put_video_rtpmap(w, codec->pt, codec->name, codec->clock_rate,
+                                                      codec->profile_level_id);
+                } else {
+                    tuya_p2p_rtc_sdp_put_rtx(w, codec->pt, codec->clock_rate, codec->original_pt);
+                }
+            }
+        } else if (sdp->video.negotiated_codec.name[0] != '\0') {
+            rtc_video_codec_t *codec = &sdp->video.negotiated_codec;
+            tuya_p2p_rtc_sdp_put_video_rtpmap(w, codec->pt, codec->name, codec->clock_rate, codec->profile_level_id);
+            if (sdp->video.rtx_mode == RTX_MODE_SSRC_MULTIPLEX) {
+                tuya_p2p_rtc_sdp_put_rtx(w, sdp->video.rtx_codec.pt, sdp->video.rtx_codec.clock_rate, codec->pt);
+            }
         }
-        already += ret;
-        remain -= ret;
     } else {
-        // ssrc
-        ret =
-            snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_SSRC, sdp->video.negotiated_codec.ssrc, sdp->cname);
-        if (ret < 0 || ret >= remain) {
-            return -1;
+        if (offer) {
+            QUEUE_FOREACH(q, &sdp->tuya.codec_list)
+            {
+                rtc_tuya_codec_t *codec = QUEUE_DATA(q, rtc_tuya_codec_t, queue);
+                SDP_PUT_LIT(w, "a=rtpmap:");
+                tuya_p2p_rtc_sdp_put_int(w, codec->pt);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_str(w, codec->name);
+                SDP_PUT_LIT(w, " ");
+                tuya_p2p_rtc_sdp_put_int(w, codec->channel_number);
+                SDP_PUT_LIT(w, "\r\n");
+            }
+        } else {
+            SDP_PUT_LIT(w, "a=rtpmap:");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->tuya.negotiated_codec.pt);
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_str(w, sdp->tuya.negotiated_codec.name);
+            SDP_PUT_LIT(w, " ");
+            tuya_p2p_rtc_sdp_put_int(w, sdp->tuya.negotiated_codec.channel_number);
+            SDP_PUT_LIT(w, "\r\n");
         }
-        already += ret;
-        remain -= ret;
     }
-
-    return already;
 }
 
-static int tuya_p2p_rtc_sdp_encode_media_tuya(rtc_sdp_t *sdp, char *type, char *mid, char *buf, int size)
+// build the codec parts of every media for the current codecs, kept until they change
+static void tuya_p2p_rtc_sdp_build_tmpl(rtc_sdp_t *sdp, int offer)
 {
-    (void)sdp;
-    (void)type;
-    int ret;
-    int index = 0;
-    int already = 0;
-    int remain = size;
-
-    char pt[128] = {0};
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->tuya.codec_list)
-        {
-            rtc_tuya_codec_t *codec = QUEUE_DATA(q, rtc_tuya_codec_t, queue);
-            ret = snprintf(pt + index, sizeof(pt) - index, " %d", codec->pt);
-            if (ret < 0 || ret >= (int)sizeof(pt) - index) {
-                return -1;
+    rtc_sdp_tmpl_t *tmpl = &sdp->tmpl;
+    if (tmpl->gen == sdp->caps_gen && tmpl->offer == offer) {
+        return;
+    }
+
+    if (tmpl->codec == NULL) {
+        tmpl->codec = (char *)malloc(RTC_SDP_TMPL_CODEC_SIZE);
+    }
+
+    int media;
+    int off = 0;
+    for (media = 0; media < RTC_SDP_TMPL_MEDIA_NUM; media++) {
+        sdp_writer_t w = {tmpl->pt[media], RTC_SDP_TMPL_PT_SIZE, 0};
+        tuya_p2p_rtc_sdp_encode_pt(sdp, offer, media, &w);
+        tmpl->pt_len[media] = w.len;
+
+        tmpl->codec_off[media] = off;
+        tmpl->codec_len[media] = -1;
+        if (tmpl->codec != NULL) {
+            w.buf = tmpl->codec + off;
+            w.size = RTC_SDP_TMPL_CODEC_SIZE - off;
+            w.len = 0;
+            tuya_p2p_rtc_sdp_encode_codecs(sdp, offer, media, &w);
+            if (w.len >= 0) {
+                tmpl->codec_len[media] = w.len;
+                off += w.len;
             }
-            index += ret;
-        }
-    } else {
-        ret = snprintf(pt, sizeof(pt), " %d", sdp->tuya.negotiated_codec.pt);
-        if (ret < 0 || ret >= (int)sizeof(pt)) {
-            return -1;
         }
     }
+    tmpl->gen = sdp->caps_gen;
+    tmpl->offer = offer;
+}
 
-    // m line
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_HEADER, "application", "tuya", pt);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_put_media_header(rtc_sdp_t *sdp, int media, sdp_writer_t *w)
+{
+    static const char *media_header[RTC_SDP_TMPL_MEDIA_NUM] = {
+        "m=audio 9 UDP/TLS/RTP/SAVPF",
+        "m=video 9 UDP/TLS/RTP/SAVPF",
+        "m=application 9 tuya",
+    };
+    if (sdp->tmpl.pt_len[media] < 0) {
+        w->len = -1;
+        return;
+    }
+    tuya_p2p_rtc_sdp_put_str(w, media_header[media]);
+    tuya_p2p_rtc_sdp_put(w, sdp->tmpl.pt[media], sdp->tmpl.pt_len[media]);
+    SDP_PUT_LIT(w, "\r\n");
+}
 
-    // ice
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_TRANSPORT, sdp->ufrag, sdp->password);
-    if (ret < 0 || ret >= remain) {
-        return -1;
+static void tuya_p2p_rtc_sdp_put_codecs(rtc_sdp_t *sdp, int offer, int media, sdp_writer_t *w)
+{
+    if (sdp->tmpl.codec_len[media] < 0) {
+        tuya_p2p_rtc_sdp_encode_codecs(sdp, offer, media, w);
+        return;
     }
-    already += ret;
-    remain -= ret;
+    tuya_p2p_rtc_sdp_put(w, sdp->tmpl.codec + sdp->tmpl.codec_off[media], sdp->tmpl.codec_len[media]);
+}
 
-    // aes key
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_APPLICATION_KEY, sdp->aes_key);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_encode_session(rtc_sdp_t *sdp, sdp_writer_t *w)
+{
+    char bundle[SDP_BUNDLE_SIZE];
+    sdp_writer_t bw = {bundle, sizeof(bundle), 0};
+    QUEUE *q;
+    QUEUE_FOREACH(q, &sdp->media_info_list.queue)
+    {
+        media_info_t *info = QUEUE_DATA(q, media_info_t, queue);
+        SDP_PUT_LIT(&bw, " ");
+        tuya_p2p_rtc_sdp_put_str(&bw, info->mid);
+    }
+    if (bw.len < 0) {
+        w->len = -1;
+        return;
+    }
+
+    SDP_PUT_LIT(w, "v=0\r\n"
+                   "o=- ");
+    tuya_p2p_rtc_sdp_put_uint(w, (unsigned long)time(NULL));
+    SDP_PUT_LIT(w, " 1 IN IP4 127.0.0.1\r\n"
+                   "s=-\r\n"
+                   "t=0 0\r\n"
+                   "a=group:BUNDLE");
+    tuya_p2p_rtc_sdp_put(w, bundle, bw.len);
+    SDP_PUT_LIT(w, "\r\na=msid-semantic: WMS ");
+    tuya_p2p_rtc_sdp_put_str(w, sdp->wms_id);
+    SDP_PUT_LIT(w, "\r\n");
+}
 
-    // mid
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_MID, mid);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_encode_media_audio(rtc_sdp_t *sdp, int offer, char *mid, sdp_writer_t *w)
+{
+    tuya_p2p_rtc_sdp_put_media_header(sdp, SDP_MEDIA_AUDIO, w);
+    tuya_p2p_rtc_sdp_put_transport(sdp, w);
+    tuya_p2p_rtc_sdp_put_rtp_media(sdp, mid, sdp->audio.direction, sdp->audio.track_id, w);
+    tuya_p2p_rtc_sdp_put_codecs(sdp, offer, SDP_MEDIA_AUDIO, w);
+    tuya_p2p_rtc_sdp_put_ssrc(w, sdp->audio.negotiated_codec.ssrc, sdp->cname);
+}
 
-    // rtpmap
-    if (strcmp(type, "offer") == 0) {
-        QUEUE *q;
-        QUEUE_FOREACH(q, &sdp->tuya.codec_list)
-        {
-            rtc_tuya_codec_t *codec = QUEUE_DATA(q, rtc_tuya_codec_t, queue);
-            ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_APPLICATION_RTPMAP, codec->pt, codec->name,
-                           codec->channel_number);
-            if (ret < 0 || ret >= remain) {
-                return -1;
-            }
-            already += ret;
-            remain -= ret;
-        }
+static void tuya_p2p_rtc_sdp_encode_media_video(rtc_sdp_t *sdp, int offer, char *mid, sdp_writer_t *w)
+{
+    tuya_p2p_rtc_sdp_put_media_header(sdp, SDP_MEDIA_VIDEO, w);
+    tuya_p2p_rtc_sdp_put_transport(sdp, w);
+    tuya_p2p_rtc_sdp_put_rtp_media(sdp, mid, sdp->video.direction, sdp->video.track_id, w);
+    tuya_p2p_rtc_sdp_put_codecs(sdp, offer, SDP_MEDIA_VIDEO, w);
+
+    if (sdp->video.rtx_mode == RTX_MODE_SSRC_MULTIPLEX) {
+        // ssrc group
+        SDP_PUT_LIT(w, "a=ssrc-group:FID ");
+        tuya_p2p_rtc_sdp_put_uint(w, sdp->video.negotiated_codec.ssrc);
+        SDP_PUT_LIT(w, " ");
+        tuya_p2p_rtc_sdp_put_uint(w, sdp->video.rtx_codec.ssrc);
+        SDP_PUT_LIT(w, "\r\n");
+        tuya_p2p_rtc_sdp_put_ssrc(w, sdp->video.negotiated_codec.ssrc, sdp->cname);
+        tuya_p2p_rtc_sdp_put_ssrc(w, sdp->video.rtx_codec.ssrc, sdp->cname);
     } else {
-        ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_APPLICATION_RTPMAP, sdp->tuya.negotiated_codec.pt,
-                       sdp->tuya.negotiated_codec.name, sdp->tuya.negotiated_codec.channel_number);
-        if (ret < 0 || ret >= remain) {
-            return -1;
-        }
-        already += ret;
-        remain -= ret;
+        tuya_p2p_rtc_sdp_put_ssrc(w, sdp->video.negotiated_codec.ssrc, sdp->cname);
     }
+}
 
-    // ssrc
-    ret = snprintf(buf + already, remain, SDP_TEMPLATE_PART_MEDIA_SSRC, sdp->video.negotiated_codec.ssrc, sdp->cname);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    already += ret;
-    remain -= ret;
+static void tuya_p2p_rtc_sdp_encode_media_tuya(rtc_sdp_t *sdp, int offer, char *mid, sdp_writer_t *w)
+{
+    tuya_p2p_rtc_sdp_put_media_header(sdp, SDP_MEDIA_TUYA, w);
+    tuya_p2p_rtc_sdp_put_transport(sdp, w);
 
-    return already;
+    // aes key
+    SDP_PUT_LIT(w, "a=aes-key:");
+    tuya_p2p_rtc_sdp_put_str(w, (char *)sdp->aes_key);
+    // mid
+    SDP_PUT_LIT(w, "\r\na=mid:");
+    tuya_p2p_rtc_sdp_put_str(w, mid);
+    SDP_PUT_LIT(w, "\r\n");
+
+    tuya_p2p_rtc_sdp_put_codecs(sdp, offer, SDP_MEDIA_TUYA, w);
+    tuya_p2p_rtc_sdp_put_ssrc(w, sdp->video.negotiated_codec.ssrc, sdp->cname);
 }
 
 static int tuya_p2p_rtc_sdp_set_original_pt(rtc_sdp_t *sdp, int pt, int original_pt)
@@ -591,6 +582,8 @@ static int tuya_p2p_rtc_sdp_set_original_pt(rtc_sdp_t *sdp, int pt, int original
             codec->original_pt = original_pt;
         }
     }
+    uint64_t hash = tuya_p2p_rtc_sdp_hash_int(SDP_FNV_OFFSET_BASIS, pt);
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'o', tuya_p2p_rtc_sdp_hash_int(hash, original_pt));
     return 0;
 }
 
@@ -609,6 +602,8 @@ int tuya_p2p_rtc_sdp_init(rtc_sdp_t *sdp, char *session_id, char *local_id, char
 
     QUEUE_INIT(&sdp->media_info_list.queue);
     QUEUE_INIT(&sdp->candidates.queue);
+    sdp->caps_hash = SDP_FNV_OFFSET_BASIS;
+    sdp->caps_gen = 1;
 
     // audio
     tuya_p2p_misc_rand_string(sdp->audio.track_id, 32);
@@ -666,6 +661,10 @@ int tuya_p2p_rtc_sdp_deinit(rtc_sdp_t *sdp)
         rtc_tuya_codec_t *codec = QUEUE_DATA(q, rtc_tuya_codec_t, queue);
         free(codec);
     }
+    if (sdp->tmpl.codec != NULL) {
+        free(sdp->tmpl.codec);
+        sdp->tmpl.codec = NULL;
+    }
     return 0;
 }
 
@@ -765,6 +764,7 @@ int tuya_p2p_rtc_sdp_add_audio_codec(rtc_sdp_t *sdp, char *name, int pt, uint32_
     }
 
     QUEUE_INSERT_TAIL(&sdp->audio.codec_list, &codec->queue);
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'a', tuya_p2p_rtc_sdp_hash_audio_codec(codec));
     return 0;
 }
 
@@ -785,6 +785,7 @@ int tuya_p2p_rtc_sdp_add_video_codec(rtc_sdp_t *sdp, char *name, int pt, uint32_
     snprintf(codec->profile_level_id, sizeof(codec->profile_level_id), "%s", profile_level_id);
 
     QUEUE_INSERT_TAIL(&sdp->video.codec_list, &codec->queue);
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'v', tuya_p2p_rtc_sdp_hash_video_codec(codec));
     return 0;
 }
 
@@ -803,6 +804,7 @@ int tuya_p2p_rtc_sdp_add_video_rtx_codec(rtc_sdp_t *sdp, int origin_pt, int pt,
     codec->clock_rate = clock_rate;
 
     QUEUE_INSERT_TAIL(&sdp->video.codec_list, &codec->queue);
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'v', tuya_p2p_rtc_sdp_hash_video_codec(codec));
     return 0;
 }
 
@@ -818,6 +820,9 @@ int tuya_p2p_rtc_sdp_add_tuya_codec(rtc_sdp_t *sdp, char *name, int pt, int chan
     codec->channel_number = channel_number;
 
     QUEUE_INSERT_TAIL(&sdp->tuya.codec_list, &codec->queue);
+    uint64_t hash = tuya_p2p_rtc_sdp_hash_str(SDP_FNV_OFFSET_BASIS, codec->name);
+    hash = tuya_p2p_rtc_sdp_hash_int(hash, codec->pt);
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'u', tuya_p2p_rtc_sdp_hash_int(hash, codec->channel_number));
     return 0;
 }
 
@@ -846,6 +851,7 @@ int tuya_p2p_rtc_sdp_add_candidate(rtc_sdp_t *sdp, char *candidate)
 int tuya_p2p_rtc_sdp_update_audio_codec(rtc_sdp_t *sdp, int pt, char *name, char *sample_rate, char *channel_number)
 {
     tuya_p2p_log_debug("update audio codec: pt = %d, codec = %s, %s, %s\n", pt, name, sample_rate, channel_number);
+    uint64_t hash = SDP_FNV_OFFSET_BASIS;
     QUEUE *q;
     QUEUE_FOREACH(q, &sdp->audio.codec_list)
     {
@@ -862,15 +868,18 @@ int tuya_p2p_rtc_sdp_update_audio_codec(rtc_sdp_t *sdp, int pt, char *name, char
             } else {
                 codec->channel_number = 1;
             }
+            hash = tuya_p2p_rtc_sdp_hash_audio_codec(codec);
             break;
         }
     }
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'A', tuya_p2p_rtc_sdp_hash_int(hash, pt));
     return 0;
 }
 
 int tuya_p2p_rtc_sdp_update_video_codec(rtc_sdp_t *sdp, int pt, char *name, char *clock_rate)
 {
     tuya_p2p_log_debug("update video codec: pt = %d, codec = %s, %s\n", pt, name, clock_rate);
+    uint64_t hash = SDP_FNV_OFFSET_BASIS;
     QUEUE *q;
     QUEUE_FOREACH(q, &sdp->video.codec_list)
     {
@@ -882,285 +891,313 @@ int tuya_p2p_rtc_sdp_update_video_codec(rtc_sdp_t *sdp, int pt, char *name, char
             if (clock_rate != NULL) {
                 codec->clock_rate = atoi(clock_rate);
             }
+            hash = tuya_p2p_rtc_sdp_hash_video_codec(codec);
             break;
         }
     }
+    tuya_p2p_rtc_sdp_caps_update(sdp, 'V', tuya_p2p_rtc_sdp_hash_int(hash, pt));
     return 0;
 }
 
+
 int tuya_p2p_rtc_sdp_encode(rtc_sdp_t *sdp, char *type, char *buf, int size)
 {
-    int ret;
-    int already = 0;
-    int remain = size;
-    ret = tuya_p2p_rtc_sdp_encode_session(sdp, buf + already, remain);
-    if (ret < 0 || ret >= remain) {
-        return -1;
-    }
-    remain -= ret;
-    already += ret;
+    int offer = (strcmp(type, "offer") == 0);
+    sdp_writer_t w = {buf, size, 0};
+
+    tuya_p2p_rtc_sdp_build_tmpl(sdp, offer);
+    tuya_p2p_rtc_sdp_encode_session(sdp, &w);
 
     QUEUE *q;
     QUEUE_FOREACH(q, &sdp->media_info_list.queue)
     {
         media_info_t *info = QUEUE_DATA(q, media_info_t, queue);
         if (strcmp(info->type, "audio") == 0) {
-            ret = tuya_p2p_rtc_sdp_encode_media_audio(sdp, type, info->mid, buf + already, remain);
+            tuya_p2p_rtc_sdp_encode_media_audio(sdp, offer, info->mid, &w);
         } else if (strcmp(info->type, "video") == 0) {
-            ret = tuya_p2p_rtc_sdp_encode_media_video(sdp, type, info->mid, buf + already, remain);
+            tuya_p2p_rtc_sdp_encode_media_video(sdp, offer, info->mid, &w);
         } else if (strcmp(info->type, "tuya") == 0) {
-            ret = tuya_p2p_rtc_sdp_encode_media_tuya(sdp, type, info->mid, buf + already, remain);
-        } else {
-            ret = 0;
+            tuya_p2p_rtc_sdp_encode_media_tuya(sdp, offer, info->mid, &w);
         }
-        if (ret < 0 || ret >= remain) {
+        if (w.len < 0) {
             return -1;
         }
-        remain -= ret;
-        already += ret;
     }
+    if (w.len < 0) {
+        return -1;
+    }
+    buf[w.len] = '\0';
 
-    return already;
+    return w.len;
 }
 
-int tuya_p2p_rtc_sdp_decode(rtc_sdp_t *sdp, char *buf)
+// next white space separated token of str, as sscanf "%s" reads it, str is cut after the token
+static char *tuya_p2p_rtc_sdp_next_token(char **str)
 {
-    char *lasts = NULL;
-    char *p = strtok_r(buf, "\r\n", &lasts);
-    if (p == NULL) {
-        return 0;
+    char *p = *str;
+    while (*p == ' ' || *p == '\t' || *p == '\v' || *p == '\f' || *p == '\r' || *p == '\n') {
+        p++;
     }
-    char m = '0';
-    while (1) {
-        p = strtok_r(NULL, "\r\n", &lasts);
-        if (p == NULL) {
-            break;
-        }
-        if (strncmp(p, "a=msid-semantic:", strlen("a=msid-semantic:")) == 0) {
-            p += strlen("a=msid-semantic:");
-            char wms_name[65] = {0};
-            char wms_id[65] = {0};
-            int cnt = sscanf(p, "%s %s", wms_name, wms_id);
-            if (cnt != 2 || strcmp(wms_name, "WMS") != 0) {
-                continue;
-            }
-            snprintf(sdp->wms_id, sizeof(sdp->wms_id), "%s", wms_id);
-            continue;
+    if (*p == '\0') {
+        *str = p;
+        return NULL;
+    }
+
+    char *token = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\v' && *p != '\f' && *p != '\r' && *p != '\n') {
+        p++;
+    }
+    if (*p != '\0') {
+        *p = '\0';
+        p++;
+    }
+    *str = p;
+    return token;
+}
+
+// m line, returns the media the lines after it belong to
+static char tuya_p2p_rtc_sdp_decode_media(rtc_sdp_t *sdp, char *line, char m)
+{
+    char *fmt;
+    if (strncmp(line, "m=audio", strlen("m=audio")) == 0) {
+        m = 'a';
+        fmt = strstr(line, "SAVPF");
+        fmt = (fmt != NULL) ? fmt + strlen("SAVPF") : NULL;
+    } else if (strncmp(line, "m=video", strlen("m=video")) == 0) {
+        m = 'v';
+        fmt = strstr(line, "SAVPF");
+        fmt = (fmt != NULL) ? fmt + strlen("SAVPF") : NULL;
+    } else if (strncmp(line, "m=application", strlen("m=application")) == 0) {
+        m = 't';
+        fmt = strstr(line, "tuya");
+        fmt = (fmt != NULL) ? fmt + strlen("tuya") : NULL;
+    } else {
+        return m;
+    }
+    if (fmt == NULL) {
+        return m;
+    }
+
+    char *pt;
+    while ((pt = tuya_p2p_rtc_sdp_next_token(&fmt)) != NULL) {
+        if (m == 'a') {
+            tuya_p2p_rtc_sdp_add_audio_codec(sdp, NULL, atoi(pt), 0, 0, 0);
+        } else if (m == 'v') {
+            tuya_p2p_rtc_sdp_add_video_codec(sdp, "", atoi(pt), 0, 0, "");
+        } else {
+            tuya_p2p_rtc_sdp_add_tuya_codec(sdp, "", atoi(pt), 0);
         }
-        if (strncmp(p, "a=msid:", strlen("a=msid:")) == 0) {
-            p += strlen("a=msid:");
-            char msid[65] = {0};
-            char track_id[65] = {0};
-            int cnt = sscanf(p, "%s %s", msid, track_id);
-            if (cnt != 2 || strcmp(msid, sdp->wms_id) != 0) {
-                continue;
-            }
-            if (m == 'a') {
-                snprintf(sdp->audio.track_id, sizeof(sdp->audio.track_id), "%s", track_id);
-            } else if (m == 'v') {
-                snprintf(sdp->video.track_id, sizeof(sdp->video.track_id), "%s", track_id);
+    }
+    return m;
+}
+
+static void tuya_p2p_rtc_sdp_decode_rtpmap(rtc_sdp_t *sdp, char *p, char m)
+{
+    int pt = atoi(p);
+
+    char *p1 = strchr(p, ' ');
+    char *p2 = NULL;
+    char *p3 = NULL;
+    if (p1 != NULL) {
+        p1 += 1;
+
+        p2 = strchr(p1, '/');
+        if (p2 != NULL) {
+            *p2 = '\0';
+            p2 += 1;
+
+            p3 = strchr(p2, '/');
+            if (p3 != NULL) {
+                *p3 = '\0';
+                p3 += 1;
             }
-            continue;
         }
-        if (strncmp(p, "a=group:BUNDLE", strlen("a=group:BUNDLE")) == 0) {
-            p += strlen("a=group:BUNDLE");
-            char m1[65] = {0};
-            char m2[65] = {0};
-            char m3[65] = {0};
-            int cnt = sscanf(p, "%s %s %s", m1, m2, m3);
-            if (cnt >= 1) {
-                tuya_p2p_rtc_sdp_add_media(sdp, m1, "");
-            }
-            if (cnt >= 2) {
-                tuya_p2p_rtc_sdp_add_media(sdp, m2, "");
-            }
-            if (cnt >= 3) {
-                tuya_p2p_rtc_sdp_add_media(sdp, m3, "");
-            }
+    }
 
-            continue;
+    if (m == 'a') {
+        tuya_p2p_rtc_sdp_update_audio_codec(sdp, pt, p1, p2, p3);
+    } else if (m == 'v') {
+        tuya_p2p_rtc_sdp_update_video_codec(sdp, pt, p1, p2);
+    } else if (m == 't') {
+    } else {
+        tuya_p2p_log_warn("got invalid rtpmap, m = %c\n", m);
+    }
+}
+
+static void tuya_p2p_rtc_sdp_decode_ssrc(rtc_sdp_t *sdp, char *p1, char m)
+{
+    char *p2 = strchr(p1, ' ');
+    if (p2 != NULL) {
+        *p2 = '\0';
+        p2 += 1;
+
+        if (strncmp(p2, "cname:", strlen("cname:")) == 0) {
+            p2 = p2 + strlen("cname:");
+        } else {
+            p2 = NULL;
         }
-        if (strncmp(p, "m=audio", strlen("m=audio")) == 0) {
-            m = 'a';
-            char tmp[128] = {0};
-            char *ptmp = strstr(p, "SAVPF");
-            if (ptmp != NULL) {
-                snprintf(tmp, sizeof(tmp), "%s", ptmp + strlen("SAVPF") + 1);
-            }
-            char *tmplasts = NULL;
-            char *pt = strtok_r(tmp, " ", &tmplasts);
-            while (pt != NULL) {
-                tuya_p2p_rtc_sdp_add_audio_codec(sdp, NULL, atoi(pt), 0, 0, 0);
-                pt = strtok_r(NULL, " ", &tmplasts);
-            }
-            continue;
+    }
+
+    if (m == 'a') {
+        if (sdp->audio.negotiated_codec.ssrc == 0) {
+            sdp->audio.negotiated_codec.ssrc = strtoul(p1, NULL, 10);
+        } else if (sdp->audio.rtx_codec.ssrc == 0) {
+            sdp->audio.rtx_codec.ssrc = strtoul(p1, NULL, 10);
         }
-        if (strncmp(p, "m=video", strlen("m=video")) == 0) {
-            m = 'v';
-            char tmp[128] = {0};
-            char *ptmp = strstr(p, "SAVPF");
-            if (ptmp != NULL) {
-                snprintf(tmp, sizeof(tmp), "%s", ptmp + strlen("SAVPF") + 1);
-            }
-            char *tmplasts = NULL;
-            char *pt = strtok_r(tmp, " ", &tmplasts);
-            while (pt != NULL) {
-                tuya_p2p_rtc_sdp_add_video_codec(sdp, "", atoi(pt), 0, 0, "");
-                pt = strtok_r(NULL, " ", &tmplasts);
-            }
-            continue;
+    } else if (m == 'v') {
+        if (sdp->video.negotiated_codec.ssrc == 0) {
+            sdp->video.negotiated_codec.ssrc = strtoul(p1, NULL, 10);
+        } else if (sdp->video.rtx_codec.ssrc == 0) {
+            sdp->video.rtx_codec.ssrc = strtoul(p1, NULL, 10);
         }
-        if (strncmp(p, "m=application", strlen("m=application")) == 0) {
-            m = 't';
-            char tmp[128] = {0};
-            char *ptmp = strstr(p, "tuya");
-            if (ptmp != NULL) {
-                snprintf(tmp, sizeof(tmp), "%s", ptmp + strlen("tuya") + 1);
-            }
-            char *tmplasts = NULL;
-            char *pt = strtok_r(tmp, " ", &tmplasts);
-            while (pt != NULL) {
-                tuya_p2p_rtc_sdp_add_tuya_codec(sdp, "", atoi(pt), 0);
-                pt = strtok_r(NULL, " ", &tmplasts);
-            }
-            continue;
+    } else {
+        // do nothing
+    }
+    if (p2 != NULL) {
+        snprintf(sdp->cname, sizeof(sdp->cname), "%s", p2);
+    }
+}
+
+// a= line, the attribute is looked up by its name and its value is read in place
+static void tuya_p2p_rtc_sdp_decode_attr(rtc_sdp_t *sdp, char *line, char m)
+{
+    char *name = line + strlen("a=");
+    char *p = strchr(name, ':');
+    if (p == NULL) {
+        return;
+    }
+    int len = p - name;
+    p += 1;
+
+    uint32_t i;
+    for (i = 0; i < TUYA_P2P_ARRAY_SIZE(sdp_attrs); i++) {
+        if (sdp_attrs[i].len == len && memcmp(sdp_attrs[i].name, name, len) == 0) {
+            break;
         }
-        if (strncmp(p, "a=rtpmap:", strlen("a=rtpmap:")) == 0) {
-            p += strlen("a=rtpmap:");
-            int pt = atoi(p);
-
-            char *p1 = strstr(p, " ");
-            char *p2 = NULL;
-            char *p3 = NULL;
-            if (p1 != NULL) {
-                p1 += 1;
-
-                p2 = strstr(p1, "/");
-                if (p2 != NULL) {
-                    *p2 = '\0';
-                    p2 += 1;
-
-                    p3 = strstr(p2, "/");
-                    if (p3 != NULL) {
-                        *p3 = '\0';
-                        p3 += 1;
-                    }
-                }
-            }
+    }
+    if (i == TUYA_P2P_ARRAY_SIZE(sdp_attrs)) {
+        return;
+    }
 
-            if (m == 'a') {
-                tuya_p2p_rtc_sdp_update_audio_codec(sdp, pt, p1, p2, p3);
-            } else if (m == 'v') {
-                tuya_p2p_rtc_sdp_update_video_codec(sdp, pt, p1, p2);
-            } else if (m == 't') {
-            } else {
-                tuya_p2p_log_warn("got invalid rtpmap, m = %c\n", m);
-            }
-            continue;
+    char *tok1;
+    char *tok2;
+    int n;
+    switch (sdp_attrs[i].attr) {
+    case SDP_ATTR_MSID_SEMANTIC:
+        tok1 = tuya_p2p_rtc_sdp_next_token(&p);
+        tok2 = tuya_p2p_rtc_sdp_next_token(&p);
+        if (tok2 == NULL || strcmp(tok1, "WMS") != 0) {
+            break;
         }
-        if (strncmp(p, "a=fmtp:", strlen("a=fmtp:")) == 0) {
-            p += strlen("a=fmtp:");
-            char str_pt[32] = {0};
-            char str_attr[256] = {0};
-            int cnt = sscanf(p, "%s %s", str_pt, str_attr);
-            if (cnt == 2) {
-                if (strncmp(str_attr, "apt=", strlen("apt=")) == 0) {
-                    int pt = atoi(str_pt);
-                    int original_pt = atoi(str_attr + strlen("apt="));
-                    tuya_p2p_rtc_sdp_set_original_pt(sdp, pt, original_pt);
-                }
-            }
+        snprintf(sdp->wms_id, sizeof(sdp->wms_id), "%s", tok2);
+        break;
+    case SDP_ATTR_MSID:
+        tok1 = tuya_p2p_rtc_sdp_next_token(&p);
+        tok2 = tuya_p2p_rtc_sdp_next_token(&p);
+        if (tok2 == NULL || strcmp(tok1, sdp->wms_id) != 0) {
+            break;
         }
-
-        if (strncmp(p, "a=ssrc-group:FID", strlen("a=ssrc-group:FID")) == 0) {
-            char *p1 = p + strlen("a=ssrc-group:FID");
-            char ssrc[65] = {0};
-            char ssrc_rtx[65] = {0};
-            int cnt = sscanf(p1, "%s %s", ssrc, ssrc_rtx);
-            if (cnt == 2) {
-                if (m == 'a') {
-                    sdp->audio.negotiated_codec.ssrc = strtoul(ssrc, NULL, 10);
-                    sdp->audio.rtx_codec.ssrc = strtoul(ssrc_rtx, NULL, 10);
-                } else if (m == 'v') {
-                    sdp->video.negotiated_codec.ssrc = strtoul(ssrc, NULL, 10);
-                    sdp->video.rtx_codec.ssrc = strtoul(ssrc_rtx, NULL, 10);
-                } else {
-                    // do nothing
-                }
-            }
-            continue;
+        if (m == 'a') {
+            snprintf(sdp->audio.track_id, sizeof(sdp->audio.track_id), "%s", tok2);
+        } else if (m == 'v') {
+            snprintf(sdp->video.track_id, sizeof(sdp->video.track_id), "%s", tok2);
         }
-        if (strncmp(p, "a=ssrc:", strlen("a=ssrc:")) == 0) {
-            char *p1 = p + strlen("a=ssrc:");
-            char *p2 = strstr(p1, " ");
-            if (p2 != NULL) {
-                *p2 = '\0';
-                p2 += 1;
-
-                if (strncmp(p2, "cname:", strlen("cname:")) == 0) {
-                    p2 = p2 + strlen("cname:");
-                } else {
-                    p2 = NULL;
-                }
-            }
-
-            if (p1 != NULL) {
-                if (m == 'a') {
-                    if (sdp->audio.negotiated_codec.ssrc == 0) {
-                        sdp->audio.negotiated_codec.ssrc = strtoul(p1, NULL, 10);
-                    } else if (sdp->audio.rtx_codec.ssrc == 0) {
-                        sdp->audio.rtx_codec.ssrc = strtoul(p1, NULL, 10);
-                    }
-                } else if (m == 'v') {
-                    if (sdp->video.negotiated_codec.ssrc == 0) {
-                        sdp->video.negotiated_codec.ssrc = strtoul(p1, NULL, 10);
-                    } else if (sdp->video.rtx_codec.ssrc == 0) {
-                        sdp->video.rtx_codec.ssrc = strtoul(p1, NULL, 10);
-                    }
-                } else {
-                    // do nothing
-                }
-            }
-            if (p2 != NULL) {
-                snprintf(sdp->cname, sizeof(sdp->cname), "%s", p2);
-            }
-            continue;
+        break;
+    case SDP_ATTR_GROUP:
+        if (strncmp(p, "BUNDLE", strlen("BUNDLE")) != 0) {
+            break;
         }
-
-        if (strncmp(p, "a=mid:", strlen("a=mid:")) == 0) {
-            char *p1 = p + strlen("a=mid:");
-            if (p1 != NULL) {
-                if (m == 'a') {
-                    tuya_p2p_rtc_sdp_set_media_type(sdp, p1, "audio");
-                } else if (m == 'v') {
-                    tuya_p2p_rtc_sdp_set_media_type(sdp, p1, "video");
-                } else {
-                    tuya_p2p_rtc_sdp_set_media_type(sdp, p1, "tuya");
-                }
-            }
-            continue;
+        p += strlen("BUNDLE");
+        for (n = 0; n < 3 && (tok1 = tuya_p2p_rtc_sdp_next_token(&p)) != NULL; n++) {
+            tuya_p2p_rtc_sdp_add_media(sdp, tok1, "");
         }
-
-        if (strncmp(p, "a=ice-ufrag:", strlen("a=ice-ufrag:")) == 0) {
-            snprintf(sdp->ufrag, sizeof(sdp->ufrag), "%s", p + strlen("a=ice-ufrag:"));
-            continue;
+        break;
+    case SDP_ATTR_RTPMAP:
+        tuya_p2p_rtc_sdp_decode_rtpmap(sdp, p, m);
+        break;
+    case SDP_ATTR_FMTP:
+        tok1 = tuya_p2p_rtc_sdp_next_token(&p);
+        tok2 = tuya_p2p_rtc_sdp_next_token(&p);
+        if (tok2 != NULL && strncmp(tok2, "apt=", strlen("apt=")) == 0) {
+            tuya_p2p_rtc_sdp_set_original_pt(sdp, atoi(tok1), atoi(tok2 + strlen("apt=")));
         }
-        if (strncmp(p, "a=ice-pwd:", strlen("a=ice-pwd:")) == 0) {
-            snprintf(sdp->password, sizeof(sdp->password), "%s", p + strlen("a=ice-pwd:"));
-            continue;
+        break;
+    case SDP_ATTR_SSRC_GROUP:
+        if (strncmp(p, "FID", strlen("FID")) != 0) {
+            break;
         }
-        if (strncmp(p, "a=fingerprint:", strlen("a=fingerprint:")) == 0) {
-            snprintf(sdp->fingerprint, sizeof(sdp->fingerprint), "%s", p + strlen("a=fingerprint:"));
-            continue;
+        p += strlen("FID");
+        tok1 = tuya_p2p_rtc_sdp_next_token(&p);
+        tok2 = tuya_p2p_rtc_sdp_next_token(&p);
+        if (tok2 == NULL) {
+            break;
         }
-        if (strncmp(p, "a=aes-key:", strlen("a=aes-key:")) == 0) {
-            snprintf((char *)sdp->aes_key, sizeof(sdp->aes_key), "%s", p + strlen("a=aes-key:"));
-            continue;
+        if (m == 'a') {
+            sdp->audio.negotiated_codec.ssrc = strtoul(tok1, NULL, 10);
+            sdp->audio.rtx_codec.ssrc = strtoul(tok2, NULL, 10);
+        } else if (m == 'v') {
+            sdp->video.negotiated_codec.ssrc = strtoul(tok1, NULL, 10);
+            sdp->video.rtx_codec.ssrc = strtoul(tok2, NULL, 10);
         }
-        if (strncmp(p, "a=candidate:", strlen("a=candidate:")) == 0) {
-            tuya_p2p_rtc_sdp_add_candidate(sdp, p);
+        break;
+    case SDP_ATTR_SSRC:
+        tuya_p2p_rtc_sdp_decode_ssrc(sdp, p, m);
+        break;
+    case SDP_ATTR_MID:
+        if (m == 'a') {
+            tuya_p2p_rtc_sdp_set_media_type(sdp, p, "audio");
+        } else if (m == 'v') {
+            tuya_p2p_rtc_sdp_set_media_type(sdp, p, "video");
+        } else {
+            tuya_p2p_rtc_sdp_set_media_type(sdp, p, "tuya");
+        }
+        break;
+    case SDP_ATTR_ICE_UFRAG:
+        snprintf(sdp->ufrag, sizeof(sdp->ufrag), "%s", p);
+        break;
+    case SDP_ATTR_ICE_PWD:
+        snprintf(sdp->password, sizeof(sdp->password), "%s", p);
+        break;
+    case SDP_ATTR_FINGERPRINT:
+        snprintf(sdp->fingerprint, sizeof(sdp->fingerprint), "%s", p);
+        break;
+    case SDP_ATTR_AES_KEY:
+        snprintf((char *)sdp->aes_key, sizeof(sdp->aes_key), "%s", p);
+        break;
+    case SDP_ATTR_CANDIDATE:
+        tuya_p2p_rtc_sdp_add_candidate(sdp, line);
+        break;
+    }
+}
+
+int tuya_p2p_rtc_sdp_decode(rtc_sdp_t *sdp, char *buf)
+{
+    // one pass over the text: every line is cut in place and handed to the parser of its type,
+    // the first line (v=) is skipped
+    char *p = buf;
+    char m = '0';
+    int first = 1;
+    while (*p != '\0') {
+        if (*p == '\r' || *p == '\n') {
+            p++;
             continue;
         }
+        char *line = p;
+        while (*p != '\0' && *p != '\r' && *p != '\n') {
+            p++;
+        }
+        if (*p != '\0') {
+            *p = '\0';
+            p++;
+        }
+
+        if (first) {
+            first = 0;
+        } else if (line[0] == 'm' && line[1] == '=') {
+            m = tuya_p2p_rtc_sdp_decode_media(sdp, line, m);
+        } else if (line[0] == 'a' && line[1] == '=') {
+            tuya_p2p_rtc_sdp_decode_attr(sdp, line, m);
+        }
     }
 
     if (!QUEUE_EMPTY(&sdp->candidates.queue)) {
@@ -1170,47 +1207,70 @@ int tuya_p2p_rtc_sdp_decode(rtc_sdp_t *sdp, char *buf)
     return 0;
 }
 
-int tuya_p2p_rtc_sdp_negotiate(rtc_sdp_t *local_sdp, rtc_sdp_t *remote_sdp, char *type)
+static QUEUE *tuya_p2p_rtc_sdp_queue_at(QUEUE *h, int index)
 {
     QUEUE *q;
-    if (strcmp(type, "offer") == 0) {
-        memcpy(local_sdp->aes_key, remote_sdp->aes_key, sizeof(local_sdp->aes_key));
+    if (index < 0) {
+        return NULL;
+    }
+    QUEUE_FOREACH(q, h)
+    {
+        if (index-- == 0) {
+            return q;
+        }
+    }
+    return NULL;
+}
 
-        QUEUE_FOREACH(q, &remote_sdp->media_info_list.queue)
-        {
-            media_info_t *m = QUEUE_DATA(q, media_info_t, queue);
-            tuya_p2p_rtc_sdp_add_media(local_sdp, m->mid, m->type);
+static int tuya_p2p_rtc_sdp_queue_index(QUEUE *h, QUEUE *item)
+{
+    QUEUE *q;
+    int index = 0;
+    QUEUE_FOREACH(q, h)
+    {
+        if (q == item) {
+            return index;
         }
+        index++;
     }
+    return -1;
+}
+
+static int tuya_p2p_rtc_sdp_audio_match(rtc_audio_codec_t *codec, rtc_audio_codec_t *tmp_codec)
+{
+    return (strncmp(codec->name, tmp_codec->name, sizeof(codec->name)) == 0) &&
+           (codec->sample_rate == tmp_codec->sample_rate) && (codec->channel_number == tmp_codec->channel_number);
+}
+
+static int tuya_p2p_rtc_sdp_video_match(rtc_video_codec_t *codec, rtc_video_codec_t *tmp_codec)
+{
+    return (strncmp(codec->name, tmp_codec->name, sizeof(codec->name)) == 0) &&
+           (codec->clock_rate == tmp_codec->clock_rate);
+}
+
+// rtx of the negotiated remote video codec
+static int tuya_p2p_rtc_sdp_rtx_match(rtc_sdp_t *remote_sdp, sdp_nego_t *nego, rtc_video_codec_t *codec)
+{
+    int pt = (nego->video_remote != NULL) ? nego->video_remote->pt : remote_sdp->video.negotiated_codec.pt;
+    return strcmp(codec->name, "rtx") == 0 && codec->original_pt == pt;
+}
+
+static void tuya_p2p_rtc_sdp_nego_search(rtc_sdp_t *local_sdp, rtc_sdp_t *remote_sdp, sdp_nego_t *nego)
+{
+    QUEUE *q;
+    QUEUE *tmp_q;
+    memset(nego, 0, sizeof(*nego));
 
     // audio
-    // printf("negotiate codec\n");
     QUEUE_FOREACH(q, &local_sdp->audio.codec_list)
     {
         rtc_audio_codec_t *codec = QUEUE_DATA(q, rtc_audio_codec_t, queue);
-        // printf("local audio pt: %d\n", codec->pt);
-        QUEUE *tmp_q;
         QUEUE_FOREACH(tmp_q, &remote_sdp->audio.codec_list)
         {
             rtc_audio_codec_t *tmp_codec = QUEUE_DATA(tmp_q, rtc_audio_codec_t, queue);
-            // printf("nego audio: %d(%s:%d:%d:%u) - %d(%s:%d:%d:%u)\n",
-            // codec->pt, codec->name, codec->sample_rate, codec->channel_number, codec->ssrc,
-            // tmp_codec->pt, tmp_codec->name, tmp_codec->sample_rate, tmp_codec->channel_number, codec->ssrc);
-            if ((strncmp(codec->name, tmp_codec->name, sizeof(codec->name)) == 0) &&
-                (codec->sample_rate == tmp_codec->sample_rate) &&
-                (codec->channel_number == tmp_codec->channel_number)) {
-                local_sdp->audio.negotiated_codec.channel_number = codec->channel_number;
-                local_sdp->audio.negotiated_codec.sample_rate = codec->sample_rate;
-                local_sdp->audio.negotiated_codec.pt = tmp_codec->pt;
-                local_sdp->audio.negotiated_codec.ssrc = codec->ssrc;
-                snprintf(local_sdp->audio.negotiated_codec.name, sizeof(local_sdp->audio.negotiated_codec.name), "%s",
-                         codec->name);
-                remote_sdp->audio.negotiated_codec.channel_number = tmp_codec->channel_number;
-                remote_sdp->audio.negotiated_codec.sample_rate = tmp_codec->sample_rate;
-                remote_sdp->audio.negotiated_codec.pt = tmp_codec->pt;
-                // remote_sdp->audio.negotiated_codec.ssrc = tmp_codec->ssrc;
-                snprintf(remote_sdp->audio.negotiated_codec.name, sizeof(remote_sdp->audio.negotiated_codec.name), "%s",
-                         tmp_codec->name);
+            if (tuya_p2p_rtc_sdp_audio_match(codec, tmp_codec)) {
+                nego->audio_local = codec;
+                nego->audio_remote = tmp_codec;
                 goto finish_audio;
             }
         }
@@ -1222,30 +1282,12 @@ finish_audio:
     QUEUE_FOREACH(q, &local_sdp->video.codec_list)
     {
         rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
-        // printf("local video pt: %d\n", codec->pt);
-        QUEUE *tmp_q;
         QUEUE_FOREACH(tmp_q, &remote_sdp->video.codec_list)
         {
             rtc_video_codec_t *tmp_codec = QUEUE_DATA(tmp_q, rtc_video_codec_t, queue);
-            if ((strncmp(codec->name, tmp_codec->name, sizeof(codec->name)) == 0) &&
-                (codec->clock_rate == tmp_codec->clock_rate)) {
-                local_sdp->video.negotiated_codec.clock_rate = codec->clock_rate;
-                local_sdp->video.negotiated_codec.pt = tmp_codec->pt;
-                local_sdp->video.negotiated_codec.ssrc = codec->ssrc;
-                local_sdp->video.negotiated_codec.original_pt = -1;
-                snprintf(local_sdp->video.negotiated_codec.profile_level_id,
-                         sizeof(local_sdp->video.negotiated_codec.profile_level_id), "%s", codec->profile_level_id);
-                snprintf(local_sdp->video.negotiated_codec.name, sizeof(local_sdp->video.negotiated_codec.name), "%s",
-                         codec->name);
-                remote_sdp->video.negotiated_codec.clock_rate = tmp_codec->clock_rate;
-                remote_sdp->video.negotiated_codec.pt = tmp_codec->pt;
-                // remote_sdp->video.negotiated_codec.ssrc = tmp_codec->ssrc;
-                remote_sdp->video.negotiated_codec.original_pt = -1;
-                snprintf(remote_sdp->video.negotiated_codec.profile_level_id,
-                         sizeof(remote_sdp->video.negotiated_codec.profile_level_id), "%s",
-                         tmp_codec->profile_level_id);
-                snprintf(remote_sdp->video.negotiated_codec.name, sizeof(remote_sdp->video.negotiated_codec.name), "%s",
-                         tmp_codec->name);
+            if (tuya_p2p_rtc_sdp_video_match(codec, tmp_codec)) {
+                nego->video_local = codec;
+                nego->video_remote = tmp_codec;
                 goto finish_video;
             }
         }
@@ -1253,18 +1295,201 @@ finish_audio:
 
 finish_video:
 
-    // video rtx codec
+    // video rtx codec, the last one listed
     QUEUE_FOREACH(q, &remote_sdp->video.codec_list)
     {
         rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
-        // printf("remote video codec: %s %d %d (negotiated_codec pt = %d)\n",
-        // codec->name, codec->pt, codec->original_pt, local_sdp->video.negotiated_codec.pt);
-        if (strcmp(codec->name, "rtx") == 0 && codec->original_pt == remote_sdp->video.negotiated_codec.pt) {
-            remote_sdp->video.rtx_codec.pt = codec->pt;
-            remote_sdp->video.rtx_codec.ssrc = codec->ssrc;
-            remote_sdp->video.rtx_mode = RTX_MODE_SSRC_MULTIPLEX;
+        if (tuya_p2p_rtc_sdp_rtx_match(remote_sdp, nego, codec)) {
+            nego->rtx_remote = codec;
+        }
+    }
+}
+
+// codecs of a cached result, checked again as the fingerprints may collide
+static int tuya_p2p_rtc_sdp_nego_resolve(rtc_sdp_t *local_sdp, rtc_sdp_t *remote_sdp, sdp_nego_cache_t *entry,
+                                         sdp_nego_t *nego)
+{
+    QUEUE *q1;
+    QUEUE *q2;
+    memset(nego, 0, sizeof(*nego));
+
+    if (entry->audio_local >= 0) {
+        q1 = tuya_p2p_rtc_sdp_queue_at(&local_sdp->audio.codec_list, entry->audio_local);
+        q2 = tuya_p2p_rtc_sdp_queue_at(&remote_sdp->audio.codec_list, entry->audio_remote);
+        if (q1 == NULL || q2 == NULL) {
+            return -1;
+        }
+        nego->audio_local = QUEUE_DATA(q1, rtc_audio_codec_t, queue);
+        nego->audio_remote = QUEUE_DATA(q2, rtc_audio_codec_t, queue);
+        if (!tuya_p2p_rtc_sdp_audio_match(nego->audio_local, nego->audio_remote)) {
+            return -1;
         }
     }
+    if (entry->video_local >= 0) {
+        q1 = tuya_p2p_rtc_sdp_queue_at(&local_sdp->video.codec_list, entry->video_local);
+        q2 = tuya_p2p_rtc_sdp_queue_at(&remote_sdp->video.codec_list, entry->video_remote);
+        if (q1 == NULL || q2 == NULL) {
+            return -1;
+        }
+        nego->video_local = QUEUE_DATA(q1, rtc_video_codec_t, queue);
+        nego->video_remote = QUEUE_DATA(q2, rtc_video_codec_t, queue);
+        if (!tuya_p2p_rtc_sdp_video_match(nego->video_local, nego->video_remote)) {
+            return -1;
+        }
+    }
+    if (entry->rtx_remote >= 0) {
+        q1 = tuya_p2p_rtc_sdp_queue_at(&remote_sdp->video.codec_list, entry->rtx_remote);
+        if (q1 == NULL) {
+            return -1;
+        }
+        nego->rtx_remote = QUEUE_DATA(q1, rtc_video_codec_t, queue);
+        if (!tuya_p2p_rtc_sdp_rtx_match(remote_sdp, nego, nego->rtx_remote)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void tuya_p2p_rtc_sdp_nego_apply(rtc_sdp_t *local_sdp, rtc_sdp_t *remote_sdp, sdp_nego_t *nego)
+{
+    if (nego->audio_local != NULL) {
+        rtc_audio_codec_t *codec = nego->audio_local;
+        rtc_audio_codec_t *tmp_codec = nego->audio_remote;
+        local_sdp->audio.negotiated_codec.channel_number = codec->channel_number;
+        local_sdp->audio.negotiated_codec.sample_rate = codec->sample_rate;
+        local_sdp->audio.negotiated_codec.pt = tmp_codec->pt;
+        local_sdp->audio.negotiated_codec.ssrc = codec->ssrc;
+        snprintf(local_sdp->audio.negotiated_codec.name, sizeof(local_sdp->audio.negotiated_codec.name), "%s",
+                 codec->name);
+        remote_sdp->audio.negotiated_codec.channel_number = tmp_codec->channel_number;
+        remote_sdp->audio.negotiated_codec.sample_rate = tmp_codec->sample_rate;
+        remote_sdp->audio.negotiated_codec.pt = tmp_codec->pt;
+        // remote_sdp->audio.negotiated_codec.ssrc = tmp_codec->ssrc;
+        snprintf(remote_sdp->audio.negotiated_codec.name, sizeof(remote_sdp->audio.negotiated_codec.name), "%s",
+                 tmp_codec->name);
+    }
+
+    if (nego->video_local != NULL) {
+        rtc_video_codec_t *codec = nego->video_local;
+        rtc_video_codec_t *tmp_codec = nego->video_remote;
+        local_sdp->video.negotiated_codec.clock_rate = codec->clock_rate;
+        local_sdp->video.negotiated_codec.pt = tmp_codec->pt;
+        local_sdp->video.negotiated_codec.ssrc = codec->ssrc;
+        local_sdp->video.negotiated_codec.original_pt = -1;
+        snprintf(local_sdp->video.negotiated_codec.profile_level_id,
+                 sizeof(local_sdp->video.negotiated_codec.profile_level_id), "%s", codec->profile_level_id);
+        snprintf(local_sdp->video.negotiated_codec.name, sizeof(local_sdp->video.negotiated_codec.name), "%s",
+                 codec->name);
+        remote_sdp->video.negotiated_codec.clock_rate = tmp_codec->clock_rate;
+        remote_sdp->video.negotiated_codec.pt = tmp_codec->pt;
+        // remote_sdp->video.negotiated_codec.ssrc = tmp_codec->ssrc;
+        remote_sdp->video.negotiated_codec.original_pt = -1;
+        snprintf(remote_sdp->video.negotiated_codec.profile_level_id,
+                 sizeof(remote_sdp->video.negotiated_codec.profile_level_id), "%s", tmp_codec->profile_level_id);
+        snprintf(remote_sdp->video.negotiated_codec.name, sizeof(remote_sdp->video.negotiated_codec.name), "%s",
+                 tmp_codec->name);
+    }
+
+    if (nego->rtx_remote != NULL) {
+        remote_sdp->video.rtx_codec.pt = nego->rtx_remote->pt;
+        remote_sdp->video.rtx_codec.ssrc = nego->rtx_remote->ssrc;
+        remote_sdp->video.rtx_mode = RTX_MODE_SSRC_MULTIPLEX;
+    }
+}
+
+static int tuya_p2p_rtc_sdp_nego_cache_get(uint64_t local_hash, uint64_t remote_hash, sdp_nego_cache_t *entry)
+{
+    int ret = -1;
+    uint32_t i;
+    pthread_mutex_lock(&sdp_nego_cache_lock);
+    for (i = 0; i < SDP_NEGO_CACHE_NUM; i++) {
+        sdp_nego_cache_t *c = &sdp_nego_cache[i];
+        if (c->used != 0 && c->local_hash == local_hash && c->remote_hash == remote_hash) {
+            c->used = ++sdp_nego_cache_used;
+            *entry = *c;
+            sdp_nego_cache_hit++;
+            ret = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sdp_nego_cache_lock);
+    return ret;
+}
+
+// the least recently used result is replaced
+static void tuya_p2p_rtc_sdp_nego_cache_put(sdp_nego_cache_t *entry)
+{
+    uint32_t i;
+    sdp_nego_cache_t *lru = &sdp_nego_cache[0];
+    pthread_mutex_lock(&sdp_nego_cache_lock);
+    for (i = 0; i < SDP_NEGO_CACHE_NUM; i++) {
+        sdp_nego_cache_t *c = &sdp_nego_cache[i];
+        if (c->used != 0 && c->local_hash == entry->local_hash && c->remote_hash == entry->remote_hash) {
+            lru = c;
+            break;
+        }
+        if (c->used < lru->used) {
+            lru = c;
+        }
+    }
+    *lru = *entry;
+    lru->used = ++sdp_nego_cache_used;
+    sdp_nego_cache_miss++;
+    pthread_mutex_unlock(&sdp_nego_cache_lock);
+}
+
+void tuya_p2p_rtc_sdp_nego_cache_clear(void)
+{
+    pthread_mutex_lock(&sdp_nego_cache_lock);
+    memset(sdp_nego_cache, 0, sizeof(sdp_nego_cache));
+    sdp_nego_cache_used = 0;
+    pthread_mutex_unlock(&sdp_nego_cache_lock);
+}
+
+void tuya_p2p_rtc_sdp_nego_cache_stat(uint32_t *hit, uint32_t *miss)
+{
+    pthread_mutex_lock(&sdp_nego_cache_lock);
+    *hit = sdp_nego_cache_hit;
+    *miss = sdp_nego_cache_miss;
+    pthread_mutex_unlock(&sdp_nego_cache_lock);
+}
+
+int tuya_p2p_rtc_sdp_negotiate(rtc_sdp_t *local_sdp, rtc_sdp_t *remote_sdp, char *type)
+{
+    QUEUE *q;
+    if (strcmp(type, "offer") == 0) {
+        memcpy(local_sdp->aes_key, remote_sdp->aes_key, sizeof(local_sdp->aes_key));
+
+        QUEUE_FOREACH(q, &remote_sdp->media_info_list.queue)
+        {
+            media_info_t *m = QUEUE_DATA(q, media_info_t, queue);
+            tuya_p2p_rtc_sdp_add_media(local_sdp, m->mid, m->type);
+        }
+    }
+
+    // viewers of the same app offer the same codecs: their match is looked up instead of searched again
+    sdp_nego_t nego;
+    sdp_nego_cache_t entry;
+    if (tuya_p2p_rtc_sdp_nego_cache_get(local_sdp->caps_hash, remote_sdp->caps_hash, &entry) != 0 ||
+        tuya_p2p_rtc_sdp_nego_resolve(local_sdp, remote_sdp, &entry, &nego) != 0) {
+        tuya_p2p_rtc_sdp_nego_search(local_sdp, remote_sdp, &nego);
+
+        entry.local_hash = local_sdp->caps_hash;
+        entry.remote_hash = remote_sdp->caps_hash;
+        entry.audio_local = tuya_p2p_rtc_sdp_queue_index(&local_sdp->audio.codec_list,
+                                                         nego.audio_local ? &nego.audio_local->queue : NULL);
+        entry.audio_remote = tuya_p2p_rtc_sdp_queue_index(&remote_sdp->audio.codec_list,
+                                                          nego.audio_remote ? &nego.audio_remote->queue : NULL);
+        entry.video_local = tuya_p2p_rtc_sdp_queue_index(&local_sdp->video.codec_list,
+                                                         nego.video_local ? &nego.video_local->queue : NULL);
+        entry.video_remote = tuya_p2p_rtc_sdp_queue_index(&remote_sdp->video.codec_list,
+                                                          nego.video_remote ? &nego.video_remote->queue : NULL);
+        entry.rtx_remote = tuya_p2p_rtc_sdp_queue_index(&remote_sdp->video.codec_list,
+                                                        nego.rtx_remote ? &nego.rtx_remote->queue : NULL);
+        tuya_p2p_rtc_sdp_nego_cache_put(&entry);
+    }
+    tuya_p2p_rtc_sdp_nego_apply(local_sdp, remote_sdp, &nego);
+
     QUEUE_FOREACH(q, &local_sdp->video.codec_list)
     {
         rtc_video_codec_t *codec = QUEUE_DATA(q, rtc_video_codec_t, queue);
@@ -1286,5 +1511,8 @@ finish_video:
     snprintf(remote_sdp->tuya.negotiated_codec.name, sizeof(remote_sdp->tuya.negotiated_codec.name), "AES/KCP");
     remote_sdp->tuya.negotiated_codec.pt = 6001;
 
+    // the negotiated codecs are part of the encoded answer
+    tuya_p2p_rtc_sdp_caps_touch(local_sdp);
+    tuya_p2p_rtc_sdp_caps_touch(remote_sdp);
     return 0;
 }
@@ -53,8 +53,27 @@ typedef struct media_info {
     char mid[65];
 } media_info_t;
 
+#define RTC_SDP_TMPL_MEDIA_NUM  3 // audio, video, tuya
+#define RTC_SDP_TMPL_PT_SIZE    128
+#define RTC_SDP_TMPL_CODEC_SIZE 1536
+
+// codec parts of the encoded sdp, they only change with the codecs, so they are
+// built once and copied into every sdp encoded after
+typedef struct rtc_sdp_tmpl {
+    uint32_t gen; // caps_gen the parts were built for, 0: not built
+    int offer;
+    int pt_len[RTC_SDP_TMPL_MEDIA_NUM]; // -1: the payload list does not fit
+    char pt[RTC_SDP_TMPL_MEDIA_NUM][RTC_SDP_TMPL_PT_SIZE];
+    int codec_off[RTC_SDP_TMPL_MEDIA_NUM];
+    int codec_len[RTC_SDP_TMPL_MEDIA_NUM]; // -1: does not fit, encoded on every call
+    char *codec;
+} rtc_sdp_tmpl_t;
+
 typedef struct rtc_sdp {
     int inited;
+    uint64_t caps_hash; // fingerprint of the codecs, keys the negotiation cache
+    uint32_t caps_gen;  // bumped whenever the codecs or the negotiated codecs change
+    rtc_sdp_tmpl_t tmpl;
     char wms_id[65];
     char cname[65];
     unsigned char aes_key[48];
@@ -103,3 +122,5 @@ int tuya_p2p_rtc_sdp_add_candidate(rtc_sdp_t *sdp, char *candidate);
 int tuya_p2p_rtc_sdp_set_aes_key(rtc_sdp_t *sdp, unsigned char *aes_key, uint32_t len);
 int tuya_p2p_rtc_sdp_get_aes_key(rtc_sdp_t *sdp, unsigned char *aes_key, uint32_t len);
 int tuya_p2p_rtc_sdp_set_dtls_cert_fingerprint(rtc_sdp_t *sdp, char *fingerprint);
+void tuya_p2p_rtc_sdp_nego_cache_clear(void);
+void tuya_p2p_rtc_sdp_nego_cache_stat(uint32_t *hit, uint32_t *miss);
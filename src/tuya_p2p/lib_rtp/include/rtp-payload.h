@@ -47,6 +47,13 @@ void rtp_payload_encode_getinfo(void *encoder, uint16_t *seq, uint32_t *timestam
 /// @return 0-ok, ENOMEM-alloc failed, <0-failed
 int rtp_payload_encode_input(void *encoder, const void *data, int bytes, uint32_t timestamp);
 
+/// Count the RTP packets rtp_payload_encode_input makes of the data, without making them
+/// @param[in] encoder RTP packet encoder(create by rtp_payload_encode_create)
+/// @param[in] data stream data
+/// @param[in] bytes stream length in bytes
+/// @return >=0-packets, <0-failed or not supported by the payload
+int rtp_payload_encode_packets(void *encoder, const void *data, int bytes);
+
 /// Create RTP packet decoder
 /// @param[in] payload RTP payload type, value: [0, 127] (see more about rtp-profile.h)
 /// @param[in] name RTP payload name
@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "rtp-payload-internal.h"
 
 #define RTP_H2645_BITSTREAM_FORMAT_DETECT 1
 
@@ -9,7 +10,10 @@ static const uint8_t *h264_startcode(const uint8_t *data, int bytes)
 {
     int i;
     for (i = 2; i + 1 < bytes; i++) {
-        if (0x01 == data[i] && 0x00 == data[i - 1] && 0x00 == data[i - 2])
+        // a byte above 0x01 can't be any of the last three bytes of a start code
+        if (data[i] > 0x01)
+            i += 2;
+        else if (0x01 == data[i] && 0x00 == data[i - 1] && 0x00 == data[i - 2])
             return data + i + 1;
     }
 
@@ -128,3 +132,42 @@ int rtp_h264_annexb_nalu(const void *h264, int bytes,
 
     return r;
 }
+
+void rtp_h264_nalu_cache_reset(struct rtp_nalu_cache_t *cache, const void *data, int bytes)
+{
+    cache->data = data;
+    cache->bytes = bytes;
+    cache->num = 0;
+}
+
+void rtp_h264_nalu_cache_add(struct rtp_nalu_cache_t *cache, const uint8_t *nalu, int bytes)
+{
+    if (cache->num < 0 || cache->num >= RTP_NALU_CACHE_MAX) {
+        cache->num = -1;
+        return;
+    }
+
+    cache->nalu[cache->num] = nalu;
+    cache->size[cache->num] = bytes;
+    cache->num++;
+}
+
+int rtp_h264_annexb_nalu_cached(struct rtp_nalu_cache_t *cache, const void *h264, int bytes,
+                                int (*handler)(void *param, const uint8_t *nalu, int bytes, int last), void *param)
+{
+    int i, r, num;
+
+    num = cache->num;
+    if (cache->data != h264 || cache->bytes != bytes || num <= 0) {
+        cache->data = NULL;
+        return rtp_h264_annexb_nalu(h264, bytes, handler, param);
+    }
+
+    // good for one frame only, the caller may reuse its buffer
+    cache->data = NULL;
+    r = 0;
+    for (i = 0; i < num && 0 == r; i++) {
+        r = handler(param, cache->nalu[i], cache->size[i], i + 1 < num ? 0 : 1);
+    }
+    return r;
+}
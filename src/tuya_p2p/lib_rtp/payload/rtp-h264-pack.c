@@ -40,6 +40,12 @@ struct rtp_encode_h264_t {
     struct rtp_payload_t handler;
     void *cbparam;
     int size;
+    struct rtp_nalu_cache_t cache;
+};
+
+struct rtp_count_h264_t {
+    struct rtp_encode_h264_t *packer;
+    int packets;
 };
 
 static void *rtp_h264_pack_create(int size, uint8_t pt, uint16_t seq, uint32_t ssrc, struct rtp_payload_t *handler,
@@ -178,7 +184,38 @@ static int rtp_h264_pack_input(void *pack, const void *h264, int bytes, uint32_t
     packer = (struct rtp_encode_h264_t *)pack;
     //	assert(packer->pkt.rtp.timestamp != timestamp || !packer->pkt.payload /*first packet*/);
     packer->pkt.rtp.timestamp = timestamp; //(uint32_t)time * KHz; // ms -> 90KHZ
-    return rtp_h264_annexb_nalu(h264, bytes, rtp_h264_pack_handler, packer);
+    return rtp_h264_annexb_nalu_cached(&packer->cache, h264, bytes, rtp_h264_pack_handler, packer);
+}
+
+static int rtp_h264_pack_count(void *param, const uint8_t *nalu, int bytes, int last)
+{
+    int fu_payload;
+    struct rtp_count_h264_t *count;
+    count = (struct rtp_count_h264_t *)param;
+    (void)last;
+
+    if (bytes + RTP_FIXED_HEADER <= count->packer->size) {
+        count->packets += 1; // single NAL unit packet
+    } else {
+        // FU-A, the NAL unit header is replaced by the FU headers
+        fu_payload = count->packer->size - RTP_FIXED_HEADER - N_FU_HEADER;
+        count->packets += (bytes - 1 + fu_payload - 1) / fu_payload;
+    }
+    rtp_h264_nalu_cache_add(&count->packer->cache, nalu, bytes);
+    return 0;
+}
+
+static int rtp_h264_pack_packets(void *pack, const void *h264, int bytes)
+{
+    struct rtp_count_h264_t count;
+    count.packer = (struct rtp_encode_h264_t *)pack;
+    count.packets = 0;
+    rtp_h264_nalu_cache_reset(&count.packer->cache, h264, bytes);
+    if (0 != rtp_h264_annexb_nalu(h264, bytes, rtp_h264_pack_count, &count)) {
+        count.packer->cache.data = NULL;
+        return -1;
+    }
+    return count.packets;
 }
 
 struct rtp_payload_encode_t *rtp_h264_encode()
@@ -188,6 +225,7 @@ struct rtp_payload_encode_t *rtp_h264_encode()
         rtp_h264_pack_destroy,
         rtp_h264_pack_get_info,
         rtp_h264_pack_input,
+        rtp_h264_pack_packets,
     };
 
     return &packer;
@@ -61,7 +61,7 @@ int rtp_pack_input(void *p, const void *data, int bytes, uint32_t timestamp)
 
     r = 0;
     packer = (struct rtp_packer_t *)p;
-    assert(packer->pkt.rtp.timestamp != timestamp || !packer->pkt.payload /*first packet*/);
+    //	assert(packer->pkt.rtp.timestamp != timestamp || !packer->pkt.payload /*first packet*/);
     packer->pkt.rtp.timestamp = timestamp; // (uint32_t)time * packer->frequency / 1000; // ms -> 8KHZ
     packer->pkt.rtp.m = 0;                 // marker bit alway 0
 
@@ -91,6 +91,14 @@ int rtp_pack_input(void *p, const void *data, int bytes, uint32_t timestamp)
     return r;
 }
 
+int rtp_pack_packets(void *p, const void *data, int bytes)
+{
+    struct rtp_packer_t *packer;
+    packer = (struct rtp_packer_t *)p;
+    (void)data;
+    return (bytes + packer->size - RTP_FIXED_HEADER - 1) / (packer->size - RTP_FIXED_HEADER);
+}
+
 struct rtp_payload_encode_t *rtp_common_encode()
 {
     static struct rtp_payload_encode_t packer = {
@@ -98,6 +106,7 @@ struct rtp_payload_encode_t *rtp_common_encode()
         rtp_pack_destroy,
         rtp_pack_get_info,
         rtp_pack_input,
+        rtp_pack_packets,
     };
 
     return &packer;
@@ -29,6 +29,24 @@ struct rtp_payload_encode_t {
     /// @param[in] time stream UTC time
     /// @return 0-ok, ENOMEM-alloc failed, <0-failed
     int (*input)(void *packer, const void *data, int bytes, uint32_t time);
+
+    /// count the packets input() makes of the data, optional
+    /// @param[in] packer
+    /// @param[in] data stream data
+    /// @param[in] bytes stream length in bytes
+    /// @return >=0-packets, <0-failed
+    int (*packets)(void *packer, const void *data, int bytes);
+};
+
+#define RTP_NALU_CACHE_MAX 16
+
+/// NAL units found by packets(), so the input() of the same frame doesn't search them again
+struct rtp_nalu_cache_t {
+    const void *data;
+    int bytes;
+    int num; // <0: more NAL units than the cache holds
+    const uint8_t *nalu[RTP_NALU_CACHE_MAX];
+    int size[RTP_NALU_CACHE_MAX];
 };
 
 struct rtp_payload_decode_t {
@@ -71,6 +89,12 @@ struct rtp_payload_decode_t *rtp_mp4a_latm_decode(void);
 struct rtp_payload_decode_t *rtp_mpeg4_generic_decode(void);
 struct rtp_payload_decode_t *rtp_mpeg1or2es_decode(void);
 
+void rtp_h264_nalu_cache_reset(struct rtp_nalu_cache_t *cache, const void *data, int bytes);
+void rtp_h264_nalu_cache_add(struct rtp_nalu_cache_t *cache, const uint8_t *nalu, int bytes);
+/// same as rtp_h264_annexb_nalu, with the NAL units of the cache when it holds this data
+int rtp_h264_annexb_nalu_cached(struct rtp_nalu_cache_t *cache, const void *h264, int bytes,
+                                int (*handler)(void *param, const uint8_t *nalu, int bytes, int last), void *param);
+
 int rtp_packet_serialize_header(const struct rtp_packet_t *pkt, void *data, int bytes);
 
 #endif /* !_rtp_payload_internal_h_ */
@@ -61,6 +61,15 @@ int rtp_payload_encode_input(void *encoder, const void *data, int bytes, uint32_
     return ctx->encoder->input(ctx->packer, data, bytes, timestamp);
 }
 
+int rtp_payload_encode_packets(void *encoder, const void *data, int bytes)
+{
+    struct rtp_payload_delegate_t *ctx;
+    ctx = (struct rtp_payload_delegate_t *)encoder;
+    if (!ctx->encoder->packets)
+        return -1;
+    return ctx->encoder->packets(ctx->packer, data, bytes);
+}
+
 void *rtp_payload_decode_create(int payload, const char *name, struct rtp_payload_t *handler, void *cbparam)
 {
     struct rtp_payload_delegate_t *ctx;
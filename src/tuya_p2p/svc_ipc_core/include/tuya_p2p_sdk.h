@@ -28,6 +28,7 @@ typedef struct tagTuyaIpcSdkVar {
     INT_T (*OnSignalDisconnectCallback)();
     INT_T (*OnGetVideoFrameCallback)(MEDIA_FRAME *pMediaFrame);
     INT_T (*OnGetAudioFrameCallback)(MEDIA_FRAME *pMediaFrame);
+    INT_T max_client_num; // Live viewers served at once, 0: 1, 1 at most until base_ice keeps a session per handle
 } TUYA_IPC_SDK_VAR_S;
 
 OPERATE_RET TUYA_APP_Start(TUYA_IPC_SDK_VAR_S *pSdkVar);
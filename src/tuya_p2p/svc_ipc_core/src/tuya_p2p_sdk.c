@@ -35,7 +35,7 @@ OPERATE_RET TUYA_APP_Start(TUYA_IPC_SDK_VAR_S *pSdkVar)
 
     // Initialize P2P component
     MEDIA_STREAM_VAR_T stream_var = {0};
-    stream_var.max_client_num = 1;
+    stream_var.max_client_num = (pSdkVar->max_client_num > 0) ? pSdkVar->max_client_num : 1;
     stream_var.def_live_mode = TRANS_DEFAULT_STANDARD;
     stream_var.recv_buffer_size = 16 * 1024;
     INT_T preconnect = stream_var.low_power ? 0 : 1;
@@ -0,0 +1,166 @@
+/**
+ * @file tuya_ipc_p2p_cmd_chan.h
+ * @brief Command channel of a P2P session.
+ *
+ * The command channel is a byte stream of commands, each a P2P_CMD_PARSE_T
+ * header followed by str_header.length bytes of payload. A read takes what
+ * the stream has into the buffer of the channel and handles every complete
+ * command in it, a command cut by the end of the read stays at the front of
+ * the buffer until the rest of it comes. A request goes to the handler of its
+ * high_cmd in a table given by the caller.
+ *
+ * Handlers answer with p2p_cmd_chan_resp, which copies the response into the
+ * response buffer of the channel. The responses of all the commands of a
+ * read are sent together at its end, a response that does not fit sends the
+ * ones before it first.
+ *
+ * A channel has no lock: it is read and answered by one thread.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TUYA_IPC_P2P_CMD_CHAN_H__
+#define __TUYA_IPC_P2P_CMD_CHAN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tuya_cloud_types.h"
+#include "tuya_ipc_p2p_inner.h"
+
+#define P2P_CMD_MARK (0x12345678) // Custom identification mark, same as the RTP one
+
+#define P2P_CMD_CHAN_RECV_SIZE (4096) // Largest command, header included
+#define P2P_CMD_CHAN_RESP_SIZE (1200) // Responses sent at once, a send buffer segment (TUYA_P2P_SEGMENT_DATA_LEN)
+#define P2P_CMD_CHAN_REQ_MAX   (64)   // Largest req_len of a handler
+#define P2P_CMD_CHAN_READ_MAX  (16)   // Reads at most before the responses are sent and other sessions served
+
+// Control signal header structure
+typedef struct P2P_CMD_PARSE_ {
+    int mark;  // Custom identification mark
+    int reqId; // Client-defined request ID, used as unique identifier
+    C2C_CMD_FIXED_HEADER_T str_header;
+} P2P_CMD_PARSE_T;
+
+#define P2P_CMD_HEAD_LEN (sizeof(P2P_CMD_PARSE_T))
+
+/**
+ * @brief Read the stream, as tuya_p2p_rtc_recv_data
+ *
+ * @param[in] priv: priv of the channel
+ * @param[in] buff: where the bytes go
+ * @param[inout] p_len: room in buff, updated to the bytes read, 0 when none came before timeout_ms
+ * @param[in] timeout_ms: time to wait for bytes, 0: do not wait
+ *
+ * @return OPRT_OK on success or timeout. Others when the session is gone
+ */
+typedef INT_T (*P2P_CMD_RECV_CB)(VOID *priv, CHAR_T *buff, INT_T *p_len, INT_T timeout_ms);
+
+/**
+ * @brief Write the stream
+ *
+ * @return bytes sent, <0 on error
+ */
+typedef INT_T (*P2P_CMD_SEND_CB)(VOID *priv, CHAR_T *buff, INT_T len);
+
+/**
+ * @brief Handle a request
+ *
+ * @param[in] priv: priv of the channel
+ * @param[in] p_cmd: the request header, str_header.length bytes of payload follow it
+ * @param[in] payload: the payload, at least req_len bytes of the handler, zeros past str_header.length
+ */
+typedef VOID (*P2P_CMD_HANDLER_CB)(VOID *priv, P2P_CMD_PARSE_T *p_cmd, CHAR_T *payload);
+
+typedef struct {
+    USHORT_T high_cmd;  // Refer to TY_MAIN_CMD_TYPE_E
+    USHORT_T req_len;   // Payload bytes the handler reads, P2P_CMD_CHAN_REQ_MAX at most
+    P2P_CMD_HANDLER_CB handler;
+} P2P_CMD_HANDLER_T;
+
+typedef struct {
+    CONST P2P_CMD_HANDLER_T *handler; // Handler table
+    UINT_T handler_num;
+    P2P_CMD_HANDLER_CB unknown; // Requests of a high_cmd not in the table, may be NULL
+    P2P_CMD_RECV_CB recv;
+    P2P_CMD_SEND_CB send;
+} P2P_CMD_CHAN_CFG_T;
+
+typedef struct {
+    UINT_T reads;      // Reads that returned bytes
+    UINT_T cmds;       // Requests handled
+    UINT_T resps;      // Responses sent
+    UINT_T resp_sends; // Sends the responses took
+} P2P_CMD_CHAN_STAT_T;
+
+typedef struct {
+    CONST P2P_CMD_CHAN_CFG_T *cfg;
+    VOID *priv;
+    P2P_CMD_CHAN_STAT_T stat;
+    INT_T len;      // Bytes in buff, the first command starts at 0
+    INT_T resp_len; // Bytes in resp_buff
+    CHAR_T buff[P2P_CMD_CHAN_RECV_SIZE];
+    CHAR_T resp_buff[P2P_CMD_CHAN_RESP_SIZE];
+} P2P_CMD_CHAN_T;
+
+/**
+ * @brief Set up a channel
+ *
+ * @param[in] chan: the channel
+ * @param[in] cfg: handlers and stream, kept by the channel
+ * @param[in] priv: given to the callbacks
+ *
+ * @return none
+ */
+VOID p2p_cmd_chan_init(P2P_CMD_CHAN_T *chan, CONST P2P_CMD_CHAN_CFG_T *cfg, VOID *priv);
+
+/**
+ * @brief Drop the bytes read and the responses not sent, for the next session
+ *
+ * @param[in] chan: the channel
+ *
+ * @return none
+ */
+VOID p2p_cmd_chan_reset(P2P_CMD_CHAN_T *chan);
+
+/**
+ * @brief Read what the stream has, handle the complete requests and send their responses
+ *
+ * Only the first read waits up to timeout_ms, the reads after it take what has already come.
+ *
+ * @param[in] chan: the channel
+ * @param[in] timeout_ms: time to wait for the first bytes
+ *
+ * @return requests handled, the error of recv when it fails, OPRT_EXCEED_UPPER_LIMIT for a command
+ *         larger than P2P_CMD_CHAN_RECV_SIZE
+ */
+INT_T p2p_cmd_chan_read(P2P_CMD_CHAN_T *chan, INT_T timeout_ms);
+
+/**
+ * @brief Queue the response to a request
+ *
+ * @param[in] chan: the channel
+ * @param[in] p_cmd: the request, its mark and reqId are answered
+ * @param[in] payload: response payload
+ * @param[in] len: payload length
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET p2p_cmd_chan_resp(P2P_CMD_CHAN_T *chan, CONST P2P_CMD_PARSE_T *p_cmd, CONST VOID *payload, INT_T len);
+
+/**
+ * @brief Send the queued responses
+ *
+ * @param[in] chan: the channel
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET p2p_cmd_chan_flush(P2P_CMD_CHAN_T *chan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TUYA_IPC_P2P_CMD_CHAN_H__ */
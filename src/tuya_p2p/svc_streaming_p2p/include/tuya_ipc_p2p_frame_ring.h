@@ -0,0 +1,173 @@
+/**
+ * @file tuya_ipc_p2p_frame_ring.h
+ * @brief Encoded frames shared by all P2P viewers.
+ *
+ * A frame is packed into RTP packets once, when it is put into the ring, and
+ * stays there until its room is needed by newer frames. Every packet keeps
+ * room in front of it for the private header, which the sender of a viewer
+ * writes there right before sending the packet. Viewers read the ring through
+ * their own reader:
+ * - a reader of video starts at the latest key frame, so a viewer joining in
+ *   the middle of a GOP still gets a decodable stream;
+ * - a frame counts the readers that still have to send it;
+ * - a reader whose next frame is overwritten starts over at the latest key
+ *   frame, the frames it skipped are counted as dropped.
+ *
+ * The ring has no lock: it is written and read by one thread.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#ifndef __TUYA_IPC_P2P_FRAME_RING_H__
+#define __TUYA_IPC_P2P_FRAME_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tuya_cloud_types.h"
+#include "tuya_ipc_p2p.h"
+
+#define P2P_RING_MEDIA_VIDEO (0x1)
+#define P2P_RING_MEDIA_AUDIO (0x2)
+
+typedef VOID *P2P_RING_HANDLE_T;
+
+typedef struct {
+    UINT_T seq;         // Frame sequence number
+    UINT_T media;       // P2P_RING_MEDIA_VIDEO or P2P_RING_MEDIA_AUDIO
+    BOOL_T key_frame;   // Video key frame, every audio frame is one
+    UINT64_T pts;       // Frame PTS (us)
+    UINT64_T timestamp; // Frame absolute time (ms)
+    UINT_T pkt_cnt;     // RTP packets of the frame
+    UINT_T size;        // Bytes the packets take in the ring
+    UINT_T ref_cnt;     // Readers that still have to send the frame
+    CHAR_T *data;       // Packets, read with p2p_ring_packet
+} P2P_RING_FRAME_T;
+
+typedef struct {
+    UINT_T media;   // Media the reader sends, 0: not reading
+    UINT_T next;    // Sequence number of the next frame to send
+    BOOL_T synced;  // FALSE: starts at the latest key frame on the next peek
+    UINT_T sent;    // Frames passed
+    UINT_T dropped; // Frames overwritten before the reader sent them
+} P2P_RING_READER_T;
+
+typedef struct {
+    UINT_T mem_size;    // Bytes allocated for the ring
+    UINT_T frames;      // Frames put
+    UINT_T packets;     // RTP packets made
+    UINT_T overwritten; // Frames overwritten while a reader still had to send them
+} P2P_RING_STAT_T;
+
+/**
+ * @brief Create a ring
+ *
+ * @param[in] buff_size: bytes for the packets, a GOP of the stream should fit
+ * @param[in] frame_num: frames the ring holds at most
+ * @param[in] head_room: bytes kept in front of every packet for the private header
+ * @param[in] reader_max: readers at most
+ * @param[out] p_ring: ring handle
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET p2p_ring_create(UINT_T buff_size, UINT_T frame_num, UINT_T head_room, UINT_T reader_max,
+                            P2P_RING_HANDLE_T *p_ring);
+
+/**
+ * @brief Destroy a ring and its RTP packers
+ *
+ * @param[in] ring: ring handle
+ *
+ * @return none
+ */
+VOID p2p_ring_destroy(P2P_RING_HANDLE_T ring);
+
+/**
+ * @brief Pack a frame into RTP packets and put it into the ring
+ *
+ * The packer of the media is kept across frames and created again when the payload type changes.
+ * Older frames are overwritten to make room.
+ *
+ * @param[in] ring: ring handle
+ * @param[in] media: P2P_RING_MEDIA_VIDEO or P2P_RING_MEDIA_AUDIO
+ * @param[in] payload: RTP payload type
+ * @param[in] name: RTP payload name, see rtp_payload_encode_create
+ * @param[in] p_frame: the frame
+ * @param[in] rtp_ts: RTP timestamp of the frame
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET p2p_ring_put(P2P_RING_HANDLE_T ring, UINT_T media, INT_T payload, CHAR_T *name, MEDIA_FRAME *p_frame,
+                         UINT_T rtp_ts);
+
+/**
+ * @brief Set the media a reader sends, the reader is added on its first media and removed with 0
+ *
+ * A reader given new media starts over at the latest key frame.
+ *
+ * @param[in] ring: ring handle
+ * @param[in] reader: the reader, zeroed before its first use
+ * @param[in] media: P2P_RING_MEDIA_VIDEO and/or P2P_RING_MEDIA_AUDIO, 0: remove
+ *
+ * @return OPRT_OK on success. Others on error, please refer to "tuya_error_code.h"
+ */
+OPERATE_RET p2p_ring_reader_set(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader, UINT_T media);
+
+/**
+ * @brief Get the next frame a reader has to send
+ *
+ * @param[in] ring: ring handle
+ * @param[in] reader: the reader
+ *
+ * @return the frame, NULL when the reader is up to date
+ */
+P2P_RING_FRAME_T *p2p_ring_peek(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader);
+
+/**
+ * @brief Release the frame returned by p2p_ring_peek, the reader moves on to the next one
+ *
+ * @param[in] ring: ring handle
+ * @param[in] reader: the reader
+ *
+ * @return none
+ */
+VOID p2p_ring_pass(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader);
+
+/**
+ * @brief Walk the RTP packets of a frame
+ *
+ * @param[in] ring: ring handle
+ * @param[in] frame: the frame
+ * @param[inout] p_offset: 0 for the first packet, moved to the next one
+ * @param[out] p_len: packet length
+ *
+ * @return the packet, head_room writable bytes in front of it, NULL after the last one
+ */
+CHAR_T *p2p_ring_packet(P2P_RING_HANDLE_T ring, P2P_RING_FRAME_T *frame, UINT_T *p_offset, INT_T *p_len);
+
+/**
+ * @brief Media wanted by the readers
+ *
+ * @param[in] ring: ring handle
+ *
+ * @return P2P_RING_MEDIA_VIDEO and/or P2P_RING_MEDIA_AUDIO, 0 when there is no reader
+ */
+UINT_T p2p_ring_media(P2P_RING_HANDLE_T ring);
+
+/**
+ * @brief Get the ring statistics
+ *
+ * @param[in] ring: ring handle
+ * @param[out] stat: statistics
+ *
+ * @return none
+ */
+VOID p2p_ring_get_stat(P2P_RING_HANDLE_T ring, P2P_RING_STAT_T *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TUYA_IPC_P2P_FRAME_RING_H__ */
@@ -9,11 +9,14 @@
 #include "tal_mutex.h"
 #include "tal_system.h"
 #include "tal_memory.h"
+#include "tal_mem_budget.h"
 #include "tal_thread.h"
 #include "tuya_ipc_p2p.h"
 #include "tuya_ipc_p2p_error.h"
 #include "tuya_ipc_p2p_inner.h"
 #include "tuya_ipc_p2p_common.h"
+#include "tuya_ipc_p2p_cmd_chan.h"
+#include "tuya_ipc_p2p_frame_ring.h"
 #include "tuya_media_service_rtc.h"
 #include "rtp-payload.h"
 
@@ -31,8 +34,26 @@
 #define TUYA_IPC_P2P_DEFAULT_CAMERA (0)
 #define P2P_RTP_PACK_LEN            (1100 + 128) // RTP packet buffer size
 #define P2P_RECV_TIMEOUT            (30)
+#define P2P_CMD_IDLE_SLEEP          (5) // ms, no session or no command on any of them
+#define P2P_SESSION_MAX             (1) // Live viewers served at once, base_ice keeps a single RTC session
+
+// With ENABLE_P2P_FRAME_RING frames are packed once into a ring shared by all sessions, a GOP of the main stream
+// should fit for each session. Without it, each session packs a frame and sends every packet as it is made.
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+#ifndef P2P_FRAME_RING_SESSION_SIZE
+#define P2P_FRAME_RING_SESSION_SIZE (512 * 1024)
+#endif
+#ifndef P2P_FRAME_RING_NUM
+#define P2P_FRAME_RING_NUM (128)
+#endif
+#endif
 
 #define P2P_CHECK_USER_TIMES (10000) // 10s
+
+// bytes of frame buffers P2P may hold, 0: not limited
+#ifndef P2P_MEDIA_MEM_BUDGET
+#define P2P_MEDIA_MEM_BUDGET 0
+#endif
 // Password synchronization structure
 typedef struct P2P_CMD_PASSWD_ {
     int mark;        // Custom identification mark
@@ -41,24 +62,10 @@ typedef struct P2P_CMD_PASSWD_ {
     char passwd[64]; // Password
 } P2P_CMD_PASSWD_T;
 
-// Control signal header structure
-typedef struct P2P_CMD_PARSE_ {
-    int mark;  // Custom identification mark
-    int reqId; // Client-defined request ID, used as unique identifier
-    C2C_CMD_FIXED_HEADER_T str_header;
-} P2P_CMD_PARSE_T;
-
-#define P2P_CMD_PARSE_MAX_SIZE_V2 (4096)
-#define P2P_CMD_HEAD_LEN          (sizeof(P2P_CMD_PARSE_T))
-
 #define MAX_PAYLOAD_SIZE (1100) /**MAX PAYLOAD SIZE*/
 #define RTP_MTU_LEN      MAX_PAYLOAD_SIZE
 #define RTP_SPLIT_LEN    RTP_MTU_LEN
 #define TUYA_RTP_HEAD    0x12345678    // Custom RTP identification packet header
-#define P2P_CMD_MARK     TUYA_RTP_HEAD // Temporarily reuse with RTP
-
-#define READ_HEADER_PART  0 // Read header part
-#define READ_PAYLOAD_PART 1 // Read payload part
 
 #define EXT_PROTOCOL_V0_LEN (12)
 #define P2P_EXT_HEAD_MAX_LEN                                                                                           \
@@ -73,14 +80,6 @@ typedef struct P2P_CMD_PARSE_ {
 #define STACK_SIZE_P2P_DETECT     65536
 #define STACK_SIZE_P2P_LISTEN     131072
 
-typedef struct {
-    INT_T client;
-    INT_T channel;
-    CHAR_T *p_rtp_buff;                         // RTP data buffer, reference size MTU+100
-    INT_T fix_len;                              // Supplementary private header data
-    CHAR_T ext_head_buff[P2P_EXT_HEAD_MAX_LEN]; // According to extended video header protocol head+ext(8)+rtp_len
-} RTP_PACK_NAL_ARG_T;
-
 typedef enum {
     P2P_IDLE = 0,
     P2P_VIDEO = 0x1, // Start live stream request
@@ -91,35 +90,36 @@ typedef enum {
     P2P_SPEAKER = 0x20,  // Intercom request
 } P2P_CMD_E;
 
-typedef struct {
-    INT_T read_size; // init P2P_CMD_HEAD_LEN;
-    CHAR_T read_buff[P2P_CMD_PARSE_MAX_SIZE_V2];
-    INT_T cur_read; // Current read length
-    INT_T flag;     // READ_HEADER_PART/READ_PAYLOAD_PART
-} P2P_DATA_PARSE_T;
-
 typedef struct {
     MUTEX_HANDLE cmutex;
-    TUYA_IPC_P2P_AUTH_T str_P2p_auth;
     /*******client*******/
     INT_T session; // Save session number
     INT_T status;  // Session status  0 not started
     /*******p2p server*******/
     P2P_CMD_E cmd; // Signal status information
     P2P_CMD_PARSE_T pb_resp_head;
-    CHAR_T *p_video_rtp_buff; // Video RTP data buffer, reference size MTU+100
-    CHAR_T *p_audio_rtp_buff; // Audio RTP data buffer, reference size MTU+100
-    USHORT_T video_seq_num;   // Video RTP packet sequence number
-    USHORT_T audio_seq_num;   // Audio RTP packet sequence number
-    BOOL_T key_frame;
-    UINT64_T v_pts;                                  // Video PTS
-    UINT64_T v_timestamp;                            // Video absolute time (ms)
-    UINT64_T a_pts;                                  // Audio PTS
-    UINT64_T a_timestamp;                            // Audio absolute time (ms)
+    USHORT_T video_seq_num;                          // Video RTP packet sequence number
+    USHORT_T audio_seq_num;                          // Audio RTP packet sequence number
     INT_T video_req_id;                              // Video request ID, used for preview, playback and other services
     INT_T audio_req_id;                              // Audio request ID
     TRANSFER_VIDEO_CLARITY_TYPE_INNER_E cur_clarity; // Current video clarity type
-    P2P_DATA_PARSE_T proto_parse;
+    P2P_CMD_CHAN_T cmd_chan; // Commands read and responses not sent yet
+    /******* media send thread only*******/
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    P2P_RING_READER_T reader; // Frames of the shared ring still to send
+    BOOL_T reader_restart;    // Session released, the reader starts over
+#else
+    VOID *packer[2];                        // RTP packers of video and audio, kept across frames
+    INT_T packer_pt[2];                     // Payload type of each packer
+    CHAR_T *rtp_buff;                       // Packet being sent, P2P_EXT_HEAD_MAX_LEN in front of it
+    P2P_RING_FRAME_T pack_frame;            // Frame being packed, without its packets
+    CHAR_T pack_head[P2P_EXT_HEAD_MAX_LEN]; // Private header of the frame being packed
+    INT_T pack_fix_len;                     // Length of pack_head
+#endif
+} P2P_SESSION_T;
+
+typedef struct {
+    TUYA_IPC_P2P_AUTH_T str_P2p_auth;
     TRANS_IPC_AV_INFO_T av_Info; // TODO currently video parameters must be consistent
 
     tuya_p2p_rtc_disconnect_cb_t on_disconnect_callback;
@@ -127,14 +127,19 @@ typedef struct {
     tuya_p2p_rtc_get_frame_cb_t on_get_audio_frame_callback;
     THREAD_HANDLE cmd_recv_proc_thread;   // Command receive thread handle
     THREAD_HANDLE video_send_proc_thread; // Video send thread handle
-    // TAL_VENC_FRAME_T tal_video_frame;
-    // TAL_AUDIO_FRAME_INFO_T tal_audio_frame;
     MEDIA_FRAME media_frame;
     MEDIA_FRAME media_audio_frame;
-    /******* p2p server*******/
-} P2P_SESSION_T;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    P2P_RING_HANDLE_T frame_ring; // Frames packed once for all sessions
+#endif
 
-STATIC P2P_SESSION_T *sg_p2p_session = NULL;
+    INT_T session_num;
+    P2P_SESSION_T *session; // Session table of session_num
+} P2P_CTL_T;
+
+STATIC P2P_CTL_T sg_p2p_ctl;
+// the frames handed to P2P are large, PSRAM is preferred
+STATIC TAL_MEM_BUDGET_DEFINE(sg_p2p_media_budget, "p2p_media", P2P_MEDIA_MEM_BUDGET, TAL_MEM_PLACE_PSRAM, 0);
 INT_T g_listen_start = 0;               // Flag variable to control listen thread start or stop
 THREAD_HANDLE g_listen_thrd_hdl = NULL; // Listen thread handle
 
@@ -142,20 +147,12 @@ OPERATE_RET p2p_deal_with_listen(INT_T session);
 OPERATE_RET p2p_get_userinfo(INT_T session, INT_T p2pType);
 IPC_STREAM_TYPE p2p_get_chn_idx(TRANSFER_VIDEO_CLARITY_TYPE_INNER_E cur_clarity);
 TRANSFER_VIDEO_CLARITY_TYPE p2p_clarity_trans(TRANSFER_VIDEO_CLARITY_TYPE_INNER_E type);
-INT_T p2p_prepare_video_send_resource(P2P_SESSION_T *pSession);
-INT_T p2p_release_video_send_resource(P2P_SESSION_T *pSession);
-INT_T p2p_prepare_audio_send_resource(P2P_SESSION_T *pSession);
-INT_T p2p_release_audio_send_resource(P2P_SESSION_T *pSession);
 INT_T __p2p_session_clear(P2P_SESSION_T *pSession);
 INT_T __p2p_session_all_stop(P2P_SESSION_T *pSession);
 INT_T __p2p_session_release_va(P2P_SESSION_T *pSession);
 VOID __p2p_thread_exit(THREAD_HANDLE thread);
 VOID __p2p_rtc_close(INT_T rtc_session, INT_T reason, P2P_SESSION_T* p2p_session);
 
-void *rtp_alloc(void *param, int bytes);
-void rtp_free(void *param, void *packet);
-int rtp_pack_packet_handler(void *param, const void *packet, int bytes, uint32_t timestamp, int flags);
-
 void ctx_listen_thread_func(void *arg)
 {
     printf("listen task start\n");
@@ -206,16 +203,23 @@ OPERATE_RET p2p_rtc_listen_stop()
 
 P2P_SESSION_T *p2p_get_idle_session(INT_T *index)
 {
-    INT_T status = -1;
+    P2P_SESSION_T *pSession = NULL;
     INT_T i;
-    if (sg_p2p_session == NULL)
+
+    if (NULL == sg_p2p_ctl.session) {
         return NULL;
+    }
     PR_DEBUG("p2p_get_idle_session begin\n");
-    status = sg_p2p_session->status;
-    if (P2P_SESSION_IDLE == status) {
-        *index = i;
-        sg_p2p_session->status = P2P_SESSION_INITING;
-        return sg_p2p_session;
+    for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+        pSession = &sg_p2p_ctl.session[i];
+        tal_mutex_lock(pSession->cmutex);
+        if (P2P_SESSION_IDLE == pSession->status) {
+            pSession->status = P2P_SESSION_INITING;
+            tal_mutex_unlock(pSession->cmutex);
+            *index = i;
+            return pSession;
+        }
+        tal_mutex_unlock(pSession->cmutex);
     }
     PR_DEBUG("p2p_get_idle_session end\n");
     return NULL;
@@ -223,8 +227,9 @@ P2P_SESSION_T *p2p_get_idle_session(INT_T *index)
 
 OPERATE_RET p2p_deal_with_listen(INT_T session)
 {
-    OPERATE_RET ret = OPRT_OK;
     BOOL_T userCheckEnable = FALSE;
+    P2P_SESSION_T *pSession = NULL;
+    INT_T index = 0;
 
     // First verify user information, close corresponding session if not qualified
     if (OPRT_OK != p2p_get_userinfo(session, 1)) {
@@ -234,7 +239,7 @@ OPERATE_RET p2p_deal_with_listen(INT_T session)
         if (FALSE == userCheckEnable) {
             PR_ERR("resend p2p passwd to service");
             // Resend passwd once
-            if (OPRT_OK == tuya_ipc_p2p_update_pw(sg_p2p_session->str_P2p_auth.p2p_passwd)) {
+            if (OPRT_OK == tuya_ipc_p2p_update_pw(sg_p2p_ctl.str_P2p_auth.p2p_passwd)) {
                 userCheckEnable = TRUE;
             }
         }
@@ -247,20 +252,21 @@ OPERATE_RET p2p_deal_with_listen(INT_T session)
         userCheckEnable = TRUE;
     }
 
-    // Request session-related resources
-    if (OPRT_OK != (ret = p2p_prepare_video_send_resource(sg_p2p_session))) {
-        goto RET;
-    }
-    if (OPRT_OK != (ret = p2p_prepare_audio_send_resource(sg_p2p_session))) {
-        goto RET;
+    pSession = p2p_get_idle_session(&index);
+    if (NULL == pSession) {
+        PR_ERR("no idle session for session[%d], %d viewers at most", session, sg_p2p_ctl.session_num);
+        __p2p_rtc_close(session, RTC_CLOSE_REASON_SESSION_FULL, NULL);
+        return OPRT_EXCEED_UPPER_LIMIT;
     }
 
-    // Save connection information
-    sg_p2p_session->session = session;
-    sg_p2p_session->status = P2P_SESSION_RUNNING;
+    // Save connection information, the media send thread picks the session up
+    tal_mutex_lock(pSession->cmutex);
+    pSession->session = session;
+    pSession->status = P2P_SESSION_RUNNING;
+    tal_mutex_unlock(pSession->cmutex);
+    PR_DEBUG("session[%d] takes slot %d", session, index);
 
-RET:
-    return ret;
+    return OPRT_OK;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -335,11 +341,11 @@ OPERATE_RET p2p_get_userinfo(INT_T session, INT_T p2pType)
     tal_md5_create_init(&md5);
     tal_md5_starts_ret(md5);
     unsigned char decrypt[16];
-    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_session->str_P2p_auth.p2p_passwd),
-                       strlen(sg_p2p_session->str_P2p_auth.p2p_passwd));
+    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_ctl.str_P2p_auth.p2p_passwd),
+                       strlen(sg_p2p_ctl.str_P2p_auth.p2p_passwd));
     tal_md5_update_ret(md5, (BYTE_T *)"||", 2);
-    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_session->str_P2p_auth.gw_local_key),
-                       strlen(sg_p2p_session->str_P2p_auth.gw_local_key));
+    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_ctl.str_P2p_auth.gw_local_key),
+                       strlen(sg_p2p_ctl.str_P2p_auth.gw_local_key));
     tal_md5_finish_ret(md5, decrypt);
     tal_md5_free(md5);
 
@@ -351,7 +357,7 @@ OPERATE_RET p2p_get_userinfo(INT_T session, INT_T p2pType)
     }
     sign[offset] = 0;
 
-    if (strcmp(strUserInfo.user, sg_p2p_session->str_P2p_auth.p2p_name) == 0 && strcmp(strUserInfo.passwd, sign) == 0) {
+    if (strcmp(strUserInfo.user, sg_p2p_ctl.str_P2p_auth.p2p_name) == 0 && strcmp(strUserInfo.passwd, sign) == 0) {
         PR_DEBUG("auth success");
         return OPRT_OK;
     }
@@ -359,8 +365,8 @@ OPERATE_RET p2p_get_userinfo(INT_T session, INT_T p2pType)
     CHAR_T lk_dm5[32 + 1] = {0};
     tal_md5_create_init(&md5);
     tal_md5_starts_ret(md5);
-    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_session->str_P2p_auth.gw_local_key),
-                       strlen(sg_p2p_session->str_P2p_auth.gw_local_key));
+    tal_md5_update_ret(md5, (BYTE_T *)(sg_p2p_ctl.str_P2p_auth.gw_local_key),
+                       strlen(sg_p2p_ctl.str_P2p_auth.gw_local_key));
     tal_md5_finish_ret(md5, decrypt);
     tal_md5_free(md5);
     offset = 0;
@@ -430,99 +436,19 @@ TRANSFER_VIDEO_CLARITY_TYPE p2p_clarity_trans(TRANSFER_VIDEO_CLARITY_TYPE_INNER_
     return eVideoClarityHigh;
 }
 
-INT_T p2p_prepare_video_send_resource(P2P_SESSION_T *pSession)
-{
-    if (pSession == NULL) {
-        PR_DEBUG("session is NULL");
-        return OPRT_INVALID_PARM;
-    }
-
-    if (NULL != pSession->p_video_rtp_buff) {
-        return OPRT_OK;
-    }
-
-    pSession->p_video_rtp_buff = (CHAR_T *)Malloc(P2P_RTP_PACK_LEN);
-    if (NULL == pSession->p_video_rtp_buff) {
-        PR_ERR("session:[%d] video rtp buffer malloc failed", pSession->session);
-        return OPRT_MALLOC_FAILED;
-    }
-    memset(pSession->p_video_rtp_buff, 0x00, P2P_RTP_PACK_LEN);
-
-    PR_DEBUG("session:[%d] malloc video send buffer success", pSession->session);
-    return OPRT_OK;
-}
-
-INT_T p2p_release_video_send_resource(P2P_SESSION_T *pSession)
-{
-    if (pSession == NULL) {
-        PR_DEBUG("session is NULL");
-        return OPRT_INVALID_PARM;
-    }
-
-    if (NULL == pSession->p_video_rtp_buff) {
-        return OPRT_OK;
-    }
-
-    Free(pSession->p_video_rtp_buff);
-    pSession->p_video_rtp_buff = NULL;
-
-    PR_DEBUG("session:[%d] release video send buffer success", pSession->session);
-    return OPRT_OK;
-}
-
-INT_T p2p_prepare_audio_send_resource(P2P_SESSION_T *pSession)
-{
-    if (pSession == NULL) {
-        PR_DEBUG("session is NULL");
-        return OPRT_INVALID_PARM;
-    }
-
-    if (NULL != pSession->p_audio_rtp_buff) {
-        return OPRT_OK;
-    }
-
-    pSession->p_audio_rtp_buff = (CHAR_T *)Malloc(P2P_RTP_PACK_LEN);
-    if (NULL == pSession->p_audio_rtp_buff) {
-        PR_ERR("session:[%d] audio rtp buffer malloc failed", pSession->session);
-        return OPRT_MALLOC_FAILED;
-    }
-    memset(pSession->p_audio_rtp_buff, 0x00, P2P_RTP_PACK_LEN);
-
-    PR_DEBUG("session:[%d] malloc audio send buffer success", pSession->session);
-    return OPRT_OK;
-}
-
-INT_T p2p_release_audio_send_resource(P2P_SESSION_T *pSession)
-{
-    if (pSession == NULL) {
-        PR_DEBUG("session is NULL");
-        return OPRT_INVALID_PARM;
-    }
-
-    if (NULL == pSession->p_audio_rtp_buff) {
-        return OPRT_OK;
-    }
-
-    Free(pSession->p_audio_rtp_buff);
-    pSession->p_audio_rtp_buff = NULL;
-
-    PR_DEBUG("session:[%d] release audio send buffer success", pSession->session);
-    return OPRT_OK;
-}
-
-OPERATE_RET p2p_send_rtp_data(INT_T client, INT_T channel, CHAR_T *buff, INT_T length)
+OPERATE_RET p2p_send_rtp_data(P2P_SESSION_T *pSession, INT_T channel, CHAR_T *buff, INT_T length)
 {
     if (channel < TUYA_VDATA_CHANNEL || channel > TUYA_ADATA_CHANNEL) {
-        PR_ERR("input errorclient[%d]channel[%d]", client, channel);
+        PR_ERR("input error session[%d]channel[%d]", pSession->session, channel);
         return OPRT_INVALID_PARM;
     }
     INT_T ret = 0;
     // Send data
-    if ((0 == (P2P_VIDEO & sg_p2p_session->cmd)) && (0 == (P2P_PB_VIDEO & sg_p2p_session->cmd)) &&
-        (0 == (P2P_AUDIO & sg_p2p_session->cmd)) && (0 == (P2P_PB_AUDIO & sg_p2p_session->cmd))) {
+    if ((0 == (P2P_VIDEO & pSession->cmd)) && (0 == (P2P_PB_VIDEO & pSession->cmd)) &&
+        (0 == (P2P_AUDIO & pSession->cmd)) && (0 == (P2P_PB_AUDIO & pSession->cmd))) {
         return OPRT_OK;
     }
-    ret = tuya_p2p_rtc_send_data(sg_p2p_session->session, channel, buff, length, -1);
+    ret = tuya_p2p_rtc_send_data(pSession->session, channel, buff, length, -1);
     if (ret != length) {
         PR_ERR("Write data failed [%d][%d]", ret, length);
     }
@@ -532,11 +458,12 @@ OPERATE_RET p2p_send_rtp_data(INT_T client, INT_T channel, CHAR_T *buff, INT_T l
 /***********************************************************
  *  Function: __p2p_ext_protocol_pack
  *  Note:Transport extension protocol packet assembly
- *  Input: client channel number, pResult result buffer, type 0/1 video/audio
+ *  Input: pSession session, type 0/1 video/audio, p_frame frame being sent, pResult result buffer
  *  Output: pResultLen result buffer size
  *  Return:
  ***********************************************************/
-STATIC VOID __p2p_ext_protocol_pack(INT_T client, INT_T type, CHAR_T *p_result, INT_T *p_result_len)
+STATIC VOID __p2p_ext_protocol_pack(P2P_SESSION_T *pSession, INT_T type, P2P_RING_FRAME_T *p_frame, CHAR_T *p_result,
+                                    INT_T *p_result_len)
 {
     if (NULL == p_result || NULL == p_result_len) {
         PR_ERR("input error");
@@ -544,65 +471,77 @@ STATIC VOID __p2p_ext_protocol_pack(INT_T client, INT_T type, CHAR_T *p_result,
     }
 
     INT_T fix_len = 0; // 20180428 supplementary header data
-    UINT64_T tmpTime;
-    INT_T ipcChan = client;
-    IPC_STREAM_E curClirtyChn = p2p_get_chn_idx(sg_p2p_session->cur_clarity);
+    IPC_STREAM_E curClirtyChn = p2p_get_chn_idx(pSession->cur_clarity);
     C2C_AV_TRANS_FIXED_HEADER *pav_Info = (C2C_AV_TRANS_FIXED_HEADER *)p_result;
 
     if (0 == type) {
-        tmpTime = sg_p2p_session->v_timestamp;
-        pav_Info->request_id = sg_p2p_session->video_req_id;
-        if (TRUE == sg_p2p_session->key_frame) {
+        pav_Info->request_id = pSession->video_req_id;
+        if (TRUE == p_frame->key_frame) {
             fix_len = sizeof(C2C_AV_TRANS_FIXED_HEADER) + EXT_PROTOCOL_V0_LEN;
             pav_Info->extension_length = 8;
             *(BYTE_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER)] = TY_EXT_VIDEO_PARAM;
             *(BYTE_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 1] = 0;
             *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 2] =
-                (SHORT_T)sg_p2p_session->av_Info.width[curClirtyChn];
+                (SHORT_T)sg_p2p_ctl.av_Info.width[curClirtyChn];
             *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 4] =
-                (SHORT_T)sg_p2p_session->av_Info.height[curClirtyChn];
+                (SHORT_T)sg_p2p_ctl.av_Info.height[curClirtyChn];
             *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 6] =
-                (SHORT_T)sg_p2p_session->av_Info.fps[curClirtyChn];
+                (SHORT_T)sg_p2p_ctl.av_Info.fps[curClirtyChn];
         } else {
             fix_len = sizeof(C2C_AV_TRANS_FIXED_HEADER) + 4;
             pav_Info->extension_length = 0;
         }
     } else {
-        tmpTime = sg_p2p_session->a_timestamp;
-        pav_Info->request_id = sg_p2p_session->audio_req_id;
+        pav_Info->request_id = pSession->audio_req_id;
         fix_len = sizeof(C2C_AV_TRANS_FIXED_HEADER) + EXT_PROTOCOL_V0_LEN;
         pav_Info->extension_length = 8;
         *(BYTE_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER)] = TY_EXT_AUDIO_PARAM;
         *(BYTE_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 1] = 0;
-        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 2] = (SHORT_T)sg_p2p_session->av_Info.audio_sample;
-        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 4] = (SHORT_T)sg_p2p_session->av_Info.audio_channel;
-        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 6] = (SHORT_T)sg_p2p_session->av_Info.audio_databits;
+        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 2] = (SHORT_T)sg_p2p_ctl.av_Info.audio_sample;
+        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 4] = (SHORT_T)sg_p2p_ctl.av_Info.audio_channel;
+        *(SHORT_T *)&p_result[sizeof(C2C_AV_TRANS_FIXED_HEADER) + 6] = (SHORT_T)sg_p2p_ctl.av_Info.audio_databits;
     }
-    pav_Info->time_ms = tmpTime;
+    pav_Info->time_ms = p_frame->timestamp;
     *p_result_len = fix_len;
 
     return;
 }
 
-STATIC OPERATE_RET __p2p_check_free_buffer_size(INT_T client, INT_T channel, INT_T len)
+STATIC OPERATE_RET __p2p_check_free_buffer_size(P2P_SESSION_T *pSession, INT_T channel, P2P_RING_FRAME_T *p_frame,
+                                                INT_T fix_len)
 {
     OPERATE_RET ret = OPRT_OK;
     INT_T sendFreeSize = 0;
     INT_T writeSize = 0;
+    INT_T need_size = 0;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    UINT_T offset = 0;
+    INT_T len = 0;
+#endif
 
-    ret = tuya_p2p_rtc_check_buffer(sg_p2p_session->session, channel, (uint32_t *)&writeSize, NULL,
+    ret = tuya_p2p_rtc_check_buffer(pSession->session, channel, (uint32_t *)&writeSize, NULL,
                                     (uint32_t *)&sendFreeSize);
     if (OPRT_OK != ret) {
         return ret;
     }
 
-    INT_T rtp_cnt = len / RTP_MTU_LEN + 1;
-    INT_T need_size = rtp_cnt * 1600; // kcp send, one segment occupies 1600 bytes
-    if (need_size > sendFreeSize) {
+    // Each RTP packet is sent on its own with the private header and takes whole send buffer segments
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    while (NULL != p2p_ring_packet(sg_p2p_ctl.frame_ring, p_frame, &offset, &len)) {
+        need_size +=
+            (fix_len + len + TUYA_P2P_SEGMENT_DATA_LEN - 1) / TUYA_P2P_SEGMENT_DATA_LEN * TUYA_P2P_SEGMENT_SIZE;
+    }
+#else
+    // the packets are not made yet, count them all at the largest size
+    need_size = p_frame->pkt_cnt * ((fix_len + rtp_packet_getsize() + TUYA_P2P_SEGMENT_DATA_LEN - 1) /
+                                    TUYA_P2P_SEGMENT_DATA_LEN * TUYA_P2P_SEGMENT_SIZE);
+#endif
+    // A frame larger than the whole buffer is sent once the buffer has drained
+    if (need_size > sendFreeSize && writeSize > 0) {
         STATIC INT_T retry_sum = 0; // Total retry count when buffer is full
         if (retry_sum % 100 == 0) {
-            PR_ERR("Check_Buffer not enough writeSize[%d] sendFreeSize[%d] len[%d] session[%d] channel[%d]", writeSize,
-                   sendFreeSize, len, sg_p2p_session->session, channel);
+            PR_ERR("Check_Buffer not enough writeSize[%d] sendFreeSize[%d] rtp_cnt[%d] session[%d] channel[%d]",
+                   writeSize, sendFreeSize, p_frame->pkt_cnt, pSession->session, channel);
         }
         retry_sum++;
         ret = OPRT_RESOURCE_NOT_READY;
@@ -610,111 +549,241 @@ STATIC OPERATE_RET __p2p_check_free_buffer_size(INT_T client, INT_T channel, INT
     return ret;
 }
 
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
 /***********************************************************
- *  Function: __p2p_pack_h265_rtp_and_send
- *  Note:IPC stream data assembly RTP and send
- *  Input: pData data header address, len data length, client channel number
+ *  Function: __p2p_session_send_frame
+ *  Note:Send the RTP packets of a frame of the shared ring to a session. The packets are shared
+ *       by all sessions, the private header and the RTP sequence number of the session are
+ *       written into them right before each one is sent
+ *  Input: pSession session, p_frame frame
  *  Output: none
- *  Return:
+ *  Return: OPRT_RESOURCE_NOT_READY when the send buffer can't take the frame yet
  ***********************************************************/
-STATIC OPERATE_RET __p2p_pack_h265_rtp_and_send(INT_T client, CHAR_T *pData, INT_T len)
+STATIC OPERATE_RET __p2p_session_send_frame(P2P_SESSION_T *pSession, P2P_RING_FRAME_T *p_frame)
 {
-    if (NULL == pData) {
-        PR_ERR("input error");
-        return OPRT_INVALID_PARM;
-    }
-
-    OPERATE_RET ret = __p2p_check_free_buffer_size(client, TUYA_VDATA_CHANNEL, len);
+    OPERATE_RET ret = OPRT_OK;
+    INT_T type = (P2P_RING_MEDIA_VIDEO == p_frame->media) ? 0 : 1;
+    INT_T channel = (0 == type) ? TUYA_VDATA_CHANNEL : TUYA_ADATA_CHANNEL;
+    USHORT_T *p_seq_num = (0 == type) ? &pSession->video_seq_num : &pSession->audio_seq_num;
+    CHAR_T ext_head_buff[P2P_EXT_HEAD_MAX_LEN] = {0}; // According to extended video header protocol head+ext(8)+rtp_len
+    INT_T fix_len = 0;
+    UINT_T offset = 0;
+    CHAR_T *packet = NULL;
+    CHAR_T *buf = NULL;
+    INT_T len = 0;
+
+    __p2p_ext_protocol_pack(pSession, type, p_frame, ext_head_buff, &fix_len);
+
+    ret = __p2p_check_free_buffer_size(pSession, channel, p_frame, fix_len);
     if (OPRT_OK != ret) {
         return ret;
     }
 
-    if (NULL == sg_p2p_session->p_video_rtp_buff) {
-        PR_ERR("video rtp buffer is NULL");
-        return OPRT_INVALID_PARM;
+    while (NULL != (packet = p2p_ring_packet(sg_p2p_ctl.frame_ring, p_frame, &offset, &len))) {
+        // RTP sequence number, bytes 2-3 of the fixed header, counts the packets of this session
+        packet[2] = (CHAR_T)(*p_seq_num >> 8);
+        packet[3] = (CHAR_T)(*p_seq_num & 0xFF);
+        (*p_seq_num)++;
+
+        // The private header goes right in front of the packet
+        buf = packet - fix_len;
+        memcpy(buf, ext_head_buff, fix_len);
+        *(INT_T *)&buf[fix_len - 4] = len;
+        p2p_send_rtp_data(pSession, channel, buf, len + fix_len);
     }
 
-    RTP_PACK_NAL_ARG_T rtp_pack_nal_arg;
-    rtp_pack_nal_arg.client = client;
-    rtp_pack_nal_arg.channel = TUYA_VDATA_CHANNEL;
-    rtp_pack_nal_arg.p_rtp_buff = sg_p2p_session->p_video_rtp_buff;
-    memset(rtp_pack_nal_arg.ext_head_buff, 0, P2P_EXT_HEAD_MAX_LEN);
-    __p2p_ext_protocol_pack(client, 0, rtp_pack_nal_arg.ext_head_buff, &rtp_pack_nal_arg.fix_len);
-
-    void *pRtpDelegate = NULL;
-    struct rtp_payload_t rtp_packer;
-    rtp_packer.alloc = rtp_alloc;
-    rtp_packer.free = rtp_free;
-    rtp_packer.packet = rtp_pack_packet_handler;
-    uint16_t seq = sg_p2p_session->video_seq_num;
-    uint32_t ssrc = 10;
-    uint32_t timestamp = (UINT_T)sg_p2p_session->v_pts;
-    pRtpDelegate = rtp_payload_encode_create(/*H265_PAY_LOAD*/ 95, "H265", seq, ssrc, &rtp_packer, &rtp_pack_nal_arg);
-    ret = rtp_payload_encode_input(pRtpDelegate, pData, len, timestamp);
-    if (OPRT_OK != ret) {
-        PR_ERR("rtp_payload_encode_input h264 error:%d", ret);
+    return OPRT_OK;
+}
+#else
+STATIC void *__p2p_rtp_alloc(void *param, int bytes)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)param;
+
+    if (bytes <= 0 || bytes > P2P_RTP_PACK_LEN) {
+        return NULL;
     }
-    rtp_payload_encode_getinfo(pRtpDelegate, &sg_p2p_session->video_seq_num, &timestamp);
-    rtp_payload_encode_destroy(pRtpDelegate);
+    return pSession->rtp_buff + P2P_EXT_HEAD_MAX_LEN;
+}
 
-    return ret;
+STATIC void __p2p_rtp_free(void *param, void *packet)
+{
+    return;
 }
 
 /***********************************************************
- *  Function: __p2p_pack_h264_rtp_and_send
- *  Note:IPC stream data assembly RTP and send
- *  Input: pData data header address, len data length, client channel number
+ *  Function: __p2p_rtp_packet
+ *  Note:Send a packet as soon as it is packed, with the private header of the frame and the RTP
+ *       sequence number of the session
+ *  Input: param session, packet bytes the packet
  *  Output: none
- *  Return:
+ *  Return: 0
  ***********************************************************/
-STATIC OPERATE_RET __p2p_pack_h264_rtp_and_send(INT_T client, CHAR_T *pData, INT_T len)
+STATIC int __p2p_rtp_packet(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
 {
-    if (NULL == pData) {
-        PR_ERR("input error");
-        return OPRT_INVALID_PARM;
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)param;
+    BOOL_T is_video = (P2P_RING_MEDIA_VIDEO == pSession->pack_frame.media) ? TRUE : FALSE;
+    USHORT_T *p_seq_num = is_video ? &pSession->video_seq_num : &pSession->audio_seq_num;
+    CHAR_T *rtp = (CHAR_T *)packet;
+    CHAR_T *buf = rtp - pSession->pack_fix_len;
+
+    rtp[2] = (CHAR_T)(*p_seq_num >> 8);
+    rtp[3] = (CHAR_T)(*p_seq_num & 0xFF);
+    (*p_seq_num)++;
+
+    memcpy(buf, pSession->pack_head, pSession->pack_fix_len);
+    *(INT_T *)&buf[pSession->pack_fix_len - 4] = bytes;
+    p2p_send_rtp_data(pSession, is_video ? TUYA_VDATA_CHANNEL : TUYA_ADATA_CHANNEL, buf,
+                      bytes + pSession->pack_fix_len);
+    return 0;
+}
+
+STATIC VOID *__p2p_session_packer_get(P2P_SESSION_T *pSession, UINT_T idx, INT_T payload, CHAR_T *name)
+{
+    struct rtp_payload_t handler;
+
+    if (NULL != pSession->packer[idx] && pSession->packer_pt[idx] == payload) {
+        return pSession->packer[idx];
+    }
+    if (NULL != pSession->packer[idx]) {
+        rtp_payload_encode_destroy(pSession->packer[idx]);
     }
 
-    UINT_T max_frame_size = /*tuya_ipc_media_adapter_get_max_frame(0, 0, 0)*/ (300 * 1024);
-    if (len > max_frame_size) {
-        PR_ERR("frame len too big[%d]", len);
-        return OPRT_INVALID_PARM;
+    handler.alloc = __p2p_rtp_alloc;
+    handler.free = __p2p_rtp_free;
+    handler.packet = __p2p_rtp_packet;
+    // __p2p_rtp_packet numbers the packets, the SSRC tells video from audio
+    pSession->packer[idx] = rtp_payload_encode_create(payload, name, 0, 10 + idx, &handler, pSession);
+    pSession->packer_pt[idx] = payload;
+
+    return pSession->packer[idx];
+}
+
+/***********************************************************
+ *  Function: __p2p_session_pack_frame
+ *  Note:Pack a frame for a session and send its packets one by one through a single packet buffer
+ *  Input: pSession session, media P2P_RING_MEDIA_VIDEO/AUDIO, payload name RTP payload type and name,
+ *         p_frame frame, rtp_ts RTP timestamp
+ *  Output: none
+ *  Return: OPRT_RESOURCE_NOT_READY when the send buffer can't take the frame, the frame is dropped
+ ***********************************************************/
+STATIC OPERATE_RET __p2p_session_pack_frame(P2P_SESSION_T *pSession, UINT_T media, INT_T payload, CHAR_T *name,
+                                            MEDIA_FRAME *p_frame, UINT_T rtp_ts)
+{
+    OPERATE_RET ret = OPRT_OK;
+    INT_T type = (P2P_RING_MEDIA_VIDEO == media) ? 0 : 1;
+    INT_T channel = (0 == type) ? TUYA_VDATA_CHANNEL : TUYA_ADATA_CHANNEL;
+    P2P_RING_FRAME_T *p_desc = &pSession->pack_frame;
+    INT_T pkt_cnt = 0;
+    VOID *packer = NULL;
+
+    packer = __p2p_session_packer_get(pSession, type, payload, name);
+    if (NULL == packer) {
+        PR_ERR("create %s rtp packer failed", name);
+        return OPRT_MALLOC_FAILED;
     }
 
-    OPERATE_RET ret;
-    ret = __p2p_check_free_buffer_size(client, TUYA_VDATA_CHANNEL, len);
+    pkt_cnt = rtp_payload_encode_packets(packer, p_frame->data, p_frame->size);
+    if (pkt_cnt <= 0) {
+        PR_ERR("%s frame of %d bytes can't be packed", name, p_frame->size);
+        return OPRT_NOT_SUPPORTED;
+    }
+
+    memset(p_desc, 0, sizeof(P2P_RING_FRAME_T));
+    p_desc->media = media;
+    p_desc->key_frame = (P2P_RING_MEDIA_AUDIO == media || eVideoIFrame == p_frame->type) ? TRUE : FALSE;
+    p_desc->pts = p_frame->pts;
+    p_desc->timestamp = p_frame->timestamp;
+    p_desc->pkt_cnt = pkt_cnt;
+
+    memset(pSession->pack_head, 0, sizeof(pSession->pack_head));
+    __p2p_ext_protocol_pack(pSession, type, p_desc, pSession->pack_head, &pSession->pack_fix_len);
+
+    ret = __p2p_check_free_buffer_size(pSession, channel, p_desc, pSession->pack_fix_len);
     if (OPRT_OK != ret) {
         return ret;
     }
 
-    if (NULL == sg_p2p_session->p_video_rtp_buff) {
-        PR_ERR("video rtp buffer is NULL");
+    if (0 != rtp_payload_encode_input(packer, p_frame->data, p_frame->size, rtp_ts)) {
+        PR_ERR("rtp_payload_encode_input error");
+        return OPRT_COM_ERROR;
+    }
+
+    return OPRT_OK;
+}
+#endif
+
+/***********************************************************
+ *  Function: __p2p_session_media
+ *  Note:Live media a session asks for, called with the session locked
+ *  Input: pSession session
+ *  Output: none
+ *  Return: P2P_RING_MEDIA_VIDEO | P2P_RING_MEDIA_AUDIO
+ ***********************************************************/
+STATIC UINT_T __p2p_session_media(P2P_SESSION_T *pSession)
+{
+    UINT_T media = 0;
+
+    if (P2P_SESSION_RUNNING == pSession->status) {
+        media |= (P2P_VIDEO & pSession->cmd) ? P2P_RING_MEDIA_VIDEO : 0;
+        media |= (P2P_AUDIO & pSession->cmd) ? P2P_RING_MEDIA_AUDIO : 0;
+    }
+    return media;
+}
+
+/***********************************************************
+ *  Function: __p2p_put_frame
+ *  Note:Put a frame into the shared ring, or without the ring pack and send it to every session
+ *       that asks for its media
+ *  Input: media P2P_RING_MEDIA_VIDEO/AUDIO, payload name RTP payload type and name, p_frame frame,
+ *         rtp_ts RTP timestamp
+ *  Output: none
+ *  Return:
+ ***********************************************************/
+STATIC OPERATE_RET __p2p_put_frame(UINT_T media, INT_T payload, CHAR_T *name, MEDIA_FRAME *p_frame, UINT_T rtp_ts)
+{
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    return p2p_ring_put(sg_p2p_ctl.frame_ring, media, payload, name, p_frame, rtp_ts);
+#else
+    P2P_SESSION_T *pSession = NULL;
+    INT_T i;
+
+    for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+        pSession = &sg_p2p_ctl.session[i];
+        tal_mutex_lock(pSession->cmutex);
+        if (__p2p_session_media(pSession) & media) {
+            __p2p_session_pack_frame(pSession, media, payload, name, p_frame, rtp_ts);
+        }
+        tal_mutex_unlock(pSession->cmutex);
+    }
+    return OPRT_OK;
+#endif
+}
+
+/***********************************************************
+ *  Function: __p2p_put_video_frame
+ *  Note:IPC stream data assembly RTP, see __p2p_put_frame
+ *  Input: p_frame video frame
+ *  Output: none
+ *  Return:
+ ***********************************************************/
+STATIC OPERATE_RET __p2p_put_video_frame(MEDIA_FRAME *p_frame)
+{
+    if (NULL == p_frame->data) {
+        PR_ERR("input error");
         return OPRT_INVALID_PARM;
     }
 
-    RTP_PACK_NAL_ARG_T rtp_pack_nal_arg;
-    rtp_pack_nal_arg.client = client;
-    rtp_pack_nal_arg.channel = TUYA_VDATA_CHANNEL;
-    rtp_pack_nal_arg.p_rtp_buff = sg_p2p_session->p_video_rtp_buff;
-    memset(rtp_pack_nal_arg.ext_head_buff, 0, P2P_EXT_HEAD_MAX_LEN);
-    __p2p_ext_protocol_pack(client, 0, rtp_pack_nal_arg.ext_head_buff, &rtp_pack_nal_arg.fix_len);
-
-    void *pRtpDelegate = NULL;
-    struct rtp_payload_t rtp_packer;
-    rtp_packer.alloc = rtp_alloc;
-    rtp_packer.free = rtp_free;
-    rtp_packer.packet = rtp_pack_packet_handler;
-    uint16_t seq = sg_p2p_session->video_seq_num;
-    uint32_t ssrc = 10;
-    uint32_t timestamp = (UINT_T)sg_p2p_session->v_pts;
-    pRtpDelegate = rtp_payload_encode_create(/*H264_PAY_LOAD*/ 96, "H264", seq, ssrc, &rtp_packer, &rtp_pack_nal_arg);
-    ret = rtp_payload_encode_input(pRtpDelegate, pData, len, timestamp);
-    if (OPRT_OK != ret) {
-        PR_ERR("rtp_payload_encode_input h264 error:%d", ret);
+    UINT_T max_frame_size = /*tuya_ipc_media_adapter_get_max_frame(0, 0, 0)*/ (300 * 1024);
+    if (p_frame->size > max_frame_size) {
+        PR_ERR("frame len too big[%d]", p_frame->size);
+        return OPRT_INVALID_PARM;
     }
-    rtp_payload_encode_getinfo(pRtpDelegate, &sg_p2p_session->video_seq_num, &timestamp);
-    rtp_payload_encode_destroy(pRtpDelegate);
 
-    return ret;
+    UINT_T rtp_ts = (p_frame->pts == 0) ? p_frame->timestamp * 1000 : p_frame->pts;
+    if (TY_AV_CODEC_VIDEO_H265 != sg_p2p_ctl.av_Info.video_codec[0]) {
+        return __p2p_put_frame(P2P_RING_MEDIA_VIDEO, /*H264_PAY_LOAD*/ 96, "H264", p_frame, rtp_ts);
+    }
+    return __p2p_put_frame(P2P_RING_MEDIA_VIDEO, /*H265_PAY_LOAD*/ 95, "H265", p_frame, rtp_ts);
 }
 
 /***********************************************************
@@ -789,50 +858,24 @@ STATIC OPERATE_RET __p2p_pack_h264_rtp_and_send(INT_T client, CHAR_T *pData, INT
 // }
 
 /***********************************************************
- *  Function: __p2p_pack_g711_rtp_and_send
- *  Note:IPC audio data assembly RTP and send
- *  Input: pData data header address, len data length, client channel number, mode g711 mode
+ *  Function: __p2p_put_audio_frame
+ *  Note:IPC audio data assembly RTP, see __p2p_put_frame
+ *  Input: p_frame audio frame, mode g711 mode
  *  Output: none
  *  Return:
  ***********************************************************/
-STATIC OPERATE_RET __p2p_pack_g711_rtp_and_send(INT_T client, CHAR_T *pData, INT_T len, INT_T mode)
+STATIC OPERATE_RET __p2p_put_audio_frame(MEDIA_FRAME *p_frame, INT_T mode)
 {
-    if (NULL == pData) {
-        PR_ERR("data[%p] client num [%d]", pData, client);
+    if (NULL == p_frame->data) {
+        PR_ERR("data[%p]", p_frame->data);
         return OPRT_INVALID_PARM;
     }
 
-    if (len > P2P_RTP_PACK_LEN) {
-        PR_ERR("data too big %d", len);
+    if (p_frame->size > P2P_RTP_PACK_LEN) {
+        PR_ERR("data too big %d", p_frame->size);
         return OPRT_INVALID_PARM;
     }
 
-    OPERATE_RET ret = OPRT_OK;
-    ret = __p2p_check_free_buffer_size(client, TUYA_ADATA_CHANNEL, len);
-    if (OPRT_OK != ret) {
-        return ret;
-    }
-
-    if (NULL == sg_p2p_session->p_audio_rtp_buff) {
-        PR_ERR("audio rtp buffer is NULL");
-        return OPRT_INVALID_PARM;
-    }
-
-    RTP_PACK_NAL_ARG_T rtp_pack_nal_arg;
-    rtp_pack_nal_arg.client = client;
-    rtp_pack_nal_arg.channel = TUYA_ADATA_CHANNEL;
-    rtp_pack_nal_arg.p_rtp_buff = sg_p2p_session->p_audio_rtp_buff;
-    memset(rtp_pack_nal_arg.ext_head_buff, 0, P2P_EXT_HEAD_MAX_LEN);
-    __p2p_ext_protocol_pack(client, 1, rtp_pack_nal_arg.ext_head_buff, &rtp_pack_nal_arg.fix_len);
-
-    void *pRtpDelegate = NULL;
-    struct rtp_payload_t rtp_packer;
-    rtp_packer.alloc = rtp_alloc;
-    rtp_packer.free = rtp_free;
-    rtp_packer.packet = rtp_pack_packet_handler;
-    uint16_t seq = sg_p2p_session->audio_seq_num;
-    uint32_t ssrc = 11;
-    uint32_t timestamp = (UINT_T)sg_p2p_session->a_pts;
     int payload = 0;
     char *codec_name = NULL;
     if (TY_AV_CODEC_AUDIO_G711U == mode) {
@@ -845,15 +888,9 @@ STATIC OPERATE_RET __p2p_pack_g711_rtp_and_send(INT_T client, CHAR_T *pData, INT
         codec_name = "PCM";
         payload = 99 /*RTP_PCM_PAYLOAD*/;
     }
-    pRtpDelegate = rtp_payload_encode_create(payload, codec_name, seq, ssrc, &rtp_packer, &rtp_pack_nal_arg);
-    ret = rtp_payload_encode_input(pRtpDelegate, pData, len, timestamp);
-    if (OPRT_OK != ret) {
-        PR_ERR("rtp_payload_encode_input h264 error:%d", ret);
-    }
-    rtp_payload_encode_getinfo(pRtpDelegate, &sg_p2p_session->audio_seq_num, &timestamp);
-    rtp_payload_encode_destroy(pRtpDelegate);
 
-    return ret;
+    UINT_T rtp_ts = (p_frame->pts == 0) ? p_frame->timestamp * 1000 : p_frame->pts;
+    return __p2p_put_frame(P2P_RING_MEDIA_AUDIO, payload, codec_name, p_frame, rtp_ts);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -870,19 +907,19 @@ OPERATE_RET tuya_ipc_p2p_set_limit_mode(BOOL_T islimit)
 
 OPERATE_RET tuya_ipc_init_trans_av_info(TRANS_IPC_AV_INFO_T *av_info)
 {
-    memcpy(&sg_p2p_session->av_Info, av_info, sizeof(TRANS_IPC_AV_INFO_T));
+    memcpy(&sg_p2p_ctl.av_Info, av_info, sizeof(TRANS_IPC_AV_INFO_T));
     return OPRT_OK;
 }
 
 OPERATE_RET tuya_p2p_rtc_register_get_video_frame_cb(tuya_p2p_rtc_get_frame_cb_t pCallback)
 {
-    sg_p2p_session->on_get_video_frame_callback = pCallback;
+    sg_p2p_ctl.on_get_video_frame_callback = pCallback;
     return OPRT_OK;
 }
 
 OPERATE_RET tuya_p2p_rtc_register_get_audio_frame_cb(tuya_p2p_rtc_get_frame_cb_t pCallback)
 {
-    sg_p2p_session->on_get_audio_frame_callback = pCallback;
+    sg_p2p_ctl.on_get_audio_frame_callback = pCallback;
     return OPRT_OK;
 }
 
@@ -966,264 +1003,186 @@ STATIC INT_T __p2p_session_trans_audio_stop(P2P_SESSION_T *pSession)
 
 /***********************************************************
  *  Function: __p2p_session_pack_resp
- *  Note:Response to app query
- *  Input:pSrc  Received data, pPayLoad Queried payload data
+ *  Note:Response to app query, queued and sent with the responses of the other commands read at once
+ *  Input:pCmd  Received command, pPayLoad Queried payload data
  *  Output: none
  *  Return:
  ***********************************************************/
-STATIC INT_T __p2p_session_pack_resp(P2P_SESSION_T *pSession, IN VOID *pSrc, IN VOID *pPayLoad, INT_T len)
+STATIC INT_T __p2p_session_pack_resp(P2P_SESSION_T *pSession, IN P2P_CMD_PARSE_T *pCmd, IN VOID *pPayLoad, INT_T len)
 {
-    CHAR_T *sendBuff = NULL;
-    INT_T packLen = 0;
-    INT_T ret = 0;
-
-    if (NULL == pSrc || NULL == pPayLoad || NULL == pSession) {
+    if (NULL == pCmd || NULL == pPayLoad || NULL == pSession) {
         PR_ERR("param error");
         return OPRT_INVALID_PARM;
     }
 
-    packLen = P2P_CMD_HEAD_LEN + len;
-    sendBuff = (CHAR_T *)Malloc(packLen);
-    if (NULL == sendBuff) {
-        PR_ERR("malloc failed len[%d]", len);
-        return OPRT_MALLOC_FAILED;
-    }
+    return p2p_cmd_chan_resp(&pSession->cmd_chan, pCmd, pPayLoad, len);
+}
 
-    memcpy(sendBuff, pSrc, P2P_CMD_HEAD_LEN);
-    ((P2P_CMD_PARSE_T *)sendBuff)->str_header.type = 1;
-    ((P2P_CMD_PARSE_T *)sendBuff)->str_header.length = len;
-    memcpy(sendBuff + P2P_CMD_HEAD_LEN, pPayLoad, len);
+STATIC VOID __p2p_session_com_resp(P2P_SESSION_T *pSession, P2P_CMD_PARSE_T *pCmd, UINT_T channel, INT_T result)
+{
+    C2C_CMD_IO_CTRL_COM_RESP_T comResp;
 
-    // Send data
-    //    PR_DEBUG("p2p Write data session[%d] chn[%d] len[%d]",pSession->session, TUYA_CMD_CHANNEL, packLen);
-    ret = tuya_p2p_rtc_send_data(pSession->session, TUYA_CMD_CHANNEL, sendBuff, packLen, -1);
-    if (ret < 0) {
-        PR_ERR("p2p Write failed ret = %d", ret);
-    }
-    Free(sendBuff);
-    sendBuff = NULL;
-    return ret;
+    memset(&comResp, 0x00, sizeof(comResp));
+    comResp.channel = channel;
+    comResp.result = result;
+    __p2p_session_pack_resp(pSession, pCmd, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
 }
 
-STATIC INT_T __p2p_session_cmd_parse_server(P2P_SESSION_T *pSession, VOID *pData)
+// Query audio parameters (reused for app to query audio types needed for intercom)
+STATIC VOID __p2p_cmd_query_audio_params(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
 {
-    P2P_CMD_PARSE_T *pCmd = NULL;
-    C2C_CMD_FIXED_HEADER_T *pFixedHead = NULL;
-    CHAR_T *pPayload = NULL;
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    C2C_TRANS_QUERY_AUDIO_PARAM_REQ_T *pAudioReq = (C2C_TRANS_QUERY_AUDIO_PARAM_REQ_T *)pPayload;
+    UINT_T resp[(sizeof(C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E) + sizeof(AUDIO_PARAM_T)) / sizeof(UINT_T)];
+    C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E *pAudioResp = (C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E *)resp;
+
+    // Send query results to client
+    //  PR_DEBUG("recv session[%d] query audio params",pSession->session);
+    memset(resp, 0, sizeof(resp));
+    pAudioResp->channel = pAudioReq->channel;
+    pAudioResp->count = 1;
+    // pAudioResp->audioParams[0].type = sg_p2p_ctl.rev_audio_codec;
+    // pAudioResp->audioParams[0].sample_rate = sg_p2p_ctl.audio_sample;
+    // pAudioResp->audioParams[0].bitwidth = sg_p2p_ctl.audio_databits;
+    // pAudioResp->audioParams[0].channel_num = sg_p2p_ctl.audio_channel;
+    __p2p_session_pack_resp(pSession, pCmd, pAudioResp, sizeof(resp));
+}
 
-    if (NULL == pSession || NULL == pData) {
-        PR_ERR("param error");
-        return OPRT_INVALID_PARM;
-    }
+// Query video parameters
+STATIC VOID __p2p_cmd_query_video_params(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    C2C_TRANS_QUERY_VIDEO_PARAM_REQ_T *pVideoReq = (C2C_TRANS_QUERY_VIDEO_PARAM_REQ_T *)pPayload;
 
-    pPayload = pData + P2P_CMD_HEAD_LEN;
-    pCmd = (P2P_CMD_PARSE_T *)pData;
-    pFixedHead = &pCmd->str_header;
-
-    switch (pFixedHead->high_cmd) {
-    case TY_C2C_CMD_QUERY_AUDIO_PARAMS: {
-        // Query audio parameters (reused for app to query audio types needed for intercom)
-        // Send query results to client
-        //  PR_DEBUG("recv session[%d] query audio params",pSession->session);
-        C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E *pAudioResp = NULL;
-        C2C_TRANS_QUERY_AUDIO_PARAM_REQ_T *pAudioReq;
-        pAudioReq = (C2C_TRANS_QUERY_AUDIO_PARAM_REQ_T *)pPayload;
-        INT_T respLen = sizeof(C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E) + sizeof(AUDIO_PARAM_T);
-        pAudioResp = (C2C_TRANS_QUERY_AUDIO_PARAM_RESP_E *)Malloc(respLen);
-        if (NULL != pAudioResp) {
-            pAudioResp->channel = pAudioReq->channel;
-            pAudioResp->count = 1;
-            // pAudioResp->audioParams[0].type = sg_p2p_ctl.rev_audio_codec;
-            // pAudioResp->audioParams[0].sample_rate = sg_p2p_ctl.audio_sample;
-            // pAudioResp->audioParams[0].bitwidth = sg_p2p_ctl.audio_databits;
-            // pAudioResp->audioParams[0].channel_num = sg_p2p_ctl.audio_channel;
-            __p2p_session_pack_resp(pSession, pData, pAudioResp, respLen);
-            Free(pAudioResp);
-        } else {
-            // Send failure message to app
-            C2C_CMD_IO_CTRL_COM_RESP_T comResp;
-            memset(&comResp, 0x00, sizeof(comResp));
-            comResp.channel = pAudioReq->channel;
-            comResp.result = TY_C2C_CMD_IO_CTRL_COMMAND_FAILED;
-            __p2p_session_pack_resp(pSession, pData, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
+    //  PR_DEBUG("recv session[%d] query video params",pSession->session);
+    // The stream parameters are not known here, send failure message to app
+    __p2p_session_com_resp(pSession, pCmd, pVideoReq->channel, TY_C2C_CMD_IO_CTRL_COMMAND_FAILED);
+}
+
+// Video clarity query
+STATIC VOID __p2p_cmd_query_video_clarity(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    C2C_TRANS_QUERY_VIDEO_CLARITY_REQ_T *clarityReq = (C2C_TRANS_QUERY_VIDEO_CLARITY_REQ_T *)pPayload;
+    C2C_TRANS_QUERY_VIDEO_CLARITY_RESP_T ClarityResp = {0};
+
+    // Video clarity feedback
+    PR_DEBUG("recv session[%d] query video clarity", pSession->session);
+    ClarityResp.channel = clarityReq->channel;
+    ClarityResp.sp_mode =
+        TY_VIDEO_CLARITY_INNER_STANDARD | TY_VIDEO_CLARITY_INNER_HIGH; // Currently SDK supports fixed format
+    // p2p_get_clarity(&ClarityResp.sp_mode);
+    PR_DEBUG("get support clarity[%u]", ClarityResp.sp_mode);
+    ClarityResp.cur_mode = pSession->cur_clarity;
+    __p2p_session_pack_resp(pSession, pCmd, &ClarityResp, sizeof(C2C_TRANS_QUERY_VIDEO_CLARITY_RESP_T));
+}
+
+STATIC VOID __p2p_cmd_ctrl_video(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    C2C_TRANS_CTRL_VIDEO_REQ_T *parm = (C2C_TRANS_CTRL_VIDEO_REQ_T *)pPayload;
+
+    PR_DEBUG("CTRL VIDEO session[%d] chn[%d] op[%d]", pSession->session, parm->channel, parm->operation);
+    __p2p_session_com_resp(pSession, pCmd, parm->channel, TY_C2C_CMD_IO_CTRL_COMMAND_RECV);
+    switch (parm->operation) {
+    case TY_CMD_IO_CTRL_VIDEO_PLAY: {
+        // When requesting video, save reqId for response
+        pSession->video_req_id = pCmd->reqId;
+        //   PR_DEBUG("CTRL VIDEO START session[%d] chn[%d]
+        //   op[%d]",pSession->session,parm->channel,parm->operation);
+        // 20190416add
+        if (0 != parm->channel) {
+            PR_DEBUG("session [%d] recv chn[%d]", pSession->session, parm->channel);
+            pSession->cur_clarity = parm->channel;
+        }
+        if (OPRT_OK != __p2p_session_trans_video_start(pSession)) {
+            PR_ERR("CTRL VIDEO START failed");
         }
         break;
     }
-    case TY_C2C_CMD_QUERY_VIDEO_STREAM_PARAMS: {
-        // Query video parameters
-        // Send query results to client
-        //  PR_DEBUG("recv session[%d] query video params",pSession->session);
-        C2C_TRANS_QUERY_VIDEO_PARAM_RESP_T *pVideoResp = NULL;
-        C2C_TRANS_QUERY_VIDEO_PARAM_REQ_T *pVideoReq;
-        pVideoReq = (C2C_TRANS_QUERY_VIDEO_PARAM_REQ_T *)pPayload;
-
-        if (NULL != pVideoResp) {
-            __p2p_session_pack_resp(pSession, pData, pVideoResp,
-                                    sizeof(C2C_TRANS_QUERY_VIDEO_PARAM_RESP_T) +
-                                        pVideoResp->count * sizeof(VIDEO_PARAM_T));
-            Free(pVideoResp);
-        } else {
-            // Send failure message to app
-            C2C_CMD_IO_CTRL_COM_RESP_T comResp;
-            memset(&comResp, 0x00, sizeof(comResp));
-            comResp.channel = pVideoReq->channel;
-            comResp.result = TY_C2C_CMD_IO_CTRL_COMMAND_FAILED;
-            __p2p_session_pack_resp(pSession, pData, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
+    case TY_CMD_IO_CTRL_VIDEO_STOP: {
+        //   PR_DEBUG("CTRL VIDEO STOP session[%d] chn[%d] op[%d]",pSession->session,parm->channel,parm->operation);
+        if (OPRT_OK != __p2p_session_trans_video_stop(pSession)) {
+            PR_ERR("CTRL VIDEO STOP failed");
         }
         break;
     }
-    case TY_C2C_CMD_QUERY_VIDEO_CLARITY: {
-        // Video clarity query
-        // Video clarity feedback
-        PR_DEBUG("recv session[%d] query video clarity", pSession->session);
-        C2C_TRANS_QUERY_VIDEO_CLARITY_RESP_T ClarityResp = {0};
-        C2C_TRANS_QUERY_VIDEO_CLARITY_REQ_T *clarityReq;
-        clarityReq = (C2C_TRANS_QUERY_VIDEO_CLARITY_REQ_T *)pPayload;
-
-        ClarityResp.channel = clarityReq->channel;
-        ClarityResp.sp_mode =
-            TY_VIDEO_CLARITY_INNER_STANDARD | TY_VIDEO_CLARITY_INNER_HIGH; // Currently SDK supports fixed format
-        // p2p_get_clarity(&ClarityResp.sp_mode);
-        PR_DEBUG("get support clarity[%u]", ClarityResp.sp_mode);
-        ClarityResp.cur_mode = pSession->cur_clarity;
-        __p2p_session_pack_resp(pSession, pData, &ClarityResp, sizeof(C2C_TRANS_QUERY_VIDEO_CLARITY_RESP_T));
+    case TY_CMD_IO_CTRL_AUDIO_MIC_START: {
+        //   PR_DEBUG("CTRL AUDIO START session[%d]",pSession->session);
+        pSession->audio_req_id = pCmd->reqId;
+        __p2p_session_trans_audio_start(pSession);
         break;
     }
-    case TY_C2C_CMD_IO_CTRL_VIDEO: {
-        C2C_TRANS_CTRL_VIDEO_REQ_T *parm = (C2C_TRANS_CTRL_VIDEO_REQ_T *)pPayload;
-        PR_DEBUG("CTRL VIDEO session[%d] chn[%d] op[%d]", pSession->session, parm->channel, parm->operation);
-        C2C_CMD_IO_CTRL_COM_RESP_T comResp;
-        memset(&comResp, 0x00, sizeof(comResp));
-        comResp.channel = parm->channel;
-        comResp.result = TY_C2C_CMD_IO_CTRL_COMMAND_RECV;
-        __p2p_session_pack_resp(pSession, pData, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
-        switch (parm->operation) {
-        case TY_CMD_IO_CTRL_VIDEO_PLAY: {
-            // When requesting video, save reqId for response
-            pSession->video_req_id = pCmd->reqId;
-            //   PR_DEBUG("CTRL VIDEO START session[%d] chn[%d]
-            //   op[%d]",pSession->session,parm->channel,parm->operation);
-            // 20190416add
-            if (0 != parm->channel) {
-                PR_DEBUG("session [%d] recv chn[%d]", pSession->session, parm->channel);
-                pSession->cur_clarity = parm->channel;
-            }
-            if (OPRT_OK != __p2p_session_trans_video_start(pSession)) {
-                PR_ERR("CTRL VIDEO START failed");
-            }
-            break;
-        }
-        case TY_CMD_IO_CTRL_VIDEO_STOP: {
-            //   PR_DEBUG("CTRL VIDEO STOP session[%d] chn[%d] op[%d]",pSession->session,parm->channel,parm->operation);
-            if (OPRT_OK != __p2p_session_trans_video_stop(pSession)) {
-                PR_ERR("CTRL VIDEO STOP failed");
-            }
-            break;
-        }
-        case TY_CMD_IO_CTRL_AUDIO_MIC_START: {
-            //   PR_DEBUG("CTRL AUDIO START session[%d]",pSession->session);
-            pSession->audio_req_id = pCmd->reqId;
-            __p2p_session_trans_audio_start(pSession);
-            break;
-        }
-        case TY_CMD_IO_CTRL_AUDIO_MIC_STOP: {
-            //   PR_DEBUG("CTRL AUDIO STOP session[%d]",pSession->session);
-            __p2p_session_trans_audio_stop(pSession);
-            break;
-        }
-        default:
-            PR_ERR("CTRL ERROR chn[%d] op[%d]", parm->channel, parm->operation);
-            break;
-        }
+    case TY_CMD_IO_CTRL_AUDIO_MIC_STOP: {
+        //   PR_DEBUG("CTRL AUDIO STOP session[%d]",pSession->session);
+        __p2p_session_trans_audio_stop(pSession);
         break;
     }
-    case TY_C2C_CMD_IO_CTRL_VIDEO_CLARITY: {
-        C2C_TRANS_CTRL_VIDEO_CLARITY_T *parm = (C2C_TRANS_CTRL_VIDEO_CLARITY_T *)pPayload;
-        // Send to device for processing
-        C2C_TRANS_LIVE_CLARITY_PARAM_S outParm = {0};
-        outParm.clarity =
-            (parm->mode == TY_VIDEO_CLARITY_INNER_HIGH) ? TY_VIDEO_CLARITY_HIGH : TY_VIDEO_CLARITY_STANDARD;
-        // outParm.clarity = __p2p_clarity_trans(parm->mode);
-        PR_DEBUG("set video clarity session[%d]chn[%d] op[%d] clarity[%d]", pSession->session, parm->channel,
-                 parm->mode, outParm.clarity);
+    default:
+        PR_ERR("CTRL ERROR chn[%d] op[%d]", parm->channel, parm->operation);
+        break;
+    }
+}
+
+STATIC VOID __p2p_cmd_ctrl_video_clarity(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    C2C_TRANS_CTRL_VIDEO_CLARITY_T *parm = (C2C_TRANS_CTRL_VIDEO_CLARITY_T *)pPayload;
+    // Send to device for processing
+    C2C_TRANS_LIVE_CLARITY_PARAM_S outParm = {0};
+
+    outParm.clarity = (parm->mode == TY_VIDEO_CLARITY_INNER_HIGH) ? TY_VIDEO_CLARITY_HIGH : TY_VIDEO_CLARITY_STANDARD;
+    // outParm.clarity = __p2p_clarity_trans(parm->mode);
+    PR_DEBUG("set video clarity session[%d]chn[%d] op[%d] clarity[%d]", pSession->session, parm->channel, parm->mode,
+             outParm.clarity);
 // tuya_ipc_media_stream_event_call(0, 0, MEDIA_STREAM_LIVE_VIDEO_CLARITY_SET, (VOID *)&outParm);
 #if 0
             //Update reqId for app to distinguish different video files
             pSession->video_req_id = pCmd->reqId;
             pSession->cur_clarity = parm->mode;
 #endif
-        C2C_CMD_IO_CTRL_COM_RESP_T comResp;
-        memset(&comResp, 0x00, sizeof(comResp));
-        comResp.channel = parm->channel;
-        comResp.result = TY_C2C_CMD_IO_CTRL_COMMAND_SUCCESS;
-        __p2p_session_pack_resp(pSession, pData, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
-        break;
-    }
-    case TY_C2C_CMD_PROTOCOL_VERSION: {
-        // C2C_CMD_PROTOCOL_VERSION_T *parm = (C2C_CMD_PROTOCOL_VERSION_T *)pPayload;
-        //  PR_DEBUG("session[%d] recv pro_ver[%d][%d]",pSession->session,parm->version >> 16,parm->version&0xff);
-        // Version verification processing to be improved later
-        C2C_CMD_PROTOCOL_VERSION_T proVerRsp = {0};
-        proVerRsp.version = (C2C_MAJOR_VERSION << 16) | C2C_MINOR_VERSION;
-        __p2p_session_pack_resp(pSession, pData, &proVerRsp, sizeof(C2C_CMD_PROTOCOL_VERSION_T));
-        break;
-    }
-    default: {
-        PR_ERR("CTRL CMD ERROR[%d]", pFixedHead->high_cmd);
-        C2C_CMD_IO_CTRL_COM_RESP_T comResp;
-        memset(&comResp, 0x00, sizeof(comResp));
-        comResp.channel = 0;
-        comResp.result = TY_C2C_CMD_IO_CTRL_COMMAND_INVALID;
-        __p2p_session_pack_resp(pSession, pData, &comResp, sizeof(C2C_CMD_IO_CTRL_COM_RESP_T));
-        break;
-    }
-    }
-
-    return OPRT_OK;
+    __p2p_session_com_resp(pSession, pCmd, parm->channel, TY_C2C_CMD_IO_CTRL_COMMAND_SUCCESS);
 }
 
-/***********************************************************
- *  Function: __p2p_session_cmd_parse
- *  Note:Session command parsing
- *  Input:
- *  Output: none
- *  Return:
- ***********************************************************/
-STATIC INT_T __p2p_session_cmd_parse(P2P_SESSION_T *pSession, VOID *pData)
+STATIC VOID __p2p_cmd_protocol_version(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
 {
-    P2P_CMD_PARSE_T *pCmd = NULL;
-    C2C_CMD_FIXED_HEADER_T *pFixedHead = NULL;
-
-    if (NULL == pSession || NULL == pData) {
-        PR_ERR("param error");
-        return OPRT_INVALID_PARM;
-    }
-
-    pCmd = (P2P_CMD_PARSE_T *)pData;
-    pFixedHead = &pCmd->str_header;
-
-    if (0 == pFixedHead->type) {
-        // Receive command request, this machine acts as server
-        return __p2p_session_cmd_parse_server(pSession, pData);
-    } else if (1 == pFixedHead->type) {
-        // Receive response packet, this machine acts as client
-        // return __p2p_session_cmd_parse_client(pSession, pData);
-    } else {
-        PR_ERR("pFixedHead->type error %d", pFixedHead->type);
-    }
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+    // C2C_CMD_PROTOCOL_VERSION_T *parm = (C2C_CMD_PROTOCOL_VERSION_T *)pPayload;
+    //  PR_DEBUG("session[%d] recv pro_ver[%d][%d]",pSession->session,parm->version >> 16,parm->version&0xff);
+    // Version verification processing to be improved later
+    C2C_CMD_PROTOCOL_VERSION_T proVerRsp = {0};
+
+    proVerRsp.version = (C2C_MAJOR_VERSION << 16) | C2C_MINOR_VERSION;
+    __p2p_session_pack_resp(pSession, pCmd, &proVerRsp, sizeof(C2C_CMD_PROTOCOL_VERSION_T));
+}
 
-    return OPRT_COM_ERROR;
+STATIC VOID __p2p_cmd_unknown(VOID *priv, P2P_CMD_PARSE_T *pCmd, CHAR_T *pPayload)
+{
+    PR_ERR("CTRL CMD ERROR[%d]", pCmd->str_header.high_cmd);
+    __p2p_session_com_resp((P2P_SESSION_T *)priv, pCmd, 0, TY_C2C_CMD_IO_CTRL_COMMAND_INVALID);
 }
 
-STATIC INT_T __p2p_read_cmd(P2P_SESSION_T *pSession)
+// Requests this machine serves
+STATIC CONST P2P_CMD_HANDLER_T sg_p2p_cmd_handler[] = {
+    {TY_C2C_CMD_QUERY_AUDIO_PARAMS, sizeof(C2C_TRANS_QUERY_AUDIO_PARAM_REQ_T), __p2p_cmd_query_audio_params},
+    {TY_C2C_CMD_QUERY_VIDEO_STREAM_PARAMS, sizeof(C2C_TRANS_QUERY_VIDEO_PARAM_REQ_T), __p2p_cmd_query_video_params},
+    {TY_C2C_CMD_QUERY_VIDEO_CLARITY, sizeof(C2C_TRANS_QUERY_VIDEO_CLARITY_REQ_T), __p2p_cmd_query_video_clarity},
+    {TY_C2C_CMD_IO_CTRL_VIDEO, sizeof(C2C_TRANS_CTRL_VIDEO_REQ_T), __p2p_cmd_ctrl_video},
+    {TY_C2C_CMD_IO_CTRL_VIDEO_CLARITY, sizeof(C2C_TRANS_CTRL_VIDEO_CLARITY_T), __p2p_cmd_ctrl_video_clarity},
+    {TY_C2C_CMD_PROTOCOL_VERSION, sizeof(C2C_CMD_PROTOCOL_VERSION_T), __p2p_cmd_protocol_version},
+};
+
+STATIC INT_T __p2p_cmd_recv(VOID *priv, CHAR_T *buff, INT_T *p_len, INT_T timeout_ms)
 {
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
     INT_T ret = 0;
-    C2C_CMD_FIXED_HEADER_T *pFixedHeader = NULL;
-    P2P_DATA_PARSE_T *pDataParse = &pSession->proto_parse;
-    P2P_CMD_PARSE_T *pReadBuff = (P2P_CMD_PARSE_T *)(pDataParse->read_buff);
-    ret = tuya_p2p_rtc_recv_data(pSession->session, TUYA_CMD_CHANNEL, pDataParse->read_buff + pDataParse->cur_read,
-                                 &pDataParse->read_size, P2P_RECV_TIMEOUT);
-    if ((ret < 0) && (ERROR_P2P_TIME_OUT != ret)) {
+
+    ret = tuya_p2p_rtc_recv_data(pSession->session, TUYA_CMD_CHANNEL, buff, p_len, timeout_ms);
+    if (ERROR_P2P_TIME_OUT == ret) {
+        *p_len = 0;
+        return OPRT_OK;
+    }
+    if (ret < 0) {
         // Exception handling
         if (ERROR_P2P_SESSION_CLOSED_REMOTE == ret || ERROR_P2P_SESSION_CLOSED_TIMEOUT == ret ||
             ERROR_P2P_SESSION_CLOSED_CALLED == ret || ERROR_P2P_NOT_INITIALIZED == ret ||
@@ -1231,210 +1190,232 @@ STATIC INT_T __p2p_read_cmd(P2P_SESSION_T *pSession)
             // Session was disconnected by client, need to close session
             PR_ERR("session[%d] was close by client ret[%d]", pSession->session, ret);
             return -1;
-        } else {
-            // Other exceptions to be added later
-            PR_ERR("session[%d] ###### error ret = [%d]", pSession->session, ret);
-            return -2;
-        }
-    } else {
-        // PR_DEBUG("recv cmd size[%d] cur_read[%d]
-        // flag[%d]",pDataParse->read_size,pDataParse->cur_read,pDataParse->flag); Receive data parsing, confirm data
-        // integrity
-        if (READ_HEADER_PART == pDataParse->flag) {
-            if (P2P_CMD_HEAD_LEN == (pDataParse->read_size + pDataParse->cur_read)) {
-                // Header information read successfully, simple parsing
-                if (P2P_CMD_MARK != pReadBuff->mark) {
-                    // Header parsing exception, exception handling to be completed later (unlikely to reach this
-                    // condition)
-                    PR_ERR("session[%d] read data error mark[0x%x]", pSession->session, pReadBuff->mark);
-                }
-                // Extract data portion
-                pFixedHeader = &(pReadBuff->str_header);
-                pDataParse->read_size = pFixedHeader->length;
-                pDataParse->cur_read = P2P_CMD_HEAD_LEN;
-                pDataParse->flag = READ_PAYLOAD_PART;
-                // PR_DEBUG("recv session[%d] cmd size[%d]",pSession->session,pDataParse->read_size);
-            } else {
-                // Continue extracting data to ensure header information is complete
-                if (P2P_CMD_HEAD_LEN < (pDataParse->read_size + pDataParse->cur_read)) {
-                    PR_ERR("session[%d] read data error", pSession->session);
-                    // note Exception handling
-                    // end
-                    return -3;
-                }
-                pDataParse->cur_read = pDataParse->read_size;
-                pDataParse->read_size = P2P_CMD_HEAD_LEN - pDataParse->cur_read;
-            }
-        } else {
-            pFixedHeader = &(pReadBuff->str_header);
-            if (pDataParse->read_size + pDataParse->cur_read == pFixedHeader->length + P2P_CMD_HEAD_LEN) {
-                // Data reception complete, enter parsing entry
-                //  PR_DEBUG("session[%d] read data succsess len[%d]",pSession->session,read_size + cur_read);
-                __p2p_session_cmd_parse(pSession, pDataParse->read_buff);
-                memset(pDataParse->read_buff, 0x00, SIZEOF(pDataParse->read_buff));
-                pDataParse->read_size = P2P_CMD_HEAD_LEN;
-                pDataParse->cur_read = 0;
-                pDataParse->flag = READ_HEADER_PART;
-            } else if (pDataParse->read_size + pDataParse->cur_read < pFixedHeader->length + P2P_CMD_HEAD_LEN) {
-                pDataParse->cur_read += pDataParse->read_size;
-                pDataParse->read_size = pFixedHeader->length + P2P_CMD_HEAD_LEN - pDataParse->cur_read;
-            } else {
-                PR_ERR("session[%d] read data error", pSession->session);
-                // note Exception handling
-                // end
-                return -4;
-            }
         }
+        // Other exceptions to be added later
+        PR_ERR("session[%d] ###### error ret = [%d]", pSession->session, ret);
+        return -2;
     }
+    return OPRT_OK;
+}
 
-    return 0;
+STATIC INT_T __p2p_cmd_send(VOID *priv, CHAR_T *buff, INT_T len)
+{
+    P2P_SESSION_T *pSession = (P2P_SESSION_T *)priv;
+
+    //    PR_DEBUG("p2p Write data session[%d] chn[%d] len[%d]",pSession->session, TUYA_CMD_CHANNEL, len);
+    return tuya_p2p_rtc_send_data(pSession->session, TUYA_CMD_CHANNEL, buff, len, -1);
+}
+
+STATIC CONST P2P_CMD_CHAN_CFG_T sg_p2p_cmd_chan_cfg = {
+    .handler = sg_p2p_cmd_handler,
+    .handler_num = sizeof(sg_p2p_cmd_handler) / sizeof(sg_p2p_cmd_handler[0]),
+    .unknown = __p2p_cmd_unknown,
+    .recv = __p2p_cmd_recv,
+    .send = __p2p_cmd_send,
+};
+
+/***********************************************************
+ *  Function: __p2p_read_cmd
+ *  Note:Read the command channel, handle every complete command read and send the responses
+ *  Input:pSession Session management, timeout_ms time to wait for the first bytes
+ *  Output: none
+ *  Return: commands handled, <0 when the session has to be closed
+ ***********************************************************/
+STATIC INT_T __p2p_read_cmd(P2P_SESSION_T *pSession, INT_T timeout_ms)
+{
+    return p2p_cmd_chan_read(&pSession->cmd_chan, timeout_ms);
 }
 
 STATIC void __p2p_cmd_recv_proc(PVOID_T pArg)
 {
     P2P_SESSION_T *pSession = NULL;
+    INT_T running = 0;
+    INT_T handled = 0;
+    INT_T timeout_ms;
     INT_T ret;
+    INT_T i;
 
-    memset(&sg_p2p_session->proto_parse, 0x00, sizeof(sg_p2p_session->proto_parse));
-    sg_p2p_session->proto_parse.read_size = P2P_CMD_HEAD_LEN;
-    sg_p2p_session->proto_parse.flag = READ_HEADER_PART;
-    while (tal_thread_get_state(sg_p2p_session->cmd_recv_proc_thread) == THREAD_STATE_RUNNING) {
-        if (P2P_SESSION_IDLE == sg_p2p_session->status) {
-            tal_system_sleep(5);
-            continue;
-        }
-        pSession = sg_p2p_session;
-        tal_mutex_lock(pSession->cmutex);
-        if (P2P_SESSION_CLOSING == pSession->status) {
+    while (tal_thread_get_state(sg_p2p_ctl.cmd_recv_proc_thread) == THREAD_STATE_RUNNING) {
+        // one session waits in its read, several are polled so that none waits behind the others
+        timeout_ms = (running > 1) ? 0 : P2P_RECV_TIMEOUT;
+        running = 0;
+        handled = 0;
+        for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+            pSession = &sg_p2p_ctl.session[i];
+            tal_mutex_lock(pSession->cmutex);
+            if (P2P_SESSION_RUNNING != pSession->status) {
+                tal_mutex_unlock(pSession->cmutex);
+                continue;
+            }
             tal_mutex_unlock(pSession->cmutex);
-            tal_system_sleep(5);
-            continue;
+            running++;
+
+            ret = __p2p_read_cmd(pSession, timeout_ms);
+            if (ret < 0) {
+                PR_ERR("session[%d] read cmd failed [%d]", pSession->session, ret);
+                __p2p_session_clear(pSession);
+                //__p2p_wait_concurr_idle(pSession, WAIT_ALL_BUF);
+                __p2p_session_release_va(pSession);
+                tuya_p2p_rtc_notify_exit();
+                printf("pSession->cmd: %d\n", pSession->cmd);
+            } else {
+                handled += ret;
+            }
         }
-        if (P2P_SESSION_RUNNING != pSession->status) {
-            tal_mutex_unlock(pSession->cmutex);
-            continue;
+        if (0 == running || (running > 1 && 0 == handled)) {
+            tal_system_sleep(P2P_CMD_IDLE_SLEEP);
         }
+    }
+
+    PR_DEBUG("session cmd proc exit");
+
+    return;
+}
+
+/***********************************************************
+ *  Function: __p2p_sync_readers
+ *  Note:Give the reader of each session the media the session asks for, a released session
+ *       starts over with a new reader. Without the ring only the media are collected
+ *  Input:
+ *  Output: none
+ *  Return: media wanted by all sessions
+ ***********************************************************/
+STATIC UINT_T __p2p_sync_readers(VOID)
+{
+    P2P_SESSION_T *pSession = NULL;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    BOOL_T restart = FALSE;
+#endif
+    UINT_T media = 0;
+    UINT_T all_media = 0;
+    INT_T i;
+
+    for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+        pSession = &sg_p2p_ctl.session[i];
+        tal_mutex_lock(pSession->cmutex);
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+        restart = pSession->reader_restart;
+        pSession->reader_restart = FALSE;
+#endif
+        media = __p2p_session_media(pSession);
         tal_mutex_unlock(pSession->cmutex);
+        all_media |= media;
 
-        ret = __p2p_read_cmd(pSession);
-        if (0 != ret) {
-            PR_ERR("session[%d] read cmd failed [%d]", pSession->session, ret);
-            __p2p_session_clear(pSession);
-            //__p2p_wait_concurr_idle(pSession, WAIT_ALL_BUF);
-            __p2p_session_release_va(pSession);
-            tuya_p2p_rtc_notify_exit();
-            printf("pSession->cmd: %d\n", sg_p2p_session->cmd);
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+        if (restart) {
+            p2p_ring_reader_set(sg_p2p_ctl.frame_ring, &pSession->reader, 0);
         }
+        p2p_ring_reader_set(sg_p2p_ctl.frame_ring, &pSession->reader, media);
+#endif
     }
 
-    PR_DEBUG("session cmd proc exit");
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    all_media = p2p_ring_media(sg_p2p_ctl.frame_ring);
+#endif
+    return all_media;
+}
 
-    return;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+/***********************************************************
+ *  Function: __p2p_send_readers
+ *  Note:Send each session the frames of the shared ring it has not sent yet. A session whose
+ *       send buffer is full keeps its frames for the next round
+ *  Input:
+ *  Output: none
+ *  Return:
+ ***********************************************************/
+STATIC VOID __p2p_send_readers(VOID)
+{
+    P2P_SESSION_T *pSession = NULL;
+    P2P_RING_FRAME_T *p_frame = NULL;
+    INT_T i;
+
+    for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+        pSession = &sg_p2p_ctl.session[i];
+        if (0 == pSession->reader.media) {
+            continue;
+        }
+        tal_mutex_lock(pSession->cmutex);
+        while (P2P_SESSION_RUNNING == pSession->status && FALSE == pSession->reader_restart &&
+               NULL != (p_frame = p2p_ring_peek(sg_p2p_ctl.frame_ring, &pSession->reader))) {
+            if (OPRT_RESOURCE_NOT_READY == __p2p_session_send_frame(pSession, p_frame)) {
+                break;
+            }
+            p2p_ring_pass(sg_p2p_ctl.frame_ring, &pSession->reader);
+        }
+        tal_mutex_unlock(pSession->cmutex);
+    }
 }
+#endif
 
 /***********************************************************
  *  Function: __p2p_video_send_proc
- *  Note:Video data transmission thread
+ *  Note:Video data transmission thread, frames are got once for all sessions
  *  Input:
  *  Output: none
  *  Return:
  ***********************************************************/
 STATIC void __p2p_media_send_proc(PVOID_T pArg)
 {
-    INT_T index = 0;
     UINT_T runCnt = 0;
-    P2P_SESSION_T *pSession = NULL;
+    UINT_T media = 0;
     OPERATE_RET op_ret = -1;
     TY_AV_CODEC_ID type;
-    type = sg_p2p_session->av_Info.audio_codec;
+    type = sg_p2p_ctl.av_Info.audio_codec;
     // type = TY_AV_CODEC_AUDIO_PCM;
 
     PR_DEBUG("into p2p video send");
 
-    while (tal_thread_get_state(sg_p2p_session->video_send_proc_thread) == THREAD_STATE_RUNNING) {
+    while (tal_thread_get_state(sg_p2p_ctl.video_send_proc_thread) == THREAD_STATE_RUNNING) {
         if (runCnt % 2000 == 0) {
             PR_DEBUG("media send proc alive [%d]", runCnt);
         }
         runCnt++;
 
-        if (P2P_SESSION_IDLE == sg_p2p_session->status) {
+        // This judgment cannot be omitted, otherwise thread idle running will occur
+        media = __p2p_sync_readers();
+        if (0 == media) {
             tal_system_sleep(5);
             continue;
         }
 
-        pSession = sg_p2p_session;
-        tal_mutex_lock(pSession->cmutex);
-        INT_T status = pSession->status;
-        P2P_CMD_E cmd = pSession->cmd;
-
-        if (P2P_SESSION_CLOSING == pSession->status) {
-            tal_mutex_unlock(pSession->cmutex);
-            tal_system_sleep(5);
-            continue;
-        }
-        if (P2P_SESSION_RUNNING != status) {
-            tal_mutex_unlock(pSession->cmutex);
-            continue;
-        }
-
-        // The judgment when both are not opened should be placed at the end, otherwise it will appear: users close
-        // audio and video at the same time, but do not release resources This judgment cannot be omitted, otherwise
-        // thread idle running will occur
-        if (!(P2P_VIDEO & cmd) && !(P2P_AUDIO & cmd)) {
-            // pSession->p2p_buff_stat.live_video = P2P_BUFF_IDLE;
-            // pSession->p2p_buff_stat.live_audio = P2P_BUFF_IDLE;
-            tal_mutex_unlock(pSession->cmutex);
-            tal_system_sleep(5);
-            continue;
-        }
-        tal_mutex_unlock(pSession->cmutex);
-
-        if (P2P_VIDEO & cmd) {
-            if (sg_p2p_session->on_get_video_frame_callback == NULL) {
+        if (P2P_RING_MEDIA_VIDEO & media) {
+            if (sg_p2p_ctl.on_get_video_frame_callback == NULL) {
                 tal_system_sleep(10);
                 continue;
             }
-            MEDIA_FRAME *pMediaFrame = &sg_p2p_session->media_frame;
-            op_ret = sg_p2p_session->on_get_video_frame_callback(pMediaFrame); // OnGetVideoFrameCallback(pMediaFrame)
+            MEDIA_FRAME *pMediaFrame = &sg_p2p_ctl.media_frame;
+            op_ret = sg_p2p_ctl.on_get_video_frame_callback(pMediaFrame); // OnGetVideoFrameCallback(pMediaFrame)
             if (op_ret == OPRT_OK) {
-                pSession->v_pts = (pMediaFrame->pts == 0) ? pMediaFrame->timestamp * 1000 : pMediaFrame->pts;
-                pSession->v_timestamp = pMediaFrame->timestamp;
-                if (eVideoIFrame == pMediaFrame->type) {
-                    pSession->key_frame = TRUE;
-                } else {
-                    pSession->key_frame = FALSE;
-                }
-                if (TY_AV_CODEC_VIDEO_H265 != sg_p2p_session->av_Info.video_codec[0]) {
-                    op_ret = __p2p_pack_h264_rtp_and_send(index, (CHAR_T *)pMediaFrame->data, pMediaFrame->size);
-                } else {
-                    op_ret = __p2p_pack_h265_rtp_and_send(index, (CHAR_T *)pMediaFrame->data, pMediaFrame->size);
-                }
+                op_ret = __p2p_put_video_frame(pMediaFrame);
             } else {
                 // Buffer has no data yet
                 tal_system_sleep(10);
             }
         }
-        if (P2P_AUDIO & cmd) {
-            if (sg_p2p_session->on_get_audio_frame_callback == NULL) {
+        if (P2P_RING_MEDIA_AUDIO & media) {
+            if (sg_p2p_ctl.on_get_audio_frame_callback == NULL) {
                 tal_system_sleep(10);
                 continue;
             }
-            MEDIA_FRAME *pMediaFrame = &sg_p2p_session->media_audio_frame;
-            op_ret = sg_p2p_session->on_get_audio_frame_callback(pMediaFrame); // OnGetAudioFrameCallback(pMediaFrame)
+            MEDIA_FRAME *pMediaFrame = &sg_p2p_ctl.media_audio_frame;
+            op_ret = sg_p2p_ctl.on_get_audio_frame_callback(pMediaFrame); // OnGetAudioFrameCallback(pMediaFrame)
             if (op_ret == OPRT_OK) {
-                pSession->a_pts = (pMediaFrame->pts == 0) ? pMediaFrame->timestamp * 1000 : pMediaFrame->pts;
-                pSession->a_timestamp = pMediaFrame->timestamp;
                 if (TY_AV_CODEC_AUDIO_AAC_ADTS == type) {
                     // op_ret = __p2p_pack_aac_rtp_and_send((CHAR_T *)node_a.data, node_a.size,index);
                 } else if (TY_AV_CODEC_AUDIO_G711A == type || TY_AV_CODEC_AUDIO_G711U == type ||
                            TY_AV_CODEC_AUDIO_PCM == type) {
-                    op_ret = __p2p_pack_g711_rtp_and_send(index, (CHAR_T *)pMediaFrame->data, pMediaFrame->size, type);
+                    op_ret = __p2p_put_audio_frame(pMediaFrame, type);
                 }
             } else {
                 // Buffer has no data yet
                 tal_system_sleep(10);
             }
         }
+
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+        __p2p_send_readers();
+#endif
     } // while
 
     PR_ERR("video send task exit");
@@ -1480,43 +1461,24 @@ INT_T __p2p_session_release_va(P2P_SESSION_T *pSession)
     // All functions closed
     PR_DEBUG("release va session[%d]", pSession->session);
     tal_mutex_lock(pSession->cmutex);
-    if (pSession->p_video_rtp_buff) {
-        Free(pSession->p_video_rtp_buff);
-        pSession->p_video_rtp_buff = NULL;
-    }
-    if (pSession->p_audio_rtp_buff) {
-        Free(pSession->p_audio_rtp_buff);
-        pSession->p_audio_rtp_buff = NULL;
-    }
     // memset(&pSession->session, 0x00, sizeof(P2P_SESSION_T) - OFFSET(P2P_SESSION_T, session));//Clear variables
     // outside the lock memset(&pSession->str_P2p_auth, 0, sizeof(pSession->str_P2p_auth));
     pSession->cur_clarity = TY_VIDEO_CLARITY_INNER_HIGH;
     pSession->status = P2P_SESSION_IDLE;
     pSession->cmd = P2P_IDLE;
     memset(&pSession->pb_resp_head, 0, sizeof(pSession->pb_resp_head));
+    // the sequence numbers start over with the next session, so does its reader
     pSession->video_seq_num = 0;
     pSession->audio_seq_num = 0;
-    pSession->key_frame = false;
-    pSession->v_pts = 0;
-    pSession->v_timestamp = 0;
-    pSession->a_pts = 0;
-    pSession->a_timestamp = 0;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    pSession->reader_restart = TRUE;
+#endif
     pSession->video_req_id = 0;
     pSession->audio_req_id = 0;
-    // if (pSession->media_frame.data != NULL) {
-    //     free(pSession->media_frame.data);
-    //     pSession->media_frame.data = NULL;
-    // }
-    // memset(&pSession->media_frame, 0, sizeof(pSession->media_frame));
-    // if (pSession->media_audio_frame.data != NULL) {
-    //     free(pSession->media_audio_frame.data);
-    //     pSession->media_audio_frame.data = NULL;
-    // }
-    // memset(&pSession->media_audio_frame, 0, sizeof(pSession->media_audio_frame));
-    memset(&pSession->proto_parse, 0, sizeof(pSession->proto_parse));
-    memset(&pSession->av_Info, 0, sizeof(pSession->av_Info));
-    if (pSession->on_disconnect_callback)
-        pSession->on_disconnect_callback(); // Notify upper layer when receiving disconnect signal from cloud
+    p2p_cmd_chan_reset(&pSession->cmd_chan);
+    // av_Info belongs to the device, the other sessions keep using it
+    if (sg_p2p_ctl.on_disconnect_callback)
+        sg_p2p_ctl.on_disconnect_callback(); // Notify upper layer when receiving disconnect signal from cloud
     tal_mutex_unlock(pSession->cmutex);
     return 0;
 }
@@ -1524,27 +1486,87 @@ INT_T __p2p_session_release_va(P2P_SESSION_T *pSession)
 OPERATE_RET p2p_init(IN CONST TUYA_IPC_P2P_VAR_T *p_var)
 {
     OPERATE_RET ret = OPRT_OK;
+    INT_T i;
 
     // Initialize session information
-    sg_p2p_session = (P2P_SESSION_T *)Malloc(sizeof(P2P_SESSION_T));
-    if (NULL == sg_p2p_session) {
+    sg_p2p_ctl.session_num = p_var->max_client_num;
+    if (sg_p2p_ctl.session_num <= 0) {
+        sg_p2p_ctl.session_num = 1;
+    } else if (sg_p2p_ctl.session_num > P2P_SESSION_MAX) {
+        PR_WARN("max_client_num %d not supported, base_ice serves %d viewer at once", sg_p2p_ctl.session_num,
+                P2P_SESSION_MAX);
+        sg_p2p_ctl.session_num = P2P_SESSION_MAX;
+    }
+    sg_p2p_ctl.session = (P2P_SESSION_T *)Malloc(sg_p2p_ctl.session_num * sizeof(P2P_SESSION_T));
+    if (NULL == sg_p2p_ctl.session) {
         PR_ERR("malloc p2p session failed");
         return OPRT_MALLOC_FAILED;
     }
-    memset(sg_p2p_session, 0, sizeof(P2P_SESSION_T));
-    tal_mutex_create_init(sg_p2p_session->cmutex);
+    memset(sg_p2p_ctl.session, 0, sg_p2p_ctl.session_num * sizeof(P2P_SESSION_T));
+    for (i = 0; i < sg_p2p_ctl.session_num; i++) {
+        tal_mutex_create_init(&sg_p2p_ctl.session[i].cmutex);
+        sg_p2p_ctl.session[i].cur_clarity = TY_VIDEO_CLARITY_INNER_HIGH;
+        p2p_cmd_chan_init(&sg_p2p_ctl.session[i].cmd_chan, &sg_p2p_cmd_chan_cfg, &sg_p2p_ctl.session[i]);
+#if !defined(ENABLE_P2P_FRAME_RING) || (ENABLE_P2P_FRAME_RING != 1)
+        sg_p2p_ctl.session[i].rtp_buff = (CHAR_T *)Malloc(P2P_EXT_HEAD_MAX_LEN + P2P_RTP_PACK_LEN);
+        if (NULL == sg_p2p_ctl.session[i].rtp_buff) {
+            PR_ERR("malloc p2p rtp buffer failed");
+            return OPRT_MALLOC_FAILED;
+        }
+#endif
+    }
     // Get password and other verification information
-    memset(&(sg_p2p_session->str_P2p_auth), 0x00, sizeof(TUYA_IPC_P2P_AUTH_T));
-    tuya_ipc_get_p2p_auth(&(sg_p2p_session->str_P2p_auth));
+    memset(&(sg_p2p_ctl.str_P2p_auth), 0x00, sizeof(TUYA_IPC_P2P_AUTH_T));
+    tuya_ipc_get_p2p_auth(&(sg_p2p_ctl.str_P2p_auth));
     tuya_ipc_check_p2p_auth_update();
 
-    sg_p2p_session->cur_clarity = TY_VIDEO_CLARITY_INNER_HIGH;
+#if defined(ENABLE_P2P_FRAME_RING) && (ENABLE_P2P_FRAME_RING == 1)
+    // Frames are packed once for all sessions, every packet keeps room for the private header
+    ret = p2p_ring_create(P2P_FRAME_RING_SESSION_SIZE * sg_p2p_ctl.session_num, P2P_FRAME_RING_NUM,
+                          P2P_EXT_HEAD_MAX_LEN, sg_p2p_ctl.session_num, &sg_p2p_ctl.frame_ring);
+    if (ret != OPRT_OK) {
+        PR_ERR("create p2p frame ring failed");
+        goto RET;
+    }
+#endif
+
+    // Initialize
+    int bufSize = 300 * 1024; // MAX_MEDIA_FRAME_SIZE
+    // memset(&sg_p2p_ctl.tal_video_frame, 0, sizeof(sg_p2p_ctl.tal_video_frame));
+    // sg_p2p_ctl.tal_video_frame.pbuf = (char*)malloc(bufSize);
+    // sg_p2p_ctl.tal_video_frame.buf_size = bufSize;
+
+    memset(&sg_p2p_ctl.media_frame, 0, sizeof(sg_p2p_ctl.media_frame));
+    sg_p2p_ctl.media_frame.data = (UCHAR_T *)tal_mem_budget_malloc(&sg_p2p_media_budget, bufSize);
+    if (NULL == sg_p2p_ctl.media_frame.data) {
+        PR_ERR("malloc p2p video frame failed");
+        return OPRT_MALLOC_FAILED;
+    }
+    sg_p2p_ctl.media_frame.size = bufSize;
+
+    bufSize = 1280;
+    // memset(&sg_p2p_ctl.tal_audio_frame, 0, sizeof(sg_p2p_ctl.tal_audio_frame));
+    // sg_p2p_ctl.tal_audio_frame.pbuf = (char*)malloc(bufSize);
+    // sg_p2p_ctl.tal_audio_frame.buf_size = bufSize;
+
+    memset(&sg_p2p_ctl.media_audio_frame, 0, sizeof(sg_p2p_ctl.media_audio_frame));
+    sg_p2p_ctl.media_audio_frame.data = (UCHAR_T *)tal_mem_budget_malloc(&sg_p2p_media_budget, bufSize);
+    if (NULL == sg_p2p_ctl.media_audio_frame.data) {
+        PR_ERR("malloc p2p audio frame failed");
+        return OPRT_MALLOC_FAILED;
+    }
+    sg_p2p_ctl.media_audio_frame.size = bufSize;
+
+    memcpy(&sg_p2p_ctl.av_Info, &p_var->av_info, sizeof(TRANS_IPC_AV_INFO_T));
+    sg_p2p_ctl.on_disconnect_callback = p_var->on_disconnect_callback;
+    sg_p2p_ctl.on_get_video_frame_callback = p_var->on_get_video_frame_callback;
+    sg_p2p_ctl.on_get_audio_frame_callback = p_var->on_get_audio_frame_callback;
 
     // Start media-related threads
     THREAD_CFG_T thrd_param = {STACK_SIZE_P2P_MEDIA_RECV, THREAD_PRIO_2, NULL};
     thrd_param.stackDepth = STACK_SIZE_P2P_CMD_RECV;
     thrd_param.thrdname = (char *)"p2p_cmd_recv";
-    ret = tal_thread_create_and_start(&(sg_p2p_session->cmd_recv_proc_thread), NULL, NULL, __p2p_cmd_recv_proc, NULL,
+    ret = tal_thread_create_and_start(&(sg_p2p_ctl.cmd_recv_proc_thread), NULL, NULL, __p2p_cmd_recv_proc, NULL,
                                       &thrd_param);
     if (ret != OPRT_OK) {
         PR_ERR("create p2p_cmd_recv task failed");
@@ -1552,47 +1574,17 @@ OPERATE_RET p2p_init(IN CONST TUYA_IPC_P2P_VAR_T *p_var)
     }
     thrd_param.stackDepth = STACK_SIZE_P2P_MEDIA_SEND;
     thrd_param.thrdname = (char *)"p2p_media_send";
-    ret = tal_thread_create_and_start(&(sg_p2p_session->video_send_proc_thread), NULL, NULL, __p2p_media_send_proc,
+    ret = tal_thread_create_and_start(&(sg_p2p_ctl.video_send_proc_thread), NULL, NULL, __p2p_media_send_proc,
                                       NULL, &thrd_param);
     if (ret != OPRT_OK) {
         PR_ERR("create p2p_media_send task failed");
         goto RET;
     }
 
-    // Initialize
-    int bufSize = 300 * 1024; // MAX_MEDIA_FRAME_SIZE
-    // memset(&sg_p2p_session->tal_video_frame, 0, sizeof(sg_p2p_session->tal_video_frame));
-    // sg_p2p_session->tal_video_frame.pbuf = (char*)malloc(bufSize);
-    // sg_p2p_session->tal_video_frame.buf_size = bufSize;
-
-    memset(&sg_p2p_session->media_frame, 0, sizeof(sg_p2p_session->media_frame));
-    sg_p2p_session->media_frame.data = (UCHAR_T *)malloc(bufSize);
-    sg_p2p_session->media_frame.size = bufSize;
-
-    bufSize = 1280;
-    // memset(&sg_p2p_session->tal_audio_frame, 0, sizeof(sg_p2p_session->tal_audio_frame));
-    // sg_p2p_session->tal_audio_frame.pbuf = (char*)malloc(bufSize);
-    // sg_p2p_session->tal_audio_frame.buf_size = bufSize;
-
-    memset(&sg_p2p_session->media_audio_frame, 0, sizeof(sg_p2p_session->media_audio_frame));
-    sg_p2p_session->media_audio_frame.data = (UCHAR_T *)malloc(bufSize);
-    sg_p2p_session->media_audio_frame.size = bufSize;
-
-    memcpy(&sg_p2p_session->av_Info, &p_var->av_info, sizeof(TRANS_IPC_AV_INFO_T));
-    sg_p2p_session->on_disconnect_callback = p_var->on_disconnect_callback;
-    sg_p2p_session->on_get_video_frame_callback = p_var->on_get_video_frame_callback;
-    sg_p2p_session->on_get_audio_frame_callback = p_var->on_get_audio_frame_callback;
-
     return OPRT_OK;
 
 RET:
-    if (NULL != sg_p2p_session->p_video_rtp_buff) {
-        p2p_release_video_send_resource(sg_p2p_session);
-    }
-    if (NULL != sg_p2p_session->p_audio_rtp_buff) {
-        p2p_release_audio_send_resource(sg_p2p_session);
-    }
-    __p2p_thread_exit(sg_p2p_session->cmd_recv_proc_thread);
+    __p2p_thread_exit(sg_p2p_ctl.cmd_recv_proc_thread);
     return ret;
 }
 
@@ -1692,39 +1684,11 @@ OPERATE_RET tuya_imm_p2p_album_play_send_finish(IN CONST CHAR_T *dev_id, IN CONS
     return 0;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void *rtp_alloc(void *param, int bytes)
-{
-    int nBufferSize = bytes;
-    unsigned char *pBuffer = (unsigned char *)malloc(nBufferSize);
-    memset(pBuffer, 0, nBufferSize);
-    return pBuffer;
-}
-
-void rtp_free(void *param, void *packet)
-{
-    free(packet);
-    packet = NULL;
-    return;
-}
-
-int rtp_pack_packet_handler(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
-{
-    //return 0;
-    CHAR_T *buf = (CHAR_T *)packet;
-    INT_T len = bytes;
-    RTP_PACK_NAL_ARG_T *nal_arg = (RTP_PACK_NAL_ARG_T *)param;
-    memcpy(nal_arg->p_rtp_buff, nal_arg->ext_head_buff, nal_arg->fix_len);
-    *(INT_T *)&nal_arg->p_rtp_buff[nal_arg->fix_len - 4] = len;
-    memcpy(nal_arg->p_rtp_buff + nal_arg->fix_len, buf, len);
-    return p2p_send_rtp_data(nal_arg->client, nal_arg->channel, nal_arg->p_rtp_buff, len + nal_arg->fix_len);
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 INT_T OnGetVideoFrameCallback(MEDIA_FRAME *pMediaFrame)
 {
-    // TAL_VENC_FRAME_T *pTalVideoFrame = &sg_p2p_session->tal_video_frame;
+    // TAL_VENC_FRAME_T *pTalVideoFrame = &sg_p2p_ctl.tal_video_frame;
     // if (tal_venc_get_frame(0, 0, pTalVideoFrame) != 0)
     // {
     //     return -1;
@@ -1739,7 +1703,7 @@ INT_T OnGetVideoFrameCallback(MEDIA_FRAME *pMediaFrame)
 
 INT_T OnGetAudioFrameCallback(MEDIA_FRAME *pMediaFrame)
 {
-    // TAL_AUDIO_FRAME_INFO_T *pTalAudioFrame = &sg_p2p_session->tal_audio_frame;
+    // TAL_AUDIO_FRAME_INFO_T *pTalAudioFrame = &sg_p2p_ctl.tal_audio_frame;
     // if (tal_ai_get_frame(0, 0, pTalAudioFrame) != 0)
     // {
     //     return -1;
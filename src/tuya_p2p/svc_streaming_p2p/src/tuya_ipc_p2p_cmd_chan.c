@@ -0,0 +1,209 @@
+/**
+ * @file tuya_ipc_p2p_cmd_chan.c
+ * @brief Command channel of a P2P session, several commands handled per read.
+ *
+ * Commands are handled where they lie in the buffer, the bytes left after the
+ * last complete one are moved to its front once per read. A command that
+ * does not start on 4 bytes is moved to the front before it is handled, the
+ * handlers read its header and payload as structures.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+#include "tal_log.h"
+#include "tuya_ipc_p2p_cmd_chan.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define P2P_CMD_CHAN_ALIGNED(off) (0 == ((off) & 3))
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static CONST P2P_CMD_HANDLER_T *__cmd_chan_handler(P2P_CMD_CHAN_T *chan, USHORT_T high_cmd)
+{
+    UINT_T i;
+
+    for (i = 0; i < chan->cfg->handler_num; i++) {
+        if (chan->cfg->handler[i].high_cmd == high_cmd) {
+            return &chan->cfg->handler[i];
+        }
+    }
+    return NULL;
+}
+
+static VOID __cmd_chan_dispatch(P2P_CMD_CHAN_T *chan, P2P_CMD_PARSE_T *p_cmd)
+{
+    UINT_T req[P2P_CMD_CHAN_REQ_MAX / sizeof(UINT_T)];
+    CONST P2P_CMD_HANDLER_T *p_handler = NULL;
+    CHAR_T *payload = (CHAR_T *)(p_cmd + 1);
+    UINT_T len = p_cmd->str_header.length;
+
+    if (1 == p_cmd->str_header.type) {
+        // a response, the device sends no request
+        return;
+    }
+    if (0 != p_cmd->str_header.type) {
+        PR_ERR("cmd type error %d", p_cmd->str_header.type);
+        return;
+    }
+
+    chan->stat.cmds++;
+    p_handler = __cmd_chan_handler(chan, p_cmd->str_header.high_cmd);
+    if (NULL == p_handler) {
+        if (chan->cfg->unknown) {
+            chan->cfg->unknown(chan->priv, p_cmd, payload);
+        }
+        return;
+    }
+
+    // a short request reads as zeros past its end, as the bytes of the next command are there
+    if (len < p_handler->req_len) {
+        memset(req, 0, sizeof(req));
+        memcpy(req, payload, len);
+        payload = (CHAR_T *)req;
+    }
+    p_handler->handler(chan->priv, p_cmd, payload);
+}
+
+/**
+ * @brief handle the complete commands in the buffer
+ *
+ * @return commands handled, OPRT_EXCEED_UPPER_LIMIT for a command larger than the buffer
+ */
+static INT_T __cmd_chan_parse(P2P_CMD_CHAN_T *chan)
+{
+    P2P_CMD_PARSE_T *p_cmd = NULL;
+    INT_T off = 0;
+    INT_T num = 0;
+    UINT_T len;
+
+    while (chan->len - off >= (INT_T)P2P_CMD_HEAD_LEN) {
+        if (!P2P_CMD_CHAN_ALIGNED(off)) {
+            memmove(chan->buff, chan->buff + off, chan->len - off);
+            chan->len -= off;
+            off = 0;
+        }
+        p_cmd = (P2P_CMD_PARSE_T *)(chan->buff + off);
+        if (P2P_CMD_MARK != p_cmd->mark) {
+            PR_ERR("read data error mark[0x%x]", p_cmd->mark);
+        }
+        len = p_cmd->str_header.length;
+        if (len > P2P_CMD_CHAN_RECV_SIZE - P2P_CMD_HEAD_LEN) {
+            PR_ERR("cmd[%d] of %u bytes too big", p_cmd->str_header.high_cmd, len);
+            return OPRT_EXCEED_UPPER_LIMIT;
+        }
+        if ((UINT_T)(chan->len - off) < P2P_CMD_HEAD_LEN + len) {
+            break;
+        }
+        __cmd_chan_dispatch(chan, p_cmd);
+        off += P2P_CMD_HEAD_LEN + len;
+        num++;
+    }
+
+    if (off > 0) {
+        memmove(chan->buff, chan->buff + off, chan->len - off);
+        chan->len -= off;
+    }
+    return num;
+}
+
+VOID p2p_cmd_chan_init(P2P_CMD_CHAN_T *chan, CONST P2P_CMD_CHAN_CFG_T *cfg, VOID *priv)
+{
+    memset(chan, 0, sizeof(P2P_CMD_CHAN_T));
+    chan->cfg = cfg;
+    chan->priv = priv;
+}
+
+VOID p2p_cmd_chan_reset(P2P_CMD_CHAN_T *chan)
+{
+    chan->len = 0;
+    chan->resp_len = 0;
+}
+
+INT_T p2p_cmd_chan_read(P2P_CMD_CHAN_T *chan, INT_T timeout_ms)
+{
+    INT_T num = 0;
+    INT_T ret = 0;
+    INT_T len = 0;
+    INT_T i;
+
+    for (i = 0; i < P2P_CMD_CHAN_READ_MAX; i++) {
+        len = P2P_CMD_CHAN_RECV_SIZE - chan->len;
+        ret = chan->cfg->recv(chan->priv, chan->buff + chan->len, &len, timeout_ms);
+        if (ret < 0) {
+            return ret;
+        }
+        if (len <= 0) {
+            break;
+        }
+        chan->len += len;
+        chan->stat.reads++;
+        // take what has come since without waiting
+        timeout_ms = 0;
+
+        ret = __cmd_chan_parse(chan);
+        if (ret < 0) {
+            return ret;
+        }
+        num += ret;
+    }
+
+    p2p_cmd_chan_flush(chan);
+    return num;
+}
+
+OPERATE_RET p2p_cmd_chan_resp(P2P_CMD_CHAN_T *chan, CONST P2P_CMD_PARSE_T *p_cmd, CONST VOID *payload, INT_T len)
+{
+    P2P_CMD_PARSE_T head;
+    INT_T pack_len = P2P_CMD_HEAD_LEN + len;
+    INT_T ret = 0;
+
+    if (NULL == chan || NULL == p_cmd || NULL == payload || len < 0) {
+        return OPRT_INVALID_PARM;
+    }
+
+    memcpy(&head, p_cmd, P2P_CMD_HEAD_LEN);
+    head.str_header.type = 1;
+    head.str_header.length = len;
+
+    if (chan->resp_len + pack_len > P2P_CMD_CHAN_RESP_SIZE) {
+        p2p_cmd_chan_flush(chan);
+    }
+    chan->stat.resps++;
+    if (pack_len > P2P_CMD_CHAN_RESP_SIZE) {
+        // too big to queue, sent as it is
+        chan->stat.resp_sends++;
+        ret = chan->cfg->send(chan->priv, (CHAR_T *)&head, P2P_CMD_HEAD_LEN);
+        if (ret >= 0) {
+            ret = chan->cfg->send(chan->priv, (CHAR_T *)payload, len);
+        }
+        return (ret < 0) ? OPRT_COM_ERROR : OPRT_OK;
+    }
+
+    memcpy(chan->resp_buff + chan->resp_len, &head, P2P_CMD_HEAD_LEN);
+    memcpy(chan->resp_buff + chan->resp_len + P2P_CMD_HEAD_LEN, payload, len);
+    chan->resp_len += pack_len;
+    return OPRT_OK;
+}
+
+OPERATE_RET p2p_cmd_chan_flush(P2P_CMD_CHAN_T *chan)
+{
+    INT_T ret = 0;
+
+    if (0 == chan->resp_len) {
+        return OPRT_OK;
+    }
+
+    chan->stat.resp_sends++;
+    ret = chan->cfg->send(chan->priv, chan->resp_buff, chan->resp_len);
+    chan->resp_len = 0;
+    if (ret < 0) {
+        PR_ERR("p2p Write failed ret = %d", ret);
+        return OPRT_COM_ERROR;
+    }
+    return OPRT_OK;
+}
@@ -0,0 +1,504 @@
+/**
+ * @file tuya_ipc_p2p_frame_ring.c
+ * @brief Encoded frames shared by all P2P viewers, packed into RTP packets once.
+ *
+ * Frames take consecutive room in one buffer, wrapping to its start when the
+ * end is too short, so the oldest frame is always the next one overwritten.
+ * A packet is kept as its length, the head room and the packet itself,
+ * padded to 4 bytes.
+ *
+ * @copyright Copyright (c) 2021-2025 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+#include <string.h>
+#include "tal_log.h"
+#include "tal_memory.h"
+#include "tal_mem_budget.h"
+#include "tuya_ipc_p2p_frame_ring.h"
+#include "rtp-payload.h"
+
+/***********************************************************
+************************macro define************************
+***********************************************************/
+#define P2P_RING_ALIGN(len)   (((len) + 3) & ~3)
+#define P2P_RING_PKT_LEN_SIZE (sizeof(UINT_T))
+#define P2P_RING_MEDIA_NUM    (2)
+
+// sequence numbers wrap, compare them by their difference
+#define P2P_RING_SEQ_BEFORE(a, b) ((INT_T)((a) - (b)) < 0)
+
+// bytes the frame rings may hold, 0: not limited
+#ifndef P2P_FRAME_RING_MEM_BUDGET
+#define P2P_FRAME_RING_MEM_BUDGET 0
+#endif
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    CHAR_T *buff;
+    UINT_T buff_size;
+    UINT_T wpos; // Where the frame after the newest one starts
+    P2P_RING_FRAME_T *frame;
+    UINT_T frame_num;
+    UINT_T head; // Sequence number of the oldest frame
+    UINT_T tail; // Sequence number of the next frame
+    UINT_T key_seq;
+    BOOL_T has_key; // key_seq is a video key frame still in the ring
+    UINT_T head_room;
+
+    P2P_RING_READER_T **reader;
+    UINT_T reader_max;
+
+    VOID *packer[P2P_RING_MEDIA_NUM];
+    INT_T packer_pt[P2P_RING_MEDIA_NUM];
+    CHAR_T *pack_pos; // Next packet of the frame being packed
+    CHAR_T *pack_end;
+    UINT_T pack_cnt;
+
+    P2P_RING_STAT_T stat;
+} P2P_RING_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+// the ring is large and written once per frame, PSRAM is preferred
+static TAL_MEM_BUDGET_DEFINE(sg_ring_budget, "p2p_frame_ring", P2P_FRAME_RING_MEM_BUDGET, TAL_MEM_PLACE_PSRAM, 0);
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+static P2P_RING_FRAME_T *__ring_frame(P2P_RING_T *p_ring, UINT_T seq)
+{
+    return &p_ring->frame[seq % p_ring->frame_num];
+}
+
+static void *__ring_rtp_alloc(void *param, int bytes)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)param;
+    UINT_T len = P2P_RING_PKT_LEN_SIZE + p_ring->head_room + bytes;
+
+    if (bytes <= 0 || p_ring->pack_pos + len > p_ring->pack_end) {
+        return NULL;
+    }
+    return p_ring->pack_pos + P2P_RING_PKT_LEN_SIZE + p_ring->head_room;
+}
+
+static void __ring_rtp_free(void *param, void *packet)
+{
+    return;
+}
+
+static int __ring_rtp_packet(void *param, const void *packet, int bytes, uint32_t timestamp, int flags)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)param;
+
+    *(UINT_T *)p_ring->pack_pos = bytes;
+    p_ring->pack_pos += P2P_RING_ALIGN(P2P_RING_PKT_LEN_SIZE + p_ring->head_room + bytes);
+    p_ring->pack_cnt++;
+    return 0;
+}
+
+static VOID *__ring_packer_get(P2P_RING_T *p_ring, UINT_T idx, INT_T payload, CHAR_T *name)
+{
+    struct rtp_payload_t handler;
+
+    if (NULL != p_ring->packer[idx] && p_ring->packer_pt[idx] == payload) {
+        return p_ring->packer[idx];
+    }
+    if (NULL != p_ring->packer[idx]) {
+        rtp_payload_encode_destroy(p_ring->packer[idx]);
+    }
+
+    handler.alloc = __ring_rtp_alloc;
+    handler.free = __ring_rtp_free;
+    handler.packet = __ring_rtp_packet;
+    // viewers number the packets themselves, the SSRC tells video from audio
+    p_ring->packer[idx] = rtp_payload_encode_create(payload, name, 0, 10 + idx, &handler, p_ring);
+    p_ring->packer_pt[idx] = payload;
+
+    return p_ring->packer[idx];
+}
+
+/**
+ * @brief add delta to the references of the frames of the reader in [from, p_ring->tail)
+ */
+static VOID __ring_reader_ref(P2P_RING_T *p_ring, P2P_RING_READER_T *reader, UINT_T from, INT_T delta)
+{
+    P2P_RING_FRAME_T *p_frame = NULL;
+    UINT_T seq;
+
+    if (P2P_RING_SEQ_BEFORE(from, p_ring->head)) {
+        from = p_ring->head;
+    }
+    for (seq = from; seq != p_ring->tail; seq++) {
+        p_frame = __ring_frame(p_ring, seq);
+        if (p_frame->media & reader->media) {
+            p_frame->ref_cnt += delta;
+        }
+    }
+}
+
+/**
+ * @brief the reader starts at the latest key frame, or at the next frame when there is none
+ */
+static VOID __ring_reader_sync(P2P_RING_T *p_ring, P2P_RING_READER_T *reader)
+{
+    if (reader->media & P2P_RING_MEDIA_VIDEO) {
+        if (FALSE == p_ring->has_key) {
+            // wait for a key frame
+            reader->next = p_ring->tail;
+            return;
+        }
+        reader->next = p_ring->key_seq;
+    } else {
+        reader->next = p_ring->tail;
+    }
+
+    __ring_reader_ref(p_ring, reader, reader->next, 1);
+    reader->synced = TRUE;
+}
+
+static VOID __ring_reader_unsync(P2P_RING_T *p_ring, P2P_RING_READER_T *reader)
+{
+    if (reader->synced) {
+        __ring_reader_ref(p_ring, reader, reader->next, -1);
+        reader->synced = FALSE;
+    }
+}
+
+static VOID __ring_evict(P2P_RING_T *p_ring)
+{
+    P2P_RING_FRAME_T *p_frame = __ring_frame(p_ring, p_ring->head);
+    P2P_RING_READER_T *reader = NULL;
+    UINT_T i;
+
+    if (p_frame->ref_cnt > 0) {
+        p_ring->stat.overwritten++;
+    }
+
+    for (i = 0; i < p_ring->reader_max; i++) {
+        reader = p_ring->reader[i];
+        if (NULL == reader || FALSE == reader->synced || reader->next != p_ring->head) {
+            continue;
+        }
+        if (0 == (p_frame->media & reader->media)) {
+            // not peeked past yet, the reader had nothing to send in it
+            reader->next++;
+            continue;
+        }
+        // the reader is too slow, it starts over at the latest key frame
+        reader->dropped += p_ring->tail - reader->next;
+        __ring_reader_unsync(p_ring, reader);
+    }
+
+    if (p_ring->has_key && p_ring->key_seq == p_ring->head) {
+        p_ring->has_key = FALSE;
+    }
+    p_ring->head++;
+}
+
+/**
+ * @brief make room for a frame of len bytes, overwriting the oldest frames
+ */
+static CHAR_T *__ring_reserve(P2P_RING_T *p_ring, UINT_T len)
+{
+    UINT_T rpos;
+
+    if (len > p_ring->buff_size) {
+        return NULL;
+    }
+
+    if (p_ring->tail - p_ring->head >= p_ring->frame_num) {
+        __ring_evict(p_ring);
+    }
+
+    while (1) {
+        if (p_ring->head == p_ring->tail) {
+            return p_ring->buff;
+        }
+
+        rpos = __ring_frame(p_ring, p_ring->head)->data - p_ring->buff;
+        if (rpos < p_ring->wpos) {
+            // frames in [rpos, wpos): the end, else the start of the buffer
+            if (p_ring->buff_size - p_ring->wpos >= len) {
+                return p_ring->buff + p_ring->wpos;
+            }
+            if (rpos >= len) {
+                return p_ring->buff;
+            }
+        } else if (rpos - p_ring->wpos >= len) {
+            // frames wrapped, room in [wpos, rpos)
+            return p_ring->buff + p_ring->wpos;
+        }
+
+        __ring_evict(p_ring);
+    }
+}
+
+OPERATE_RET p2p_ring_create(UINT_T buff_size, UINT_T frame_num, UINT_T head_room, UINT_T reader_max,
+                            P2P_RING_HANDLE_T *p_ring)
+{
+    P2P_RING_T *ring = NULL;
+    UINT_T mem_size;
+
+    if (NULL == p_ring || 0 == buff_size || 0 == frame_num || 0 == reader_max) {
+        return OPRT_INVALID_PARM;
+    }
+
+    head_room = P2P_RING_ALIGN(head_room);
+    buff_size = P2P_RING_ALIGN(buff_size);
+    mem_size = sizeof(P2P_RING_T) + buff_size + frame_num * sizeof(P2P_RING_FRAME_T) +
+               reader_max * sizeof(P2P_RING_READER_T *);
+    ring = (P2P_RING_T *)tal_mem_budget_malloc(&sg_ring_budget, mem_size);
+    if (NULL == ring) {
+        PR_ERR("malloc frame ring failed %d", mem_size);
+        return OPRT_MALLOC_FAILED;
+    }
+    memset(ring, 0, mem_size - buff_size);
+
+    ring->frame = (P2P_RING_FRAME_T *)(ring + 1);
+    ring->frame_num = frame_num;
+    ring->reader = (P2P_RING_READER_T **)(ring->frame + frame_num);
+    ring->reader_max = reader_max;
+    ring->buff = (CHAR_T *)(ring->reader + reader_max);
+    ring->buff_size = buff_size;
+    ring->head_room = head_room;
+    ring->stat.mem_size = mem_size;
+
+    *p_ring = ring;
+
+    return OPRT_OK;
+}
+
+VOID p2p_ring_destroy(P2P_RING_HANDLE_T ring)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    UINT_T i;
+
+    if (NULL == p_ring) {
+        return;
+    }
+
+    for (i = 0; i < P2P_RING_MEDIA_NUM; i++) {
+        if (NULL != p_ring->packer[i]) {
+            rtp_payload_encode_destroy(p_ring->packer[i]);
+        }
+    }
+    tal_mem_budget_free(p_ring);
+}
+
+OPERATE_RET p2p_ring_put(P2P_RING_HANDLE_T ring, UINT_T media, INT_T payload, CHAR_T *name, MEDIA_FRAME *p_frame,
+                         UINT_T rtp_ts)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    P2P_RING_FRAME_T *p_new = NULL;
+    P2P_RING_READER_T *reader = NULL;
+    CHAR_T *data = NULL;
+    VOID *packer = NULL;
+    INT_T pkt_cnt, ret;
+    UINT_T i, len;
+
+    if (NULL == p_ring || NULL == p_frame || NULL == p_frame->data || 0 == p_frame->size ||
+        (P2P_RING_MEDIA_VIDEO != media && P2P_RING_MEDIA_AUDIO != media)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    packer = __ring_packer_get(p_ring, media - 1, payload, name);
+    if (NULL == packer) {
+        PR_ERR("create %s rtp packer failed", name);
+        return OPRT_MALLOC_FAILED;
+    }
+
+    // reserve for packets of the largest size, the frame then keeps what they take
+    pkt_cnt = rtp_payload_encode_packets(packer, p_frame->data, p_frame->size);
+    if (pkt_cnt <= 0) {
+        PR_ERR("%s frame of %d bytes can't be packed", name, p_frame->size);
+        return OPRT_NOT_SUPPORTED;
+    }
+    len = pkt_cnt * P2P_RING_ALIGN(P2P_RING_PKT_LEN_SIZE + p_ring->head_room + rtp_packet_getsize());
+    data = __ring_reserve(p_ring, len);
+    if (NULL == data) {
+        PR_ERR("%s frame of %d bytes too big for the ring", name, p_frame->size);
+        return OPRT_EXCEED_UPPER_LIMIT;
+    }
+
+    p_ring->pack_pos = data;
+    p_ring->pack_end = data + len;
+    p_ring->pack_cnt = 0;
+    ret = rtp_payload_encode_input(packer, p_frame->data, p_frame->size, rtp_ts);
+    if (0 != ret) {
+        PR_ERR("rtp_payload_encode_input error:%d", ret);
+        return OPRT_COM_ERROR;
+    }
+
+    p_new = __ring_frame(p_ring, p_ring->tail);
+    memset(p_new, 0, sizeof(P2P_RING_FRAME_T));
+    p_new->seq = p_ring->tail;
+    p_new->media = media;
+    p_new->key_frame = (P2P_RING_MEDIA_AUDIO == media || eVideoIFrame == p_frame->type) ? TRUE : FALSE;
+    p_new->pts = p_frame->pts;
+    p_new->timestamp = p_frame->timestamp;
+    p_new->pkt_cnt = p_ring->pack_cnt;
+    p_new->size = p_ring->pack_pos - data;
+    p_new->data = data;
+    p_ring->wpos = (data - p_ring->buff) + p_new->size;
+    p_ring->tail++;
+
+    if (P2P_RING_MEDIA_VIDEO == media && p_new->key_frame) {
+        p_ring->key_seq = p_new->seq;
+        p_ring->has_key = TRUE;
+    }
+
+    p_ring->stat.frames++;
+    p_ring->stat.packets += p_new->pkt_cnt;
+
+    for (i = 0; i < p_ring->reader_max; i++) {
+        reader = p_ring->reader[i];
+        if (NULL != reader && reader->synced && (reader->media & media)) {
+            p_new->ref_cnt++;
+        }
+    }
+
+    return OPRT_OK;
+}
+
+OPERATE_RET p2p_ring_reader_set(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader, UINT_T media)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    UINT_T i, slot = p_ring ? p_ring->reader_max : 0;
+
+    if (NULL == p_ring || NULL == reader) {
+        return OPRT_INVALID_PARM;
+    }
+
+    for (i = 0; i < p_ring->reader_max; i++) {
+        if (reader == p_ring->reader[i]) {
+            break;
+        }
+        if (NULL == p_ring->reader[i] && slot == p_ring->reader_max) {
+            slot = i;
+        }
+    }
+
+    if (i == p_ring->reader_max) {
+        // not a reader yet
+        if (0 == media) {
+            return OPRT_OK;
+        }
+        if (slot == p_ring->reader_max) {
+            return OPRT_EXCEED_UPPER_LIMIT;
+        }
+        memset(reader, 0, sizeof(P2P_RING_READER_T));
+        reader->media = media;
+        reader->next = p_ring->tail;
+        p_ring->reader[slot] = reader;
+        return OPRT_OK;
+    }
+
+    if (media == reader->media) {
+        return OPRT_OK;
+    }
+
+    __ring_reader_unsync(p_ring, reader);
+    reader->media = media;
+    if (0 == media) {
+        p_ring->reader[i] = NULL;
+    }
+
+    return OPRT_OK;
+}
+
+P2P_RING_FRAME_T *p2p_ring_peek(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    P2P_RING_FRAME_T *p_frame = NULL;
+
+    if (NULL == p_ring || NULL == reader || 0 == reader->media) {
+        return NULL;
+    }
+
+    if (FALSE == reader->synced) {
+        __ring_reader_sync(p_ring, reader);
+        if (FALSE == reader->synced) {
+            return NULL;
+        }
+    }
+
+    // frames of the other media are not referenced by the reader
+    for (; reader->next != p_ring->tail; reader->next++) {
+        p_frame = __ring_frame(p_ring, reader->next);
+        if (p_frame->media & reader->media) {
+            return p_frame;
+        }
+    }
+
+    return NULL;
+}
+
+VOID p2p_ring_pass(P2P_RING_HANDLE_T ring, P2P_RING_READER_T *reader)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    P2P_RING_FRAME_T *p_frame = NULL;
+
+    if (NULL == p_ring || NULL == reader || FALSE == reader->synced || reader->next == p_ring->tail) {
+        return;
+    }
+
+    p_frame = __ring_frame(p_ring, reader->next);
+    if (p_frame->ref_cnt > 0) {
+        p_frame->ref_cnt--;
+    }
+    reader->next++;
+    reader->sent++;
+}
+
+CHAR_T *p2p_ring_packet(P2P_RING_HANDLE_T ring, P2P_RING_FRAME_T *frame, UINT_T *p_offset, INT_T *p_len)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    CHAR_T *rec = NULL;
+    UINT_T len;
+
+    if (NULL == p_ring || NULL == frame || NULL == p_offset || *p_offset >= frame->size) {
+        return NULL;
+    }
+
+    rec = frame->data + *p_offset;
+    len = *(UINT_T *)rec;
+    *p_offset += P2P_RING_ALIGN(P2P_RING_PKT_LEN_SIZE + p_ring->head_room + len);
+    if (p_len) {
+        *p_len = len;
+    }
+
+    return rec + P2P_RING_PKT_LEN_SIZE + p_ring->head_room;
+}
+
+UINT_T p2p_ring_media(P2P_RING_HANDLE_T ring)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+    UINT_T i, media = 0;
+
+    if (NULL == p_ring) {
+        return 0;
+    }
+
+    for (i = 0; i < p_ring->reader_max; i++) {
+        if (NULL != p_ring->reader[i]) {
+            media |= p_ring->reader[i]->media;
+        }
+    }
+
+    return media;
+}
+
+VOID p2p_ring_get_stat(P2P_RING_HANDLE_T ring, P2P_RING_STAT_T *stat)
+{
+    P2P_RING_T *p_ring = (P2P_RING_T *)ring;
+
+    if (NULL == p_ring || NULL == stat) {
+        return;
+    }
+
+    memcpy(stat, &p_ring->stat, sizeof(P2P_RING_STAT_T));
+}